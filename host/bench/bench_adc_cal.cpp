@@ -0,0 +1,298 @@
+/**
+ * @file bench_adc_cal.cpp
+ * @brief Benchmark: eFuse curve table against the esp_adc_cali reference curve
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * 1. Reference: for every attenuation and a spread of eFuse points (nominal
+ *    and +-3 % chips), every one of the 4096 table entries must equal
+ *    adc_cali_raw_to_voltage() for that code, and the table must not fall
+ *    by more than 1 mV from one code to the next.
+ * 2. Error: at the board attenuation, how far the old linear scale and the
+ *    bare eFuse line are from the curve near the rails and mid-range, in mV
+ *    and in pH at the default slope.
+ * 3. Firmware path: adc_cal_init() with and without an eFuse point; pH and
+ *    EC readings use the table when there is one and the unchanged linear
+ *    scale when there is not.
+ * 4. Upgrade: a pH/EC calibration stored by linear-scale firmware on a chip
+ *    that now gets the eFuse curve pauses automatic dosing until both probes
+ *    are recalibrated; rolling back to a linear-scale record is refused.
+ * 5. Cost: table lookup against one esp_adc_cali call per sample.
+ *
+ *   bench_adc_cal [samples]
+ */
+
+#include "adc_cal.h"
+#include "calibration.h"
+#include "cal_history.h"
+#include "cli.h"
+#include "pump.h"
+#include "sensors.h"
+#include "communication.h"
+#include "host_hal.h"
+
+#include <esp_adc/adc_cali_scheme.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// NVS preferences object (main.cpp is not linked; sensors pull in calibration)
+Preferences preferences;
+
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+// Nominal ADC1 eFuse points (code, mV) per attenuation
+static const uint32_t kPoint[4][2] = {{1724, 400}, {1802, 550}, {1755, 750}, {1810, 1370}};
+static constexpr float kPhSlope = -0.0169f;            // pH per mV (calibration default)
+
+static uint16_t lut[ADC_CAL_CODES];
+
+static bool cali_convert(void* ctx, int code, int* millivolts) {
+    return adc_cali_raw_to_voltage(static_cast<adc_cali_handle_t>(ctx), code, millivolts) == ESP_OK;
+}
+
+static adc_cali_handle_t open_curve(int atten, uint32_t code, uint32_t millivolts) {
+    host_set_adc_efuse(atten, code, millivolts);
+    adc_cali_curve_fitting_config_t config = {};
+    config.unit_id = ADC_UNIT_1;
+    config.atten = static_cast<adc_atten_t>(atten);
+    config.bitwidth = ADC_BITWIDTH_12;
+    adc_cali_handle_t handle = nullptr;
+    return adc_cali_create_scheme_curve_fitting(&config, &handle) == ESP_OK ? handle : nullptr;
+}
+
+//=============================================================================
+// REFERENCE
+//=============================================================================
+
+static void reference(void) {
+    static const float kSpread[] = {0.97f, 1.0f, 1.03f};
+    int tables = 0;
+    for (int atten = 0; atten < 4; atten++) {
+        for (float spread : kSpread) {
+            uint32_t millivolts = (uint32_t)lroundf(kPoint[atten][1] * spread);
+            adc_cali_handle_t handle = open_curve(atten, kPoint[atten][0], millivolts);
+            EXPECT(handle != nullptr, "reference: no scheme for atten %d\n", atten);
+            if (!handle) continue;
+            EXPECT(adc_cal_build_lut(cali_convert, handle, lut, ADC_CAL_CODES), "reference: build failed\n");
+            int mismatches = 0, worst_drop = 0;
+            for (int code = 0; code < ADC_CAL_CODES; code++) {
+                int expected = 0;
+                adc_cali_raw_to_voltage(handle, code, &expected);
+                if (lut[code] != (uint16_t)constrain(expected, 0, 65535)) mismatches++;
+                if (code > 0 && lut[code - 1] - lut[code] > worst_drop) worst_drop = lut[code - 1] - lut[code];
+            }
+            EXPECT(mismatches == 0, "reference: atten %d x%.2f: %d entries differ from esp_adc_cali\n", atten, spread,
+                   mismatches);
+            EXPECT(worst_drop <= 1, "reference: atten %d x%.2f: table falls by %d mV\n", atten, spread, worst_drop);
+            adc_cali_delete_scheme_curve_fitting(handle);
+            tables++;
+        }
+    }
+    host_reset();
+    printf("Reference: %d tables x %d codes equal to adc_cali_raw_to_voltage()\n", tables, ADC_CAL_CODES);
+}
+
+//=============================================================================
+// ERROR
+//=============================================================================
+
+static void error_report(void) {
+    int atten = static_cast<int>(Board::adc_attenuation);
+    adc_cali_handle_t handle = open_curve(atten, kPoint[atten][0], kPoint[atten][1]);
+    EXPECT(handle && adc_cal_build_lut(cali_convert, handle, lut, ADC_CAL_CODES), "error: build failed\n");
+    adc_cali_delete_scheme_curve_fitting(handle);
+    host_reset();
+
+    // The eFuse line alone (gain from the calibration point, no error correction)
+    float line_mv_per_code = (float)kPoint[atten][1] / kPoint[atten][0];
+    struct band_t {
+        const char* name;
+        int from, to;
+        float linear, line;
+    };
+    band_t bands[] = {{"low rail (0-5%)", 1, 205, 0, 0},
+                      {"mid (25-75%)", 1024, 3071, 0, 0},
+                      {"high rail (95-100%)", 3890, 4095, 0, 0}};
+    for (band_t& band : bands) {
+        for (int code = band.from; code <= band.to; code++) {
+            float linear = fabsf(code * SENSOR_ADC_VOLTS_PER_COUNT * 1000.0f - lut[code]);
+            float line = fabsf(code * line_mv_per_code - lut[code]);
+            if (linear > band.linear) band.linear = linear;
+            if (line > band.line) band.line = line;
+        }
+        printf("Error %-20s linear 3.3 V scale up to %6.1f mV (%.2f pH) | eFuse line up to %5.1f mV (%.2f pH)\n",
+               band.name, band.linear, band.linear * -kPhSlope, band.line, band.line * -kPhSlope);
+    }
+    EXPECT(bands[2].line > 10.0f, "error: no rail non-linearity in the curve (%.1f mV)\n", bands[2].line);
+}
+
+//=============================================================================
+// FIRMWARE PATH
+//=============================================================================
+
+static void firmware_path(void) {
+    calibration_t cal;
+    cal.ph_slope = kPhSlope;
+    cal.ph_offset = 27.0f;
+    const int code = 1500;
+
+    host_reset();
+    communication_init("bench", "bench");
+    EXPECT(adc_cal_init() == AdcCalSource::LINEAR, "firmware: table without eFuse data\n");
+    host_set_adc_value(PH_PIN, code);
+    float linear_ph = sensor_read_ph_raw(25.0f, cal);
+    float voltage = code * SENSOR_ADC_VOLTS_PER_COUNT;
+    float millivolts = voltage * 1000.0;
+    EXPECT(adc_cal_millivolts(code) == millivolts, "firmware: linear scale changed\n");
+    EXPECT(fabsf(linear_ph - constrain(kPhSlope * millivolts + 27.0f, 0.0f, 14.0f)) < 1e-4f,
+           "firmware: linear pH %.3f\n", linear_ph);
+
+    int atten = static_cast<int>(Board::adc_attenuation);
+    host_set_adc_efuse(atten, kPoint[atten][0], kPoint[atten][1]);
+    EXPECT(adc_cal_init() == AdcCalSource::EFUSE_CURVE, "firmware: eFuse point ignored\n");
+    adc_cali_handle_t handle = open_curve(atten, kPoint[atten][0], kPoint[atten][1]);
+    int expected = 0;
+    adc_cali_raw_to_voltage(handle, code, &expected);
+    adc_cali_delete_scheme_curve_fitting(handle);
+    EXPECT(adc_cal_millivolts(code) == (float)expected, "firmware: table %.0f mV, curve %d mV\n",
+           adc_cal_millivolts(code), expected);
+    host_set_adc_value(PH_PIN, code);
+    float curve_ph = sensor_read_ph_raw(25.0f, cal);
+    EXPECT(fabsf(curve_ph - constrain(kPhSlope * expected + 27.0f, 0.0f, 14.0f)) < 1e-4f,
+           "firmware: curve pH %.3f\n", curve_ph);
+    printf("Firmware path: code %d -> %.1f mV linear (pH %.3f), %d mV eFuse curve (pH %.3f)\n", code, millivolts,
+           linear_ph, expected, curve_ph);
+}
+
+//=============================================================================
+// UPGRADE
+//=============================================================================
+
+static std::string serial_out;
+
+static void capture_serial(const char* data, size_t len, void* ctx) {
+    (void)ctx;
+    serial_out.append(data, len);
+}
+
+static bool warned(void) {
+    return serial_out.find("ADC SCALE CHANGED") != std::string::npos;
+}
+
+static void upgrade(void) {
+    host_reset();
+    communication_init("bench", "bench");
+    serial_out.clear();
+    host_serial_set_output_hook(capture_serial, nullptr);
+
+    // Older firmware stored a calibration and no scale, fitted on the linear scale
+    preferences.begin(NVS_NAMESPACE);
+    calibration_reset();
+    cal_history_init();
+    const float mv[2] = {1700.0f, 1530.0f};
+    const float ph[2] = {4.01f, 7.00f};
+    cal_history_record(CalProbe::PH, mv, ph, kPhSlope, 27.0f);
+    preferences.remove(NVS_CAL_PH_ADC_KEY);
+    preferences.remove(NVS_CAL_EC_ADC_KEY);
+
+    adc_cal_init();
+    pump_init();
+    calibration_check_adc_scale();
+    EXPECT(!calibration_adc_scale_stale() && !(pump_get_auto_inhibit() & PUMP_INHIBIT_ADC_SCALE),
+           "upgrade: same linear scale paused dosing\n");
+    EXPECT(!warned(), "upgrade: warned without a scale change\n");
+
+    int atten = static_cast<int>(Board::adc_attenuation);
+    host_set_adc_efuse(atten, kPoint[atten][0], kPoint[atten][1]);
+    adc_cal_init();
+    pump_init();
+    calibration_check_adc_scale();
+    EXPECT(calibration_adc_scale_stale() && !calibration_is_valid(), "upgrade: linear calibration still valid\n");
+    EXPECT(pump_get_auto_inhibit() & PUMP_INHIBIT_ADC_SCALE, "upgrade: automatic dosing not paused\n");
+    EXPECT(warned(), "upgrade: scale change not logged\n");
+
+    const char* rollback = "krollback ph 1\n";
+    host_serial_feed(reinterpret_cast<const uint8_t*>(rollback), strlen(rollback));
+    Debug->update();
+    if (Debug->available()) cli_process_command(Debug->read());
+    EXPECT(calibration_adc_scale_stale() && serial_out.find("fitted on the linear") != std::string::npos,
+           "upgrade: rollback to a linear record accepted\n");
+
+    EXPECT(calibration_ph_2point(1700.0f, 4.01f, 1530.0f, 7.00f), "upgrade: pH recalibration failed\n");
+    EXPECT(pump_get_auto_inhibit() & PUMP_INHIBIT_ADC_SCALE, "upgrade: dosing resumed with EC still stale\n");
+    EXPECT(calibration_ec_2point(100.0f, 1.413f, 1300.0f, 12.88f), "upgrade: EC recalibration failed\n");
+    EXPECT(!calibration_adc_scale_stale() && !(pump_get_auto_inhibit() & PUMP_INHIBIT_ADC_SCALE),
+           "upgrade: dosing still paused after recalibration\n");
+
+    // The next boot on the same chip finds both probes on the curve
+    serial_out.clear();
+    calibration_check_adc_scale();
+    EXPECT(!calibration_adc_scale_stale() && !warned(), "upgrade: recalibration not stored\n");
+    host_serial_set_output_hook(nullptr, nullptr);
+    preferences.end();
+    printf("Upgrade: linear calibration on the eFuse curve pauses automatic dosing until pH and EC are "
+           "recalibrated\n");
+}
+
+//=============================================================================
+// COST
+//=============================================================================
+
+static void cost(long samples) {
+    int atten = static_cast<int>(Board::adc_attenuation);
+    adc_cali_handle_t handle = open_curve(atten, kPoint[atten][0], kPoint[atten][1]);
+    adc_cal_init();
+
+    volatile float sink = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < samples; i++) {
+        sink = sink + adc_cal_millivolts((int)(i * 2654435761u >> 20) & (ADC_CAL_CODES - 1));
+    }
+    double table_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    volatile uint32_t isink = 0;
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < samples; i++) {
+        int millivolts = 0;
+        adc_cali_raw_to_voltage(handle, (int)(i * 2654435761u >> 20) & (ADC_CAL_CODES - 1), &millivolts);
+        isink = isink + (uint32_t)millivolts;
+    }
+    double cali_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    adc_cali_delete_scheme_curve_fitting(handle);
+
+    table_ns /= samples;
+    cali_ns /= samples;
+    printf("Cost per sample (%ld samples): table %.2f ns | esp_adc_cali %.2f ns | table %u bytes\n", samples,
+           table_ns, cali_ns, (unsigned)(ADC_CAL_CODES * sizeof(uint16_t)));
+    EXPECT(table_ns < cali_ns, "cost: table %.2f ns not cheaper than esp_adc_cali %.2f ns\n", table_ns, cali_ns);
+}
+
+int main(int argc, char** argv) {
+    long samples = argc > 1 ? atol(argv[1]) : 10000000;
+    if (samples < 1000) samples = 1000;
+
+    reference();
+    error_report();
+    firmware_path();
+    upgrade();
+    cost(samples);
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
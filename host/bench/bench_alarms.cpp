@@ -0,0 +1,107 @@
+/**
+ * @file bench_alarms.cpp
+ * @brief Benchmark: evaluate a 50-rule alarm program per reading
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Compiles 50 rules mixing plain thresholds, hysteresis, windowed history
+ * functions and boolean logic, fills two hours of history, then times
+ * alarm_program_step(). Fails if evaluation allocates. Host numbers are for
+ * regression tracking; the ESP32-S3 at 240 MHz is roughly 10-20x slower.
+ *
+ *   bench_alarms [iterations]
+ */
+
+#include "alarms.h"
+
+#include <chrono>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+
+static unsigned long allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static alarm_program_t program;
+static alarm_history_t history;
+static char text[ALARM_RULES_TEXT_MAX];
+
+// Ten rule shapes; each is instantiated five times with shifted thresholds
+static const char* const kTemplates[] = {
+    "ph_low%d: ph < %.2f hyst 0.1 for 10m hold 2m crit\n",
+    "ph_high%d: ph > %.2f hyst 0.1 for 10m warn\n",
+    "ec_rise%d: rate(ec, 1h) > %.2f hyst 0.05 for 5m\n",
+    "leak%d: pct(volume, 1h) < -%.2f hyst 2 crit\n",
+    "noresp%d: delta(ph_dosed, 15m) > 10 and abs(delta(ph, 15m)) < %.2f\n",
+    "band%d: not (ec > 0.8 and ec < %.2f) for 15m\n",
+    "warm%d: temp >= 26 or avg(temp, 30m) > %.2f hold 10m\n",
+    "swing%d: max(ph, 30m) - min(ph, 30m) > %.2f for 5m\n",
+    "auto%d: auto_ph < 1 and ph > %.2f for 1h\n",
+    "mix%d: (ec * 1000 / (volume + 1)) > %.2f or ph * 2 - 3 < 7\n",
+};
+
+int main(int argc, char** argv) {
+    long iterations = argc > 1 ? atol(argv[1]) : 200000;
+
+    size_t used = 0;
+    int n = 0;
+    for (int round = 0; round < 5; round++) {
+        for (const char* tmpl : kTemplates) {
+            used += (size_t)snprintf(text + used, sizeof(text) - used, tmpl, n++, 0.5 + round * 0.3);
+        }
+    }
+    alarm_compile_error_t error;
+    // A hysteresis that overflows to inf would keep the rule from ever raising
+    if (alarm_compile("huge: ph < 6 hyst 1e39\n", &program, &error)) {
+        fprintf(stderr, "bench_alarms: non-finite hysteresis accepted\n");
+        return 1;
+    }
+    if (!alarm_compile(text, &program, &error)) {
+        fprintf(stderr, "bench_alarms: compile failed at %d:%d: %s\n", error.line, error.column, error.message);
+        return 1;
+    }
+
+    // Two hours of 5 s readings with a slow drift so statistics are live
+    alarm_inputs_t inputs;
+    uint32_t now = 0;
+    alarm_history_reset(&history, now);
+    for (int i = 0; i < 1440; i++) {
+        now += 5000;
+        inputs.values[static_cast<int>(AlarmVar::PH)] = 6.0f + 0.0005f * i;
+        inputs.values[static_cast<int>(AlarmVar::EC)] = 1.4f - 0.0001f * i;
+        inputs.values[static_cast<int>(AlarmVar::VOLUME)] = 40.0f - 0.002f * i;
+        inputs.values[static_cast<int>(AlarmVar::TEMP)] = 22.0f;
+        inputs.values[static_cast<int>(AlarmVar::PH_DOSED)] = (float)(i / 60) * 5.0f;
+        inputs.values[static_cast<int>(AlarmVar::AUTO_PH)] = 1.0f;
+        inputs.timestamp = now;
+        alarm_history_push(&history, &inputs);
+    }
+
+    alarm_event_t events[ALARM_MAX_RULES];
+    unsigned long allocations_before = allocations;
+    long transitions = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < iterations; i++) {
+        inputs.values[static_cast<int>(AlarmVar::PH)] = 6.0f + 0.3f * (float)((i >> 4) & 7);
+        inputs.timestamp = now + (uint32_t)(i & 1023);
+        transitions += alarm_program_step(&program, &inputs, &history, events, ALARM_MAX_RULES);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    double per_cycle = elapsed / (double)iterations;
+    printf("alarm bench: %d rules, %d bytes bytecode, %ld cycles, %ld transitions\n",
+           program.rule_count, program.code_used, iterations, transitions);
+    printf("alarm bench: %.0f ns/cycle (%.1f ns/rule), %lu allocations during evaluation\n",
+           per_cycle, per_cycle / program.rule_count, allocations - allocations_before);
+
+    if (program.rule_count != 50) return 1;
+    return allocations == allocations_before ? 0 : 1;
+}
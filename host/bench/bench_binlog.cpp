@@ -0,0 +1,217 @@
+/**
+ * @file bench_binlog.cpp
+ * @brief Benchmark: binlog call-site cost, MPSC accounting and raw round trip
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * 1. Round trip: records with every supported conversion (and more distinct
+ *    strings than the raw dictionary holds) are drained to a text sink and a
+ *    raw sink; decoding the raw stream must reproduce the text exactly.
+ * 2. MPSC: four producer threads log numbered records while the main thread
+ *    drains. Every producer's records must arrive in order. With producers
+ *    retrying dropped records nothing may be lost; without, published plus
+ *    dropped must equal what was logged.
+ * 3. Cost: binlog() against formatting the same line with vsnprintf into a
+ *    512-byte buffer, which is what Debug->printf does at the call site.
+ *    Fails unless the deferred call is cheaper.
+ *
+ *   bench_binlog [calls]
+ */
+
+#include "binlog.h"
+#include "binlog_decode.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+static std::vector<std::string> text_lines;
+static std::vector<uint8_t> raw_stream;
+static std::vector<std::string> decoded_lines;
+
+static void capture_text(const binlog_record_t& record, const char* text) {
+    (void)record;
+    text_lines.push_back(text);
+}
+
+static void capture_raw(const uint8_t* data, size_t len) {
+    raw_stream.insert(raw_stream.end(), data, data + len);
+}
+
+static void capture_decoded(uint32_t timestamp_us, const char* text, void* ctx) {
+    (void)timestamp_us;
+    (void)ctx;
+    decoded_lines.push_back(text);
+}
+
+static void drain_all(void) {
+    while (binlog_drain(BINLOG_DRAIN_PER_LOOP) > 0) {}
+}
+
+//=============================================================================
+// ROUND TRIP
+//=============================================================================
+
+static const char* const kPumpNames[] = {"pH_Up", "pH_Down", "Nut_A", "Nut_B"};
+static char names[BINLOG_DICT_SIZE * 2][12];     // More %s strings than the dictionary holds
+
+static bool round_trip(void) {
+    binlog_init();
+    text_lines.clear();
+    raw_stream.clear();
+    decoded_lines.clear();
+    binlog_add_sink(capture_text);
+    binlog_add_raw_sink(capture_raw);
+
+    binlog("[STATE] PUMP_%d: %s -> %s", 2, "DOSING", "COOLING_DOWN");
+    binlog("Pump %s completed dose after %.1fs", kPumpNames[1], 12.25f);
+    binlog("pH %.2f -> %.2f, slope %+.2f/h, %5.1f%%", 6.4f, 6.0, -0.125f, 42.0f);
+    binlog("signed %d %i, unsigned %u %lu", -42, INT32_MIN, 4000000000u, (unsigned long)123456);
+    binlog("hex %08x %X, char %c", 0xbeefu, 255, 'k');
+    binlog("width [%-8s] [%8s] [%04d] [%-6u]", "left", "right", 7, 99u);
+    binlog("no arguments, 100%% literal");
+    binlog("missing %d %s");
+    binlog("%s%s%s%s%s%s", "a", "b", "c", "d", "e", "f");
+    for (int i = 0; i < BINLOG_DICT_SIZE * 2; i++) {
+        snprintf(names[i], sizeof(names[i]), "name%03d", i);
+        binlog("dictionary %s #%d", (const char*)names[i], i);
+        if (i % 16 == 15) drain_all();
+    }
+    drain_all();
+
+    binlog_decoder_t decoder;
+    if (!binlog_decode(&decoder, raw_stream.data(), raw_stream.size(), capture_decoded, nullptr)) {
+        fprintf(stderr, "bench_binlog: decode failed: %s\n", decoder.error.c_str());
+        return false;
+    }
+    if (decoded_lines != text_lines) {
+        fprintf(stderr, "bench_binlog: decoded %zu lines, console %zu\n", decoded_lines.size(), text_lines.size());
+        for (size_t i = 0; i < decoded_lines.size() && i < text_lines.size(); i++) {
+            if (decoded_lines[i] != text_lines[i]) {
+                fprintf(stderr, "  console: %s\n  decoded: %s\n", text_lines[i].c_str(), decoded_lines[i].c_str());
+                break;
+            }
+        }
+        return false;
+    }
+    printf("binlog bench: round trip %zu records, %zu raw bytes, e.g. \"%s\"\n", text_lines.size(),
+           raw_stream.size(), text_lines[3].c_str());
+    return true;
+}
+
+//=============================================================================
+// MPSC ACCOUNTING
+//=============================================================================
+
+static constexpr int kProducers = 4;
+static uint32_t next_seq[kProducers];
+static uint32_t received = 0;
+static bool in_order = true;
+
+static void check_order(const binlog_record_t& record, const char* text) {
+    (void)text;
+    if (record.argc != 2) return;                // Drop reports
+    uint32_t producer = (uint32_t)record.args[0];
+    uint32_t seq = (uint32_t)record.args[1];
+    if (producer >= (uint32_t)kProducers || seq < next_seq[producer]) {
+        in_order = false;
+    } else {
+        next_seq[producer] = seq + 1;
+    }
+    received++;
+}
+
+static bool mpsc(long per_producer, bool retry) {
+    binlog_init();
+    binlog_add_sink(check_order);
+    memset(next_seq, 0, sizeof(next_seq));
+    received = 0;
+
+    std::atomic<int> running{kProducers};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([p, per_producer, retry, &running]() {
+            for (long i = 0; i < per_producer; i++) {
+                while (!binlog("producer %u seq %u", (unsigned)p, (unsigned)i) && retry) {
+                    std::this_thread::yield();
+                }
+            }
+            running--;
+        });
+    }
+    while (running.load() > 0) {
+        binlog_drain(BINLOG_DRAIN_PER_LOOP);
+    }
+    for (auto& t : producers) t.join();
+    drain_all();
+
+    binlog_stats_t stats = binlog_get_stats();
+    long total = per_producer * kProducers;
+    printf("binlog bench: %d producers x %ld records%s: %u published, %u dropped, high water %u/%d\n",
+           kProducers, per_producer, retry ? " (retrying)" : "", received, stats.dropped, stats.high_water,
+           BINLOG_RING_SIZE);
+    if (!in_order) {
+        fprintf(stderr, "bench_binlog: records of one producer arrived out of order\n");
+        return false;
+    }
+    bool balanced = retry ? stats.written == (uint32_t)total : stats.written + stats.dropped == (uint32_t)total;
+    if (!balanced || received != stats.written || stats.pending != 0) {
+        fprintf(stderr, "bench_binlog: accounting mismatch (logged %ld)\n", total);
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// CALL-SITE COST
+//=============================================================================
+
+static volatile char sink_byte;
+
+static void format_at_call_site(const char* format, ...) {
+    char buffer[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    sink_byte = buffer[0];
+}
+
+int main(int argc, char** argv) {
+    long calls = argc > 1 ? atol(argv[1]) : 200000;
+
+    if (!round_trip()) return 1;
+    if (!mpsc(calls / 40, true) || !mpsc(calls / 4, false)) return 1;
+
+    binlog_init();
+    double deferred = 0.0;
+    long pushed = 0;
+    while (pushed < calls) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < BINLOG_RING_SIZE; i++) {
+            binlog("pH dosing: %.1fml %s (pH %.2f -> %.2f, Vol: %.1fL)", 2.5f, kPumpNames[i & 3], 6.41f, 6.0f, 40.0f);
+        }
+        deferred += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        pushed += BINLOG_RING_SIZE;
+        binlog_init();                            // Empty without formatting (drain cost is off the hot path)
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < calls; i++) {
+        format_at_call_site("pH dosing: %.1fml %s (pH %.2f -> %.2f, Vol: %.1fL)", 2.5f, kPumpNames[i & 3], 6.41f,
+                            6.0f, 40.0f);
+    }
+    double formatted = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    double per_deferred = deferred / (double)pushed;
+    double per_formatted = formatted / (double)calls;
+    printf("binlog bench: binlog() %.1f ns/call, vsnprintf at call site %.1f ns/call (%.1fx)\n", per_deferred,
+           per_formatted, per_formatted / per_deferred);
+    return per_deferred < per_formatted ? 0 : 1;
+}
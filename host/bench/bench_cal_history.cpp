@@ -0,0 +1,285 @@
+/**
+ * @file bench_cal_history.cpp
+ * @brief Benchmark: calibration history, rollback and probe-aging prediction
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Runs the firmware's calibration path (calibration_ph_2point/_ec_2point,
+ * the 'k' command, the operating-hours clock) over simulated months:
+ *
+ * 1. Aging: a pH probe whose slope efficiency falls linearly (1 %/1000 h by
+ *    default, from 100 %) is calibrated in pH 4.01/7.00 buffers every 720
+ *    operating hours with 0.3 mV reading noise and a drifting zero point.
+ *    After each calibration the predicted hours at which the probe crosses
+ *    the 85 % limit are compared with the true crossing. The board resets
+ *    every 1000.6 h, so each reset drops part of an hour not yet stored.
+ * 2. Botched calibration: the pH 7.00 reading carries 25 mV over from the
+ *    pH 4.01 buffer (probe not rinsed), so the stored slope puts the probe
+ *    below its limit. 'k rollback ph' must restore the previous record as
+ *    the calibration in use and in NVS, and take the botched record out of
+ *    the aging fit.
+ * 3. Ring: only the last CAL_HISTORY_RECORDS records are kept, newest first.
+ * 4. Reset within the hour: two calibrations half an hour apart with a reset
+ *    between them, before the hours counter is due to be stored. The second
+ *    record must not be stamped before the first, and the earlier records
+ *    must still load.
+ * 5. EC: the first calibration of a cell is its 100 %.
+ * 6. Cost: cal_history_tick(), the only per-loop() work, against one
+ *    history load from NVS (console and calibration only).
+ *
+ * Fails if a prediction misses the true crossing by more than twice its own
+ * one-sigma band (predicted - earliest), or by more than 10 % once the probe
+ * is below 90 %, if the hours counter lost more than an hour per reset, or
+ * if any rollback, ring or EC check does not hold.
+ *
+ *   bench_cal_history [decline_pct_per_kh] [months]
+ */
+
+#include "cal_history.h"
+#include "calibration.h"
+#include "cli.h"
+#include "communication.h"
+#include "sensors.h"
+#include "host_hal.h"
+
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// NVS preferences object (main.cpp is not linked)
+Preferences preferences;
+
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+static constexpr float kNernstMvPerPh = 59.16f;         // 100 % probe at 25 C
+static constexpr float kCalEveryH = 720.0f;
+static constexpr double kResetEveryH = 1000.6;          // Not a whole hour: each reset loses some
+static constexpr float kLimit = CAL_HISTORY_DEFAULT_PH_LIMIT;
+
+static std::mt19937 rng(7);
+static double true_hours = 0.0;                       // Operating hours the bench has run
+static int resets = 0;
+
+static void boot(void) {
+    preferences.begin(NVS_NAMESPACE);
+    calibration_load();
+    cal_history_init();
+}
+
+/**
+ * @brief Run the board for 'hours', ticking the clock like loop() and resetting every kResetEveryH
+ */
+static void run_for(double hours) {
+    static double next_reset = kResetEveryH;
+    double end = true_hours + hours;
+    while (true_hours < end) {
+        double step = fmin(fmin(0.25, end - true_hours), next_reset - true_hours);
+        host_advance_ms((uint32_t)(step * 3600000.0 + 0.5));
+        true_hours += step;
+        cal_history_tick();
+        if (true_hours >= next_reset - 1e-9) {
+            preferences.end();
+            boot();
+            resets++;
+            next_reset += kResetEveryH;
+        }
+    }
+}
+
+/**
+ * @brief Type 'k' and one command line on the Serial console
+ */
+static void command(const char* line) {
+    host_serial_feed(reinterpret_cast<const uint8_t*>("k"), 1);
+    host_serial_feed(reinterpret_cast<const uint8_t*>(line), strlen(line));
+    Debug->update();
+    if (Debug->available()) cli_process_command(Debug->read());
+}
+
+/**
+ * @brief Buffer readings of a probe at 'efficiency' with zero point 'zero_mv', plus reading noise
+ * @param carryover_mv pH 7.00 reading pulled towards the pH 4.01 one (probe not rinsed)
+ */
+static void calibrate_ph(float efficiency, float zero_mv, float carryover_mv) {
+    std::normal_distribution<float> noise(0.0f, 0.3f);
+    float mv4 = zero_mv + (7.0f - 4.01f) * kNernstMvPerPh * efficiency + noise(rng);
+    float mv7 = zero_mv + carryover_mv + noise(rng);
+    // The board reads the probe through a +1000 mV bias; the calibration sees the ADC voltage
+    calibration_ph_2point(1000.0f + mv4, 4.01f, 1000.0f + mv7, 7.00f);
+}
+
+static bool predicted_due(float* due, float* early) {
+    cal_history_t hist;
+    cal_history_load(CalProbe::PH, &hist);
+    cal_aging_t aging;
+    if (!cal_history_aging(&hist, kLimit, &aging) || aging.hours_left < 0.0f) return false;
+    float newest = 0.0f;
+    for (int back = 0; back < hist.count; back++) {
+        const cal_record_t* r = cal_history_at(&hist, back);
+        if (!(r->flags & CAL_RECORD_ROLLED_BACK)) {
+            newest = r->hours;
+            break;
+        }
+    }
+    *due = newest + aging.hours_left;
+    *early = aging.hours_left_early >= 0.0f ? newest + aging.hours_left_early : -1.0f;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    float decline = argc > 1 ? (float)atof(argv[1]) : 1.0f;     // % per 1000 h
+    int months = argc > 2 ? atoi(argv[2]) : 16;
+    const float true_due = (100.0f - kLimit) / decline * 1000.0f;
+
+    host_reset();
+    communication_init("bench", "bench");
+    boot();
+
+    // 1. Aging
+    printf("pH probe losing %.2f %%/1000 h, calibrated every %.0f h, limit %.0f %% reached at %.0f h\n", decline,
+           kCalEveryH, kLimit, true_due);
+    printf("%4s %9s %9s %8s %9s %9s %8s\n", "cal", "true h", "clock h", "eff %", "due h", "early h", "error");
+    float last_due = 0.0f;
+    for (int month = 0; month < months; month++) {
+        if (month > 0) run_for(kCalEveryH);
+        float efficiency = 1.0f - decline / 100.0f * (float)true_hours / 1000.0f;
+        calibrate_ph(efficiency, 2.0f + 0.004f * (float)true_hours, 0.0f);
+
+        float due = 0.0f, early = 0.0f;
+        bool have = predicted_due(&due, &early);
+        float error = have ? (due - true_due) / true_due * 100.0f : 0.0f;
+        printf("%4d %9.1f %9.1f %8.2f ", month + 1, true_hours, cal_history_hours(), efficiency * 100.0f);
+        if (have) {
+            printf("%9.0f %9.0f %+7.1f%%\n", due, early, error);
+            last_due = due;
+        } else {
+            printf("%9s %9s %8s\n", "-", "-", "-");
+        }
+        if (month + 1 >= CAL_HISTORY_MIN_POINTS) {
+            EXPECT(have && early >= 0.0f && fabsf(due - true_due) <= 2.0f * (due - early),
+                   "prediction after %d calibrations %.0f h, earliest %.0f h, truth %.0f h\n", month + 1, due, early,
+                   true_due);
+        }
+        if (efficiency <= 0.90f) {
+            EXPECT(have && fabsf(error) <= 10.0f, "prediction after %d calibrations off by %.1f %%\n", month + 1,
+                   error);
+        }
+    }
+    float lost = (float)true_hours - cal_history_hours();
+    printf("hours counter: %.1f h behind after %d resets (millis() wrapped %d times)\n", lost, resets,
+           (int)(true_hours / (4294967.296 / 3600.0)));
+    EXPECT(lost >= 0.0f && lost <= resets * 1.0f + 0.01f, "counter lost %.2f h over %d resets\n", lost, resets);
+
+    // 2. Botched calibration and rollback
+    calibration_t good = calibration;
+    cal_history_t hist;
+    cal_history_load(CalProbe::PH, &hist);
+    uint32_t good_seq = hist.active_seq;
+    run_for(24.0);
+    float efficiency = 1.0f - decline / 100.0f * (float)true_hours / 1000.0f;
+    calibrate_ph(efficiency, 2.0f + 0.004f * (float)true_hours, 25.0f);
+    cal_history_load(CalProbe::PH, &hist);
+    cal_aging_t aging;
+    cal_history_aging(&hist, kLimit, &aging);
+    printf("botched (pH 7 read with 25 mV carry-over): efficiency %.1f %%, fit %.1f %%, %s\n",
+           cal_history_efficiency(&hist, *cal_history_at(&hist, 0)), aging.efficiency,
+           aging.hours_left == 0.0f ? "below the limit - replace now" : "limit not reached");
+
+    command("rollback ph\n");
+    cal_history_load(CalProbe::PH, &hist);
+    cal_history_aging(&hist, kLimit, &aging);
+    float rolled_due = 0.0f, early = 0.0f;
+    bool rolled_have = predicted_due(&rolled_due, &early);
+    printf("rolled back to #%lu: slope %.6f offset %.4f, %u records counted, limit at %.0f h (%.0f h before)\n",
+           (unsigned long)hist.active_seq, calibration.ph_slope, calibration.ph_offset, aging.points, rolled_due,
+           last_due);
+    EXPECT(hist.active_seq == good_seq, "rollback went to #%lu, not #%lu\n", (unsigned long)hist.active_seq,
+           (unsigned long)good_seq);
+    EXPECT(calibration.ph_slope == good.ph_slope && calibration.ph_offset == good.ph_offset,
+           "rollback did not restore the previous calibration\n");
+    const cal_record_t* botched = cal_history_at(&hist, 0);
+    EXPECT(botched && (botched->flags & CAL_RECORD_ROLLED_BACK), "botched record not marked rolled back\n");
+    EXPECT(aging.points == hist.count - 1, "%u records counted after rollback, expected %u\n", aging.points,
+           hist.count - 1);
+    EXPECT(rolled_have && early >= 0.0f && fabsf(rolled_due - true_due) <= 2.0f * (rolled_due - early),
+           "prediction after rollback %.0f h, earliest %.0f h, truth %.0f h\n", rolled_due, early, true_due);
+    calibration = calibration_t();
+    calibration_load();
+    EXPECT(calibration.ph_slope == good.ph_slope && calibration.ph_offset == good.ph_offset,
+           "rolled-back calibration not what calibration_load() reads back\n");
+
+    // 3. Ring
+    EXPECT(hist.count == CAL_HISTORY_RECORDS, "ring holds %u records\n", hist.count);
+    for (int back = 0; back < hist.count; back++) {
+        const cal_record_t* r = cal_history_at(&hist, back);
+        EXPECT(r->seq == hist.next_seq - 1 - (uint32_t)back, "record %d back is #%lu\n", back,
+               (unsigned long)r->seq);
+    }
+    printf("ring: %u records kept, #%lu..#%lu\n", hist.count, (unsigned long)cal_history_at(&hist, hist.count - 1)->seq,
+           (unsigned long)cal_history_at(&hist, 0)->seq);
+
+    // 4. Reset within the hour
+    run_for(kCalEveryH);
+    calibrate_ph(1.0f - decline / 100.0f * (float)true_hours / 1000.0f, 2.0f + 0.004f * (float)true_hours, 0.0f);
+    cal_history_load(CalProbe::PH, &hist);
+    cal_record_t before = *cal_history_at(&hist, 0);
+    run_for(0.5);
+    preferences.end();
+    boot();
+    resets++;
+    calibrate_ph(1.0f - decline / 100.0f * (float)true_hours / 1000.0f, 2.0f + 0.004f * (float)true_hours, 0.0f);
+    bool kept = cal_history_load(CalProbe::PH, &hist);
+    const cal_record_t* after = cal_history_at(&hist, 0);
+    const cal_record_t* prev = cal_history_at(&hist, 1);
+    printf("reset within the hour: #%lu at %.1f h, then #%lu at %.1f h, %u records kept\n",
+           (unsigned long)before.seq, before.hours, after ? (unsigned long)after->seq : 0UL,
+           after ? after->hours : 0.0f, hist.count);
+    EXPECT(kept && hist.count == CAL_HISTORY_RECORDS, "history lost across the reset (%u records)\n", hist.count);
+    EXPECT(prev && prev->seq == before.seq && prev->hours == before.hours, "record #%lu not kept across the reset\n",
+           (unsigned long)before.seq);
+    EXPECT(after && after->hours >= before.hours, "record after the reset stamped before #%lu\n",
+           (unsigned long)before.seq);
+
+    // 5. EC: first cell calibration is 100 %, a fouled cell needs a larger slope
+    calibration_ec_2point(100.0f, 1.413f, 1300.0f, 12.88f);
+    run_for(kCalEveryH);
+    calibration_ec_2point(95.0f, 1.413f, 1235.0f, 12.88f);
+    cal_history_t ec;
+    cal_history_load(CalProbe::EC, &ec);
+    float ec_first = cal_history_efficiency(&ec, *cal_history_at(&ec, 1));
+    float ec_now = cal_history_efficiency(&ec, *cal_history_at(&ec, 0));
+    printf("EC cell: %.1f %% at first calibration, %.1f %% after %.0f h\n", ec_first, ec_now, kCalEveryH);
+    EXPECT(fabsf(ec_first - 100.0f) < 0.01f, "first EC calibration at %.2f %%\n", ec_first);
+    EXPECT(fabsf(ec_now - 95.0f) < 0.1f, "fouled EC cell at %.2f %%, expected 95 %%\n", ec_now);
+
+    // 6. Cost
+    const int kTicks = 1000000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTicks; i++) cal_history_tick();
+    auto t1 = std::chrono::steady_clock::now();
+    const int kLoads = 10000;
+    uint32_t sink = 0;
+    for (int i = 0; i < kLoads; i++) {
+        cal_history_load(CalProbe::PH, &hist);
+        sink += hist.count;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    double tick_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / kTicks;
+    double load_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / kLoads;
+    printf("cost (host): cal_history_tick %.1f ns per loop(), history load %.0f ns (console only) [%u]\n", tick_ns,
+           load_ns, sink / kLoads);
+
+    return failures ? 1 : 0;
+}
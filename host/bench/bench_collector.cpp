@@ -0,0 +1,504 @@
+/**
+ * @file bench_collector.cpp
+ * @brief Load test of the telemetry collector against simulated controllers
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Starts N simulated devices on localhost (three in four serve binary
+ * telemetry frames, the rest console text), points one collector at all of
+ * them and streams a fixed number of readings per device as fast as the
+ * sockets take them. Reports the sustained ingest rate and the collector's
+ * memory per connection, then checks every device's columnar files row by
+ * row.
+ *
+ *   bench_collector [devices] [readings_per_device] [workers]
+ *
+ * Then one device streams a reading every 5 ms, too few to fill the row
+ * buffer between flushes, and the stored row count is sampled while it does.
+ *
+ * Fails if a reading is missing or wrong, an event is lost, the deliberate
+ * sequence gap on device 0 is not reported exactly, a device needs more
+ * than 8 KiB of collector memory, or rows under continuous load take longer
+ * than flush_ms (plus scheduling slack) to reach disk.
+ */
+
+#include "collector.h"
+#include "telemetry.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr uint32_t GAP_DEVICE = 0;
+constexpr uint32_t GAP_FRAMES = 3;
+constexpr size_t MAX_BYTES_PER_CONNECTION = 8192;
+constexpr uint32_t LOAD_FLUSH_MS = 200;
+constexpr uint32_t LOAD_INTERVAL_MS = 5;             // 40 rows per flush_ms, below COLLECTOR_FLUSH_ROWS
+constexpr uint32_t LOAD_READINGS = 400;
+constexpr uint32_t LOAD_SLACK_MS = 100;
+
+//=============================================================================
+// SIMULATED DEVICES
+//=============================================================================
+
+struct sim_device_t {
+    int listen_fd = -1;
+    int fd = -1;
+    uint16_t port = 0;
+    CollectorProtocol protocol = CollectorProtocol::BINARY;
+    std::vector<uint8_t> stream;                 // Everything the device will send
+    size_t sent = 0;
+    uint32_t events = 0;
+    uint32_t ignored_lines = 0;
+};
+
+static float expected_ph(uint32_t device, uint32_t k) {
+    return 5.50f + (float)((k + device) % 150) * 0.01f;
+}
+
+static float expected_ec(uint32_t device) {
+    return 1.00f + (float)(device % 10) * 0.10f;
+}
+
+static float expected_volume(uint32_t k) {
+    return 40.0f - (float)(k % 100) * 0.1f;
+}
+
+static uint32_t expected_ts(uint32_t device, uint32_t k) {
+    return 1000u * k + device;
+}
+
+static void append_frame(sim_device_t& sim, const telemetry_event_t& event) {
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    size_t len = telemetry_encode(event, frame, sizeof(frame));
+    sim.stream.insert(sim.stream.end(), frame, frame + len);
+}
+
+static void append_text(sim_device_t& sim, const char* text) {
+    sim.stream.insert(sim.stream.end(), text, text + strlen(text));
+}
+
+/**
+ * @brief Pre-render a device's stream the way the firmware would send it
+ */
+static void build_stream(sim_device_t& sim, uint32_t device, uint32_t readings) {
+    uint32_t seq = 0;
+    for (uint32_t k = 0; k < readings; k++) {
+        sensor_readings_t r;
+        r.ph = expected_ph(device, k);
+        r.ec = expected_ec(device);
+        r.volume = expected_volume(k);
+        r.temperature = 21.5f;
+        r.timestamp = expected_ts(device, k);
+
+        if (sim.protocol == CollectorProtocol::BINARY) {
+            if (device == GAP_DEVICE && k == readings / 2) seq += GAP_FRAMES;   // Frames lost on the device
+            telemetry_event_t event = telemetry_event_t();
+            event.type = TelemetryType::READING;
+            event.seq = seq++;
+            event.timestamp = r.timestamp;
+            event.reading = r;
+            append_frame(sim, event);
+            if (k % 50 == 25) {
+                telemetry_event_t pump = telemetry_event_t();
+                pump.type = TelemetryType::PUMP;
+                pump.seq = seq++;
+                pump.timestamp = r.timestamp + 1;
+                pump.pump = (uint8_t)(k % 4);
+                pump.from_state = 0;
+                pump.to_state = 1;
+                append_frame(sim, pump);
+                sim.events++;
+            }
+            if (k % 200 == 100) {
+                telemetry_event_t alarm = telemetry_event_t();
+                alarm.type = TelemetryType::ALARM;
+                alarm.seq = seq++;
+                alarm.timestamp = r.timestamp + 2;
+                strcpy(alarm.alarm_name, "ph_high");
+                alarm.severity = 1;
+                alarm.raised = true;
+                alarm.value = r.ph;
+                append_frame(sim, alarm);
+                sim.events++;
+            }
+        } else {
+            char line[128];
+            snprintf(line, sizeof(line), "%.2f | %.2f | %.1f L\r\n", r.ph, r.ec, r.volume);
+            append_text(sim, line);
+            if (k % 100 == 50) {
+                snprintf(line, sizeof(line), "[%lu] Pump system initialized successfully [WiFi]\r\n",
+                         (unsigned long)r.timestamp);
+                append_text(sim, line);
+                sim.ignored_lines++;
+            }
+            if (k % 200 == 100) {
+                snprintf(line, sizeof(line), "[%lu] ALARM RAISED ph_high [crit] value=%.3f [WiFi]\r\n",
+                         (unsigned long)r.timestamp, r.ph);
+                append_text(sim, line);
+                sim.events++;
+            }
+        }
+    }
+}
+
+static bool open_listener(sim_device_t& sim) {
+    sim.listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sim.listen_fd < 0) return false;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (bind(sim.listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(sim.listen_fd, 4) != 0 ||
+        getsockname(sim.listen_fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        return false;
+    }
+    sim.port = ntohs(addr.sin_port);
+    return true;
+}
+
+/**
+ * @brief Serve every simulated device from one epoll loop until stop is set
+ * Listener and connection events are told apart by the low bit of data.u64.
+ */
+static void run_simulator(std::vector<sim_device_t>* sims, std::atomic<bool>* stop) {
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    for (size_t i = 0; i < sims->size(); i++) {
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u64 = i << 1;
+        epoll_ctl(ep, EPOLL_CTL_ADD, (*sims)[i].listen_fd, &ev);
+    }
+    epoll_event events[128];
+    while (!stop->load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, events, 128, 20);
+        for (int e = 0; e < n; e++) {
+            sim_device_t& sim = (*sims)[events[e].data.u64 >> 1];
+            if ((events[e].data.u64 & 1) == 0) {
+                int fd = accept4(sim.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) continue;
+                if (sim.fd >= 0) {                   // One collector per device
+                    close(fd);
+                    continue;
+                }
+                sim.fd = fd;
+                epoll_event ev = {};
+                ev.events = EPOLLOUT;
+                ev.data.u64 = (events[e].data.u64 & ~1ull) | 1;
+                epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+                continue;
+            }
+            while (sim.sent < sim.stream.size()) {
+                ssize_t w = send(sim.fd, sim.stream.data() + sim.sent, sim.stream.size() - sim.sent, MSG_NOSIGNAL);
+                if (w <= 0) break;
+                sim.sent += (size_t)w;
+            }
+            if (sim.sent == sim.stream.size()) {
+                epoll_ctl(ep, EPOLL_CTL_DEL, sim.fd, nullptr);   // Done; stay connected and quiet
+            }
+        }
+    }
+    close(ep);
+}
+
+//=============================================================================
+// HELPERS
+//=============================================================================
+
+static double now_s(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static long rss_kb(void) {
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    long pages = 0, resident = 0;
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static std::vector<uint8_t> read_file(const std::string& path) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return data;
+    uint8_t buffer[8192];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) data.insert(data.end(), buffer, buffer + n);
+    fclose(f);
+    return data;
+}
+
+static int remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+    (void)st;
+    (void)flag;
+    (void)ftw;
+    return remove(path);
+}
+
+/**
+ * @brief Compare one device's columns with what it sent
+ * @return Number of wrong or missing rows
+ */
+static uint32_t check_device(const std::string& dir, uint32_t device, const sim_device_t& sim, uint32_t readings) {
+    std::vector<uint8_t> ts = read_file(dir + "/ts.u32");
+    std::vector<uint8_t> ph = read_file(dir + "/ph.f32");
+    std::vector<uint8_t> ec = read_file(dir + "/ec.f32");
+    std::vector<uint8_t> volume = read_file(dir + "/volume.f32");
+    std::vector<uint8_t> temp = read_file(dir + "/temp.f32");
+    size_t expected_bytes = (size_t)readings * 4;
+    if (ts.size() != expected_bytes || ph.size() != expected_bytes || ec.size() != expected_bytes ||
+        volume.size() != expected_bytes || temp.size() != expected_bytes) {
+        return readings;
+    }
+
+    bool binary = sim.protocol == CollectorProtocol::BINARY;
+    uint32_t bad = 0;
+    for (uint32_t k = 0; k < readings; k++) {
+        uint32_t t;
+        float p, e, v, c;
+        memcpy(&t, &ts[k * 4], 4);
+        memcpy(&p, &ph[k * 4], 4);
+        memcpy(&e, &ec[k * 4], 4);
+        memcpy(&v, &volume[k * 4], 4);
+        memcpy(&c, &temp[k * 4], 4);
+        // Binary: frame fixed-point; text: printed with 2/2/1 decimals, no temperature
+        bool ok = fabsf(p - expected_ph(device, k)) < (binary ? 0.0006f : 0.006f) &&
+                  fabsf(e - expected_ec(device)) < (binary ? 0.0006f : 0.006f) &&
+                  fabsf(v - expected_volume(k)) < 0.06f;
+        if (binary) {
+            ok = ok && t == expected_ts(device, k) && fabsf(c - 21.5f) < 0.006f;
+        } else {
+            ok = ok && isnan(c);
+        }
+        if (!ok) bad++;
+    }
+    return bad;
+}
+
+//=============================================================================
+// CONTINUOUS LOAD
+//=============================================================================
+
+/**
+ * @brief One device sending a reading every LOAD_INTERVAL_MS keeps the
+ * worker's queue from ever being empty; rows must still reach disk on time
+ * @return Longest time in ms the stored rows lagged the ingested ones, or -1
+ */
+static long continuous_load(void) {
+    sim_device_t sim;
+    build_stream(sim, 1, LOAD_READINGS);
+    char dir_template[] = "/tmp/bench_collector_load.XXXXXX";
+    if (!open_listener(sim) || !mkdtemp(dir_template)) return -1;
+
+    collector_config_t config;
+    config.out_dir = dir_template;
+    config.workers = 1;
+    config.flush_ms = LOAD_FLUSH_MS;
+    std::vector<collector_device_t> devices = {{"load", "127.0.0.1", sim.port, CollectorProtocol::BINARY}};
+    std::string error;
+    collector_t* collector = collector_create(config, devices, &error);
+    if (!collector) {
+        fprintf(stderr, "bench_collector: %s\n", error.c_str());
+        return -1;
+    }
+
+    // Paced sender: a reading's share of the stream per interval on a blocking socket
+    std::atomic<bool> sent_all{false};
+    std::thread sender([&sim, &sent_all] {
+        int flags = fcntl(sim.listen_fd, F_GETFL);
+        fcntl(sim.listen_fd, F_SETFL, flags & ~O_NONBLOCK);
+        sim.fd = accept(sim.listen_fd, nullptr, nullptr);
+        size_t size = sim.stream.size();
+        for (uint32_t k = 0; sim.fd >= 0 && k < LOAD_READINGS; k++) {
+            size_t from = size * k / LOAD_READINGS, to = size * (k + 1) / LOAD_READINGS;
+            send(sim.fd, sim.stream.data() + from, to - from, MSG_NOSIGNAL);
+            usleep(LOAD_INTERVAL_MS * 1000);
+        }
+        sent_all = true;
+    });
+    std::thread loop([collector] { collector_run(collector); });
+
+    // Longest stretch in which the stored row count did not move while behind
+    std::string ts_path = std::string(dir_template) + "/load/ts.u32";
+    double t_start = now_s(), caught_up = now_s();
+    long worst_ms = 0;
+    size_t stored = 0;
+    while (!sent_all && now_s() - t_start < 30.0) {
+        usleep(2000);
+        uint64_t ingested = collector_get_stats(collector).readings;
+        size_t rows = read_file(ts_path).size() / 4;
+        double t = now_s();
+        if (rows != stored || rows >= ingested) caught_up = t;
+        stored = rows;
+        long lag_ms = (long)((t - caught_up) * 1000.0);
+        if (lag_ms > worst_ms) worst_ms = lag_ms;
+    }
+    sender.join();
+    collector_stop(collector);
+    loop.join();
+    collector_destroy(collector);
+    if (sim.fd >= 0) close(sim.fd);
+    close(sim.listen_fd);
+    nftw(dir_template, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    return stored > 0 ? worst_ms : -1;
+}
+
+//=============================================================================
+// MAIN
+//=============================================================================
+
+int main(int argc, char** argv) {
+    uint32_t device_count = argc > 1 ? (uint32_t)atoi(argv[1]) : 256;
+    uint32_t readings = argc > 2 ? (uint32_t)atoi(argv[2]) : 2000;
+    int workers = argc > 3 ? atoi(argv[3]) : 2;
+    if (device_count == 0 || readings < 4) {
+        fprintf(stderr, "usage: %s [devices] [readings_per_device>=4] [workers]\n", argv[0]);
+        return 2;
+    }
+
+    // Two sockets per device on the simulator side, one on the collector side
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    std::vector<sim_device_t> sims(device_count);
+    std::vector<collector_device_t> devices;
+    uint64_t expected_events = 0, expected_ignored = 0, stream_bytes = 0;
+    for (uint32_t d = 0; d < device_count; d++) {
+        sim_device_t& sim = sims[d];
+        sim.protocol = (d % 4 == 3) ? CollectorProtocol::TELNET : CollectorProtocol::BINARY;
+        build_stream(sim, d, readings);
+        if (!open_listener(sim)) {
+            fprintf(stderr, "bench_collector: cannot listen for device %u: %s\n", d, strerror(errno));
+            return 1;
+        }
+        expected_events += sim.events;
+        expected_ignored += sim.ignored_lines;
+        stream_bytes += sim.stream.size();
+        devices.push_back({"dev" + std::to_string(d), "127.0.0.1", sim.port, sim.protocol});
+    }
+
+    char dir_template[] = "/tmp/bench_collector.XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    collector_config_t config;
+    config.out_dir = dir_template;
+    config.workers = workers;
+    config.flush_ms = 200;
+    std::string error;
+    collector_t* collector = collector_create(config, devices, &error);
+    if (!collector) {
+        fprintf(stderr, "bench_collector: %s\n", error.c_str());
+        return 1;
+    }
+
+    std::atomic<bool> stop_sim{false};
+    std::thread simulator(run_simulator, &sims, &stop_sim);
+    long rss_before = rss_kb();
+    double t_start = now_s();
+    std::thread loop([collector] { collector_run(collector); });
+
+    uint64_t expected_readings = (uint64_t)device_count * readings;
+    collector_stats_t stats = collector_get_stats(collector);
+    double t_connected = 0;
+    long rss_peak = rss_before;
+    while (now_s() - t_start < 120.0) {
+        usleep(2000);
+        stats = collector_get_stats(collector);
+        if (t_connected == 0 && stats.connected == device_count) t_connected = now_s();
+        long rss = rss_kb();
+        if (rss > rss_peak) rss_peak = rss;
+        if (stats.readings >= expected_readings && stats.events >= expected_events) break;
+    }
+    double t_done = now_s();
+    collector_stop(collector);
+    loop.join();
+    stop_sim = true;
+    simulator.join();
+    stats = collector_get_stats(collector);
+
+    uint32_t bad_rows = 0, bad_devices = 0;
+    for (uint32_t d = 0; d < device_count; d++) {
+        uint32_t bad = check_device(std::string(dir_template) + "/dev" + std::to_string(d), d, sims[d], readings);
+        bad_rows += bad;
+        if (bad) bad_devices++;
+    }
+    collector_destroy(collector);
+    for (sim_device_t& sim : sims) {
+        if (sim.fd >= 0) close(sim.fd);
+        close(sim.listen_fd);
+    }
+    nftw(dir_template, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+
+    double seconds = t_done - t_start;
+    size_t accounted = collector_connection_bytes();
+    printf("Collector load test: %u devices (%u binary, %u telnet), %u readings each, %d workers\n",
+           device_count, device_count - device_count / 4, device_count / 4, readings, workers);
+    printf("  all connected after %.1f ms\n", t_connected > 0 ? (t_connected - t_start) * 1000.0 : -1.0);
+    printf("  ingest: %llu readings + %llu events in %.3f s = %.0f readings/s, %.1f MB/s on the wire\n",
+           (unsigned long long)stats.readings, (unsigned long long)stats.events, seconds,
+           stats.readings / seconds, stats.bytes / seconds / 1e6);
+    printf("  memory: %zu B/connection accounted, RSS +%.1f KiB/connection at peak (incl. shared chunks)\n",
+           accounted, (double)(rss_peak - rss_before) / device_count);
+    printf("  checks: seq gaps %llu (expected %u), bad frames %llu, ignored lines %llu (expected %llu), "
+           "wrong rows %u on %u devices\n",
+           (unsigned long long)stats.seq_gaps, GAP_FRAMES, (unsigned long long)stats.bad_frames,
+           (unsigned long long)stats.lines_ignored, (unsigned long long)expected_ignored, bad_rows, bad_devices);
+
+    bool ok = true;
+    if (stats.readings != expected_readings || bad_rows != 0) {
+        fprintf(stderr, "FAIL: %llu of %llu readings stored, %u rows wrong\n", (unsigned long long)stats.readings,
+                (unsigned long long)expected_readings, bad_rows);
+        ok = false;
+    }
+    if (stats.events != expected_events) {
+        fprintf(stderr, "FAIL: %llu of %llu events\n", (unsigned long long)stats.events,
+                (unsigned long long)expected_events);
+        ok = false;
+    }
+    if (stats.seq_gaps != GAP_FRAMES || stats.bad_frames != 0 || stats.lines_ignored != expected_ignored) {
+        fprintf(stderr, "FAIL: sequence gap, resync or line accounting is off\n");
+        ok = false;
+    }
+    if (stats.bytes != stream_bytes) {
+        fprintf(stderr, "FAIL: received %llu of %llu bytes\n", (unsigned long long)stats.bytes,
+                (unsigned long long)stream_bytes);
+        ok = false;
+    }
+    if (accounted > MAX_BYTES_PER_CONNECTION) {
+        fprintf(stderr, "FAIL: %zu B per connection (limit %zu)\n", accounted, MAX_BYTES_PER_CONNECTION);
+        ok = false;
+    }
+
+    long lag_ms = continuous_load();
+    printf("  continuous load: a reading every %u ms, stored rows lag at most %ld ms (flush_ms %u)\n",
+           LOAD_INTERVAL_MS, lag_ms, LOAD_FLUSH_MS);
+    if (lag_ms < 0 || lag_ms > (long)(LOAD_FLUSH_MS + LOAD_SLACK_MS)) {
+        fprintf(stderr, "FAIL: rows under continuous load reach disk after %ld ms (flush_ms %u)\n", lag_ms,
+                LOAD_FLUSH_MS);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
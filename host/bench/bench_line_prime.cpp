@@ -0,0 +1,168 @@
+/**
+ * @file bench_line_prime.cpp
+ * @brief Benchmark: delivered volume of short doses after idle periods
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Gives the simulated pumps a tubing dead volume that drains back while
+ * idle, then doses 5 ml of pH Up after increasing idle times. Scores what
+ * actually reached the solution against the requested volume, for the
+ * firmware with the default line volume and with the line volume calibrated,
+ * next to what the former fixed 2.5 s / 25 % prime would have delivered from
+ * the same line state. Errors are net of the pump's own metering error,
+ * measured in a run without a line. Also reports the priming time per dose.
+ * Fails if a calibrated dose is off by more than twice the priming threshold.
+ * Firmware globals are per process, so each mode runs in a forked child.
+ *
+ *   bench_line_prime [line_ml] [dose_ml]
+ */
+
+#include "sim_harness.h"
+#include "host_hal.h"
+#include "pump.h"
+#include "state_machine.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const double kIdleHours[] = {0.25, 2.0, 12.0, 72.0};
+static constexpr int kIdleCount = sizeof(kIdleHours) / sizeof(kIdleHours[0]);
+
+struct prime_result_t {
+    double error_ml[kIdleCount];         // Delivered - requested
+    double fixed_error_ml[kIdleCount];   // Same for a fixed 2.5 s prime at 25 % duty
+    double prime_s[kIdleCount];          // Time spent in PRIMING
+    double primed_ml;                    // Firmware's primed-volume total over the scored doses
+};
+
+struct prime_config_t {
+    float line_ml;
+    float dose_ml;
+    bool calibrated;
+};
+
+/**
+ * @brief Let the plant and firmware idle (one loop pass per simulated minute)
+ */
+static void idle_for(double hours) {
+    uint32_t end_ms = sim_now_ms() + (uint32_t)(hours * 3600000.0);
+    while (sim_now_ms() + 60000 <= end_ms) {
+        host_advance_ms(59900);
+        sim_step();
+    }
+}
+
+/**
+ * @brief Run one manual dose to completion
+ * @return ms the pump spent in PRIMING
+ */
+static uint32_t run_dose(float dose_ml) {
+    if (!pump_manual_dose(PumpId::PH_UP, dose_ml)) return UINT32_MAX;
+    uint32_t prime_ms = 0;
+    for (;;) {
+        PumpState state = state_manager.pump_states[static_cast<int>(PumpId::PH_UP)];
+        if (state != PumpState::PRIMING && state != PumpState::DOSING) break;
+        sim_step();
+        if (state == PumpState::PRIMING) prime_ms += 10;
+    }
+    return prime_ms;
+}
+
+static prime_result_t run_mode(const prime_config_t& config) {
+    reservoir_config_t plant;
+    plant.line_dead_ml = config.line_ml;
+    plant.line_drain_tau_h = PUMP_LINE_DRAIN_TAU_H;
+    plant.seed = 3;
+
+    sim_init(plant, 10);
+    sim_boot();
+    if (config.calibrated) pump_set_line_dead_volume(PumpId::PH_UP, config.line_ml);
+
+    // Old fixed prime: 2.5 s at 25 % duty, whatever the line held
+    const float fixed_prime_ml = reservoir_flow_from_duty((uint32_t)(255 * 0.25f)) * 2.5f / 60.0f;
+
+    // The firmware assumes an empty line after boot: one unscored dose brings both in step
+    idle_for(0.1);
+    run_dose(config.dose_ml);
+
+    prime_result_t result = {};
+    float primed_start = pump_get_total_primed(PumpId::PH_UP);
+    for (int i = 0; i < kIdleCount; i++) {
+        idle_for(kIdleHours[i]);
+        const reservoir_t* r = sim_reservoir();
+        float shortfall = config.line_ml - r->line_ml[0];
+        float before = r->delivered_ml[0];
+        uint32_t prime_ms = run_dose(config.dose_ml);
+        result.error_ml[i] = r->delivered_ml[0] - before - config.dose_ml;
+        result.fixed_error_ml[i] = fixed_prime_ml - shortfall;
+        result.prime_s[i] = prime_ms == UINT32_MAX ? -1.0 : prime_ms / 1000.0;
+    }
+    result.primed_ml = pump_get_total_primed(PumpId::PH_UP) - primed_start;
+    return result;
+}
+
+static bool run_in_child(const prime_config_t& config, prime_result_t* out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        prime_result_t r = run_mode(config);
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    float line_ml = argc > 1 ? (float)atof(argv[1]) : 1.5f;
+    float dose_ml = argc > 2 ? (float)atof(argv[2]) : PUMP_MIN_DOSE_VOLUME;
+
+    // Reference: a negligible line the firmware knows about, i.e. pump metering error alone
+    prime_config_t modes[] = {{0.001f, dose_ml, true}, {line_ml, dose_ml, false}, {line_ml, dose_ml, true}};
+    prime_result_t results[3];
+    for (int m = 0; m < 3; m++) {
+        if (!run_in_child(modes[m], &results[m])) {
+            fprintf(stderr, "bench_line_prime: simulation run failed\n");
+            return 1;
+        }
+    }
+    const prime_result_t& ref = results[0];
+    const prime_result_t& uncal = results[1];
+    const prime_result_t& cal = results[2];
+
+    printf("%.1f ml doses, %.2f ml line (drain-back tau %.0f h), firmware default %.2f ml\n", dose_ml, line_ml,
+           PUMP_LINE_DRAIN_TAU_H, PUMP_LINE_DEFAULT_DEAD_ML);
+    printf("delivered - requested, net of the pump metering error (no line)\n");
+    printf("%-8s %10s %12s %14s %12s %10s\n", "idle (h)", "metering", "fixed prime", "default line", "calibrated",
+           "prime (s)");
+    double worst = 0.0;
+    for (int i = 0; i < kIdleCount; i++) {
+        double net = cal.error_ml[i] - ref.error_ml[i];
+        if (fabs(net) > fabs(worst)) worst = net;
+        printf("%-8.2f %+9.3fml %+11.3fml %+13.3fml %+11.3fml %10.2f\n", kIdleHours[i], ref.error_ml[i],
+               cal.fixed_error_ml[i], uncal.error_ml[i] - ref.error_ml[i], net, cal.prime_s[i]);
+    }
+    printf("primed ml over the scored doses: default %.2f, calibrated %.2f\n", uncal.primed_ml, cal.primed_ml);
+
+    for (int i = 0; i < kIdleCount; i++) {
+        if (cal.prime_s[i] < 0.0) {
+            fprintf(stderr, "bench_line_prime: dose after %.2f h idle was refused\n", kIdleHours[i]);
+            return 1;
+        }
+    }
+    if (fabs(worst) > 2.0 * PUMP_LINE_MIN_PRIME_ML) {
+        fprintf(stderr, "bench_line_prime: calibrated line still off by %+.3f ml\n", worst);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,281 @@
+/**
+ * @file bench_macro.cpp
+ * @brief Benchmark: command batches and stored macros on the simulated plant
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * 1. Compiler: accepted batches and rejected ones with the step at fault.
+ * 2. Batch on the console: 'b' + "auto_ph off; ph_target 6.2; dose ph_down 8;
+ *    auto_ph on" is applied within one loop() pass - the control cycles
+ *    before and after it see none or all of it.
+ * 3. All or nothing: 'b' is refused while the first batch's dose runs (its
+ *    prompt would hold up loop()); a batch whose dose fails the pre-check
+ *    (too soon after that dose) changes nothing;
+ *    a dose refused while the batch runs (pump state changed by a telemetry
+ *    sink) puts the targets and auto flags back and stops the dose started.
+ * 4. Stored macros: save/list/run/del on the console, reload from NVS, and
+ *    run over Modbus (HR 8 = slot; empty slot is exception 03).
+ * 5. Cost: compiling the example batch.
+ *
+ *   bench_macro [compiles]
+ */
+
+#include "macro.h"
+#include "modbus.h"
+#include "telemetry.h"
+#include "state_machine.h"
+#include "host_hal.h"
+#include "sim_harness.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+static const char* kExample = "auto_ph off; ph_target 6.2; dose ph_down 8; auto_ph on";
+
+//=============================================================================
+// COMPILER
+//=============================================================================
+
+static void compiler(void) {
+    struct accepted_t {
+        const char* text;
+        int steps;
+    };
+    static const accepted_t accepted[] = {
+        {"auto_ph off; ph_target 6.2; dose ph_down 8; auto_ph on", 4},
+        {"AUTO_EC OFF\nEC_TARGET 1.6\n", 2},
+        {";; stop all ;", 1},
+        {"dose ph_up 0.5; dose nut_a 25; dose nut_b 5; stop ph_down", 4},
+    };
+    struct rejected_t {
+        const char* text;
+        int step;
+    };
+    static const rejected_t rejected[] = {
+        {"", 0},
+        {" ; ;\n", 0},
+        {"ph_target 6.2; ph_target 9", 2},
+        {"dose ph_down 8; dose ph_down 2", 2},
+        {"dose ph_down 30", 1},
+        {"dose ph_down 0.1", 1},
+        {"dose acid 5", 1},
+        {"auto_ph maybe", 1},
+        {"ec_target 1e0", 1},
+        {"stop", 1},
+        {"auto_ph on off extra words", 1},
+        {"reboot", 1},
+        {"stop all;stop all;stop all;stop all;stop all;stop all;stop all;stop all;stop all;stop all;stop all;"
+         "stop all;stop all", 13},
+    };
+
+    macro_batch_t batch;
+    macro_error_t error;
+    for (const accepted_t& a : accepted) {
+        bool ok = macro_compile(a.text, strlen(a.text), &batch, &error);
+        EXPECT(ok && batch.count == a.steps, "compiler: \"%s\" not accepted as %d steps\n", a.text, a.steps);
+    }
+    for (const rejected_t& r : rejected) {
+        memset(&error, 0, sizeof(error));
+        bool ok = macro_compile(r.text, strlen(r.text), &batch, &error);
+        EXPECT(!ok && error.step == r.step, "compiler: \"%s\" not rejected at step %d (got %d: %s)\n", r.text,
+               r.step, error.step, error.message);
+    }
+    EXPECT(macro_valid_name("night_1", 7) && !macro_valid_name("Night", 5) && !macro_valid_name("", 0) &&
+               !macro_valid_name("sixteen_chars_xx", 16),
+           "compiler: name rules\n");
+    printf("Compiler: %zu batches accepted, %zu rejected at the right step\n",
+           sizeof(accepted) / sizeof(accepted[0]), sizeof(rejected) / sizeof(rejected[0]));
+}
+
+//=============================================================================
+// FIRMWARE
+//=============================================================================
+
+static std::string serial_out;
+
+static void capture_serial(const char* data, size_t len, void* ctx) {
+    (void)ctx;
+    serial_out.append(data, len);
+}
+
+static size_t count_of(const std::string& text, const char* needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) count++;
+    return count;
+}
+
+// Pump events seen by telemetry, and an optional fault injected on one
+static uint32_t pump_events;
+static int fault_on_pump = -1;                       // This pump entering PRIMING...
+static int fault_pump = -1;                          // ...puts this one into MAINTENANCE
+
+static void pump_sink(const telemetry_event_t& event, const uint8_t* frame, size_t len) {
+    (void)frame;
+    (void)len;
+    if (event.type != TelemetryType::PUMP) return;
+    pump_events++;
+    if (event.pump == fault_on_pump && event.to_state == static_cast<uint8_t>(PumpState::PRIMING)) {
+        state_manager.pump_states[fault_pump] = PumpState::MAINTENANCE;
+        fault_on_pump = -1;
+    }
+}
+
+static bool dosing(PumpId pump) {
+    PumpState state = state_manager.pump_states[static_cast<int>(pump)];
+    return state == PumpState::PRIMING || state == PumpState::DOSING;
+}
+
+static uint8_t write_macro_register(uint16_t value) {
+    uint8_t request[12] = {0x00, 0x01, 0x00, 0x00, 0x00, 0x06, 0x01, MODBUS_FC_WRITE_REGISTER,
+                           (uint8_t)(MODBUS_HR_MACRO >> 8), (uint8_t)MODBUS_HR_MACRO,
+                           (uint8_t)(value >> 8), (uint8_t)value};
+    uint8_t response[MODBUS_ADU_MAX];
+    size_t len = modbus_handle_adu(request, sizeof(request), response, sizeof(response));
+    if (len < 9) return 0xFF;
+    return (response[7] & 0x80) ? response[8] : 0;
+}
+
+static void console_batch(void) {
+    serial_out.clear();
+    sim_send_cli("b\n");
+    sim_send_cli(kExample);
+    sim_send_cli("\n");
+    uint32_t before = pump_events;
+    sim_step();
+    EXPECT(count_of(serial_out, "Batch console: 4 steps applied") == 1, "console: batch not applied\n");
+    EXPECT(pump_get_ph_target() > 6.19f && pump_get_ph_target() < 6.21f, "console: pH target %.2f\n",
+           pump_get_ph_target());
+    EXPECT(pump_is_auto_ph_enabled(), "console: auto pH left off\n");
+    EXPECT(dosing(PumpId::PH_DOWN), "console: pH Down dose not started\n");
+    EXPECT(pump_events > before, "console: no pump event\n");
+    printf("Console batch: \"%s\" applied in one loop() pass\n", kExample);
+}
+
+static void all_or_nothing(void) {
+    // No prompt while the first batch's dose runs: it would hold up loop()
+    serial_out.clear();
+    sim_send_cli("b\n");
+    sim_step();
+    EXPECT(count_of(serial_out, "A pump is running") == 1, "busy: prompted while pH Down ran\n");
+    for (int i = 0; i < 3000 && pump_any_running(); i++) sim_step();
+    EXPECT(!pump_any_running(), "busy: pH Down dose did not end\n");
+
+    // Pre-check: pH Down is still inside its minimum dose interval
+    serial_out.clear();
+    sim_send_cli("b\nph_target 6.8; dose ph_down 5\n");
+    sim_step();
+    EXPECT(count_of(serial_out, "Batch console: step 2:") == 1, "pre-check: refusal not reported\n");
+    EXPECT(pump_get_ph_target() < 6.21f, "pre-check: pH target changed to %.2f\n", pump_get_ph_target());
+
+    // A dose refused mid-batch: Nut B goes into maintenance once Nut A starts
+    EXPECT(pump_can_dose(PumpId::NUTRIENT_A) && pump_can_dose(PumpId::NUTRIENT_B), "rollback: nutrient pumps not ready\n");
+    float ec_target = pump_get_ec_target();
+    bool auto_ec = pump_is_auto_ec_enabled();
+    fault_on_pump = static_cast<int>(PumpId::NUTRIENT_A);
+    fault_pump = static_cast<int>(PumpId::NUTRIENT_B);
+    serial_out.clear();
+    sim_send_cli("b\nec_target 2.4; auto_ec ");
+    sim_send_cli(auto_ec ? "off" : "on");
+    sim_send_cli("; dose nut_a 5; dose nut_b 5\n");
+    sim_step();
+    EXPECT(count_of(serial_out, "step 4: dose refused, batch rolled back") == 1, "rollback: not reported\n");
+    EXPECT(pump_get_ec_target() == ec_target, "rollback: EC target %.2f not restored\n", pump_get_ec_target());
+    EXPECT(pump_is_auto_ec_enabled() == auto_ec, "rollback: auto EC not restored\n");
+    EXPECT(!dosing(PumpId::NUTRIENT_A), "rollback: Nut A dose not stopped\n");
+    state_manager.pump_states[static_cast<int>(PumpId::NUTRIENT_B)] = PumpState::IDLE;
+    printf("All or nothing: pre-check refusal changes nothing; mid-batch refusal restores EC target/auto EC "
+           "and stops Nut A\n");
+}
+
+static void stored_macros(void) {
+    serial_out.clear();
+    sim_send_cli("b\nsave night auto_ec off; ec_target 1.6\n");
+    sim_step();
+    sim_send_cli("b\nsave bad dose acid 5\n");
+    sim_step();
+    sim_send_cli("b\nlist\n");
+    sim_step();
+    EXPECT(count_of(serial_out, "Macro night saved in slot 1 (2 steps)") == 1, "macros: save\n");
+    EXPECT(count_of(serial_out, "Batch bad: step 1: unknown pump") == 1, "macros: bad macro saved\n");
+    EXPECT(count_of(serial_out, "Macros: 1/8 slots used") == 1, "macros: list\n");
+
+    macro_init();                                    // Reload from NVS
+    EXPECT(macro_find("night") == 0, "macros: not reloaded from NVS\n");
+
+    pump_set_ec_target(1.2f);
+    pump_enable_auto_ec(true);
+    EXPECT(write_macro_register(1) == 0, "modbus: slot 1 not run\n");
+    EXPECT(pump_get_ec_target() > 1.59f && pump_get_ec_target() < 1.61f && !pump_is_auto_ec_enabled(),
+           "modbus: macro not applied\n");
+    EXPECT(write_macro_register(5) == MODBUS_EX_ILLEGAL_VALUE, "modbus: empty slot accepted\n");
+    EXPECT(write_macro_register(0) == MODBUS_EX_ILLEGAL_VALUE, "modbus: slot 0 accepted\n");
+
+    sim_send_cli("b\ndel night\n");
+    sim_step();
+    EXPECT(macro_find("night") < 0, "macros: not deleted\n");
+    macro_init();
+    EXPECT(macro_find("night") < 0, "macros: deleted macro back after reload\n");
+    printf("Stored macros: save/list/del on the console, NVS reload, Modbus HR %u runs slot 1, empty slot -> 03\n",
+           MODBUS_HR_MACRO);
+}
+
+//=============================================================================
+// COST
+//=============================================================================
+
+static void cost(long compiles) {
+    macro_batch_t batch;
+    macro_error_t error;
+    size_t len = strlen(kExample);
+    int steps = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < compiles; i++) {
+        if (macro_compile(kExample, len, &batch, &error)) steps += batch.count;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    EXPECT(steps == 4 * compiles, "cost: compile failed\n");
+    printf("Cost: %.0f ns to compile the example batch (%ld compiles)\n", ns / compiles, compiles);
+}
+
+//=============================================================================
+// MAIN
+//=============================================================================
+
+int main(int argc, char** argv) {
+    long compiles = argc > 1 ? atol(argv[1]) : 100000;
+    if (compiles < 1) compiles = 1;
+
+    compiler();
+
+    reservoir_config_t plant;
+    sim_init(plant, 100);
+    sim_boot();
+    for (int i = 0; i < 3200; i++) sim_step();               // Past PUMP_MIN_DOSE_INTERVAL after boot
+    telemetry_add_sink(pump_sink);
+    host_serial_set_output_hook(capture_serial, nullptr);
+    console_batch();
+    all_or_nothing();
+    stored_macros();
+    host_serial_set_output_hook(nullptr, nullptr);
+
+    cost(compiles);
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
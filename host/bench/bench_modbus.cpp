@@ -0,0 +1,302 @@
+/**
+ * @file bench_modbus.cpp
+ * @brief Modbus TCP register map: conformance against a client, then requests/s
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Boots the firmware against the simulated reservoir, then serves Modbus TCP
+ * on a loopback socket with the firmware's own request handler, driven the
+ * way modbus_update() drives it on the device (one snapshot refresh per pass,
+ * then the queued requests). The shim's WiFi has no sockets, so the socket
+ * loop is the bench's; everything after the bytes arrive is firmware code.
+ *
+ * A client first walks the register map: reads against the snapshot,
+ * exceptions 01/02/03, all-or-nothing multi-register writes, pump coils,
+ * a manual dose and finally the e-stop. Then N clients issue M reads of the
+ * full input block each while the firmware loop keeps running, reporting
+ * requests/s and client-side latency percentiles.
+ *
+ *   bench_modbus [requests_per_client] [clients]
+ *
+ * Fails on any conformance mismatch or lost request.
+ */
+
+#include "sim_harness.h"
+#include "modbus.h"
+#include "modbus_client.h"
+#include "pump.h"
+#include "state_machine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static std::atomic<bool> client_done{false};
+static std::atomic<bool> loop_running{false};        // Server pass also runs the firmware loop
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+//=============================================================================
+// SERVER (firmware side)
+//=============================================================================
+
+struct connection_t {
+    int fd;
+    std::vector<uint8_t> rx;
+};
+
+static int open_listener(uint16_t* port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(fd, 16) != 0 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+/**
+ * @brief Serve until the client script finishes
+ * Single-threaded like the device: firmware state is only touched here.
+ */
+static void serve(int listen_fd) {
+    std::vector<connection_t> conns;
+    std::vector<pollfd> fds;
+    uint8_t buffer[4096];
+    while (!client_done.load()) {
+        fds.clear();
+        fds.push_back({listen_fd, POLLIN, 0});
+        for (const connection_t& c : conns) fds.push_back({c.fd, POLLIN, 0});
+        poll(fds.data(), fds.size(), 5);
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) conns.push_back({fd, {}});
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            connection_t& c = conns[i - 1];
+            ssize_t n = recv(c.fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                close(c.fd);
+                c.fd = -1;
+                continue;
+            }
+            c.rx.insert(c.rx.end(), buffer, buffer + n);
+        }
+
+        // As modbus_update(): one snapshot per pass, then the requests
+        if (loop_running.load()) sim_step();
+        modbus_refresh_snapshot();
+        for (connection_t& c : conns) {
+            size_t pos = 0;
+            while (c.fd >= 0) {
+                int adu_len = modbus_adu_length(c.rx.data() + pos, c.rx.size() - pos);
+                if (adu_len == 0 || (adu_len > 0 && (size_t)adu_len > c.rx.size() - pos)) break;
+                uint8_t response[MODBUS_ADU_MAX];
+                size_t out = modbus_handle_adu(c.rx.data() + pos, adu_len > 0 ? (size_t)adu_len : c.rx.size() - pos,
+                                               response, sizeof(response));
+                if (out == 0) {
+                    close(c.fd);                         // Malformed: drop the connection
+                    c.fd = -1;
+                    break;
+                }
+                send(c.fd, response, out, MSG_NOSIGNAL);
+                pos += (size_t)adu_len;
+            }
+            if (c.fd >= 0) c.rx.erase(c.rx.begin(), c.rx.begin() + pos);
+        }
+        conns.erase(std::remove_if(conns.begin(), conns.end(), [](const connection_t& c) { return c.fd < 0; }),
+                    conns.end());
+    }
+    for (connection_t& c : conns) close(c.fd);
+}
+
+//=============================================================================
+// CLIENT SCRIPT
+//=============================================================================
+
+struct load_result_t {
+    uint32_t ok = 0;
+    std::vector<float> latency_us;
+};
+
+static void load_client(uint16_t port, uint32_t requests, load_result_t* result) {
+    modbus_client_t client;
+    if (!modbus_client_connect(&client, "127.0.0.1", port)) return;
+    result->latency_us.reserve(requests);
+    uint16_t regs[MODBUS_INPUT_COUNT];
+    for (uint32_t i = 0; i < requests; i++) {
+        auto start = std::chrono::steady_clock::now();
+        if (modbus_read_registers(&client, MODBUS_FC_READ_INPUT, 0, MODBUS_INPUT_COUNT, regs) != 0) break;
+        auto end = std::chrono::steady_clock::now();
+        result->latency_us.push_back(std::chrono::duration<float, std::micro>(end - start).count());
+        result->ok++;
+    }
+    modbus_client_close(&client);
+}
+
+static void run_client(uint16_t port, modbus_snapshot_t expected, uint32_t requests, int clients) {
+    modbus_client_t c;
+    if (!modbus_client_connect(&c, "127.0.0.1", port)) {
+        fprintf(stderr, "FAIL: connect: %s\n", c.error.c_str());
+        failures++;
+        client_done = true;
+        return;
+    }
+    uint16_t regs[MODBUS_INPUT_COUNT];
+    uint8_t bits[1] = {0};
+
+    // Reads come from the snapshot
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_INPUT, 0, MODBUS_INPUT_COUNT, regs) == 0, "read inputs\n");
+    EXPECT(memcmp(regs, expected.input, sizeof(expected.input)) == 0, "input registers differ from snapshot\n");
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_HOLDING, 0, MODBUS_HOLDING_COUNT, regs) == 0, "read holding\n");
+    EXPECT(memcmp(regs, expected.holding, sizeof(expected.holding)) == 0, "holding registers differ\n");
+    EXPECT(modbus_read_coils(&c, 0, MODBUS_COIL_COUNT, bits) == 0 && bits[0] == expected.coils, "coils\n");
+    printf("  snapshot: pH %.3f  EC %.3f  %.1f L  %.2f C  (reading %u s old, %u published)\n",
+           (int16_t)expected.input[MODBUS_IR_PH] / 1000.0, (int16_t)expected.input[MODBUS_IR_EC] / 1000.0,
+           (int16_t)expected.input[MODBUS_IR_VOLUME] / 10.0, (int16_t)expected.input[MODBUS_IR_TEMPERATURE] / 100.0,
+           expected.input[MODBUS_IR_READING_AGE], expected.input[MODBUS_IR_READING_COUNT]);
+
+    // Exceptions
+    uint8_t read_discrete[5] = {0x02, 0, 0, 0, 1}, response[MODBUS_ADU_MAX];
+    size_t len = 0;
+    EXPECT(modbus_transact(&c, read_discrete, sizeof(read_discrete), response, &len) == MODBUS_EX_ILLEGAL_FUNCTION,
+           "FC 02 must be unsupported\n");
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_INPUT, 20, 5, regs) == MODBUS_EX_ILLEGAL_ADDRESS,
+           "read past the input map\n");
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_INPUT, 0, 0, regs) == MODBUS_EX_ILLEGAL_VALUE, "zero count\n");
+    EXPECT(modbus_write_register(&c, MODBUS_HR_PH_TARGET, 9000) == MODBUS_EX_ILLEGAL_VALUE, "pH target 9.0\n");
+
+    // Setpoints, all-or-nothing multi writes
+    EXPECT(modbus_write_register(&c, MODBUS_HR_PH_TARGET, 6200) == 0, "pH target 6.2\n");
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_HOLDING, MODBUS_HR_PH_TARGET, 1, regs) == 0 && regs[0] == 6200,
+           "pH target read back\n");
+    uint16_t bad_pair[2] = {1, 5};
+    EXPECT(modbus_write_registers(&c, MODBUS_HR_AUTO_PH, 2, bad_pair) == MODBUS_EX_ILLEGAL_VALUE, "auto EC = 5\n");
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_HOLDING, MODBUS_HR_AUTO_PH, 1, regs) == 0 &&
+               regs[0] == expected.holding[MODBUS_HR_AUTO_PH],
+           "a rejected multi-write must change nothing\n");
+    uint16_t ec_target[1] = {1800};
+    EXPECT(modbus_write_registers(&c, MODBUS_HR_EC_TARGET, 1, ec_target) == 0, "EC target 1.8\n");
+
+    // Pump coils and a manual dose
+    EXPECT(modbus_write_coil(&c, MODBUS_COIL_PUMP + 2, true) == 0, "start nutrient A\n");
+    EXPECT(modbus_read_coils(&c, 0, MODBUS_COIL_COUNT, bits) == 0 && (bits[0] & 0x04), "nutrient A running\n");
+    EXPECT(modbus_write_coil(&c, MODBUS_COIL_PUMP + 2, false) == 0, "stop nutrient A\n");
+    EXPECT(modbus_read_coils(&c, 0, MODBUS_COIL_COUNT, bits) == 0 && !(bits[0] & 0x04), "nutrient A stopped\n");
+    EXPECT(modbus_write_register(&c, MODBUS_HR_DOSE + 1, 300) == MODBUS_EX_ILLEGAL_VALUE, "30 ml dose\n");
+    EXPECT(modbus_write_register(&c, MODBUS_HR_DOSE + 1, 50) == 0, "5 ml pH Down dose\n");
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_INPUT, MODBUS_IR_PUMP_STATE + 1, 1, regs) == 0 &&
+               regs[0] != static_cast<uint16_t>(PumpState::IDLE),
+           "pH Down dosing\n");
+
+    // Throughput with the firmware loop running between passes
+    loop_running = true;
+    std::vector<load_result_t> results(clients);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < clients; i++) threads.emplace_back(load_client, port, requests, &results[i]);
+    for (std::thread& t : threads) t.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    loop_running = false;
+
+    std::vector<float> latency;
+    uint64_t ok = 0;
+    for (const load_result_t& r : results) {
+        ok += r.ok;
+        latency.insert(latency.end(), r.latency_us.begin(), r.latency_us.end());
+    }
+    std::sort(latency.begin(), latency.end());
+    auto pct = [&](double p) { return latency.empty() ? 0.0f : latency[(size_t)(p * (latency.size() - 1))]; };
+    printf("  load: %d clients x %u reads of %u input registers: %.0f requests/s, latency p50 %.1f us, "
+           "p99 %.1f us, max %.1f us\n",
+           clients, requests, MODBUS_INPUT_COUNT, ok / seconds, pct(0.50), pct(0.99), pct(1.0));
+    EXPECT(ok == (uint64_t)clients * requests, "%llu of %llu load requests answered\n", (unsigned long long)ok,
+           (unsigned long long)clients * requests);
+
+    // E-stop latches; releasing it is console-only
+    EXPECT(modbus_write_coil(&c, MODBUS_COIL_ESTOP, true) == 0, "e-stop\n");
+    EXPECT(modbus_read_coils(&c, 0, MODBUS_COIL_COUNT, bits) == 0 && (bits[0] & 0x10) && !(bits[0] & 0x0F),
+           "e-stop latched, pumps stopped\n");
+    EXPECT(modbus_read_registers(&c, MODBUS_FC_READ_INPUT, MODBUS_IR_SYSTEM_STATE, 1, regs) == 0 &&
+               regs[0] == static_cast<uint16_t>(SystemState::ERROR),
+           "system state ERROR\n");
+    EXPECT(modbus_write_coil(&c, MODBUS_COIL_ESTOP, false) == MODBUS_EX_ILLEGAL_VALUE, "e-stop release refused\n");
+
+    // A non-Modbus header drops the connection
+    uint8_t garbage[8] = {0, 1, 0, 1, 0, 2, 1, 4};
+    send(c.fd, garbage, sizeof(garbage), MSG_NOSIGNAL);
+    uint8_t byte;
+    EXPECT(recv(c.fd, &byte, 1, 0) == 0, "malformed header must close the connection\n");
+    modbus_client_close(&c);
+    client_done = true;
+}
+
+//=============================================================================
+// MAIN
+//=============================================================================
+
+int main(int argc, char** argv) {
+    uint32_t requests = argc > 1 ? (uint32_t)atoi(argv[1]) : 20000;
+    int clients = argc > 2 ? atoi(argv[2]) : 4;
+    if (requests == 0 || clients < 1) {
+        fprintf(stderr, "usage: %s [requests_per_client] [clients]\n", argv[0]);
+        return 2;
+    }
+
+    reservoir_config_t plant;
+    sim_init(plant, 100);
+    sim_boot();
+    for (int i = 0; i < 3200; i++) sim_step();               // Past PUMP_MIN_DOSE_INTERVAL after boot
+    modbus_refresh_snapshot();
+    modbus_snapshot_t expected = modbus_get_snapshot();
+
+    uint16_t port = 0;
+    int listen_fd = open_listener(&port);
+    if (listen_fd < 0) {
+        perror("bench_modbus: listen");
+        return 1;
+    }
+    printf("Modbus TCP register map on 127.0.0.1:%u\n", port);
+    std::thread client(run_client, port, expected, requests, clients);
+    serve(listen_fd);
+    client.join();
+    close(listen_fd);
+
+    modbus_stats_t stats = modbus_get_stats();
+    printf("  server: %lu requests, %lu exceptions, %lu writes, %lu malformed\n",
+           (unsigned long)stats.requests, (unsigned long)stats.exceptions, (unsigned long)stats.writes,
+           (unsigned long)stats.malformed);
+    EXPECT(pump_get_ph_target() > 6.19f && pump_get_ph_target() < 6.21f, "firmware pH target not applied\n");
+    EXPECT(pump_get_ec_target() > 1.79f && pump_get_ec_target() < 1.81f, "firmware EC target not applied\n");
+    EXPECT(stats.exceptions == 7, "%lu exceptions, expected 7\n", (unsigned long)stats.exceptions);
+    EXPECT(stats.malformed == 1, "%lu malformed, expected 1\n", (unsigned long)stats.malformed);
+
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,329 @@
+/**
+ * @file bench_multicast.cpp
+ * @brief Benchmark: multicast telemetry loss recovery and listener fan-out
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The firmware telemetry publisher runs in-process. The host WiFi shim has
+ * no network, so a bench sink stands in for multicast.cpp's WiFiUDP send
+ * and puts each published frame in one datagram to a group on loopback.
+ * Backfill requests are answered over a loopback TCP socket by the
+ * firmware's own request parser and history (telemetry_parse_backfill /
+ * telemetry_backfill), as the stream port does.
+ *
+ * 1. Loss: three listeners (logger, dashboard, SCADA bridge) on a stream
+ *    where the sender drops a share of datagrams. Each listener backfills
+ *    its holes over TCP every 32 frames. Every listener must end with every
+ *    frame exactly once, with the published values, and nothing abandoned.
+ * 2. Fan-out: frames published as fast as possible to 1, 4 and 16
+ *    listeners, each with its own reader thread. Reports the sender cost
+ *    per frame and the share the slowest listener received without
+ *    backfill. The device makes one send whatever the count; on loopback
+ *    the kernel's per-listener copies are charged to the sender, which a
+ *    WiFi link (one frame on air) does not do.
+ *
+ *   bench_multicast [frames] [loss_percent]
+ */
+
+#include "telemetry.h"
+#include "multicast.h"
+#include "multicast_receiver.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static const char kGroup[] = "239.255.72.1";
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+//=============================================================================
+// DEVICE SIDE
+//=============================================================================
+
+static std::mutex firmware_mutex;                  // Publisher and backfill server share firmware state
+static int sender_fd = -1;
+static sockaddr_in group_addr;
+static uint32_t loss_per_mille = 0;
+static uint32_t rng_state = 0x2545F491;
+static uint32_t datagrams_dropped = 0;
+static uint32_t datagrams_sent = 0;
+
+static uint32_t next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+// Stand-in for the WiFiUDP send in multicast.cpp, with injected loss
+static void send_datagram(const telemetry_event_t& event, const uint8_t* frame, size_t len) {
+    if (event.seq > 0 && next_random() % 1000 < loss_per_mille) {
+        datagrams_dropped++;
+        return;
+    }
+    while (sendto(sender_fd, frame, len, 0, reinterpret_cast<sockaddr*>(&group_addr), sizeof(group_addr)) < 0 &&
+           errno == ENOBUFS) {
+        std::this_thread::yield();
+    }
+    datagrams_sent++;
+}
+
+static sensor_readings_t reading_for(uint32_t i) {
+    sensor_readings_t r = sensor_readings_t();
+    r.ph = 5.5f + (i % 1000) / 1000.0f;
+    r.ec = 1.0f + (i % 500) / 1000.0f;
+    r.volume = 40.0f - (i % 100) / 10.0f;
+    r.temperature = 21.0f + (i % 300) / 100.0f;
+    r.timestamp = i * 100;
+    r.valid = true;
+    return r;
+}
+
+static void publish(uint32_t i) {
+    std::lock_guard<std::mutex> lock(firmware_mutex);
+    telemetry_publish_reading(reading_for(i));
+}
+
+/**
+ * @brief Loopback stand-in for the stream port's backfill path
+ */
+static void backfill_server(int listen_fd, std::atomic<bool>* stop, std::atomic<uint32_t>* requests) {
+    while (!stop->load()) {
+        pollfd pfd = {listen_fd, POLLIN, 0};
+        if (poll(&pfd, 1, 20) <= 0) continue;
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+        std::string line;
+        char c;
+        pollfd cfd = {fd, POLLIN, 0};
+        while (poll(&cfd, 1, 100) > 0 && recv(fd, &c, 1, 0) == 1) {
+            if (c != '\n') {
+                line += c;
+                continue;
+            }
+            uint32_t from, count;
+            if (telemetry_parse_backfill(line.data(), line.size(), &from, &count)) {
+                requests->fetch_add(1);
+                uint8_t chunk[8 * TELEMETRY_FRAME_MAX];
+                uint32_t end = from + count;
+                while (from != end) {
+                    uint32_t next;
+                    size_t n;
+                    {
+                        std::lock_guard<std::mutex> lock(firmware_mutex);
+                        n = telemetry_backfill(from, end - from, chunk, sizeof(chunk), &next);
+                    }
+                    if (n == 0) break;
+                    send(fd, chunk, n, MSG_NOSIGNAL);
+                    from = next;
+                }
+            }
+            line.clear();
+        }
+        close(fd);
+    }
+}
+
+//=============================================================================
+// PHASES
+//=============================================================================
+
+static bool open_listeners(std::vector<multicast_receiver_t>& listeners, uint16_t port) {
+    for (multicast_receiver_t& r : listeners) {
+        if (!multicast_receiver_open(&r, kGroup, port, "127.0.0.1")) {
+            fprintf(stderr, "FAIL: %s\n", r.error.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+static void loss_recovery(uint16_t group_port, uint16_t tcp_port, uint32_t frames) {
+    const char* names[] = {"logger", "dashboard", "SCADA bridge"};
+    std::vector<multicast_receiver_t> listeners(3);
+    if (!open_listeners(listeners, group_port)) {
+        failures++;
+        return;
+    }
+    std::vector<std::vector<telemetry_event_t>> received(3);
+    uint32_t first_seq = telemetry_get_seq();
+    uint32_t dropped_before = datagrams_dropped;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++) {
+        publish(i);
+        if (i % 32 == 31 || i == frames - 1) {
+            for (size_t l = 0; l < listeners.size(); l++) {
+                multicast_receiver_poll(&listeners[l], i == frames - 1 ? 50 : 0, &received[l]);
+                if (multicast_backfill(&listeners[l], "127.0.0.1", tcp_port, 500, &received[l]) < 0) {
+                    fprintf(stderr, "FAIL: %s backfill: %s\n", names[l], listeners[l].error.c_str());
+                    failures++;
+                }
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint32_t dropped = datagrams_dropped - dropped_before;
+    printf("multicast bench: loss %.1f%%: %u frames, %u datagrams dropped at the sender, %.2f s\n",
+           loss_per_mille / 10.0, frames, dropped, seconds);
+    for (size_t l = 0; l < listeners.size(); l++) {
+        const multicast_receiver_t& r = listeners[l];
+        std::vector<uint8_t> seen(frames, 0);
+        bool values_ok = true;
+        for (const telemetry_event_t& e : received[l]) {
+            uint32_t i = e.seq - first_seq;
+            if (i >= frames || e.type != TelemetryType::READING) {
+                values_ok = false;
+                continue;
+            }
+            seen[i]++;
+            sensor_readings_t expected = reading_for(i);
+            values_ok = values_ok &&
+                        e.reading.ph == telemetry_scale(expected.ph, TELEMETRY_PH_SCALE) / TELEMETRY_PH_SCALE &&
+                        e.reading.ec == telemetry_scale(expected.ec, TELEMETRY_EC_SCALE) / TELEMETRY_EC_SCALE &&
+                        e.timestamp == expected.timestamp;
+        }
+        uint32_t once = 0;
+        for (uint8_t count : seen) once += count == 1;
+        printf("  %-12s %6llu datagrams, %5llu backfilled, %llu duplicates, %llu missing, %llu abandoned\n",
+               names[l], (unsigned long long)r.datagrams, (unsigned long long)r.filled,
+               (unsigned long long)r.duplicates, (unsigned long long)multicast_receiver_missing(&r),
+               (unsigned long long)r.abandoned);
+        EXPECT(once == frames && received[l].size() == frames, "%s: %u of %u frames exactly once\n", names[l], once,
+               frames);
+        EXPECT(values_ok, "%s: frame contents differ from what was published\n", names[l]);
+        EXPECT(r.filled == dropped && r.abandoned == 0 && r.invalid == 0, "%s: %llu backfilled for %u dropped\n",
+               names[l], (unsigned long long)r.filled, dropped);
+        multicast_receiver_close(&listeners[l]);
+    }
+}
+
+static void fan_out(uint16_t group_port, int count, uint32_t frames) {
+    std::vector<multicast_receiver_t> listeners(count);
+    if (!open_listeners(listeners, group_port)) {
+        failures++;
+        return;
+    }
+
+    // One reader per listener, like separate consumer processes
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (multicast_receiver_t& r : listeners) {
+        readers.emplace_back([&done, &r]() {
+            std::vector<telemetry_event_t> events;
+            while (!done.load()) {
+                events.clear();
+                multicast_receiver_poll(&r, 5, &events);
+            }
+            events.clear();
+            multicast_receiver_poll(&r, 20, &events);
+        });
+    }
+
+    uint32_t sent_before = datagrams_sent;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++) publish(i);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint32_t sent = datagrams_sent - sent_before;
+    done.store(true);
+    for (std::thread& reader : readers) reader.join();
+
+    uint64_t worst = frames;
+    for (const multicast_receiver_t& r : listeners) {
+        if (r.delivered < worst) worst = r.delivered;
+        EXPECT(r.invalid == 0 && r.duplicates == 0, "corrupt or duplicated datagrams\n");
+        EXPECT(r.delivered > 0, "a listener received nothing\n");
+    }
+    printf("multicast bench: %2d listeners: %u datagrams sent, %.0f frames/s, %.0f ns/frame at the sender; "
+           "worst listener got %.1f%%\n",
+           count, sent, frames / seconds, seconds * 1e9 / frames, 100.0 * worst / frames);
+    for (multicast_receiver_t& r : listeners) multicast_receiver_close(&r);
+}
+
+//=============================================================================
+// MAIN
+//=============================================================================
+
+static uint16_t free_port(int type) {
+    int fd = socket(AF_INET, type, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+int main(int argc, char** argv) {
+    uint32_t frames = argc > 1 ? (uint32_t)atol(argv[1]) : 20000;
+    double loss = argc > 2 ? atof(argv[2]) : 5.0;
+    if (frames < 64) frames = 64;
+    loss_per_mille = (uint32_t)(loss * 10.0);
+
+    // Sender: loopback interface, looped back to local listeners
+    uint16_t group_port = free_port(SOCK_DGRAM);
+    sender_fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    in_addr loopback = {htonl(INADDR_LOOPBACK)};
+    unsigned char on = 1;
+    setsockopt(sender_fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback));
+    setsockopt(sender_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &on, sizeof(on));
+    group_addr = sockaddr_in();
+    group_addr.sin_family = AF_INET;
+    group_addr.sin_port = htons(group_port);
+    inet_pton(AF_INET, kGroup, &group_addr.sin_addr);
+    telemetry_add_sink(send_datagram);
+
+    // Backfill server
+    int listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd, 8) != 0 ||
+        getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &addr_len) != 0) {
+        perror("backfill server");
+        return 1;
+    }
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> requests{0};
+    std::thread server(backfill_server, listen_fd, &stop, &requests);
+
+    printf("multicast bench: group %s:%u, default device group %u.%u.%u.%u:%u, history %d frames\n", kGroup,
+           group_port, MULTICAST_DEFAULT_GROUP[0], MULTICAST_DEFAULT_GROUP[1], MULTICAST_DEFAULT_GROUP[2],
+           MULTICAST_DEFAULT_GROUP[3], MULTICAST_DEFAULT_PORT, TELEMETRY_HISTORY_FRAMES);
+    loss_recovery(group_port, ntohs(addr.sin_port), frames);
+    printf("  %u backfill requests answered\n", requests.load());
+
+    loss_per_mille = 0;
+    for (int count : {1, 4, 16}) fan_out(group_port, count, frames);
+
+    stop.store(true);
+    server.join();
+    close(listen_fd);
+    close(sender_fd);
+    return failures == 0 ? 0 : 1;
+}
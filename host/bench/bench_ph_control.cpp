@@ -0,0 +1,157 @@
+/**
+ * @file bench_ph_control.cpp
+ * @brief Benchmark: time-in-band of reactive PID vs predictive pH dosing, with and without micro-dosing
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Runs the firmware closed-loop against the simulated reservoir with a steady
+ * upward pH drift (nutrient uptake) and probe noise, once per dosing mode.
+ * Scores the well-mixed pH of the plant, not the filtered reading: time
+ * outside target +/- PH_BAND, dose count, ml dosed and reversal ml (doses by
+ * the opposite pump to the previous dose, i.e. undoing an overshoot). Fails
+ * if predictive mode spends more time out of band or doses more often than
+ * the PID, or if micro-dosing adds time out of band or ml to either one.
+ * Firmware globals are per process, so each mode runs in a forked child.
+ *
+ *   bench_ph_control [hours] [drift_per_h] [volume_l]
+ */
+
+#include "sim_harness.h"
+#include "pump.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct run_result_t {
+    double out_of_band_min;      // Plant pH outside target +/- PH_BAND
+    double mean_abs_error;       // Time-averaged |pH - target|
+    double max_abs_error;
+    int doses;                   // pH Up + pH Down doses started
+    double ml;                   // pH Up + pH Down ml dosed
+    double reversal_ml;          // ml dosed by the other pump than the previous dose
+};
+
+struct dosing_mode_t {
+    const char* name;
+    bool predictive;
+    bool micro;
+};
+
+static run_result_t run_mode(const dosing_mode_t& mode, double hours, float drift_per_h, float volume_l) {
+    reservoir_config_t plant;
+    plant.volume_l = volume_l;
+    plant.ph = 6.0f;
+    plant.ph_drift_per_h = drift_per_h;
+    plant.noise_ph = 0.02f;
+    plant.noise_ec = 0.005f;
+    plant.noise_distance_cm = 0.1f;
+    plant.pump_dead_ms = 100.0f;          // Matches the uncalibrated pulse dead time
+    plant.seed = 7;
+
+    const uint32_t tick_ms = 100;
+    const uint32_t settle_ms = 1800000;   // Boot, EMA warm-up and first corrections are not scored
+    sim_init(plant, tick_ms);
+    sim_boot();
+    sim_send_cli(mode.predictive ? "aP" : "a");
+    if (mode.micro) sim_send_cli("u");
+
+    run_result_t result = {};
+    float last_up = 0.0f, last_down = 0.0f;
+    int last_pump = -1;
+    uint32_t end_ms = settle_ms + (uint32_t)(hours * 3600000.0);
+    double scored_ms = 0.0;
+    while (sim_now_ms() < end_ms) {
+        sim_step();
+
+        float up = pump_get_total_dosed(PumpId::PH_UP);
+        float down = pump_get_total_dosed(PumpId::PH_DOWN);
+        if (up != last_up || down != last_down) {
+            int pump = up != last_up ? 0 : 1;
+            if (sim_now_ms() >= settle_ms) {
+                result.doses++;
+                result.ml += (up - last_up) + (down - last_down);
+                if (last_pump >= 0 && pump != last_pump) result.reversal_ml += (up - last_up) + (down - last_down);
+            }
+            last_up = up;
+            last_down = down;
+            last_pump = pump;
+        }
+        if (sim_now_ms() < settle_ms) continue;
+
+        double error = fabs(sim_reservoir()->ph - pump_get_ph_target());
+        if (error > PH_BAND) result.out_of_band_min += tick_ms / 60000.0;
+        result.mean_abs_error += error * tick_ms;
+        if (error > result.max_abs_error) result.max_abs_error = error;
+        scored_ms += tick_ms;
+    }
+    result.mean_abs_error /= scored_ms > 0.0 ? scored_ms : 1.0;
+    return result;
+}
+
+static bool run_in_child(const dosing_mode_t& mode, double hours, float drift_per_h, float volume_l, run_result_t* out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        run_result_t r = run_mode(mode, hours, drift_per_h, volume_l);
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 24.0;
+    float drift = argc > 2 ? (float)atof(argv[2]) : 0.2f;
+    float volume = argc > 3 ? (float)atof(argv[3]) : 40.0f;
+
+    const dosing_mode_t modes[] = {
+        {"reactive", false, false},
+        {"reactive+u", false, true},
+        {"predictive", true, false},
+        {"predict+u", true, true},
+    };
+    const int mode_count = sizeof(modes) / sizeof(modes[0]);
+    run_result_t results[mode_count];
+    for (int i = 0; i < mode_count; i++) {
+        if (!run_in_child(modes[i], hours, drift, volume, &results[i])) {
+            fprintf(stderr, "bench_ph_control: simulation run failed (%s)\n", modes[i].name);
+            return 1;
+        }
+    }
+
+    printf("pH control over %.1f h, %.0f L, drift %+.2f pH/h, band +/-%.2f\n", hours, volume, drift, PH_BAND);
+    printf("%-11s %10s %9s %9s %6s %8s %8s\n", "mode", "out (min)", "in band", "mean|e|", "doses", "ml", "rev ml");
+    for (int i = 0; i < mode_count; i++) {
+        const run_result_t& r = results[i];
+        printf("%-11s %10.1f %8.1f%% %9.3f %6d %8.1f %8.1f\n", modes[i].name, r.out_of_band_min,
+               100.0 * (1.0 - r.out_of_band_min / (hours * 60.0)), r.mean_abs_error, r.doses, r.ml, r.reversal_ml);
+    }
+
+    const run_result_t& reactive = results[0];
+    const run_result_t& predictive = results[2];
+    bool ok = true;
+    if (predictive.out_of_band_min > reactive.out_of_band_min || predictive.doses > reactive.doses) {
+        fprintf(stderr, "bench_ph_control: predictive mode is not better than the PID\n");
+        ok = false;
+    }
+    for (int i = 0; i < mode_count; i += 2) {
+        const run_result_t& base = results[i];
+        const run_result_t& micro = results[i + 1];
+        if (micro.out_of_band_min > base.out_of_band_min || micro.ml > base.ml) {
+            fprintf(stderr, "bench_ph_control: micro-dosing is not better (%s)\n", modes[i].name);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+/**
+ * @file bench_ph_ec.cpp
+ * @brief Benchmark: independent pH and EC loops vs coupled pH/EC dosing
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Starts the simulated reservoir with pH high and EC low on a plant with
+ * strong cross-effects (nutrients acidify, pH Down adds salts), then lets the
+ * firmware bring both to target: once with the pH PID and the EC loop running
+ * side by side, once in coupled mode (K). Scores the well-mixed plant: time
+ * until pH and EC both stay inside their bands, dose starts per pump until
+ * then, and ml per group over the run. Fails if coupled mode converges later,
+ * needs more doses or uses more chemical than the independent loops.
+ * Firmware globals are per process, so each mode runs in a forked child.
+ *
+ *   bench_ph_ec [start_ph] [start_ec] [target_ec] [volume_l]
+ */
+
+#include "sim_harness.h"
+#include "pump.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct coupled_result_t {
+    double converge_min;         // Last time mixed pH or EC was out of band
+    int doses;                   // Pump dose starts up to convergence (A and B count separately)
+    int dose_rounds;             // Readings on which any dose started, up to convergence
+    double ph_up_ml;
+    double ph_down_ml;
+    double nutrient_ml;          // Nutrient A + B
+};
+
+struct coupled_config_t {
+    float start_ph;
+    float start_ec;
+    float target_ec;
+    float volume_l;
+    bool coupled;
+};
+
+static coupled_result_t run_mode(const coupled_config_t& config) {
+    reservoir_config_t plant;
+    plant.volume_l = config.volume_l;
+    plant.ph = config.start_ph;
+    plant.ec = config.start_ec;
+    plant.nutrient_ph = -0.4f;            // Strongly acidifying nutrient line
+    plant.ph_down_ec = 0.2f;              // Acid adds noticeable salts
+    plant.noise_ph = 0.02f;
+    plant.noise_ec = 0.005f;
+    plant.noise_distance_cm = 0.1f;
+    plant.seed = 5;
+
+    const uint32_t tick_ms = 100;
+    const uint32_t run_ms = 4u * 3600000u;
+    sim_init(plant, tick_ms);
+    sim_boot();
+    pump_set_ec_target(config.target_ec);
+    sim_send_cli(config.coupled ? "aEK" : "aE");
+
+    coupled_result_t result = {};
+    float last[static_cast<int>(PumpId::COUNT)] = {};
+    float target_ph = pump_get_ph_target();
+    int doses = 0, rounds = 0;
+    while (sim_now_ms() < run_ms) {
+        sim_step();
+
+        bool started = false;
+        for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+            float total = pump_get_total_dosed(static_cast<PumpId>(i));
+            if (total != last[i]) {
+                doses++;
+                started = true;
+                last[i] = total;
+            }
+        }
+        if (started) rounds++;
+
+        const reservoir_t* r = sim_reservoir();
+        if (fabs(r->ph - target_ph) > PH_BAND || fabs(r->ec - config.target_ec) > EC_BAND) {
+            result.converge_min = sim_now_ms() / 60000.0;
+            result.doses = doses;
+            result.dose_rounds = rounds;
+        }
+    }
+    result.ph_up_ml = last[static_cast<int>(PumpId::PH_UP)];
+    result.ph_down_ml = last[static_cast<int>(PumpId::PH_DOWN)];
+    result.nutrient_ml = last[static_cast<int>(PumpId::NUTRIENT_A)] + last[static_cast<int>(PumpId::NUTRIENT_B)];
+    return result;
+}
+
+static bool run_in_child(const coupled_config_t& config, coupled_result_t* out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        coupled_result_t r = run_mode(config);
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    float start_ph = argc > 1 ? (float)atof(argv[1]) : 6.6f;
+    float start_ec = argc > 2 ? (float)atof(argv[2]) : 1.0f;
+    float target_ec = argc > 3 ? (float)atof(argv[3]) : 1.6f;
+    float volume = argc > 4 ? (float)atof(argv[4]) : 40.0f;
+
+    coupled_config_t independent = {start_ph, start_ec, target_ec, volume, false};
+    coupled_config_t coupled = {start_ph, start_ec, target_ec, volume, true};
+    coupled_result_t results[2];
+    if (!run_in_child(independent, &results[0]) || !run_in_child(coupled, &results[1])) {
+        fprintf(stderr, "bench_ph_ec: simulation run failed\n");
+        return 1;
+    }
+
+    printf("pH %.2f -> %.2f, EC %.2f -> %.2f in %.0f L, bands +/-%.2f pH, +/-%.2f EC\n", start_ph,
+           DEFAULT_PH_TARGET, start_ec, target_ec, volume, PH_BAND, EC_BAND);
+    printf("%-12s %14s %6s %7s %10s %12s %12s\n", "mode", "converge (min)", "doses", "rounds", "pH_Up ml",
+           "pH_Down ml", "Nut A+B ml");
+    const char* names[] = {"independent", "coupled"};
+    for (int i = 0; i < 2; i++) {
+        const coupled_result_t& r = results[i];
+        printf("%-12s %14.1f %6d %7d %10.1f %12.1f %12.1f\n", names[i], r.converge_min, r.doses, r.dose_rounds,
+               r.ph_up_ml, r.ph_down_ml, r.nutrient_ml);
+    }
+
+    const coupled_result_t& base = results[0];
+    const coupled_result_t& joint = results[1];
+    double base_ml = base.ph_up_ml + base.ph_down_ml + base.nutrient_ml;
+    double joint_ml = joint.ph_up_ml + joint.ph_down_ml + joint.nutrient_ml;
+    if (joint.converge_min > base.converge_min || joint.doses > base.doses || joint_ml > base_ml) {
+        fprintf(stderr, "bench_ph_ec: coupled dosing is not better than independent loops\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,261 @@
+/**
+ * @file bench_ph_oversample.cpp
+ * @brief Benchmark: effective pH ADC resolution with oversampling, decimation and dither
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * 1. Resolution: a modelled 12-bit ADC (input held at a random fractional
+ *    code per reading, Gaussian noise, round to the nearest code) read at
+ *    0-4 extra bits with no noise, 0.3 / 1 / 2 LSB of natural noise, and a
+ *    noiseless input with an injected 2 LSB ramp. Reports the effective bits
+ *    from the error against the true input and the oversampler's own
+ *    estimate at a fixed input; fails if a noiseless input gains bits or if
+ *    1 LSB of noise or the ramp do not reach about 14 / 15 bits at 4 extra bits.
+ * 2. Firmware path: sensor_read_ph_raw() at pH 6.5 with 1.5 LSB ADC noise,
+ *    the 5-sample average against 14/15/16-bit oversampling: pH noise per
+ *    reading, the filtered noise at the default EMA alpha 0.2 and the alpha
+ *    (and lag at the 5 s interval) that oversampling needs for the same
+ *    filtered noise. Fails unless 16 bits is quieter than the average and
+ *    matches it with a higher alpha.
+ * 3. Cost: host time per reading and conversions per reading.
+ *
+ *   bench_ph_oversample [readings]
+ */
+
+#include "adc_oversample.h"
+#include "adc_cal.h"
+#include "sensors.h"
+#include "communication.h"
+#include "host_hal.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// NVS preferences object (main.cpp is not linked; sensors pull in calibration)
+Preferences preferences;
+
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+static constexpr int kMaxCode = (1 << Board::adc_bits) - 1;
+
+//=============================================================================
+// MODELLED ADC
+//=============================================================================
+
+struct adc_model_t {
+    double input;            // True input, fractional ADC code
+    double noise_lsb;        // Gaussian noise (1 sigma)
+    double ramp_lsb;         // Injected ramp, peak to peak (0 = none)
+    double ramp_level;       // Current ramp offset
+    uint64_t rng;
+};
+
+static uint64_t next_u64(adc_model_t* m) {
+    uint64_t z = (m->rng += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static double uniform(adc_model_t* m) {
+    return (next_u64(m) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double gaussian(adc_model_t* m) {
+    double u1 = ((next_u64(m) >> 11) + 1.0) * (1.0 / 9007199254740993.0);
+    double u2 = uniform(m);
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+static int model_sample(void* ctx) {
+    adc_model_t* m = static_cast<adc_model_t*>(ctx);
+    double v = m->input + m->ramp_level + m->noise_lsb * gaussian(m);
+    long code = lround(v);
+    return (int)(code < 0 ? 0 : (code > kMaxCode ? kMaxCode : code));
+}
+
+// Ramp centred on zero: -pp/2 .. +pp/2 across the burst
+static void model_dither(void* ctx, int step, int steps) {
+    adc_model_t* m = static_cast<adc_model_t*>(ctx);
+    m->ramp_level = m->ramp_lsb * ((double)step / (steps - 1) - 0.5);
+}
+
+static float enob(double rms_lsb) {
+    return (float)(Board::adc_bits - log2(rms_lsb * sqrt(12.0)));
+}
+
+//=============================================================================
+// RESOLUTION
+//=============================================================================
+
+static void resolution(int readings) {
+    struct input_t {
+        const char* name;
+        double noise_lsb, ramp_lsb;
+    };
+    static const input_t kInputs[] = {{"noiseless", 0.0, 0.0},
+                                      {"0.3 LSB noise", 0.3, 0.0},
+                                      {"1 LSB noise", 1.0, 0.0},
+                                      {"2 LSB noise", 2.0, 0.0},
+                                      {"noiseless + 2 LSB ramp", 0.0, 2.0}};
+    printf("Effective bits (error vs true input | oversampler estimate at a fixed input):\n");
+    printf("  %-24s", "input");
+    for (int bits = 0; bits <= ADC_OVERSAMPLE_MAX_BITS; bits++) printf("   +%d bits      ", bits);
+    printf("\n");
+
+    for (const input_t& in : kInputs) {
+        printf("  %-24s", in.name);
+        for (int bits = 0; bits <= ADC_OVERSAMPLE_MAX_BITS; bits++) {
+            adc_model_t model = {0.0, in.noise_lsb, in.ramp_lsb, 0.0, 42};
+            adc_oversample_t os;
+            adc_oversample_init(&os, (uint8_t)bits);
+            adc_dither_t dither = in.ramp_lsb > 0.0 ? model_dither : nullptr;
+
+            // Error against the true input, which moves between readings
+            double sum_sq = 0.0;
+            for (int i = 0; i < readings; i++) {
+                model.input = 1000.0 + 2000.0 * uniform(&model);
+                adc_oversample_read(&os, model_sample, dither, &model);
+                double err = adc_oversample_code(&os) - model.input;
+                sum_sq += err * err;
+            }
+            float measured = enob(sqrt(sum_sq / readings));
+
+            // The oversampler's own measurement at a fixed input
+            adc_oversample_init(&os, (uint8_t)bits);
+            model.input = 2048.3;
+            for (int i = 0; i < readings; i++) adc_oversample_read(&os, model_sample, dither, &model);
+            float estimated = adc_oversample_effective_bits(&os);
+            printf("  %5.1f | %5.1f  ", measured, estimated);
+
+            if (in.noise_lsb == 0.0 && in.ramp_lsb == 0.0) {
+                EXPECT(measured < Board::adc_bits + 0.2f, "noiseless input gained bits at +%d (%.1f)\n", bits,
+                       measured);
+                EXPECT(estimated <= Board::adc_bits, "noiseless: oversampler claims %.1f bits at +%d\n", estimated,
+                       bits);
+            }
+            if (bits == ADC_OVERSAMPLE_MAX_BITS && in.noise_lsb == 1.0) {
+                EXPECT(measured >= 13.8f, "1 LSB noise reached only %.1f bits\n", measured);
+                EXPECT(fabsf(estimated - measured) < 0.5f, "1 LSB noise: estimate %.1f vs %.1f bits\n", estimated,
+                       measured);
+            }
+            if (bits == ADC_OVERSAMPLE_MAX_BITS && in.ramp_lsb > 0.0) {
+                EXPECT(measured >= 15.0f, "ramp dither reached only %.1f bits\n", measured);
+            }
+        }
+        printf("\n");
+    }
+}
+
+//=============================================================================
+// FIRMWARE PATH
+//=============================================================================
+
+static uint16_t firmware_adc(uint8_t pin, void* ctx) {
+    return pin == PH_PIN ? (uint16_t)model_sample(ctx) : 2048;
+}
+
+static double ph_sigma(const calibration_t& cal, int readings, double* mean_out) {
+    double sum = 0.0, sum_sq = 0.0;
+    for (int i = 0; i < readings; i++) {
+        double ph = sensor_read_ph_raw(25.0f, cal);
+        sum += ph;
+        sum_sq += ph * ph;
+    }
+    double mean = sum / readings;
+    *mean_out = mean;
+    double variance = sum_sq / readings - mean * mean;
+    return variance > 0.0 ? sqrt(variance) : 0.0;
+}
+
+static void firmware_path(int readings) {
+    calibration_t cal;
+    cal.ph_slope = DEFAULT_PH_SLOPE;
+    cal.ph_offset = 27.0f;
+    const double true_ph = 6.5;
+    const double alpha = 0.2;
+    const double interval_s = SENSOR_INTERVAL / 1000.0;
+
+    host_reset();
+    communication_init("bench", "bench");
+    adc_cal_init();
+    // Input for pH 6.5 on the linear scale, as a fractional code
+    adc_model_t model = {(true_ph - cal.ph_offset) / cal.ph_slope / (SENSOR_ADC_VOLTS_PER_COUNT * 1000.0), 1.5, 0.0,
+                         0.0, 7};
+    host_set_adc_hook(firmware_adc, &model);
+
+    double base_filtered = 0.0;
+    printf("Firmware path at pH %.1f, 1.5 LSB ADC noise (%d readings each):\n", true_ph, readings);
+    for (int bits = 0; bits <= ADC_OVERSAMPLE_MAX_BITS; bits = bits == 0 ? 2 : bits + 1) {
+        sensor_set_ph_oversampling((uint8_t)bits);
+        EXPECT(sensor_get_ph_oversampling() == bits, "firmware: oversampling setting %d not applied\n", bits);
+        double mean = 0.0;
+        double sigma = ph_sigma(cal, readings, &mean);
+        double filtered = sigma * sqrt(alpha / (2.0 - alpha));
+        if (bits == 0) {
+            base_filtered = filtered;
+            printf("  %-22s pH noise %.5f per reading, %.5f after EMA alpha %.2f (lag %.0f s), mean %.4f\n",
+                   "5-sample average", sigma, filtered, alpha, (1.0 - alpha) / alpha * interval_s, mean);
+            continue;
+        }
+        // EMA noise: sigma * sqrt(a / (2 - a)); solve for the alpha giving the averaged path's filtered noise
+        double r = sigma > 0.0 ? (base_filtered / sigma) * (base_filtered / sigma) : 1.0;
+        double match = r >= 1.0 ? 1.0 : 2.0 * r / (1.0 + r);
+        char label[32];
+        snprintf(label, sizeof(label), "%d-bit oversampling", Board::adc_bits + bits);
+        printf("  %-22s pH noise %.5f per reading, %.5f after alpha %.2f; same noise as the average at alpha %.2f "
+               "(lag %.1f s), mean %.4f\n",
+               label, sigma, filtered, alpha, match, (1.0 - match) / match * interval_s, mean);
+        EXPECT(fabs(mean - true_ph) < 0.01, "firmware: %d-bit mean pH %.4f\n", Board::adc_bits + bits, mean);
+        if (bits == ADC_OVERSAMPLE_MAX_BITS) {
+            EXPECT(filtered < base_filtered, "firmware: 16-bit filtered noise %.5f not below the average %.5f\n",
+                   filtered, base_filtered);
+            EXPECT(match > alpha, "firmware: 16-bit needs alpha %.2f, not above %.2f\n", match, alpha);
+        }
+    }
+    sensor_set_ph_oversampling(0);
+    host_reset();
+}
+
+//=============================================================================
+// COST
+//=============================================================================
+
+static void cost(int readings) {
+    adc_model_t model = {2048.3, 1.0, 0.0, 0.0, 3};
+    for (int bits = 2; bits <= ADC_OVERSAMPLE_MAX_BITS; bits++) {
+        adc_oversample_t os;
+        adc_oversample_init(&os, (uint8_t)bits);
+        volatile uint32_t sink = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < readings; i++) sink = sink + adc_oversample_read(&os, model_sample, nullptr, &model);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("Cost +%d bits: %d conversions per reading, %.2f us per reading on the host (modelled ADC included)\n",
+               bits, 1 << (2 * bits), ns / readings / 1000.0);
+    }
+}
+
+int main(int argc, char** argv) {
+    int readings = argc > 1 ? atoi(argv[1]) : 4000;
+    if (readings < 200) readings = 200;
+
+    resolution(readings);
+    firmware_path(readings);
+    cost(readings);
+    if (failures) {
+        fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file bench_ph_shadow.cpp
+ * @brief Benchmark: shadow pH controllers next to the live reactive PID
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Runs the live reactive PID closed-loop against a drifting, noisy reservoir,
+ * once alone and once each with a shadow controller (a softer PID and the
+ * predictive policy). Reports the live vs shadow decision statistics and the
+ * host time per run. Fails if a shadow changes anything the live loop does:
+ * every plant pH sample and the ml dosed per pump must match the run without
+ * a shadow bit for bit. Also fails if a shadow counted no decisions.
+ * Firmware globals are per process, so each mode runs in a forked child.
+ *
+ *   bench_ph_shadow [hours] [drift_per_h] [volume_l]
+ */
+
+#include "sim_harness.h"
+#include "pump.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+struct shadow_result_t {
+    uint64_t trajectory;         // FNV-1a over every plant pH sample
+    float up_ml;                 // Live ml dosed
+    float down_ml;
+    ph_shadow_stats_t stats;
+    double host_ms;              // Wall time of the closed-loop run
+};
+
+struct shadow_mode_t {
+    const char* name;
+    PhPolicy policy;
+    float kp, ki, kd;
+};
+
+static shadow_result_t run_mode(const shadow_mode_t& mode, double hours, float drift_per_h, float volume_l) {
+    reservoir_config_t plant;
+    plant.volume_l = volume_l;
+    plant.ph = 6.0f;
+    plant.ph_drift_per_h = drift_per_h;
+    plant.noise_ph = 0.02f;
+    plant.noise_ec = 0.005f;
+    plant.noise_distance_cm = 0.1f;
+    plant.seed = 7;
+
+    sim_init(plant, 100);
+    sim_boot();
+    sim_send_cli("a");
+    if (mode.policy != PhPolicy::OFF) pump_set_ph_shadow(mode.policy, mode.kp, mode.ki, mode.kd);
+
+    shadow_result_t result = {};
+    result.trajectory = 1469598103934665603ull;
+    timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t end_ms = (uint32_t)(hours * 3600000.0);
+    while (sim_now_ms() < end_ms) {
+        sim_step();
+        uint32_t bits;
+        float ph = sim_reservoir()->ph;
+        memcpy(&bits, &ph, sizeof(bits));
+        for (int b = 0; b < 4; b++) {
+            result.trajectory = (result.trajectory ^ ((bits >> (8 * b)) & 0xFF)) * 1099511628211ull;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    result.host_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    result.up_ml = pump_get_total_dosed(PumpId::PH_UP);
+    result.down_ml = pump_get_total_dosed(PumpId::PH_DOWN);
+    pump_get_ph_shadow_stats(&result.stats);
+    return result;
+}
+
+static bool run_in_child(const shadow_mode_t& mode, double hours, float drift, float volume, shadow_result_t* out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        shadow_result_t r = run_mode(mode, hours, drift, volume);
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 8.0;
+    float drift = argc > 2 ? (float)atof(argv[2]) : 0.15f;
+    float volume = argc > 3 ? (float)atof(argv[3]) : 40.0f;
+
+    const shadow_mode_t modes[] = {
+        {"no shadow", PhPolicy::OFF, 0.0f, 0.0f, 0.0f},
+        {"PID Kp/2", PhPolicy::PID, DEFAULT_PH_KP * 0.5f, DEFAULT_PH_KI, DEFAULT_PH_KD},
+        {"predictive", PhPolicy::PREDICTIVE, DEFAULT_PH_KP, 0.0f, 0.0f},
+    };
+    const int count = sizeof(modes) / sizeof(modes[0]);
+    shadow_result_t results[count];
+    for (int i = 0; i < count; i++) {
+        if (!run_in_child(modes[i], hours, drift, volume, &results[i])) {
+            fprintf(stderr, "bench_ph_shadow: simulation run failed\n");
+            return 1;
+        }
+    }
+
+    printf("live reactive PID, %.1f h, drift %+.2f pH/h, %.0f L\n", hours, drift, volume);
+    printf("%-11s %9s %6s %8s %6s %6s %10s %10s %13s %8s\n", "shadow", "decisions", "agree", "opposite",
+           "live", "shadow", "live ml", "shadow ml", "same-pump dml", "host ms");
+    for (int i = 0; i < count; i++) {
+        const ph_shadow_stats_t& s = results[i].stats;
+        printf("%-11s %9u %5.1f%% %8u %6u %6u %10.1f %10.1f %+13.2f %8.0f\n", modes[i].name, s.decisions,
+               s.decisions ? 100.0 * s.agreements / s.decisions : 0.0, s.opposite,
+               s.live_doses[0] + s.live_doses[1], s.shadow_doses[0] + s.shadow_doses[1],
+               s.live_ml[0] + s.live_ml[1], s.shadow_ml[0] + s.shadow_ml[1],
+               s.same_pump_doses ? s.same_pump_ml_diff / s.same_pump_doses : 0.0, results[i].host_ms);
+    }
+
+    const shadow_result_t& base = results[0];
+    for (int i = 1; i < count; i++) {
+        const shadow_result_t& r = results[i];
+        if (r.trajectory != base.trajectory || r.up_ml != base.up_ml || r.down_ml != base.down_ml) {
+            fprintf(stderr, "bench_ph_shadow: %s shadow changed the live loop (pH Up %.2f vs %.2f ml, "
+                    "pH Down %.2f vs %.2f ml)\n", modes[i].name, r.up_ml, base.up_ml, r.down_ml, base.down_ml);
+            return 1;
+        }
+        if (r.stats.decisions == 0) {
+            fprintf(stderr, "bench_ph_shadow: %s shadow saw no decisions\n", modes[i].name);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file bench_ph_step.cpp
+ * @brief Benchmark: pH step correction with whole vs fractionated doses
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Starts the simulated reservoir well above the pH target, with the probe
+ * near the dosing outlet so it sees the unmixed plume, and lets the reactive
+ * PID correct it once per dose splitting setting. Scores the plant, not the
+ * filtered reading: time until the mixed pH stays inside target +/- PH_BAND,
+ * worst mixed overshoot past the target, worst plume excursion at the probe
+ * (the local acid spike roots see), doses and ml. Fails if splitting makes
+ * the plume spike or the overshoot worse, or settles later than the whole
+ * dose by more than the mixing gaps it adds.
+ * Firmware globals are per process, so each mode runs in a forked child.
+ *
+ *   bench_ph_step [start_ph] [volume_l] [pieces] [gap_s]
+ */
+
+#include "sim_harness.h"
+#include "pump.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct step_result_t {
+    double settle_min;           // Last time the mixed pH was out of band
+    double overshoot;            // Worst mixed pH past the target (opposite side to the start)
+    double plume_peak;           // Worst |plume pH offset| at the probe
+    int doses;                   // pH Up + pH Down dose starts (pieces included)
+    double ml;                   // pH Up + pH Down ml dosed
+};
+
+struct step_config_t {
+    float start_ph;
+    float volume_l;
+    uint8_t pieces;
+    uint32_t gap_ms;
+};
+
+static step_result_t run_step(const step_config_t& config) {
+    reservoir_config_t plant;
+    plant.volume_l = config.volume_l;
+    plant.ph = config.start_ph;
+    plant.plume_l = config.volume_l * 0.5f;   // Probe sits in the outlet's half of the tank
+    plant.noise_ph = 0.02f;
+    plant.noise_ec = 0.005f;
+    plant.noise_distance_cm = 0.1f;
+    plant.seed = 11;
+
+    const uint32_t tick_ms = 100;
+    const uint32_t run_ms = 3u * 3600000u;
+    sim_init(plant, tick_ms);
+    sim_boot();
+    pump_set_dose_fractionation(config.pieces, config.gap_ms);
+    sim_send_cli("a");
+
+    step_result_t result = {};
+    float target = pump_get_ph_target();
+    float side = config.start_ph > target ? 1.0f : -1.0f;
+    float last_total = 0.0f;
+    while (sim_now_ms() < run_ms) {
+        sim_step();
+
+        const reservoir_t* r = sim_reservoir();
+        float total = pump_get_total_dosed(PumpId::PH_UP) + pump_get_total_dosed(PumpId::PH_DOWN);
+        if (total != last_total) {
+            result.doses++;
+            result.ml += total - last_total;
+            last_total = total;
+        }
+        double error = r->ph - target;
+        if (fabs(error) > PH_BAND) result.settle_min = sim_now_ms() / 60000.0;
+        if (-side * error > result.overshoot) result.overshoot = -side * error;
+        double plume = fabs(reservoir_plume_ph(r));
+        if (plume > result.plume_peak) result.plume_peak = plume;
+    }
+    return result;
+}
+
+static bool run_in_child(const step_config_t& config, step_result_t* out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        step_result_t r = run_step(config);
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    float start_ph = argc > 1 ? (float)atof(argv[1]) : 7.2f;
+    float volume = argc > 2 ? (float)atof(argv[2]) : 40.0f;
+    uint8_t pieces = argc > 3 ? (uint8_t)atoi(argv[3]) : 3;
+    uint32_t gap_ms = argc > 4 ? (uint32_t)(atof(argv[4]) * 1000.0) : PUMP_FRACTION_DEFAULT_GAP_MS;
+
+    step_config_t whole = {start_ph, volume, 1, gap_ms};
+    step_config_t split = {start_ph, volume, pieces, gap_ms};
+    step_result_t results[2];
+    if (!run_in_child(whole, &results[0]) || !run_in_child(split, &results[1])) {
+        fprintf(stderr, "bench_ph_step: simulation run failed\n");
+        return 1;
+    }
+
+    printf("pH step %.2f -> %.2f in %.0f L, band +/-%.2f\n", start_ph, DEFAULT_PH_TARGET, volume, PH_BAND);
+    printf("%-14s %11s %10s %11s %6s %8s\n", "mode", "settle (min)", "overshoot", "plume peak", "doses", "ml");
+    char split_name[32];
+    snprintf(split_name, sizeof(split_name), "%dx, %lus gap", split.pieces, (unsigned long)(gap_ms / 1000));
+    const char* names[] = {"whole", split_name};
+    for (int i = 0; i < 2; i++) {
+        const step_result_t& r = results[i];
+        printf("%-14s %11.1f %10.3f %11.3f %6d %8.1f\n", names[i], r.settle_min, r.overshoot,
+               r.plume_peak, r.doses, r.ml);
+    }
+
+    // The last piece starts (pieces - 1) gaps after a whole dose would have
+    double gap_allowance_min = (split.pieces - 1) * gap_ms / 60000.0;
+    if (results[1].plume_peak > results[0].plume_peak || results[1].overshoot > results[0].overshoot ||
+        results[1].settle_min > results[0].settle_min + gap_allowance_min) {
+        fprintf(stderr, "bench_ph_step: fractionated dosing is not better than whole doses\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file bench_probe_vote.cpp
+ * @brief Benchmark: redundant pH probes voting against injected probe faults
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Runs auto pH closed-loop on the simulated reservoir with probe faults
+ * injected through the per-probe offset/drift model, configuring the probes
+ * with the 'n' console command as an operator would:
+ *
+ * - one healthy probe (reference)
+ * - one probe drifting high: the single-probe firmware doses pH Down after it
+ * - the same drift on probe 1 of three, median and weighted vote
+ * - probe 2 of three failing with a +2 pH step at 1 h
+ * - two probes, one drifting: a split, readings discarded, no dose on them
+ *
+ * Reports pH Down/Up ml, the true pH range and time outside target +-0.3,
+ * the voted-out probe and when, and discarded readings. Fails if any voting
+ * mode lets the faulty probe move the true pH out of band or spend more than
+ * the healthy run plus 20 %, if it does not exclude the faulty probe (three
+ * probes), or if the split run doses more than the healthy run. Firmware
+ * globals are per process, so each run forks. Past about 20 h the reactive
+ * PID starts hunting on this plant with or without faults, so keep runs
+ * shorter when comparing.
+ *
+ *   bench_probe_vote [hours] [drift_per_h]
+ */
+
+#include "sim_harness.h"
+#include "pump.h"
+#include "probe_vote.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+struct vote_run_t {
+    const char* name;
+    const char* probes_cli;      // 'n' lines before auto pH starts (nullptr = one probe)
+    int faulty;                  // Probe index with the fault
+    float drift_per_h;           // Fault as drift (pH/h), scaled by the command line
+    float step_ph;               // Fault as a step at step_at_h
+    float step_at_h;
+    bool split;                  // Two probes: the fault cannot be outvoted
+};
+
+struct vote_result_t {
+    float up_ml, down_ml;
+    float ph_min, ph_max;
+    double out_of_band_s;
+    int8_t excluded;             // First probe excluded, -1 if none
+    double excluded_at_h;
+    uint32_t splits;
+    uint32_t votes;
+};
+
+static const float kBand = 0.3f;
+
+static vote_result_t run(const vote_run_t& mode, double hours, float drift_scale) {
+    reservoir_config_t plant;
+    plant.volume_l = 40.0f;
+    plant.ph = 6.0f;
+    plant.ph_drift_per_h = 0.05f;
+    plant.noise_ph = 0.02f;
+    plant.noise_ec = 0.005f;
+    plant.noise_distance_cm = 0.1f;
+    plant.seed = 11;
+    if (mode.faulty >= 0) plant.ph_probe_drift_per_h[mode.faulty] = mode.drift_per_h * drift_scale;
+
+    sim_init(plant, 100);
+    sim_boot();
+    if (mode.probes_cli) sim_send_cli(mode.probes_cli);
+    sim_send_cli("a");
+
+    vote_result_t result = {};
+    result.ph_min = 14.0f;
+    result.excluded = -1;
+    bool stepped = false;
+    const uint32_t end_ms = (uint32_t)(hours * 3600000.0);
+    while (sim_now_ms() < end_ms) {
+        if (!stepped && mode.step_ph != 0.0f && sim_now_ms() >= mode.step_at_h * 3600000.0) {
+            sim_reservoir()->config.ph_probe_offset[mode.faulty] = mode.step_ph;
+            stepped = true;
+        }
+        sim_step();
+        float ph = sim_reservoir()->ph;
+        if (ph < result.ph_min) result.ph_min = ph;
+        if (ph > result.ph_max) result.ph_max = ph;
+        if (fabsf(ph - DEFAULT_PH_TARGET) > kBand) result.out_of_band_s += 0.1;
+        const probe_vote_t* vote = probe_vote_state(ProbeQuantity::PH);
+        if (result.excluded < 0) {
+            for (int i = 0; i < PROBE_MAX; i++) {
+                if (vote->probe[i].excluded) {
+                    result.excluded = (int8_t)i;
+                    result.excluded_at_h = sim_now_ms() / 3600000.0;
+                    break;
+                }
+            }
+        }
+    }
+    const probe_vote_t* vote = probe_vote_state(ProbeQuantity::PH);
+    result.splits = vote->splits;
+    result.votes = vote->votes;
+    result.up_ml = pump_get_total_dosed(PumpId::PH_UP);
+    result.down_ml = pump_get_total_dosed(PumpId::PH_DOWN);
+    return result;
+}
+
+static bool run_in_child(const vote_run_t& mode, double hours, float drift_scale, vote_result_t* out) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (pid == 0) {
+        close(fds[0]);
+        vote_result_t r = run(mode, hours, drift_scale);
+        ssize_t written = write(fds[1], &r, sizeof(r));
+        _exit(written == (ssize_t)sizeof(r) ? 0 : 1);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return got == (ssize_t)sizeof(*out) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char** argv) {
+    double hours = argc > 1 ? atof(argv[1]) : 8.0;
+    float drift = argc > 2 ? (float)atof(argv[2]) : 0.25f;
+
+    const vote_run_t modes[] = {
+        {"1 probe, healthy", nullptr, -1, 0.0f, 0.0f, 0.0f, false},
+        {"1 probe, drifting", nullptr, 0, 1.0f, 0.0f, 0.0f, false},
+        {"3 median, #1 drifting", "n\nph 3\n", 0, 1.0f, 0.0f, 0.0f, false},
+        {"3 weighted, #1 drifting", "n\nph 3\nn\nmode weighted\n", 0, 1.0f, 0.0f, 0.0f, false},
+        {"3 median, #2 +2 pH @1h", "n\nph 3\n", 1, 0.0f, 2.0f, 1.0f, false},
+        {"2 median, #1 drifting", "n\nph 2\n", 0, 1.0f, 0.0f, 0.0f, true},
+    };
+    const int count = sizeof(modes) / sizeof(modes[0]);
+    vote_result_t results[count];
+    for (int i = 0; i < count; i++) {
+        if (!run_in_child(modes[i], hours, drift, &results[i])) {
+            fprintf(stderr, "bench_probe_vote: simulation run failed\n");
+            return 1;
+        }
+    }
+
+    printf("auto pH, target %.1f, %.1f h, faulty probe drift %+.2f pH/h, plant drift +0.05 pH/h\n",
+           DEFAULT_PH_TARGET, hours, drift);
+    printf("%-24s %9s %9s %6s %6s %10s %14s %9s\n", "run", "down ml", "up ml", "pH min", "pH max",
+           "out band", "excluded", "discarded");
+    for (int i = 0; i < count; i++) {
+        const vote_result_t& r = results[i];
+        char excluded[24] = "-";
+        if (r.excluded >= 0) snprintf(excluded, sizeof(excluded), "#%d at %.2f h", r.excluded + 1, r.excluded_at_h);
+        printf("%-24s %9.1f %9.1f %6.2f %6.2f %9.0fs %14s %9u\n", modes[i].name, r.down_ml, r.up_ml, r.ph_min,
+               r.ph_max, r.out_of_band_s, excluded, r.splits);
+    }
+
+    int failures = 0;
+    const vote_result_t& healthy = results[0];
+    const float healthy_ml = healthy.down_ml + healthy.up_ml;
+    for (int i = 2; i < count; i++) {
+        const vote_result_t& r = results[i];
+        const vote_run_t& m = modes[i];
+        float ml = r.down_ml + r.up_ml;
+        if (m.split) {
+            if (ml > healthy_ml + 1.0f) {
+                fprintf(stderr, "FAIL: %s dosed %.1f ml on split readings (healthy %.1f)\n", m.name, ml, healthy_ml);
+                failures++;
+            }
+            if (r.splits == 0) {
+                fprintf(stderr, "FAIL: %s discarded no readings\n", m.name);
+                failures++;
+            }
+            continue;
+        }
+        if (r.ph_min < DEFAULT_PH_TARGET - kBand || ml > healthy_ml * 1.2f + 1.0f) {
+            fprintf(stderr, "FAIL: %s: faulty probe moved the tank (pH min %.2f, %.1f ml vs %.1f)\n", m.name,
+                    r.ph_min, ml, healthy_ml);
+            failures++;
+        }
+        if (r.excluded != m.faulty) {
+            fprintf(stderr, "FAIL: %s excluded probe %d, not the faulty #%d\n", m.name, r.excluded + 1,
+                    m.faulty + 1);
+            failures++;
+        }
+    }
+    if (results[1].ph_min >= DEFAULT_PH_TARGET - kBand) {
+        fprintf(stderr, "FAIL: the single drifting probe did not move the tank (pH min %.2f) - fault too small\n",
+                results[1].ph_min);
+        failures++;
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,422 @@
+/**
+ * @file bench_usb_export.cpp
+ * @brief Benchmark: USB bulk export integrity, port separation and encode rate
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The controller is filled first: a wrapped telemetry history, a wrapped
+ * log flight recorder and more abnormal resets than the crash log keeps.
+ *
+ * 1. Integrity: an export through a port that takes random slices (and is
+ *    sometimes busy) while readings and log lines keep arriving. The capture
+ *    must be complete, hold exactly the snapshot (what was overwritten
+ *    before it was sent is reported, nothing newer appears) and match what
+ *    was published byte for byte.
+ * 2. Shared port: console text lands between writes, sometimes inside a
+ *    frame. The receiver must skip the text, lose exactly the frames it
+ *    broke and keep every other frame intact. (Why the firmware refuses to
+ *    export over the console port: those frames are lost.)
+ * 3. Firmware path: 'X' on the shim's native USB port. Debug lines and
+ *    direct Serial prints during the export stay on the console, the export
+ *    port carries nothing but frames, and a host that stops reading aborts a
+ *    console-started export.
+ * 4. Rate: full exports to memory. Reports encode throughput, frame
+ *    overhead and the longest loop() slice, against the 115200 baud console.
+ *
+ *   bench_usb_export [exports]
+ */
+
+#include "usb_export.h"
+#include "usb_export_capture.h"
+#include "telemetry.h"
+#include "binlog.h"
+#include "crash_log.h"
+#include "cli.h"
+#include "state_machine.h"
+#include "communication.h"
+#include "host_hal.h"
+
+#include <Preferences.h>
+#include <esp_system.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// NVS preferences object (main.cpp is not linked; the CLI pulls in calibration)
+Preferences preferences;
+
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+//=============================================================================
+// DEVICE CONTENT
+//=============================================================================
+
+// Everything published, by telemetry seq and in log order
+static std::vector<telemetry_event_t> published;
+static std::vector<usb_export_log_line_t> logged;
+static uint32_t reading_count = 0;
+
+static void record_telemetry(const telemetry_event_t& event, const uint8_t* frame, size_t len) {
+    telemetry_event_t decoded;
+    size_t consumed = 0;
+    telemetry_decode(frame, len, &decoded, &consumed);     // Quantised as the receiver sees it
+    (void)event;
+    published.push_back(decoded);
+}
+
+static void record_log(const binlog_record_t& record, const char* text) {
+    logged.push_back({record.timestamp_us, text});
+}
+
+static void publish_reading(void) {
+    sensor_readings_t reading = {};
+    reading.ph = 5.8f + 0.001f * (float)(reading_count % 400);
+    reading.ec = 1.2f + 0.0001f * (float)(reading_count % 1000);
+    reading.volume = 40.0f - 0.1f * (float)(reading_count % 50);
+    reading.temperature = 21.0f + 0.01f * (float)(reading_count % 300);
+    reading.timestamp = millis();
+    reading.valid = true;
+    telemetry_publish_reading(reading);
+    reading_count++;
+}
+
+static void log_lines(int count) {
+    for (int i = 0; i < count; i++) {
+        binlog("[BENCH] reading %u ph=%.3f dose=%d", reading_count, 6.0f + 0.01f * (float)(i % 50), i);
+        if (i % 8 == 7) binlog_drain(BINLOG_RING_SIZE);
+    }
+    binlog_drain(BINLOG_RING_SIZE);
+}
+
+static void fill_device(void) {
+    // Abnormal resets: more than CRASH_LOG_RECORDS, interleaved with normal boots
+    static const int kReasons[] = {ESP_RST_POWERON, ESP_RST_PANIC, ESP_RST_TASK_WDT, ESP_RST_SW, ESP_RST_BROWNOUT,
+                                   ESP_RST_INT_WDT, ESP_RST_PANIC, ESP_RST_WDT, ESP_RST_PANIC, ESP_RST_EXT,
+                                   ESP_RST_TASK_WDT, ESP_RST_PANIC, ESP_RST_BROWNOUT};
+    for (int reason : kReasons) {
+        host_set_reset_reason(reason);
+        crash_log_init();
+        host_advance_ms(60000);
+        crash_log_checkpoint((uint8_t)SystemState::MONITORING);
+    }
+    host_set_reset_reason(ESP_RST_POWERON);
+
+    telemetry_add_sink(record_telemetry);
+    binlog_add_sink(record_log);
+    for (int i = 0; i < 3 * TELEMETRY_HISTORY_FRAMES; i++) {
+        publish_reading();
+        host_advance_ms(1000);
+    }
+    log_lines(600);
+}
+
+// Capture content against what was published
+static void check_content(const char* name, const usb_export_capture_t& capture) {
+    for (const telemetry_event_t& e : capture.telemetry) {
+        if (e.seq >= published.size()) {
+            EXPECT(false, "%s: telemetry seq %u was never published\n", name, e.seq);
+            return;
+        }
+        const telemetry_event_t& p = published[e.seq];
+        EXPECT(e.type == p.type && e.timestamp == p.timestamp && e.reading.ph == p.reading.ph &&
+                   e.reading.ec == p.reading.ec && e.reading.volume == p.reading.volume &&
+                   e.reading.temperature == p.reading.temperature,
+               "%s: telemetry seq %u differs from what was published\n", name, e.seq);
+    }
+    for (size_t i = 1; i < capture.telemetry.size(); i++) {
+        EXPECT(capture.telemetry[i].seq > capture.telemetry[i - 1].seq, "%s: telemetry seq %u follows %u\n", name,
+               capture.telemetry[i].seq, capture.telemetry[i - 1].seq);
+    }
+
+    // Log lines appear in logging order (runs overwritten before they were sent are skipped)
+    size_t next = 0;
+    for (size_t i = 0; i < capture.logs.size(); i++) {
+        while (next < logged.size() && (logged[next].timestamp_us != capture.logs[i].timestamp_us ||
+                                        logged[next].text != capture.logs[i].text)) {
+            next++;
+        }
+        if (next == logged.size()) {
+            EXPECT(false, "%s: log line %zu was never logged or is out of order\n", name, i);
+            return;
+        }
+        next++;
+    }
+}
+
+static void check_crashes(const char* name, const usb_export_capture_t& capture) {
+    EXPECT((int)capture.crashes.size() == crash_log_count(), "%s: %zu crash records, device holds %d\n", name,
+           capture.crashes.size(), crash_log_count());
+    for (size_t i = 0; i < capture.crashes.size(); i++) {
+        crash_record_t record;
+        crash_log_get((int)i, &record);
+        EXPECT(capture.crashes[i].boot == record.boot && capture.crashes[i].uptime_ms == record.uptime_ms &&
+                   capture.crashes[i].reason == record.reason && capture.crashes[i].system_state == record.system_state,
+               "%s: crash record %zu differs\n", name, i);
+    }
+}
+
+//=============================================================================
+// PORTS
+//=============================================================================
+
+/**
+ * @brief A host port taking 1..max_slice bytes per write, busy one write in busy_every
+ */
+struct slice_port_t {
+    std::vector<uint8_t> bytes;
+    size_t max_slice = 700;
+    int busy_every = 5;
+    uint32_t rng = 12345;
+    const usb_export_t* session = nullptr;
+    int inject_every = 0;                // Console line between writes (0 = never)
+    int writes = 0;
+    int frames_broken = 0;               // Frames the injected text landed inside
+    int last_broken = -1;                // seq of the last one
+};
+
+static uint32_t next_random(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static int slice_write(void* ctx, const uint8_t* data, size_t len) {
+    slice_port_t* port = static_cast<slice_port_t*>(ctx);
+    port->writes++;
+    if (port->inject_every && port->writes % port->inject_every == 0) {
+        static const char kLine[] = "[123456] Sensor: pH 6.02 EC 1.41 [Serial]\n";
+        port->bytes.insert(port->bytes.end(), kLine, kLine + sizeof(kLine) - 1);
+        const usb_export_t* s = port->session;
+        int seq = (uint16_t)(s->seq - 1);
+        if (s->frame_sent > 0 && s->frame_sent < s->frame_len && seq != port->last_broken) {
+            port->frames_broken++;
+            port->last_broken = seq;
+        }
+    }
+    if (port->busy_every && next_random(&port->rng) % port->busy_every == 0) return 0;
+    size_t n = 1 + next_random(&port->rng) % port->max_slice;
+    if (n > len) n = len;
+    port->bytes.insert(port->bytes.end(), data, data + n);
+    return (int)n;
+}
+
+static int memory_write(void* ctx, const uint8_t* data, size_t len) {
+    std::vector<uint8_t>* out = static_cast<std::vector<uint8_t>*>(ctx);
+    out->insert(out->end(), data, data + len);
+    return (int)len;
+}
+
+/**
+ * @brief Export through a slice port while the controller keeps publishing
+ */
+static void run_export(slice_port_t* port, usb_export_capture_t* capture, int publish_every) {
+    usb_export_t session;
+    usb_export_begin(&session, micros());
+    port->session = &session;
+    int passes = 0;
+    while (!usb_export_finished(&session)) {
+        usb_export_pump(&session, slice_write, port, 1024, micros());
+        host_advance_ms(1);
+        if (++passes % publish_every == 0) publish_reading();
+        if (passes % 25 == 0) log_lines(4);
+    }
+    usb_export_capture_reset(capture);
+    usb_export_capture_feed(capture, port->bytes.data(), port->bytes.size());
+}
+
+//=============================================================================
+// SCENARIOS
+//=============================================================================
+
+static void integrity(const char* name, size_t max_slice, int busy_every, int publish_every) {
+    slice_port_t port;
+    port.max_slice = max_slice;
+    port.busy_every = busy_every;
+    usb_export_capture_t capture;
+    run_export(&port, &capture, publish_every);
+
+    EXPECT(usb_export_capture_complete(&capture), "%s: capture incomplete (%llu missing, %llu malformed)\n", name,
+           (unsigned long long)capture.missing_frames, (unsigned long long)capture.bad_payloads);
+    EXPECT(capture.skipped_bytes == 0, "%s: %llu bytes skipped on a clean port\n", name,
+           (unsigned long long)capture.skipped_bytes);
+    uint32_t snapshot_frames = capture.telemetry_to - capture.telemetry_from;
+    EXPECT(capture.telemetry.size() + capture.telemetry_lost == snapshot_frames,
+           "%s: %zu telemetry frames + %u lost != snapshot of %u\n", name, capture.telemetry.size(),
+           capture.telemetry_lost, snapshot_frames);
+    EXPECT(snapshot_frames == (uint32_t)TELEMETRY_HISTORY_FRAMES, "%s: snapshot of %u frames\n", name, snapshot_frames);
+    EXPECT(capture.telemetry.empty() || (int32_t)(capture.telemetry.back().seq - capture.telemetry_to) < 0,
+           "%s: frames newer than the snapshot\n", name);
+    size_t log_bytes = 0;
+    for (const usb_export_log_line_t& line : capture.logs) log_bytes += BINLOG_HISTORY_ENTRY_HEADER + line.text.size();
+    EXPECT(log_bytes + capture.log_lost == capture.log_bytes, "%s: %zu log bytes + %u lost != snapshot of %u\n", name,
+           log_bytes, capture.log_lost, capture.log_bytes);
+    EXPECT(capture.log_bytes > BINLOG_HISTORY_BYTES - 300, "%s: flight recorder not full (%u bytes)\n", name,
+           capture.log_bytes);
+    check_content(name, capture);
+    check_crashes(name, capture);
+    EXPECT(capture.crashes.size() == (size_t)CRASH_LOG_RECORDS, "%s: %zu crash records kept\n", name,
+           capture.crashes.size());
+
+    printf("%s: %llu frames, %u bytes in %u slices | %zu telemetry (+%u overwritten), %zu log lines "
+           "(+%u bytes overwritten), %zu crash records\n",
+           name, (unsigned long long)capture.frames, capture.device_bytes, port.writes, capture.telemetry.size(),
+           capture.telemetry_lost, capture.logs.size(), capture.log_lost, capture.crashes.size());
+}
+
+static void shared_port(void) {
+    slice_port_t port;
+    port.inject_every = 25;
+    port.max_slice = 200;
+    usb_export_capture_t capture;
+    run_export(&port, &capture, 10);
+
+    EXPECT(capture.ended, "shared port: END lost\n");
+    EXPECT(capture.missing_frames == (uint64_t)port.frames_broken, "shared port: %llu frames missing, %d broken\n",
+           (unsigned long long)capture.missing_frames, port.frames_broken);
+    EXPECT(capture.frames + capture.missing_frames == (uint64_t)capture.device_frames + 1,
+           "shared port: %llu received + %llu missing != %u sent\n", (unsigned long long)capture.frames,
+           (unsigned long long)capture.missing_frames, capture.device_frames + 1);
+    EXPECT(capture.bad_payloads == 0, "shared port: %llu malformed payloads\n", (unsigned long long)capture.bad_payloads);
+    check_content("shared port", capture);
+
+    printf("Shared port: %d console lines injected, %d inside frames -> %llu of %u frames lost, %llu bytes skipped\n",
+           port.writes / port.inject_every, port.frames_broken, (unsigned long long)capture.missing_frames,
+           capture.device_frames + 1, (unsigned long long)capture.skipped_bytes);
+}
+
+static std::string serial_out;
+static std::string usb_out;
+
+static void capture_output(const char* data, size_t len, void* ctx) {
+    static_cast<std::string*>(ctx)->append(data, len);
+}
+
+static size_t count_of(const std::string& text, const char* needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+
+static void firmware_path(void) {
+    serial_out.clear();
+    usb_out.clear();
+    host_serial_set_output_hook(capture_output, &serial_out);
+    host_usb_set_output_hook(capture_output, &usb_out);
+    host_usb_set_tx_space(1024);
+
+    // usbdump's trigger on the native port; console text printed meanwhile,
+    // through Debug or straight to Serial, stays on the console
+    const uint8_t trigger = (uint8_t)USB_EXPORT_TRIGGER;
+    host_usb_feed(&trigger, 1);
+    usb_export_update();
+    EXPECT(usb_export_is_active(), "firmware: 'X' on the native port did not start an export\n");
+    int printed = 0;
+    int passes = 0;
+    for (; passes < 10000 && usb_export_is_active(); passes++) {
+        usb_export_update();
+        if (!usb_export_is_active()) break;
+        if (passes % 3 == 0) {
+            Debug->printf("console tick %d", printed++);
+            Serial.printf("direct tick\n");
+        }
+        host_advance_ms(1);
+    }
+    EXPECT(!usb_export_is_active(), "firmware: export still running\n");
+    EXPECT(count_of(usb_out, "console tick") == 0 && count_of(usb_out, "direct tick") == 0,
+           "firmware: console text on the export port\n");
+    EXPECT(count_of(serial_out, "console tick") == (size_t)printed && count_of(serial_out, "direct tick") == (size_t)printed,
+           "firmware: %zu + %zu of %d console lines on the console\n", count_of(serial_out, "console tick"),
+           count_of(serial_out, "direct tick"), printed);
+
+    usb_export_capture_t capture;
+    usb_export_capture_feed(&capture, reinterpret_cast<const uint8_t*>(usb_out.data()), usb_out.size());
+    EXPECT(usb_export_capture_complete(&capture), "firmware: capture incomplete\n");
+    EXPECT(capture.skipped_bytes == 0, "firmware: %llu stray bytes on the export port\n",
+           (unsigned long long)capture.skipped_bytes);
+    check_content("firmware", capture);
+    check_crashes("firmware", capture);
+    printf("Firmware path: %u bytes over the native USB port in %d loop passes, %d Debug and %d direct Serial "
+           "lines kept on the console\n", capture.device_bytes, passes + 1, printed, printed);
+
+    // Console 'X', then the host stops reading: abort after USB_EXPORT_STALL_MS
+    usb_export_stats_t before = usb_export_get_stats();
+    cli_process_command(USB_EXPORT_TRIGGER);
+    EXPECT(usb_export_is_active(), "firmware: console 'X' did not start an export\n");
+    host_usb_set_tx_space(0);
+    for (uint32_t ms = 0; ms <= USB_EXPORT_STALL_MS + 10 && usb_export_is_active(); ms += 10) {
+        usb_export_update();
+        host_advance_ms(10);
+    }
+    EXPECT(!usb_export_is_active() && usb_export_get_stats().aborted == before.aborted + 1,
+           "firmware: stalled export not aborted\n");
+    host_usb_set_tx_space(4096);
+    host_serial_set_output_hook(nullptr, nullptr);
+    host_usb_set_output_hook(nullptr, nullptr);
+}
+
+static void rate(long exports) {
+    std::vector<uint8_t> out;
+    out.reserve(64 * 1024);
+    size_t bytes = 0;
+    double longest_slice_us = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < exports; i++) {
+        out.clear();
+        usb_export_t session;
+        usb_export_begin(&session, micros());
+        while (!usb_export_finished(&session)) {
+            auto slice_start = std::chrono::steady_clock::now();
+            usb_export_pump(&session, memory_write, &out, USB_EXPORT_BYTES_PER_LOOP, micros());
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - slice_start).count();
+            if (us > longest_slice_us) longest_slice_us = us;
+        }
+        bytes += out.size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    usb_export_capture_t capture;
+    usb_export_capture_feed(&capture, out.data(), out.size());
+    EXPECT(usb_export_capture_complete(&capture), "rate: capture incomplete\n");
+    size_t payload = out.size() - (size_t)capture.frames * (USB_EXPORT_HEADER_LEN + 2);
+    double overhead = 100.0 * (double)(out.size() - payload) / (double)out.size();
+    EXPECT(overhead < 3.0, "rate: framing overhead %.1f%%\n", overhead);
+
+    double per_export_kb = out.size() / 1024.0;
+    printf("Rate: %.1f KB per export, framing overhead %.1f%% | encode %.0f MB/s on this host, longest "
+           "%zu-byte slice %.1f us | 115200 baud console: %.1f s per export\n",
+           per_export_kb, overhead, bytes / seconds / 1e6, USB_EXPORT_BYTES_PER_LOOP, longest_slice_us,
+           out.size() * 10.0 / 115200.0);
+}
+
+int main(int argc, char** argv) {
+    long exports = argc > 1 ? atol(argv[1]) : 200;
+    if (exports < 1) exports = 1;
+
+    host_reset();
+    binlog_init();
+    communication_init("bench", "bench");
+    telemetry_init();
+    usb_export_init();
+    fill_device();
+
+    integrity("Integrity", 700, 5, 10);
+    integrity("Slow host", 8, 2, 1);
+    shared_port();
+    firmware_path();
+    rate(exports);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,345 @@
+/**
+ * @file bench_watch.cpp
+ * @brief Benchmark: per-connection watch cadence and formatting cost
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * 1. Parser: accepted and rejected watch commands.
+ * 2. Cadence: the operators from the request on a loop() running every
+ *    10 ms - pump states every second, pH every 30 s, EC every 5 s with pH
+ *    every 30 s on one line, and a logger watching nothing. Each must get
+ *    exactly its periods with no drift and only the channels it asked for.
+ * 3. Cost: loop passes with nothing watched, with the operators and with 32
+ *    clients, against formatting a full status line for every client on
+ *    every reading. Lines formatted must follow the subscriptions (one per
+ *    distinct channel set per pass), snapshots only the passes with
+ *    something due.
+ * 4. Firmware path: 'W' on the Serial console reads "ph 5" from the same
+ *    connection, and watch_update() prints the pH line every 5 s. While a
+ *    pump runs, 'W' is refused instead of blocking loop() for its prompt.
+ *
+ *   bench_watch [minutes]
+ */
+
+#include "watch.h"
+#include "cli.h"
+#include "telemetry.h"
+#include "state_machine.h"
+#include "pump.h"
+#include "communication.h"
+#include "host_hal.h"
+
+#include <Preferences.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// NVS preferences object (main.cpp is not linked; the CLI pulls in calibration)
+Preferences preferences;
+
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+static constexpr uint32_t kLoopMs = 10;
+static constexpr int kMaxClients = 32;
+
+//=============================================================================
+// CLIENTS
+//=============================================================================
+
+struct received_t {
+    std::vector<uint32_t> at;            // millis() of each line
+    std::vector<std::string> lines;
+};
+
+struct bench_t {
+    received_t received[kMaxClients];
+    uint32_t now;
+    bool keep;                           // Keep line text (cadence), or only count (cost)
+    uint64_t lines;
+};
+
+static uint32_t bench_now;                           // Clock of the pure-core scenarios
+
+// The reading is always fresh here (the firmware path covers stale ones)
+static void fake_refresh(watch_snapshot_t* snapshot) {
+    snapshot->have_reading = true;
+    snapshot->reading = sensor_readings_t(6.12f, 1.48f, 41.5f, 21.7f);
+    snapshot->reading.timestamp = bench_now;
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        snapshot->pump_state[i] = static_cast<uint8_t>(i == 0 ? PumpState::DOSING : PumpState::IDLE);
+    }
+    snapshot->system_state = static_cast<uint8_t>(SystemState::DOSING);
+    snapshot->taken_at = bench_now;
+}
+
+static bool record_line(void* ctx, int client, const char* line) {
+    bench_t* bench = static_cast<bench_t*>(ctx);
+    bench->lines++;
+    if (bench->keep) {
+        bench->received[client].at.push_back(bench->now);
+        bench->received[client].lines.push_back(line);
+    }
+    return true;
+}
+
+static watch_request_t parse(const char* text) {
+    watch_request_t request = {WatchAction::LIST, 0, 0, false};
+    bool ok = watch_parse(text, strlen(text), &request);
+    EXPECT(ok, "parser: \"%s\" rejected\n", text);
+    return request;
+}
+
+//=============================================================================
+// SCENARIOS
+//=============================================================================
+
+static void parser(void) {
+    static const char* kAccepted[] = {"ph 30", "PUMPS 1", "watch ec 5s", "  temp\t3600 ", "volume off", "off",
+                                      "list", "", "log off", "log on", "state 2"};
+    static const char* kRejected[] = {"ph", "ph 0", "ph 3601", "ph -5", "ph 1.5", "ph 30 40", "alarms 5",
+                                      "log", "log maybe", "on", "ph 99999999", "ph s"};
+    int accepted = 0;
+    for (const char* text : kAccepted) {
+        watch_request_t request;
+        bool ok = watch_parse(text, strlen(text), &request);
+        EXPECT(ok, "parser: \"%s\" rejected\n", text);
+        accepted += ok ? 1 : 0;
+    }
+    for (const char* text : kRejected) {
+        watch_request_t request = {WatchAction::LOG, 7, 7, true};
+        EXPECT(!watch_parse(text, strlen(text), &request), "parser: \"%s\" accepted\n", text);
+        EXPECT(request.channel == 7 && request.period_ms == 7, "parser: \"%s\" changed the request\n", text);
+    }
+    watch_request_t request = parse("watch ec 5s");
+    EXPECT(request.action == WatchAction::SET && request.channel == static_cast<uint8_t>(WatchChannel::EC) &&
+               request.period_ms == 5000,
+           "parser: \"watch ec 5s\" parsed wrong\n");
+    printf("Parser: %d of %zu commands accepted, %zu rejected\n", accepted, sizeof(kAccepted) / sizeof(kAccepted[0]),
+           sizeof(kRejected) / sizeof(kRejected[0]));
+}
+
+static void check_cadence(const char* name, const received_t& r, uint32_t period_ms, uint32_t start, uint32_t end) {
+    size_t expected = (end - start + period_ms - 1) / period_ms;
+    EXPECT(r.at.size() == expected, "%s: %zu lines, expected %zu\n", name, r.at.size(), expected);
+    for (size_t i = 0; i < r.at.size(); i++) {
+        uint32_t due = start + (uint32_t)i * period_ms;
+        EXPECT(r.at[i] == due, "%s: line %zu at %u ms, due at %u\n", name, i, r.at[i], due);
+        if (r.at[i] != due) break;
+    }
+}
+
+static void cadence(int minutes) {
+    static bench_t bench;
+    bench = bench_t();
+    bench.keep = true;
+    watch_client_t clients[WATCH_MAX_CLIENTS];
+    watch_table_t table;
+    watch_table_init(&table, clients, WATCH_MAX_CLIENTS);
+
+    // Client 0 is the logger on Serial: the full log, no watches
+    uint32_t start = 0xFFFFF000u;                        // millis() wraps during the run
+    watch_apply(&table, 1, parse("pumps 1"), start);
+    watch_apply(&table, 2, parse("ph 30"), start);
+    watch_apply(&table, 3, parse("ec 5"), start);
+    watch_apply(&table, 3, parse("ph 30"), start);
+
+    uint32_t end = start + (uint32_t)minutes * 60000u;
+    for (bench.now = start; bench.now != end; bench.now += kLoopMs) {
+        bench_now = bench.now;
+        watch_run(&table, fake_refresh, record_line, &bench, bench.now);
+    }
+
+    EXPECT(bench.received[0].at.empty(), "cadence: the logger got %zu watch lines\n", bench.received[0].at.size());
+    check_cadence("pumps 1s", bench.received[1], 1000, start, end);
+    check_cadence("ph 30s", bench.received[2], 30000, start, end);
+    check_cadence("ec 5s + ph 30s", bench.received[3], 5000, start, end);
+    for (const std::string& line : bench.received[1].lines) {
+        EXPECT(line.find("pH_Up=DOSING") != std::string::npos && line.find("pH ") == std::string::npos,
+               "cadence: pump line \"%s\"\n", line.c_str());
+    }
+    for (const std::string& line : bench.received[2].lines) {
+        EXPECT(line == "watch | pH 6.12", "cadence: pH line \"%s\"\n", line.c_str());
+    }
+    int both = 0;
+    for (size_t i = 0; i < bench.received[3].lines.size(); i++) {
+        const std::string& line = bench.received[3].lines[i];
+        bool with_ph = line.find("pH 6.12") != std::string::npos;
+        both += with_ph ? 1 : 0;
+        EXPECT(with_ph == (i % 6 == 0) && line.find("EC 1.48") != std::string::npos, "cadence: line %zu \"%s\"\n", i,
+               line.c_str());
+    }
+    printf("Cadence (%d min): pumps/1s %zu lines, pH/30s %zu, EC/5s+pH/30s %zu (%d with both), logger 0 | "
+           "%u snapshots for %u loop passes\n",
+           minutes, bench.received[1].at.size(), bench.received[2].at.size(), bench.received[3].at.size(), both,
+           table.snapshots, (uint32_t)(end - start) / kLoopMs);
+}
+
+struct cost_t {
+    double ns_per_pass;
+    uint64_t lines;
+    uint32_t formatted;
+    uint32_t snapshots;
+};
+
+static cost_t measure(watch_table_t* table, long passes) {
+    static bench_t bench;
+    bench = bench_t();
+    uint32_t snapshots = table->snapshots;
+    uint32_t formatted = table->formatted;
+    uint32_t start = 1000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (long i = 0; i < passes; i++) {
+        bench.now = bench_now = start + (uint32_t)i * kLoopMs;
+        watch_run(table, fake_refresh, record_line, &bench, bench.now);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return {ns / passes, bench.lines, table->formatted - formatted, table->snapshots - snapshots};
+}
+
+static void cost(int minutes) {
+    long passes = (long)minutes * 60000 / kLoopMs;
+    static watch_client_t clients[kMaxClients];
+    watch_table_t table;
+
+    watch_table_init(&table, clients, WATCH_MAX_CLIENTS);
+    cost_t idle = measure(&table, passes);
+    EXPECT(idle.lines == 0 && idle.snapshots == 0, "cost: idle table wrote %llu lines\n", (unsigned long long)idle.lines);
+
+    watch_table_init(&table, clients, WATCH_MAX_CLIENTS);
+    watch_apply(&table, 1, parse("pumps 1"), 1000);
+    watch_apply(&table, 2, parse("ph 30"), 1000);
+    cost_t operators = measure(&table, passes);
+    EXPECT(operators.formatted == operators.lines, "cost: operators formatted %u lines for %llu written\n",
+           operators.formatted, (unsigned long long)operators.lines);
+    EXPECT(operators.snapshots == (uint32_t)minutes * 60, "cost: %u snapshots in %d s\n", operators.snapshots,
+           minutes * 60);
+
+    // 32 clients on the same channels: one line per pass, shared
+    watch_table_init(&table, clients, kMaxClients);
+    for (int c = 0; c < kMaxClients; c++) watch_apply(&table, c, parse("ph 1"), 1000);
+    cost_t same = measure(&table, passes);
+    EXPECT(same.formatted == (uint32_t)minutes * 60 && same.lines == (uint64_t)kMaxClients * minutes * 60,
+           "cost: 32 same-channel clients formatted %u lines for %llu written\n", same.formatted,
+           (unsigned long long)same.lines);
+
+    // 32 clients, all channels, different periods: one line per client and due pass
+    watch_table_init(&table, clients, kMaxClients);
+    for (int c = 0; c < kMaxClients; c++) {
+        for (int ch = 0; ch < WATCH_CHANNEL_COUNT; ch++) {
+            watch_request_t request = {WatchAction::SET, (uint8_t)ch, (uint32_t)(1 + (c + ch) % 10) * 1000u, false};
+            watch_apply(&table, c, request, 1000);
+        }
+    }
+    cost_t mixed = measure(&table, passes);
+    EXPECT(mixed.formatted <= mixed.lines, "cost: mixed formatted more lines than written\n");
+
+    // Broadcast equivalent: a full status line for 32 clients on every reading
+    watch_snapshot_t snapshot;
+    fake_refresh(&snapshot);
+    char line[WATCH_LINE_MAX];
+    long readings = (long)minutes * 60000 / SENSOR_INTERVAL;
+    uint8_t all = (uint8_t)((1u << WATCH_CHANNEL_COUNT) - 1);
+    auto t0 = std::chrono::steady_clock::now();
+    for (long r = 0; r < readings; r++) {
+        for (int c = 0; c < kMaxClients; c++) watch_format(all, snapshot, bench_now, line, sizeof(line));
+    }
+    double broadcast_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    double format_us = broadcast_us / (double)(readings * kMaxClients);
+
+    printf("Cost per loop pass (%ld passes): idle %.1f ns | operators %.1f ns, %u lines formatted | "
+           "32 clients same channels %.1f ns, %u formatted for %llu lines | 32 clients mixed %.1f ns, %u formatted "
+           "for %llu lines\n",
+           passes, idle.ns_per_pass, operators.ns_per_pass, operators.formatted, same.ns_per_pass, same.formatted,
+           (unsigned long long)same.lines, mixed.ns_per_pass, mixed.formatted, (unsigned long long)mixed.lines);
+    printf("Formatting: %.2f us per full line on this host; per-client status on every reading would format "
+           "%ld lines for 32 clients\n",
+           format_us, readings * kMaxClients);
+    EXPECT(idle.ns_per_pass * 10.0 < format_us * 1000.0, "cost: idle pass %.1f ns not cheaper than a line (%.2f us)\n",
+           idle.ns_per_pass, format_us);
+}
+
+static std::string serial_out;
+
+static void capture_serial(const char* data, size_t len, void* ctx) {
+    (void)ctx;
+    serial_out.append(data, len);
+}
+
+static size_t count_of(const std::string& text, const char* needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) count++;
+    return count;
+}
+
+static void console_command(const char* input) {
+    host_serial_feed(reinterpret_cast<const uint8_t*>(input), strlen(input));
+    while (Debug->available()) cli_process_command(Debug->read());
+}
+
+static void firmware_path(void) {
+    host_reset();
+    communication_init("bench", "bench");
+    telemetry_init();
+    watch_init();
+    serial_out.clear();
+    host_serial_set_output_hook(capture_serial, nullptr);
+
+    sensor_readings_t reading(6.31f, 1.52f, 38.0f, 20.5f);
+    telemetry_publish_reading(reading);
+    console_command("W\r\nph 5\r\n");
+    EXPECT(count_of(serial_out, "Watching: ph 5s") == 1, "firmware: no confirmation\n");
+    for (int s = 0; s < 60; s++) {
+        watch_update();
+        host_advance_ms(1000);
+    }
+    size_t lines = count_of(serial_out, "watch | pH 6.31");
+    EXPECT(lines == 12, "firmware: %zu pH lines in 60 s, expected 12\n", lines);
+    EXPECT(count_of(serial_out, "s old)") > 0, "firmware: stale reading without its age\n");
+
+    console_command("W\nbogus 5\n");
+    EXPECT(count_of(serial_out, "not understood") == 1, "firmware: bad command accepted\n");
+    console_command("W\nlog off\n");
+    EXPECT(count_of(serial_out, "Serial always receives the full log") == 1, "firmware: Serial log muted\n");
+    console_command("W\noff\n");
+    size_t before = count_of(serial_out, "watch | pH");
+    for (int s = 0; s < 20; s++) {
+        watch_update();
+        host_advance_ms(1000);
+    }
+    EXPECT(count_of(serial_out, "watch | pH") == before, "firmware: lines after \"off\"\n");
+
+    // The prompt would hold up loop() and with it the end of a running dose
+    pump_init();
+    pump_start_manual(PumpId::PH_UP, 30.0f);
+    pump_update();
+    console_command("W\n");
+    EXPECT(count_of(serial_out, "a pump is running") == 1, "firmware: prompted while a pump ran\n");
+    pump_stop_all();
+    host_serial_set_output_hook(nullptr, nullptr);
+    printf("Firmware path: 'W' + \"ph 5\" on Serial -> %zu pH lines in 60 s, stale age shown, \"off\" stops them\n",
+           lines);
+}
+
+int main(int argc, char** argv) {
+    int minutes = argc > 1 ? atoi(argv[1]) : 60;
+    if (minutes < 1) minutes = 1;
+
+    parser();
+    cadence(minutes);
+    cost(minutes);
+    firmware_path();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,354 @@
+/**
+ * @file bench_websocket.cpp
+ * @brief Benchmark: WebSocket fan-out cost, rate caps and coalescing
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * 1. Protocol: the RFC 6455 sample handshake, subscription parsing from the
+ *    request path, rejected requests, and masked client frames.
+ * 2. Slow clients: on a 10 Hz reading stream with pump transitions, a
+ *    2 Hz subscriber, a subscriber whose socket takes nothing for 5 s and one
+ *    that takes 7 bytes per write. Each must see a valid message stream,
+ *    never hold more than one message per slot, and end on the latest value.
+ * 3. Alarms: two rules raised by the same reading must both reach a 2 Hz
+ *    subscriber, in order; a subscriber stalled past the alarm queue gets
+ *    the newest WEBSOCKET_ALARM_QUEUE and counts the rest as dropped.
+ * 4. Cost: readings published into hubs of 1, 8 and 32 subscribers, against
+ *    encoding the frame for every subscriber. Fails unless the shared
+ *    buffer is cheaper from 8 subscribers up.
+ *
+ *   bench_websocket [events]
+ */
+
+#include "websocket.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static int failures = 0;
+
+#define EXPECT(cond, ...)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FAIL: " __VA_ARGS__);                              \
+            fprintf(stderr, "  (%s)\n", #cond);                                 \
+            failures++;                                                         \
+        }                                                                       \
+    } while (0)
+
+//=============================================================================
+// CLIENT SIDE
+//=============================================================================
+
+/**
+ * @brief Subscriber output captured in memory
+ * accept_per_write limits bytes taken per call (0 = all); busy_until makes
+ * the socket take nothing before that time.
+ */
+struct capture_t {
+    std::vector<uint8_t> bytes;
+    size_t accept_per_write = 0;
+    uint32_t busy_until = 0;
+    uint32_t* clock = nullptr;
+};
+
+static int capture_write(void* ctx, const uint8_t* data, size_t len) {
+    capture_t* c = static_cast<capture_t*>(ctx);
+    if (c->clock && *c->clock < c->busy_until) return 0;
+    size_t n = c->accept_per_write && c->accept_per_write < len ? c->accept_per_write : len;
+    c->bytes.insert(c->bytes.end(), data, data + n);
+    return (int)n;
+}
+
+// Split a server byte stream into telemetry events; false on a framing error
+static bool decode_stream(const std::vector<uint8_t>& bytes, std::vector<telemetry_event_t>* events) {
+    size_t pos = 0;
+    while (pos < bytes.size()) {
+        if (bytes.size() - pos < 2 || bytes[pos] != (0x80 | WEBSOCKET_OP_BINARY) || bytes[pos + 1] >= 126) return false;
+        size_t len = bytes[pos + 1];
+        if (bytes.size() - pos - 2 < len) return false;
+        telemetry_event_t event;
+        size_t consumed = 0;
+        if (telemetry_decode(bytes.data() + pos + 2, len, &event, &consumed) != 1 || consumed != len) return false;
+        events->push_back(event);
+        pos += 2 + len;
+    }
+    return true;
+}
+
+static size_t encode_reading(uint32_t seq, uint32_t now, float ph, uint8_t* frame) {
+    telemetry_event_t event = telemetry_event_t();
+    event.type = TelemetryType::READING;
+    event.seq = seq;
+    event.timestamp = now;
+    event.reading.ph = ph;
+    event.reading.ec = 1.4f;
+    event.reading.volume = 40.0f;
+    event.reading.temperature = 22.5f;
+    event.reading.timestamp = now;
+    event.reading.valid = true;
+    return telemetry_encode(event, frame, TELEMETRY_FRAME_MAX);
+}
+
+//=============================================================================
+// PROTOCOL
+//=============================================================================
+
+static void protocol(void) {
+    static const char kRequest[] =
+        "GET /stream?events=reading,alarm&hz=2 HTTP/1.1\r\n"
+        "Host: hydro.local:81\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: keep-alive, Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+    char response[WEBSOCKET_RESPONSE_MAX];
+    websocket_subscription_t sub = {};
+
+    EXPECT(websocket_handshake(kRequest, 40, response, sizeof(response), &sub) == 0, "partial request not pending\n");
+    int n = websocket_handshake(kRequest, sizeof(kRequest) - 1, response, sizeof(response), &sub);
+    EXPECT(n > 0 && strstr(response, "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != nullptr,
+           "RFC 6455 sample accept key\n");
+    EXPECT(sub.events == (WEBSOCKET_EVENT_READING | WEBSOCKET_EVENT_ALARM) && sub.max_hz == 2,
+           "subscription from the path: events %02x hz %u\n", sub.events, sub.max_hz);
+
+    static const char* const kRejected[] = {
+        "GET /other HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        "GET /stream HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 8\r\n\r\n",
+        "GET /stream HTTP/1.1\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        "GET /stream?events=reading,level HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n\r\n",
+        "POST /stream HTTP/1.1\r\n\r\n",
+    };
+    for (const char* request : kRejected) {
+        EXPECT(websocket_handshake(request, strlen(request), response, sizeof(response), &sub) < 0,
+               "accepted: %.40s\n", request);
+    }
+
+    // Masked "events=pump&hz=5" text frame, then an unmasked one
+    const char* text = "events=pump&hz=5";
+    uint8_t frame[64] = {0x81, (uint8_t)(0x80 | strlen(text)), 0x12, 0x34, 0x56, 0x78};
+    for (size_t i = 0; i < strlen(text); i++) frame[6 + i] = (uint8_t)text[i] ^ frame[2 + (i & 3)];
+    websocket_frame_t decoded;
+    EXPECT(websocket_decode_frame(frame, 6 + strlen(text) - 1, &decoded) == 0, "partial frame not pending\n");
+    EXPECT(websocket_decode_frame(frame, 6 + strlen(text), &decoded) == (int)(6 + strlen(text)), "text frame\n");
+    websocket_subscription_t changed = sub;
+    EXPECT(websocket_parse_subscription(reinterpret_cast<const char*>(decoded.payload), decoded.length, &changed) &&
+               changed.events == WEBSOCKET_EVENT_PUMP && changed.max_hz == 5,
+           "subscription change message\n");
+    frame[1] &= 0x7F;
+    EXPECT(websocket_decode_frame(frame, sizeof(frame), &decoded) < 0, "unmasked client frame accepted\n");
+}
+
+//=============================================================================
+// SLOW CLIENTS
+//=============================================================================
+
+static void slow_clients(void) {
+    uint32_t now = 0;
+    websocket_subscriber_t subscribers[4];
+    websocket_hub_t hub;
+    websocket_hub_init(&hub, subscribers, 4);
+
+    capture_t fast, limited, stalled, trickle;
+    stalled.clock = &now;
+    stalled.busy_until = 5000;
+    trickle.accept_per_write = 7;
+    websocket_hub_subscribe(&hub, capture_write, &fast, {WEBSOCKET_EVENT_ALL, 0});
+    websocket_hub_subscribe(&hub, capture_write, &limited, {WEBSOCKET_EVENT_READING, 2});
+    websocket_hub_subscribe(&hub, capture_write, &stalled, {WEBSOCKET_EVENT_ALL, 0});
+    websocket_hub_subscribe(&hub, capture_write, &trickle, {WEBSOCKET_EVENT_ALL, 0});
+
+    // 10 s of 10 Hz readings, a pH Down run every 2 s, main loop every 10 ms,
+    // then 1 s without events for held-back messages to go out
+    uint32_t seq = 0;
+    uint32_t last_seq = 0;
+    uint32_t readings_published = 0, pumps_published = 0;
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    for (now = 0; now <= 11000; now += 10) {
+        if (now <= 10000 && now % 100 == 0) {
+            last_seq = seq;
+            size_t len = encode_reading(seq++, now, 6.0f + now / 100000.0f, frame);
+            telemetry_event_t event = telemetry_event_t();
+            event.type = TelemetryType::READING;
+            websocket_hub_publish(&hub, event, frame, len, now);
+            readings_published++;
+        }
+        if (now <= 10000 && now % 2000 == 1000) {
+            telemetry_event_t event = telemetry_event_t();
+            event.type = TelemetryType::PUMP;
+            event.seq = seq++;
+            event.timestamp = now;
+            event.pump = 1;
+            event.to_state = 1;
+            size_t len = telemetry_encode(event, frame, sizeof(frame));
+            websocket_hub_publish(&hub, event, frame, len, now);
+            pumps_published++;
+        }
+        websocket_hub_flush(&hub, now);
+    }
+
+    const char* names[] = {"as published", "hz=2 readings", "stalled 5 s", "7 bytes/write"};
+    capture_t* captures[] = {&fast, &limited, &stalled, &trickle};
+    for (int i = 0; i < 4; i++) {
+        const websocket_subscriber_t& s = subscribers[i];
+        std::vector<telemetry_event_t> events;
+        EXPECT(decode_stream(captures[i]->bytes, &events), "%s: broken message stream\n", names[i]);
+        uint32_t readings = 0, last_reading = 0;
+        for (const telemetry_event_t& e : events) {
+            if (e.type != TelemetryType::READING) continue;
+            readings++;
+            last_reading = e.seq;
+        }
+        uint32_t offered = readings_published + (s.events & WEBSOCKET_EVENT_PUMP ? pumps_published : 0);
+        printf("websocket bench: %-13s %3u readings, %u pump events, %2u coalesced, last reading seq %u of %u\n",
+               names[i], readings, (uint32_t)events.size() - readings, s.coalesced, last_reading, last_seq);
+        EXPECT(last_reading == last_seq, "%s: did not end on the latest reading\n", names[i]);
+        EXPECT(events.size() + s.coalesced == offered && s.pending == 0 && s.tail_len == 0,
+               "%s: %zu sent + %u coalesced of %u offered\n", names[i], events.size(), s.coalesced, offered);
+    }
+    EXPECT(subscribers[0].coalesced == 0 && subscribers[3].coalesced == 0, "a keeping-up subscriber coalesced\n");
+    EXPECT(subscribers[1].sent <= 2 * 11 + 1, "hz=2 sent %u readings in 11 s\n", subscribers[1].sent);
+    EXPECT(subscribers[2].coalesced >= 49, "stalled subscriber queued instead of coalescing\n");
+}
+
+//=============================================================================
+// ALARMS
+//=============================================================================
+
+static size_t encode_alarm(uint32_t seq, uint32_t now, const char* name, uint8_t* frame) {
+    telemetry_event_t event = telemetry_event_t();
+    event.type = TelemetryType::ALARM;
+    event.seq = seq;
+    event.timestamp = now;
+    strncpy(event.alarm_name, name, sizeof(event.alarm_name) - 1);
+    event.raised = true;
+    return telemetry_encode(event, frame, TELEMETRY_FRAME_MAX);
+}
+
+static void alarm_queue(void) {
+    uint32_t now = 0;
+    websocket_subscriber_t subscribers[2];
+    websocket_hub_t hub;
+    websocket_hub_init(&hub, subscribers, 2);
+
+    capture_t limited, stalled;
+    stalled.clock = &now;
+    stalled.busy_until = 5000;
+    websocket_hub_subscribe(&hub, capture_write, &limited, {WEBSOCKET_EVENT_READING | WEBSOCKET_EVENT_ALARM, 2});
+    websocket_hub_subscribe(&hub, capture_write, &stalled, {WEBSOCKET_EVENT_ALARM, 0});
+
+    // A reading at 1 s raises ph_low and ec_low 10 ms later; the 2 Hz
+    // subscriber has just sent the reading
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+    uint32_t seq = 0;
+    now = 1000;
+    telemetry_event_t reading = telemetry_event_t();
+    reading.type = TelemetryType::READING;
+    websocket_hub_publish(&hub, reading, frame, encode_reading(seq++, now, 5.2f, frame), now);
+    now += 10;
+    telemetry_event_t alarm = telemetry_event_t();
+    alarm.type = TelemetryType::ALARM;
+    websocket_hub_publish(&hub, alarm, frame, encode_alarm(seq++, now, "ph_low", frame), now);
+    websocket_hub_publish(&hub, alarm, frame, encode_alarm(seq++, now, "ec_low", frame), now);
+
+    // More alarms than the queue holds while the other socket takes nothing
+    const uint32_t extra = WEBSOCKET_ALARM_QUEUE + 3;
+    for (uint32_t i = 0; i < extra; i++) {
+        now += 100;
+        websocket_hub_publish(&hub, alarm, frame, encode_alarm(seq++, now, "flap", frame), now);
+    }
+    for (now += 10; now <= 6000; now += 10) websocket_hub_flush(&hub, now);
+
+    std::vector<telemetry_event_t> events;
+    EXPECT(decode_stream(limited.bytes, &events), "hz=2 alarms: broken message stream\n");
+    bool both = events.size() >= 3 && strcmp(events[1].alarm_name, "ph_low") == 0 &&
+                strcmp(events[2].alarm_name, "ec_low") == 0;
+    EXPECT(both, "hz=2: the two alarms of one reading did not both arrive in order\n");
+    size_t limited_alarms = events.empty() ? 0 : events.size() - 1;
+    EXPECT(limited_alarms == 2 + extra && subscribers[0].alarms_dropped == 0,
+           "hz=2: %zu of %u alarms, %u dropped\n", limited_alarms, 2 + extra, subscribers[0].alarms_dropped);
+
+    events.clear();
+    EXPECT(decode_stream(stalled.bytes, &events), "stalled alarms: broken message stream\n");
+    const websocket_subscriber_t& s = subscribers[1];
+    bool newest = events.size() == WEBSOCKET_ALARM_QUEUE && events.back().seq == seq - 1;
+    for (size_t i = 1; newest && i < events.size(); i++) newest = events[i].seq == events[i - 1].seq + 1;
+    EXPECT(newest && s.alarms_dropped == 2 + extra - WEBSOCKET_ALARM_QUEUE,
+           "stalled: %zu alarms received, %u dropped of %u\n", events.size(), s.alarms_dropped, 2 + extra);
+    printf("websocket bench: alarms        hz=2 got %zu of %u, stalled 5 s got %zu, %u dropped past a %u-alarm queue\n",
+           limited_alarms, 2 + extra, events.size(), s.alarms_dropped, WEBSOCKET_ALARM_QUEUE);
+}
+
+//=============================================================================
+// FAN-OUT COST
+//=============================================================================
+
+static int count_write(void* ctx, const uint8_t* data, size_t len) {
+    uint8_t* last = static_cast<uint8_t*>(ctx);
+    memcpy(last, data, len);                             // Stands in for the socket copy
+    return (int)len;
+}
+
+static bool fan_out(int clients, long events) {
+    static uint8_t sinks[32][WEBSOCKET_MESSAGE_MAX];
+    std::vector<websocket_subscriber_t> subscribers(clients);
+    websocket_hub_t hub;
+    websocket_hub_init(&hub, subscribers.data(), clients);
+    for (int i = 0; i < clients; i++) websocket_hub_subscribe(&hub, count_write, sinks[i], {WEBSOCKET_EVENT_ALL, 0});
+
+    telemetry_event_t event = telemetry_event_t();
+    event.type = TelemetryType::READING;
+    uint8_t frame[TELEMETRY_FRAME_MAX];
+
+    // Shared: encode once, wrap once, write from the slot
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < events; i++) {
+        size_t len = encode_reading((uint32_t)i, (uint32_t)i, 6.0f + (i % 1000) / 1000.0f, frame);
+        websocket_hub_publish(&hub, event, frame, len, (uint32_t)i);
+    }
+    double shared = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / events;
+
+    // Per client: encode and frame the event for every subscriber
+    start = std::chrono::steady_clock::now();
+    for (long i = 0; i < events; i++) {
+        for (int c = 0; c < clients; c++) {
+            uint8_t message[WEBSOCKET_MESSAGE_MAX];
+            size_t len = encode_reading((uint32_t)i, (uint32_t)i, 6.0f + (i % 1000) / 1000.0f, message + 2);
+            size_t header = websocket_encode_header(WEBSOCKET_OP_BINARY, len, message);
+            count_write(sinks[c], message, header + len);
+        }
+    }
+    double per_client =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / events;
+
+    uint32_t sent = 0;
+    for (const websocket_subscriber_t& s : subscribers) sent += s.sent;
+    EXPECT(sent == (uint32_t)(events * clients), "%d clients: %u of %ld messages sent\n", clients, sent,
+           events * clients);
+    printf("websocket bench: %2d clients: shared %7.1f ns/event (%5.1f ns/client), encode per client %7.1f ns/event\n",
+           clients, shared, shared / clients, per_client);
+    return clients < 8 || shared < per_client;
+}
+
+int main(int argc, char** argv) {
+    long events = argc > 1 ? atol(argv[1]) : 200000;
+    if (events < 1) events = 1;
+
+    protocol();
+    slow_clients();
+    alarm_queue();
+    for (int clients : {1, 8, 32}) {
+        if (!fan_out(clients, events)) {
+            fprintf(stderr, "FAIL: shared fan-out not cheaper than per-client encoding at %d clients\n", clients);
+            failures++;
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
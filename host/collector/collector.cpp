@@ -0,0 +1,768 @@
+/**
+ * @file collector.cpp
+ * @brief Host telemetry collector: epoll event loop, decode workers, columnar writer
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "collector.h"
+#include "telemetry.h"
+#include "state_machine.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+static_assert(2 * TELEMETRY_FRAME_MAX <= COLLECTOR_LINE_MAX, "frame carry must hold a partial and a whole frame");
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+enum class ChunkKind : uint8_t {
+    DATA,
+    CONNECTED,
+    DISCONNECTED
+};
+
+/**
+ * @brief One socket read (or connection marker) on its way to a worker
+ */
+struct chunk_t {
+    uint32_t device;
+    uint32_t rx_ms;
+    uint16_t len;
+    ChunkKind kind;
+    uint8_t data[COLLECTOR_CHUNK_SIZE];
+};
+
+enum class LinkState : uint8_t {
+    IDLE,                                // Waiting for retry_at
+    CONNECTING,
+    CONNECTED
+};
+
+/**
+ * @brief Event-loop side of a device
+ */
+struct link_t {
+    int fd;
+    LinkState state;
+    uint32_t retry_at;
+    sockaddr_in addr;
+};
+
+/**
+ * @brief Worker side of a device: stream decoder and staged rows
+ */
+struct device_sink_t {
+    uint8_t carry[COLLECTOR_LINE_MAX];   // Partial frame or line from the previous chunk
+    uint16_t carry_len;
+    bool skipping_line;                  // Inside an over-long console line
+    bool in_garbage;                     // Resyncing; counts one bad run once
+    bool have_seq;
+    uint32_t next_seq;
+
+    uint16_t rows;
+    uint32_t ts[COLLECTOR_FLUSH_ROWS];
+    float ph[COLLECTOR_FLUSH_ROWS];
+    float ec[COLLECTOR_FLUSH_ROWS];
+    float volume[COLLECTOR_FLUSH_ROWS];
+    float temp[COLLECTOR_FLUSH_ROWS];
+
+    uint16_t event_len;
+    char events[COLLECTOR_EVENT_BUFFER];
+};
+
+struct worker_t {
+    std::mutex lock;
+    std::condition_variable wake;
+    std::vector<chunk_t*> queue;
+    std::vector<chunk_t*> free_chunks;
+    bool stopping = false;
+    std::thread thread;
+};
+
+struct collector_t {
+    collector_config_t config;
+    std::vector<collector_device_t> devices;
+    std::vector<std::string> dirs;
+    std::vector<link_t> links;
+    std::vector<device_sink_t> sinks;
+    std::vector<worker_t> workers;
+
+    int epoll_fd = -1;
+    int stop_fd = -1;
+    std::atomic<bool> stop_requested{false};
+
+    std::atomic<uint64_t> bytes{0}, readings{0}, events{0}, bad_frames{0}, seq_gaps{0}, lines_ignored{0};
+    std::atomic<uint64_t> connects{0}, disconnects{0};
+    std::atomic<uint32_t> connected{0};
+
+    explicit collector_t(size_t worker_count) : workers(worker_count) {}
+};
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+static uint32_t monotonic_ms(void) {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000u + ts.tv_nsec / 1000000);
+}
+
+static inline bool time_reached(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+static worker_t& worker_of(collector_t* c, uint32_t device) {
+    return c->workers[device % c->workers.size()];
+}
+
+static bool valid_device_name(const std::string& name) {
+    if (name.empty() || name == "." || name == "..") return false;
+    for (char ch : name) {
+        if (!isalnum((unsigned char)ch) && ch != '_' && ch != '-' && ch != '.') return false;
+    }
+    return true;
+}
+
+static bool append_file(const std::string& path, const void* data, size_t len) {
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        p += n;
+        len -= (size_t)n;
+    }
+    close(fd);
+    return len == 0;
+}
+
+//=============================================================================
+// WORKER: COLUMNAR WRITER
+//=============================================================================
+
+static void flush_rows(collector_t* c, uint32_t device) {
+    device_sink_t& s = c->sinks[device];
+    if (s.rows > 0) {
+        const std::string& dir = c->dirs[device];
+        append_file(dir + "/ts.u32", s.ts, s.rows * sizeof(uint32_t));
+        append_file(dir + "/ph.f32", s.ph, s.rows * sizeof(float));
+        append_file(dir + "/ec.f32", s.ec, s.rows * sizeof(float));
+        append_file(dir + "/volume.f32", s.volume, s.rows * sizeof(float));
+        append_file(dir + "/temp.f32", s.temp, s.rows * sizeof(float));
+        s.rows = 0;
+    }
+    if (s.event_len > 0) {
+        append_file(c->dirs[device] + "/events.log", s.events, s.event_len);
+        s.event_len = 0;
+    }
+}
+
+static void stage_reading(collector_t* c, uint32_t device, uint32_t ts, const sensor_readings_t& r) {
+    device_sink_t& s = c->sinks[device];
+    s.ts[s.rows] = ts;
+    s.ph[s.rows] = r.ph;
+    s.ec[s.rows] = r.ec;
+    s.volume[s.rows] = r.volume;
+    s.temp[s.rows] = r.temperature;
+    if (++s.rows == COLLECTOR_FLUSH_ROWS) flush_rows(c, device);
+    c->readings.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void stage_event(collector_t* c, uint32_t device, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static void stage_event(collector_t* c, uint32_t device, const char* format, ...) {
+    char line[160];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(line, sizeof(line) - 1, format, args);
+    va_end(args);
+    if (n < 0) return;
+    if ((size_t)n > sizeof(line) - 2) n = sizeof(line) - 2;
+    line[n++] = '\n';
+
+    device_sink_t& s = c->sinks[device];
+    if (s.event_len + (size_t)n > COLLECTOR_EVENT_BUFFER) flush_rows(c, device);
+    memcpy(s.events + s.event_len, line, n);
+    s.event_len += n;
+}
+
+//=============================================================================
+// WORKER: BINARY FRAMES
+//=============================================================================
+
+static void handle_frame(collector_t* c, uint32_t device, const telemetry_event_t& event) {
+    device_sink_t& s = c->sinks[device];
+    if (s.have_seq && event.seq != s.next_seq) {
+        if ((int32_t)(event.seq - s.next_seq) > 0) {
+            uint32_t missing = event.seq - s.next_seq;
+            c->seq_gaps.fetch_add(missing, std::memory_order_relaxed);
+            stage_event(c, device, "%lu GAP %lu frames", (unsigned long)event.timestamp, (unsigned long)missing);
+        } else {
+            stage_event(c, device, "%lu RESTART seq %lu", (unsigned long)event.timestamp,
+                        (unsigned long)event.seq);
+        }
+    }
+    s.have_seq = true;
+    s.next_seq = event.seq + 1;
+
+    switch (event.type) {
+        case TelemetryType::READING:
+            stage_reading(c, device, event.timestamp, event.reading);
+            break;
+        case TelemetryType::PUMP:
+            stage_event(c, device, "%lu PUMP %u %s -> %s", (unsigned long)event.timestamp, event.pump,
+                        pump_state_to_string(static_cast<PumpState>(event.from_state)),
+                        pump_state_to_string(static_cast<PumpState>(event.to_state)));
+            c->events.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case TelemetryType::ALARM:
+            stage_event(c, device, "%lu ALARM %s %s %s value=%.3f", (unsigned long)event.timestamp,
+                        event.raised ? "RAISED" : "CLEARED", event.alarm_name,
+                        alarm_severity_to_string(static_cast<AlarmSeverity>(event.severity)), event.value);
+            c->events.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+}
+
+/**
+ * @brief Decode whole frames from a buffer
+ * @return Bytes consumed (the rest is an incomplete frame)
+ */
+static size_t decode_frames(collector_t* c, uint32_t device, const uint8_t* data, size_t len) {
+    device_sink_t& s = c->sinks[device];
+    size_t pos = 0;
+    while (pos < len) {
+        telemetry_event_t event;
+        size_t consumed = 0;
+        int result = telemetry_decode(data + pos, len - pos, &event, &consumed);
+        if (result == 0) break;
+        if (result > 0) {
+            s.in_garbage = false;
+            handle_frame(c, device, event);
+        } else if (!s.in_garbage) {
+            s.in_garbage = true;
+            c->bad_frames.fetch_add(1, std::memory_order_relaxed);
+        }
+        pos += consumed;
+    }
+    return pos;
+}
+
+/**
+ * @brief Feed one chunk to a device's frame decoder
+ * A frame split across reads is reassembled in the carry buffer, which holds
+ * less than one frame between chunks.
+ */
+static void feed_binary(collector_t* c, uint32_t device, const uint8_t* data, size_t len) {
+    device_sink_t& s = c->sinks[device];
+    size_t pos = 0;
+    if (s.carry_len > 0) {
+        size_t old = s.carry_len;
+        size_t take = std::min(len, sizeof(s.carry) - old);
+        memcpy(s.carry + old, data, take);
+        s.carry_len += take;
+        size_t used = decode_frames(c, device, s.carry, s.carry_len);
+        if (used < old) {
+            // Still waiting for the rest of the frame (all of data is in the carry)
+            memmove(s.carry, s.carry + used, s.carry_len - used);
+            s.carry_len -= used;
+            return;
+        }
+        pos = used - old;
+        s.carry_len = 0;
+    }
+    pos += decode_frames(c, device, data + pos, len - pos);
+    memcpy(s.carry, data + pos, len - pos);
+    s.carry_len = (uint16_t)(len - pos);
+}
+
+//=============================================================================
+// WORKER: CONSOLE TEXT
+//=============================================================================
+
+static void handle_line(collector_t* c, uint32_t device, char* line, uint32_t rx_ms) {
+    // "[ms] message [WiFi]" from Debug, or a bare line from Serial
+    uint32_t ts = rx_ms;
+    char* text = line;
+    if (*text == '[') {
+        char* end = nullptr;
+        unsigned long ms = strtoul(text + 1, &end, 10);
+        if (end != text + 1 && *end == ']') {
+            ts = (uint32_t)ms;
+            text = end + 1;
+            while (*text == ' ') text++;
+        }
+    }
+
+    sensor_readings_t reading;
+    float volume;
+    char unit;
+    if (sscanf(text, "%f | %f | %f %c", &reading.ph, &reading.ec, &volume, &unit) == 4 && unit == 'L') {
+        reading.volume = volume;
+        reading.temperature = NAN;
+        reading.timestamp = ts;
+        reading.valid = true;
+        stage_reading(c, device, ts, reading);
+        return;
+    }
+
+    char action[8], name[ALARM_NAME_LEN], severity[8];
+    float value;
+    if (sscanf(text, "ALARM %7s %15s [%7[a-z]] value=%f", action, name, severity, &value) == 4 &&
+        (strcmp(action, "RAISED") == 0 || strcmp(action, "CLEARED") == 0)) {
+        stage_event(c, device, "%lu ALARM %s %s %s value=%.3f", (unsigned long)ts, action, name, severity, value);
+        c->events.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    c->lines_ignored.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void feed_text(collector_t* c, uint32_t device, const uint8_t* data, size_t len, uint32_t rx_ms) {
+    device_sink_t& s = c->sinks[device];
+    for (size_t i = 0; i < len; i++) {
+        uint8_t ch = data[i];
+        if (ch == '\n') {
+            if (!s.skipping_line && s.carry_len > 0) {
+                s.carry[s.carry_len] = '\0';
+                handle_line(c, device, reinterpret_cast<char*>(s.carry), rx_ms);
+            } else if (s.skipping_line) {
+                c->lines_ignored.fetch_add(1, std::memory_order_relaxed);
+            }
+            s.carry_len = 0;
+            s.skipping_line = false;
+        } else if (ch == '\r' || ch == 0) {
+            continue;
+        } else if ((size_t)s.carry_len + 1 < sizeof(s.carry)) {
+            s.carry[s.carry_len++] = ch;
+        } else {
+            s.skipping_line = true;
+        }
+    }
+}
+
+//=============================================================================
+// WORKER THREAD
+//=============================================================================
+
+static void process_chunk(collector_t* c, const chunk_t* chunk) {
+    uint32_t device = chunk->device;
+    device_sink_t& s = c->sinks[device];
+    switch (chunk->kind) {
+        case ChunkKind::CONNECTED:
+            s.carry_len = 0;
+            s.skipping_line = false;
+            s.in_garbage = false;
+            stage_event(c, device, "- CONNECT");
+            break;
+        case ChunkKind::DISCONNECTED:
+            stage_event(c, device, "- DISCONNECT");
+            break;
+        case ChunkKind::DATA:
+            if (c->devices[device].protocol == CollectorProtocol::BINARY) {
+                feed_binary(c, device, chunk->data, chunk->len);
+            } else {
+                feed_text(c, device, chunk->data, chunk->len, chunk->rx_ms);
+            }
+            break;
+    }
+}
+
+static void worker_main(collector_t* c, size_t index) {
+    worker_t& w = c->workers[index];
+    std::vector<chunk_t*> batch;
+    uint32_t last_flush = monotonic_ms();
+
+    for (;;) {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(w.lock);
+            w.wake.wait_for(lock, std::chrono::milliseconds(c->config.flush_ms),
+                            [&] { return !w.queue.empty() || w.stopping; });
+            batch.swap(w.queue);
+            stopping = w.stopping;
+        }
+
+        bool drained = batch.empty();                    // Drain the queue before stopping
+        for (chunk_t* chunk : batch) process_chunk(c, chunk);
+        if (!drained) {
+            std::lock_guard<std::mutex> lock(w.lock);
+            w.free_chunks.insert(w.free_chunks.end(), batch.begin(), batch.end());
+            batch.clear();
+        }
+
+        // Every pass: under continuous load the queue is never empty
+        uint32_t now = monotonic_ms();
+        if ((stopping && drained) || now - last_flush >= c->config.flush_ms) {
+            for (uint32_t d = (uint32_t)index; d < c->devices.size(); d += (uint32_t)c->workers.size()) {
+                flush_rows(c, d);
+            }
+            last_flush = now;
+        }
+        if (stopping && drained) return;
+    }
+}
+
+//=============================================================================
+// EVENT LOOP
+//=============================================================================
+
+static chunk_t* take_chunk(worker_t& w) {
+    std::lock_guard<std::mutex> lock(w.lock);
+    if ((int)w.queue.size() >= COLLECTOR_QUEUE_MAX) return nullptr;    // Worker behind: pause reads
+    if (w.free_chunks.empty()) return new chunk_t;
+    chunk_t* chunk = w.free_chunks.back();
+    w.free_chunks.pop_back();
+    return chunk;
+}
+
+static void give_chunk(worker_t& w, chunk_t* chunk) {
+    {
+        std::lock_guard<std::mutex> lock(w.lock);
+        w.queue.push_back(chunk);
+    }
+    w.wake.notify_one();
+}
+
+static void post_marker(collector_t* c, uint32_t device, ChunkKind kind) {
+    worker_t& w = worker_of(c, device);
+    chunk_t* chunk;
+    {
+        std::lock_guard<std::mutex> lock(w.lock);
+        if (w.free_chunks.empty()) {
+            chunk = new chunk_t;                     // Markers are never refused
+        } else {
+            chunk = w.free_chunks.back();
+            w.free_chunks.pop_back();
+        }
+    }
+    chunk->device = device;
+    chunk->kind = kind;
+    chunk->len = 0;
+    chunk->rx_ms = 0;
+    give_chunk(w, chunk);
+}
+
+static void close_link(collector_t* c, uint32_t device, uint32_t now) {
+    link_t& link = c->links[device];
+    if (link.fd >= 0) {
+        epoll_ctl(c->epoll_fd, EPOLL_CTL_DEL, link.fd, nullptr);
+        close(link.fd);
+    }
+    if (link.state == LinkState::CONNECTED) {
+        c->connected.fetch_sub(1, std::memory_order_relaxed);
+        c->disconnects.fetch_add(1, std::memory_order_relaxed);
+        post_marker(c, device, ChunkKind::DISCONNECTED);
+    }
+    link.fd = -1;
+    link.state = LinkState::IDLE;
+    link.retry_at = now + c->config.reconnect_ms;
+}
+
+static void start_connect(collector_t* c, uint32_t device, uint32_t now) {
+    link_t& link = c->links[device];
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        link.retry_at = now + c->config.reconnect_ms;
+        return;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    link.fd = fd;
+    link.state = LinkState::CONNECTING;
+    epoll_event ev = {};
+    ev.events = EPOLLOUT;
+    ev.data.u32 = device;
+    if (epoll_ctl(c->epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        close_link(c, device, now);
+        return;
+    }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&link.addr), sizeof(link.addr)) != 0 &&
+        errno != EINPROGRESS) {
+        close_link(c, device, now);
+    }
+}
+
+static void finish_connect(collector_t* c, uint32_t device, uint32_t now) {
+    link_t& link = c->links[device];
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    if (getsockopt(link.fd, SOL_SOCKET, SO_ERROR, &err, &err_len) != 0 || err != 0) {
+        close_link(c, device, now);
+        return;
+    }
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.u32 = device;
+    epoll_ctl(c->epoll_fd, EPOLL_CTL_MOD, link.fd, &ev);
+    link.state = LinkState::CONNECTED;
+    c->connected.fetch_add(1, std::memory_order_relaxed);
+    c->connects.fetch_add(1, std::memory_order_relaxed);
+    post_marker(c, device, ChunkKind::CONNECTED);
+}
+
+/**
+ * @brief Read what a device has sent (a few chunks per wakeup, for fairness)
+ * @return false if the read was deferred because the device's worker is behind
+ */
+static bool read_link(collector_t* c, uint32_t device, uint32_t now) {
+    worker_t& w = worker_of(c, device);
+    for (int reads = 0; reads < 4; reads++) {
+        chunk_t* chunk = take_chunk(w);
+        if (!chunk) return false;
+        ssize_t n = recv(c->links[device].fd, chunk->data, sizeof(chunk->data), 0);
+        if (n > 0) {
+            chunk->device = device;
+            chunk->kind = ChunkKind::DATA;
+            chunk->len = (uint16_t)n;
+            chunk->rx_ms = now;
+            c->bytes.fetch_add((uint64_t)n, std::memory_order_relaxed);
+            give_chunk(w, chunk);
+            if ((size_t)n < sizeof(chunk->data)) return true;
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(w.lock);
+            w.free_chunks.push_back(chunk);
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return true;
+        close_link(c, device, now);                  // EOF or error
+        return true;
+    }
+    return true;
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+collector_t* collector_create(const collector_config_t& config, const std::vector<collector_device_t>& devices,
+                              std::string* error) {
+    int worker_count = config.workers < 1 ? 1 : config.workers;
+    collector_t* c = new collector_t((size_t)worker_count);
+    c->config = config;
+    if (c->config.flush_ms == 0) c->config.flush_ms = 1000;
+    c->devices = devices;
+    c->links.resize(devices.size());
+    c->sinks.resize(devices.size());
+
+    mkdir(config.out_dir.c_str(), 0755);
+    for (size_t i = 0; i < devices.size(); i++) {
+        const collector_device_t& d = devices[i];
+        if (!valid_device_name(d.name)) {
+            *error = "invalid device name '" + d.name + "'";
+            collector_destroy(c);
+            return nullptr;
+        }
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(d.host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr) {
+            *error = d.name + ": cannot resolve " + d.host;
+            collector_destroy(c);
+            return nullptr;
+        }
+        link_t& link = c->links[i];
+        link.fd = -1;
+        link.state = LinkState::IDLE;
+        link.retry_at = 0;
+        memcpy(&link.addr, result->ai_addr, sizeof(link.addr));
+        link.addr.sin_port = htons(d.port);
+        freeaddrinfo(result);
+
+        std::string dir = config.out_dir + "/" + d.name;
+        if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+            *error = dir + ": " + strerror(errno);
+            collector_destroy(c);
+            return nullptr;
+        }
+        c->dirs.push_back(dir);
+        memset(&c->sinks[i], 0, sizeof(device_sink_t));
+    }
+
+    c->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    c->stop_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (c->epoll_fd < 0 || c->stop_fd < 0) {
+        *error = std::string("epoll/eventfd: ") + strerror(errno);
+        collector_destroy(c);
+        return nullptr;
+    }
+    epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.u32 = UINT32_MAX;
+    epoll_ctl(c->epoll_fd, EPOLL_CTL_ADD, c->stop_fd, &ev);
+    return c;
+}
+
+/**
+ * @brief Run the event loop on the calling thread until collector_stop
+ * Workers are started here and joined (after a final flush) before returning.
+ */
+bool collector_run(collector_t* c) {
+    if (c == nullptr || c->epoll_fd < 0) return false;
+    for (size_t i = 0; i < c->workers.size(); i++) {
+        c->workers[i].thread = std::thread(worker_main, c, i);
+    }
+
+    epoll_event events[256];
+    while (!c->stop_requested.load(std::memory_order_acquire)) {
+        uint32_t now = monotonic_ms();
+        for (uint32_t d = 0; d < c->links.size(); d++) {
+            if (c->links[d].state == LinkState::IDLE && time_reached(now, c->links[d].retry_at)) {
+                start_connect(c, d, now);
+            }
+        }
+
+        int n = epoll_wait(c->epoll_fd, events, 256, 50);
+        now = monotonic_ms();
+        bool deferred = false;
+        for (int i = 0; i < n; i++) {
+            uint32_t device = events[i].data.u32;
+            if (device == UINT32_MAX) continue;     // stop_fd: loop condition exits
+            link_t& link = c->links[device];
+            if (link.state == LinkState::CONNECTING) {
+                finish_connect(c, device, now);
+            } else if (link.state == LinkState::CONNECTED) {
+                if (events[i].events & EPOLLIN) {
+                    if (!read_link(c, device, now)) deferred = true;
+                } else if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+                    close_link(c, device, now);
+                }
+            }
+        }
+        if (deferred) usleep(200);                   // Let workers catch up (level-triggered: data stays)
+    }
+
+    uint32_t now = monotonic_ms();
+    for (uint32_t d = 0; d < c->links.size(); d++) {
+        if (c->links[d].fd >= 0) close_link(c, d, now);
+    }
+    for (worker_t& w : c->workers) {
+        {
+            std::lock_guard<std::mutex> lock(w.lock);
+            w.stopping = true;
+        }
+        w.wake.notify_one();
+    }
+    for (worker_t& w : c->workers) {
+        if (w.thread.joinable()) w.thread.join();
+    }
+    return true;
+}
+
+void collector_stop(collector_t* c) {
+    c->stop_requested.store(true, std::memory_order_release);
+    uint64_t one = 1;
+    ssize_t ignored = write(c->stop_fd, &one, sizeof(one));
+    (void)ignored;
+}
+
+collector_stats_t collector_get_stats(const collector_t* c) {
+    collector_stats_t stats;
+    stats.bytes = c->bytes.load(std::memory_order_relaxed);
+    stats.readings = c->readings.load(std::memory_order_relaxed);
+    stats.events = c->events.load(std::memory_order_relaxed);
+    stats.bad_frames = c->bad_frames.load(std::memory_order_relaxed);
+    stats.seq_gaps = c->seq_gaps.load(std::memory_order_relaxed);
+    stats.lines_ignored = c->lines_ignored.load(std::memory_order_relaxed);
+    stats.connects = c->connects.load(std::memory_order_relaxed);
+    stats.disconnects = c->disconnects.load(std::memory_order_relaxed);
+    stats.connected = c->connected.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void collector_destroy(collector_t* c) {
+    if (c == nullptr) return;
+    for (link_t& link : c->links) {
+        if (link.fd >= 0) close(link.fd);
+    }
+    for (worker_t& w : c->workers) {
+        for (chunk_t* chunk : w.queue) delete chunk;
+        for (chunk_t* chunk : w.free_chunks) delete chunk;
+    }
+    if (c->epoll_fd >= 0) close(c->epoll_fd);
+    if (c->stop_fd >= 0) close(c->stop_fd);
+    delete c;
+}
+
+/**
+ * @brief Memory the collector keeps per device once connected
+ * Chunks in flight are shared by all devices of a worker and bounded by
+ * COLLECTOR_QUEUE_MAX; kernel socket buffers are not counted.
+ */
+size_t collector_connection_bytes(void) {
+    return sizeof(link_t) + sizeof(device_sink_t) + sizeof(collector_device_t) + sizeof(std::string);
+}
+
+bool collector_load_devices(const char* path, std::vector<collector_device_t>* devices, std::string* error) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        *error = std::string(path) + ": " + strerror(errno);
+        return false;
+    }
+    char line[256];
+    int line_no = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_no++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char name[64], endpoint[160], protocol[16] = "binary";
+        int fields = sscanf(line, "%63s %159s %15s", name, endpoint, protocol);
+        if (fields <= 0) continue;
+
+        collector_device_t device;
+        char* colon = fields >= 2 ? strrchr(endpoint, ':') : nullptr;
+        long port = colon ? strtol(colon + 1, nullptr, 10) : 0;
+        if (colon == nullptr || port <= 0 || port > 65535) {
+            *error = std::string(path) + ":" + std::to_string(line_no) + ": expected 'name host:port [binary|telnet]'";
+            ok = false;
+            break;
+        }
+        *colon = '\0';
+        device.name = name;
+        device.host = endpoint;
+        device.port = (uint16_t)port;
+        if (strcmp(protocol, "binary") == 0) {
+            device.protocol = CollectorProtocol::BINARY;
+        } else if (strcmp(protocol, "telnet") == 0) {
+            device.protocol = CollectorProtocol::TELNET;
+        } else {
+            *error = std::string(path) + ":" + std::to_string(line_no) + ": unknown protocol '" + protocol + "'";
+            ok = false;
+            break;
+        }
+        devices->push_back(device);
+    }
+    fclose(file);
+    return ok;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file collector.h
+ * @brief Host telemetry collector for a fleet of controllers
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * One event loop thread (epoll, nonblocking sockets) keeps a connection to
+ * every device and hands the received bytes to a small set of worker
+ * threads. Devices are sharded over the workers, so one device's bytes are
+ * always decoded in order by the same worker and its files have a single
+ * writer (no locking on the write path).
+ *
+ * Two wire formats are accepted per device:
+ * - BINARY: telemetry frames from TELEMETRY_PORT (telemetry.h), decoded with
+ *   the firmware codec; sequence gaps are detected and logged
+ * - TELNET: console text ("[ms] ALARM RAISED name [warn] value=..." lines and
+ *   "ph | ec | volume L" reading lines, e.g. from a serial-over-TCP bridge)
+ *
+ * Readings are normalised to sensor_readings_t and appended to per-device
+ * columnar files under <out_dir>/<device>/:
+ *
+ *   ts.u32      device millis() (BINARY) or collector receive ms (TELNET)
+ *   ph.f32  ec.f32  volume.f32  temp.f32   (NaN where the path lacks a value)
+ *   events.log  pump transitions, alarms, sequence gaps, connects
+ *
+ * Columns are little-endian arrays appended together per flush; after a
+ * crash a reader truncates to the shortest column.
+ */
+
+#ifndef HOST_COLLECTOR_H
+#define HOST_COLLECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//=============================================================================
+// COLLECTOR CONFIGURATION
+//=============================================================================
+
+constexpr size_t COLLECTOR_CHUNK_SIZE = 4096;        // One socket read handed to a worker
+constexpr int COLLECTOR_QUEUE_MAX = 256;             // Chunks queued per worker before reads pause
+constexpr int COLLECTOR_FLUSH_ROWS = 128;            // Readings staged per device between flushes
+constexpr size_t COLLECTOR_EVENT_BUFFER = 512;       // events.log bytes staged per device
+constexpr size_t COLLECTOR_LINE_MAX = 256;           // Longest console line kept (longer are skipped)
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+enum class CollectorProtocol {
+    BINARY,
+    TELNET
+};
+
+struct collector_device_t {
+    std::string name;                    // Directory name under out_dir ([A-Za-z0-9_.-])
+    std::string host;
+    uint16_t port;
+    CollectorProtocol protocol;
+};
+
+struct collector_config_t {
+    std::string out_dir;
+    int workers = 2;
+    uint32_t reconnect_ms = 2000;        // Delay before redialling a failed/closed device
+    uint32_t flush_ms = 1000;            // Staged rows reach disk at least this often
+};
+
+/**
+ * @brief Counters since collector_create (all devices)
+ */
+struct collector_stats_t {
+    uint64_t bytes;
+    uint64_t readings;
+    uint64_t events;                     // Pump transitions and alarms
+    uint64_t bad_frames;                 // Garbage runs skipped while resyncing
+    uint64_t seq_gaps;                   // Frames missing from a device's sequence
+    uint64_t lines_ignored;              // Console lines that are neither reading nor alarm
+    uint64_t connects;
+    uint64_t disconnects;
+    uint32_t connected;                  // Devices connected right now
+};
+
+struct collector_t;
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// nullptr with *error set if a device cannot be resolved or its directory created
+collector_t* collector_create(const collector_config_t& config, const std::vector<collector_device_t>& devices,
+                              std::string* error);
+bool collector_run(collector_t* collector);              // Blocks until collector_stop; flushes on exit
+void collector_stop(collector_t* collector);             // Any thread, async-signal-safe
+collector_stats_t collector_get_stats(const collector_t* collector);
+void collector_destroy(collector_t* collector);
+
+size_t collector_connection_bytes(void);                 // Steady-state collector memory per device
+
+// Device list: "name host:port [binary|telnet]" per line, '#' comments
+bool collector_load_devices(const char* path, std::vector<collector_device_t>* devices, std::string* error);
+
+#endif // HOST_COLLECTOR_H
@@ -0,0 +1,85 @@
+/**
+ * @file collector_main.cpp
+ * @brief collector: record telemetry from a list of controllers until interrupted
+ * @author Arduino Developer
+ * @date 2025
+ *
+ *   collector devices.txt /var/lib/hydro [workers]
+ *
+ * devices.txt has one controller per line:
+ *
+ *   tank-a  192.168.1.40:2424  binary     # TELEMETRY_PORT
+ *   tank-b  192.168.1.41:23    telnet
+ *
+ * Totals are printed every 10 s; Ctrl-C flushes and exits.
+ */
+
+#include "collector.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <thread>
+
+static collector_t* running = nullptr;
+static volatile sig_atomic_t interrupted = 0;
+
+static void on_signal(int signal) {
+    (void)signal;
+    interrupted = 1;
+    if (running) collector_stop(running);
+}
+
+static void print_stats(const collector_stats_t& stats, size_t devices, double rate) {
+    printf("%u/%zu connected | %.1f readings/s | %llu readings, %llu events | gaps %llu | bad %llu\n",
+           stats.connected, devices, rate, (unsigned long long)stats.readings, (unsigned long long)stats.events,
+           (unsigned long long)stats.seq_gaps, (unsigned long long)stats.bad_frames);
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 4) {
+        fprintf(stderr, "usage: %s <devices> <out_dir> [workers]\n", argv[0]);
+        return 2;
+    }
+    std::vector<collector_device_t> devices;
+    std::string error;
+    if (!collector_load_devices(argv[1], &devices, &error)) {
+        fprintf(stderr, "collector: %s\n", error.c_str());
+        return 2;
+    }
+
+    collector_config_t config;
+    config.out_dir = argv[2];
+    if (argc == 4) config.workers = atoi(argv[3]);
+    collector_t* collector = collector_create(config, devices, &error);
+    if (!collector) {
+        fprintf(stderr, "collector: %s\n", error.c_str());
+        return 1;
+    }
+
+    running = collector;
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("collecting from %zu devices into %s (%zu B per device)\n", devices.size(), config.out_dir.c_str(),
+           collector_connection_bytes());
+    std::thread loop([collector] { collector_run(collector); });
+
+    collector_stats_t last = collector_get_stats(collector);
+    for (int tick = 1; !interrupted; tick++) {
+        usleep(100000);
+        if (tick % 100 == 0) {
+            collector_stats_t now = collector_get_stats(collector);
+            print_stats(now, devices.size(), (now.readings - last.readings) / 10.0);
+            last = now;
+        }
+    }
+    loop.join();
+    print_stats(collector_get_stats(collector), devices.size(), 0.0);
+    collector_destroy(collector);
+    return 0;
+}
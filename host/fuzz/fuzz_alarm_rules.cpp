@@ -0,0 +1,59 @@
+/**
+ * @file fuzz_alarm_rules.cpp
+ * @brief Fuzz target: alarm rule compiler and bytecode evaluator
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Input is rule text up to the first NUL byte; remaining bytes are readings
+ * (pH, EC, volume, temperature, dosed ml, auto flag, time step). Whatever
+ * the text, compilation must stay inside the bytecode pool and every program
+ * that compiles must evaluate without touching memory outside its stack.
+ */
+
+#include "fuzz_common.h"
+
+static alarm_program_t program;
+static alarm_history_t history;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static char text[ALARM_RULES_TEXT_MAX];
+    size_t text_len = 0;
+    while (text_len < size && data[text_len] != 0 && text_len + 1 < sizeof(text)) text_len++;
+    memcpy(text, data, text_len);
+    text[text_len] = '\0';
+
+    alarm_compile_error_t error;
+    if (!alarm_compile(text, &program, &error)) {
+        FUZZ_CHECK(program.rule_count == 0);
+        FUZZ_CHECK(error.line >= 1 && error.column >= 1);
+        FUZZ_CHECK(memchr(error.message, '\0', sizeof(error.message)) != nullptr);
+        return 0;
+    }
+
+    FUZZ_CHECK(program.code_used <= ALARM_CODE_SIZE);
+    FUZZ_CHECK(program.rule_count <= ALARM_MAX_RULES);
+    for (int i = 0; i < program.rule_count; i++) {
+        const alarm_rule_t& rule = program.rules[i];
+        FUZZ_CHECK(rule.code_offset + rule.code_length <= program.code_used);
+        FUZZ_CHECK(strlen(rule.name) > 0 && strlen(rule.name) < ALARM_NAME_LEN);
+    }
+
+    fuzz_input_t in(data + text_len, size - text_len);
+    alarm_event_t events[ALARM_MAX_RULES];
+    alarm_inputs_t inputs;
+    uint32_t now = 0;
+    alarm_history_reset(&history, now);
+
+    // At least a few hours of history so windowed functions produce values
+    for (int step = 0; step < 300; step++) {
+        for (int v = 0; v < static_cast<int>(AlarmVar::COUNT); v++) {
+            inputs.values[v] = in.empty() ? (float)(step % 7) : in.take_float();
+        }
+        now += in.empty() ? 30000u : (uint32_t)in.take_u8() * 1000u;
+        inputs.timestamp = now;
+        alarm_history_push(&history, &inputs);
+        int count = alarm_program_step(&program, &inputs, &history, events, ALARM_MAX_RULES);
+        FUZZ_CHECK(count >= 0 && count <= program.rule_count);
+    }
+    return 0;
+}
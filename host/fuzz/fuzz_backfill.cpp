@@ -0,0 +1,61 @@
+/**
+ * @file fuzz_backfill.cpp
+ * @brief Fuzz target: telemetry backfill request line -> history copy
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The first byte publishes that many readings (moving the history window),
+ * the second picks the output buffer size, the rest is the request line a
+ * stream client sent. An accepted request is answered chunk by chunk as the
+ * stream port does: every chunk must be whole frames, in increasing seq,
+ * inside the requested range and the held history.
+ */
+
+#include "fuzz_common.h"
+#include "telemetry.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_input_t input(data, size);
+    uint8_t publish = input.take_u8();
+    size_t out_len = TELEMETRY_FRAME_MAX + input.take_u8();
+    for (int i = 0; i < publish; i++) {
+        sensor_readings_t r = sensor_readings_t();
+        r.ph = 6.0f + i / 100.0f;
+        r.valid = true;
+        telemetry_publish_reading(r);
+    }
+
+    const char* line = reinterpret_cast<const char*>(data + input.pos);
+    uint32_t from, count;
+    if (!telemetry_parse_backfill(line, input.remaining(), &from, &count)) return 0;
+    FUZZ_CHECK(count >= 1 && count <= (uint32_t)TELEMETRY_HISTORY_FRAMES);
+
+    uint32_t oldest = telemetry_get_oldest_seq();
+    uint32_t newest = telemetry_get_seq();
+    uint32_t end = from + count;
+    uint32_t last = 0;
+    bool any = false;
+    uint8_t out[TELEMETRY_FRAME_MAX + 256];
+    for (int chunks = 0; from != end; chunks++) {
+        FUZZ_CHECK(chunks <= TELEMETRY_HISTORY_FRAMES);
+        uint32_t next;
+        size_t n = telemetry_backfill(from, end - from, out, out_len, &next);
+        FUZZ_CHECK(n <= out_len);
+        if (n == 0) break;
+        size_t pos = 0;
+        while (pos < n) {
+            telemetry_event_t event;
+            size_t consumed = 0;
+            FUZZ_CHECK(telemetry_decode(out + pos, n - pos, &event, &consumed) == 1);
+            FUZZ_CHECK(event.seq - from < end - from);
+            FUZZ_CHECK(event.seq >= oldest && event.seq < newest);
+            FUZZ_CHECK(!any || event.seq > last);
+            last = event.seq;
+            any = true;
+            pos += consumed;
+        }
+        FUZZ_CHECK(next - from <= end - from && next != from);
+        from = next;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file fuzz_block_pool.cpp
+ * @brief Fuzz target: fixed-block pools against a reference model
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Each input byte pair is an opcode and an operand: allocate from a pool,
+ * free one of the live blocks, free a block twice, or free a pointer the
+ * pool never handed out. Every live block is filled with its own tag, so a
+ * block handed out twice or a free list threaded through a live block shows
+ * up as a corrupted tag. Counters must match the model after every step.
+ */
+
+#include "fuzz_common.h"
+#include "block_pool.h"
+
+static constexpr int kPools = static_cast<int>(PoolId::COUNT);
+static constexpr int kMaxLive = 64;
+
+struct live_block_t {
+    PoolId pool;
+    uint8_t* data;
+    uint8_t tag;
+};
+
+static void check_tag(const live_block_t& b) {
+    size_t size = pool_get_stats(b.pool).block_size;
+    for (size_t i = 0; i < size; i++) FUZZ_CHECK(b.data[i] == b.tag);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_input_t in(data, size);
+    pool_init();
+
+    live_block_t live[kMaxLive];
+    int live_count = 0;
+    uint16_t in_use[kPools] = {};
+    uint16_t high_water[kPools] = {};
+    uint32_t exhausted[kPools] = {};
+    uint32_t bad_frees[kPools] = {};
+    uint8_t next_tag = 1;
+
+    while (!in.empty()) {
+        uint8_t op = in.take_u8();
+        uint8_t arg = in.take_u8();
+        PoolId pool = static_cast<PoolId>(arg % kPools);
+        int p = static_cast<int>(pool);
+        pool_stats_t stats = pool_get_stats(pool);
+
+        switch (op % 4) {
+            case 0: {                                        // Allocate
+                uint8_t* block = static_cast<uint8_t*>(pool_alloc(pool));
+                if (in_use[p] == stats.block_count) {
+                    FUZZ_CHECK(block == nullptr);
+                    exhausted[p]++;
+                    break;
+                }
+                FUZZ_CHECK(block != nullptr);
+                FUZZ_CHECK(reinterpret_cast<uintptr_t>(block) % 8 == 0);
+                in_use[p]++;
+                if (in_use[p] > high_water[p]) high_water[p] = in_use[p];
+                if (live_count < kMaxLive) {
+                    live[live_count] = {pool, block, next_tag++};
+                    memset(block, live[live_count].tag, stats.block_size);
+                    live_count++;
+                } else {
+                    FUZZ_CHECK(pool_free(pool, block));        // Model full: hand it straight back
+                    in_use[p]--;
+                }
+                break;
+            }
+            case 1: {                                        // Free a live block
+                if (live_count == 0) break;
+                int i = arg % live_count;
+                check_tag(live[i]);
+                FUZZ_CHECK(pool_free(live[i].pool, live[i].data));
+                in_use[static_cast<int>(live[i].pool)]--;
+                live[i] = live[--live_count];
+                break;
+            }
+            case 2: {                                        // Double free
+                if (live_count == 0) break;
+                int i = arg % live_count;
+                int q = static_cast<int>(live[i].pool);
+                FUZZ_CHECK(pool_free(live[i].pool, live[i].data));
+                FUZZ_CHECK(!pool_free(live[i].pool, live[i].data));
+                in_use[q]--;
+                bad_frees[q]++;
+                live[i] = live[--live_count];
+                break;
+            }
+            case 3: {                                        // Foreign, interior or wrong-pool pointer
+                static uint8_t outside[16];
+                uint8_t* bogus = outside;
+                if (live_count > 0) {
+                    const live_block_t& b = live[arg % live_count];
+                    bogus = (arg & 0x80) ? b.data + 1 + (arg & 7) : b.data;
+                    if (bogus == b.data && b.pool == pool) bogus = outside;
+                }
+                FUZZ_CHECK(!pool_free(pool, bogus));
+                bad_frees[p]++;
+                break;
+            }
+        }
+
+        for (int q = 0; q < kPools; q++) {
+            pool_stats_t s = pool_get_stats(static_cast<PoolId>(q));
+            FUZZ_CHECK(s.in_use == in_use[q]);
+            FUZZ_CHECK(s.high_water == high_water[q]);
+            FUZZ_CHECK(s.exhausted == exhausted[q]);
+            FUZZ_CHECK(s.bad_frees == bad_frees[q]);
+        }
+    }
+
+    for (int i = 0; i < live_count; i++) check_tag(live[i]);
+    return 0;
+}
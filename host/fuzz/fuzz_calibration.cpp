@@ -0,0 +1,62 @@
+/**
+ * @file fuzz_calibration.cpp
+ * @brief Fuzz target: calibration setters and distance-to-volume conversion
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Input layout: a sequence of records, each an opcode byte followed by the
+ * float arguments of the selected setter. Every record ends with a probe of
+ * calibration_distance_to_volume() using a fuzzed distance.
+ */
+
+#include "fuzz_common.h"
+
+static bool calibration_finite(void) {
+    return isfinite(calibration.ph_slope) && isfinite(calibration.ph_offset) &&
+           isfinite(calibration.ec_slope) && isfinite(calibration.ec_offset) &&
+           isfinite(calibration.empty_distance) && isfinite(calibration.half_distance) &&
+           isfinite(calibration.full_distance) && isfinite(calibration.max_volume);
+}
+
+static void check_volume_probe(float distance) {
+    float volume = calibration_distance_to_volume(distance);
+    if (distance < 0) {
+        FUZZ_CHECK(volume == -1.0f);
+        return;
+    }
+    if (isnan(distance)) {
+        return; // NaN distance is never produced by sensor_read_distance_raw()
+    }
+    FUZZ_CHECK(isfinite(volume));
+    FUZZ_CHECK(volume >= 0.0f && volume <= calibration.max_volume + 1e-3f * calibration.max_volume);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_reset_firmware();
+    fuzz_input_t in(data, size);
+
+    while (!in.empty()) {
+        uint8_t op = in.take_u8() % 3;
+        float a = in.take_float();
+        float b = in.take_float();
+        float c = in.take_float();
+        float d = in.take_float();
+
+        switch (op) {
+            case 0:
+                calibration_ph_2point(a, b, c, d);
+                break;
+            case 1:
+                calibration_ec_2point(a, b, c, d);
+                break;
+            default:
+                calibration_volume_3point(a, b, c, d);
+                break;
+        }
+
+        FUZZ_CHECK(calibration_finite());
+        check_volume_probe(in.take_float());
+    }
+
+    return 0;
+}
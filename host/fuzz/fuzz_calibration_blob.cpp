@@ -0,0 +1,42 @@
+/**
+ * @file fuzz_calibration_blob.cpp
+ * @brief Fuzz target: NVS calibration record decoder (calibration_load)
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The input is stored verbatim under NVS_CALIBRATION_KEY, as a corrupted or
+ * foreign flash page would present it, then decoded by calibration_load().
+ * Whatever was stored, the loaded calibration must produce finite sensor
+ * values.
+ */
+
+#include "fuzz_common.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    host_reset();
+    host_nvs_put_raw(NVS_NAMESPACE, NVS_CALIBRATION_KEY, data, size);
+    fuzz_boot_firmware();
+
+    FUZZ_CHECK(isfinite(calibration.ph_slope) && isfinite(calibration.ph_offset));
+    FUZZ_CHECK(isfinite(calibration.ec_slope) && isfinite(calibration.ec_offset));
+
+    // Full-scale ADC range through both conversion formulas
+    static const uint16_t kCodes[] = {0, 1, 2048, 4094, 4095};
+    for (uint16_t code : kCodes) {
+        host_set_adc_value(PH_PIN, code);
+        host_set_adc_value(EC_PIN, code);
+        float ph = sensor_read_ph_raw(25.0f, calibration);
+        float ec = sensor_read_ec_raw(25.0f, calibration);
+        FUZZ_CHECK(isfinite(ph) && ph >= 0.0f && ph <= 14.0f);
+        FUZZ_CHECK(isfinite(ec) && ec >= 0.0f);
+    }
+
+    // Distance range of the HC-SR04 (2-400 cm) plus the timeout marker
+    static const float kDistances[] = {-1.0f, 2.0f, 20.0f, 55.5f, 400.0f};
+    for (float distance : kDistances) {
+        float volume = calibration_distance_to_volume(distance);
+        FUZZ_CHECK(isfinite(volume));
+    }
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file fuzz_cli.cpp
+ * @brief Fuzz target: Serial bytes -> CommunicationManager input path -> CLI dispatcher
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The whole input is queued on the Serial RX line, then the main-loop input
+ * path (Debug->available()/read() -> cli_process_command) drains it while
+ * the state machine and pump updates run in between, as in loop().
+ * Interactive calibration commands read their numeric arguments from the
+ * same byte stream.
+ */
+
+#include "fuzz_common.h"
+#include "cli.h"
+
+// Loop iterations allowed per input byte before declaring a livelock
+static constexpr size_t kIterationsPerByte = 64;
+
+static const uint8_t kPumpPins[static_cast<int>(PumpId::COUNT)] = {
+    PUMP_PH_UP_PIN, PUMP_PH_DOWN_PIN, PUMP_NUTRIENT_A_PIN, PUMP_NUTRIENT_B_PIN
+};
+
+static void check_invariants(void) {
+    FUZZ_CHECK(static_cast<int>(state_manager.system_state) <= static_cast<int>(SystemState::SHUTDOWN));
+    FUZZ_CHECK(static_cast<int>(state_manager.sensor_state) <= static_cast<int>(SensorState::ERROR));
+
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        PumpState state = state_manager.pump_states[i];
+        FUZZ_CHECK(static_cast<int>(state) <= static_cast<int>(PumpState::MAINTENANCE));
+
+        // pump_update() must leave non-running states with PWM off
+        if (state == PumpState::IDLE || state == PumpState::COOLING_DOWN || state == PumpState::ERROR) {
+            FUZZ_CHECK(host_get_pwm_duty(kPumpPins[i]) == 0);
+        }
+
+        float total = pump_get_total_dosed(static_cast<PumpId>(i));
+        FUZZ_CHECK(isfinite(total) && total >= 0.0f);
+    }
+
+    float target = pump_get_ph_target();
+    FUZZ_CHECK(target >= 5.0f && target <= 8.0f);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_reset_firmware();
+    host_serial_feed(data, size);
+
+    size_t budget = (size + 1) * kIterationsPerByte;
+    while (host_serial_rx_pending() > 0) {
+        FUZZ_CHECK(budget-- > 0);
+
+        Debug->update();
+        state_machine_update();
+        if (state_manager.system_state != SystemState::SHUTDOWN && Debug->available()) {
+            cli_process_command(Debug->read());
+        }
+        pump_update();
+        check_invariants();
+
+        host_advance_ms(50);
+    }
+
+    return 0;
+}
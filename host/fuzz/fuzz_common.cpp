@@ -0,0 +1,52 @@
+/**
+ * @file fuzz_common.cpp
+ * @brief Shared firmware reset for fuzz targets
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "fuzz_common.h"
+#include "cal_history.h"
+
+// NVS preferences object (main.cpp is not linked into fuzz targets)
+Preferences preferences;
+
+void fuzz_boot_firmware(void) {
+    // Busy-wait loops (operator keypress waits) must terminate on empty input
+    host_set_auto_tick_us(100000);
+
+    binlog_init();
+    if (!Debug) {
+        communication_init("fuzz", "fuzz");
+    }
+
+    state_manager = state_manager_t();
+    state_machine_init();
+    state_manager.debug_logging_enabled = false;
+
+    preferences.begin(NVS_NAMESPACE);
+    calibration_load();
+    cal_history_init();
+
+    pump_system.auto_ph_control = false;
+    pump_system.auto_ec_control = false;
+    pump_system.auto_inhibit = 0;
+    pump_system.ph_predictive = false;
+    pump_system.micro_dosing = false;
+    pump_set_dose_fractionation(1, PUMP_FRACTION_DEFAULT_GAP_MS);
+    pump_system.coupled_control = false;
+    pump_set_ec_target(DEFAULT_EC_TARGET);
+    pump_set_ph_shadow(PhPolicy::OFF, DEFAULT_PH_KP, DEFAULT_PH_KI, DEFAULT_PH_KD);
+    sensor_initialize();
+    pump_init();
+    calibration_check_adc_scale();
+    alarm_init();
+    volume_balance_init();
+    system_transition_to(SystemState::INITIALIZING);
+    system_transition_to(SystemState::MONITORING);
+}
+
+void fuzz_reset_firmware(void) {
+    host_reset();
+    fuzz_boot_firmware();
+}
@@ -0,0 +1,73 @@
+/**
+ * @file fuzz_common.h
+ * @brief Shared helpers for libFuzzer entry points in the host build
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#ifndef FUZZ_COMMON_H
+#define FUZZ_COMMON_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host_hal.h"
+#include "calibration.h"
+#include "sensors.h"
+#include "pump.h"
+#include "state_machine.h"
+#include "communication.h"
+#include "alarms.h"
+#include "volume_balance.h"
+#include "binlog.h"
+
+// Abort with a message so both libFuzzer and the standalone driver record a crash
+#define FUZZ_CHECK(cond)                                                        \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "FUZZ_CHECK failed: %s (%s:%d)\n", #cond, __FILE__, __LINE__); \
+            abort();                                                            \
+        }                                                                       \
+    } while (0)
+
+/**
+ * @brief Byte cursor for carving typed values out of fuzzer input
+ * Exhausted input yields zeros, so every input length is meaningful.
+ */
+struct fuzz_input_t {
+    const uint8_t* data;
+    size_t size;
+    size_t pos;
+
+    fuzz_input_t(const uint8_t* d, size_t s) : data(d), size(s), pos(0) {}
+
+    bool empty() const { return pos >= size; }
+    size_t remaining() const { return size - pos; }
+
+    uint8_t take_u8() { return pos < size ? data[pos++] : 0; }
+
+    float take_float() {
+        uint8_t raw[4] = {0, 0, 0, 0};
+        for (int i = 0; i < 4 && pos < size; i++) raw[i] = data[pos++];
+        float value;
+        memcpy(&value, raw, sizeof(value));
+        return value;
+    }
+};
+
+/**
+ * @brief Run the firmware init sequence against the current shim state
+ * Mirrors the init order of setup() in main.cpp without WiFi/OTA; NVS
+ * contents prepared by the caller are picked up by calibration_load().
+ */
+void fuzz_boot_firmware(void);
+
+/**
+ * @brief Reset the shim (clock, pins, NVS, serial) and boot the firmware
+ */
+void fuzz_reset_firmware(void);
+
+#endif // FUZZ_COMMON_H
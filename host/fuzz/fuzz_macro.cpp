@@ -0,0 +1,81 @@
+/**
+ * @file fuzz_macro.cpp
+ * @brief Fuzz target: batch compiler and all-or-nothing execution
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The input is batch text. A rejected batch must leave the output untouched
+ * and name a step no later than the ones present; an accepted one must hold
+ * 1..MACRO_MAX_STEPS in-range steps with each pump dosed at most once. An
+ * accepted batch is then run on the booted firmware: if it is refused, the
+ * targets and auto flags must be as they were before.
+ */
+
+#include "fuzz_common.h"
+#include "macro.h"
+
+static void check_step(const macro_step_t& step) {
+    switch (step.op) {
+        case MacroOp::AUTO_PH:
+        case MacroOp::AUTO_EC:
+            FUZZ_CHECK(step.value == 0.0f || step.value == 1.0f);
+            break;
+        case MacroOp::PH_TARGET:
+            FUZZ_CHECK(step.value >= 5.0f && step.value <= 8.0f);
+            break;
+        case MacroOp::EC_TARGET:
+            FUZZ_CHECK(step.value >= 0.2f && step.value <= 4.0f);
+            break;
+        case MacroOp::DOSE:
+            FUZZ_CHECK(step.pump < static_cast<int>(PumpId::COUNT));
+            FUZZ_CHECK(step.value >= PUMP_MICRO_MIN_VOLUME && step.value <= PUMP_MAX_DOSE_VOLUME);
+            break;
+        case MacroOp::STOP:
+            FUZZ_CHECK(step.pump < static_cast<int>(PumpId::COUNT) || step.pump == MACRO_ALL_PUMPS);
+            break;
+        default:
+            FUZZ_CHECK(false);
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const char* text = reinterpret_cast<const char*>(data);
+    int segments = 1;
+    for (size_t i = 0; i < size; i++) {
+        if (text[i] == ';' || text[i] == '\n') segments++;
+    }
+
+    macro_batch_t batch;
+    memset(&batch, 0xAA, sizeof(batch));
+    macro_batch_t before = batch;
+    macro_error_t error;
+    memset(&error, 0xAA, sizeof(error));
+
+    if (!macro_compile(text, size, &batch, &error)) {
+        FUZZ_CHECK(memcmp(&before, &batch, sizeof(batch)) == 0);
+        FUZZ_CHECK(error.step <= segments);
+        FUZZ_CHECK(memchr(error.message, '\0', sizeof(error.message)) != nullptr && error.message[0] != '\0');
+        return 0;
+    }
+
+    FUZZ_CHECK(batch.count >= 1 && batch.count <= MACRO_MAX_STEPS && batch.count <= segments);
+    uint8_t dosed = 0;
+    for (int i = 0; i < batch.count; i++) {
+        check_step(batch.steps[i]);
+        if (batch.steps[i].op != MacroOp::DOSE) continue;
+        FUZZ_CHECK(!(dosed & (1u << batch.steps[i].pump)));
+        dosed |= (uint8_t)(1u << batch.steps[i].pump);
+    }
+
+    fuzz_reset_firmware();
+    float ph_target = pump_get_ph_target();
+    float ec_target = pump_get_ec_target();
+    bool auto_ph = pump_is_auto_ph_enabled();
+    bool auto_ec = pump_is_auto_ec_enabled();
+    if (!macro_execute(batch, &error)) {
+        FUZZ_CHECK(error.step >= 1 && error.step <= batch.count);
+        FUZZ_CHECK(pump_get_ph_target() == ph_target && pump_get_ec_target() == ec_target);
+        FUZZ_CHECK(pump_is_auto_ph_enabled() == auto_ph && pump_is_auto_ec_enabled() == auto_ec);
+    }
+    return 0;
+}
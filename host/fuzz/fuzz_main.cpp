@@ -0,0 +1,131 @@
+/**
+ * @file fuzz_main.cpp
+ * @brief Standalone driver for fuzz targets when libFuzzer is unavailable
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Runs every file of the given corpus directories/files through
+ * LLVMFuzzerTestOneInput(), then -runs=N randomly mutated corpus entries.
+ * Accepts the libFuzzer flags used in CI (-runs=, -seed=, -max_len=) so the
+ * same ctest command line works with either engine, and reports executions
+ * per second as a parser-efficiency figure.
+ *
+ * Usage: fuzz_<target> [-runs=N] [-seed=S] [-max_len=L] <corpus_dir|file>...
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+typedef std::vector<uint8_t> input_t;
+
+bool parse_flag(const char* arg, const char* name, long* value) {
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0) return false;
+    *value = strtol(arg + len, nullptr, 10);
+    return true;
+}
+
+void load_path(const std::filesystem::path& path, std::vector<input_t>& corpus) {
+    if (std::filesystem::is_directory(path)) {
+        std::vector<std::filesystem::path> files;
+        for (const auto& entry : std::filesystem::directory_iterator(path)) {
+            if (entry.is_regular_file()) files.push_back(entry.path());
+        }
+        std::sort(files.begin(), files.end()); // Deterministic replay order
+        for (const auto& file : files) load_path(file, corpus);
+        return;
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        fprintf(stderr, "fuzz: cannot open %s\n", path.c_str());
+        exit(2);
+    }
+    corpus.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Small set of libFuzzer-style mutations: flip, replace, insert, erase, splice
+void mutate(input_t& data, const std::vector<input_t>& corpus, std::mt19937& rng, size_t max_len) {
+    int rounds = 1 + (int)(rng() % 4);
+    for (int r = 0; r < rounds; r++) {
+        switch (rng() % 5) {
+            case 0:
+                if (!data.empty()) data[rng() % data.size()] ^= (uint8_t)(1u << (rng() % 8));
+                break;
+            case 1:
+                if (!data.empty()) data[rng() % data.size()] = (uint8_t)rng();
+                break;
+            case 2:
+                if (data.size() < max_len) data.insert(data.begin() + (data.empty() ? 0 : rng() % (data.size() + 1)), (uint8_t)rng());
+                break;
+            case 3:
+                if (!data.empty()) data.erase(data.begin() + rng() % data.size());
+                break;
+            default: {
+                const input_t& other = corpus[rng() % corpus.size()];
+                if (other.empty()) break;
+                size_t from = rng() % other.size();
+                size_t count = 1 + rng() % (other.size() - from);
+                size_t at = data.empty() ? 0 : rng() % (data.size() + 1);
+                data.insert(data.begin() + at, other.begin() + from, other.begin() + from + count);
+                break;
+            }
+        }
+    }
+    if (data.size() > max_len) data.resize(max_len);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    long runs = 0;
+    long seed = 1;
+    long max_len = 4096;
+    std::vector<input_t> corpus;
+
+    for (int i = 1; i < argc; i++) {
+        if (parse_flag(argv[i], "-runs=", &runs) || parse_flag(argv[i], "-seed=", &seed) ||
+            parse_flag(argv[i], "-max_len=", &max_len)) {
+            continue;
+        }
+        if (argv[i][0] == '-') continue; // Ignore other libFuzzer flags
+        load_path(argv[i], corpus);
+    }
+    if (corpus.empty()) corpus.emplace_back();
+
+    auto start = std::chrono::steady_clock::now();
+    long executions = 0;
+
+    for (const input_t& input : corpus) {
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        executions++;
+    }
+
+    std::mt19937 rng((uint32_t)seed);
+    for (long i = 0; i < runs; i++) {
+        input_t input = corpus[rng() % corpus.size()];
+        mutate(input, corpus, rng, (size_t)max_len);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+        executions++;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("fuzz: %ld corpus inputs, %ld executions in %.3f s (%.0f exec/s)\n",
+           (long)corpus.size(), executions, seconds, seconds > 0 ? executions / seconds : 0.0);
+    return 0;
+}
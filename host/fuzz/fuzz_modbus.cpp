@@ -0,0 +1,72 @@
+/**
+ * @file fuzz_modbus.cpp
+ * @brief Fuzz target: Modbus TCP request stream -> modbus_handle_adu()
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The input is what one client sent, split into ADUs the way the server's
+ * connection loop does; a bad MBAP header ends the connection. Every
+ * response must echo the request header with a consistent length, carry the
+ * request's function code (or it with the exception bit), and writes must
+ * never leave the controller outside its setpoint limits. Pump and state
+ * machine updates run between requests so started doses progress.
+ */
+
+#include "fuzz_common.h"
+#include "modbus.h"
+#include "telemetry.h"
+
+static void check_response(const uint8_t* request, const uint8_t* response, size_t len) {
+    FUZZ_CHECK(len >= MODBUS_MBAP_LEN + 2 && len <= MODBUS_ADU_MAX);
+    FUZZ_CHECK(memcmp(response, request, 4) == 0);      // Transaction and protocol
+    FUZZ_CHECK(((response[4] << 8) | response[5]) == (int)(len - 6));
+    FUZZ_CHECK(response[6] == request[6]);
+
+    uint8_t function = request[MODBUS_MBAP_LEN];
+    if (response[MODBUS_MBAP_LEN] == (function | 0x80)) {
+        FUZZ_CHECK(len == MODBUS_MBAP_LEN + 2);
+        FUZZ_CHECK(response[MODBUS_MBAP_LEN + 1] >= MODBUS_EX_ILLEGAL_FUNCTION &&
+                   response[MODBUS_MBAP_LEN + 1] <= MODBUS_EX_DEVICE_FAILURE);
+    } else {
+        FUZZ_CHECK(response[MODBUS_MBAP_LEN] == function && function < 0x80);
+    }
+}
+
+static void check_invariants(void) {
+    float ph = pump_get_ph_target();
+    float ec = pump_get_ec_target();
+    FUZZ_CHECK(ph >= 5.0f && ph <= 8.0f);
+    FUZZ_CHECK(ec >= 0.2f && ec <= 4.0f);
+
+    const modbus_snapshot_t& snapshot = modbus_get_snapshot();
+    FUZZ_CHECK(snapshot.holding[MODBUS_HR_PH_TARGET] >= 5000 && snapshot.holding[MODBUS_HR_PH_TARGET] <= 8000);
+    FUZZ_CHECK(snapshot.coils < (1u << MODBUS_COIL_COUNT));
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_reset_firmware();
+    modbus_init();
+
+    size_t pos = 0;
+    while (pos < size) {
+        int adu_len = modbus_adu_length(data + pos, size - pos);
+        if (adu_len == 0 || (adu_len > 0 && (size_t)adu_len > size - pos)) break;   // Incomplete tail
+
+        uint8_t response[MODBUS_ADU_MAX];
+        size_t len = adu_len > 0 ? (size_t)adu_len : size - pos;
+        size_t out = modbus_handle_adu(data + pos, len, response, sizeof(response));
+        if (adu_len < 0) {
+            FUZZ_CHECK(out == 0);
+            break;                                       // Connection dropped
+        }
+        check_response(data + pos, response, out);
+        pos += len;
+
+        state_machine_update();
+        pump_update();
+        modbus_refresh_snapshot();
+        check_invariants();
+        host_advance_ms(100);
+    }
+    return 0;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file fuzz_telemetry.cpp
+ * @brief Fuzz target: telemetry frame decoder on an arbitrary byte stream
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The input is a received stream, decoded the way the collector does:
+ * frame by frame, skipping garbage one byte at a time. Every decoded frame
+ * must re-encode to a frame that decodes to the same event, and the decoder
+ * must always make progress or ask for more bytes.
+ */
+
+#include "fuzz_common.h"
+#include "telemetry.h"
+
+static bool same_event(const telemetry_event_t& a, const telemetry_event_t& b) {
+    if (a.type != b.type || a.seq != b.seq || a.timestamp != b.timestamp) return false;
+    switch (a.type) {
+        case TelemetryType::READING:
+            return a.reading.ph == b.reading.ph && a.reading.ec == b.reading.ec &&
+                   a.reading.volume == b.reading.volume && a.reading.temperature == b.reading.temperature;
+        case TelemetryType::PUMP:
+            return a.pump == b.pump && a.from_state == b.from_state && a.to_state == b.to_state;
+        case TelemetryType::ALARM:
+            return a.severity == b.severity && a.raised == b.raised &&
+                   memcmp(&a.value, &b.value, sizeof(a.value)) == 0 && strcmp(a.alarm_name, b.alarm_name) == 0;
+    }
+    return false;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    size_t pos = 0;
+    while (pos < size) {
+        telemetry_event_t event;
+        size_t consumed = 0;
+        int result = telemetry_decode(data + pos, size - pos, &event, &consumed);
+        if (result == 0) {
+            FUZZ_CHECK(consumed == 0);
+            FUZZ_CHECK(size - pos < TELEMETRY_FRAME_MAX);
+            break;
+        }
+        FUZZ_CHECK(consumed >= 1 && consumed <= size - pos);
+        if (result > 0) {
+            FUZZ_CHECK(consumed <= TELEMETRY_FRAME_MAX);
+            FUZZ_CHECK(strlen(event.alarm_name) < ALARM_NAME_LEN);
+
+            uint8_t frame[TELEMETRY_FRAME_MAX];
+            size_t len = telemetry_encode(event, frame, sizeof(frame));
+            FUZZ_CHECK(len > 0 && len <= consumed);
+
+            telemetry_event_t again;
+            size_t again_consumed = 0;
+            FUZZ_CHECK(telemetry_decode(frame, len, &again, &again_consumed) == 1);
+            FUZZ_CHECK(again_consumed == len);
+            FUZZ_CHECK(same_event(event, again));
+        }
+        pos += consumed;
+    }
+    return 0;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file fuzz_timer_wheel.cpp
+ * @brief Fuzz target: hashed timer wheel against a polled reference
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The input is a start time followed by 4-byte records: opcode, timer id and
+ * a 16-bit amount. Opcodes arm a timer, cancel it or move the clock and
+ * advance the wheel; clock steps are scaled so that stalls of several wheel
+ * revolutions and the 32-bit millis() wrap are reached. A plain array of
+ * deadlines, polled the way the state machine used to poll
+ * `millis() - entry > timeout`, must agree with the wheel on every advance:
+ * same timers due, none early, none missed, same remaining time.
+ */
+
+#include "fuzz_common.h"
+#include "timer_wheel.h"
+
+static constexpr int kTimers = 8;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_input_t in(data, size);
+
+    uint32_t now = 0;
+    for (int i = 0; i < 4; i++) now = (now << 8) | in.take_u8();
+
+    timer_wheel_t wheel;
+    timer_wheel_init(&wheel, now);
+    bool armed[kTimers] = {};
+    uint32_t deadline[kTimers] = {};
+
+    while (!in.empty()) {
+        uint8_t op = in.take_u8();
+        uint8_t id = in.take_u8() % kTimers;
+        uint32_t amount = in.take_u8();
+        amount = (amount << 8) | in.take_u8();
+
+        switch (op % 4) {
+            case 0:                                         // Arm (up to ~10 min ahead)
+                deadline[id] = now + amount * 10;
+                armed[id] = true;
+                timer_wheel_arm(&wheel, id, deadline[id]);
+                break;
+            case 1:                                         // Cancel
+                armed[id] = false;
+                timer_wheel_cancel(&wheel, id);
+                break;
+            case 2:                                         // Loop pass: a few ms
+                now += amount % 64;
+                break;
+            case 3:                                         // Stall: up to ~65 s
+                now += amount;
+                break;
+        }
+
+        if (op % 4 >= 2) {
+            uint32_t due = timer_wheel_advance(&wheel, now);
+            for (int t = 0; t < kTimers; t++) {
+                bool expected = armed[t] && (int32_t)(now - deadline[t]) > 0;
+                FUZZ_CHECK(((due >> t) & 1u) == (expected ? 1u : 0u));
+                if (expected) armed[t] = false;
+            }
+            FUZZ_CHECK((due >> kTimers) == 0);
+        }
+
+        for (int t = 0; t < kTimers; t++) {
+            FUZZ_CHECK(timer_wheel_is_armed(&wheel, t) == armed[t]);
+            if (armed[t]) {
+                int32_t left = (int32_t)(deadline[t] - now);
+                FUZZ_CHECK(timer_wheel_remaining_ms(&wheel, t, now) == (left > 0 ? (uint32_t)left : 0u));
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+/**
+ * @file fuzz_usb_export.cpp
+ * @brief Fuzz target: USB bulk export stream -> host capture
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The first byte picks the piece size the stream is fed in, the rest is the
+ * byte stream a serial port delivered. Every frame the decoder accepts must
+ * re-encode to the same bytes, and feeding the stream in pieces must give
+ * the same capture as feeding it at once.
+ */
+
+#include "fuzz_common.h"
+#include "usb_export.h"
+#include "usb_export_capture.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_input_t input(data, size);
+    size_t piece = 1 + input.take_u8();
+    const uint8_t* stream = data + input.pos;
+    size_t len = input.remaining();
+
+    uint8_t encoded[USB_EXPORT_FRAME_MAX];
+    for (size_t pos = 0; pos < len;) {
+        usb_export_frame_t frame;
+        int used = usb_export_decode_frame(stream + pos, len - pos, &frame);
+        if (used == 0) break;
+        if (used < 0) {
+            pos++;
+            continue;
+        }
+        FUZZ_CHECK((size_t)used <= len - pos && frame.len <= USB_EXPORT_PAYLOAD_MAX);
+        FUZZ_CHECK(usb_export_encode_frame(frame.type, frame.seq, frame.payload, frame.len, encoded,
+                                           sizeof(encoded)) == (size_t)used);
+        FUZZ_CHECK(memcmp(encoded, stream + pos, (size_t)used) == 0);
+        pos += (size_t)used;
+    }
+
+    usb_export_capture_t whole;
+    usb_export_capture_feed(&whole, stream, len);
+    usb_export_capture_t pieces;
+    for (size_t pos = 0; pos < len; pos += piece) {
+        usb_export_capture_feed(&pieces, stream + pos, len - pos < piece ? len - pos : piece);
+    }
+    FUZZ_CHECK(whole.frames == pieces.frames && whole.skipped_bytes == pieces.skipped_bytes);
+    FUZZ_CHECK(whole.missing_frames == pieces.missing_frames && whole.bad_payloads == pieces.bad_payloads);
+    FUZZ_CHECK(whole.telemetry.size() == pieces.telemetry.size() && whole.logs.size() == pieces.logs.size() &&
+               whole.crashes.size() == pieces.crashes.size() && whole.ended == pieces.ended);
+    FUZZ_CHECK(whole.pending.size() == pieces.pending.size() && whole.pending.size() < USB_EXPORT_FRAME_MAX);
+    return 0;
+}
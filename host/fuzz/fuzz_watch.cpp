@@ -0,0 +1,99 @@
+/**
+ * @file fuzz_watch.cpp
+ * @brief Fuzz target: watch command parser and per-client scheduler
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Each input line is a watch command from the client named by its first
+ * byte. A rejected command must leave the request untouched; an accepted
+ * one must be within the period limits. After each command the clock moves
+ * on by a byte-chosen number of seconds and the scheduler runs: every line
+ * written must fit, name only watched channels and go to a watching client,
+ * and no client may get more than one line per pass.
+ */
+
+#include "fuzz_common.h"
+#include "watch.h"
+
+struct run_t {
+    watch_table_t* table;
+    int lines[WATCH_MAX_CLIENTS];
+    uint32_t calls;
+};
+
+static void fake_refresh(watch_snapshot_t* snapshot) {
+    *snapshot = watch_snapshot_t{};
+    snapshot->have_reading = true;
+    snapshot->reading = sensor_readings_t(6.2f, 1.4f, 40.0f, 21.5f);
+    snapshot->pump_state[1] = static_cast<uint8_t>(PumpState::DOSING);
+    snapshot->system_state = static_cast<uint8_t>(SystemState::MONITORING);
+}
+
+static bool check_write(void* ctx, int client, const char* line) {
+    run_t* run = static_cast<run_t*>(ctx);
+    FUZZ_CHECK(client >= 0 && client < WATCH_MAX_CLIENTS);
+    FUZZ_CHECK(run->table->clients[client].channels != 0);
+    FUZZ_CHECK(strlen(line) < WATCH_LINE_MAX && strncmp(line, "watch", 5) == 0);
+    run->lines[client]++;
+    return client != 3 || (++run->calls & 1) == 0;       // One client refuses every other line
+}
+
+static void check_table(const watch_table_t& table) {
+    int watching = 0;
+    for (int c = 0; c < table.capacity; c++) {
+        const watch_client_t& client = table.clients[c];
+        FUZZ_CHECK((client.channels >> WATCH_CHANNEL_COUNT) == 0);
+        if (client.channels) watching++;
+        for (int i = 0; i < WATCH_CHANNEL_COUNT; i++) {
+            if (!(client.channels & (1u << i))) continue;
+            FUZZ_CHECK(client.period_ms[i] >= WATCH_MIN_PERIOD_MS && client.period_ms[i] <= WATCH_MAX_PERIOD_MS);
+            FUZZ_CHECK((int32_t)(client.next_due[i] - table.next_due) >= 0);
+        }
+    }
+    FUZZ_CHECK(watching == table.watching);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    watch_client_t clients[WATCH_MAX_CLIENTS];
+    watch_table_t table;
+    watch_table_init(&table, clients, WATCH_MAX_CLIENTS);
+    run_t run = {&table, {0}, 0};
+    uint32_t now = 0xFFFF0000u;                          // Wraps during the run
+
+    const char* text = reinterpret_cast<const char*>(data);
+    size_t pos = 0;
+    while (pos < size) {
+        size_t end = pos;
+        while (end < size && text[end] != '\n') end++;
+        if (end > pos) {
+            int client = (uint8_t)text[pos] % WATCH_MAX_CLIENTS;
+            watch_request_t request = {WatchAction::LOG, 0xAA, 0x12345678u, true};
+            watch_request_t before = request;
+            if (watch_parse(text + pos + 1, end - pos - 1, &request)) {
+                if (request.action == WatchAction::SET) {
+                    FUZZ_CHECK(request.channel < WATCH_CHANNEL_COUNT);
+                    FUZZ_CHECK(request.period_ms >= WATCH_MIN_PERIOD_MS && request.period_ms <= WATCH_MAX_PERIOD_MS);
+                }
+                watch_apply(&table, client, request, now);
+            } else {
+                FUZZ_CHECK(memcmp(&before, &request, sizeof(before)) == 0);
+            }
+            char description[WATCH_LINE_MAX];
+            FUZZ_CHECK(watch_describe(clients[client], description, sizeof(description)) < sizeof(description));
+        }
+        check_table(table);
+
+        now += 1000u * (end < size && end + 1 < size ? (uint8_t)text[end + 1] % 8 : 1);
+        memset(run.lines, 0, sizeof(run.lines));
+        int written = watch_run(&table, fake_refresh, check_write, &run, now);
+        int total = 0;
+        for (int c = 0; c < WATCH_MAX_CLIENTS; c++) {
+            FUZZ_CHECK(run.lines[c] <= 1);
+            total += run.lines[c];
+        }
+        FUZZ_CHECK(written <= total);
+        check_table(table);
+        pos = end + 1;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file fuzz_websocket.cpp
+ * @brief Fuzz target: WebSocket opening handshake and client frame decoder
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The input is first offered as a handshake request, growing a byte at a
+ * time as the server sees it arrive, until the handshake stops asking for
+ * more; an accepted request yields a bounded 101 response and a valid
+ * subscription. The same bytes are then decoded as a client frame
+ * stream the way the server does after the upgrade; text frames are applied
+ * as subscription changes.
+ */
+
+#include "fuzz_common.h"
+#include "websocket.h"
+
+static void check_subscription(const websocket_subscription_t& subscription) {
+    FUZZ_CHECK((subscription.events & ~WEBSOCKET_EVENT_ALL) == 0);
+    FUZZ_CHECK(subscription.max_hz <= WEBSOCKET_MAX_HZ);
+}
+
+static void fuzz_handshake(const char* request, size_t size) {
+    if (size > WEBSOCKET_REQUEST_MAX) size = WEBSOCKET_REQUEST_MAX;
+    char response[WEBSOCKET_RESPONSE_MAX];
+    for (size_t len = 0; len <= size; len++) {
+        websocket_subscription_t subscription = {0, 0};
+        int result = websocket_handshake(request, len, response, sizeof(response), &subscription);
+        if (result == 0) continue;
+        if (result > 0) {
+            FUZZ_CHECK((size_t)result < sizeof(response));
+            FUZZ_CHECK(strncmp(response, "HTTP/1.1 101 ", 13) == 0);
+            FUZZ_CHECK(strstr(response, "Sec-WebSocket-Accept: ") != nullptr);
+            check_subscription(subscription);
+        }
+        break;                                           // The server stops reading here
+    }
+}
+
+static void fuzz_frames(const uint8_t* data, size_t size) {
+    websocket_subscription_t subscription = {WEBSOCKET_EVENT_ALL, 0};
+    size_t pos = 0;
+    while (pos < size) {
+        websocket_frame_t frame;
+        int used = websocket_decode_frame(data + pos, size - pos, &frame);
+        if (used <= 0) break;                            // Need more, or the connection is closed
+        FUZZ_CHECK((size_t)used <= size - pos && used == 6 + frame.length);
+        FUZZ_CHECK(frame.length <= WEBSOCKET_CONTROL_MAX && frame.fin);
+        if (frame.opcode == WEBSOCKET_OP_TEXT) {
+            websocket_subscription_t before = subscription;
+            if (!websocket_parse_subscription(reinterpret_cast<const char*>(frame.payload), frame.length,
+                                              &subscription)) {
+                FUZZ_CHECK(memcmp(&before, &subscription, sizeof(before)) == 0);
+            }
+            check_subscription(subscription);
+        }
+        pos += (size_t)used;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_handshake(reinterpret_cast<const char*>(data), size);
+    fuzz_frames(data, size);
+    return 0;
+}
@@ -0,0 +1,396 @@
+/**
+ * @file golden_main.cpp
+ * @brief Golden trace runner: scenario script -> canonical control trace -> compare
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Runs one scenario (simulated reservoir + seeded noise + timed events)
+ * through the real firmware and records a canonical trace of:
+ *   READ  <t> <ph> <ec> <volume> <temp>      completed sensor cycle (filtered)
+ *   SYS   <t> <from> <to>                    system state change
+ *   PUMP  <t> <pump> <from> <to>             pump state change
+ *   PWM   <t> <pump> <duty>                  pump PWM duty change
+ *   DOSE  <t> <pump> <ml>                    dose accounted by the pump module
+ *                                            (manual runs: once, when the run ends)
+ *   EVENT <t> <script line>                  scenario event applied
+ *   ALARM <t> <rule> RAISED|CLEARED <value>  alarm transition from the rule engine
+ * The trace is compared token by token with the checked-in golden file;
+ * numeric tokens use the scenario's tolerances.
+ *
+ * Usage: golden_run <scenario.scn> <golden.trace> [--update] [--actual <path>]
+ */
+
+#include "sim_harness.h"
+#include "host_hal.h"
+#include "state_machine.h"
+#include "sensors.h"
+#include "pump.h"
+#include "alarms.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//=============================================================================
+// SCENARIO
+//=============================================================================
+
+struct scenario_event_t {
+    uint32_t time_ms;
+    std::string action;   // cli | set | add_water
+    std::string arg;
+    float value;
+    std::string text;     // Original line for the trace
+};
+
+struct scenario_t {
+    reservoir_config_t plant;
+    std::vector<std::pair<std::string, float>> plant_params;  // Applied after init
+    uint32_t duration_ms = 3600000;
+    uint32_t tick_ms = 10;
+    uint32_t read_every = 1;                                  // Record every Nth READ (long scenarios)
+    double tolerance_time_ms = 0.0;
+    double tolerance_value = 1e-3;
+    std::map<std::string, double> tolerance_kind;            // Per trace kind override
+    std::vector<scenario_event_t> events;
+};
+
+static bool parse_time(const std::string& s, uint32_t* ms) {
+    unsigned h = 0, m = 0;
+    double sec = 0.0;
+    if (sscanf(s.c_str(), "%u:%u:%lf", &h, &m, &sec) != 3) return false;
+    *ms = (uint32_t)(h * 3600000u + m * 60000u + (uint32_t)llround(sec * 1000.0));
+    return true;
+}
+
+static std::string unescape(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '\\' && i + 1 < s.size() && s[i + 1] == 'n') {
+            out += '\n';
+            i++;
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+static bool load_scenario(const char* path, scenario_t* sc) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "golden: cannot open scenario %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    int line_no = 0;
+    while (std::getline(file, line)) {
+        line_no++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream in(line);
+        std::string key;
+        if (!(in >> key)) continue;
+
+        if (key == "at") {
+            scenario_event_t ev;
+            std::string when;
+            in >> when >> ev.action;
+            if (!parse_time(when, &ev.time_ms)) {
+                fprintf(stderr, "golden: %s:%d bad time '%s'\n", path, line_no, when.c_str());
+                return false;
+            }
+            if (ev.action == "cli") {
+                std::string rest;
+                std::getline(in >> std::ws, rest);
+                ev.arg = unescape(rest);
+            } else if (ev.action == "set") {
+                in >> ev.arg >> ev.value;
+            } else if (ev.action == "add_water") {
+                in >> ev.value;
+            } else {
+                fprintf(stderr, "golden: %s:%d unknown action '%s'\n", path, line_no, ev.action.c_str());
+                return false;
+            }
+            ev.text = line.substr(line.find(ev.action));
+            while (!ev.text.empty() && isspace((unsigned char)ev.text.back())) ev.text.pop_back();
+            sc->events.push_back(ev);
+            continue;
+        }
+
+        double value;
+        if (!(in >> value)) {
+            fprintf(stderr, "golden: %s:%d missing value for '%s'\n", path, line_no, key.c_str());
+            return false;
+        }
+        if (key == "duration_min") sc->duration_ms = (uint32_t)(value * 60000.0);
+        else if (key == "tick_ms") sc->tick_ms = (uint32_t)value;
+        else if (key == "read_every") sc->read_every = value >= 1.0 ? (uint32_t)value : 1;
+        else if (key == "seed") sc->plant.seed = (uint32_t)value;
+        else if (key == "volume_l") sc->plant.volume_l = (float)value;
+        else if (key == "tank_l") sc->plant.tank_l = (float)value;
+        else if (key == "ph") sc->plant.ph = (float)value;
+        else if (key == "ec") sc->plant.ec = (float)value;
+        else if (key == "temperature") sc->plant.temperature = (float)value;
+        else if (key == "tolerance_time_ms") sc->tolerance_time_ms = value;
+        else if (key == "tolerance_value") sc->tolerance_value = value;
+        else if (key.rfind("tolerance_", 0) == 0) sc->tolerance_kind[key.substr(10)] = value;
+        else sc->plant_params.emplace_back(key, (float)value);
+    }
+    return true;
+}
+
+//=============================================================================
+// TRACE RECORDING
+//=============================================================================
+
+static const char* kPumpNames[SIM_PUMP_COUNT] = {"pH_Up", "pH_Down", "Nut_A", "Nut_B"};
+static const uint8_t kPumpPins[SIM_PUMP_COUNT] = {
+    PUMP_PH_UP_PIN, PUMP_PH_DOWN_PIN, PUMP_NUTRIENT_A_PIN, PUMP_NUTRIENT_B_PIN
+};
+
+struct snapshot_t {
+    SystemState system;
+    SensorState sensor;
+    PumpState pumps[SIM_PUMP_COUNT];
+    uint32_t duty[SIM_PUMP_COUNT];
+    float dosed[SIM_PUMP_COUNT];
+};
+
+static snapshot_t take_snapshot(void) {
+    snapshot_t s;
+    s.system = state_manager.system_state;
+    s.sensor = state_manager.sensor_state;
+    for (int i = 0; i < SIM_PUMP_COUNT; i++) {
+        s.pumps[i] = state_manager.pump_states[i];
+        s.duty[i] = host_get_pwm_duty(kPumpPins[i]);
+        s.dosed[i] = pump_get_total_dosed(static_cast<PumpId>(i));
+    }
+    return s;
+}
+
+static void emit(std::string& trace, const char* format, ...) __attribute__((format(printf, 2, 3)));
+static void emit(std::string& trace, const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    trace += line;
+    trace += '\n';
+}
+
+// Recording state carried between snapshots
+struct recorder_t {
+    uint32_t read_every;
+    uint32_t read_count;
+    float pending_ml[SIM_PUMP_COUNT];     // Manual run delivery accrued while the pump runs
+};
+
+static void record_changes(std::string& trace, recorder_t& rec, uint32_t t,
+                           const snapshot_t& before, const snapshot_t& after) {
+    if (before.system != after.system) {
+        emit(trace, "SYS %u %s %s", t, system_state_to_string(before.system), system_state_to_string(after.system));
+    }
+    for (int i = 0; i < SIM_PUMP_COUNT; i++) {
+        if (before.pumps[i] != after.pumps[i]) {
+            emit(trace, "PUMP %u %s %s %s", t, kPumpNames[i],
+                 pump_state_to_string(before.pumps[i]), pump_state_to_string(after.pumps[i]));
+        }
+        if (before.duty[i] != after.duty[i]) {
+            emit(trace, "PWM %u %s %u", t, kPumpNames[i], after.duty[i]);
+        }
+        float ml = after.dosed[i] - before.dosed[i];
+        if (after.duty[i] > 0) {
+            rec.pending_ml[i] += ml;
+        } else if (ml != 0.0f || rec.pending_ml[i] != 0.0f) {
+            emit(trace, "DOSE %u %s %.3f", t, kPumpNames[i], rec.pending_ml[i] + ml);
+            rec.pending_ml[i] = 0.0f;
+        }
+    }
+    if (before.sensor == SensorState::FILTERING && after.sensor == SensorState::READY &&
+        rec.read_count++ % rec.read_every == 0) {
+        sensor_readings_t r = sensor_get_filtered();
+        emit(trace, "READ %u %.3f %.3f %.2f %.2f", t, r.ph, r.ec, r.volume, r.temperature);
+    }
+}
+
+// Alarm events arrive through the firmware's sink list, not via snapshots
+static std::string* alarm_trace = nullptr;
+
+static void record_alarm(const alarm_event_t& event) {
+    if (alarm_trace) {
+        emit(*alarm_trace, "ALARM %u %s %s %.3f", event.timestamp, event.name,
+             event.raised ? "RAISED" : "CLEARED", event.value);
+    }
+}
+
+static std::string run_scenario(const scenario_t& sc, const char* name) {
+    std::string trace;
+    alarm_trace = &trace;
+    emit(trace, "# golden trace v1 scenario=%s", name);
+
+    sim_init(sc.plant, sc.tick_ms);
+    for (const auto& param : sc.plant_params) {
+        if (!reservoir_set_param(sim_reservoir(), param.first.c_str(), param.second)) {
+            fprintf(stderr, "golden: unknown scenario key '%s'\n", param.first.c_str());
+            exit(2);
+        }
+    }
+    sim_boot();
+    alarm_add_sink(record_alarm);
+
+    recorder_t rec = {};
+    rec.read_every = sc.read_every;
+    size_t next_event = 0;
+    snapshot_t before = take_snapshot();
+    while (sim_now_ms() < sc.duration_ms) {
+        while (next_event < sc.events.size() && sc.events[next_event].time_ms <= sim_now_ms()) {
+            const scenario_event_t& ev = sc.events[next_event++];
+            if (ev.action == "cli") {
+                sim_send_cli(ev.arg.c_str());
+            } else if (ev.action == "set") {
+                reservoir_set_param(sim_reservoir(), ev.arg.c_str(), ev.value);
+            } else {
+                reservoir_add_water(sim_reservoir(), ev.value);
+            }
+            emit(trace, "EVENT %u %s", sim_now_ms(), ev.text.c_str());
+        }
+
+        sim_step();
+        snapshot_t after = take_snapshot();
+        record_changes(trace, rec, sim_now_ms(), before, after);
+        before = after;
+    }
+    alarm_trace = nullptr;
+    return trace;
+}
+
+//=============================================================================
+// COMPARISON
+//=============================================================================
+
+static std::vector<std::vector<std::string>> tokenize(const std::string& text) {
+    std::vector<std::vector<std::string>> lines;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream words(line);
+        std::vector<std::string> tokens;
+        std::string w;
+        while (words >> w) tokens.push_back(w);
+        lines.push_back(tokens);
+    }
+    return lines;
+}
+
+static bool parse_number(const std::string& s, double* out) {
+    char* end = nullptr;
+    *out = strtod(s.c_str(), &end);
+    return end && *end == '\0' && end != s.c_str();
+}
+
+static bool tokens_match(const scenario_t& sc, const std::vector<std::string>& a, const std::vector<std::string>& b) {
+    if (a.size() != b.size() || a.empty() || a[0] != b[0]) return false;
+    auto kind = sc.tolerance_kind.find(a[0]);
+    double value_tol = kind != sc.tolerance_kind.end() ? kind->second : sc.tolerance_value;
+
+    for (size_t i = 1; i < a.size(); i++) {
+        double x, y;
+        if (a[0] != "EVENT" && parse_number(a[i], &x) && parse_number(b[i], &y)) {
+            double tol = (i == 1) ? sc.tolerance_time_ms : value_tol;
+            if (fabs(x - y) > tol) return false;
+        } else if (a[i] != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string join(const std::vector<std::string>& tokens) {
+    std::string s;
+    for (const auto& t : tokens) s += (s.empty() ? "" : " ") + t;
+    return s;
+}
+
+static bool compare_traces(const scenario_t& sc, const std::string& expected, const std::string& actual) {
+    auto exp = tokenize(expected);
+    auto act = tokenize(actual);
+    size_t n = exp.size() < act.size() ? exp.size() : act.size();
+    for (size_t i = 0; i < n; i++) {
+        if (!tokens_match(sc, exp[i], act[i])) {
+            fprintf(stderr, "golden: mismatch at trace entry %zu\n  expected: %s\n  actual:   %s\n",
+                    i + 1, join(exp[i]).c_str(), join(act[i]).c_str());
+            return false;
+        }
+    }
+    if (exp.size() != act.size()) {
+        fprintf(stderr, "golden: trace length differs (expected %zu entries, got %zu)\n", exp.size(), act.size());
+        const auto& extra = exp.size() > act.size() ? exp[n] : act[n];
+        fprintf(stderr, "  first unmatched: %s\n", join(extra).c_str());
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// MAIN
+//=============================================================================
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <scenario.scn> <golden.trace> [--update] [--actual <path>]\n", argv[0]);
+        return 2;
+    }
+    const char* scenario_path = argv[1];
+    const char* golden_path = argv[2];
+    bool update = false;
+    const char* actual_path = nullptr;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) update = true;
+        else if (strcmp(argv[i], "--actual") == 0 && i + 1 < argc) actual_path = argv[++i];
+    }
+
+    scenario_t sc;
+    if (!load_scenario(scenario_path, &sc)) return 2;
+
+    std::string name = scenario_path;
+    name = name.substr(name.find_last_of('/') + 1);
+    name = name.substr(0, name.find_last_of('.'));
+
+    std::string actual = run_scenario(sc, name.c_str());
+
+    if (actual_path) {
+        std::ofstream(actual_path) << actual;
+    }
+    if (update) {
+        std::ofstream(golden_path) << actual;
+        printf("golden: updated %s (%zu bytes)\n", golden_path, actual.size());
+        return 0;
+    }
+
+    std::ifstream golden_file(golden_path);
+    if (!golden_file) {
+        fprintf(stderr, "golden: missing %s (run with --update to create)\n", golden_path);
+        return 1;
+    }
+    std::stringstream expected;
+    expected << golden_file.rdbuf();
+
+    if (!compare_traces(sc, expected.str(), actual)) {
+        return 1;
+    }
+    printf("golden: %s matches (%zu trace entries)\n", name.c_str(), tokenize(actual).size());
+    return 0;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file Arduino.h
+ * @brief Host-side stand-in for the Arduino-ESP32 core
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Provides just enough of the Arduino API for the firmware modules in src/
+ * to compile and run on a PC:
+ * - Simulated millis()/micros() clock driven by the host harness
+ * - GPIO, ADC and pulseIn() backed by hooks in host_hal.h
+ * - Minimal String and HardwareSerial (Serial) implementations
+ * - The native USB port (USBSerial) with the esp32-s3-devkitc-1 defaults:
+ *   USB mode on, CDC on boot off, so the console stays on Serial
+ *
+ * Nothing in here talks to real hardware. Behaviour is controlled through
+ * the host_* functions declared in host_hal.h.
+ */
+
+#ifndef HOST_SHIM_ARDUINO_H
+#define HOST_SHIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <cmath>
+#include <algorithm>
+#include <string>
+
+using std::abs;
+using std::min;
+using std::max;
+
+//=============================================================================
+// ARDUINO CONSTANTS AND MACROS
+//=============================================================================
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT  0x01
+#define OUTPUT 0x03
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+//=============================================================================
+// TIMING
+//=============================================================================
+
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+//=============================================================================
+// GPIO / ADC
+//=============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+uint16_t analogRead(uint8_t pin);
+typedef enum { ADC_0db, ADC_2_5db, ADC_6db, ADC_11db } adc_attenuation_t;
+void analogReadResolution(uint8_t bits);
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation);
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout = 1000000UL);
+
+//=============================================================================
+// STRING
+//=============================================================================
+
+/**
+ * @brief Minimal Arduino String replacement backed by std::string
+ */
+class String {
+public:
+    String() {}
+    String(const char* s) : str_(s ? s : "") {}
+    String(const std::string& s) : str_(s) {}
+    String(char c) : str_(1, c) {}
+    String(int v) : str_(std::to_string(v)) {}
+    String(unsigned int v) : str_(std::to_string(v)) {}
+    String(long v) : str_(std::to_string(v)) {}
+    String(unsigned long v) : str_(std::to_string(v)) {}
+
+    const char* c_str() const { return str_.c_str(); }
+    unsigned int length() const { return (unsigned int)str_.length(); }
+    int indexOf(const char* s) const {
+        size_t pos = str_.find(s);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+
+    String& operator+=(const String& rhs) { str_ += rhs.str_; return *this; }
+    String& operator+=(const char* rhs) { str_ += rhs; return *this; }
+    String& operator+=(char rhs) { str_ += rhs; return *this; }
+    String& operator+=(int rhs) { str_ += std::to_string(rhs); return *this; }
+    String& operator+=(unsigned int rhs) { str_ += std::to_string(rhs); return *this; }
+    String& operator+=(uint8_t rhs) { str_ += std::to_string(rhs); return *this; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.str_ + b.str_); }
+    friend String operator+(const String& a, const char* b) { return String(a.str_ + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.str_); }
+
+    bool operator==(const char* rhs) const { return str_ == rhs; }
+
+private:
+    std::string str_;
+};
+
+//=============================================================================
+// SERIAL
+//=============================================================================
+
+/**
+ * @brief Host Serial: output goes to a capture sink, input comes from an
+ * injected RX buffer (see host_serial_* in host_hal.h)
+ */
+class HardwareSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    operator bool() const { return true; }
+
+    int available();
+    int availableForWrite();
+    int read();
+    int peek();
+    void flush() {}
+    void setTimeout(unsigned long timeout_ms) { timeout_ms_ = timeout_ms; }
+    float parseFloat();
+    long parseInt();
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buf, size_t len);
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    size_t print(const char* s);
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t print(char c);
+    size_t print(int v);
+    size_t print(unsigned int v);
+    size_t print(long v);
+    size_t print(unsigned long v);
+    size_t print(double v, int digits = 2);
+
+    size_t println();
+    size_t println(const char* s);
+    size_t println(const String& s) { return println(s.c_str()); }
+    size_t println(char c);
+    size_t println(int v);
+    size_t println(unsigned int v);
+    size_t println(long v);
+    size_t println(unsigned long v);
+    size_t println(double v, int digits = 2);
+
+private:
+    unsigned long timeout_ms_ = 1000;
+};
+
+extern HardwareSerial Serial;
+
+// Board defaults of esp32-s3-devkitc-1 (platformio.ini)
+#define ARDUINO_USB_MODE 1
+#define ARDUINO_USB_CDC_ON_BOOT 0
+
+/**
+ * @brief Host native USB port: its own RX buffer, capture sink and transmit
+ * space, separate from Serial (see host_usb_* in host_hal.h)
+ */
+class HWCDC {
+public:
+    void begin(unsigned long baud = 0) { (void)baud; }
+    size_t setTxBufferSize(size_t size) { return size; }
+
+    int available();
+    int availableForWrite();
+    int read();
+    size_t write(const uint8_t* buf, size_t len);
+};
+
+extern HWCDC USBSerial;
+
+#endif // HOST_SHIM_ARDUINO_H
@@ -0,0 +1,39 @@
+/**
+ * @file ArduinoOTA.h
+ * @brief Host-side no-op stand-in for ArduinoOTA
+ */
+
+#ifndef HOST_SHIM_ARDUINO_OTA_H
+#define HOST_SHIM_ARDUINO_OTA_H
+
+#include <Arduino.h>
+#include <functional>
+
+#define U_FLASH 0
+#define U_SPIFFS 100
+
+typedef enum {
+    OTA_AUTH_ERROR,
+    OTA_BEGIN_ERROR,
+    OTA_CONNECT_ERROR,
+    OTA_RECEIVE_ERROR,
+    OTA_END_ERROR
+} ota_error_t;
+
+class ArduinoOTAClass {
+public:
+    ArduinoOTAClass& setHostname(const char* name) { (void)name; return *this; }
+    ArduinoOTAClass& setPort(uint16_t port) { (void)port; return *this; }
+    ArduinoOTAClass& onStart(std::function<void(void)> fn) { (void)fn; return *this; }
+    ArduinoOTAClass& onEnd(std::function<void(void)> fn) { (void)fn; return *this; }
+    ArduinoOTAClass& onProgress(std::function<void(unsigned int, unsigned int)> fn) { (void)fn; return *this; }
+    ArduinoOTAClass& onError(std::function<void(ota_error_t)> fn) { (void)fn; return *this; }
+    void begin() {}
+    void end() {}
+    void handle() {}
+    int getCommand() { return U_FLASH; }
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif // HOST_SHIM_ARDUINO_OTA_H
@@ -0,0 +1,26 @@
+/**
+ * @file DallasTemperature.h
+ * @brief Host-side stand-in for the DS18B20 driver
+ * Readings come from host_set_temperature() (see host_hal.h).
+ */
+
+#ifndef HOST_SHIM_DALLAS_TEMPERATURE_H
+#define HOST_SHIM_DALLAS_TEMPERATURE_H
+
+#include <Arduino.h>
+#include "OneWire.h"
+#include "host_hal.h"
+
+#define DEVICE_DISCONNECTED_C -127
+
+class DallasTemperature {
+public:
+    explicit DallasTemperature(OneWire* bus) : bus_(bus) {}
+    void begin() {}
+    void requestTemperatures() {}
+    float getTempCByIndex(uint8_t index) { (void)index; return host_get_temperature(); }
+private:
+    OneWire* bus_;
+};
+
+#endif // HOST_SHIM_DALLAS_TEMPERATURE_H
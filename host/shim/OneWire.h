@@ -0,0 +1,18 @@
+/**
+ * @file OneWire.h
+ * @brief Host-side stand-in for the OneWire library
+ */
+
+#ifndef HOST_SHIM_ONEWIRE_H
+#define HOST_SHIM_ONEWIRE_H
+
+#include <Arduino.h>
+
+class OneWire {
+public:
+    explicit OneWire(uint8_t pin) : pin_(pin) {}
+private:
+    uint8_t pin_;
+};
+
+#endif // HOST_SHIM_ONEWIRE_H
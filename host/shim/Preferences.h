@@ -0,0 +1,51 @@
+/**
+ * @file Preferences.h
+ * @brief Host-side in-memory replacement for the ESP32 Preferences (NVS) API
+ */
+
+#ifndef HOST_SHIM_PREFERENCES_H
+#define HOST_SHIM_PREFERENCES_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Namespace-scoped key/value store held in process memory
+ * Contents persist across begin()/end() until host_nvs_clear()/host_reset().
+ */
+class Preferences {
+public:
+    bool begin(const char* name, bool read_only = false);
+    void end();
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putBytes(const char* key, const void* value, size_t len);
+    size_t getBytesLength(const char* key);
+    size_t getBytes(const char* key, void* buf, size_t maxLen);
+
+    size_t putUChar(const char* key, uint8_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint8_t getUChar(const char* key, uint8_t default_value = 0) { return get_scalar(key, default_value); }
+    size_t putUInt(const char* key, uint32_t value) { return putBytes(key, &value, sizeof(value)); }
+    uint32_t getUInt(const char* key, uint32_t default_value = 0) { return get_scalar(key, default_value); }
+    size_t putFloat(const char* key, float value) { return putBytes(key, &value, sizeof(value)); }
+    float getFloat(const char* key, float default_value = 0.0f) { return get_scalar(key, default_value); }
+    size_t putString(const char* key, const char* value) { return putBytes(key, value, strlen(value) + 1); }
+    size_t getString(const char* key, char* value, size_t maxLen);
+
+private:
+    template <typename T>
+    T get_scalar(const char* key, T default_value) {
+        T value;
+        if (getBytesLength(key) != sizeof(T) || getBytes(key, &value, sizeof(T)) != sizeof(T)) {
+            return default_value;
+        }
+        return value;
+    }
+
+    std::string ns_;
+    bool read_only_ = false;
+    bool open_ = false;
+};
+
+#endif // HOST_SHIM_PREFERENCES_H
@@ -0,0 +1,79 @@
+/**
+ * @file WiFi.h
+ * @brief Host-side stand-in for the Arduino-ESP32 WiFi library
+ *
+ * The host build never has a network link: WiFi.status() reports
+ * WL_DISCONNECTED, so CommunicationManager stays in its Serial paths.
+ */
+
+#ifndef HOST_SHIM_WIFI_H
+#define HOST_SHIM_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED
+} wl_status_t;
+
+#define WIFI_STA 1
+
+class IPAddress {
+public:
+    IPAddress() : bytes_{0, 0, 0, 0} {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : bytes_{a, b, c, d} {}
+    uint8_t operator[](int index) const { return bytes_[index]; }
+    String toString() const {
+        char text[16];
+        snprintf(text, sizeof(text), "%u.%u.%u.%u", bytes_[0], bytes_[1], bytes_[2], bytes_[3]);
+        return String(text);
+    }
+private:
+    uint8_t bytes_[4];
+};
+
+class WiFiClient {
+public:
+    operator bool() const { return false; }
+    uint8_t connected() { return 0; }
+    int available() { return 0; }
+    int read() { return -1; }
+    int read(uint8_t* buf, size_t size) { (void)buf; (void)size; return -1; }
+    size_t write(const uint8_t* buf, size_t len) { (void)buf; return len; }
+    int fd() const { return -1; }
+    size_t print(const String& s) { return s.length(); }
+    size_t print(const char* s) { return strlen(s); }
+    size_t println(const char* s) { return strlen(s) + 2; }
+    void stop() {}
+    void clear() {}
+    void setNoDelay(bool enabled) { (void)enabled; }
+};
+
+class WiFiServer {
+public:
+    explicit WiFiServer(uint16_t port) : port_(port) {}
+    void begin() {}
+    void end() {}
+    WiFiClient accept() { return WiFiClient(); }
+    WiFiClient available() { return WiFiClient(); }
+private:
+    uint16_t port_;
+};
+
+class WiFiClass {
+public:
+    wl_status_t status() { return WL_DISCONNECTED; }
+    bool mode(int m) { (void)m; return true; }
+    wl_status_t begin(const char* ssid, const char* pass) { (void)ssid; (void)pass; return WL_DISCONNECTED; }
+    bool disconnect() { return true; }
+    IPAddress localIP() { return IPAddress(); }
+};
+
+extern WiFiClass WiFi;
+
+#endif // HOST_SHIM_WIFI_H
@@ -0,0 +1,21 @@
+/**
+ * @file WiFiUdp.h
+ * @brief Host-side stand-in for the Arduino-ESP32 WiFiUDP class
+ *
+ * No network on the host: packets are accepted and discarded, endPacket()
+ * reports failure like the ESP32 stack does without a link.
+ */
+
+#ifndef HOST_SHIM_WIFIUDP_H
+#define HOST_SHIM_WIFIUDP_H
+
+#include <WiFi.h>
+
+class WiFiUDP {
+public:
+    int beginPacket(IPAddress ip, uint16_t port) { (void)ip; (void)port; return 1; }
+    size_t write(const uint8_t* buf, size_t len) { (void)buf; return len; }
+    int endPacket() { return 0; }
+};
+
+#endif // HOST_SHIM_WIFIUDP_H
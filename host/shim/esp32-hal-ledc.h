@@ -0,0 +1,16 @@
+/**
+ * @file esp32-hal-ledc.h
+ * @brief Host-side stand-in for the Arduino-ESP32 3.x LEDC API
+ * Duty writes are recorded per pin and reported through host_set_pwm_hook().
+ */
+
+#ifndef HOST_SHIM_ESP32_HAL_LEDC_H
+#define HOST_SHIM_ESP32_HAL_LEDC_H
+
+#include <Arduino.h>
+
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+uint32_t ledcRead(uint8_t pin);
+
+#endif // HOST_SHIM_ESP32_HAL_LEDC_H
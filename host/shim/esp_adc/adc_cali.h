@@ -0,0 +1,49 @@
+/**
+ * @file adc_cali.h
+ * @brief Host-side stand-in for the ESP-IDF ADC calibration API (ESP32-S3)
+ *
+ * The curve-fitting scheme converts like the S3 driver: a line through the
+ * chip's eFuse calibration point (coeff_a = 65536 * mV / code), minus an
+ * error polynomial in the line voltage with integer coefficient pairs and
+ * signs per attenuation. A chip "has" an eFuse point once the harness sets
+ * one with host_set_adc_efuse(); after host_reset() it has none and scheme
+ * creation fails with ESP_ERR_NOT_SUPPORTED, like an uncalibrated chip.
+ */
+
+#ifndef HOST_SHIM_ESP_ADC_CALI_H
+#define HOST_SHIM_ESP_ADC_CALI_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum { ADC_UNIT_1, ADC_UNIT_2 } adc_unit_t;
+
+typedef enum {
+    ADC_CHANNEL_0, ADC_CHANNEL_1, ADC_CHANNEL_2, ADC_CHANNEL_3, ADC_CHANNEL_4,
+    ADC_CHANNEL_5, ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_8, ADC_CHANNEL_9
+} adc_channel_t;
+
+typedef enum { ADC_ATTEN_DB_0, ADC_ATTEN_DB_2_5, ADC_ATTEN_DB_6, ADC_ATTEN_DB_12 } adc_atten_t;
+
+typedef enum {
+    ADC_BITWIDTH_DEFAULT = 0,
+    ADC_BITWIDTH_9 = 9,
+    ADC_BITWIDTH_10 = 10,
+    ADC_BITWIDTH_11 = 11,
+    ADC_BITWIDTH_12 = 12
+} adc_bitwidth_t;
+
+typedef struct adc_cali_scheme_t* adc_cali_handle_t;
+
+typedef struct {
+    adc_unit_t unit_id;
+    adc_channel_t chan;
+    adc_atten_t atten;
+    adc_bitwidth_t bitwidth;
+} adc_cali_curve_fitting_config_t;
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t* config, adc_cali_handle_t* ret_handle);
+esp_err_t adc_cali_delete_scheme_curve_fitting(adc_cali_handle_t handle);
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int* voltage);
+
+#endif // HOST_SHIM_ESP_ADC_CALI_H
@@ -0,0 +1,11 @@
+/**
+ * @file adc_cali_scheme.h
+ * @brief Host-side stand-in: the scheme constructors live in adc_cali.h
+ */
+
+#ifndef HOST_SHIM_ESP_ADC_CALI_SCHEME_H
+#define HOST_SHIM_ESP_ADC_CALI_SCHEME_H
+
+#include "esp_adc/adc_cali.h"
+
+#endif // HOST_SHIM_ESP_ADC_CALI_SCHEME_H
@@ -0,0 +1,27 @@
+/**
+ * @file esp_system.h
+ * @brief Host-side stand-in for the ESP-IDF reset reason API
+ * The reason reported for the current "boot" is set by the harness with
+ * host_set_reset_reason() (power-on after host_reset()).
+ */
+
+#ifndef HOST_SHIM_ESP_SYSTEM_H
+#define HOST_SHIM_ESP_SYSTEM_H
+
+typedef enum {
+    ESP_RST_UNKNOWN,
+    ESP_RST_POWERON,
+    ESP_RST_EXT,
+    ESP_RST_SW,
+    ESP_RST_PANIC,
+    ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT,
+    ESP_RST_WDT,
+    ESP_RST_DEEPSLEEP,
+    ESP_RST_BROWNOUT,
+    ESP_RST_SDIO
+} esp_reset_reason_t;
+
+esp_reset_reason_t esp_reset_reason(void);
+
+#endif // HOST_SHIM_ESP_SYSTEM_H
@@ -0,0 +1,599 @@
+/**
+ * @file host_hal.cpp
+ * @brief Host-side implementation of the Arduino shim and its control hooks
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <ArduinoOTA.h>
+#include <esp32-hal-ledc.h>
+#include <esp_timer.h>
+#include <esp_system.h>
+#include <esp_adc/adc_cali_scheme.h>
+#include "host_hal.h"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+//=============================================================================
+// SHIM STATE
+//=============================================================================
+
+namespace {
+
+constexpr int kMaxPins = 64;
+
+struct host_state_t {
+    uint64_t now_us = 0;
+    uint32_t auto_tick_us = 0;
+
+    uint8_t digital[kMaxPins] = {};
+    uint16_t adc[kMaxPins] = {};
+    uint32_t pwm[kMaxPins] = {};
+    host_adc_hook_t adc_hook = nullptr;
+    void* adc_ctx = nullptr;
+    host_pulse_hook_t pulse_hook = nullptr;
+    void* pulse_ctx = nullptr;
+    unsigned long pulse_us = 0;
+    host_pwm_hook_t pwm_hook = nullptr;
+    void* pwm_ctx = nullptr;
+    float temperature = 25.0f;
+    int reset_reason = ESP_RST_POWERON;
+    uint32_t efuse_code[4] = {};          // ADC1 eFuse calibration point per attenuation (0 = none)
+    uint32_t efuse_mv[4] = {};
+
+    std::deque<uint8_t> rx;
+    host_output_hook_t out_hook = nullptr;
+    void* out_ctx = nullptr;
+    bool echo = false;
+    int tx_space = 4096;
+    int tx_used = 0;                      // Bytes written since the clock last moved
+
+    std::deque<uint8_t> usb_rx;           // Native USB port (USBSerial)
+    host_output_hook_t usb_out_hook = nullptr;
+    void* usb_out_ctx = nullptr;
+    int usb_tx_space = 4096;
+    int usb_tx_used = 0;
+};
+
+host_state_t g_host;
+
+// esp_timer instances (owned here, freed by esp_timer_delete)
+struct host_timer_t {
+    esp_timer_cb_t callback;
+    void* arg;
+    uint64_t deadline_us;
+    uint64_t period_us;          // 0 = one-shot
+    bool active;
+};
+std::vector<host_timer_t*> g_timers;
+bool g_firing = false;
+
+// NVS contents: namespace -> key -> blob
+std::map<std::string, std::map<std::string, std::vector<uint8_t>>> g_nvs;
+
+/**
+ * @brief Move the clock to 'target', firing due timers in deadline order
+ * Each callback sees the clock at its own deadline.
+ */
+void advance_to(uint64_t target) {
+    if (target > g_host.now_us) {         // Transmit buffers drained
+        g_host.tx_used = 0;
+        g_host.usb_tx_used = 0;
+    }
+    if (g_firing) {                       // Callback moved time: no nested dispatch
+        g_host.now_us = target;
+        return;
+    }
+    for (;;) {
+        host_timer_t* next = nullptr;
+        for (host_timer_t* t : g_timers) {
+            if (t->active && t->deadline_us <= target && (!next || t->deadline_us < next->deadline_us)) {
+                next = t;
+            }
+        }
+        if (!next) break;
+        if (next->deadline_us > g_host.now_us) g_host.now_us = next->deadline_us;
+        if (next->period_us) {
+            next->deadline_us += next->period_us;
+        } else {
+            next->active = false;
+        }
+        g_firing = true;
+        next->callback(next->arg);
+        g_firing = false;
+    }
+    if (target > g_host.now_us) g_host.now_us = target;
+}
+
+void auto_tick(void) {
+    if (g_host.auto_tick_us) advance_to(g_host.now_us + g_host.auto_tick_us);
+}
+
+void serial_emit(const char* data, size_t len) {
+    g_host.tx_used += (int)len;
+    if (g_host.out_hook) {
+        g_host.out_hook(data, len, g_host.out_ctx);
+    }
+    if (g_host.echo) {
+        fwrite(data, 1, len, stdout);
+    }
+}
+
+} // namespace
+
+HardwareSerial Serial;
+HWCDC USBSerial;
+WiFiClass WiFi;
+ArduinoOTAClass ArduinoOTA;
+
+//=============================================================================
+// HOST CONTROL INTERFACE
+//=============================================================================
+
+void host_reset(void) {
+    g_host = host_state_t();
+    g_nvs.clear();
+    // Timers are hardware-like: handles survive a reset, pending expiries do not
+    for (host_timer_t* t : g_timers) t->active = false;
+}
+
+void host_set_micros(uint64_t us) { g_host.now_us = us; }
+uint64_t host_get_micros(void) { return g_host.now_us; }
+void host_advance_ms(uint32_t ms) { advance_to(g_host.now_us + (uint64_t)ms * 1000u); }
+void host_advance_us(uint32_t us) { advance_to(g_host.now_us + us); }
+void host_set_auto_tick_us(uint32_t us) { g_host.auto_tick_us = us; }
+
+void host_set_adc_hook(host_adc_hook_t hook, void* ctx) { g_host.adc_hook = hook; g_host.adc_ctx = ctx; }
+void host_set_adc_value(uint8_t pin, uint16_t code) { if (pin < kMaxPins) g_host.adc[pin] = code; }
+void host_set_pulse_hook(host_pulse_hook_t hook, void* ctx) { g_host.pulse_hook = hook; g_host.pulse_ctx = ctx; }
+void host_set_pulse_value(unsigned long echo_us) { g_host.pulse_us = echo_us; }
+void host_set_temperature(float celsius) { g_host.temperature = celsius; }
+float host_get_temperature(void) { return g_host.temperature; }
+void host_set_pwm_hook(host_pwm_hook_t hook, void* ctx) { g_host.pwm_hook = hook; g_host.pwm_ctx = ctx; }
+uint32_t host_get_pwm_duty(uint8_t pin) { return pin < kMaxPins ? g_host.pwm[pin] : 0; }
+int host_get_digital(uint8_t pin) { return pin < kMaxPins ? g_host.digital[pin] : 0; }
+void host_set_reset_reason(int reason) { g_host.reset_reason = reason; }
+
+void host_set_adc_efuse(int atten, uint32_t code, uint32_t millivolts) {
+    if (atten < 0 || atten > 3) return;
+    g_host.efuse_code[atten] = code;
+    g_host.efuse_mv[atten] = millivolts;
+}
+
+void host_serial_feed(const uint8_t* data, size_t len) { g_host.rx.insert(g_host.rx.end(), data, data + len); }
+size_t host_serial_rx_pending(void) { return g_host.rx.size(); }
+void host_serial_set_output_hook(host_output_hook_t hook, void* ctx) { g_host.out_hook = hook; g_host.out_ctx = ctx; }
+void host_serial_set_tx_space(int bytes) { g_host.tx_space = bytes; }
+void host_serial_set_echo(bool enabled) { g_host.echo = enabled; }
+
+void host_usb_feed(const uint8_t* data, size_t len) { g_host.usb_rx.insert(g_host.usb_rx.end(), data, data + len); }
+void host_usb_set_output_hook(host_output_hook_t hook, void* ctx) { g_host.usb_out_hook = hook; g_host.usb_out_ctx = ctx; }
+void host_usb_set_tx_space(int bytes) { g_host.usb_tx_space = bytes; }
+
+void host_nvs_clear(void) { g_nvs.clear(); }
+
+void host_nvs_put_raw(const char* ns, const char* key, const void* data, size_t len) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    g_nvs[ns][key].assign(bytes, bytes + len);
+}
+
+//=============================================================================
+// TIMING
+//=============================================================================
+
+uint32_t millis(void) {
+    auto_tick();
+    return (uint32_t)(g_host.now_us / 1000u);
+}
+
+uint32_t micros(void) {
+    auto_tick();
+    return (uint32_t)g_host.now_us;
+}
+
+void delay(uint32_t ms) { host_advance_ms(ms); }
+void delayMicroseconds(uint32_t us) { host_advance_us(us); }
+
+//=============================================================================
+// GPIO / ADC
+//=============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+    if (pin < kMaxPins) g_host.digital[pin] = val ? HIGH : LOW;
+}
+
+int digitalRead(uint8_t pin) { return host_get_digital(pin); }
+
+uint16_t analogRead(uint8_t pin) {
+    uint16_t code = g_host.adc_hook ? g_host.adc_hook(pin, g_host.adc_ctx)
+                                    : (pin < kMaxPins ? g_host.adc[pin] : 0);
+    return code > 4095 ? 4095 : code;
+}
+
+void analogReadResolution(uint8_t bits) {
+    (void)bits;
+}
+
+void analogSetPinAttenuation(uint8_t pin, adc_attenuation_t attenuation) {
+    (void)pin; (void)attenuation;
+}
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+    (void)state;
+    unsigned long width = g_host.pulse_hook ? g_host.pulse_hook(pin, g_host.pulse_ctx) : g_host.pulse_us;
+    if (width == 0 || width > timeout) {
+        host_advance_us((uint32_t)timeout);
+        return 0;
+    }
+    host_advance_us((uint32_t)width);
+    return width;
+}
+
+//=============================================================================
+// LEDC
+//=============================================================================
+
+//=============================================================================
+// ESP_TIMER
+//=============================================================================
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle) {
+    if (!args || !args->callback || !out_handle) return ESP_ERR_INVALID_ARG;
+    host_timer_t* t = new host_timer_t{args->callback, args->arg, 0, 0, false};
+    g_timers.push_back(t);
+    *out_handle = reinterpret_cast<esp_timer_handle_t>(t);
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    host_timer_t* t = reinterpret_cast<host_timer_t*>(timer);
+    if (!t) return ESP_ERR_INVALID_ARG;
+    if (t->active) return ESP_ERR_INVALID_STATE;
+    t->deadline_us = g_host.now_us + timeout_us;
+    t->period_us = 0;
+    t->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period) {
+    host_timer_t* t = reinterpret_cast<host_timer_t*>(timer);
+    if (!t || period == 0) return ESP_ERR_INVALID_ARG;
+    if (t->active) return ESP_ERR_INVALID_STATE;
+    t->deadline_us = g_host.now_us + period;
+    t->period_us = period;
+    t->active = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    host_timer_t* t = reinterpret_cast<host_timer_t*>(timer);
+    if (!t) return ESP_ERR_INVALID_ARG;
+    if (!t->active) return ESP_ERR_INVALID_STATE;
+    t->active = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    host_timer_t* t = reinterpret_cast<host_timer_t*>(timer);
+    if (!t) return ESP_ERR_INVALID_ARG;
+    for (size_t i = 0; i < g_timers.size(); i++) {
+        if (g_timers[i] == t) {
+            g_timers.erase(g_timers.begin() + i);
+            delete t;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_INVALID_ARG;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+    host_timer_t* t = reinterpret_cast<host_timer_t*>(timer);
+    return t && t->active;
+}
+
+int64_t esp_timer_get_time(void) {
+    return (int64_t)g_host.now_us;
+}
+
+esp_reset_reason_t esp_reset_reason(void) {
+    return (esp_reset_reason_t)g_host.reset_reason;
+}
+
+//=============================================================================
+// ADC CALIBRATION (curve fitting, ESP32-S3 ADC1)
+//=============================================================================
+
+namespace {
+
+// Error polynomial terms {numerator, denominator} and signs per attenuation,
+// from the ESP-IDF ESP32-S3 curve-fitting table
+const uint64_t kErrorCoef[4][5][2] = {
+    {{27856531419538344ull, 10000000000000000ull}, {50871540569528ull, 10000000000000000ull},
+     {9798249589ull, 1000000000000000ull}, {0, 1}, {0, 1}},
+    {{29831022915028695ull, 10000000000000000ull}, {49393185868806ull, 10000000000000000ull},
+     {101379430548ull, 10000000000000000ull}, {0, 1}, {0, 1}},
+    {{23285545746296417ull, 10000000000000000ull}, {147640181047414ull, 10000000000000000ull},
+     {208385525314ull, 10000000000000000ull}, {0, 1}, {0, 1}},
+    {{644403418269478ull, 1000000000000000ull}, {644334888647536ull, 10000000000000000ull},
+     {1297891447611ull, 10000000000000000ull}, {70769718ull, 1000000000000000ull},
+     {13515ull, 1000000000000000ull}},
+};
+const int32_t kErrorSign[4][5] = {
+    {-1, -1, 1, 0, 0},
+    {-1, -1, 1, 0, 0},
+    {-1, 1, 1, 0, 0},
+    {-1, -1, 1, -1, 1},
+};
+const int kErrorTerms[4] = {3, 3, 3, 5};
+constexpr uint64_t kCoeffAScaling = 65536;
+
+struct host_adc_cali_t {
+    int atten;
+    uint64_t coeff_a;
+};
+
+int32_t reading_error(uint64_t v_cali_1, int atten) {
+    if (v_cali_1 == 0) return 0;
+    int32_t error = 0;
+    uint64_t variable = 1;
+    for (int i = 0; i < kErrorTerms[atten]; i++) {
+        if (i > 0) variable *= v_cali_1;
+        uint64_t term = variable * kErrorCoef[atten][i][0] / kErrorCoef[atten][i][1];
+        error += (int32_t)term * kErrorSign[atten][i];
+    }
+    return error;
+}
+
+}  // namespace
+
+esp_err_t adc_cali_create_scheme_curve_fitting(const adc_cali_curve_fitting_config_t* config, adc_cali_handle_t* ret_handle) {
+    if (!config || !ret_handle || config->unit_id != ADC_UNIT_1 || config->atten > ADC_ATTEN_DB_12 ||
+        (config->bitwidth != ADC_BITWIDTH_DEFAULT && config->bitwidth != ADC_BITWIDTH_12)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int atten = config->atten;
+    if (g_host.efuse_code[atten] == 0 || g_host.efuse_mv[atten] == 0) return ESP_ERR_NOT_SUPPORTED;
+    host_adc_cali_t* cali = new host_adc_cali_t{atten, kCoeffAScaling * g_host.efuse_mv[atten] / g_host.efuse_code[atten]};
+    *ret_handle = reinterpret_cast<adc_cali_handle_t>(cali);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_delete_scheme_curve_fitting(adc_cali_handle_t handle) {
+    if (!handle) return ESP_ERR_INVALID_ARG;
+    delete reinterpret_cast<host_adc_cali_t*>(handle);
+    return ESP_OK;
+}
+
+esp_err_t adc_cali_raw_to_voltage(adc_cali_handle_t handle, int raw, int* voltage) {
+    if (!handle || !voltage || raw < 0 || raw > 4095) return ESP_ERR_INVALID_ARG;
+    const host_adc_cali_t* cali = reinterpret_cast<const host_adc_cali_t*>(handle);
+    uint64_t v_cali_1 = (uint64_t)raw * cali->coeff_a / kCoeffAScaling;
+    *voltage = (int32_t)v_cali_1 - reading_error(v_cali_1, cali->atten);
+    return ESP_OK;
+}
+
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution) {
+    (void)freq; (void)resolution;
+    return pin < kMaxPins;
+}
+
+bool ledcWrite(uint8_t pin, uint32_t duty) {
+    if (pin >= kMaxPins) return false;
+    g_host.pwm[pin] = duty;
+    if (g_host.pwm_hook) {
+        g_host.pwm_hook(pin, duty, g_host.pwm_ctx);
+    }
+    return true;
+}
+
+uint32_t ledcRead(uint8_t pin) { return host_get_pwm_duty(pin); }
+
+//=============================================================================
+// SERIAL
+//=============================================================================
+
+int HardwareSerial::available() { return (int)g_host.rx.size(); }
+int HardwareSerial::availableForWrite() { return std::max(0, g_host.tx_space - g_host.tx_used); }
+
+int HardwareSerial::read() {
+    if (g_host.rx.empty()) return -1;
+    uint8_t c = g_host.rx.front();
+    g_host.rx.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek() { return g_host.rx.empty() ? -1 : g_host.rx.front(); }
+
+float HardwareSerial::parseFloat() {
+    // Skip until something that can start a number; an empty buffer behaves
+    // like the device-side timeout and returns 0.
+    while (!g_host.rx.empty()) {
+        int c = g_host.rx.front();
+        if ((c >= '0' && c <= '9') || c == '-' || c == '.') break;
+        g_host.rx.pop_front();
+    }
+    if (g_host.rx.empty()) {
+        host_advance_ms((uint32_t)timeout_ms_);
+        return 0.0f;
+    }
+
+    bool negative = false;
+    bool fraction = false;
+    float value = 0.0f;
+    float scale = 1.0f;
+    if (g_host.rx.front() == '-') {
+        negative = true;
+        g_host.rx.pop_front();
+    }
+    while (!g_host.rx.empty()) {
+        int c = g_host.rx.front();
+        if (c == '.' && !fraction) {
+            fraction = true;
+        } else if (c >= '0' && c <= '9') {
+            if (fraction) {
+                scale *= 0.1f;
+                value += (c - '0') * scale;
+            } else {
+                value = value * 10.0f + (c - '0');
+            }
+        } else {
+            break;
+        }
+        g_host.rx.pop_front();
+    }
+    return negative ? -value : value;
+}
+
+long HardwareSerial::parseInt() {
+    // Same skipping and timeout as parseFloat(); stops at '.', so dotted
+    // addresses read one octet per call
+    while (!g_host.rx.empty()) {
+        int c = g_host.rx.front();
+        if ((c >= '0' && c <= '9') || c == '-') break;
+        g_host.rx.pop_front();
+    }
+    if (g_host.rx.empty()) {
+        host_advance_ms((uint32_t)timeout_ms_);
+        return 0;
+    }
+
+    bool negative = false;
+    long value = 0;
+    if (g_host.rx.front() == '-') {
+        negative = true;
+        g_host.rx.pop_front();
+    }
+    while (!g_host.rx.empty() && g_host.rx.front() >= '0' && g_host.rx.front() <= '9') {
+        value = value * 10 + (g_host.rx.front() - '0');
+        g_host.rx.pop_front();
+    }
+    return negative ? -value : value;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    char ch = (char)c;
+    serial_emit(&ch, 1);
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t len) {
+    serial_emit(reinterpret_cast<const char*>(buf), len);
+    return len;
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    char buffer[1024];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    size_t n = (size_t)len < sizeof(buffer) ? (size_t)len : sizeof(buffer) - 1;
+    serial_emit(buffer, n);
+    return n;
+}
+
+size_t HardwareSerial::print(const char* s) {
+    size_t n = strlen(s);
+    serial_emit(s, n);
+    return n;
+}
+
+size_t HardwareSerial::print(char c) { return write((uint8_t)c); }
+size_t HardwareSerial::print(int v) { return printf("%d", v); }
+size_t HardwareSerial::print(unsigned int v) { return printf("%u", v); }
+size_t HardwareSerial::print(long v) { return printf("%ld", v); }
+size_t HardwareSerial::print(unsigned long v) { return printf("%lu", v); }
+size_t HardwareSerial::print(double v, int digits) { return printf("%.*f", digits, v); }
+
+size_t HardwareSerial::println() { return print("\r\n"); }
+size_t HardwareSerial::println(const char* s) { return print(s) + println(); }
+size_t HardwareSerial::println(char c) { return print(c) + println(); }
+size_t HardwareSerial::println(int v) { return print(v) + println(); }
+size_t HardwareSerial::println(unsigned int v) { return print(v) + println(); }
+size_t HardwareSerial::println(long v) { return print(v) + println(); }
+size_t HardwareSerial::println(unsigned long v) { return print(v) + println(); }
+size_t HardwareSerial::println(double v, int digits) { return print(v, digits) + println(); }
+
+//=============================================================================
+// NATIVE USB PORT
+//=============================================================================
+
+int HWCDC::available() { return (int)g_host.usb_rx.size(); }
+int HWCDC::availableForWrite() { return std::max(0, g_host.usb_tx_space - g_host.usb_tx_used); }
+
+int HWCDC::read() {
+    if (g_host.usb_rx.empty()) return -1;
+    uint8_t c = g_host.usb_rx.front();
+    g_host.usb_rx.pop_front();
+    return c;
+}
+
+size_t HWCDC::write(const uint8_t* buf, size_t len) {
+    g_host.usb_tx_used += (int)len;
+    if (g_host.usb_out_hook) {
+        g_host.usb_out_hook(reinterpret_cast<const char*>(buf), len, g_host.usb_out_ctx);
+    }
+    return len;
+}
+
+//=============================================================================
+// PREFERENCES
+//=============================================================================
+
+bool Preferences::begin(const char* name, bool read_only) {
+    ns_ = name ? name : "";
+    read_only_ = read_only;
+    open_ = true;
+    return true;
+}
+
+void Preferences::end() { open_ = false; }
+
+bool Preferences::clear() {
+    if (!open_ || read_only_) return false;
+    g_nvs[ns_].clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    if (!open_ || read_only_) return false;
+    return g_nvs[ns_].erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return open_ && g_nvs[ns_].count(key) > 0;
+}
+
+size_t Preferences::putBytes(const char* key, const void* value, size_t len) {
+    if (!open_ || read_only_ || !key || !value) return 0;
+    host_nvs_put_raw(ns_.c_str(), key, value, len);
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char* key) {
+    if (!open_) return 0;
+    auto& space = g_nvs[ns_];
+    auto it = space.find(key);
+    return it == space.end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t maxLen) {
+    size_t len = getBytesLength(key);
+    if (len == 0 || len > maxLen || !buf) return 0;
+    memcpy(buf, g_nvs[ns_][key].data(), len);
+    return len;
+}
+
+size_t Preferences::getString(const char* key, char* value, size_t maxLen) {
+    size_t len = getBytes(key, value, maxLen);
+    if (len > 0) value[len - 1] = '\0';
+    return len;
+}
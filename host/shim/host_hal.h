@@ -0,0 +1,87 @@
+/**
+ * @file host_hal.h
+ * @brief Control interface for the host-side Arduino shim
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Harnesses (fuzzers, simulator, golden traces) use these functions to drive
+ * the simulated clock, feed ADC/ultrasonic/temperature values, inject serial
+ * input and capture output. Firmware code never includes this header.
+ */
+
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+//=============================================================================
+// HOOK TYPES
+//=============================================================================
+
+typedef uint16_t (*host_adc_hook_t)(uint8_t pin, void* ctx);          // Returns 12-bit ADC code
+typedef unsigned long (*host_pulse_hook_t)(uint8_t pin, void* ctx);    // Returns echo width (us), 0 = timeout
+typedef void (*host_pwm_hook_t)(uint8_t pin, uint32_t duty, void* ctx); // Called on every ledcWrite()
+typedef void (*host_output_hook_t)(const char* data, size_t len, void* ctx);
+
+//=============================================================================
+// LIFECYCLE
+//=============================================================================
+
+// Reset clock, pins, hooks, NVS and serial buffers to power-on defaults
+void host_reset(void);
+
+//=============================================================================
+// CLOCK
+//=============================================================================
+
+// Advancing the clock fires due esp_timer callbacks at their exact deadlines
+void host_set_micros(uint64_t us);
+uint64_t host_get_micros(void);
+void host_advance_ms(uint32_t ms);
+void host_advance_us(uint32_t us);
+
+// Advance the clock by this many microseconds on every millis()/micros() call.
+// Lets busy-wait loops in firmware terminate when nothing else moves time.
+void host_set_auto_tick_us(uint32_t us);
+
+//=============================================================================
+// PERIPHERALS
+//=============================================================================
+
+void host_set_adc_hook(host_adc_hook_t hook, void* ctx);
+void host_set_adc_value(uint8_t pin, uint16_t code);           // Used when no hook installed
+void host_set_pulse_hook(host_pulse_hook_t hook, void* ctx);
+void host_set_pulse_value(unsigned long echo_us);              // Used when no hook installed
+void host_set_temperature(float celsius);                      // DS18B20 reading
+float host_get_temperature(void);
+void host_set_pwm_hook(host_pwm_hook_t hook, void* ctx);
+uint32_t host_get_pwm_duty(uint8_t pin);
+int host_get_digital(uint8_t pin);
+
+void host_set_reset_reason(int reason);                        // esp_reset_reason_t of the current boot
+void host_set_adc_efuse(int atten, uint32_t code, uint32_t millivolts);   // ADC1 eFuse point (adc_atten_t); 0 = none
+
+//=============================================================================
+// SERIAL
+//=============================================================================
+
+void host_serial_feed(const uint8_t* data, size_t len);        // Append bytes to Serial RX
+size_t host_serial_rx_pending(void);
+void host_serial_set_output_hook(host_output_hook_t hook, void* ctx);
+void host_serial_set_echo(bool enabled);                       // Mirror TX to stdout
+void host_serial_set_tx_space(int bytes);                      // availableForWrite() per clock step (default 4096)
+
+void host_usb_feed(const uint8_t* data, size_t len);           // Append bytes to USBSerial RX
+void host_usb_set_output_hook(host_output_hook_t hook, void* ctx);
+void host_usb_set_tx_space(int bytes);                         // Same as Serial, for USBSerial
+
+//=============================================================================
+// NVS (Preferences)
+//=============================================================================
+
+void host_nvs_clear(void);
+void host_nvs_put_raw(const char* ns, const char* key, const void* data, size_t len);
+
+#endif // HOST_HAL_H
@@ -0,0 +1,14 @@
+/**
+ * @file sockets.h
+ * @brief Host-side stand-in for lwIP's BSD socket API
+ * The host's own sockets provide send(), MSG_DONTWAIT and errno. Shim
+ * WiFiClients have no descriptor (fd() is -1), so they are never reached.
+ */
+
+#ifndef HOST_SHIM_LWIP_SOCKETS_H
+#define HOST_SHIM_LWIP_SOCKETS_H
+
+#include <sys/socket.h>
+#include <errno.h>
+
+#endif // HOST_SHIM_LWIP_SOCKETS_H
@@ -0,0 +1,255 @@
+/**
+ * @file reservoir.cpp
+ * @brief Simulated hydroponic reservoir implementation
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "reservoir.h"
+
+#include <math.h>
+#include <string.h>
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+// Probe voltage at pH 7.00 for the simulated pH front-end (mV)
+static constexpr float kPhNeutralMv = 1500.0f;
+
+// Ultrasonic sensor mounting: distances for the 3-point volume calibration
+static constexpr float kEmptyDistanceCm = 50.0f;
+static constexpr float kHalfDistanceCm = 30.0f;
+static constexpr float kFullDistanceCm = 10.0f;
+
+/**
+ * @brief splitmix64 step - specified bit-for-bit, unlike std:: distributions
+ */
+static uint64_t next_u64(reservoir_t* r) {
+    uint64_t z = (r->rng_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Standard normal sample (Box-Muller)
+ */
+static float gaussian(reservoir_t* r) {
+    double u1 = ((next_u64(r) >> 11) + 1.0) * (1.0 / 9007199254740993.0);
+    double u2 = (next_u64(r) >> 11) * (1.0 / 9007199254740992.0);
+    return (float)(sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2));
+}
+
+static uint16_t mv_to_adc(float mv) {
+    float code = mv * (4095.0f / 3300.0f);
+    if (code <= 0.0f) return 0;
+    if (code >= 4095.0f) return 4095;
+    return (uint16_t)lroundf(code);
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+void reservoir_init(reservoir_t* r, const reservoir_config_t& config) {
+    *r = reservoir_t{};
+    r->config = config;
+    r->volume_l = config.volume_l;
+    r->ph = config.ph;
+    r->ec = config.ec;
+    r->temperature = config.temperature;
+    r->rng_state = config.seed;
+    for (int i = 0; i < SIM_PUMP_COUNT; i++) {
+        r->line_ml[i] = config.line_dead_ml;
+    }
+}
+
+void reservoir_step(reservoir_t* r, float dt_s, const float flow_ml_per_min[SIM_PUMP_COUNT]) {
+    const reservoir_config_t& c = r->config;
+    if (dt_s <= 0.0f) return;
+
+    // Pump delivery into the unmixed plume near the outlet (adds to the volume),
+    // once the tubing is full; idle tubing drains back towards the bottle
+    float drain = c.line_drain_tau_h > 0.0f ? expf(-dt_s / (c.line_drain_tau_h * 3600.0f)) : 1.0f;
+    for (int i = 0; i < SIM_PUMP_COUNT; i++) {
+        float ml = flow_ml_per_min[i] * dt_s / 60.0f;
+        if (ml <= 0.0f) {
+            r->line_ml[i] *= drain;
+            continue;
+        }
+        float fill = c.line_dead_ml - r->line_ml[i];
+        if (fill > ml) fill = ml;
+        if (fill > 0.0f) {
+            r->line_ml[i] += fill;
+            ml -= fill;
+        }
+        r->unmixed_ml[i] += ml;
+        r->delivered_ml[i] += ml;
+        r->volume_l += ml / 1000.0f;
+    }
+    r->elapsed_s += dt_s;
+
+    // First-order mixing of each plume into the bulk solution
+    float mix_fraction = 1.0f - expf(-dt_s / c.mixing_tau_s);
+    float volume = r->volume_l > 1.0f ? r->volume_l : 1.0f;
+    for (int i = 0; i < SIM_PUMP_COUNT; i++) {
+        float ml = r->unmixed_ml[i] * mix_fraction;
+        r->unmixed_ml[i] -= ml;
+        float ml_per_l = ml / volume;
+        switch (i) {
+            case 0:  // pH Up
+                r->ph += c.ph_up_strength * ml_per_l;
+                break;
+            case 1:  // pH Down
+                r->ph -= c.ph_down_strength * ml_per_l;
+                r->ec += c.ph_down_ec * ml_per_l;
+                break;
+            default: // Nutrient A / B
+                r->ec += c.nutrient_ec * ml_per_l;
+                r->ph += c.nutrient_ph * ml_per_l;
+                break;
+        }
+    }
+
+    // Plant uptake drift
+    float dt_h = dt_s / 3600.0f;
+    r->ph += c.ph_drift_per_h * dt_h;
+    r->ec += c.ec_drift_per_h * dt_h;
+
+    // Water loss: evaporation concentrates salts, a leak removes solution
+    double hour = fmod(r->elapsed_s / 3600.0, 24.0);
+    float diurnal = 1.0f + c.evaporation_diurnal * (float)sin(2.0 * M_PI * (hour - 8.0) / 24.0);
+    float evaporated = c.evaporation_l_per_h * (diurnal > 0.0f ? diurnal : 0.0f) * dt_h;
+    if (evaporated > 0.0f && r->volume_l > evaporated) {
+        r->ec *= r->volume_l / (r->volume_l - evaporated);
+        r->volume_l -= evaporated;
+    }
+    r->volume_l -= c.leak_l_per_h * dt_h;
+
+    if (r->volume_l < 0.0f) r->volume_l = 0.0f;
+    if (r->ph < 0.0f) r->ph = 0.0f;
+    if (r->ph > 14.0f) r->ph = 14.0f;
+    if (r->ec < 0.0f) r->ec = 0.0f;
+}
+
+void reservoir_add_water(reservoir_t* r, float liters) {
+    if (liters <= 0.0f) return;
+    float total = r->volume_l + liters;
+    // Mixing on a linear pH scale is a simplification; good enough for control tests
+    r->ph = (r->ph * r->volume_l + SIM_WATER_PH * liters) / total;
+    r->ec = (r->ec * r->volume_l + SIM_WATER_EC * liters) / total;
+    r->volume_l = total;
+}
+
+bool reservoir_set_param(reservoir_t* r, const char* name, float value) {
+    reservoir_config_t& c = r->config;
+    struct { const char* name; float* field; } params[] = {
+        {"ph_drift_per_h", &c.ph_drift_per_h},
+        {"ec_drift_per_h", &c.ec_drift_per_h},
+        {"evaporation_l_per_h", &c.evaporation_l_per_h},
+        {"evaporation_diurnal", &c.evaporation_diurnal},
+        {"leak_l_per_h", &c.leak_l_per_h},
+        {"ph_down_strength", &c.ph_down_strength},
+        {"ph_up_strength", &c.ph_up_strength},
+        {"ph_down_ec", &c.ph_down_ec},
+        {"nutrient_ec", &c.nutrient_ec},
+        {"nutrient_ph", &c.nutrient_ph},
+        {"line_dead_ml", &c.line_dead_ml},
+        {"line_drain_tau_h", &c.line_drain_tau_h},
+        {"mixing_tau_s", &c.mixing_tau_s},
+        {"pump_dead_ms", &c.pump_dead_ms},
+        {"plume_l", &c.plume_l},
+        {"noise_ph", &c.noise_ph},
+        {"noise_ec", &c.noise_ec},
+        {"noise_distance_cm", &c.noise_distance_cm},
+        {"ph_probe1_offset", &c.ph_probe_offset[0]},
+        {"ph_probe2_offset", &c.ph_probe_offset[1]},
+        {"ph_probe3_offset", &c.ph_probe_offset[2]},
+        {"ph_probe1_drift_per_h", &c.ph_probe_drift_per_h[0]},
+        {"ph_probe2_drift_per_h", &c.ph_probe_drift_per_h[1]},
+        {"ph_probe3_drift_per_h", &c.ph_probe_drift_per_h[2]},
+        {"ec_probe1_offset", &c.ec_probe_offset[0]},
+        {"ec_probe2_offset", &c.ec_probe_offset[1]},
+        {"ec_probe3_offset", &c.ec_probe_offset[2]},
+        {"temperature", &r->temperature},
+        {"ph", &r->ph},
+        {"ec", &r->ec},
+        {"volume_l", &r->volume_l},
+    };
+    for (auto& p : params) {
+        if (strcmp(p.name, name) == 0) {
+            *p.field = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+calibration_t reservoir_calibration(const reservoir_config_t& config) {
+    calibration_t cal;
+    cal.ph_slope = DEFAULT_PH_SLOPE;
+    cal.ph_offset = 7.0f - DEFAULT_PH_SLOPE * kPhNeutralMv;
+    cal.ec_slope = DEFAULT_EC_SLOPE;
+    cal.ec_offset = DEFAULT_EC_OFFSET;
+    cal.empty_distance = kEmptyDistanceCm;
+    cal.half_distance = kHalfDistanceCm;
+    cal.full_distance = kFullDistanceCm;
+    cal.max_volume = config.tank_l;
+    return cal;
+}
+
+float reservoir_plume_ph(const reservoir_t* r) {
+    const reservoir_config_t& c = r->config;
+    if (c.plume_l <= 0.0f) return 0.0f;
+    // Same linear dose response as mixing, concentrated in the plume volume
+    float shift = c.ph_up_strength * r->unmixed_ml[0] - c.ph_down_strength * r->unmixed_ml[1] +
+                  c.nutrient_ph * (r->unmixed_ml[2] + r->unmixed_ml[3]);
+    return shift / c.plume_l;
+}
+
+uint16_t reservoir_ph_adc(reservoir_t* r, const calibration_t& cal) {
+    return reservoir_ph_probe_adc(r, cal, 0);
+}
+
+uint16_t reservoir_ec_adc(reservoir_t* r, const calibration_t& cal) {
+    return reservoir_ec_probe_adc(r, cal, 0);
+}
+
+uint16_t reservoir_ph_probe_adc(reservoir_t* r, const calibration_t& cal, int probe) {
+    // Firmware adds 0.03 pH/°C above 25 °C; the probe reports the uncompensated value
+    float measured = r->ph + reservoir_plume_ph(r) + r->config.noise_ph * gaussian(r) -
+                     (r->temperature - 25.0f) * 0.03f;
+    measured += r->config.ph_probe_offset[probe] +
+                r->config.ph_probe_drift_per_h[probe] * (float)(r->elapsed_s / 3600.0);
+    return mv_to_adc((measured - cal.ph_offset) / cal.ph_slope);
+}
+
+uint16_t reservoir_ec_probe_adc(reservoir_t* r, const calibration_t& cal, int probe) {
+    // Firmware multiplies by (1 + 0.02 * (T - 25)); undo it at the probe
+    float measured = (r->ec + r->config.noise_ec * gaussian(r) + r->config.ec_probe_offset[probe]) /
+                     (1.0f + 0.02f * (r->temperature - 25.0f));
+    return mv_to_adc((measured - cal.ec_offset) / cal.ec_slope);
+}
+
+unsigned long reservoir_echo_us(reservoir_t* r, const calibration_t& cal) {
+    // Inverse of calibration_distance_to_volume() piecewise interpolation
+    float half_volume = cal.max_volume / 2.0f;
+    float v = r->volume_l < 0.0f ? 0.0f : (r->volume_l > cal.max_volume ? cal.max_volume : r->volume_l);
+    float distance;
+    if (v <= half_volume) {
+        distance = cal.empty_distance - (v / half_volume) * (cal.empty_distance - cal.half_distance);
+    } else {
+        distance = cal.half_distance - ((v - half_volume) / half_volume) * (cal.half_distance - cal.full_distance);
+    }
+    distance += r->config.noise_distance_cm * gaussian(r);
+    // distance = duration * 0.034 / 2 in sensor_read_distance_raw()
+    return (unsigned long)lroundf(distance * 2.0f / 0.034f);
+}
+
+float reservoir_flow_from_duty(uint32_t duty) {
+    // calculate_pwm_duty(): 5.2 ml/min = 10 % duty, 90 ml/min = 100 % duty
+    float duty_percent = duty * 100.0f / 255.0f;
+    if (duty_percent < 10.0f) return 0.0f;
+    return 5.2f + (duty_percent - 10.0f) * 84.8f / 90.0f;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file reservoir.h
+ * @brief Simulated hydroponic reservoir for host-side control testing
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - Nutrient solution chemistry (pH, EC) with first-order mixing of doses
+ * - Pump tubing that must fill before a pump delivers and drains back when idle
+ * - Volume balance (pump inflow, diurnal evaporation, leaks, top-ups) with EC
+ *   concentration
+ * - Probe models producing the ADC codes, echo widths and temperatures the
+ *   firmware would see, with seeded, platform-independent noise and
+ *   injectable per-probe faults (offset, drift) for redundant probes
+ */
+
+#ifndef SIM_RESERVOIR_H
+#define SIM_RESERVOIR_H
+
+#include <stdint.h>
+#include "calibration.h"
+
+//=============================================================================
+// CONSTANTS
+//=============================================================================
+
+constexpr int SIM_PUMP_COUNT = 4;        // Matches PumpId::COUNT
+constexpr float SIM_WATER_PH = 7.0f;     // pH of top-up water
+constexpr float SIM_WATER_EC = 0.2f;     // EC of top-up water (mS/cm)
+constexpr int SIM_PROBE_COUNT = 3;       // Probes per quantity, matches PROBE_MAX
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Physical and probe parameters of a simulated reservoir
+ * Defaults describe a 40 L deep-water-culture tank at 22 °C; dose strengths
+ * give roughly 0.1 pH per ml of pH Up/Down in 20 L.
+ */
+struct reservoir_config_t {
+    // Initial state
+    float volume_l;              // Solution volume (L)
+    float tank_l;                // Tank capacity used for volume calibration (L)
+    float ph;                    // Initial pH
+    float ec;                    // Initial EC (mS/cm)
+    float temperature;           // Water temperature (°C)
+
+    // Slow processes
+    float ph_drift_per_h;        // Plant-driven pH drift (pH/h, +ve = rising)
+    float ec_drift_per_h;        // Nutrient uptake (mS/cm per h, -ve = falling)
+    float evaporation_l_per_h;   // Evaporation / transpiration loss, daily mean (L/h)
+    float evaporation_diurnal;   // Day/night swing as a fraction of the mean (peak at 14:00 sim time)
+    float leak_l_per_h;          // Unplanned loss (L/h)
+
+    // Dose response (per ml dosed into 1 L of solution)
+    float ph_down_strength;      // pH drop per ml/L of pH Down
+    float ph_up_strength;        // pH rise per ml/L of pH Up
+    float ph_down_ec;            // EC rise per ml/L of pH Down (mS/cm)
+    float nutrient_ec;           // EC rise per ml/L of nutrient A or B (mS/cm)
+    float nutrient_ph;           // pH change per ml/L of nutrient A or B
+    float mixing_tau_s;          // First-order mixing time constant (s)
+    float pump_dead_ms;          // Run time before liquid leaves the tube (motor spin-up, slack)
+    float plume_l;               // Solution the unmixed plume sits in around outlet and probe (0 = probe sees bulk)
+    float line_dead_ml;          // Tubing volume filled before a pump delivers (lines start full)
+    float line_drain_tau_h;      // Idle drain-back of the tubing towards the bottle (h)
+
+    // Probe noise (1 sigma)
+    float noise_ph;              // pH units
+    float noise_ec;              // mS/cm
+    float noise_distance_cm;     // Ultrasonic distance (cm)
+
+    // Probe faults, per probe (0 = PH_PIN / EC_PIN): error added to what the probe reports
+    float ph_probe_offset[SIM_PROBE_COUNT];        // pH
+    float ph_probe_drift_per_h[SIM_PROBE_COUNT];   // pH per hour since init
+    float ec_probe_offset[SIM_PROBE_COUNT];        // mS/cm
+
+    uint32_t seed;               // Noise RNG seed
+
+    reservoir_config_t()
+        : volume_l(40.0f), tank_l(60.0f), ph(6.0f), ec(1.4f), temperature(22.0f),
+          ph_drift_per_h(0.0f), ec_drift_per_h(0.0f), evaporation_l_per_h(0.0f),
+          evaporation_diurnal(0.0f), leak_l_per_h(0.0f),
+          ph_down_strength(2.0f), ph_up_strength(2.0f), ph_down_ec(0.05f),
+          nutrient_ec(0.3f), nutrient_ph(-0.05f), mixing_tau_s(120.0f), pump_dead_ms(0.0f), plume_l(0.0f),
+          line_dead_ml(0.8f), line_drain_tau_h(24.0f),
+          noise_ph(0.0f), noise_ec(0.0f), noise_distance_cm(0.0f),
+          ph_probe_offset{}, ph_probe_drift_per_h{}, ec_probe_offset{}, seed(1) {}
+};
+
+/**
+ * @brief Live reservoir state
+ */
+struct reservoir_t {
+    reservoir_config_t config;
+    float volume_l;                          // Current solution volume (L)
+    float ph;                                // Well-mixed pH
+    float ec;                                // Well-mixed EC (mS/cm)
+    float temperature;                       // Water temperature (°C)
+    float unmixed_ml[SIM_PUMP_COUNT];        // Dosed but not yet mixed chemical per pump
+    float delivered_ml[SIM_PUMP_COUNT];      // Total delivered into the solution per pump (ground truth)
+    float line_ml[SIM_PUMP_COUNT];           // Liquid standing in each pump's tubing
+    double elapsed_s;                        // Simulated time since init (diurnal phase)
+    uint64_t rng_state;                      // splitmix64 state for noise
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void reservoir_init(reservoir_t* r, const reservoir_config_t& config);
+void reservoir_step(reservoir_t* r, float dt_s, const float flow_ml_per_min[SIM_PUMP_COUNT]);
+void reservoir_add_water(reservoir_t* r, float liters);       // Operator top-up
+
+// Parameter access by name for scenario scripts ("ph_drift_per_h", ...)
+bool reservoir_set_param(reservoir_t* r, const char* name, float value);
+
+// Calibration the simulated probes are built against (pH 7.00 at 1500 mV)
+calibration_t reservoir_calibration(const reservoir_config_t& config);
+
+// pH offset of the unmixed plume around the outlet and probe (0 when plume_l is 0)
+float reservoir_plume_ph(const reservoir_t* r);
+
+// Probe models: what the firmware would measure right now (probe 0, or one of SIM_PROBE_COUNT)
+uint16_t reservoir_ph_adc(reservoir_t* r, const calibration_t& cal);
+uint16_t reservoir_ec_adc(reservoir_t* r, const calibration_t& cal);
+uint16_t reservoir_ph_probe_adc(reservoir_t* r, const calibration_t& cal, int probe);
+uint16_t reservoir_ec_probe_adc(reservoir_t* r, const calibration_t& cal, int probe);
+unsigned long reservoir_echo_us(reservoir_t* r, const calibration_t& cal);
+
+// Pump model: PWM duty (8-bit) to delivered flow, inverse of calculate_pwm_duty()
+float reservoir_flow_from_duty(uint32_t duty);
+
+#endif // SIM_RESERVOIR_H
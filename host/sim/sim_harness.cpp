@@ -0,0 +1,125 @@
+/**
+ * @file sim_harness.cpp
+ * @brief Closed-loop harness implementation
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "sim_harness.h"
+#include "host_hal.h"
+#include "sensors.h"
+#include "pump.h"
+
+#include <string.h>
+
+// Arduino entry points from main.cpp
+void setup();
+void loop();
+
+//=============================================================================
+// HARNESS STATE
+//=============================================================================
+
+static reservoir_t sim_plant;
+static calibration_t sim_cal;
+static uint32_t sim_tick_ms = 10;
+static uint64_t sim_plant_time_us = 0;
+static float sim_flow[SIM_PUMP_COUNT];
+static uint64_t sim_on_since_us[SIM_PUMP_COUNT];   // PWM switched on (valid while flow > 0)
+
+static const uint8_t kPumpPins[SIM_PUMP_COUNT] = {
+    PUMP_PH_UP_PIN, PUMP_PH_DOWN_PIN, PUMP_NUTRIENT_A_PIN, PUMP_NUTRIENT_B_PIN
+};
+
+//=============================================================================
+// SHIM HOOKS
+//=============================================================================
+
+static uint16_t sim_adc_hook(uint8_t pin, void* ctx) {
+    (void)ctx;
+    for (int i = 0; i < Board::ph_probe_count; i++) {
+        if (pin == Board::ph_probe_pins[i]) return reservoir_ph_probe_adc(&sim_plant, sim_cal, i);
+    }
+    for (int i = 0; i < Board::ec_probe_count; i++) {
+        if (pin == Board::ec_probe_pins[i]) return reservoir_ec_probe_adc(&sim_plant, sim_cal, i);
+    }
+    return 0;
+}
+
+static unsigned long sim_pulse_hook(uint8_t pin, void* ctx) {
+    (void)ctx;
+    return pin == ECHO_PIN ? reservoir_echo_us(&sim_plant, sim_cal) : 0;
+}
+
+/**
+ * @brief Integrate the plant up to the shim clock (sensor reads move time too)
+ * A pump delivers nothing for pump_dead_ms after it is switched on.
+ */
+static void sim_catch_up_plant(void) {
+    uint64_t now = host_get_micros();
+    if (now > sim_plant_time_us) {
+        double span = (double)(now - sim_plant_time_us);
+        uint64_t dead_us = (uint64_t)(sim_plant.config.pump_dead_ms * 1000.0f);
+        float flow[SIM_PUMP_COUNT];
+        for (int i = 0; i < SIM_PUMP_COUNT; i++) {
+            uint64_t flowing_from = sim_on_since_us[i] + dead_us;
+            if (flowing_from < sim_plant_time_us) flowing_from = sim_plant_time_us;
+            flow[i] = (sim_flow[i] > 0.0f && flowing_from < now) ? sim_flow[i] * (float)((now - flowing_from) / span) : 0.0f;
+        }
+        reservoir_step(&sim_plant, (float)(span / 1e6), flow);
+        sim_plant_time_us = now;
+    }
+    host_set_temperature(sim_plant.temperature);
+}
+
+static void sim_pwm_hook(uint8_t pin, uint32_t duty, void* ctx) {
+    (void)ctx;
+    for (int i = 0; i < SIM_PUMP_COUNT; i++) {
+        if (kPumpPins[i] == pin) {
+            // Settle the plant at the old flow first: timer callbacks switch mid-tick
+            sim_catch_up_plant();
+            float flow = reservoir_flow_from_duty(duty);
+            if (flow > 0.0f && sim_flow[i] <= 0.0f) sim_on_since_us[i] = host_get_micros();
+            sim_flow[i] = flow;
+        }
+    }
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+void sim_init(const reservoir_config_t& config, uint32_t tick_ms) {
+    host_reset();
+    reservoir_init(&sim_plant, config);
+    sim_cal = reservoir_calibration(config);
+    sim_tick_ms = tick_ms > 0 ? tick_ms : 1;
+    sim_plant_time_us = 0;
+    memset(sim_flow, 0, sizeof(sim_flow));
+    memset(sim_on_since_us, 0, sizeof(sim_on_since_us));
+
+    host_nvs_put_raw(NVS_NAMESPACE, NVS_CALIBRATION_KEY, &sim_cal, sizeof(sim_cal));
+    host_set_adc_hook(sim_adc_hook, nullptr);
+    host_set_pulse_hook(sim_pulse_hook, nullptr);
+    host_set_pwm_hook(sim_pwm_hook, nullptr);
+    host_set_temperature(sim_plant.temperature);
+}
+
+void sim_boot(void) {
+    setup();
+    sim_catch_up_plant();
+}
+
+void sim_step(void) {
+    host_advance_ms(sim_tick_ms);
+    sim_catch_up_plant();
+    loop();
+}
+
+void sim_send_cli(const char* text) {
+    host_serial_feed(reinterpret_cast<const uint8_t*>(text), strlen(text));
+}
+
+uint32_t sim_now_ms(void) { return (uint32_t)(host_get_micros() / 1000u); }
+reservoir_t* sim_reservoir(void) { return &sim_plant; }
+const calibration_t& sim_calibration(void) { return sim_cal; }
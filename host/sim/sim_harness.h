@@ -0,0 +1,39 @@
+/**
+ * @file sim_harness.h
+ * @brief Closed-loop harness: real firmware setup()/loop() against a simulated reservoir
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Wires the host shim's ADC, ultrasonic, DS18B20 and LEDC hooks to a
+ * reservoir_t, seeds NVS with the calibration the simulated probes were
+ * built against, and steps the simulated clock in fixed ticks. Firmware
+ * globals are process-wide, so run one simulation per process.
+ */
+
+#ifndef SIM_HARNESS_H
+#define SIM_HARNESS_H
+
+#include <stdint.h>
+#include "reservoir.h"
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Reset the shim, build the plant and store its calibration in NVS
+void sim_init(const reservoir_config_t& config, uint32_t tick_ms);
+
+// Run the firmware's setup() (boot to MONITORING)
+void sim_boot(void);
+
+// Advance one tick: move the clock, integrate the plant, run loop() once
+void sim_step(void);
+
+// Queue CLI input as if typed on the Serial console
+void sim_send_cli(const char* text);
+
+uint32_t sim_now_ms(void);
+reservoir_t* sim_reservoir(void);
+const calibration_t& sim_calibration(void);
+
+#endif // SIM_HARNESS_H
@@ -0,0 +1,80 @@
+/**
+ * @file adclut.cpp
+ * @brief Host ADC table generator: the firmware's eFuse curve table for a given calibration point
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Builds the table with the firmware builder (src/adc_cal.cpp) over the
+ * curve-fitting conversion of the host esp_adc_cali stand-in, for an ADC1
+ * eFuse point as reported by espefuse.py. Prints CSV (code, linear mV as
+ * the firmware computes without eFuse data, curve mV, difference) or, with
+ * -c, the table as a C array.
+ *
+ *   adclut <atten 0-3> <efuse_code> <efuse_mv>        # CSV
+ *   adclut -c 3 3100 2800 > adc_lut.inc                # C array
+ */
+
+#include "adc_cal.h"
+#include "sensors.h"
+#include "host_hal.h"
+
+#include <esp_adc/adc_cali_scheme.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint16_t lut[ADC_CAL_CODES];
+
+static bool cali_convert(void* ctx, int code, int* millivolts) {
+    return adc_cali_raw_to_voltage(static_cast<adc_cali_handle_t>(ctx), code, millivolts) == ESP_OK;
+}
+
+int main(int argc, char** argv) {
+    bool c_array = false;
+    int arg = 1;
+    if (arg < argc && strcmp(argv[arg], "-c") == 0) {
+        c_array = true;
+        arg++;
+    }
+    if (argc - arg != 3) {
+        fprintf(stderr, "usage: %s [-c] <atten 0-3> <efuse_code> <efuse_mv>\n", argv[0]);
+        return 2;
+    }
+    int atten = atoi(argv[arg]);
+    long code = atol(argv[arg + 1]);
+    long millivolts = atol(argv[arg + 2]);
+    if (atten < 0 || atten > 3 || code <= 0 || code >= ADC_CAL_CODES || millivolts <= 0 || millivolts > 3300) {
+        fprintf(stderr, "adclut: attenuation 0-3, code 1-%d, 1-3300 mV\n", ADC_CAL_CODES - 1);
+        return 2;
+    }
+
+    host_set_adc_efuse(atten, (uint32_t)code, (uint32_t)millivolts);
+    adc_cali_curve_fitting_config_t config = {};
+    config.unit_id = ADC_UNIT_1;
+    config.atten = static_cast<adc_atten_t>(atten);
+    config.bitwidth = ADC_BITWIDTH_12;
+    adc_cali_handle_t handle = nullptr;
+    if (adc_cali_create_scheme_curve_fitting(&config, &handle) != ESP_OK ||
+        !adc_cal_build_lut(cali_convert, handle, lut, ADC_CAL_CODES)) {
+        fprintf(stderr, "adclut: conversion failed\n");
+        return 1;
+    }
+    adc_cali_delete_scheme_curve_fitting(handle);
+
+    if (c_array) {
+        printf("// adclut -c %d %ld %ld: ADC1 code -> mV\n", atten, code, millivolts);
+        printf("static const uint16_t adc_lut[%d] = {", ADC_CAL_CODES);
+        for (int i = 0; i < ADC_CAL_CODES; i++) {
+            printf("%s%u,", i % 16 ? " " : "\n    ", lut[i]);
+        }
+        printf("\n};\n");
+        return 0;
+    }
+    printf("code,linear_mv,curve_mv,diff_mv\n");
+    for (int i = 0; i < ADC_CAL_CODES; i++) {
+        float linear = i * SENSOR_ADC_VOLTS_PER_COUNT * 1000.0f;
+        printf("%d,%.1f,%u,%.1f\n", i, linear, lut[i], lut[i] - linear);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file alarmc.cpp
+ * @brief Host alarm rule compiler: validate a rule file and show its bytecode
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Uses the firmware compiler (src/alarms.cpp) so a file that passes here
+ * loads on the device with 'L'. Errors are printed as file:line:col so
+ * editors can jump to them.
+ *
+ *   alarmc rules.txt          # summary per rule
+ *   alarmc -d rules.txt       # plus disassembly
+ */
+
+#include "alarms.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static alarm_program_t program;
+static char text[ALARM_RULES_TEXT_MAX];
+
+static void print_line(const char* line, void* ctx) {
+    (void)ctx;
+    printf("    %s\n", line);
+}
+
+int main(int argc, char** argv) {
+    bool disassemble = false;
+    const char* path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-d") == 0) disassemble = true;
+        else path = argv[i];
+    }
+    if (!path) {
+        fprintf(stderr, "usage: %s [-d] <rules-file | ->\n", argv[0]);
+        return 2;
+    }
+
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "alarmc: cannot open %s\n", path);
+        return 2;
+    }
+    size_t len = fread(text, 1, sizeof(text), file);
+    if (file != stdin) fclose(file);
+    if (len >= sizeof(text)) {
+        fprintf(stderr, "%s: error: rule text exceeds %zu bytes (device NVS limit)\n", path, ALARM_RULES_TEXT_MAX - 1);
+        return 1;
+    }
+    text[len] = '\0';
+
+    alarm_compile_error_t error;
+    if (!alarm_compile(text, &program, &error)) {
+        fprintf(stderr, "%s:%d:%d: error: %s\n", path, error.line, error.column, error.message);
+        return 1;
+    }
+
+    printf("%d rules, %d/%d bytes bytecode, %zu/%zu bytes text\n", program.rule_count, program.code_used,
+           ALARM_CODE_SIZE, len, ALARM_RULES_TEXT_MAX - 1);
+    for (int i = 0; i < program.rule_count; i++) {
+        const alarm_rule_t& rule = program.rules[i];
+        printf("  %-15s %s  %3u bytes  for %lus  hold %lus\n", rule.name, alarm_severity_to_string(rule.severity),
+               rule.code_length, (unsigned long)(rule.raise_delay_ms / 1000), (unsigned long)(rule.clear_delay_ms / 1000));
+        if (disassemble) alarm_disassemble(&program, i, print_line, nullptr);
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file binlog_decode.cpp
+ * @brief Host decoder for the binlog raw frame stream
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "binlog_decode.h"
+
+#include <stdio.h>
+
+static uint16_t get_u16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const char* dictionary_string(binlog_word_t word, void* ctx) {
+    const binlog_decoder_t* decoder = static_cast<const binlog_decoder_t*>(ctx);
+    return word < BINLOG_DICT_SIZE ? decoder->strings[word].c_str() : "(bad id)";
+}
+
+static bool fail(binlog_decoder_t* decoder, size_t offset, const char* what) {
+    char text[80];
+    snprintf(text, sizeof(text), "offset %zu: %s", offset, what);
+    decoder->error = text;
+    return false;
+}
+
+bool binlog_decode(binlog_decoder_t* decoder, const uint8_t* data, size_t len,
+                   binlog_decode_line_fn line, void* ctx) {
+    const size_t magic_len = sizeof(BINLOG_STREAM_MAGIC) - 1;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t left = len - pos;
+        const uint8_t* frame = data + pos;
+
+        if (left >= magic_len && memcmp(frame, BINLOG_STREAM_MAGIC, magic_len) == 0) {
+            for (auto& s : decoder->strings) s.clear();
+            pos += magic_len;
+        } else if (frame[0] == BINLOG_FRAME_STRING) {
+            if (left < 5) return fail(decoder, pos, "truncated string frame");
+            uint16_t id = get_u16(frame + 1);
+            uint16_t n = get_u16(frame + 3);
+            if (id >= BINLOG_DICT_SIZE) return fail(decoder, pos, "string id out of range");
+            if (left < 5u + n) return fail(decoder, pos, "truncated string frame");
+            decoder->strings[id].assign(reinterpret_cast<const char*>(frame + 5), n);
+            pos += 5u + n;
+        } else if (frame[0] == BINLOG_FRAME_RECORD) {
+            if (left < 8) return fail(decoder, pos, "truncated record frame");
+            uint16_t fmt_id = get_u16(frame + 1);
+            uint32_t timestamp_us = get_u32(frame + 3);
+            uint8_t argc = frame[7];
+            if (fmt_id >= BINLOG_DICT_SIZE) return fail(decoder, pos, "format id out of range");
+            if (argc > BINLOG_MAX_ARGS) return fail(decoder, pos, "too many arguments");
+            if (left < 8u + 4u * argc) return fail(decoder, pos, "truncated record frame");
+
+            binlog_word_t args[BINLOG_MAX_ARGS];
+            for (uint8_t i = 0; i < argc; i++) args[i] = get_u32(frame + 8 + 4 * i);
+            char text[BINLOG_LINE_MAX];
+            binlog_format(text, sizeof(text), decoder->strings[fmt_id].c_str(), args, argc,
+                          dictionary_string, decoder);
+            decoder->records++;
+            line(timestamp_us, text, ctx);
+            pos += 8u + 4u * argc;
+        } else if (frame[0] == BINLOG_FRAME_DROPPED) {
+            if (left < 5) return fail(decoder, pos, "truncated dropped frame");
+            uint32_t lost = get_u32(frame + 1);
+            decoder->dropped += lost;
+            char text[48];
+            snprintf(text, sizeof(text), "[LOG] %u records dropped (ring full)", lost);
+            line(0, text, ctx);
+            pos += 5;
+        } else {
+            return fail(decoder, pos, "unknown frame type");
+        }
+    }
+    return true;
+}
+
+std::vector<uint8_t> binlog_extract_hex_lines(const std::string& text) {
+    std::vector<uint8_t> bytes;
+    size_t pos = 0;
+    while ((pos = text.find("#BLG ", pos)) != std::string::npos) {
+        pos += 5;
+        while (pos + 1 < text.size() && isxdigit((unsigned char)text[pos]) && isxdigit((unsigned char)text[pos + 1])) {
+            bytes.push_back((uint8_t)strtoul(text.substr(pos, 2).c_str(), nullptr, 16));
+            pos += 2;
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,40 @@
+/**
+ * @file binlog_decode.h
+ * @brief Host decoder for the binlog raw frame stream
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Rebuilds the string dictionary from 'S' frames and formats 'R' frames with
+ * the firmware's own binlog_format(), so decoded text matches what the
+ * device console would have printed. Shared by logdump and bench_binlog.
+ */
+
+#ifndef HOST_BINLOG_DECODE_H
+#define HOST_BINLOG_DECODE_H
+
+#include "binlog.h"
+
+#include <string>
+#include <vector>
+
+typedef void (*binlog_decode_line_fn)(uint32_t timestamp_us, const char* text, void* ctx);
+
+/**
+ * @brief Decoder state; a stream may be fed in pieces of whole frames
+ */
+struct binlog_decoder_t {
+    std::string strings[BINLOG_DICT_SIZE];
+    uint32_t records = 0;
+    uint32_t dropped = 0;
+    std::string error;                       // Set when the stream is malformed
+};
+
+// Decode whole frames from data (magic resets the dictionary). Returns false on
+// a malformed or truncated frame; decoder.error says where.
+bool binlog_decode(binlog_decoder_t* decoder, const uint8_t* data, size_t len,
+                   binlog_decode_line_fn line, void* ctx);
+
+// Extract the bytes of "#BLG <hex>" lines from a captured console log
+std::vector<uint8_t> binlog_extract_hex_lines(const std::string& text);
+
+#endif // HOST_BINLOG_DECODE_H
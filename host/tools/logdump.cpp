@@ -0,0 +1,67 @@
+/**
+ * @file logdump.cpp
+ * @brief Host decoder for binlog captures: raw frame dumps back to text
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Accepts either a binary stream (starts with the BLG1 magic) or a captured
+ * console log with "#BLG <hex>" lines from the 'g' CLI command; other lines
+ * in the capture are ignored. Prints one line per record with the device
+ * micros() timestamp in seconds.
+ *
+ *   logdump capture.txt
+ *   logdump - < stream.bin
+ */
+
+#include "binlog_decode.h"
+
+#include <stdio.h>
+
+static void print_line(uint32_t timestamp_us, const char* text, void* ctx) {
+    (void)ctx;
+    if (timestamp_us == 0) {
+        printf("%16s  %s\n", "", text);
+    } else {
+        printf("%9lu.%06lu  %s\n", (unsigned long)(timestamp_us / 1000000u),
+               (unsigned long)(timestamp_us % 1000000u), text);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <capture | ->\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[1];
+    FILE* file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "logdump: cannot open %s\n", path);
+        return 2;
+    }
+    std::string content;
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) content.append(chunk, n);
+    if (file != stdin) fclose(file);
+
+    std::vector<uint8_t> stream;
+    const size_t magic_len = sizeof(BINLOG_STREAM_MAGIC) - 1;
+    if (content.compare(0, magic_len, BINLOG_STREAM_MAGIC) == 0) {
+        stream.assign(content.begin(), content.end());
+    } else {
+        stream = binlog_extract_hex_lines(content);
+    }
+    if (stream.empty()) {
+        fprintf(stderr, "%s: no binlog frames found\n", path);
+        return 1;
+    }
+
+    binlog_decoder_t decoder;
+    bool ok = binlog_decode(&decoder, stream.data(), stream.size(), print_line, nullptr);
+    fprintf(stderr, "%u records, %u dropped on the device\n", decoder.records, decoder.dropped);
+    if (!ok) {
+        fprintf(stderr, "%s: error: %s\n", path, decoder.error.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file modbus_client.cpp
+ * @brief Minimal blocking Modbus TCP client
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "modbus_client.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static constexpr size_t kAduMax = 260;
+
+static int fail(modbus_client_t* client, const std::string& error) {
+    client->error = error;
+    modbus_client_close(client);
+    return -1;
+}
+
+static bool read_exact(int fd, uint8_t* out, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(fd, out, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        out += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+bool modbus_client_connect(modbus_client_t* client, const char* host, uint16_t port) {
+    modbus_client_close(client);
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0 || result == nullptr) {
+        client->error = std::string("cannot resolve ") + host;
+        return false;
+    }
+    sockaddr_in addr;
+    memcpy(&addr, result->ai_addr, sizeof(addr));
+    addr.sin_port = htons(port);
+    freeaddrinfo(result);
+
+    client->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (client->fd < 0 || connect(client->fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        fail(client, std::string("connect: ") + strerror(errno));
+        return false;
+    }
+    int one = 1;
+    setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return true;
+}
+
+void modbus_client_close(modbus_client_t* client) {
+    if (client->fd >= 0) close(client->fd);
+    client->fd = -1;
+}
+
+int modbus_transact(modbus_client_t* client, const uint8_t* pdu, size_t pdu_len, uint8_t* response,
+                    size_t* response_len) {
+    if (client->fd < 0) return fail(client, "not connected");
+    if (pdu_len < 1 || pdu_len > kAduMax - 7) return fail(client, "PDU too long");
+
+    uint16_t transaction = client->next_transaction++;
+    uint8_t adu[kAduMax];
+    adu[0] = (uint8_t)(transaction >> 8);
+    adu[1] = (uint8_t)transaction;
+    adu[2] = adu[3] = 0;
+    adu[4] = (uint8_t)((pdu_len + 1) >> 8);
+    adu[5] = (uint8_t)(pdu_len + 1);
+    adu[6] = client->unit;
+    memcpy(adu + 7, pdu, pdu_len);
+    if (send(client->fd, adu, pdu_len + 7, MSG_NOSIGNAL) != (ssize_t)(pdu_len + 7)) {
+        return fail(client, "send failed");
+    }
+
+    uint8_t header[7];
+    if (!read_exact(client->fd, header, sizeof(header))) return fail(client, "connection closed");
+    uint16_t length = (uint16_t)((header[4] << 8) | header[5]);
+    if (((header[0] << 8) | header[1]) != transaction || header[2] != 0 || header[3] != 0 || length < 2 ||
+        length > kAduMax - 6) {
+        return fail(client, "bad MBAP header in response");
+    }
+    size_t body = length - 1;
+    if (!read_exact(client->fd, response, body)) return fail(client, "truncated response");
+    *response_len = body;
+    if (response[0] == (pdu[0] | 0x80)) return body >= 2 ? response[1] : fail(client, "short exception");
+    if (response[0] != pdu[0]) return fail(client, "function code mismatch");
+    return 0;
+}
+
+int modbus_read_registers(modbus_client_t* client, uint8_t function, uint16_t address, uint16_t count,
+                          uint16_t* values) {
+    uint8_t pdu[5] = {function, (uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(count >> 8), (uint8_t)count};
+    uint8_t response[kAduMax];
+    size_t len = 0;
+    int result = modbus_transact(client, pdu, sizeof(pdu), response, &len);
+    if (result != 0) return result;
+    if (len != 2u + 2u * count || response[1] != 2 * count) return fail(client, "register count mismatch");
+    for (uint16_t i = 0; i < count; i++) values[i] = (uint16_t)((response[2 + 2 * i] << 8) | response[3 + 2 * i]);
+    return 0;
+}
+
+int modbus_read_coils(modbus_client_t* client, uint16_t address, uint16_t count, uint8_t* bits) {
+    uint8_t pdu[5] = {0x01, (uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(count >> 8), (uint8_t)count};
+    uint8_t response[kAduMax];
+    size_t len = 0;
+    int result = modbus_transact(client, pdu, sizeof(pdu), response, &len);
+    if (result != 0) return result;
+    size_t bytes = (count + 7) / 8;
+    if (len != 2 + bytes || response[1] != bytes) return fail(client, "coil count mismatch");
+    memcpy(bits, response + 2, bytes);
+    return 0;
+}
+
+int modbus_write_coil(modbus_client_t* client, uint16_t address, bool on) {
+    uint8_t pdu[5] = {0x05, (uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(on ? 0xFF : 0x00), 0x00};
+    uint8_t response[kAduMax];
+    size_t len = 0;
+    int result = modbus_transact(client, pdu, sizeof(pdu), response, &len);
+    if (result != 0) return result;
+    return (len == 5 && memcmp(response, pdu, 5) == 0) ? 0 : fail(client, "write coil echo mismatch");
+}
+
+int modbus_write_register(modbus_client_t* client, uint16_t address, uint16_t value) {
+    uint8_t pdu[5] = {0x06, (uint8_t)(address >> 8), (uint8_t)address, (uint8_t)(value >> 8), (uint8_t)value};
+    uint8_t response[kAduMax];
+    size_t len = 0;
+    int result = modbus_transact(client, pdu, sizeof(pdu), response, &len);
+    if (result != 0) return result;
+    return (len == 5 && memcmp(response, pdu, 5) == 0) ? 0 : fail(client, "write register echo mismatch");
+}
+
+int modbus_write_registers(modbus_client_t* client, uint16_t address, uint16_t count, const uint16_t* values) {
+    if (count < 1 || count > 123) return fail(client, "register count out of range");
+    uint8_t pdu[6 + 2 * 123];
+    pdu[0] = 0x10;
+    pdu[1] = (uint8_t)(address >> 8);
+    pdu[2] = (uint8_t)address;
+    pdu[3] = (uint8_t)(count >> 8);
+    pdu[4] = (uint8_t)count;
+    pdu[5] = (uint8_t)(count * 2);
+    for (uint16_t i = 0; i < count; i++) {
+        pdu[6 + 2 * i] = (uint8_t)(values[i] >> 8);
+        pdu[7 + 2 * i] = (uint8_t)values[i];
+    }
+    uint8_t response[kAduMax];
+    size_t len = 0;
+    int result = modbus_transact(client, pdu, 6 + 2u * count, response, &len);
+    if (result != 0) return result;
+    return (len == 5 && memcmp(response, pdu, 5) == 0) ? 0 : fail(client, "write registers echo mismatch");
+}
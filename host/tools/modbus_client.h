@@ -0,0 +1,41 @@
+/**
+ * @file modbus_client.h
+ * @brief Minimal blocking Modbus TCP client for host tests and benchmarks
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * One request in flight per client. Calls return 0 on success, the Modbus
+ * exception code (1-4) when the slave answered with an exception, and -1 on
+ * a transport or framing error (client.error says which; the connection is
+ * closed).
+ */
+
+#ifndef HOST_MODBUS_CLIENT_H
+#define HOST_MODBUS_CLIENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+struct modbus_client_t {
+    int fd = -1;
+    uint16_t next_transaction = 1;
+    uint8_t unit = 1;
+    std::string error;
+};
+
+bool modbus_client_connect(modbus_client_t* client, const char* host, uint16_t port);
+void modbus_client_close(modbus_client_t* client);
+
+// Raw request: PDU in, response PDU out (function code first)
+int modbus_transact(modbus_client_t* client, const uint8_t* pdu, size_t pdu_len, uint8_t* response,
+                    size_t* response_len);
+
+int modbus_read_registers(modbus_client_t* client, uint8_t function, uint16_t address, uint16_t count,
+                          uint16_t* values);                     // FC 03 or 04
+int modbus_read_coils(modbus_client_t* client, uint16_t address, uint16_t count, uint8_t* bits);
+int modbus_write_coil(modbus_client_t* client, uint16_t address, bool on);
+int modbus_write_register(modbus_client_t* client, uint16_t address, uint16_t value);
+int modbus_write_registers(modbus_client_t* client, uint16_t address, uint16_t count, const uint16_t* values);
+
+#endif // HOST_MODBUS_CLIENT_H
@@ -0,0 +1,249 @@
+/**
+ * @file multicast_receiver.cpp
+ * @brief Multicast telemetry receiver: gap tracking and TCP backfill
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "multicast_receiver.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+
+static constexpr size_t kMaxHoles = 1024;               // Oldest are abandoned beyond this
+static constexpr uint32_t kRestartDistance = 1u << 16;  // seq this far behind = device rebooted
+
+static bool fail(multicast_receiver_t* receiver, const std::string& error) {
+    receiver->error = error + ": " + strerror(errno);
+    return false;
+}
+
+bool multicast_receiver_open(multicast_receiver_t* receiver, const char* group, uint16_t port, const char* iface) {
+    multicast_receiver_close(receiver);
+    ip_mreq membership = {};
+    if (inet_pton(AF_INET, group, &membership.imr_multiaddr) != 1 ||
+        inet_pton(AF_INET, iface, &membership.imr_interface) != 1) {
+        receiver->error = std::string("bad address ") + group + " / " + iface;
+        return false;
+    }
+
+    receiver->fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (receiver->fd < 0) return fail(receiver, "socket");
+    int one = 1;
+    setsockopt(receiver->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));   // Several listeners per host
+    int buffer = 1 << 20;
+    setsockopt(receiver->fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr = membership.imr_multiaddr;            // Only this group's datagrams
+    if (bind(receiver->fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        fail(receiver, "bind");
+        multicast_receiver_close(receiver);
+        return false;
+    }
+    if (setsockopt(receiver->fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+        fail(receiver, "join group");
+        multicast_receiver_close(receiver);
+        return false;
+    }
+    return true;
+}
+
+void multicast_receiver_close(multicast_receiver_t* receiver) {
+    if (receiver->fd >= 0) close(receiver->fd);
+    receiver->fd = -1;
+}
+
+uint64_t multicast_receiver_missing(const multicast_receiver_t* receiver) {
+    uint64_t missing = 0;
+    for (const multicast_hole_t& hole : receiver->holes) missing += hole.to - hole.from;
+    return missing;
+}
+
+// Frame inside a hole: close that part of it
+static bool fill_hole(multicast_receiver_t* receiver, uint32_t seq) {
+    std::vector<multicast_hole_t>& holes = receiver->holes;
+    for (size_t i = 0; i < holes.size(); i++) {
+        multicast_hole_t& hole = holes[i];
+        if (seq - hole.from >= hole.to - hole.from) continue;
+        if (seq == hole.from) {
+            hole.from++;
+        } else if (seq == hole.to - 1) {
+            hole.to--;
+        } else {
+            multicast_hole_t rest = {seq + 1, hole.to};
+            hole.to = seq;
+            holes.insert(holes.begin() + i + 1, rest);
+        }
+        if (holes[i].from == holes[i].to) holes.erase(holes.begin() + i);
+        receiver->filled++;
+        return true;
+    }
+    return false;
+}
+
+// Give up on frames older than limit (no longer held by the device)
+static void abandon_before(multicast_receiver_t* receiver, uint32_t limit) {
+    std::vector<multicast_hole_t>& holes = receiver->holes;
+    while (!holes.empty() && (int32_t)(holes.front().from - limit) < 0) {
+        multicast_hole_t& hole = holes.front();
+        if ((int32_t)(hole.to - limit) <= 0) {
+            receiver->abandoned += hole.to - hole.from;
+            holes.erase(holes.begin());
+        } else {
+            receiver->abandoned += limit - hole.from;
+            hole.from = limit;
+        }
+    }
+}
+
+bool multicast_receiver_accept(multicast_receiver_t* receiver, const telemetry_event_t& event) {
+    uint32_t seq = event.seq;
+    uint32_t behind = receiver->next_seq - seq;
+    if (receiver->started && behind > kRestartDistance && behind < 0x80000000u) {
+        abandon_before(receiver, receiver->next_seq);    // Device restarted: old holes are gone
+        receiver->started = false;
+    }
+    if (!receiver->started || seq == receiver->next_seq) {
+        receiver->started = true;
+        receiver->next_seq = seq + 1;
+        receiver->delivered++;
+        return true;
+    }
+    if ((int32_t)(seq - receiver->next_seq) > 0) {
+        receiver->holes.push_back({receiver->next_seq, seq});
+        if (receiver->holes.size() > kMaxHoles) abandon_before(receiver, receiver->holes[1].from);
+        receiver->next_seq = seq + 1;
+        receiver->delivered++;
+        return true;
+    }
+    if (fill_hole(receiver, seq)) {
+        receiver->delivered++;
+        return true;
+    }
+    receiver->duplicates++;
+    return false;
+}
+
+int multicast_receiver_poll(multicast_receiver_t* receiver, int timeout_ms, std::vector<telemetry_event_t>* events) {
+    if (receiver->fd < 0) return -1;
+    pollfd pfd = {receiver->fd, POLLIN, 0};
+    if (timeout_ms > 0 && poll(&pfd, 1, timeout_ms) < 0 && errno != EINTR) {
+        fail(receiver, "poll");
+        return -1;
+    }
+
+    int count = 0;
+    for (;;) {
+        uint8_t datagram[512];
+        ssize_t n = recv(receiver->fd, datagram, sizeof(datagram), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) break;
+            fail(receiver, "recv");
+            return -1;
+        }
+        receiver->datagrams++;
+        telemetry_event_t event;
+        size_t consumed = 0;
+        if (telemetry_decode(datagram, (size_t)n, &event, &consumed) != 1 || consumed != (size_t)n) {
+            receiver->invalid++;
+            continue;
+        }
+        if (multicast_receiver_accept(receiver, event)) {
+            events->push_back(event);
+            count++;
+        }
+    }
+    return count;
+}
+
+static int connect_tcp(const char* host, uint16_t port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0 || result == nullptr) return -1;
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0 && connect(fd, result->ai_addr, result->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    return fd;
+}
+
+int multicast_backfill(multicast_receiver_t* receiver, const char* host, uint16_t port, int timeout_ms,
+                       std::vector<telemetry_event_t>* events) {
+    if (receiver->holes.empty()) return 0;
+    int fd = connect_tcp(host, port);
+    if (fd < 0) {
+        fail(receiver, std::string("connect ") + host);
+        return -1;
+    }
+
+    std::string request;
+    for (const multicast_hole_t& hole : receiver->holes) {
+        for (uint32_t from = hole.from; from != hole.to;) {
+            uint32_t count = hole.to - from;
+            if (count > (uint32_t)TELEMETRY_HISTORY_FRAMES) count = TELEMETRY_HISTORY_FRAMES;
+            char line[TELEMETRY_REQUEST_MAX];
+            snprintf(line, sizeof(line), "B %u %u\n", from, count);
+            request += line;
+            from += count;
+        }
+    }
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+        fail(receiver, "send backfill request");
+        close(fd);
+        return -1;
+    }
+
+    // The stream port also carries live frames: only frames inside holes count
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    std::vector<uint8_t> buffer;
+    int recovered = 0;
+    while (!receiver->holes.empty()) {
+        int left = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now())
+                       .count();
+        pollfd pfd = {fd, POLLIN, 0};
+        if (left <= 0 || poll(&pfd, 1, left) <= 0) break;
+        uint8_t chunk[4096];
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buffer.insert(buffer.end(), chunk, chunk + n);
+
+        size_t pos = 0;
+        while (pos < buffer.size()) {
+            telemetry_event_t event;
+            size_t consumed = 0;
+            int result = telemetry_decode(buffer.data() + pos, buffer.size() - pos, &event, &consumed);
+            if (result == 0) break;
+            pos += consumed;
+            if (result < 0) continue;
+            if (fill_hole(receiver, event.seq)) {
+                receiver->delivered++;
+                events->push_back(event);
+                recovered++;
+            }
+            if (event.seq + 1 > (uint32_t)TELEMETRY_HISTORY_FRAMES) {
+                abandon_before(receiver, event.seq + 1 - TELEMETRY_HISTORY_FRAMES);
+            }
+        }
+        buffer.erase(buffer.begin(), buffer.begin() + pos);
+    }
+    close(fd);
+    return recovered;
+}
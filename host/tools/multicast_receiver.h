@@ -0,0 +1,65 @@
+/**
+ * @file multicast_receiver.h
+ * @brief Host receiver for multicast telemetry with gap tracking and TCP backfill
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Joins the group, decodes one telemetry frame per datagram and follows the
+ * sequence numbers: frames arriving in order are delivered, a jump records
+ * the skipped range as a hole, and a frame that falls into a hole (late
+ * datagram or backfill) fills it. Duplicates are dropped. Holes are fetched
+ * with multicast_backfill() from the controller's TCP stream port, which
+ * holds the last TELEMETRY_HISTORY_FRAMES frames.
+ *
+ * Delivery is not reordered: late and backfilled frames come out when they
+ * arrive, with their own seq and device timestamp.
+ */
+
+#ifndef HOST_MULTICAST_RECEIVER_H
+#define HOST_MULTICAST_RECEIVER_H
+
+#include "telemetry.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct multicast_hole_t {
+    uint32_t from;                       // First missing seq
+    uint32_t to;                         // One past the last
+};
+
+struct multicast_receiver_t {
+    int fd = -1;
+    bool started = false;                // First frame seen (seq baseline)
+    uint32_t next_seq = 0;               // Expected next seq
+    std::vector<multicast_hole_t> holes; // Oldest first
+    uint64_t datagrams = 0;
+    uint64_t delivered = 0;
+    uint64_t duplicates = 0;
+    uint64_t invalid = 0;                // Not exactly one valid frame
+    uint64_t filled = 0;                 // Frames that closed part of a hole
+    uint64_t abandoned = 0;              // Missing frames given up on (older than the device history)
+    std::string error;
+};
+
+// Join group:port on the interface with address iface ("0.0.0.0" = default route)
+bool multicast_receiver_open(multicast_receiver_t* receiver, const char* group, uint16_t port,
+                             const char* iface = "0.0.0.0");
+void multicast_receiver_close(multicast_receiver_t* receiver);
+
+// Receive for up to timeout_ms (0 = what is queued); appends new frames, returns their count or -1
+int multicast_receiver_poll(multicast_receiver_t* receiver, int timeout_ms, std::vector<telemetry_event_t>* events);
+
+// Offer one decoded frame (from a datagram or backfill); true if new
+bool multicast_receiver_accept(multicast_receiver_t* receiver, const telemetry_event_t& event);
+
+uint64_t multicast_receiver_missing(const multicast_receiver_t* receiver);  // Frames currently in holes
+
+// Fetch the holes over TCP from host:port; appends recovered frames, returns their count or -1.
+// Holes the device no longer holds are abandoned once it answers without them.
+int multicast_backfill(multicast_receiver_t* receiver, const char* host, uint16_t port, int timeout_ms,
+                       std::vector<telemetry_event_t>* events);
+
+#endif // HOST_MULTICAST_RECEIVER_H
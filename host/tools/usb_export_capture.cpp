@@ -0,0 +1,122 @@
+/**
+ * @file usb_export_capture.cpp
+ * @brief Host receiver for the USB bulk export stream
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "usb_export_capture.h"
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void usb_export_capture_reset(usb_export_capture_t* capture) {
+    *capture = usb_export_capture_t();
+}
+
+// Payload of one valid frame; false if its content is malformed
+static bool unpack(usb_export_capture_t* capture, const usb_export_frame_t& frame) {
+    const uint8_t* p = frame.payload;
+    size_t len = frame.len;
+    switch ((UsbExportFrame)frame.type) {
+        case UsbExportFrame::BEGIN:
+            if (len != USB_EXPORT_BEGIN_LEN || p[0] != USB_EXPORT_VERSION) return false;
+            capture->boot = get_u32(p + 1);
+            capture->uptime_ms = get_u32(p + 5);
+            capture->telemetry_from = get_u32(p + 9);
+            capture->telemetry_to = get_u32(p + 13);
+            capture->log_bytes = get_u32(p + 17);
+            capture->crash_count = p[21];
+            return true;
+        case UsbExportFrame::TELEMETRY:
+            for (size_t pos = 0; pos < len;) {
+                telemetry_event_t event;
+                size_t consumed = 0;
+                if (telemetry_decode(p + pos, len - pos, &event, &consumed) != 1) return false;
+                capture->telemetry.push_back(event);
+                pos += consumed;
+            }
+            return true;
+        case UsbExportFrame::LOG:
+            for (size_t pos = 0; pos < len;) {
+                if (len - pos < BINLOG_HISTORY_ENTRY_HEADER || len - pos - BINLOG_HISTORY_ENTRY_HEADER < p[pos + 4]) {
+                    return false;
+                }
+                usb_export_log_line_t line;
+                line.timestamp_us = get_u32(p + pos);
+                line.text.assign(reinterpret_cast<const char*>(p + pos + BINLOG_HISTORY_ENTRY_HEADER), p[pos + 4]);
+                capture->logs.push_back(line);
+                pos += BINLOG_HISTORY_ENTRY_HEADER + p[pos + 4];
+            }
+            return true;
+        case UsbExportFrame::CRASH:
+            if (len % USB_EXPORT_CRASH_RECORD_LEN != 0) return false;
+            for (size_t pos = 0; pos < len; pos += USB_EXPORT_CRASH_RECORD_LEN) {
+                crash_record_t record;
+                record.boot = get_u32(p + pos);
+                record.uptime_ms = get_u32(p + pos + 4);
+                record.reason = p[pos + 8];
+                record.system_state = p[pos + 9];
+                capture->crashes.push_back(record);
+            }
+            return true;
+        case UsbExportFrame::END:
+            if (len != USB_EXPORT_END_LEN) return false;
+            capture->device_frames = get_u32(p);
+            capture->device_bytes = get_u32(p + 4);
+            capture->device_elapsed_us = get_u32(p + 8);
+            capture->telemetry_lost = get_u32(p + 12);
+            capture->log_lost = get_u32(p + 16);
+            capture->ended = true;
+            return true;
+        default:
+            return false;
+    }
+}
+
+static void accept_frame(usb_export_capture_t* capture, const usb_export_frame_t& frame, size_t frame_len) {
+    if (frame.type == (uint8_t)UsbExportFrame::BEGIN) {
+        // A new export restarts the capture (pending keeps its storage: frame points into it)
+        uint64_t skipped = capture->skipped_bytes;
+        std::vector<uint8_t> pending;
+        pending.swap(capture->pending);
+        *capture = usb_export_capture_t();
+        capture->pending.swap(pending);
+        capture->skipped_bytes = skipped;
+        capture->begun = true;
+        capture->next_seq = frame.seq;
+    }
+    if (!capture->begun || capture->ended) return;
+
+    capture->missing_frames += (uint16_t)(frame.seq - capture->next_seq);
+    capture->next_seq = (uint16_t)(frame.seq + 1);
+    capture->frames++;
+    if (frame.type != (uint8_t)UsbExportFrame::END) capture->frame_bytes += frame_len;
+    if (!unpack(capture, frame)) capture->bad_payloads++;
+}
+
+void usb_export_capture_feed(usb_export_capture_t* capture, const uint8_t* data, size_t len) {
+    std::vector<uint8_t>& buffer = capture->pending;
+    buffer.insert(buffer.end(), data, data + len);
+
+    size_t pos = 0;
+    while (pos < buffer.size()) {
+        usb_export_frame_t frame;
+        int used = usb_export_decode_frame(buffer.data() + pos, buffer.size() - pos, &frame);
+        if (used == 0) break;
+        if (used < 0) {
+            capture->skipped_bytes++;                  // Resync one byte further on
+            pos++;
+            continue;
+        }
+        accept_frame(capture, frame, (size_t)used);
+        pos += (size_t)used;
+    }
+    capture->pending.erase(capture->pending.begin(), capture->pending.begin() + pos);
+}
+
+bool usb_export_capture_complete(const usb_export_capture_t* capture) {
+    return capture->begun && capture->ended && capture->missing_frames == 0 && capture->bad_payloads == 0 &&
+           capture->frames == (uint64_t)capture->device_frames + 1 && capture->frame_bytes == capture->device_bytes;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file usb_export_capture.h
+ * @brief Host receiver for the USB bulk export stream
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Splits the byte stream into export frames with the firmware's own
+ * usb_export_decode_frame(), skipping anything between frames (console text
+ * on a shared port, a corrupted frame) and counting what it skipped. Frame
+ * seq gaps count lost frames. Payloads are unpacked into telemetry events,
+ * log lines and crash records. Shared by usbdump, bench_usb_export and
+ * fuzz_usb_export.
+ */
+
+#ifndef HOST_USB_EXPORT_CAPTURE_H
+#define HOST_USB_EXPORT_CAPTURE_H
+
+#include "usb_export.h"
+#include "telemetry.h"
+#include "binlog.h"
+#include "crash_log.h"
+
+#include <string>
+#include <vector>
+
+struct usb_export_log_line_t {
+    uint32_t timestamp_us;
+    std::string text;
+};
+
+/**
+ * @brief Capture state; feed the stream in pieces of any size
+ */
+struct usb_export_capture_t {
+    bool begun = false;                  // BEGIN seen (frames before it are ignored)
+    bool ended = false;                  // END seen
+    uint32_t boot = 0;                   // From BEGIN
+    uint32_t uptime_ms = 0;
+    uint32_t telemetry_from = 0;
+    uint32_t telemetry_to = 0;
+    uint32_t log_bytes = 0;
+    uint8_t crash_count = 0;
+    uint32_t device_frames = 0;          // From END
+    uint32_t device_bytes = 0;
+    uint32_t device_elapsed_us = 0;
+    uint32_t telemetry_lost = 0;
+    uint32_t log_lost = 0;
+
+    std::vector<telemetry_event_t> telemetry;
+    std::vector<usb_export_log_line_t> logs;
+    std::vector<crash_record_t> crashes;
+
+    uint64_t frames = 0;                 // Valid frames after BEGIN, END included
+    uint64_t frame_bytes = 0;            // Their bytes, END excluded (compare with device_bytes)
+    uint64_t skipped_bytes = 0;          // Not part of a valid frame
+    uint64_t missing_frames = 0;         // seq gaps
+    uint64_t bad_payloads = 0;           // Valid frame, malformed content
+    uint16_t next_seq = 0;
+    std::vector<uint8_t> pending;
+};
+
+void usb_export_capture_reset(usb_export_capture_t* capture);
+void usb_export_capture_feed(usb_export_capture_t* capture, const uint8_t* data, size_t len);
+
+// Complete and consistent: END seen, nothing missing or malformed, byte count matches
+bool usb_export_capture_complete(const usb_export_capture_t* capture);
+
+#endif // HOST_USB_EXPORT_CAPTURE_H
@@ -0,0 +1,178 @@
+/**
+ * @file usbdump.cpp
+ * @brief Host receiver for the controller's USB bulk export
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * Opens the serial device, puts it in raw mode, writes the 'X' trigger and
+ * captures the export until its END frame (or 5 s without data). A file or
+ * "-" (stdin) is decoded offline instead, e.g. a capture made with cat.
+ * Writes <prefix>.telemetry.csv, <prefix>.log.txt and <prefix>.crash.txt
+ * and reports the transfer rate measured here and by the device.
+ *
+ *   usbdump /dev/ttyACM0 [prefix]
+ *   usbdump capture.bin [prefix]
+ */
+
+#include "usb_export_capture.h"
+#include "state_machine.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+
+static constexpr int kIdleTimeoutMs = 5000;
+static constexpr double kConsoleBaud = 115200.0;     // 10 bits per byte on the UART console
+
+static bool open_device(const char* path, int* fd_out) {
+    int fd = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) return false;
+    termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIOFLUSH);
+    }
+    *fd_out = fd;
+    return true;
+}
+
+/**
+ * @brief Read until END or idle timeout; returns seconds from the first byte to END
+ */
+static double capture_stream(int fd, bool live, usb_export_capture_t* capture) {
+    using clock = std::chrono::steady_clock;
+    clock::time_point first;
+    bool have_first = false;
+    double seconds = 0.0;
+    uint8_t chunk[16384];
+    while (!capture->ended) {
+        pollfd pfd = {fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, live ? kIdleTimeoutMs : -1);
+        if (ready <= 0) break;
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        if (!have_first) {
+            first = clock::now();
+            have_first = true;
+        }
+        usb_export_capture_feed(capture, chunk, (size_t)n);
+        seconds = std::chrono::duration<double>(clock::now() - first).count();
+    }
+    return seconds;
+}
+
+static bool write_outputs(const usb_export_capture_t& capture, const std::string& prefix) {
+    FILE* csv = fopen((prefix + ".telemetry.csv").c_str(), "w");
+    FILE* log = fopen((prefix + ".log.txt").c_str(), "w");
+    FILE* crash = fopen((prefix + ".crash.txt").c_str(), "w");
+    bool ok = csv && log && crash;
+    if (ok) {
+        fprintf(csv, "seq,time_ms,type,ph,ec,volume,temperature,pump,from,to,alarm,severity,raised,value\n");
+        for (const telemetry_event_t& e : capture.telemetry) {
+            switch (e.type) {
+                case TelemetryType::READING:
+                    fprintf(csv, "%u,%u,reading,%.3f,%.3f,%.1f,%.2f,,,,,,,\n", e.seq, e.timestamp, e.reading.ph,
+                            e.reading.ec, e.reading.volume, e.reading.temperature);
+                    break;
+                case TelemetryType::PUMP:
+                    fprintf(csv, "%u,%u,pump,,,,,%u,%s,%s,,,,\n", e.seq, e.timestamp, e.pump,
+                            pump_state_to_string((PumpState)e.from_state), pump_state_to_string((PumpState)e.to_state));
+                    break;
+                case TelemetryType::ALARM:
+                    fprintf(csv, "%u,%u,alarm,,,,,,,,%s,%u,%d,%.3f\n", e.seq, e.timestamp, e.alarm_name, e.severity,
+                            e.raised ? 1 : 0, e.value);
+                    break;
+            }
+        }
+        for (const usb_export_log_line_t& line : capture.logs) {
+            fprintf(log, "%9lu.%06lu  %s\n", (unsigned long)(line.timestamp_us / 1000000u),
+                    (unsigned long)(line.timestamp_us % 1000000u), line.text.c_str());
+        }
+        for (const crash_record_t& record : capture.crashes) {
+            fprintf(crash, "boot %u: %s after %u s in %s\n", record.boot, crash_log_reason_to_string(record.reason),
+                    record.uptime_ms / 1000, system_state_to_string((SystemState)record.system_state));
+        }
+    }
+    if (csv) fclose(csv);
+    if (log) fclose(log);
+    if (crash) fclose(crash);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "usage: %s <device | capture | -> [prefix]\n", argv[0]);
+        return 2;
+    }
+    const char* path = argv[1];
+    std::string prefix = argc == 3 ? argv[2] : "export";
+
+    int fd = STDIN_FILENO;
+    bool live = false;
+    if (strcmp(path, "-") != 0) {
+        struct stat st;
+        if (stat(path, &st) != 0) {
+            fprintf(stderr, "usbdump: cannot open %s: %s\n", path, strerror(errno));
+            return 2;
+        }
+        live = S_ISCHR(st.st_mode);
+        if (live ? !open_device(path, &fd) : (fd = open(path, O_RDONLY | O_CLOEXEC)) < 0) {
+            fprintf(stderr, "usbdump: cannot open %s: %s\n", path, strerror(errno));
+            return 2;
+        }
+    }
+    if (live) {
+        char trigger = USB_EXPORT_TRIGGER;
+        if (write(fd, &trigger, 1) != 1) {
+            fprintf(stderr, "usbdump: cannot write to %s: %s\n", path, strerror(errno));
+            return 2;
+        }
+    }
+
+    usb_export_capture_t capture;
+    double seconds = capture_stream(fd, live, &capture);
+    if (fd != STDIN_FILENO) close(fd);
+
+    if (!capture.begun) {
+        fprintf(stderr, "%s: no export found (%llu bytes skipped)\n", path, (unsigned long long)capture.skipped_bytes);
+        return 1;
+    }
+    if (!write_outputs(capture, prefix)) {
+        fprintf(stderr, "usbdump: cannot write %s.*\n", prefix.c_str());
+        return 2;
+    }
+
+    printf("Boot %u, uptime %u s: %zu telemetry frames, %zu log lines, %zu crash record(s) -> %s.*\n", capture.boot,
+           capture.uptime_ms / 1000, capture.telemetry.size(), capture.logs.size(), capture.crashes.size(),
+           prefix.c_str());
+    printf("Frames %llu, %llu missing, %llu malformed; %llu bytes skipped between frames\n",
+           (unsigned long long)capture.frames, (unsigned long long)capture.missing_frames,
+           (unsigned long long)capture.bad_payloads, (unsigned long long)capture.skipped_bytes);
+    if (capture.telemetry_lost || capture.log_lost) {
+        printf("Overwritten on the device before they were sent: %u telemetry frames, %u log bytes\n",
+               capture.telemetry_lost, capture.log_lost);
+    }
+    if (capture.ended) {
+        double kb = capture.device_bytes / 1024.0;
+        double device_s = capture.device_elapsed_us / 1e6;
+        printf("Transfer: %.1f KB", kb);
+        if (live && seconds > 0) printf(" in %.3f s here (%.1f KB/s)", seconds, kb / seconds);
+        if (device_s > 0) printf(", %.3f s on the device (%.1f KB/s)", device_s, kb / device_s);
+        printf("; %.1f s at %.0f baud\n", capture.device_bytes * 10.0 / kConsoleBaud, kConsoleBaud);
+    } else {
+        printf("Incomplete: no END frame (device aborted or stopped sending)\n");
+    }
+    return usb_export_capture_complete(&capture) ? 0 : 1;
+}
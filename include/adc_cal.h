@@ -0,0 +1,69 @@
+/**
+ * @file adc_cal.h
+ * @brief eFuse-calibrated ADC code to millivolt conversion through a lookup table
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A table builder over any code -> mV converter (pure; the host generator
+ *   adclut and the bench drive it with the same converter as the firmware)
+ * - adc_cal_init(): builds the table once at boot from the chip's eFuse
+ *   characteristics via the ESP-IDF curve-fitting scheme (esp_adc_cali) for
+ *   the board's attenuation
+ * - adc_cal_millivolts(): one indexed load per sample
+ * - adc_cal_millivolts_fine(): the same for a fractional code from the
+ *   oversampler, interpolated between the two neighbouring entries
+ *
+ * The curve-fitting conversion corrects the per-chip gain and the
+ * attenuation non-linearity that the plain 3.3 V / 4095 line ignores (the
+ * non-linearity alone is tens of mV near the rails, over 0.5 pH at the
+ * default slope). Calling esp_adc_cali per sample costs a 64-bit
+ * polynomial; the table costs 8 KB of RAM.
+ *
+ * A chip without eFuse calibration keeps the board's linear scale, computed
+ * exactly as before, so stored sensor calibrations stay valid. A chip that
+ * gains the curve needs a pH/EC recalibration ('p', 'e'): the offsets were
+ * fitted on the linear scale. The scale each probe was calibrated on is kept
+ * in NVS; on a mismatch calibration_check_adc_scale() pauses automatic dosing
+ * until the stale probes are recalibrated.
+ */
+
+#ifndef ADC_CAL_H
+#define ADC_CAL_H
+
+#include <Arduino.h>
+#include "board.h"
+
+//=============================================================================
+// ADC CALIBRATION CONFIGURATION
+//=============================================================================
+
+constexpr int ADC_CAL_CODES = 1 << Board::adc_bits;          // Table entries (4096 at 12 bits)
+
+/**
+ * @brief Where the conversion comes from
+ */
+enum class AdcCalSource : uint8_t {
+    LINEAR,                              // Board full scale / max code (no eFuse data)
+    EFUSE_CURVE                          // eFuse point + curve-fitting error correction
+};
+
+// One code -> mV conversion; false if the converter refused the code
+typedef bool (*adc_cal_convert_t)(void* ctx, int code, int* millivolts);
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Table (pure)
+bool adc_cal_build_lut(adc_cal_convert_t convert, void* ctx, uint16_t* lut, int codes);   // Clamped to 0-65535 mV
+
+// Firmware
+AdcCalSource adc_cal_init(void);                   // Build the table for Board::adc_attenuation
+float adc_cal_millivolts(int code);                // Calibrated mV, or the linear scale
+float adc_cal_millivolts_fine(float code);         // Fractional (oversampled) code: interpolated between entries
+AdcCalSource adc_cal_get_source(void);
+const char* adc_cal_source_to_string(AdcCalSource source);
+void adc_cal_print_status(void);
+
+#endif // ADC_CAL_H
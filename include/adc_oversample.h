@@ -0,0 +1,73 @@
+/**
+ * @file adc_oversample.h
+ * @brief Oversampling and decimation for extra effective ADC resolution (pH channel)
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A burst reader: 4^n conversions summed and shifted right by n, giving a
+ *   code n bits wider than the ADC (12 -> 14..16 bits at n = 2..4)
+ * - Optional injected dither: a callback sets a ramp level before each
+ *   conversion, spanning the burst so its mean is the same every burst
+ * - Noise measurement: the sample spread inside each burst (how much natural
+ *   dither the input carries) and the reading-to-reading noise of the
+ *   decimated codes, from successive differences so slow drift cancels
+ * - Effective resolution: ENOB = adc_bits - log2(sigma_lsb * sqrt(12)),
+ *   capped at the decimated width, and at the ADC width when the burst
+ *   spread is too small for the extra bits to be real
+ *
+ * Oversampling only resolves below one LSB when the input moves across code
+ * boundaries during the burst: a noiseless input returns the same code 4^n
+ * times. The ESP32-S3 ADC is usually noisy enough on its own; a board with
+ * Board::ph_dither_pin >= 0 injects a ramp as well. The state is
+ * caller-owned; the sample and dither callbacks are the only I/O.
+ */
+
+#ifndef ADC_OVERSAMPLE_H
+#define ADC_OVERSAMPLE_H
+
+#include <Arduino.h>
+#include "board.h"
+
+//=============================================================================
+// OVERSAMPLING CONFIGURATION
+//=============================================================================
+
+constexpr uint8_t ADC_OVERSAMPLE_MAX_BITS = 4;            // 256 conversions -> 16 bits
+constexpr float ADC_OVERSAMPLE_MIN_SPREAD_LSB = 0.5f;     // Burst spread below this: no dither, no extra bits
+
+// One raw conversion
+typedef int (*adc_sample_t)(void* ctx);
+// Set the injected dither level before conversion `step` of `steps` (bursts only, steps > 1)
+typedef void (*adc_dither_t)(void* ctx, int step, int steps);
+
+/**
+ * @brief Oversampler state: setting, last burst and noise statistics
+ */
+struct adc_oversample_t {
+    uint8_t extra_bits;          // n: 4^n conversions per reading (0 = one conversion)
+    // Last burst
+    uint32_t code;               // Decimated code, adc_bits + extra_bits wide
+    float burst_spread_lsb;      // Standard deviation of the burst's conversions (ADC LSBs)
+    // Reading-to-reading noise
+    uint32_t readings;           // Bursts since the statistics were reset
+    uint32_t last_code;
+    double diff_sum_sq;          // Sum of squared successive differences (decimated LSBs)
+    double spread_sum;           // Sum of burst spreads (ADC LSBs)
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void adc_oversample_init(adc_oversample_t* os, uint8_t extra_bits);   // Clamped to ADC_OVERSAMPLE_MAX_BITS
+void adc_oversample_reset_stats(adc_oversample_t* os);
+uint32_t adc_oversample_read(adc_oversample_t* os, adc_sample_t sample, adc_dither_t dither, void* ctx);   // dither may be null
+float adc_oversample_code(const adc_oversample_t* os);             // Last reading as a fractional ADC code
+
+// Measurement (from the statistics since the last reset)
+float adc_oversample_noise_lsb(const adc_oversample_t* os);        // Reading noise in ADC LSBs, -1 before 3 readings
+float adc_oversample_mean_spread_lsb(const adc_oversample_t* os);  // Mean burst spread in ADC LSBs, -1 before a reading
+float adc_oversample_effective_bits(const adc_oversample_t* os);   // ENOB, -1 before 3 readings
+
+#endif // ADC_OVERSAMPLE_H
@@ -0,0 +1,186 @@
+/**
+ * @file alarms.h
+ * @brief Rule-based alarm engine with compiled stack bytecode
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A small rule language ("ph < 5.2 hyst 0.1 for 10m crit") compiled into
+ *   stack bytecode, on the device at boot or on the host with alarmc
+ * - Rolling per-minute statistics (delta, rate, percent change, avg/min/max)
+ * - Per-comparison hysteresis plus raise (for) and clear (hold) timers
+ * - Publication of raise/clear events to the console and registered sinks
+ *
+ * Rule syntax, one rule per line (or separated by ';'), '#' starts a comment:
+ *
+ *   <name>: <expr> [for <dur>] [hold <dur>] [warn|crit]
+ *
+ *   expr     := expr or expr | expr and expr | not expr
+ *             | sum (< | <= | > | >=) sum [hyst <number>]
+ *   sum      := sum (+|-) term ; term := term (*|/) unary ; unary := -unary | primary
+ *   primary  := <number> | <variable> | abs(expr) | (expr)
+ *             | delta|rate|pct|avg|min|max(<channel>, <dur>)
+ *   dur      := <number>[s|m|h]     (bare number = seconds)
+ *
+ * Variables: ph, ec, volume, temp, ph_dosed (cumulative ml of pH Up + Down),
+ * auto_ph (1/0), loss_rate and excess_loss (L/h, from the volume balance).
+ * ph..ph_dosed are history channels usable in functions.
+ * Evaluation is allocation-free; all storage is sized by the constants below.
+ */
+
+#ifndef ALARMS_H
+#define ALARMS_H
+
+#include <Arduino.h>
+#include "sensors.h"
+
+//=============================================================================
+// ALARM CONFIGURATION
+//=============================================================================
+
+constexpr int ALARM_MAX_RULES = 64;                  // Rules per rule set
+constexpr int ALARM_CODE_SIZE = 2048;                // Bytecode pool shared by all rules (bytes)
+constexpr int ALARM_STACK_DEPTH = 16;                // VM stack depth (checked at compile time)
+constexpr int ALARM_NAME_LEN = 16;                   // Rule name incl. terminator
+constexpr int ALARM_MAX_SINKS = 4;                   // Extra event sinks besides the console
+constexpr uint32_t ALARM_HISTORY_PERIOD_MS = 60000;  // One history slot per minute (mean of readings)
+constexpr int ALARM_HISTORY_SLOTS = 128;             // ~2 h of history per channel
+constexpr size_t ALARM_RULES_TEXT_MAX = 3072;        // Stored rule text (NVS blob limit is ~4000)
+constexpr uint32_t ALARM_LINE_TIMEOUT_MS = 10000;    // Max wait per line while entering rules
+
+#define ALARM_NVS_NAMESPACE "alarms"    // Own namespace, keeps rule text out of sensor_cal
+#define ALARM_NVS_RULES_KEY "rules"
+
+//=============================================================================
+// ENUMERATIONS
+//=============================================================================
+
+/**
+ * @brief Rule inputs; the first ALARM_HISTORY_CHANNELS also keep history
+ */
+enum class AlarmVar : uint8_t {
+    PH = 0,
+    EC,
+    VOLUME,
+    TEMP,
+    PH_DOSED,          // Cumulative ml dosed by pH Up + pH Down
+    AUTO_PH,           // Auto pH control enabled (1/0)
+    LOSS_RATE,         // Volume balance loss rate (L/h, 0 until settled)
+    EXCESS_LOSS,       // Loss above the evaporation baseline (L/h)
+    COUNT
+};
+
+constexpr int ALARM_HISTORY_CHANNELS = static_cast<int>(AlarmVar::AUTO_PH);
+
+/**
+ * @brief Alarm severity
+ */
+enum class AlarmSeverity : uint8_t {
+    WARNING,
+    CRITICAL
+};
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Values a rule set is evaluated against (one reading)
+ */
+struct alarm_inputs_t {
+    float values[static_cast<int>(AlarmVar::COUNT)];
+    uint32_t timestamp;          // Reading timestamp (ms)
+};
+
+/**
+ * @brief Per-minute means of the history channels (ring buffer)
+ */
+struct alarm_history_t {
+    float slots[ALARM_HISTORY_CHANNELS][ALARM_HISTORY_SLOTS];
+    uint16_t head;               // Next slot to write
+    uint16_t count;              // Completed slots available
+    float sum[ALARM_HISTORY_CHANNELS];  // Accumulator for the slot in progress
+    uint16_t samples;            // Readings in the slot in progress
+    uint32_t slot_start;         // Start of the slot in progress (ms)
+};
+
+/**
+ * @brief Compiled rule plus its runtime state
+ */
+struct alarm_rule_t {
+    char name[ALARM_NAME_LEN];
+    uint16_t code_offset;        // Start of bytecode in alarm_program_t::code
+    uint16_t code_length;
+    uint32_t raise_delay_ms;     // Condition must hold this long to raise ("for")
+    uint32_t clear_delay_ms;     // Condition must be false this long to clear ("hold")
+    AlarmSeverity severity;
+
+    bool active;                 // Alarm currently raised
+    bool condition;              // Last evaluated condition
+    uint32_t condition_since;    // When condition last changed (ms)
+    uint32_t raised_at;          // When the alarm was last raised (ms)
+    uint16_t raise_count;        // Times raised since compile
+    float last_value;            // Left operand of the last comparison (the observed quantity)
+};
+
+/**
+ * @brief A compiled rule set
+ */
+struct alarm_program_t {
+    alarm_rule_t rules[ALARM_MAX_RULES];
+    uint8_t rule_count;
+    uint16_t code_used;
+    uint8_t code[ALARM_CODE_SIZE];
+};
+
+/**
+ * @brief Compile diagnostics (1-based line and column)
+ */
+struct alarm_compile_error_t {
+    int line;
+    int column;
+    char message[64];
+};
+
+/**
+ * @brief Raise/clear transition published to sinks
+ */
+struct alarm_event_t {
+    const char* name;
+    AlarmSeverity severity;
+    bool raised;                 // true = raised, false = cleared
+    float value;                 // Observed quantity at the transition (see last_value)
+    uint32_t timestamp;          // ms
+};
+
+typedef void (*alarm_sink_t)(const alarm_event_t& event);
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Compiler and evaluator (no Arduino I/O, usable on the host)
+bool alarm_compile(const char* text, alarm_program_t* program, alarm_compile_error_t* error);
+float alarm_evaluate(const alarm_program_t* program, const alarm_rule_t* rule,
+                     const alarm_inputs_t* inputs, const alarm_history_t* history, float* observed);
+int alarm_program_step(alarm_program_t* program, const alarm_inputs_t* inputs,
+                       const alarm_history_t* history, alarm_event_t* events, int max_events);
+void alarm_disassemble(const alarm_program_t* program, int rule_index,
+                       void (*emit)(const char* line, void* ctx), void* ctx);
+const char* alarm_severity_to_string(AlarmSeverity severity);
+
+// Rolling statistics
+void alarm_history_reset(alarm_history_t* history, uint32_t now);
+void alarm_history_push(alarm_history_t* history, const alarm_inputs_t* inputs);
+
+// Firmware alarm engine
+bool alarm_init(void);                                  // Load rules from NVS (or defaults) and compile
+void alarm_update(const sensor_readings_t& readings);   // Evaluate all rules for one reading
+bool alarm_add_sink(alarm_sink_t sink);                 // Publish events to an additional sink
+void alarm_publish(const alarm_event_t& event);         // Publish a transition raised outside the rule set
+bool alarm_set_rules(const char* text);                 // Compile, activate and store a rule set
+void alarm_interactive_rules(void);                     // Enter a rule set via Serial/Telnet
+void alarm_print_status(void);                          // Print rules and their state
+int alarm_active_count(void);                           // Number of raised alarms
+
+#endif // ALARMS_H
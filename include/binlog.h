@@ -0,0 +1,150 @@
+/**
+ * @file binlog.h
+ * @brief Deferred-formatting binary logger for ISRs, timer callbacks and tasks
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - binlog(fmt, args...): push a compact record (format pointer, micros()
+ *   timestamp, raw argument words) into a lock-free MPSC ring
+ * - binlog_drain(): format pending records in the main loop and publish
+ *   them to the console and registered sinks
+ * - A raw frame stream for sinks that ship records unformatted; the host
+ *   tool logdump turns it back into text
+ * - A flight recorder: the most recent formatted lines stay in a byte ring
+ *   (BINLOG_HISTORY_BYTES) for bulk export after the fact
+ *
+ * A call site costs one slot claim (compare-and-swap on the write index),
+ * a few word copies and one release store; there is no formatting, no lock
+ * and no allocation, so it is safe from ISRs, esp_timer callbacks and either
+ * core. When the ring is full the record is dropped and counted; the drain
+ * reports the count. Formatting happens only in binlog_drain().
+ *
+ * Arguments are stored as words, so only these conversions are supported:
+ * - %d %i %u %x %X %o %c (32 bits; l/h/z length modifiers are ignored)
+ * - %f %e %g (stored as float)
+ * - %s (the pointer is stored, so the string must outlive the drain:
+ *   literals and constant tables only, never stack buffers)
+ * The format string itself must be a literal for the same reason.
+ */
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+//=============================================================================
+// BINLOG CONFIGURATION
+//=============================================================================
+
+constexpr int BINLOG_RING_SIZE = 64;         // Records (power of two)
+constexpr int BINLOG_MAX_ARGS = 6;           // Argument words per record
+constexpr int BINLOG_DRAIN_PER_LOOP = 8;     // Records formatted per loop() pass
+constexpr int BINLOG_MAX_SINKS = 4;          // Extra sinks besides the console
+constexpr int BINLOG_LINE_MAX = 160;         // Formatted line incl. terminator
+constexpr int BINLOG_DICT_SIZE = 64;         // Strings the raw stream remembers
+constexpr size_t BINLOG_HISTORY_BYTES = 16384;   // Flight recorder (power of two)
+
+// Flight recorder entries: u32 timestamp us, u8 len, len bytes of text.
+// Positions are byte offsets counted since binlog_init (wrapping u32).
+constexpr size_t BINLOG_HISTORY_ENTRY_HEADER = 5;
+
+// Raw stream frames (little-endian). A stream starts with the magic; a string
+// id is defined by an 'S' frame before the first record that uses it and may
+// be redefined later (the dictionary is small and recycled).
+//   'S' u16 id, u16 len, len bytes             string (format or %s argument)
+//   'R' u16 fmt id, u32 timestamp us, u8 argc, argc x u32 words (%s -> id)
+//   'D' u32 records dropped since the last 'D'
+#define BINLOG_STREAM_MAGIC "BLG1"
+constexpr uint8_t BINLOG_FRAME_STRING = 'S';
+constexpr uint8_t BINLOG_FRAME_RECORD = 'R';
+constexpr uint8_t BINLOG_FRAME_DROPPED = 'D';
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+typedef uintptr_t binlog_word_t;             // 32 bits on the device, wide enough for %s pointers on the host
+
+/**
+ * @brief One captured log call
+ */
+struct binlog_record_t {
+    const char* fmt;
+    uint32_t timestamp_us;                   // micros() at the call
+    uint8_t argc;
+    binlog_word_t args[BINLOG_MAX_ARGS];
+};
+
+/**
+ * @brief Logger counters (since binlog_init)
+ */
+struct binlog_stats_t {
+    uint32_t written;                        // Records accepted into the ring
+    uint32_t dropped;                        // Records lost to a full ring
+    uint32_t high_water;                     // Most records seen pending at a drain
+    uint32_t pending;                        // Records waiting now
+};
+
+typedef void (*binlog_text_sink_t)(const binlog_record_t& record, const char* text);
+typedef void (*binlog_raw_sink_t)(const uint8_t* data, size_t len);
+
+// Resolves a %s argument word to text (pointer on the device, id in a dump)
+typedef const char* (*binlog_string_fn)(binlog_word_t word, void* ctx);
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void binlog_init(void);                      // Empty the ring, reset counters and sinks
+bool binlog_push(const char* fmt, const binlog_word_t* args, uint8_t argc);  // false = dropped
+int binlog_drain(int max_records);           // Returns records published
+binlog_stats_t binlog_get_stats(void);
+void binlog_print_stats(void);
+
+bool binlog_add_sink(binlog_text_sink_t sink);           // Formatted lines
+bool binlog_add_raw_sink(binlog_raw_sink_t sink);        // Raw frames, starts with the magic
+bool binlog_remove_raw_sink(binlog_raw_sink_t sink);      // false if it was not registered
+
+// Flight recorder: entries between oldest and end; reading from *cursor copies
+// whole entries and advances it (a cursor already overwritten restarts at oldest)
+uint32_t binlog_history_oldest(void);
+uint32_t binlog_history_end(void);
+size_t binlog_history_read(uint32_t* cursor, uint32_t end, uint8_t* out, size_t out_len);
+
+// Format a record's arguments; also used by the host decoder
+size_t binlog_format(char* out, size_t out_len, const char* fmt, const binlog_word_t* args, uint8_t argc,
+                     binlog_string_fn string_at, void* ctx);
+
+// Argument conversion: integers keep their low 32 bits, floats their IEEE bits
+template <typename T>
+inline binlog_word_t binlog_word(T value) {
+    if constexpr (std::is_floating_point<T>::value) {
+        float f = (float)value;
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        return bits;
+    } else if constexpr (std::is_pointer<T>::value) {
+        return (binlog_word_t)value;
+    } else {
+        return (binlog_word_t)(uint32_t)value;
+    }
+}
+
+/**
+ * @brief Log a record (any context; see the file comment for allowed formats)
+ * @return false if the ring was full and the record was dropped
+ */
+template <typename... Args>
+inline bool binlog(const char* fmt, Args... args) {
+    static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "too many binlog arguments");
+    const binlog_word_t words[sizeof...(Args) + 1] = {binlog_word(args)..., 0};
+    return binlog_push(fmt, words, (uint8_t)sizeof...(Args));
+}
+
+#endif // BINLOG_H
@@ -0,0 +1,103 @@
+/**
+ * @file block_pool.h
+ * @brief Fixed-block pools for network, telemetry and command buffers
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - Three pools carved out of static storage at boot: message buffers,
+ *   connection contexts and frame buffers
+ * - O(1) alloc/free (intrusive free list), no fragmentation
+ * - Per-pool usage, high-water mark and exhaustion counters
+ * - pool_new/pool_delete for constructing objects in a pool block
+ *
+ * Network, telemetry and command paths draw their per-request buffers and
+ * per-connection objects from these pools instead of new/delete or Arduino
+ * String, so the heap stays flat after init however long the uptime. An
+ * exhausted pool returns nullptr; callers degrade (drop the message, refuse
+ * the connection) and the exhaustion is counted for 'C'.
+ *
+ * Pools are used from the main loop only (like the rest of the firmware);
+ * they are not safe from ISRs or other tasks.
+ */
+
+#ifndef BLOCK_POOL_H
+#define BLOCK_POOL_H
+
+#include <Arduino.h>
+#include <new>
+#include <utility>
+
+//=============================================================================
+// POOL CONFIGURATION
+//=============================================================================
+
+constexpr size_t POOL_MESSAGE_BLOCK = 544;       // One Debug->printf line (512) plus timestamp prefix
+constexpr int POOL_MESSAGE_COUNT = 6;
+constexpr size_t POOL_CONNECTION_BLOCK = 192;    // Server or client context object
+constexpr int POOL_CONNECTION_COUNT = 12;        // Telnet, telemetry, Modbus and WebSocket servers plus their clients
+constexpr size_t POOL_FRAME_BLOCK = 1024;        // Telemetry/protocol frame
+constexpr int POOL_FRAME_COUNT = 6;              // Modbus receive buffers, WebSocket handshakes
+
+constexpr int POOL_MAX_BLOCKS = 32;              // Per pool (in-use bitmap width)
+
+//=============================================================================
+// ENUMERATIONS AND DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Pool selector
+ */
+enum class PoolId {
+    MESSAGE,
+    CONNECTION,
+    FRAME,
+    COUNT
+};
+
+/**
+ * @brief Pool counters (since pool_init)
+ */
+struct pool_stats_t {
+    size_t block_size;
+    uint16_t block_count;
+    uint16_t in_use;
+    uint16_t high_water;                 // Most blocks in use at once
+    uint32_t allocs;
+    uint32_t exhausted;                  // Allocations refused (pool empty)
+    uint32_t bad_frees;                  // Foreign pointers and double frees (ignored)
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void pool_init(void);                            // Build the free lists (boot; invalidates all blocks)
+void* pool_alloc(PoolId pool);                   // nullptr when exhausted
+bool pool_free(PoolId pool, void* block);        // false for a pointer the pool did not hand out
+pool_stats_t pool_get_stats(PoolId pool);
+const char* pool_name(PoolId pool);
+void pool_print_status(void);
+
+/**
+ * @brief Construct an object in a pool block
+ * @return nullptr if the pool is exhausted
+ */
+template <typename T, typename... Args>
+inline T* pool_new(PoolId pool, Args&&... args) {
+    static_assert(alignof(T) <= 8, "pool blocks are 8-byte aligned");
+    void* block = pool_alloc(pool);
+    return block ? new (block) T(std::forward<Args>(args)...) : nullptr;
+}
+
+/**
+ * @brief Destroy an object made with pool_new and return its block
+ */
+template <typename T>
+inline void pool_delete(PoolId pool, T* object) {
+    if (object == nullptr) return;
+    object->~T();
+    pool_free(pool, object);
+}
+
+#endif // BLOCK_POOL_H
@@ -0,0 +1,164 @@
+/**
+ * @file board.h
+ * @brief Compile-time board descriptors (pins, ADC, pumps, PWM) per PCB revision
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - One descriptor type per board revision: static constexpr pins, ADC
+ *   channels/attenuation/resolution, pH dither output, redundant probe
+ *   inputs, pump count and PWM parameters
+ * - Board: the descriptor selected by HYDRO_BOARD_REV (a build flag set per
+ *   PlatformIO env; revision 1 when unset, as in the host build)
+ * - board_check<B>: static_asserts rejecting combinations the ESP32-S3 or
+ *   this firmware cannot run (ADC2 inputs, shared or reserved pins, PWM out
+ *   of the LEDC range, a pump count the PumpId enum does not have)
+ *
+ * The module constants (PH_PIN, PUMP_PWM_FREQ, ...) are defined from Board,
+ * so each variant is constant-folded exactly like the literals were.
+ *
+ * Adding a revision: copy board_rev1_t, change what differs, add an #elif
+ * below and an env in platformio.ini with build_flags = -DHYDRO_BOARD_REV=<n>.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// BOARD DESCRIPTORS
+//=============================================================================
+
+/**
+ * @brief Revision 1: ESP32-S3-DevKitC-1 carrier
+ */
+struct board_rev1_t {
+    static constexpr const char* name = "rev 1 (ESP32-S3-DevKitC-1)";
+
+    // Analog sensors (ADC1: GPIO1-10 = channels 0-9)
+    static constexpr int ph_pin = 6;                             // GPIO6, ADC1_CH5
+    static constexpr int ph_adc_channel = 5;
+    static constexpr int ec_pin = 5;                             // GPIO5, ADC1_CH4
+    static constexpr int ec_adc_channel = 4;
+    static constexpr adc_attenuation_t adc_attenuation = ADC_11db;
+    static constexpr int adc_bits = 12;
+    static constexpr float adc_ref_volts = 3.3f;                 // Full-scale voltage the calibration assumes
+    static constexpr int ph_dither_pin = -1;                     // LEDC ramp into the pH input via a resistor (-1 = none)
+
+    // Redundant probe inputs (first = ph_pin / ec_pin; spare ADC1 pins on the header)
+    static constexpr int ph_probe_count = 3;
+    static constexpr int ph_probe_pins[ph_probe_count] = {6, 1, 2};     // ADC1_CH5, CH0, CH1
+    static constexpr int ec_probe_count = 2;
+    static constexpr int ec_probe_pins[ec_probe_count] = {5, 3};        // ADC1_CH4, CH2
+
+    // Sensor power, ultrasonic and 1-Wire
+    static constexpr int ph_power_pin = 7;
+    static constexpr int ec_power_pin = 4;
+    static constexpr int trig_pin = 8;
+    static constexpr int echo_pin = 9;
+    static constexpr int temp_pin = 10;
+
+    // Pumps (PumpId order, one LEDC channel each)
+    static constexpr int pump_count = 4;
+    static constexpr int pump_pins[pump_count] = {11, 12, 13, 14};
+    static constexpr uint32_t pwm_freq_hz = 1000;
+    static constexpr int pwm_resolution_bits = 8;
+};
+
+//=============================================================================
+// VALIDATION
+//=============================================================================
+
+constexpr int BOARD_MAX_GPIO = 48;
+constexpr int BOARD_LEDC_CHANNELS = 8;
+constexpr uint32_t BOARD_LEDC_CLOCK_HZ = 80000000;   // APB clock: freq << bits must fit
+
+constexpr bool board_adc1_pin(int pin) {
+    return pin >= 1 && pin <= 10;
+}
+
+// Native USB (19/20, used by the bulk export), SPI flash/PSRAM (26-32) and GPIOs the S3 does not have
+constexpr bool board_usable_pin(int pin) {
+    return pin >= 0 && pin <= BOARD_MAX_GPIO && pin != 19 && pin != 20 && !(pin >= 22 && pin <= 32);
+}
+
+template <typename B>
+constexpr bool board_probe_pins_ok() {
+    if (B::ph_probe_count < 1 || B::ec_probe_count < 1) return false;
+    if (B::ph_probe_pins[0] != B::ph_pin || B::ec_probe_pins[0] != B::ec_pin) return false;
+    for (int i = 0; i < B::ph_probe_count; i++) {
+        if (!board_adc1_pin(B::ph_probe_pins[i])) return false;
+    }
+    for (int i = 0; i < B::ec_probe_count; i++) {
+        if (!board_adc1_pin(B::ec_probe_pins[i])) return false;
+    }
+    return true;
+}
+
+template <typename B>
+constexpr bool board_pins_ok() {
+    const int fixed[] = {B::ph_pin, B::ec_pin, B::ph_power_pin, B::ec_power_pin,
+                         B::trig_pin, B::echo_pin, B::temp_pin};
+    constexpr int fixed_count = sizeof(fixed) / sizeof(fixed[0]);
+    constexpr int probe_extra = (B::ph_probe_count - 1) + (B::ec_probe_count - 1);
+    constexpr int total = fixed_count + B::pump_count + probe_extra;
+    int pins[total] = {};
+    int n = 0;
+    for (int i = 0; i < fixed_count; i++) pins[n++] = fixed[i];
+    for (int i = 0; i < B::pump_count; i++) pins[n++] = B::pump_pins[i];
+    for (int i = 1; i < B::ph_probe_count; i++) pins[n++] = B::ph_probe_pins[i];
+    for (int i = 1; i < B::ec_probe_count; i++) pins[n++] = B::ec_probe_pins[i];
+    for (int i = 0; i < total; i++) {
+        if (!board_usable_pin(pins[i])) return false;
+        for (int j = 0; j < i; j++) {
+            if (pins[i] == pins[j]) return false;
+        }
+    }
+    if (B::ph_dither_pin >= 0) {
+        if (!board_usable_pin(B::ph_dither_pin)) return false;
+        for (int i = 0; i < total; i++) {
+            if (pins[i] == B::ph_dither_pin) return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Compile-time checks for a board descriptor (instantiated for Board below)
+ */
+template <typename B>
+struct board_check {
+    static_assert(board_adc1_pin(B::ph_pin) && board_adc1_pin(B::ec_pin),
+                  "pH/EC inputs must be on ADC1 (GPIO1-10): ADC2 is unavailable while WiFi runs");
+    static_assert(B::ph_adc_channel == B::ph_pin - 1 && B::ec_adc_channel == B::ec_pin - 1,
+                  "ADC1 channel n is GPIO n+1");
+    static_assert(B::adc_bits >= 9 && B::adc_bits <= 12, "ESP32-S3 ADC resolution is 9-12 bits");
+    static_assert(B::adc_ref_volts > 0.0f, "ADC full scale must be positive");
+    static_assert(B::pump_count >= 1 && B::pump_count + (B::ph_dither_pin >= 0 ? 1 : 0) <= BOARD_LEDC_CHANNELS,
+                  "one LEDC channel per pump and for the pH dither");
+    static_assert(B::pwm_resolution_bits >= 1 && B::pwm_resolution_bits <= 8, "pump duties are 8-bit");
+    static_assert(B::pwm_freq_hz > 0 && (B::pwm_freq_hz << B::pwm_resolution_bits) <= BOARD_LEDC_CLOCK_HZ,
+                  "PWM frequency too high for this resolution");
+    static_assert(board_probe_pins_ok<B>(),
+                  "probe inputs must start with ph_pin/ec_pin and all be on ADC1");
+    static_assert(board_pins_ok<B>(), "pins must be distinct, exist and not be USB, flash or PSRAM pins");
+};
+
+//=============================================================================
+// BOARD SELECTION
+//=============================================================================
+
+#ifndef HYDRO_BOARD_REV
+#define HYDRO_BOARD_REV 1
+#endif
+
+#if HYDRO_BOARD_REV == 1
+using Board = board_rev1_t;
+#else
+#error "Unknown HYDRO_BOARD_REV (see board.h)"
+#endif
+
+static_assert(sizeof(board_check<Board>) > 0, "instantiates the board checks");
+
+#endif // BOARD_H
@@ -0,0 +1,121 @@
+/**
+ * @file cal_history.h
+ * @brief Calibration history per probe: rollback and probe-aging trend
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A ring of the last CAL_HISTORY_RECORDS 2-point calibrations per probe
+ *   (pH, EC): when, the two points, and the fitted slope/offset (pure,
+ *   caller-owned state)
+ * - Rollback: restore an older record; the newer ones stay listed but are
+ *   marked rolled back and no longer count towards the trend
+ * - Aging: probe efficiency (pH: slope against DEFAULT_PH_SLOPE, the Nernst
+ *   slope at 25 C; EC: against the first calibration of the probe)
+ *   fitted against operating hours, and the hours until the fit crosses the
+ *   probe's minimum efficiency
+ * - The firmware's history: its own NVS namespace, an operating-hours clock,
+ *   the 'k' console command (list, diff, rollback, aging, limit, new probe)
+ *
+ * There is no wall clock on the board, so records carry operating hours: a
+ * counter kept in the same namespace and stored once an hour, which also
+ * skips the time a probe spends unpowered (and mostly unaging). A reset
+ * loses at most the last hour; the counter is also stored with every
+ * calibration, so a record is never stamped before the one it follows.
+ * Records are read from NVS only by the console and when a calibration is
+ * stored, never on the sensor path; the only per-loop cost is the clock's
+ * millis() compare.
+ */
+
+#ifndef CAL_HISTORY_H
+#define CAL_HISTORY_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// HISTORY CONFIGURATION
+//=============================================================================
+
+constexpr int CAL_HISTORY_RECORDS = 8;                      // Per probe; oldest overwritten
+constexpr float CAL_HISTORY_DEFAULT_PH_LIMIT = 85.0f;       // % - replace the pH probe below this
+constexpr float CAL_HISTORY_DEFAULT_EC_LIMIT = 80.0f;       // % of the new cell's slope
+constexpr double CAL_HISTORY_TREND_TAU_H = 8760.0;          // Aging fit weighting (a year of operation)
+constexpr float CAL_HISTORY_SUSPECT_DROP = 5.0f;            // % lost since the last record: suggest rollback
+constexpr float CAL_HISTORY_MAX_EFFICIENCY = 200.0f;        // % - above this a record is a typo, not aging
+constexpr float CAL_HISTORY_MAX_HOURS = 1.0e7f;             // Plausibility bound on stored records
+constexpr float CAL_HISTORY_MIN_SPAN_H = 48.0f;             // Trend needs records this far apart
+constexpr int CAL_HISTORY_MIN_POINTS = 3;
+constexpr uint32_t CAL_HISTORY_CLOCK_SAVE_MS = 3600000;     // Operating-hours counter to NVS
+constexpr uint32_t CAL_HISTORY_INPUT_TIMEOUT_MS = 10000;    // 'k' command line
+
+// NVS namespace for the records ("ph", "ec"), limits and the hours counter
+#define CAL_HISTORY_NVS_NAMESPACE "cal_hist"
+
+constexpr uint8_t CAL_RECORD_ROLLED_BACK = 0x01;            // Newer than a rollback target
+constexpr uint8_t CAL_RECORD_ADC_CURVE = 0x02;              // Fitted on the eFuse curve, not the linear scale
+
+enum class CalProbe : uint8_t {
+    PH,
+    EC
+};
+
+/**
+ * @brief One 2-point calibration
+ */
+struct cal_record_t {
+    uint32_t seq;            // Calibration number of the probe (1, 2, ...), 0 = empty slot
+    float hours;             // Operating hours when stored
+    float point_mv[2];       // Readings in the two solutions (mV)
+    float point_value[2];    // Their pH or mS/cm
+    float slope;             // Fitted line: value = slope * mV + offset
+    float offset;
+    uint8_t flags;           // CAL_RECORD_*
+};
+
+/**
+ * @brief Records of one probe
+ */
+struct cal_history_t {
+    cal_record_t record[CAL_HISTORY_RECORDS];   // Ring
+    uint8_t head;            // Slot of the next record
+    uint8_t count;
+    uint32_t next_seq;
+    uint32_t active_seq;     // Record in use (newest, or the rollback target)
+    float reference_slope;   // 100 % efficiency; 0 = take the next record's slope
+};
+
+/**
+ * @brief Aging fit of one probe
+ */
+struct cal_aging_t {
+    float efficiency;        // Fitted efficiency at the newest counted record (%)
+    float rate_per_kh;       // Efficiency change per 1000 operating hours (%)
+    float rate_sigma_per_kh; // Its standard error
+    float hours_left;        // From the newest record to the limit: -1 = not declining, 0 = below already
+    float hours_left_early;  // Same with the decline one standard error faster
+    uint8_t points;          // Records counted (not rolled back, efficiency 0-CAL_HISTORY_MAX_EFFICIENCY)
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// History (pure)
+void cal_history_reset(cal_history_t* hist, float reference_slope);         // 0 = first record is 100 %
+const cal_record_t* cal_history_push(cal_history_t* hist, const cal_record_t& record);   // Assigns seq
+const cal_record_t* cal_history_at(const cal_history_t* hist, int back);    // 0 = newest, null past the oldest
+const cal_record_t* cal_history_find(const cal_history_t* hist, uint32_t seq);
+bool cal_history_rollback(cal_history_t* hist, uint32_t seq);               // Marks newer records rolled back
+float cal_history_efficiency(const cal_history_t* hist, const cal_record_t& record);   // %, 0 without reference
+bool cal_history_aging(const cal_history_t* hist, float limit, cal_aging_t* out);      // false: too little history
+
+// Firmware
+void cal_history_init(void);                  // Load the hours counter and limits
+void cal_history_tick(void);                  // Every loop() pass: store the hours counter once an hour
+float cal_history_hours(void);                // Operating hours now
+bool cal_history_record(CalProbe probe, const float* point_mv, const float* point_value, float slope, float offset);
+bool cal_history_load(CalProbe probe, cal_history_t* out);   // Console and tests; not the sensor path
+void cal_history_command(void);               // 'k': list, diff, rollback, aging, limit, new
+const char* cal_probe_to_string(CalProbe probe);
+
+#endif // CAL_HISTORY_H
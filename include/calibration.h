@@ -21,6 +21,9 @@
 //=============================================================================
 
 constexpr const char* NVS_CALIBRATION_KEY = "calibration";  // Key for calibration structure
+constexpr const char* NVS_CAL_PH_ADC_KEY = "ph_adc";         // AdcCalSource the pH calibration was fitted on
+constexpr const char* NVS_CAL_EC_ADC_KEY = "ec_adc";         // Same for EC (absent: linear, pre-curve firmware)
+constexpr uint32_t CALIBRATION_KEY_TIMEOUT_MS = 300000;     // Max wait for operator keypress (5 min)
 
 //=============================================================================
 // DEFAULT CALIBRATION VALUES
@@ -31,6 +34,10 @@ constexpr float DEFAULT_PH_OFFSET = 7.0f;       // Default pH offset at neutral
 constexpr float DEFAULT_EC_SLOPE = 0.001f;      // Default EC slope (mS/cm per mV)
 constexpr float DEFAULT_EC_OFFSET = 0.0f;       // Default EC offset
 
+// Plausibility bounds for stored records (2-point setters stay well inside)
+constexpr float CALIBRATION_MAX_SLOPE = 10.0f;      // |slope| per mV
+constexpr float CALIBRATION_MAX_OFFSET = 10000.0f;  // |offset| in pH or mS/cm
+
 //=============================================================================
 // DATA STRUCTURES
 //=============================================================================
@@ -84,6 +91,10 @@ void calibration_interactive_ph(void);      // Interactive pH calibration via se
 void calibration_interactive_ec(void);      // Interactive EC calibration via serial
 void calibration_interactive_volume(void);  // Interactive volume calibration via serial
 
+// ADC scale of the stored pH/EC calibration (see adc_cal.h)
+void calibration_check_adc_scale(void);          // After sensor_initialize(): pause auto dosing on a mismatch
+bool calibration_adc_scale_stale(void);          // pH or EC fitted on another ADC scale than the current one
+
 // Utility functions
 bool calibration_is_valid(void);                 // Check if calibration data is valid
 void calibration_print_status(void);             // Print current calibration values
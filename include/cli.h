@@ -0,0 +1,30 @@
+/**
+ * @file cli.h
+ * @brief Command-line interface dispatcher for Serial/Telnet input
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - Single-character command dispatch shared by Serial and Telnet
+ * - CLI help text printed at startup
+ */
+
+#ifndef CLI_H
+#define CLI_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// CLI CONFIGURATION
+//=============================================================================
+
+constexpr uint32_t CLI_INPUT_TIMEOUT_MS = 10000;   // Parameter prompts, read from the issuing connection
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void cli_print_help(void);               // Print command summary via Debug
+void cli_process_command(char cmd);      // Execute one command character
+
+#endif // CLI_H
@@ -24,6 +24,9 @@
 #define TELNET_PORT 23
 #define MAX_TELNET_CLIENTS 3
 #define COMM_BUFFER_SIZE 256
+#define COMM_CLIENT_SERIAL 0         // Client numbers: Serial, then Telnet slot + 1
+#define COMM_CLIENT_NONE 0xFF
+#define COMM_MAX_CLIENTS (1 + MAX_TELNET_CLIENTS)
 #define OTA_PORT 3232
 #define OTA_HOSTNAME "ESP32-Hydroponic"
 
@@ -72,9 +75,13 @@ private:
   WiFiServer* telnet_server;
   WiFiClient telnet_clients[MAX_TELNET_CLIENTS];
   uint8_t active_clients;
+  uint8_t client_session[MAX_TELNET_CLIENTS];   // Bumped on every accept into the slot
+  bool client_quiet[MAX_TELNET_CLIENTS];        // Broadcast lines skipped (replies still sent)
   
   // Input handling
   InputSource last_input_source;
+  uint8_t input_client;                         // Client the last read() came from
+  uint8_t reply_client;                         // Same, until the next update()
   char input_buffer[COMM_BUFFER_SIZE];
   uint16_t buffer_pos;
   
@@ -85,6 +92,8 @@ private:
   
   // Internal methods
   void transition_to(CommState new_state);
+  void write_serial_line(uint32_t now, const char* message);
+  int read_from(uint8_t client);
   void update_wifi_connection();
   void handle_telnet_clients();
   void cleanup_disconnected_clients();
@@ -107,10 +116,19 @@ public:
   void printf(const char* format, ...);
   void print_status();
   
+  // Per-client output (COMM_CLIENT_SERIAL or Telnet slot + 1)
+  bool print_to(uint8_t client, const char* message);     // false if the client is gone
+  bool is_client_connected(uint8_t client);
+  uint8_t get_client_session(uint8_t client);             // Changes when a Telnet slot is reused
+  void set_client_quiet(uint8_t client, bool quiet);      // Telnet only
+  bool is_client_quiet(uint8_t client);
+  
   // Input methods
   bool available();
   char read();
   InputSource get_input_source();
+  uint8_t get_input_client() { return input_client; }
+  bool read_line(char* out, size_t len, uint32_t timeout_ms);   // From the last input client
   void flush();
   
   // State queries
@@ -148,8 +166,8 @@ extern CommunicationManager* Debug;
 void communication_init(const char* ssid, const char* password);
 
 /**
- * @brief Get communication status string
+ * @brief Format the communication status line into a caller buffer
  */
-String communication_get_status();
+void communication_get_status(char* buffer, size_t len);
 
 #endif // COMMUNICATION_H
\ No newline at end of file
@@ -0,0 +1,57 @@
+/**
+ * @file crash_log.h
+ * @brief Records of abnormal resets (panic, watchdog, brownout) kept in NVS
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A checkpoint of the running system (boot number, uptime, system state)
+ *   in RTC memory that survives a reset but not a power cycle
+ * - At boot, one crash record per abnormal reset: the reset reason plus the
+ *   last checkpoint of the run that ended, appended to a small NVS ring
+ *
+ * The checkpoint costs a few stores per loop() pass; NVS is written once per
+ * boot (boot counter) and once per crash.
+ */
+
+#ifndef CRASH_LOG_H
+#define CRASH_LOG_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// CRASH LOG CONFIGURATION
+//=============================================================================
+
+constexpr int CRASH_LOG_RECORDS = 8;                 // Oldest dropped beyond this
+#define CRASH_LOG_NVS_NAMESPACE "crashlog"
+#define CRASH_LOG_NVS_RECORDS_KEY "records"
+#define CRASH_LOG_NVS_BOOTS_KEY "boots"
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief One abnormal reset
+ */
+struct crash_record_t {
+    uint32_t boot;                       // Boot number of the run that ended (0 = no checkpoint)
+    uint32_t uptime_ms;                  // Its last checkpoint
+    uint8_t reason;                      // esp_reset_reason_t of the reset
+    uint8_t system_state;                // SystemState at the last checkpoint
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void crash_log_init(void);                           // At boot: count the boot, record an abnormal reset
+void crash_log_checkpoint(uint8_t system_state);     // Every loop() pass
+uint32_t crash_log_get_boot(void);                   // Boot number of this run
+int crash_log_count(void);
+bool crash_log_get(int index, crash_record_t* out);  // 0 = oldest
+const char* crash_log_reason_to_string(uint8_t reason);
+void crash_log_print(void);
+
+#endif // CRASH_LOG_H
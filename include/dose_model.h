@@ -0,0 +1,95 @@
+/**
+ * @file dose_model.h
+ * @brief Learned pH/EC dose-response model and joint dose planner
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A 2 x 3 response matrix: pH and EC change per ml/L of pH Up, pH Down and
+ *   the nutrient A+B pair, including the cross-effects (acid raises EC,
+ *   nutrients shift pH)
+ * - Learning the matrix from observed dose responses (ridge regression
+ *   towards the prior, with forgetting so it follows changing chemistry)
+ * - Planning one joint dose that moves pH and EC to their targets together
+ *
+ * Pure math on caller-owned state; the pump module owns the model and runs
+ * the plans. Doses are in ml per litre of solution so the model is
+ * independent of reservoir volume.
+ */
+
+#ifndef DOSE_MODEL_H
+#define DOSE_MODEL_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// DOSE MODEL CONFIGURATION
+//=============================================================================
+
+constexpr int DOSE_GROUP_COUNT = 3;             // pH Up, pH Down, nutrient A+B (1:1)
+constexpr int DOSE_CHANNEL_COUNT = 2;           // pH, EC
+
+constexpr float DOSE_MODEL_PRIOR_WEIGHT = 0.5f; // Prior precision (about two 0.5 ml/L doses)
+constexpr float DOSE_MODEL_FORGET = 0.97f;      // Per-observation forgetting factor
+constexpr float DOSE_MODEL_MIN_STIMULUS = 0.02f; // ml/L total below which a dose teaches nothing
+constexpr float DOSE_MODEL_MAIN_MIN = 0.25f;    // Learned main effects kept within these multiples
+constexpr float DOSE_MODEL_MAIN_MAX = 4.0f;     //   of the prior (sign never flips)
+constexpr float DOSE_PLAN_GAIN = 0.85f;         // Fraction of the modelled correction dosed
+constexpr float DOSE_PLAN_ML_COST = 0.05f;      // Tie-break towards less chemical (per ml/L)
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+enum class DoseGroup {
+    PH_UP = 0,
+    PH_DOWN,
+    NUTRIENT,                   // Nutrient A and B in equal parts (ml/L of A+B)
+};
+
+enum class DoseChannel {
+    PH = 0,
+    EC,
+};
+
+/**
+ * @brief Response model: effect[channel][group] per ml/L
+ */
+struct dose_model_t {
+    float effect[DOSE_CHANNEL_COUNT][DOSE_GROUP_COUNT];   // Current estimate
+    float prior[DOSE_CHANNEL_COUNT][DOSE_GROUP_COUNT];    // Starting point and ridge target
+    float gram[DOSE_GROUP_COUNT][DOSE_GROUP_COUNT];       // Forgetting-weighted sum of u u^T
+    float moment[DOSE_CHANNEL_COUNT][DOSE_GROUP_COUNT];   // Forgetting-weighted sum of u y
+    uint16_t observations;
+};
+
+/**
+ * @brief One joint dose
+ */
+struct dose_plan_t {
+    float ml_per_l[DOSE_GROUP_COUNT];   // Dose per group (nutrient = A+B total)
+    float ph_residual;                  // Modelled pH error left after the dose
+    float ec_residual;                  // Modelled EC error left (0 when EC is not controlled)
+};
+
+/**
+ * @brief A dose waiting for its mixed response
+ */
+struct dose_observation_t {
+    float ml_per_l[DOSE_GROUP_COUNT];
+    float ph;                           // Readings when the dose started
+    float ec;
+    uint32_t time;
+    bool pending;
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void dose_model_reset(dose_model_t* model, const float prior[DOSE_CHANNEL_COUNT][DOSE_GROUP_COUNT]);
+void dose_model_learn(dose_model_t* model, const float ml_per_l[DOSE_GROUP_COUNT], float d_ph, float d_ec);
+bool dose_model_plan(const dose_model_t* model, float ph_error, float ec_error, bool ec_active,
+                     float ph_band, float ec_band, dose_plan_t* plan);   // false = nothing to dose
+
+#endif // DOSE_MODEL_H
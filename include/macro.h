@@ -0,0 +1,114 @@
+/**
+ * @file macro.h
+ * @brief Command batches and named macros applied as one unit
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - The batch compiler (pure; also driven by the fuzzer): step text to a
+ *   list of checked steps, or the first error with its step number
+ * - Execution: every dose is checked against the pump safety limits
+ *   before anything is applied, then all steps run in one call from the
+ *   main loop, so no control cycle (pump_ph_dose and friends) sees a
+ *   half-applied batch. If a step is refused anyway, settings changed by
+ *   the batch are put back and doses it started are stopped.
+ * - Named macros stored in NVS, run from the console ('b') or over
+ *   Modbus (holding register MODBUS_HR_MACRO)
+ *
+ * Steps are separated by ';' or new lines, case-insensitive:
+ *
+ *   auto_ph on|off        auto_ec on|off
+ *   ph_target 5.0-8.0     ec_target 0.2-4.0
+ *   dose <pump> <ml>      pump: ph_up, ph_down, nut_a, nut_b
+ *   stop <pump>|all
+ *
+ *   auto_ph off; ph_target 6.2; dose ph_down 8; auto_ph on
+ */
+
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <Arduino.h>
+#include "pump.h"
+
+//=============================================================================
+// MACRO CONFIGURATION
+//=============================================================================
+
+constexpr int MACRO_MAX_STEPS = 12;
+constexpr size_t MACRO_TEXT_MAX = 192;               // Stored step text, terminator included
+constexpr size_t MACRO_NAME_MAX = 16;                // Terminator included
+constexpr int MACRO_SLOTS = 8;
+constexpr uint8_t MACRO_ALL_PUMPS = 0xFF;            // stop all
+constexpr uint32_t MACRO_INPUT_TIMEOUT_MS = 10000;
+
+#define MACRO_NVS_NAMESPACE "macros"                 // One key per slot: "m0".."m7"
+
+/**
+ * @brief Step operations
+ */
+enum class MacroOp : uint8_t {
+    AUTO_PH,                             // value 0/1
+    AUTO_EC,
+    PH_TARGET,
+    EC_TARGET,
+    DOSE,                                // pump, value = ml
+    STOP                                 // pump or MACRO_ALL_PUMPS
+};
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+struct macro_step_t {
+    MacroOp op;
+    uint8_t pump;                        // PumpId (DOSE, STOP)
+    float value;
+};
+
+struct macro_batch_t {
+    uint8_t count;
+    macro_step_t steps[MACRO_MAX_STEPS];
+};
+
+/**
+ * @brief Why a batch was not compiled or not applied
+ */
+struct macro_error_t {
+    uint8_t step;                        // 1-based, 0 = the batch as a whole
+    char message[48];
+};
+
+/**
+ * @brief One stored macro (NVS record)
+ */
+struct macro_record_t {
+    char name[MACRO_NAME_MAX];           // Empty = free slot
+    char text[MACRO_TEXT_MAX];
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Compiler (pure)
+bool macro_compile(const char* text, size_t len, macro_batch_t* batch, macro_error_t* error);
+bool macro_valid_name(const char* name, size_t len);         // 1-15 of [a-z0-9_]
+
+// Execution (main loop only)
+bool macro_execute(const macro_batch_t& batch, macro_error_t* error);
+bool macro_run_text(const char* text, const char* label);    // Compile, execute, report on Debug
+
+// Stored macros
+void macro_init(void);                                       // Load the NVS slots
+bool macro_save(const char* name, const char* text);         // Compile-checked; replaces a same-named macro
+bool macro_delete(const char* name);
+int macro_find(const char* name);                            // Slot or -1
+bool macro_get(int slot, macro_record_t* out);               // false if the slot is free
+bool macro_run_slot(int slot);
+
+// Console
+void macro_command(void);                                    // 'b': batch, save, run, del or list
+void macro_print_status(void);
+
+#endif // MACRO_H
@@ -0,0 +1,157 @@
+/**
+ * @file modbus.h
+ * @brief Modbus TCP slave exposing readings, setpoints and pump commands
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A documented register map (below) for SCADA systems
+ * - A request handler for whole Modbus TCP ADUs, independent of the socket
+ *   (the same handler is driven by host tests over a loopback socket)
+ * - A server on MODBUS_PORT polled from the main loop
+ *
+ * Reads are answered from a register snapshot taken in the main loop from
+ * state the firmware already holds (latest published reading, pump and
+ * system states, counters) - never from the ADC or sensors - so a request
+ * costs the same however busy the hardware is. Writes go through the same
+ * pump/state APIs as the CLI and refresh the snapshot, so a following read
+ * sees them.
+ *
+ * Register map (0-based protocol addresses; SCADA "30001"/"40001" style
+ * numbers are these plus one):
+ *
+ *   Input registers (FC 04, read-only)
+ *     0  pH x1000            int16   TELEMETRY_PH_SCALE
+ *     1  EC x1000 (mS/cm)    int16   TELEMETRY_EC_SCALE
+ *     2  volume x10 (L)      int16   TELEMETRY_VOLUME_SCALE
+ *     3  temperature x100    int16   TELEMETRY_TEMP_SCALE
+ *     4  reading age (s)             0xFFFF = no reading yet
+ *     5  readings published          wraps at 65536
+ *     6  system state                SystemState order
+ *     7-10   pump state per pump     PumpState order (pH Up, pH Down, A, B)
+ *     11-18  total dosed x10 ml      uint32 per pump, high word first
+ *     19 auto-dosing inhibit bits    PUMP_INHIBIT_*
+ *     20-21  uptime (s)              uint32, high word first
+ *
+ *   Holding registers (FC 03 read, FC 06/16 write)
+ *     0  pH target x1000     5000..8000
+ *     1  EC target x1000     200..4000
+ *     2  auto pH             0/1
+ *     3  auto EC             0/1
+ *     4-7  manual dose x10 ml per pump  write 1..250 to start a dose; reads 0
+ *     8  run macro           write 1..8 to run that stored macro slot as one
+ *                            batch (03 if the slot is empty); reads 0
+ *
+ *   Coils (FC 01 read, FC 05/15 write)
+ *     0-3  pump running      1 = start a manual run (console flow rate), 0 = stop
+ *     4    e-stop            1 = emergency stop (latches ERROR); reads 1 while
+ *                            in ERROR. Writing 0 while latched is refused
+ *                            (exception 03): release with 'R' on the console.
+ *
+ * Exceptions: 01 unsupported function, 02 address outside the map, 03 value
+ * out of range (nothing is written), 04 the firmware refused the command
+ * (pump busy, dose blocked by safety limits or macro refused).
+ */
+
+#ifndef MODBUS_H
+#define MODBUS_H
+
+#include <Arduino.h>
+#include "sensors.h"
+
+//=============================================================================
+// MODBUS CONFIGURATION
+//=============================================================================
+
+constexpr uint16_t MODBUS_PORT = 502;
+constexpr int MODBUS_MAX_CLIENTS = 2;
+constexpr int MODBUS_REQUESTS_PER_UPDATE = 4;        // Per client per loop pass
+constexpr size_t MODBUS_ADU_MAX = 260;               // MBAP (7) + PDU (253)
+constexpr size_t MODBUS_MBAP_LEN = 7;
+
+// Register map sizes
+constexpr uint16_t MODBUS_INPUT_COUNT = 22;
+constexpr uint16_t MODBUS_HOLDING_COUNT = 9;
+constexpr uint16_t MODBUS_COIL_COUNT = 5;
+
+// Input register addresses
+constexpr uint16_t MODBUS_IR_PH = 0;
+constexpr uint16_t MODBUS_IR_EC = 1;
+constexpr uint16_t MODBUS_IR_VOLUME = 2;
+constexpr uint16_t MODBUS_IR_TEMPERATURE = 3;
+constexpr uint16_t MODBUS_IR_READING_AGE = 4;
+constexpr uint16_t MODBUS_IR_READING_COUNT = 5;
+constexpr uint16_t MODBUS_IR_SYSTEM_STATE = 6;
+constexpr uint16_t MODBUS_IR_PUMP_STATE = 7;         // + pump index
+constexpr uint16_t MODBUS_IR_TOTAL_DOSED = 11;       // + 2 * pump index
+constexpr uint16_t MODBUS_IR_INHIBIT = 19;
+constexpr uint16_t MODBUS_IR_UPTIME = 20;
+
+// Holding register addresses
+constexpr uint16_t MODBUS_HR_PH_TARGET = 0;
+constexpr uint16_t MODBUS_HR_EC_TARGET = 1;
+constexpr uint16_t MODBUS_HR_AUTO_PH = 2;
+constexpr uint16_t MODBUS_HR_AUTO_EC = 3;
+constexpr uint16_t MODBUS_HR_DOSE = 4;               // + pump index
+constexpr uint16_t MODBUS_HR_MACRO = 8;              // Write 1..MACRO_SLOTS: run that stored macro
+
+// Coil addresses
+constexpr uint16_t MODBUS_COIL_PUMP = 0;             // + pump index
+constexpr uint16_t MODBUS_COIL_ESTOP = 4;
+
+// Function and exception codes
+constexpr uint8_t MODBUS_FC_READ_COILS = 0x01;
+constexpr uint8_t MODBUS_FC_READ_HOLDING = 0x03;
+constexpr uint8_t MODBUS_FC_READ_INPUT = 0x04;
+constexpr uint8_t MODBUS_FC_WRITE_COIL = 0x05;
+constexpr uint8_t MODBUS_FC_WRITE_REGISTER = 0x06;
+constexpr uint8_t MODBUS_FC_WRITE_COILS = 0x0F;
+constexpr uint8_t MODBUS_FC_WRITE_REGISTERS = 0x10;
+
+constexpr uint8_t MODBUS_EX_ILLEGAL_FUNCTION = 0x01;
+constexpr uint8_t MODBUS_EX_ILLEGAL_ADDRESS = 0x02;
+constexpr uint8_t MODBUS_EX_ILLEGAL_VALUE = 0x03;
+constexpr uint8_t MODBUS_EX_DEVICE_FAILURE = 0x04;
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Register image requests are served from
+ */
+struct modbus_snapshot_t {
+    uint16_t input[MODBUS_INPUT_COUNT];
+    uint16_t holding[MODBUS_HOLDING_COUNT];
+    uint8_t coils;                       // Bit i = coil i
+    uint32_t taken_at;                   // millis()
+};
+
+/**
+ * @brief Server counters since boot
+ */
+struct modbus_stats_t {
+    uint32_t requests;
+    uint32_t exceptions;
+    uint32_t writes;                     // Write requests that changed something
+    uint32_t malformed;                  // Bad MBAP headers (connection dropped)
+    uint32_t max_handle_us;              // Slowest request handled
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void modbus_init(void);                                          // Track published readings
+void modbus_update(void);                                        // Serve clients (main loop)
+void modbus_refresh_snapshot(void);                              // Rebuild the register image
+const modbus_snapshot_t& modbus_get_snapshot(void);
+
+// Handle one complete ADU; returns the response length, 0 to drop the connection
+size_t modbus_handle_adu(const uint8_t* request, size_t len, uint8_t* response, size_t response_len);
+int modbus_adu_length(const uint8_t* data, size_t len);          // ADU bytes at data, 0 need more, -1 bad header
+
+modbus_stats_t modbus_get_stats(void);
+uint8_t modbus_get_client_count(void);
+
+#endif // MODBUS_H
@@ -0,0 +1,59 @@
+/**
+ * @file multicast.h
+ * @brief Optional UDP multicast publisher of telemetry frames
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - One datagram per published reading, pump transition and alarm, sent to
+ *   a multicast group: the telemetry frame itself (layout in telemetry.h),
+ *   so it carries the sequence number and CRC
+ * - Enabling and choosing the group at run time (console 'B')
+ *
+ * The cost per event is one send whatever the number of listeners (logger,
+ * dashboard, SCADA bridge), unlike telnet or the TCP stream where every
+ * client gets its own copy. UDP may drop datagrams; receivers see the gap
+ * in seq and fetch the missing frames from the TCP stream port with a
+ * backfill request (see telemetry.h and host/tools/multicast_receiver.h).
+ *
+ * Off by default; datagrams only go out while WiFi is connected.
+ */
+
+#ifndef MULTICAST_H
+#define MULTICAST_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// MULTICAST CONFIGURATION
+//=============================================================================
+
+constexpr uint8_t MULTICAST_DEFAULT_GROUP[4] = {239, 72, 79, 1};   // Organisation-local scope
+constexpr uint16_t MULTICAST_DEFAULT_PORT = 2425;
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Publisher counters since boot
+ */
+struct multicast_stats_t {
+    uint32_t sent;
+    uint32_t failed;                     // Send refused by the stack (no buffer, no route)
+    uint32_t skipped;                    // Events while enabled but WiFi was down
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void multicast_init(void);                                       // Attach to published telemetry
+void multicast_enable(bool enabled);
+bool multicast_is_enabled(void);
+void multicast_set_group(const uint8_t group[4], uint16_t port);
+void multicast_get_group(uint8_t group[4], uint16_t* port);
+multicast_stats_t multicast_get_stats(void);
+void multicast_print_status(void);
+
+#endif // MULTICAST_H
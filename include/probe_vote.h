@@ -0,0 +1,109 @@
+/**
+ * @file probe_vote.h
+ * @brief Redundant pH/EC probes: median or weighted voting with fault masking
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A voter over up to PROBE_MAX readings of one quantity (pure, caller-owned
+ *   state): median or weighted vote, per-probe disagreement tracking and
+ *   exclusion of a probe that stays beyond tolerance of the others
+ * - The firmware's pH and EC voters: installed probe counts, mode,
+ *   tolerances, per-probe trims and exclusions kept in NVS, the 'n' console
+ *   command and status output
+ *
+ * Only a majority can outvote a probe: with three voters the one that
+ * disagrees is struck and, after exclude_after readings in a row, excluded.
+ * Two voters that disagree are a split: there is no value, the sensor
+ * reading is invalid and no dose follows from it. An excluded probe stays
+ * out (across reboots) until readmitted from the console. The voted value
+ * replaces the single-probe reading ahead of the EMA filter, so filtering,
+ * alarms and dosing see it unchanged.
+ */
+
+#ifndef PROBE_VOTE_H
+#define PROBE_VOTE_H
+
+#include <Arduino.h>
+#include "board.h"
+
+//=============================================================================
+// VOTING CONFIGURATION
+//=============================================================================
+
+constexpr int PROBE_MAX = 3;                            // Voters per quantity
+constexpr float PROBE_DEFAULT_PH_TOLERANCE = 0.3f;      // pH
+constexpr float PROBE_DEFAULT_EC_TOLERANCE = 0.2f;      // mS/cm
+constexpr uint8_t PROBE_DEFAULT_EXCLUDE_AFTER = 3;      // Consecutive disagreeing readings
+constexpr float PROBE_DEVIATION_ALPHA = 0.1f;           // EMA of each probe's distance from the vote
+constexpr uint32_t PROBE_INPUT_TIMEOUT_MS = 10000;      // 'n' command line
+
+static_assert(Board::ph_probe_count <= PROBE_MAX && Board::ec_probe_count <= PROBE_MAX,
+              "board has more probe inputs than the voter takes");
+
+// NVS namespace for probe counts, mode, tolerances, trims and exclusions
+#define PROBE_NVS_NAMESPACE "probes"
+
+enum class ProbeVoteMode : uint8_t {
+    MEDIAN,                  // Middle reading of the voters (mean of two)
+    WEIGHTED                 // Voters within tolerance of the median, weighted by their track record
+};
+
+enum class ProbeQuantity : uint8_t {
+    PH,
+    EC
+};
+
+/**
+ * @brief Voter settings for one quantity
+ */
+struct probe_vote_config_t {
+    uint8_t count;           // Installed probes (1 = single probe, no voting)
+    ProbeVoteMode mode;
+    float tolerance;         // Largest accepted distance from the vote
+    uint8_t exclude_after;   // Consecutive struck readings before exclusion
+};
+
+/**
+ * @brief Track record of one probe
+ */
+struct probe_track_t {
+    float last;              // Last reading (trim applied)
+    float deviation;         // Last distance from the median
+    float deviation_avg;     // EMA of the distance (weights in WEIGHTED mode)
+    uint32_t disagreements;  // Readings beyond tolerance (struck or split)
+    uint8_t strikes;         // Consecutive struck readings
+    bool excluded;
+};
+
+/**
+ * @brief Voter state for one quantity
+ */
+struct probe_vote_t {
+    probe_track_t probe[PROBE_MAX];
+    float value;             // Last voted value
+    uint8_t voters;          // Probes that formed the last vote
+    int8_t excluded_now;     // Probe excluded by the last update, -1 if none
+    uint32_t votes;          // Updates that produced a value
+    uint32_t splits;         // Updates without a majority (or without voters)
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Voter (pure)
+void probe_vote_reset(probe_vote_t* vote);
+bool probe_vote_update(probe_vote_t* vote, const probe_vote_config_t& config, const float* readings, float* out);
+void probe_vote_readmit(probe_vote_t* vote, int probe);
+const char* probe_vote_mode_to_string(ProbeVoteMode mode);
+
+// Firmware
+void probe_vote_init(void);                                    // Load settings and exclusions from NVS
+uint8_t probe_vote_count(ProbeQuantity quantity);              // Installed probes (1 = no voting)
+const probe_vote_t* probe_vote_state(ProbeQuantity quantity);  // Voter state (track records, counters)
+bool probe_vote_apply(ProbeQuantity quantity, const float* readings, float* out);   // Trims, votes, logs exclusions
+void probe_vote_command(void);                                 // 'n': counts, mode, tolerances, readmit, match
+void probe_vote_print_status(void);
+
+#endif // PROBE_VOTE_H
@@ -7,29 +7,40 @@
  * This header provides interface for:
  * - PID-controlled pH adjustment using peristaltic pumps
  * - Volume-proportional dosing based on reservoir size
+ * - Optional predictive pH dosing from the fitted pH trend
+ * - Shadow pH controller: a candidate policy evaluated on live readings, never dosing
+ * - Micro-dosing: sub-minimum volumes as calibrated full-speed timer pulses
+ * - Line priming sized from a per-pump tubing dead volume and drain-back model
+ * - Dose fractionation: automatic doses split into pieces with mixing gaps
+ * - Proportional EC control with nutrient A/B in equal parts
+ * - Coupled pH/EC dosing planned on a learned cross-effect model
  * - Safety mechanisms (dose limits, timing restrictions)
- * - Foundation for future EC control expansion
  */
 
 #ifndef PUMP_H
 #define PUMP_H
 
 #include <Arduino.h>
+#include "state_machine.h"
+#include "trend.h"
+#include "dose_model.h"
+#include "board.h"
 
 //=============================================================================
-// HARDWARE CONFIGURATION
+// HARDWARE CONFIGURATION (from the board descriptor, board.h)
 //=============================================================================
 
 // GPIO pin assignments for pump control
-constexpr int PUMP_PH_UP_PIN = 11;       // pH Up pump (PWM Channel 0)
-constexpr int PUMP_PH_DOWN_PIN = 12;     // pH Down pump (PWM Channel 1)
+constexpr int PUMP_PH_UP_PIN = Board::pump_pins[0];       // pH Up pump (PWM Channel 0)
+constexpr int PUMP_PH_DOWN_PIN = Board::pump_pins[1];     // pH Down pump (PWM Channel 1)
 //CLAUDE: implement phase 2 but without automation, just using serial run command to run 
-constexpr int PUMP_NUTRIENT_A_PIN = 13;  // Nutrient A pump (PWM Channel 2)
-constexpr int PUMP_NUTRIENT_B_PIN = 14;  // Nutrient B pump (PWM Channel 3)
+constexpr int PUMP_NUTRIENT_A_PIN = Board::pump_pins[2];  // Nutrient A pump (PWM Channel 2)
+constexpr int PUMP_NUTRIENT_B_PIN = Board::pump_pins[3];  // Nutrient B pump (PWM Channel 3)
 
 // PWM configuration
-constexpr int PUMP_PWM_FREQ = 1000;      // PWM frequency (Hz)
-constexpr int PUMP_PWM_RESOLUTION = 8;   // PWM resolution (bits)
+constexpr int PUMP_PWM_FREQ = Board::pwm_freq_hz;          // PWM frequency (Hz)
+constexpr int PUMP_PWM_RESOLUTION = Board::pwm_resolution_bits;   // PWM resolution (bits)
+constexpr uint8_t PUMP_PWM_MAX_DUTY = (1 << PUMP_PWM_RESOLUTION) - 1;
 
 // Pump specifications
 constexpr float PUMP_MIN_FLOW_RATE = 10.0f;   // Minimum practical flow rate (ml/min)
@@ -45,6 +56,62 @@ constexpr uint32_t PUMP_MIN_DOSE_INTERVAL = 300000;   // 5 minutes between doses
 constexpr float PUMP_MIN_DOSE_VOLUME = 5.0f;       // Minimum dose volume (ml)
 constexpr float PUMP_MAX_DOSE_VOLUME = 25.0f;      // Maximum single dose volume (ml)
 constexpr uint32_t PUMP_TIMEOUT_MS = 600000;          // 10 minute maximum run time (safety)
+constexpr uint32_t PUMP_COOLDOWN_MS = 300000;         // COOLING_DOWN lockout after a dose
+constexpr uint32_t PUMP_ERROR_RECOVERY_MS = 30000;    // ERROR -> IDLE auto-recovery
+
+//=============================================================================
+// LINE PRIMING CONFIGURATION
+//=============================================================================
+
+// Each line (bottle to outlet) holds a dead volume that must be full before a
+// dose reaches the reservoir. An idle line drains back towards the bottle;
+// PRIMING refills only the estimated shortfall and is skipped for a full line.
+constexpr float PUMP_LINE_DEFAULT_DEAD_ML = 0.8f;      // Uncalibrated line volume (ml)
+constexpr float PUMP_LINE_MAX_DEAD_ML = 5.0f;
+constexpr float PUMP_LINE_DRAIN_TAU_H = 24.0f;         // Idle drain-back time constant (h)
+constexpr float PUMP_LINE_MIN_PRIME_ML = 0.05f;        // Shortfall below this is not primed
+constexpr float PUMP_PRIME_FLOW_RATE = 20.0f;          // Priming flow (ml/min, ~25% duty)
+constexpr uint32_t PUMP_PRIME_TIMEOUT_MARGIN_MS = 2500; // PRIMING this far over plan -> ERROR
+constexpr uint32_t PUMP_LINE_CAL_TIMEOUT_MS = 30000;   // Longest run while measuring a line
+
+// NVS storage for line dead volumes (same namespace as the pulse calibration)
+constexpr const char* PUMP_NVS_LINE_KEY = "line";
+
+//=============================================================================
+// MICRO-DOSING CONFIGURATION
+//=============================================================================
+
+// Doses below PUMP_MIN_DOSE_VOLUME are delivered as one full-duty pulse whose
+// length is timed by an esp_timer one-shot: pulse = dead time + ml / flow.
+constexpr float PUMP_MICRO_MIN_VOLUME = 0.2f;         // Smallest micro dose worth delivering (ml)
+constexpr uint8_t PUMP_MICRO_DUTY = PUMP_PWM_MAX_DUTY;  // Pulses run at full duty (no ramp to calibrate)
+constexpr uint32_t PUMP_MICRO_DEFAULT_DEAD_MS = 100;  // Uncalibrated run time before liquid flows
+constexpr uint32_t PUMP_MICRO_MARGIN_MS = 50;         // Minimum pulse = dead time + margin
+constexpr uint32_t PUMP_MICRO_WATCHDOG_MS = 50;       // Pulse end overdue -> stop from pump_update
+
+// Two-point pulse calibration (pulses per point, pulse lengths)
+constexpr int PUMP_PULSE_CAL_COUNT = 20;
+constexpr uint32_t PUMP_PULSE_CAL_SHORT_MS = 300;
+constexpr uint32_t PUMP_PULSE_CAL_LONG_MS = 1500;
+constexpr uint32_t PUMP_PULSE_CAL_GAP_MS = 500;       // Pump fully stopped between pulses
+constexpr uint32_t PUMP_CAL_INPUT_TIMEOUT_MS = 10000; // Pump number prompt ('c', 'd')
+constexpr uint32_t PUMP_PULSE_CAL_INPUT_TIMEOUT_MS = 30000;  // Collected volume prompt
+
+// NVS storage for pulse calibration
+constexpr const char* PUMP_NVS_NAMESPACE = "pumpcal";
+constexpr const char* PUMP_NVS_PULSE_KEY = "pulse";
+
+//=============================================================================
+// DOSE FRACTIONATION CONFIGURATION
+//=============================================================================
+
+// An automatic dose may be split into pieces delivered with mixing gaps. The
+// series counts as one dose for the rate limiter; the lockout follows the last piece.
+// A pH series also holds the other pH pump until two gaps after its last piece.
+constexpr uint8_t PUMP_FRACTION_MAX_COUNT = 5;              // Pieces per dose
+constexpr uint32_t PUMP_FRACTION_DEFAULT_GAP_MS = 60000;    // End of one piece to start of the next
+constexpr uint32_t PUMP_FRACTION_MIN_GAP_MS = 10000;
+constexpr uint32_t PUMP_FRACTION_MAX_GAP_MS = 300000;
 
 //=============================================================================
 // PID CONFIGURATION
@@ -60,6 +127,31 @@ constexpr float DEFAULT_PH_TARGET = 6.0f;  // Default target pH
 constexpr float PID_INTEGRAL_MAX = 50.0f;  // Maximum integral accumulation
 constexpr float PID_INTEGRAL_MIN = -50.0f; // Minimum integral accumulation
 
+//=============================================================================
+// PREDICTIVE PH CONFIGURATION
+//=============================================================================
+
+constexpr float PH_BAND = 0.2f;                       // Acceptable +/- band around the pH target
+constexpr float PH_PREDICT_TREND_TAU_MIN = 10.0f;     // pH trend fit time constant (min)
+constexpr uint32_t PH_PREDICT_SETTLE_MS = 480000;     // Readings ignored while a dose mixes (~3 mixing tau)
+constexpr uint32_t PH_PREDICT_MIX_MS = 240000;        // Dose start until fully mixed (prime + dose + mix)
+constexpr float PH_PREDICT_MIN_WEIGHT = 12.0f;        // Readings in the fit before its slope is trusted
+constexpr float PH_PREDICT_CONFIDENCE = 2.0f;         // Prediction bound in standard deviations
+
+//=============================================================================
+// EC AND COUPLED CONTROL CONFIGURATION
+//=============================================================================
+
+constexpr float DEFAULT_EC_TARGET = 1.5f;             // Default target EC (mS/cm)
+constexpr float EC_BAND = 0.1f;                       // Acceptable +/- band around the EC target
+constexpr float PUMP_EC_PER_ML_L = 0.25f;             // Assumed EC rise per ml/L of nutrient A+B
+constexpr float PUMP_EC_GAIN = 0.8f;                  // Fraction of the EC error corrected per dose
+
+// Coupled mode doses pH and nutrients together from a learned response model
+// (dose_model.h) and waits for each joint dose to mix before learning from it.
+constexpr uint32_t PUMP_COUPLED_SETTLE_MS = 480000;   // Dose start until the response is read (~3.5 mixing tau)
+constexpr float PUMP_COUPLED_PRIOR_PH = 1.25f;        // pH per ml/L of pH Up/Down (DEFAULT_PH_KP in 10 L)
+
 //=============================================================================
 // DATA STRUC// DATA STRUC researcTURES
 
@@ -76,6 +168,8 @@ enum class PumpId {
     COUNT = 4          // Total pump count for Phase 2
 };
 
+static_assert(Board::pump_count == static_cast<int>(PumpId::COUNT), "board pump count must match PumpId");
+
 /**
  * @brief PID controller state
  * Maintains PID calculation state and safety tracking
@@ -97,6 +191,37 @@ struct pid_controller_t {
                         total_ml_dosed(0.0f) {}
 };
 
+/**
+ * @brief Per-pump short pulse calibration
+ * A pulse of t ms delivers (t - dead_ms) * flow_ml_per_min / 60000 ml.
+ */
+struct pump_pulse_cal_t {
+    float flow_ml_per_min;          // Flow at PUMP_MICRO_DUTY once liquid moves
+    uint32_t dead_ms;               // Motor spin-up and tubing slack (no delivery)
+    uint32_t min_pulse_ms;          // Shortest pulse that delivers repeatably
+    bool calibrated;                // false = defaults from the pump specification
+
+    pump_pulse_cal_t() : flow_ml_per_min(PUMP_MAX_FLOW_RATE), dead_ms(PUMP_MICRO_DEFAULT_DEAD_MS),
+                         min_pulse_ms(PUMP_MICRO_DEFAULT_DEAD_MS + PUMP_MICRO_MARGIN_MS),
+                         calibrated(false) {}
+};
+
+/**
+ * @brief Per-pump tubing state
+ * The line held fill_ml when the pump last ran (wet_at); it drains back
+ * exponentially from there while idle. After a reboot it counts as empty.
+ */
+struct pump_line_t {
+    float dead_ml;                  // Line volume from bottle to outlet
+    bool calibrated;                // false = PUMP_LINE_DEFAULT_DEAD_ML
+    float fill_ml;                  // Liquid in the line as of wet_at
+    uint32_t wet_at;                // Last time the pump moved liquid
+    float primed_ml;                // Lifetime ml pumped into the line (not the reservoir)
+
+    pump_line_t() : dead_ml(PUMP_LINE_DEFAULT_DEAD_ML), calibrated(false), fill_ml(0.0f),
+                    wet_at(0), primed_ml(0.0f) {}
+};
+
 /**
  * @brief Pump hardware and control state
  * Contains all pump-specific information and state
@@ -109,10 +234,28 @@ struct pump_t {
     uint32_t start_time;           // Pump start timestamp
     uint32_t run_duration_ms;      // Planned run duration
     uint8_t target_pwm_duty;        // Target PWM duty for dosing phase
+    float manual_flow_rate;         // Flow of a manual run in progress (ml/min, 0 = none)
+    uint32_t manual_accounted_at;   // Manual run delivered ml counted up to this time
+    pump_pulse_cal_t pulse_cal;     // Micro-dosing pulse calibration
+    bool micro_pulse;               // DOSING phase is a timer-ended micro pulse
+    volatile bool pulse_done;       // Set by the pulse timer callback
+    uint8_t series_count;           // Pieces in the current fractionated dose
+    uint8_t series_remaining;       // Pieces still to start (0 = no series)
+    float series_piece_ml;          // Volume of each piece
+    float series_target;            // Reading at which remaining pieces are dropped
+    float series_reading;           // Newest reading seen while the series runs
+    uint32_t series_gap_start;      // End of the last piece, or when the series was dropped
+    pump_line_t line;               // Tubing dead volume and fill
+    uint32_t prime_ms;              // PRIMING length of the current dose (0 = line full)
+    float prime_start_fill;         // Line fill when PRIMING started
     
     // Default constructor
     pump_t() : gpio_pin(0), pwm_channel(0), controller(), running(false), 
-               start_time(0), run_duration_ms(0), target_pwm_duty(0) {}
+               start_time(0), run_duration_ms(0), target_pwm_duty(0),
+               manual_flow_rate(0.0f), manual_accounted_at(0), pulse_cal(),
+               micro_pulse(false), pulse_done(false), series_count(0), series_remaining(0),
+               series_piece_ml(0.0f), series_target(0.0f), series_reading(0.0f),
+               series_gap_start(0), line(), prime_ms(0), prime_start_fill(0.0f) {}
 };
 
 /**
@@ -122,8 +265,82 @@ typedef struct {
     bool auto_ph_control;           // Automatic pH control enabled
     bool auto_ec_control;           // Automatic EC control enabled (Phase 2)
     bool initialized;               // System initialization status
+    uint8_t auto_inhibit;           // PUMP_INHIBIT_* reasons pausing automatic dosing
+    bool ph_predictive;             // Dose on the predicted (mixed) pH instead of the PID
+    bool micro_dosing;              // Deliver sub-minimum doses as timed pulses
+    uint8_t fraction_count;         // Pieces per automatic dose (1 = not split)
+    uint32_t fraction_gap_ms;       // Mixing gap between pieces
+    float ec_target;                // Target EC (mS/cm)
+    bool coupled_control;           // Joint pH/EC doses when auto pH and auto EC are both on
 } pump_system_t;
 
+/**
+ * @brief Predictive pH dosing state
+ * pH trend since the last pH dose has mixed, fitted per reading (time in minutes)
+ */
+typedef struct {
+    trend_fit_t trend;              // pH vs time since the last settled reading
+    uint32_t last_reading;          // Timestamp of the newest point in the fit
+    uint32_t dose_time;             // Start of the last pH dose
+    bool settling;                  // Dose still mixing - readings are not trend
+    float predicted_ph;             // Last prediction at PH_PREDICT_MIX_MS ahead
+    float predicted_sigma;          // Its standard deviation
+    float slope_per_h;              // Last fitted pH slope
+} ph_predictor_t;
+
+/**
+ * @brief Candidate pH policy run by the shadow controller
+ */
+enum class PhPolicy : uint8_t {
+    OFF = 0,                        // No shadow controller
+    PID,                            // Reactive PID with its own gains and integral
+    PREDICTIVE,                     // Trend prediction with its own fit and Kp
+};
+
+/**
+ * @brief One automatic pH dosing decision
+ */
+typedef struct {
+    PumpId pump;                    // pH Up or pH Down
+    float ml;                       // Whole dose (before fractionation), 0 = no dose
+} ph_decision_t;
+
+/**
+ * @brief Live vs shadow pH decisions since the shadow controller was started
+ * Counted on every reading the live pH loop decided on (auto pH on, not
+ * paused, inputs valid). Index [0] is pH Up, [1] is pH Down.
+ */
+typedef struct {
+    uint32_t decisions;             // Readings both policies decided on
+    uint32_t agreements;            // Same pump, or no dose, from both
+    uint32_t opposite;              // Live and shadow picked opposite pumps
+    uint32_t live_only;             // Live dosed, shadow would not have
+    uint32_t shadow_only;           // Shadow would have dosed, live did not
+    uint32_t live_doses[2];
+    uint32_t shadow_doses[2];
+    float live_ml[2];
+    float shadow_ml[2];
+    uint32_t same_pump_doses;       // Both dosed the same pump
+    float same_pump_ml_diff;        // Sum of shadow - live ml over those
+    uint32_t max_eval_us;           // Longest shadow evaluation
+} ph_shadow_stats_t;
+
+/**
+ * @brief Shadow pH controller state
+ * Sees the same filtered readings as the live loop and the same pump lockouts;
+ * its decisions are logged and counted, never actuated.
+ */
+typedef struct {
+    PhPolicy policy;
+    pid_controller_t pid[2];        // Own gains and integral per pH pump
+    ph_predictor_t predictor;       // Own trend fit (restarts on live pH doses)
+    ph_shadow_stats_t stats;
+} ph_shadow_t;
+
+// Reasons automatic dosing is paused (pump_system_t::auto_inhibit bits)
+constexpr uint8_t PUMP_INHIBIT_LEAK = 0x01;      // Volume balance suspects a leak
+constexpr uint8_t PUMP_INHIBIT_ADC_SCALE = 0x02; // pH/EC calibrated on another ADC scale - recalibrate
+
 //=============================================================================
 // GLOBAL VARIABLES (EXTERN DECLARATIONS)
 //=============================================================================
@@ -139,7 +356,8 @@ extern pump_system_t pump_system;
 bool pump_init(void);                           // Initialize pump system
 void pump_update(void);                         // Non-blocking pump update
 void pump_stop_all(void);                       // Emergency stop all pumps
-void pump_safety_check(void);                   // Check and enforce safety timeouts
+uint32_t pump_state_timeout_ms(PumpId pump, PumpState state); // Timeout armed on entering a state (0 = none)
+void pump_state_expired(PumpId pump, PumpState state);      // A pump state's timeout ran out
 
 // Manual control functions (Phase 2)
 bool pump_start_manual(PumpId pump, float ml_per_min); // Start pump at flow rate
@@ -150,11 +368,42 @@ bool pump_ph_dose(float current_ph, float volume_liters);    // Automatic pH dos
 void pump_set_ph_target(float target_ph);                    // Set pH target
 float pump_get_ph_target(void);                              // Get pH target
 bool pump_manual_dose(PumpId pump, float ml);             // Manual dose override
+bool pump_can_dose(PumpId pump);                          // A manual dose would pass the safety limits now
+void pump_enable_ph_predictive(bool enabled);                // Predictive (trend) vs reactive (PID) dosing
+bool pump_is_ph_predictive(void);                            // Check predictive pH mode
+
+// Shadow pH controller functions (candidate policy next to the live one, never actuates)
+void pump_set_ph_shadow(PhPolicy policy, float kp, float ki, float kd); // Start (clears stats) or stop (OFF)
+PhPolicy pump_get_ph_shadow(void);                           // Current shadow policy
+void pump_get_ph_shadow_stats(ph_shadow_stats_t* stats);     // Live vs shadow statistics
+void pump_print_ph_shadow(void);                             // Live vs shadow summary
+
+// Micro-dosing functions
+void pump_enable_micro_dosing(bool enabled);                 // Sub-minimum doses as timed pulses
+bool pump_is_micro_dosing(void);                             // Check micro-dosing mode
+bool pump_set_pulse_calibration(PumpId pump, float flow_ml_per_min, uint32_t dead_ms); // Apply and store
+void pump_interactive_pulse_calibration(void);               // Two-point pulse calibration via Serial
+
+// Line priming functions
+bool pump_set_line_dead_volume(PumpId pump, float dead_ml);  // Apply and store a line volume
+float pump_get_line_fill(PumpId pump);                       // Estimated ml in the line now
+void pump_interactive_line_calibration(void);                // Measure a line volume via Serial
+
+// Dose fractionation functions
+void pump_set_dose_fractionation(uint8_t count, uint32_t gap_ms); // Pieces per automatic dose and gap
+void pump_get_dose_fractionation(uint8_t* count, uint32_t* gap_ms);
+
+// EC control functions
+bool pump_ec_dose(float current_ec, float volume_liters);    // Automatic EC dosing (nutrient A+B)
+void pump_set_ec_target(float target_ec);                    // Set EC target
+float pump_get_ec_target(void);                              // Get EC target
+void pump_enable_auto_ec(bool enabled);                      // Enable/disable auto EC
+bool pump_is_auto_ec_enabled(void);                          // Check auto EC status
 
-// EC control functions (Phase 2 foundation - not yet implemented)
-bool pump_ec_dose(float current_ec, float volume_liters);    // Returns false in Phase 1
-void pump_set_ec_target(float target_ec);                    // No-op in Phase 1
-float pump_get_ec_target(void);                              // Returns 0.0 in Phase 1
+// Coupled pH/EC control functions
+bool pump_coupled_dose(float current_ph, float current_ec, float volume_liters); // Joint pH/EC dosing
+void pump_enable_coupled_control(bool enabled);              // Coupled vs independent pH and EC loops
+bool pump_is_coupled_control(void);                          // Check coupled mode
 
 // PID tuning functions
 void pump_set_ph_pid(float kp, float ki, float kd);         // Set pH PID parameters
@@ -163,11 +412,16 @@ void pump_get_ph_pid(float* kp, float* ki, float* kd);      // Get pH PID parame
 // Status and utility functions
 void pump_print_status(void);                               // Print pump statistics
 bool pump_is_running(PumpId pump);                       // Check if pump running
+bool pump_any_running(void);                                // Any pump running (blocking prompts wait for none)
 void pump_reset_counters(void);                             // Reset dose counters
 float pump_get_total_dosed(PumpId pump);                 // Get total ml dosed
+float pump_get_total_primed(PumpId pump);                // Get total ml pumped into the line by priming
+float pump_get_total_inflow_ml(void);                       // ml delivered by all pumps (doses + manual runs)
 
 // Auto control functions
 void pump_enable_auto_ph(bool enabled);                     // Enable/disable auto pH
 bool pump_is_auto_ph_enabled(void);                         // Check auto pH status
+void pump_set_auto_inhibit(uint8_t reason, bool active);    // Pause/resume automatic dosing for a reason
+uint8_t pump_get_auto_inhibit(void);                        // Active PUMP_INHIBIT_* reasons (0 = none)
 
 #endif // PUMP_H
\ No newline at end of file
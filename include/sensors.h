@@ -8,6 +8,9 @@
  * - Non-blocking sensor reading with configurable intervals
  * - Power management for analog sensors
  * - Multi-sample averaging and low-pass filtering
+ * - Redundant pH/EC probes voted per reading (probe_vote.h)
+ * - Optional pH oversampling and decimation (adc_oversample.h) with
+ *   measured noise floor and effective resolution
  * - NVS storage for calibration data persistence (ESP32-S3)
  */
 
@@ -22,21 +25,23 @@
 //=============================================================================
 #include <OneWire.h>
 #include <DallasTemperature.h>
-constexpr int TEMP_SENSOR_PIN = 10;    // DS18B20 data pin (1-Wire)
+#include "board.h"
+constexpr int TEMP_SENSOR_PIN = Board::temp_pin;    // DS18B20 data pin (1-Wire)
 
 //=============================================================================
-// HARDWARE CONFIGURATION (ESP32-S3)
+// HARDWARE CONFIGURATION (from the board descriptor, board.h)
 //=============================================================================
 
-// Analog sensor pins (ESP32-S3 ADC pins)
-constexpr int PH_PIN = 6;           // pH sensor analog input (GPIO5)
-constexpr int EC_PIN = 5;           // EC sensor analog input (GPIO6)
+// Analog sensor pins (ESP32-S3 ADC1 pins)
+constexpr int PH_PIN = Board::ph_pin;           // pH sensor analog input (rev 1: GPIO6)
+constexpr int EC_PIN = Board::ec_pin;           // EC sensor analog input (rev 1: GPIO5)
+constexpr float SENSOR_ADC_VOLTS_PER_COUNT = Board::adc_ref_volts / ((1 << Board::adc_bits) - 1);
 
 // Digital control pins
-constexpr int PH_POWER_PIN = 7;      // pH sensor power control
-constexpr int EC_POWER_PIN = 4;      // EC sensor power control
-constexpr int TRIG_PIN = 8;          // Ultrasonic trigger pin
-constexpr int ECHO_PIN = 9;         // Ultrasonic echo pin
+constexpr int PH_POWER_PIN = Board::ph_power_pin;      // pH sensor power control
+constexpr int EC_POWER_PIN = Board::ec_power_pin;      // EC sensor power control
+constexpr int TRIG_PIN = Board::trig_pin;              // Ultrasonic trigger pin
+constexpr int ECHO_PIN = Board::echo_pin;              // Ultrasonic echo pin
 
 //=============================================================================
 // TIMING AND SAMPLING CONFIGURATION
@@ -45,6 +50,8 @@ constexpr int ECHO_PIN = 9;         // Ultrasonic echo pin
 constexpr uint32_t SENSOR_INTERVAL = 5000;  // Sensor reading interval (ms)
 constexpr uint32_t SENSOR_WARMUP = 200;     // Sensor warmup time after power on (ms)
 constexpr int FILTER_SAMPLES = 5;                // Number of samples for averaging
+constexpr uint32_t PH_DITHER_PWM_FREQ = 312500;  // Dither ramp PWM (8-bit at the 80 MHz LEDC clock), RC-filtered on the board
+constexpr uint8_t PH_DITHER_PWM_RESOLUTION = 8;
 
 //=============================================================================
 // NVS CONFIGURATION
@@ -127,14 +134,20 @@ bool sensor_update_needed(void);                 // Check if reading update is n
 // Reading functions
 sensor_readings_t sensor_read_all(void);         // Read all sensors with filtering
 sensor_readings_t sensor_read_raw(void);         // Read all sensors without filtering
+sensor_readings_t sensor_get_filtered(void);     // Latest filtered readings (no hardware access)
 
 // Individual sensor functions
 // Temperature-compensated sensor read functions accept calibration parameters
-float sensor_read_ph_raw(float temperature, const calibration_t& calib);      // Read pH sensor with temperature compensation
-float sensor_read_ec_raw(float temperature, const calibration_t& calib);      // Read EC sensor with temperature compensation
+float sensor_read_ph_raw(float temperature, const calibration_t& calib);      // Read pH sensor(s) with temperature compensation, -1 on a probe split
+float sensor_read_ec_raw(float temperature, const calibration_t& calib);      // Read EC sensor(s) with temperature compensation, -1 on a probe split
 float sensor_read_temperature_raw(void);          // Read water temperature
 float sensor_read_distance_raw(void);            // Read ultrasonic distance sensor
 
+// pH oversampling (0 = FILTER_SAMPLES average; n = 4^n conversions decimated to 12 + n bits)
+void sensor_set_ph_oversampling(uint8_t extra_bits);  // Resets the noise statistics
+uint8_t sensor_get_ph_oversampling(void);
+void sensor_print_ph_resolution(void);           // Burst spread, reading noise, effective bits
+
 // Data processing functions
 sensor_readings_t sensor_apply_filter(sensor_readings_t new_reading, sensor_readings_t filtered);
 
@@ -19,6 +19,17 @@
 // Forward declarations
 enum class PumpId;
 
+//=============================================================================
+// STATE TIMEOUT CONFIGURATION
+//=============================================================================
+
+// System and sensor timeouts; pump state timeouts come from
+// pump_state_timeout_ms() in pump.cpp. All of them run on one timer wheel:
+// entering a state arms its timeout, expiry fires the state's handler.
+constexpr uint32_t SYSTEM_ERROR_RECOVERY_MS = 5000;     // ERROR -> MONITORING
+constexpr uint32_t SENSOR_ERROR_RECOVERY_MS = 10000;    // Sensor ERROR -> READY
+constexpr uint32_t SENSOR_WARMUP_TIMEOUT_MS = 5000;     // Sensor WARMING_UP -> ERROR
+
 //=============================================================================
 // SYSTEM STATE MACHINE (ESP32-S3 System Level)
 //=============================================================================
@@ -142,6 +153,7 @@ uint32_t system_get_state_duration_ms(void);
 bool pump_transition_to(PumpId pump_id, PumpState new_state);
 const char* pump_state_to_string(PumpState state);
 uint32_t pump_get_state_duration_ms(PumpId pump_id);
+uint32_t pump_get_state_remaining_ms(PumpId pump_id);   // Until the state's timeout (0 = none)
 
 // Sensor state transition functions
 bool sensor_transition_to(SensorState new_state);
@@ -0,0 +1,118 @@
+/**
+ * @file telemetry.h
+ * @brief Binary telemetry frames for readings, pump transitions and alarms
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A compact, CRC-checked frame encoding shared by the firmware and the
+ *   host tools (collector), one frame per reading or event
+ * - Publication of every filtered reading, pump transition and alarm to
+ *   registered sinks, encoded once per event
+ * - A binary TCP stream on TELEMETRY_PORT for collectors (clients are
+ *   connection-pool objects; frames are written as they are published,
+ *   without blocking: a frame that finds the socket full is skipped)
+ *
+ * Frame layout (little-endian):
+ *
+ *   0xA5 | type u8 | len u8 | seq u32 | timestamp ms u32 | payload[len] | crc16
+ *
+ *   READING  ph, ec, volume, temperature as int16 (TELEMETRY_*_SCALE)
+ *   PUMP     pump u8, from state u8, to state u8 (PumpState order)
+ *   ALARM    severity u8, raised u8, value float, name len u8, name
+ *
+ * seq counts every frame since boot, so a receiver can detect gaps. The CRC
+ * is CRC-16/CCITT-FALSE over type..payload.
+ *
+ * The last TELEMETRY_HISTORY_FRAMES frames are kept for backfill: a stream
+ * client that sends the line "B <from> <count>\n" gets the frames of that
+ * range still held, interleaved with the live stream (receivers that lost
+ * datagrams, or frames skipped while their socket was full, fill their gaps
+ * this way). The range is sent as the socket takes it over the following
+ * passes; a new request replaces one still in progress.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "sensors.h"
+#include "alarms.h"
+
+class WiFiClient;
+
+//=============================================================================
+// TELEMETRY CONFIGURATION
+//=============================================================================
+
+constexpr uint16_t TELEMETRY_PORT = 2424;            // Binary stream for collectors
+constexpr int TELEMETRY_MAX_CLIENTS = 2;
+constexpr int TELEMETRY_MAX_SINKS = 6;
+constexpr int TELEMETRY_HISTORY_FRAMES = 128;        // Recent frames kept for backfill
+constexpr size_t TELEMETRY_REQUEST_MAX = 32;         // Backfill request line
+
+constexpr uint8_t TELEMETRY_SYNC = 0xA5;
+constexpr size_t TELEMETRY_HEADER_LEN = 11;          // sync, type, len, seq, timestamp
+constexpr size_t TELEMETRY_FRAME_MAX = TELEMETRY_HEADER_LEN + 8 + ALARM_NAME_LEN + 2;
+
+// Fixed-point scales of readings (shared with the Modbus register map)
+constexpr float TELEMETRY_PH_SCALE = 1000.0f;        // 0.001 pH
+constexpr float TELEMETRY_EC_SCALE = 1000.0f;        // 0.001 mS/cm (max 32.767)
+constexpr float TELEMETRY_VOLUME_SCALE = 10.0f;      // 0.1 L (max 3276.7)
+constexpr float TELEMETRY_TEMP_SCALE = 100.0f;       // 0.01 °C
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+enum class TelemetryType : uint8_t {
+    READING = 1,
+    PUMP = 2,
+    ALARM = 3
+};
+
+/**
+ * @brief One decoded telemetry frame
+ */
+struct telemetry_event_t {
+    TelemetryType type;
+    uint32_t seq;
+    uint32_t timestamp;                  // Device millis()
+    sensor_readings_t reading;           // READING (quantised to the frame scales)
+    uint8_t pump;                        // PUMP: PumpId index
+    uint8_t from_state;                  // PUMP: PumpState values
+    uint8_t to_state;
+    char alarm_name[ALARM_NAME_LEN];     // ALARM
+    uint8_t severity;                    // ALARM: AlarmSeverity value
+    bool raised;
+    float value;
+};
+
+typedef void (*telemetry_sink_t)(const telemetry_event_t& event, const uint8_t* frame, size_t len);
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Codec (pure; also used by host tools)
+uint16_t telemetry_crc16(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
+int16_t telemetry_scale(float value, float scale);                 // Rounded, saturated
+size_t telemetry_encode(const telemetry_event_t& event, uint8_t* out, size_t out_len);   // 0 if it does not fit
+int telemetry_decode(const uint8_t* data, size_t len, telemetry_event_t* event, size_t* consumed);  // 1 frame, 0 need more, -1 bad
+
+// Publisher
+void telemetry_init(void);
+void telemetry_update(void);                                       // Accept/clean up stream clients
+void telemetry_publish_reading(const sensor_readings_t& readings);
+void telemetry_publish_pump(uint8_t pump, uint8_t from_state, uint8_t to_state);
+bool telemetry_add_sink(telemetry_sink_t sink);
+uint32_t telemetry_get_seq(void);                                  // Next sequence number
+uint8_t telemetry_get_client_count(void);
+int telemetry_client_send(WiFiClient* client, const uint8_t* data, size_t len);  // Non-blocking: taken, 0 full, -1 closed
+
+// Backfill from the recent-frame history
+bool telemetry_parse_backfill(const char* line, size_t len, uint32_t* from, uint32_t* count);   // "B <from> <count>"
+size_t telemetry_backfill(uint32_t from, uint32_t count, uint8_t* out, size_t out_len, uint32_t* next);  // Whole frames
+uint32_t telemetry_get_oldest_seq(void);                           // Oldest frame still held
+
+#endif // TELEMETRY_H
@@ -0,0 +1,65 @@
+/**
+ * @file timer_wheel.h
+ * @brief Hashed timer wheel for a small fixed set of one-shot timeouts
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - O(1) arm, re-arm and cancel of timers identified by a small integer id
+ * - One advance per loop that returns every timer now due, as a bitmask
+ *
+ * Timers hash into TIMER_WHEEL_SLOTS slots of TIMER_WHEEL_TICK_MS by due
+ * time; longer timeouts simply stay in their slot for more revolutions. An
+ * advance visits only the slots whose tick has passed since the last one
+ * (at most one revolution after a stall) and only the timers hashed there,
+ * so its cost does not depend on how many timers are armed. A timer with
+ * deadline d is due once (now - d) > 0, which is exactly the old polled
+ * `millis() - entry > timeout` test with d = entry + timeout.
+ *
+ * Pure data structure on caller-owned state; the state machine owns the
+ * wheel for the FSM timeouts.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// TIMER WHEEL CONFIGURATION
+//=============================================================================
+
+constexpr int TIMER_WHEEL_TICK_SHIFT = 4;                          // 16 ms per slot
+constexpr uint32_t TIMER_WHEEL_TICK_MS = 1u << TIMER_WHEEL_TICK_SHIFT;
+constexpr int TIMER_WHEEL_SLOTS = 128;                             // One revolution = 2.048 s
+constexpr int TIMER_WHEEL_MAX_TIMERS = 32;                         // Ids fit the due bitmask
+constexpr uint8_t TIMER_WHEEL_NONE = 0xFF;
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Wheel of intrusive doubly linked slot lists, indexed by timer id
+ */
+struct timer_wheel_t {
+    uint8_t head[TIMER_WHEEL_SLOTS];            // First timer in each slot
+    uint8_t next[TIMER_WHEEL_MAX_TIMERS];
+    uint8_t prev[TIMER_WHEEL_MAX_TIMERS];
+    uint8_t slot[TIMER_WHEEL_MAX_TIMERS];       // TIMER_WHEEL_NONE = not armed
+    uint32_t deadline[TIMER_WHEEL_MAX_TIMERS];
+    uint32_t tick;                              // Oldest tick not yet fully processed
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void timer_wheel_init(timer_wheel_t* wheel, uint32_t now);
+void timer_wheel_arm(timer_wheel_t* wheel, uint8_t id, uint32_t deadline);  // Due once now > deadline
+void timer_wheel_cancel(timer_wheel_t* wheel, uint8_t id);
+bool timer_wheel_is_armed(const timer_wheel_t* wheel, uint8_t id);
+uint32_t timer_wheel_remaining_ms(const timer_wheel_t* wheel, uint8_t id, uint32_t now);  // 0 if due or not armed
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint32_t now);    // Bit i set: timer i due (now disarmed)
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,56 @@
+/**
+ * @file trend.h
+ * @brief Exponentially weighted linear trend fit with uncertainty
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - Incremental weighted least-squares fit of value vs time (O(1) per point)
+ * - Slope, level and residual spread of the fit
+ * - Prediction ahead of the newest point with a standard deviation
+ *
+ * Older points are down-weighted by exp(-age / tau). Sums are kept with the
+ * time origin at the newest point, so they stay small however long the fit
+ * runs; they are doubles because the slope is a difference of large products.
+ * Time is in whatever unit the caller uses for tau (hours, minutes, ...).
+ */
+
+#ifndef TREND_H
+#define TREND_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Weighted regression sums (origin = newest point)
+ */
+struct trend_fit_t {
+    double sw, st, sv, stt, stv, svv;  // Sums of w, w*t, w*v, w*t^2, w*t*v, w*v^2
+    float reference;                   // First value; sums hold value - reference
+    bool has_reference;
+};
+
+/**
+ * @brief Fit result
+ */
+struct trend_estimate_t {
+    float level;                 // Fitted value at the newest point
+    float slope;                 // Units per time unit
+    float slope_sigma;           // Standard error of the slope
+    float residual_sigma;        // Spread of points around the line
+    float weight;                // Sum of weights (effective number of points)
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+void trend_reset(trend_fit_t* fit);
+void trend_add(trend_fit_t* fit, double dt, float value, double tau);   // dt since the previous point
+bool trend_estimate(const trend_fit_t* fit, trend_estimate_t* out);     // false until two distinct times
+float trend_predict(const trend_fit_t* fit, double ahead, float* sigma); // Value 'ahead' after the newest point
+
+#endif // TREND_H
@@ -0,0 +1,144 @@
+/**
+ * @file usb_export.h
+ * @brief Binary bulk export of telemetry history, logs and crash records over USB
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - A framed, CRC-checked transfer of everything the controller holds for
+ *   after-the-fact diagnosis: the telemetry history (TELEMETRY_HISTORY_FRAMES),
+ *   the log flight recorder (binlog) and the crash log
+ * - The ESP32-S3 native USB port (USB Serial/JTAG, full speed) while the
+ *   console stays on the UART bridge. Builds with USB CDC on boot refuse to
+ *   export: much of the firmware prints straight to Serial, and that text
+ *   would land inside frames on a shared port
+ *
+ * An export starts with console 'X' or when the host tool writes 'X' to the
+ * native port. It runs from loop() in bounded slices, so control, dosing and
+ * the CLI (including 'x' emergency stop) keep running, and gives up if the
+ * host stops reading for USB_EXPORT_STALL_MS. Content is what the sources
+ * hold when it starts; anything newer goes into the next export.
+ *
+ * Frame layout (little-endian):
+ *
+ *   0xE5 | type u8 | seq u16 | len u16 | payload[len] | crc16
+ *
+ *   BEGIN      version u8, boot u32, uptime ms u32, telemetry from seq u32,
+ *              telemetry to seq u32, log bytes u32, crash records u8
+ *   TELEMETRY  whole telemetry frames (layout in telemetry.h), oldest first
+ *   LOG        whole flight recorder entries (layout in binlog.h)
+ *   CRASH      records of USB_EXPORT_CRASH_RECORD_LEN: boot u32, uptime ms
+ *              u32, reset reason u8, system state u8
+ *   END        frames u32, bytes u32 (both before END), elapsed us u32,
+ *              telemetry frames lost u32, log bytes lost u32 (overwritten
+ *              before they were sent)
+ *
+ * seq counts frames from 0 at BEGIN so the receiver sees lost frames. The
+ * CRC is telemetry_crc16() over type..payload. The sync byte is not ASCII,
+ * so stray console text between frames is skipped by the receiver.
+ */
+
+#ifndef USB_EXPORT_H
+#define USB_EXPORT_H
+
+#include <Arduino.h>
+
+//=============================================================================
+// USB EXPORT CONFIGURATION
+//=============================================================================
+
+constexpr uint8_t USB_EXPORT_VERSION = 1;
+constexpr uint8_t USB_EXPORT_SYNC = 0xE5;
+constexpr size_t USB_EXPORT_HEADER_LEN = 6;          // sync, type, seq, len
+constexpr size_t USB_EXPORT_PAYLOAD_MAX = 512;
+constexpr size_t USB_EXPORT_FRAME_MAX = USB_EXPORT_HEADER_LEN + USB_EXPORT_PAYLOAD_MAX + 2;
+constexpr size_t USB_EXPORT_BEGIN_LEN = 22;
+constexpr size_t USB_EXPORT_END_LEN = 20;
+constexpr size_t USB_EXPORT_CRASH_RECORD_LEN = 10;
+constexpr size_t USB_EXPORT_BYTES_PER_LOOP = 8192;   // Bounds one loop() slice
+constexpr uint32_t USB_EXPORT_STALL_MS = 2000;       // Host not reading: abort
+constexpr size_t USB_EXPORT_TX_BUFFER = 4096;        // Native port transmit buffer
+constexpr char USB_EXPORT_TRIGGER = 'X';             // Starts an export (console or native port)
+
+enum class UsbExportFrame : uint8_t {
+    BEGIN = 'B',
+    TELEMETRY = 'T',
+    LOG = 'L',
+    CRASH = 'C',
+    END = 'E'
+};
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief One decoded frame (payload points into the decoded buffer)
+ */
+struct usb_export_frame_t {
+    uint8_t type;
+    uint16_t seq;
+    uint16_t len;
+    const uint8_t* payload;
+};
+
+/**
+ * @brief Port output: bytes taken (0 = busy, try later), -1 = closed
+ */
+typedef int (*usb_export_write_t)(void* ctx, const uint8_t* data, size_t len);
+
+/**
+ * @brief One export in progress (caller-owned; sources are the firmware's)
+ */
+struct usb_export_t {
+    uint8_t section;                     // UsbExportFrame being sent; 0 = finished
+    uint32_t started_us;
+    uint32_t telemetry_next;             // Telemetry seq range of the snapshot
+    uint32_t telemetry_end;
+    uint32_t log_cursor;                 // Flight recorder range of the snapshot
+    uint32_t log_end;
+    uint8_t crash_next;
+    uint16_t seq;                        // Next frame seq
+    uint32_t frames;                     // Frames encoded so far
+    uint32_t bytes;
+    uint32_t telemetry_lost;
+    uint32_t log_lost;
+    uint8_t frame[USB_EXPORT_FRAME_MAX]; // Frame being written
+    uint16_t frame_len;
+    uint16_t frame_sent;
+};
+
+/**
+ * @brief Firmware export counters (since boot)
+ */
+struct usb_export_stats_t {
+    uint32_t exports;                    // Completed
+    uint32_t aborted;                    // Stalled or port closed
+    uint32_t last_bytes;
+    uint32_t last_elapsed_us;
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Codec (pure; also used by host tools)
+size_t usb_export_encode_frame(uint8_t type, uint16_t seq, const uint8_t* payload, size_t len, uint8_t* out,
+                               size_t out_len);                                  // 0 if it does not fit
+int usb_export_decode_frame(const uint8_t* data, size_t len, usb_export_frame_t* frame);  // Bytes used, 0 need more, -1 bad
+
+// Session (caller-owned state)
+void usb_export_begin(usb_export_t* session, uint32_t now_us);                   // Snapshot the source ranges
+int usb_export_pump(usb_export_t* session, usb_export_write_t write, void* ctx, size_t budget,
+                    uint32_t now_us);                                             // Bytes written or -1 closed
+bool usb_export_finished(const usb_export_t* session);
+
+// Firmware port
+void usb_export_init(void);
+bool usb_export_start(void);                         // false if one is already running or no native port
+void usb_export_update(void);                        // Send the next slice; native port trigger
+bool usb_export_is_active(void);
+usb_export_stats_t usb_export_get_stats(void);
+void usb_export_print_status(void);
+
+#endif // USB_EXPORT_H
@@ -0,0 +1,106 @@
+/**
+ * @file volume_balance.h
+ * @brief Reservoir volume balance: leak vs evaporation detection
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - Net volume tracking: filtered volume minus known pump inflow and top-ups
+ * - Incremental loss-rate estimate (exponentially weighted regression)
+ * - Top-up detection (rises no inflow explains)
+ * - Learned diurnal evaporation baseline (24 hour-of-day bins)
+ * - Leak alarm with hysteresis; automatic dosing is paused while it is raised
+ *
+ * Memory is constant (one volume_balance_t); every reading costs O(1).
+ * Hour bins are relative to boot (no RTC), so the learned profile is RAM-only
+ * and relearned within a day after a reboot; until then the default baseline
+ * applies.
+ */
+
+#ifndef VOLUME_BALANCE_H
+#define VOLUME_BALANCE_H
+
+#include <Arduino.h>
+#include "sensors.h"
+#include "trend.h"
+
+//=============================================================================
+// VOLUME BALANCE CONFIGURATION
+//=============================================================================
+
+constexpr float VB_MIN_VOLUME_L = 1.0f;              // Below this the volume is uncalibrated/empty
+constexpr uint32_t VB_WARMUP_MS = 120000;            // Let the volume EMA settle after (re)start
+constexpr float VB_TREND_TAU_H = 1.0f / 6.0f;       // Loss-rate regression time constant (10 min)
+constexpr float VB_TOPUP_ENTER_L = 0.25f;            // Unexplained rise per reading that starts a top-up
+constexpr float VB_TOPUP_EXIT_L = 0.02f;             // Rise per reading below which the top-up has ended
+constexpr float VB_DEFAULT_EVAP_L_PER_H = 0.2f;      // Baseline until the diurnal profile has data
+constexpr float VB_BASELINE_MAX_L_PER_H = 1.0f;      // Cap on learned evaporation (a leak from boot is not learned)
+constexpr float VB_BASELINE_ALPHA = 0.3f;            // Day-to-day EMA weight of each hour bin
+constexpr float VB_LEAK_RAISE_L_PER_H = 0.5f;        // Loss above baseline that indicates a leak
+constexpr float VB_LEAK_CLEAR_L_PER_H = 0.25f;       // Loss above baseline below which the leak has stopped
+constexpr uint32_t VB_LEAK_CONFIRM_MS = 600000;      // Raise/clear condition must persist 10 min
+constexpr int VB_DIURNAL_BINS = 24;                  // One bin per hour of day
+
+// Event flags returned by volume_balance_step()
+constexpr uint8_t VB_EVENT_TOPUP_START = 0x01;
+constexpr uint8_t VB_EVENT_TOPUP_END = 0x02;
+constexpr uint8_t VB_EVENT_LEAK_RAISED = 0x04;
+constexpr uint8_t VB_EVENT_LEAK_CLEARED = 0x08;
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief Volume balance estimator state
+ */
+struct volume_balance_t {
+    // Previous reading
+    bool started;
+    uint32_t start_time;              // First reading after (re)start (ms)
+    uint32_t last_time;               // ms
+    float last_volume;                // L
+    float last_inflow_ml;             // Cumulative pump inflow at last reading
+
+    // Corrections that make net volume continuous
+    float inflow_l;                   // Known pump inflow since start
+    float topup_l;                    // Detected top-ups since start
+    bool in_topup;
+    float current_topup_l;            // Size of the top-up in progress / last completed
+    uint16_t topup_count;
+
+    // Exponentially weighted regression of net volume vs time (h)
+    trend_fit_t trend;
+    bool settled;                     // Enough history for a trustworthy rate
+    float loss_rate;                  // L/h, positive = losing water
+
+    // Diurnal evaporation baseline
+    float diurnal[VB_DIURNAL_BINS];   // Learned loss rate per hour of day (L/h)
+    uint8_t diurnal_days[VB_DIURNAL_BINS];  // Days folded into each bin (saturating)
+    uint8_t current_hour;
+    float hour_sum;
+    uint16_t hour_samples;
+    float baseline;                   // Expected evaporation now (L/h)
+    float excess;                     // loss_rate - baseline (L/h)
+
+    // Leak alarm
+    bool leak;
+    bool leak_condition;
+    uint32_t leak_condition_since;
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Estimator core (no Arduino I/O, usable on the host)
+void volume_balance_reset(volume_balance_t* vb);
+uint8_t volume_balance_step(volume_balance_t* vb, float volume_l, float inflow_ml, uint32_t now);
+
+// Firmware integration
+void volume_balance_init(void);                                 // Restart estimation (boot, volume recalibration)
+void volume_balance_update(const sensor_readings_t& readings);  // Feed one reading; raises/clears the leak alarm
+const volume_balance_t* volume_balance_get(void);               // Current estimator state
+void volume_balance_print_status(void);                         // Print loss rate, baseline and leak state
+
+#endif // VOLUME_BALANCE_H
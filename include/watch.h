@@ -0,0 +1,143 @@
+/**
+ * @file watch.h
+ * @brief Per-connection watch subscriptions for the Serial/Telnet console
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - The watch command parser (pure; also driven by the fuzzer)
+ * - A scheduler over caller-owned clients: each client watches any set of
+ *   channels, each at its own period, and gets one line per pass with the
+ *   channels that came due
+ * - The console glue: 'W' reads "<channel> <seconds>" from the connection
+ *   that typed it, and watch_update() serves all clients from the main loop
+ *
+ * Lines are formatted from a snapshot (last published reading, pump and
+ * system states) taken only on passes where something is due, and a line
+ * is formatted once per pass for every client due on the same channels.
+ * With nothing watched a pass is one comparison. "log off" keeps a Telnet
+ * connection to its watch lines and the replies to its own commands.
+ *
+ *   W  ph 30        pH every 30 s
+ *   W  pumps 1      pump states every second
+ *   W  pumps off    stop one channel; "off" stops all, "list" shows them
+ */
+
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <Arduino.h>
+#include "sensors.h"
+#include "pump.h"
+
+//=============================================================================
+// WATCH CONFIGURATION
+//=============================================================================
+
+constexpr int WATCH_MAX_CLIENTS = 4;                 // Serial + Telnet slots (COMM_MAX_CLIENTS)
+constexpr uint32_t WATCH_MIN_PERIOD_MS = 1000;
+constexpr uint32_t WATCH_MAX_PERIOD_MS = 3600000;
+constexpr uint32_t WATCH_STALE_MS = 2 * SENSOR_INTERVAL;   // Older readings show their age
+constexpr size_t WATCH_LINE_MAX = 192;
+constexpr uint32_t WATCH_INPUT_TIMEOUT_MS = 10000;
+
+/**
+ * @brief What a client can watch (bit i of a mask = channel i)
+ */
+enum class WatchChannel : uint8_t {
+    PH,
+    EC,
+    TEMPERATURE,
+    VOLUME,
+    PUMPS,
+    STATE,
+    COUNT
+};
+
+constexpr int WATCH_CHANNEL_COUNT = static_cast<int>(WatchChannel::COUNT);
+
+/**
+ * @brief Parsed watch command
+ */
+enum class WatchAction : uint8_t {
+    LIST,                                // "" or "list"
+    SET,                                 // "<channel> <seconds>"
+    STOP,                                // "<channel> off"
+    STOP_ALL,                            // "off"
+    LOG                                  // "log on" / "log off"
+};
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+struct watch_request_t {
+    WatchAction action;
+    uint8_t channel;                     // SET, STOP
+    uint32_t period_ms;                  // SET
+    bool log;                            // LOG
+};
+
+/**
+ * @brief State the lines are formatted from
+ */
+struct watch_snapshot_t {
+    bool have_reading;
+    sensor_readings_t reading;           // Last published reading
+    uint8_t pump_state[static_cast<int>(PumpId::COUNT)];   // PumpState
+    uint8_t system_state;                // SystemState
+    uint32_t taken_at;                   // millis()
+};
+
+/**
+ * @brief One connection's watches
+ */
+struct watch_client_t {
+    uint8_t channels;                    // Watched channel bits
+    uint32_t period_ms[WATCH_CHANNEL_COUNT];
+    uint32_t next_due[WATCH_CHANNEL_COUNT];    // millis()
+    uint8_t due;                         // Channels due in the current pass
+    uint32_t lines;                      // Lines written
+    uint32_t failed;                     // Lines the connection did not take
+};
+
+/**
+ * @brief Caller-owned clients plus the earliest due time across all of them
+ */
+struct watch_table_t {
+    watch_client_t* clients;
+    int capacity;
+    uint8_t watching;                    // Clients with at least one channel
+    uint32_t next_due;                   // Nothing is due before this (valid while watching)
+    uint32_t snapshots;                  // Passes that took a snapshot
+    uint32_t formatted;                  // Lines formatted
+    uint32_t shared;                     // Lines reused for another client
+};
+
+typedef void (*watch_refresh_t)(watch_snapshot_t* snapshot);
+typedef bool (*watch_write_t)(void* ctx, int client, const char* line);   // false = not taken
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Parser (pure)
+bool watch_parse(const char* text, size_t len, watch_request_t* request);
+const char* watch_channel_to_string(WatchChannel channel);
+
+// Scheduler (pure; caller-owned state)
+void watch_table_init(watch_table_t* table, watch_client_t* clients, int capacity);
+void watch_apply(watch_table_t* table, int client, const watch_request_t& request, uint32_t now);  // SET, STOP, STOP_ALL
+void watch_reset_client(watch_table_t* table, int client);
+uint8_t watch_client_due(watch_client_t* client, uint32_t now);              // Due channel bits; schedules the next
+size_t watch_format(uint8_t channels, const watch_snapshot_t& snapshot, uint32_t now, char* out, size_t len);
+size_t watch_describe(const watch_client_t& client, char* out, size_t len);  // "ph 30s, pumps 1s" or "nothing"
+int watch_run(watch_table_t* table, watch_refresh_t refresh, watch_write_t write, void* ctx, uint32_t now);  // Lines written
+
+// Console
+void watch_init(void);
+void watch_update(void);                             // Serve due watches (main loop)
+void watch_command(void);                            // 'W': read and apply one watch command
+void watch_print_status(void);
+
+#endif // WATCH_H
@@ -0,0 +1,160 @@
+/**
+ * @file websocket.h
+ * @brief WebSocket live stream of readings, pump transitions and alarms
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * This header provides interface for:
+ * - The RFC 6455 opening handshake and client frame decoding (pure; also
+ *   driven by host tests and the fuzzer)
+ * - A fan-out hub: each telemetry event is wrapped once into a WebSocket
+ *   binary message held in a shared slot, and every subscriber is written
+ *   from that slot
+ * - A server on WEBSOCKET_PORT polled from the main loop
+ *
+ * Messages are binary, one telemetry frame each (layout in telemetry.h).
+ * Clients pick what they receive and how often in the request path, and
+ * may change it later by sending the same text as a text message:
+ *
+ *   ws://<device>:81/stream?events=reading,pump,alarm&hz=2
+ *
+ * events defaults to all three; hz caps updates per second (0 or absent =
+ * as published, at most WEBSOCKET_MAX_HZ). A subscriber that is rate-limited
+ * or whose socket is not taking data does not queue readings or pump
+ * transitions: it keeps one pending flag per slot (the reading, each pump),
+ * and a newer event replaces the unsent one. When it catches up it receives
+ * the latest value of each slot once. Alarms are not coalesced - two rules
+ * raised by the same reading are two messages - so the hub keeps the last
+ * WEBSOCKET_ALARM_QUEUE of them and each subscriber its position in that
+ * queue; alarms overwritten before a subscriber got them are counted. Frames
+ * carry the telemetry sequence number, so the skipped count is visible to
+ * the client.
+ */
+
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <Arduino.h>
+#include "telemetry.h"
+
+//=============================================================================
+// WEBSOCKET CONFIGURATION
+//=============================================================================
+
+constexpr uint16_t WEBSOCKET_PORT = 81;
+constexpr int WEBSOCKET_MAX_CLIENTS = 4;
+constexpr uint16_t WEBSOCKET_MAX_HZ = 50;
+constexpr size_t WEBSOCKET_REQUEST_MAX = 1024;              // Handshake request (FRAME pool block)
+constexpr size_t WEBSOCKET_RESPONSE_MAX = 160;
+constexpr size_t WEBSOCKET_CONTROL_MAX = 125;               // Largest client payload accepted
+constexpr size_t WEBSOCKET_RX_MAX = 6 + WEBSOCKET_CONTROL_MAX;  // Header + mask + payload
+constexpr size_t WEBSOCKET_MESSAGE_MAX = 2 + TELEMETRY_FRAME_MAX;
+constexpr uint32_t WEBSOCKET_HANDSHAKE_TIMEOUT_MS = 5000;
+
+// Hub slots: latest message of each kind (alarms are queued instead)
+constexpr int WEBSOCKET_SLOT_READING = 0;
+constexpr int WEBSOCKET_SLOT_PUMP = 1;                      // + pump index
+constexpr int WEBSOCKET_SLOT_COUNT = 5;
+constexpr uint32_t WEBSOCKET_ALARM_QUEUE = 8;               // Alarm messages kept for slow subscribers
+
+// Subscription mask bits
+constexpr uint8_t WEBSOCKET_EVENT_READING = 1u << 0;
+constexpr uint8_t WEBSOCKET_EVENT_PUMP = 1u << 1;
+constexpr uint8_t WEBSOCKET_EVENT_ALARM = 1u << 2;
+constexpr uint8_t WEBSOCKET_EVENT_ALL = 0x07;
+
+// Opcodes
+constexpr uint8_t WEBSOCKET_OP_TEXT = 0x1;
+constexpr uint8_t WEBSOCKET_OP_BINARY = 0x2;
+constexpr uint8_t WEBSOCKET_OP_CLOSE = 0x8;
+constexpr uint8_t WEBSOCKET_OP_PING = 0x9;
+constexpr uint8_t WEBSOCKET_OP_PONG = 0xA;
+
+//=============================================================================
+// DATA STRUCTURES
+//=============================================================================
+
+/**
+ * @brief What a client receives and how often
+ */
+struct websocket_subscription_t {
+    uint8_t events;                      // WEBSOCKET_EVENT_* bits
+    uint16_t max_hz;                     // 0 = no cap
+};
+
+/**
+ * @brief One decoded (unmasked) client frame
+ */
+struct websocket_frame_t {
+    uint8_t opcode;
+    bool fin;
+    uint8_t length;
+    uint8_t payload[WEBSOCKET_CONTROL_MAX];
+};
+
+/**
+ * @brief Subscriber output: bytes taken (0 = busy, try later), -1 = closed
+ */
+typedef int (*websocket_write_t)(void* ctx, const uint8_t* data, size_t len);
+
+/**
+ * @brief One subscriber of a hub (write == nullptr: free)
+ */
+struct websocket_subscriber_t {
+    websocket_write_t write;
+    void* ctx;
+    uint8_t events;
+    uint16_t min_interval_ms;            // From max_hz
+    uint32_t last_flush;                 // millis() of the last rate-limited flush
+    uint8_t pending;                     // Bit per slot: newer message than sent
+    uint32_t alarm_next;                 // Hub alarm count when this one was last up to date
+    uint8_t tail[WEBSOCKET_MESSAGE_MAX]; // Rest of a partially written message
+    uint8_t tail_len;
+    bool closed;                         // Write reported -1; owner reclaims
+    uint32_t sent;
+    uint32_t coalesced;                  // Messages replaced before they were sent
+    uint32_t alarms_dropped;             // Alarms overwritten in the queue before they were sent
+};
+
+/**
+ * @brief Latest message per slot, recent alarms, plus caller-owned subscribers
+ */
+struct websocket_hub_t {
+    uint8_t message[WEBSOCKET_SLOT_COUNT][WEBSOCKET_MESSAGE_MAX];
+    uint8_t message_len[WEBSOCKET_SLOT_COUNT];
+    uint8_t alarm[WEBSOCKET_ALARM_QUEUE][WEBSOCKET_MESSAGE_MAX];
+    uint8_t alarm_len[WEBSOCKET_ALARM_QUEUE];
+    uint32_t alarms;                     // Alarm messages published; the newest is at (alarms - 1) % queue
+    websocket_subscriber_t* subscribers;
+    int capacity;
+    uint32_t published;
+};
+
+//=============================================================================
+// FUNCTION DECLARATIONS
+//=============================================================================
+
+// Protocol (pure)
+// Complete request: response length (101 Switching Protocols) or -1 rejected; 0 need more
+int websocket_handshake(const char* request, size_t len, char* response, size_t response_len,
+                        websocket_subscription_t* subscription);
+bool websocket_parse_subscription(const char* text, size_t len, websocket_subscription_t* subscription);
+int websocket_decode_frame(const uint8_t* data, size_t len, websocket_frame_t* frame);  // Bytes used, 0 need more, -1 bad
+size_t websocket_encode_header(uint8_t opcode, size_t payload_len, uint8_t* out);       // Server frames (unmasked)
+
+// Fan-out hub (pure; caller-owned state)
+void websocket_hub_init(websocket_hub_t* hub, websocket_subscriber_t* subscribers, int capacity);
+int websocket_hub_subscribe(websocket_hub_t* hub, websocket_write_t write, void* ctx,
+                            const websocket_subscription_t& subscription);               // Index or -1 if full
+void websocket_hub_set_subscription(websocket_hub_t* hub, int index, const websocket_subscription_t& subscription);
+void websocket_hub_unsubscribe(websocket_hub_t* hub, int index);
+void websocket_hub_publish(websocket_hub_t* hub, const telemetry_event_t& event, const uint8_t* frame, size_t len,
+                           uint32_t now);
+void websocket_hub_flush(websocket_hub_t* hub, uint32_t now);                            // Send what rate limits now allow
+
+// Server
+void websocket_init(void);
+void websocket_update(void);
+uint8_t websocket_get_client_count(void);
+
+#endif // WEBSOCKET_H
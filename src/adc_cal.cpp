@@ -0,0 +1,124 @@
+/**
+ * @file adc_cal.cpp
+ * @brief eFuse curve-fitting lookup table for the pH/EC ADC inputs
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "adc_cal.h"
+#include "sensors.h"
+#include "communication.h"
+#include <esp_adc/adc_cali_scheme.h>
+
+static_assert(Board::adc_bits == 12, "the curve-fitting scheme converts 12-bit codes");
+
+//=============================================================================
+// TABLE
+//=============================================================================
+
+/**
+ * @brief Fill lut[0..codes) from a converter, clamping to the uint16_t range
+ * @return false (table incomplete) if the converter refused a code
+ */
+bool adc_cal_build_lut(adc_cal_convert_t convert, void* ctx, uint16_t* lut, int codes) {
+    for (int code = 0; code < codes; code++) {
+        int millivolts = 0;
+        if (!convert(ctx, code, &millivolts)) return false;
+        lut[code] = (uint16_t)constrain(millivolts, 0, 65535);
+    }
+    return true;
+}
+
+//=============================================================================
+// FIRMWARE
+//=============================================================================
+
+static uint16_t adc_lut[ADC_CAL_CODES];
+static AdcCalSource adc_source = AdcCalSource::LINEAR;
+
+static bool cali_convert(void* ctx, int code, int* millivolts) {
+    return adc_cali_raw_to_voltage(static_cast<adc_cali_handle_t>(ctx), code, millivolts) == ESP_OK;
+}
+
+/**
+ * @brief Build the table from the eFuse curve, or fall back to the linear scale
+ * The scheme handle is only needed while the table is built.
+ */
+AdcCalSource adc_cal_init(void) {
+    adc_source = AdcCalSource::LINEAR;
+
+    adc_cali_curve_fitting_config_t config = {};
+    config.unit_id = ADC_UNIT_1;
+    config.chan = static_cast<adc_channel_t>(Board::ph_adc_channel);
+    config.atten = static_cast<adc_atten_t>(Board::adc_attenuation);
+    config.bitwidth = ADC_BITWIDTH_12;
+    adc_cali_handle_t handle = nullptr;
+    esp_err_t err = adc_cali_create_scheme_curve_fitting(&config, &handle);
+    if (err != ESP_OK) {
+        Debug->printf("ADC: no eFuse calibration (%d) - linear %.1f V / %d", (int)err, Board::adc_ref_volts,
+                      ADC_CAL_CODES - 1);
+        return adc_source;
+    }
+
+    if (adc_cal_build_lut(cali_convert, handle, adc_lut, ADC_CAL_CODES)) {
+        adc_source = AdcCalSource::EFUSE_CURVE;
+        Debug->printf("ADC: eFuse curve table built, code 0 = %u mV, %d = %u mV", adc_lut[0], ADC_CAL_CODES - 1,
+                      adc_lut[ADC_CAL_CODES - 1]);
+    } else {
+        Debug->println("ERROR: ADC calibration refused a code - linear scale");
+    }
+    adc_cali_delete_scheme_curve_fitting(handle);
+    return adc_source;
+}
+
+/**
+ * @brief Millivolts for one ADC code (pH and EC inputs share the attenuation)
+ */
+float adc_cal_millivolts(int code) {
+    code = constrain(code, 0, ADC_CAL_CODES - 1);
+    if (adc_source == AdcCalSource::EFUSE_CURVE) {
+        return adc_lut[code];
+    }
+    float voltage = code * SENSOR_ADC_VOLTS_PER_COUNT;
+    return voltage * 1000.0;
+}
+
+/**
+ * @brief Millivolts for a fractional code (oversampled reading)
+ * The table holds whole mV, so sub-LSB steps come from the interpolation;
+ * the linear scale is the same formula as adc_cal_millivolts().
+ */
+float adc_cal_millivolts_fine(float code) {
+    code = constrain(code, 0.0f, (float)(ADC_CAL_CODES - 1));
+    if (adc_source == AdcCalSource::EFUSE_CURVE) {
+        int index = (int)code;
+        if (index >= ADC_CAL_CODES - 1) return adc_lut[ADC_CAL_CODES - 1];
+        float frac = code - index;
+        return adc_lut[index] + frac * ((float)adc_lut[index + 1] - adc_lut[index]);
+    }
+    float voltage = code * SENSOR_ADC_VOLTS_PER_COUNT;
+    return voltage * 1000.0;
+}
+
+AdcCalSource adc_cal_get_source(void) {
+    return adc_source;
+}
+
+const char* adc_cal_source_to_string(AdcCalSource source) {
+    switch (source) {
+        case AdcCalSource::LINEAR:      return "linear";
+        case AdcCalSource::EFUSE_CURVE: return "eFuse curve";
+        default:                        return "unknown";
+    }
+}
+
+void adc_cal_print_status(void) {
+    if (adc_source != AdcCalSource::EFUSE_CURVE) {
+        Debug->printf("ADC: %s (%.1f V / %d)", adc_cal_source_to_string(adc_source), Board::adc_ref_volts,
+                      ADC_CAL_CODES - 1);
+        return;
+    }
+    Debug->printf("ADC: %s table, 0 = %u mV, %d = %u mV, %d = %u mV", adc_cal_source_to_string(adc_source),
+                  adc_lut[0], ADC_CAL_CODES / 2, adc_lut[ADC_CAL_CODES / 2], ADC_CAL_CODES - 1,
+                  adc_lut[ADC_CAL_CODES - 1]);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file adc_oversample.cpp
+ * @brief Oversampling, decimation and resolution measurement for ADC bursts
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "adc_oversample.h"
+#include <math.h>
+
+//=============================================================================
+// OVERSAMPLER
+//=============================================================================
+
+void adc_oversample_init(adc_oversample_t* os, uint8_t extra_bits) {
+    os->extra_bits = extra_bits > ADC_OVERSAMPLE_MAX_BITS ? ADC_OVERSAMPLE_MAX_BITS : extra_bits;
+    os->code = 0;
+    os->burst_spread_lsb = 0.0f;
+    adc_oversample_reset_stats(os);
+}
+
+void adc_oversample_reset_stats(adc_oversample_t* os) {
+    os->readings = 0;
+    os->last_code = 0;
+    os->diff_sum_sq = 0.0;
+    os->spread_sum = 0.0;
+}
+
+/**
+ * @brief One reading: 4^n conversions, summed and shifted right by n
+ * @return Decimated code (adc_bits + extra_bits wide)
+ */
+uint32_t adc_oversample_read(adc_oversample_t* os, adc_sample_t sample, adc_dither_t dither, void* ctx) {
+    const int count = 1 << (2 * os->extra_bits);
+    uint32_t sum = 0;
+    uint64_t sum_sq = 0;
+    for (int i = 0; i < count; i++) {
+        if (dither && count > 1) dither(ctx, i, count);
+        int raw = constrain(sample(ctx), 0, (1 << Board::adc_bits) - 1);
+        sum += (uint32_t)raw;
+        sum_sq += (uint64_t)raw * (uint64_t)raw;
+    }
+    os->code = sum >> os->extra_bits;
+
+    double mean = (double)sum / count;
+    double variance = (double)sum_sq / count - mean * mean;
+    os->burst_spread_lsb = variance > 0.0 ? (float)sqrt(variance) : 0.0f;
+
+    if (os->readings > 0) {
+        double diff = (double)os->code - (double)os->last_code;
+        os->diff_sum_sq += diff * diff;
+    }
+    os->spread_sum += os->burst_spread_lsb;
+    os->last_code = os->code;
+    os->readings++;
+    return os->code;
+}
+
+float adc_oversample_code(const adc_oversample_t* os) {
+    return (float)os->code / (float)(1u << os->extra_bits);
+}
+
+//=============================================================================
+// MEASUREMENT
+//=============================================================================
+
+/**
+ * @brief Reading noise: RMS successive difference / sqrt(2), in ADC LSBs
+ * Needs two differences so one step in the input is not the whole estimate.
+ */
+float adc_oversample_noise_lsb(const adc_oversample_t* os) {
+    if (os->readings < 3) return -1.0f;
+    double sigma = sqrt(os->diff_sum_sq / (2.0 * (os->readings - 1)));
+    return (float)(sigma / (1u << os->extra_bits));
+}
+
+float adc_oversample_mean_spread_lsb(const adc_oversample_t* os) {
+    if (os->readings == 0) return -1.0f;
+    return (float)(os->spread_sum / os->readings);
+}
+
+float adc_oversample_effective_bits(const adc_oversample_t* os) {
+    float noise = adc_oversample_noise_lsb(os);
+    if (noise < 0.0f) return -1.0f;
+    // Without spread the decimated code is the plain code shifted: no bits gained
+    float cap = Board::adc_bits;
+    if (os->extra_bits > 0 && adc_oversample_mean_spread_lsb(os) >= ADC_OVERSAMPLE_MIN_SPREAD_LSB) {
+        cap += os->extra_bits;
+    }
+    if (noise <= 0.0f) return cap;
+    float bits = Board::adc_bits - log2f(noise * sqrtf(12.0f));
+    return bits < cap ? bits : cap;
+}
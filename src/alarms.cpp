@@ -0,0 +1,1005 @@
+/**
+ * @file alarms.cpp
+ * @brief Alarm rule compiler, bytecode evaluator and firmware alarm engine
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "alarms.h"
+#include "pump.h"
+#include "volume_balance.h"
+#include "communication.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+//=============================================================================
+// BYTECODE DEFINITION
+//=============================================================================
+
+// Opcodes; operands follow inline (f32 little-endian, u8 indices)
+enum : uint8_t {
+    OP_CONST = 1,    // f32 value
+    OP_LOAD,         // u8 variable
+    OP_HIST,         // u8 function, u8 channel, u8 slots
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_NEG,
+    OP_ABS,
+    OP_LT,           // f32 hysteresis (applied while the alarm is active)
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_AND,
+    OP_OR,
+    OP_NOT
+};
+
+// History functions for OP_HIST
+enum : uint8_t {
+    HIST_DELTA = 0,  // current - value one window ago
+    HIST_RATE,       // delta per hour
+    HIST_PCT,        // delta in percent of the old value
+    HIST_AVG,
+    HIST_MIN,
+    HIST_MAX,
+    HIST_COUNT
+};
+
+static const char* const kAlarmVarNames[static_cast<int>(AlarmVar::COUNT)] = {
+    "ph", "ec", "volume", "temp", "ph_dosed", "auto_ph", "loss_rate", "excess_loss"
+};
+
+static const char* const kHistFunctionNames[HIST_COUNT] = {
+    "delta", "rate", "pct", "avg", "min", "max"
+};
+
+// Rule set used until one is stored with 'L' (see alarm_interactive_rules)
+static const char kDefaultAlarmRules[] =
+    "ph_low: ph < 5.2 hyst 0.1 for 10m hold 2m crit\n"
+    "ph_high: ph > 7.0 hyst 0.1 for 10m hold 2m warn\n"
+    "ec_rising: rate(ec, 1h) > 0.3 hyst 0.05 for 5m warn\n"
+    "no_ph_response: delta(ph_dosed, 15m) > 10 and abs(delta(ph, 15m)) < 0.05 for 1m warn\n";
+
+//=============================================================================
+// COMPILER
+//=============================================================================
+
+enum AlarmToken {
+    TOK_EOF,
+    TOK_SEP,         // newline or ';' (end of rule)
+    TOK_NUMBER,      // with optional unit suffix (10m)
+    TOK_IDENT,
+    TOK_LT, TOK_LE, TOK_GT, TOK_GE,
+    TOK_LPAREN, TOK_RPAREN, TOK_COMMA, TOK_COLON,
+    TOK_PLUS, TOK_MINUS, TOK_STAR, TOK_SLASH,
+    TOK_INVALID
+};
+
+/**
+ * @brief Recursive-descent compiler state (lives on the caller's stack)
+ */
+struct alarm_parser_t {
+    const char* pos;
+    const char* line_start;
+    int line;
+    alarm_program_t* program;
+    alarm_compile_error_t* error;
+    bool failed;
+    int depth;                   // Current VM stack depth of the emitted code
+    int nesting;                 // Parser recursion depth (parentheses, unary chains)
+    bool after_newline;          // Last token ended a line (errors on it report that line)
+
+    AlarmToken tok;
+    const char* tok_start;
+    size_t tok_len;
+    float tok_number;
+    const char* tok_suffix;      // Unit suffix of a number token
+    size_t tok_suffix_len;
+};
+
+static void parser_fail(alarm_parser_t* p, const char* message) {
+    if (p->failed) return;
+    p->failed = true;
+    if (p->error) {
+        p->error->line = p->line;
+        p->error->column = (int)(p->tok_start - p->line_start) + 1;
+        strncpy(p->error->message, message, sizeof(p->error->message) - 1);
+        p->error->message[sizeof(p->error->message) - 1] = '\0';
+    }
+}
+
+static bool tok_is(const alarm_parser_t* p, const char* word) {
+    return p->tok == TOK_IDENT && strlen(word) == p->tok_len && strncmp(p->tok_start, word, p->tok_len) == 0;
+}
+
+static void parser_next(alarm_parser_t* p) {
+    if (p->after_newline) {
+        p->line++;
+        p->line_start = p->pos;
+        p->after_newline = false;
+    }
+    const char* s = p->pos;
+    while (*s == ' ' || *s == '\t' || *s == '\r') s++;
+    if (*s == '#') {
+        while (*s && *s != '\n') s++;
+    }
+    p->tok_start = s;
+    p->tok_len = 1;
+
+    if (*s == '\0') {
+        p->tok = TOK_EOF;
+        p->tok_len = 0;
+        p->pos = s;
+        return;
+    }
+    if (*s == '\n' || *s == ';') {
+        p->tok = TOK_SEP;
+        p->pos = s + 1;
+        p->after_newline = (*s == '\n');
+        return;
+    }
+    if (isdigit((unsigned char)*s) || (*s == '.' && isdigit((unsigned char)s[1]))) {
+        char* end = nullptr;
+        p->tok_number = strtof(s, &end);
+        p->tok_suffix = end;
+        while (isalpha((unsigned char)*end)) end++;
+        p->tok_suffix_len = (size_t)(end - p->tok_suffix);
+        p->tok = TOK_NUMBER;
+        p->tok_len = (size_t)(end - s);
+        p->pos = end;
+        return;
+    }
+    if (isalpha((unsigned char)*s) || *s == '_') {
+        const char* end = s;
+        while (isalnum((unsigned char)*end) || *end == '_') end++;
+        p->tok = TOK_IDENT;
+        p->tok_len = (size_t)(end - s);
+        p->pos = end;
+        return;
+    }
+
+    p->pos = s + 1;
+    switch (*s) {
+        case '<':
+            if (s[1] == '=') { p->tok = TOK_LE; p->tok_len = 2; p->pos++; } else { p->tok = TOK_LT; }
+            break;
+        case '>':
+            if (s[1] == '=') { p->tok = TOK_GE; p->tok_len = 2; p->pos++; } else { p->tok = TOK_GT; }
+            break;
+        case '(': p->tok = TOK_LPAREN; break;
+        case ')': p->tok = TOK_RPAREN; break;
+        case ',': p->tok = TOK_COMMA; break;
+        case ':': p->tok = TOK_COLON; break;
+        case '+': p->tok = TOK_PLUS; break;
+        case '-': p->tok = TOK_MINUS; break;
+        case '*': p->tok = TOK_STAR; break;
+        case '/': p->tok = TOK_SLASH; break;
+        default: p->tok = TOK_INVALID; break;
+    }
+}
+
+static void parser_expect(alarm_parser_t* p, AlarmToken tok, const char* message) {
+    if (p->failed) return;
+    if (p->tok != tok) {
+        parser_fail(p, message);
+        return;
+    }
+    parser_next(p);
+}
+
+static void emit_u8(alarm_parser_t* p, uint8_t value) {
+    if (p->failed) return;
+    if (p->program->code_used >= ALARM_CODE_SIZE) {
+        parser_fail(p, "rule set exceeds bytecode pool");
+        return;
+    }
+    p->program->code[p->program->code_used++] = value;
+}
+
+static void emit_f32(alarm_parser_t* p, float value) {
+    uint8_t bytes[sizeof(float)];
+    memcpy(bytes, &value, sizeof(float));
+    for (size_t i = 0; i < sizeof(float); i++) emit_u8(p, bytes[i]);
+}
+
+// Track VM stack depth so the evaluator never needs bounds checks
+static void stack_push(alarm_parser_t* p) {
+    if (++p->depth > ALARM_STACK_DEPTH) parser_fail(p, "expression too deeply nested");
+}
+
+static void stack_pop(alarm_parser_t* p) {
+    p->depth--;
+}
+
+// Bound parser recursion for inputs such as "((((((" or "- - - -"
+static bool parser_enter(alarm_parser_t* p) {
+    if (++p->nesting > ALARM_STACK_DEPTH * 2) {
+        parser_fail(p, "expression too deeply nested");
+        return false;
+    }
+    return true;
+}
+
+static int lookup_name(const alarm_parser_t* p, const char* const* names, int count) {
+    for (int i = 0; i < count; i++) {
+        if (tok_is(p, names[i])) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Parse a duration token (10, 30s, 10m, 1h) into milliseconds
+ */
+static uint32_t parse_duration(alarm_parser_t* p) {
+    if (p->failed) return 0;
+    if (p->tok != TOK_NUMBER) {
+        parser_fail(p, "expected duration (e.g. 30s, 10m, 1h)");
+        return 0;
+    }
+    float unit_ms;
+    if (p->tok_suffix_len == 0 || (p->tok_suffix_len == 1 && p->tok_suffix[0] == 's')) unit_ms = 1000.0f;
+    else if (p->tok_suffix_len == 1 && p->tok_suffix[0] == 'm') unit_ms = 60000.0f;
+    else if (p->tok_suffix_len == 1 && p->tok_suffix[0] == 'h') unit_ms = 3600000.0f;
+    else {
+        parser_fail(p, "unknown duration unit (use s, m or h)");
+        return 0;
+    }
+    float ms = p->tok_number * unit_ms;
+    if (!(ms >= 0.0f) || ms > 86400000.0f) {
+        parser_fail(p, "duration out of range (max 24h)");
+        return 0;
+    }
+    parser_next(p);
+    return (uint32_t)ms;
+}
+
+static void parse_or(alarm_parser_t* p);
+
+static void parse_primary(alarm_parser_t* p) {
+    if (p->failed) return;
+
+    if (p->tok == TOK_NUMBER) {
+        if (p->tok_suffix_len != 0) {
+            parser_fail(p, "unexpected unit suffix on number");
+            return;
+        }
+        emit_u8(p, OP_CONST);
+        emit_f32(p, p->tok_number);
+        stack_push(p);
+        parser_next(p);
+        return;
+    }
+    if (p->tok == TOK_LPAREN) {
+        if (!parser_enter(p)) return;
+        parser_next(p);
+        parse_or(p);
+        parser_expect(p, TOK_RPAREN, "expected ')'");
+        p->nesting--;
+        return;
+    }
+    if (p->tok != TOK_IDENT) {
+        parser_fail(p, "expected number, variable or function");
+        return;
+    }
+
+    if (tok_is(p, "abs")) {
+        if (!parser_enter(p)) return;
+        parser_next(p);
+        parser_expect(p, TOK_LPAREN, "expected '(' after abs");
+        parse_or(p);
+        parser_expect(p, TOK_RPAREN, "expected ')'");
+        emit_u8(p, OP_ABS);
+        p->nesting--;
+        return;
+    }
+
+    int fn = lookup_name(p, kHistFunctionNames, HIST_COUNT);
+    if (fn >= 0) {
+        parser_next(p);
+        parser_expect(p, TOK_LPAREN, "expected '(' after function name");
+        if (p->failed) return;
+        int channel = lookup_name(p, kAlarmVarNames, ALARM_HISTORY_CHANNELS);
+        if (channel < 0) {
+            parser_fail(p, "expected history channel (ph, ec, volume, temp, ph_dosed)");
+            return;
+        }
+        parser_next(p);
+        parser_expect(p, TOK_COMMA, "expected ',' before window");
+        const char* window_start = p->tok_start;
+        uint32_t window_ms = parse_duration(p);
+        uint32_t slots = (window_ms + ALARM_HISTORY_PERIOD_MS / 2) / ALARM_HISTORY_PERIOD_MS;
+        if (!p->failed && (slots < 1 || slots > ALARM_HISTORY_SLOTS)) {
+            p->tok_start = window_start;
+            parser_fail(p, "window must be 1m..128m");
+            return;
+        }
+        parser_expect(p, TOK_RPAREN, "expected ')'");
+        emit_u8(p, OP_HIST);
+        emit_u8(p, (uint8_t)fn);
+        emit_u8(p, (uint8_t)channel);
+        emit_u8(p, (uint8_t)slots);
+        stack_push(p);
+        return;
+    }
+
+    int var = lookup_name(p, kAlarmVarNames, static_cast<int>(AlarmVar::COUNT));
+    if (var < 0) {
+        parser_fail(p, "unknown variable or function");
+        return;
+    }
+    emit_u8(p, OP_LOAD);
+    emit_u8(p, (uint8_t)var);
+    stack_push(p);
+    parser_next(p);
+}
+
+static void parse_unary(alarm_parser_t* p) {
+    if (p->failed) return;
+    if (p->tok == TOK_MINUS) {
+        if (!parser_enter(p)) return;
+        parser_next(p);
+        if (p->tok == TOK_NUMBER && p->tok_suffix_len == 0) {
+            // Fold negative literals ("< -10") into one constant
+            p->tok_number = -p->tok_number;
+            parse_primary(p);
+            p->nesting--;
+            return;
+        }
+        parse_unary(p);
+        emit_u8(p, OP_NEG);
+        p->nesting--;
+        return;
+    }
+    parse_primary(p);
+}
+
+static void parse_term(alarm_parser_t* p) {
+    parse_unary(p);
+    while (!p->failed && (p->tok == TOK_STAR || p->tok == TOK_SLASH)) {
+        uint8_t op = p->tok == TOK_STAR ? OP_MUL : OP_DIV;
+        parser_next(p);
+        parse_unary(p);
+        emit_u8(p, op);
+        stack_pop(p);
+    }
+}
+
+static void parse_sum(alarm_parser_t* p) {
+    parse_term(p);
+    while (!p->failed && (p->tok == TOK_PLUS || p->tok == TOK_MINUS)) {
+        uint8_t op = p->tok == TOK_PLUS ? OP_ADD : OP_SUB;
+        parser_next(p);
+        parse_term(p);
+        emit_u8(p, op);
+        stack_pop(p);
+    }
+}
+
+static void parse_comparison(alarm_parser_t* p) {
+    parse_sum(p);
+    if (p->failed) return;
+
+    uint8_t op;
+    switch (p->tok) {
+        case TOK_LT: op = OP_LT; break;
+        case TOK_LE: op = OP_LE; break;
+        case TOK_GT: op = OP_GT; break;
+        case TOK_GE: op = OP_GE; break;
+        default: return;
+    }
+    parser_next(p);
+    parse_sum(p);
+
+    float hysteresis = 0.0f;
+    if (!p->failed && tok_is(p, "hyst")) {
+        parser_next(p);
+        // A huge value overflows to inf, and 0 * inf would make the rule never raise
+        if (p->tok != TOK_NUMBER || p->tok_suffix_len != 0 || !isfinite(p->tok_number)) {
+            parser_fail(p, "expected hysteresis value");
+            return;
+        }
+        hysteresis = p->tok_number;
+        parser_next(p);
+    }
+    emit_u8(p, op);
+    emit_f32(p, hysteresis);
+    stack_pop(p);
+}
+
+static void parse_not(alarm_parser_t* p) {
+    if (p->failed) return;
+    if (tok_is(p, "not")) {
+        if (!parser_enter(p)) return;
+        parser_next(p);
+        parse_not(p);
+        emit_u8(p, OP_NOT);
+        p->nesting--;
+        return;
+    }
+    parse_comparison(p);
+}
+
+static void parse_and(alarm_parser_t* p) {
+    parse_not(p);
+    while (!p->failed && tok_is(p, "and")) {
+        parser_next(p);
+        parse_not(p);
+        emit_u8(p, OP_AND);
+        stack_pop(p);
+    }
+}
+
+static void parse_or(alarm_parser_t* p) {
+    parse_and(p);
+    while (!p->failed && tok_is(p, "or")) {
+        parser_next(p);
+        parse_and(p);
+        emit_u8(p, OP_OR);
+        stack_pop(p);
+    }
+}
+
+/**
+ * @brief Parse "<name>: <expr> [for <dur>] [hold <dur>] [warn|crit]"
+ */
+static void parse_rule(alarm_parser_t* p) {
+    alarm_program_t* program = p->program;
+    if (program->rule_count >= ALARM_MAX_RULES) {
+        parser_fail(p, "too many rules");
+        return;
+    }
+    if (p->tok != TOK_IDENT) {
+        parser_fail(p, "expected rule name");
+        return;
+    }
+    if (p->tok_len >= ALARM_NAME_LEN) {
+        parser_fail(p, "rule name too long (max 15)");
+        return;
+    }
+
+    alarm_rule_t* rule = &program->rules[program->rule_count];
+    memset(rule, 0, sizeof(*rule));
+    memcpy(rule->name, p->tok_start, p->tok_len);
+    rule->name[p->tok_len] = '\0';
+    rule->severity = AlarmSeverity::WARNING;
+    rule->last_value = NAN;
+    for (int i = 0; i < program->rule_count; i++) {
+        if (strcmp(program->rules[i].name, rule->name) == 0) {
+            parser_fail(p, "duplicate rule name");
+            return;
+        }
+    }
+    parser_next(p);
+    parser_expect(p, TOK_COLON, "expected ':' after rule name");
+
+    rule->code_offset = program->code_used;
+    p->depth = 0;
+    p->nesting = 0;
+    parse_or(p);
+    if (p->failed) return;
+    rule->code_length = (uint16_t)(program->code_used - rule->code_offset);
+
+    while (!p->failed && p->tok == TOK_IDENT) {
+        if (tok_is(p, "for")) {
+            parser_next(p);
+            rule->raise_delay_ms = parse_duration(p);
+        } else if (tok_is(p, "hold")) {
+            parser_next(p);
+            rule->clear_delay_ms = parse_duration(p);
+        } else if (tok_is(p, "warn")) {
+            rule->severity = AlarmSeverity::WARNING;
+            parser_next(p);
+        } else if (tok_is(p, "crit")) {
+            rule->severity = AlarmSeverity::CRITICAL;
+            parser_next(p);
+        } else {
+            parser_fail(p, "unexpected word (expected for, hold, warn or crit)");
+        }
+    }
+    if (!p->failed && p->tok != TOK_SEP && p->tok != TOK_EOF) {
+        parser_fail(p, "unexpected token after rule");
+        return;
+    }
+    if (!p->failed) program->rule_count++;
+}
+
+/**
+ * @brief Compile a rule set into bytecode
+ * @param text Rule text (see alarms.h for the syntax)
+ * @param program Destination; reset before compiling
+ * @param error Optional diagnostics for the first error
+ * @return true if every rule compiled
+ */
+bool alarm_compile(const char* text, alarm_program_t* program, alarm_compile_error_t* error) {
+    program->rule_count = 0;
+    program->code_used = 0;
+
+    alarm_parser_t p;
+    memset(&p, 0, sizeof(p));
+    p.pos = text;
+    p.line_start = text;
+    p.line = 1;
+    p.program = program;
+    p.error = error;
+
+    parser_next(&p);
+    while (!p.failed && p.tok != TOK_EOF) {
+        if (p.tok == TOK_SEP) {
+            parser_next(&p);
+            continue;
+        }
+        parse_rule(&p);
+    }
+    if (p.failed) {
+        program->rule_count = 0;
+        program->code_used = 0;
+        return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// ROLLING STATISTICS
+//=============================================================================
+
+/**
+ * @brief Clear history; the first slot starts at now
+ */
+void alarm_history_reset(alarm_history_t* history, uint32_t now) {
+    for (int c = 0; c < ALARM_HISTORY_CHANNELS; c++) {
+        for (int s = 0; s < ALARM_HISTORY_SLOTS; s++) {
+            history->slots[c][s] = NAN;
+        }
+        history->sum[c] = 0.0f;
+    }
+    history->head = 0;
+    history->count = 0;
+    history->samples = 0;
+    history->slot_start = now;
+}
+
+/**
+ * @brief Add one reading; closes finished one-minute slots first
+ * Minutes without readings (ERROR/MAINTENANCE) are stored as NaN so
+ * statistics spanning the gap read as "unknown" rather than stale.
+ */
+void alarm_history_push(alarm_history_t* history, const alarm_inputs_t* inputs) {
+    uint32_t now = inputs->timestamp;
+    if (now - history->slot_start >= ALARM_HISTORY_PERIOD_MS * ALARM_HISTORY_SLOTS) {
+        alarm_history_reset(history, now);
+    }
+    while (now - history->slot_start >= ALARM_HISTORY_PERIOD_MS) {
+        for (int c = 0; c < ALARM_HISTORY_CHANNELS; c++) {
+            history->slots[c][history->head] = history->samples > 0 ? history->sum[c] / history->samples : NAN;
+            history->sum[c] = 0.0f;
+        }
+        history->samples = 0;
+        history->head = (uint16_t)((history->head + 1) % ALARM_HISTORY_SLOTS);
+        if (history->count < ALARM_HISTORY_SLOTS) history->count++;
+        history->slot_start += ALARM_HISTORY_PERIOD_MS;
+    }
+    for (int c = 0; c < ALARM_HISTORY_CHANNELS; c++) {
+        history->sum[c] += inputs->values[c];
+    }
+    history->samples++;
+}
+
+// Completed slot `back` minutes ago (1 = most recent)
+static inline float history_slot(const alarm_history_t* history, int channel, int back) {
+    return history->slots[channel][(history->head + ALARM_HISTORY_SLOTS - back) % ALARM_HISTORY_SLOTS];
+}
+
+static float history_stat(const alarm_history_t* history, uint8_t fn, uint8_t channel, uint8_t slots,
+                          const alarm_inputs_t* inputs) {
+    if (history->count < slots) return NAN;   // Not enough history yet
+
+    float now = inputs->values[channel];
+    switch (fn) {
+        case HIST_DELTA:
+            return now - history_slot(history, channel, slots);
+        case HIST_RATE:
+            return (now - history_slot(history, channel, slots)) * (3600000.0f / (slots * ALARM_HISTORY_PERIOD_MS));
+        case HIST_PCT: {
+            float old = history_slot(history, channel, slots);
+            return old != 0.0f ? 100.0f * (now - old) / fabsf(old) : NAN;
+        }
+        case HIST_AVG: {
+            float sum = 0.0f;
+            for (int b = 1; b <= slots; b++) sum += history_slot(history, channel, b);
+            return sum / slots;
+        }
+        case HIST_MIN:
+        case HIST_MAX: {
+            // fminf/fmaxf skip NaN; a gap in the window must read as unknown, as for avg
+            float m = history_slot(history, channel, 1);
+            for (int b = 1; b <= slots; b++) {
+                float v = history_slot(history, channel, b);
+                if (isnan(v)) return NAN;
+                m = fn == HIST_MIN ? fminf(m, v) : fmaxf(m, v);
+            }
+            return m;
+        }
+        default:
+            return NAN;
+    }
+}
+
+//=============================================================================
+// EVALUATOR
+//=============================================================================
+
+static inline bool alarm_truthy(float v) {
+    return v != 0.0f && !isnan(v);
+}
+
+static inline float read_f32(const uint8_t* ip) {
+    float v;
+    memcpy(&v, ip, sizeof(float));
+    return v;
+}
+
+/**
+ * @brief Run one rule's bytecode
+ * Comparisons are relaxed by their hysteresis while the rule is active, so
+ * "ph < 5.2 hyst 0.1" stays raised until pH reaches 5.3.
+ * @param observed Optional; receives the left operand of the last comparison
+ * @return Expression value (NaN when inputs or history are unavailable)
+ */
+float alarm_evaluate(const alarm_program_t* program, const alarm_rule_t* rule,
+                     const alarm_inputs_t* inputs, const alarm_history_t* history, float* observed) {
+    float stack[ALARM_STACK_DEPTH];
+    float lhs = NAN;
+    int sp = 0;
+    const uint8_t* ip = program->code + rule->code_offset;
+    const uint8_t* end = ip + rule->code_length;
+    const float relax = rule->active ? 1.0f : 0.0f;
+
+    while (ip < end) {
+        switch (*ip++) {
+            case OP_CONST: stack[sp++] = read_f32(ip); ip += 4; break;
+            case OP_LOAD:  stack[sp++] = inputs->values[*ip++]; break;
+            case OP_HIST:  stack[sp++] = history_stat(history, ip[0], ip[1], ip[2], inputs); ip += 3; break;
+            case OP_ADD:   sp--; stack[sp - 1] += stack[sp]; break;
+            case OP_SUB:   sp--; stack[sp - 1] -= stack[sp]; break;
+            case OP_MUL:   sp--; stack[sp - 1] *= stack[sp]; break;
+            case OP_DIV:   sp--; stack[sp - 1] = stack[sp] != 0.0f ? stack[sp - 1] / stack[sp] : NAN; break;
+            case OP_NEG:   stack[sp - 1] = -stack[sp - 1]; break;
+            case OP_ABS:   stack[sp - 1] = fabsf(stack[sp - 1]); break;
+            case OP_LT:    sp--; lhs = stack[sp - 1]; stack[sp - 1] = lhs <  stack[sp] + relax * read_f32(ip) ? 1.0f : 0.0f; ip += 4; break;
+            case OP_LE:    sp--; lhs = stack[sp - 1]; stack[sp - 1] = lhs <= stack[sp] + relax * read_f32(ip) ? 1.0f : 0.0f; ip += 4; break;
+            case OP_GT:    sp--; lhs = stack[sp - 1]; stack[sp - 1] = lhs >  stack[sp] - relax * read_f32(ip) ? 1.0f : 0.0f; ip += 4; break;
+            case OP_GE:    sp--; lhs = stack[sp - 1]; stack[sp - 1] = lhs >= stack[sp] - relax * read_f32(ip) ? 1.0f : 0.0f; ip += 4; break;
+            case OP_AND:   sp--; stack[sp - 1] = alarm_truthy(stack[sp - 1]) && alarm_truthy(stack[sp]) ? 1.0f : 0.0f; break;
+            case OP_OR:    sp--; stack[sp - 1] = alarm_truthy(stack[sp - 1]) || alarm_truthy(stack[sp]) ? 1.0f : 0.0f; break;
+            case OP_NOT:   stack[sp - 1] = alarm_truthy(stack[sp - 1]) ? 0.0f : 1.0f; break;
+            default:       return NAN;   // Not produced by alarm_compile()
+        }
+    }
+    if (observed) *observed = isnan(lhs) && sp > 0 ? stack[sp - 1] : lhs;
+    return sp > 0 ? stack[sp - 1] : NAN;
+}
+
+/**
+ * @brief Evaluate every rule and apply hold timers
+ * @param events Receives raise/clear transitions
+ * @return Number of events written
+ */
+int alarm_program_step(alarm_program_t* program, const alarm_inputs_t* inputs,
+                       const alarm_history_t* history, alarm_event_t* events, int max_events) {
+    uint32_t now = inputs->timestamp;
+    int event_count = 0;
+
+    for (int i = 0; i < program->rule_count; i++) {
+        alarm_rule_t* rule = &program->rules[i];
+        float observed;
+        bool condition = alarm_truthy(alarm_evaluate(program, rule, inputs, history, &observed));
+        rule->last_value = observed;
+
+        if (condition != rule->condition) {
+            rule->condition = condition;
+            rule->condition_since = now;
+        }
+        uint32_t held = now - rule->condition_since;
+
+        bool transition = false;
+        if (!rule->active && condition && held >= rule->raise_delay_ms) {
+            rule->active = true;
+            rule->raised_at = now;
+            rule->raise_count++;
+            transition = true;
+        } else if (rule->active && !condition && held >= rule->clear_delay_ms) {
+            rule->active = false;
+            transition = true;
+        }
+
+        if (transition && event_count < max_events) {
+            alarm_event_t* event = &events[event_count++];
+            event->name = rule->name;
+            event->severity = rule->severity;
+            event->raised = rule->active;
+            event->value = observed;
+            event->timestamp = now;
+        }
+    }
+    return event_count;
+}
+
+/**
+ * @brief Print one rule's bytecode, one instruction per line
+ */
+void alarm_disassemble(const alarm_program_t* program, int rule_index,
+                       void (*emit)(const char* line, void* ctx), void* ctx) {
+    static const char* const kOpNames[] = {
+        "?", "CONST", "LOAD", "HIST", "ADD", "SUB", "MUL", "DIV", "NEG", "ABS",
+        "LT", "LE", "GT", "GE", "AND", "OR", "NOT"
+    };
+    if (rule_index < 0 || rule_index >= program->rule_count) return;
+
+    const alarm_rule_t* rule = &program->rules[rule_index];
+    const uint8_t* start = program->code + rule->code_offset;
+    const uint8_t* ip = start;
+    const uint8_t* end = start + rule->code_length;
+    char line[64];
+
+    while (ip < end) {
+        int offset = (int)(ip - start);
+        uint8_t op = *ip++;
+        const char* name = op < sizeof(kOpNames) / sizeof(kOpNames[0]) ? kOpNames[op] : "?";
+        switch (op) {
+            case OP_CONST:
+                snprintf(line, sizeof(line), "%04d %-5s %g", offset, name, read_f32(ip));
+                ip += 4;
+                break;
+            case OP_LOAD:
+                snprintf(line, sizeof(line), "%04d %-5s %s", offset, name, kAlarmVarNames[*ip]);
+                ip += 1;
+                break;
+            case OP_HIST:
+                snprintf(line, sizeof(line), "%04d %-5s %s(%s, %um)", offset, name,
+                         kHistFunctionNames[ip[0]], kAlarmVarNames[ip[1]], ip[2]);
+                ip += 3;
+                break;
+            case OP_LT: case OP_LE: case OP_GT: case OP_GE:
+                snprintf(line, sizeof(line), "%04d %-5s hyst %g", offset, name, read_f32(ip));
+                ip += 4;
+                break;
+            default:
+                snprintf(line, sizeof(line), "%04d %s", offset, name);
+                break;
+        }
+        emit(line, ctx);
+    }
+}
+
+const char* alarm_severity_to_string(AlarmSeverity severity) {
+    return severity == AlarmSeverity::CRITICAL ? "crit" : "warn";
+}
+
+//=============================================================================
+// FIRMWARE ALARM ENGINE
+//=============================================================================
+
+static alarm_program_t alarm_program;
+static alarm_history_t alarm_history;
+static alarm_event_t alarm_events[ALARM_MAX_RULES];
+static char alarm_rules_text[ALARM_RULES_TEXT_MAX];
+static alarm_sink_t alarm_sinks[ALARM_MAX_SINKS];
+static uint8_t alarm_sink_count = 0;
+
+static void alarm_print_compile_error(const alarm_compile_error_t& error) {
+    Debug->printf("Alarm rules: line %d col %d: %s", error.line, error.column, error.message);
+}
+
+/**
+ * @brief Publish one transition to the console and every registered sink
+ * Also used by monitors outside the rule set (volume balance leak alarm).
+ */
+void alarm_publish(const alarm_event_t& event) {
+    Debug->printf("ALARM %s %s [%s] value=%.3f", event.raised ? "RAISED" : "CLEARED",
+                  event.name, alarm_severity_to_string(event.severity), event.value);
+    for (int i = 0; i < alarm_sink_count; i++) {
+        alarm_sinks[i](event);
+    }
+}
+
+/**
+ * @brief Load the stored rule set (or the defaults) and compile it
+ * @return true if the stored rules compiled (false means defaults are active)
+ */
+bool alarm_init(void) {
+    bool stored_ok = false;
+    alarm_compile_error_t error;
+
+    Preferences store;
+    size_t len = 0;
+    if (store.begin(ALARM_NVS_NAMESPACE, true)) {
+        len = store.getBytesLength(ALARM_NVS_RULES_KEY);
+        if (len > 0 && len < ALARM_RULES_TEXT_MAX &&
+            store.getBytes(ALARM_NVS_RULES_KEY, alarm_rules_text, len) == len) {
+            alarm_rules_text[len] = '\0';
+        } else {
+            len = 0;
+        }
+        store.end();
+    }
+
+    if (len > 0) {
+        stored_ok = alarm_compile(alarm_rules_text, &alarm_program, &error);
+        if (!stored_ok) {
+            Debug->println("ERROR: Stored alarm rules invalid - using defaults");
+            alarm_print_compile_error(error);
+        }
+    }
+    if (!stored_ok) {
+        strncpy(alarm_rules_text, kDefaultAlarmRules, sizeof(alarm_rules_text) - 1);
+        alarm_rules_text[sizeof(alarm_rules_text) - 1] = '\0';
+        alarm_compile(alarm_rules_text, &alarm_program, &error);
+    }
+
+    alarm_history_reset(&alarm_history, millis());
+    Debug->printf("Alarm engine: %d rules, %d/%d bytes bytecode (%s)", alarm_program.rule_count,
+                  alarm_program.code_used, ALARM_CODE_SIZE, stored_ok ? "stored" : "defaults");
+    return stored_ok;
+}
+
+/**
+ * @brief Evaluate all rules against one reading and publish transitions
+ * @param readings Filtered sensor readings for this cycle
+ */
+void alarm_update(const sensor_readings_t& readings) {
+    alarm_inputs_t inputs;
+    inputs.values[static_cast<int>(AlarmVar::PH)] = readings.ph;
+    inputs.values[static_cast<int>(AlarmVar::EC)] = readings.ec;
+    inputs.values[static_cast<int>(AlarmVar::VOLUME)] = readings.volume;
+    inputs.values[static_cast<int>(AlarmVar::TEMP)] = readings.temperature;
+    inputs.values[static_cast<int>(AlarmVar::PH_DOSED)] =
+        pump_get_total_dosed(PumpId::PH_UP) + pump_get_total_dosed(PumpId::PH_DOWN);
+    inputs.values[static_cast<int>(AlarmVar::AUTO_PH)] = pump_is_auto_ph_enabled() ? 1.0f : 0.0f;
+    const volume_balance_t* balance = volume_balance_get();
+    inputs.values[static_cast<int>(AlarmVar::LOSS_RATE)] = balance->settled ? balance->loss_rate : 0.0f;
+    inputs.values[static_cast<int>(AlarmVar::EXCESS_LOSS)] = balance->settled ? balance->excess : 0.0f;
+    inputs.timestamp = readings.timestamp;
+
+    alarm_history_push(&alarm_history, &inputs);
+    int count = alarm_program_step(&alarm_program, &inputs, &alarm_history, alarm_events, ALARM_MAX_RULES);
+    for (int i = 0; i < count; i++) {
+        alarm_publish(alarm_events[i]);
+    }
+}
+
+/**
+ * @brief Register an additional event sink (telemetry, network, ...)
+ * @return false if all sink slots are taken
+ */
+bool alarm_add_sink(alarm_sink_t sink) {
+    if (sink == nullptr || alarm_sink_count >= ALARM_MAX_SINKS) {
+        return false;
+    }
+    for (int i = 0; i < alarm_sink_count; i++) {
+        if (alarm_sinks[i] == sink) return true;
+    }
+    alarm_sinks[alarm_sink_count++] = sink;
+    return true;
+}
+
+/**
+ * @brief Compile and activate a new rule set, then store it in NVS
+ * The set is compiled aside and swapped in only if it compiles, so a
+ * compile error leaves the active rules, their timers and raised alarms
+ * untouched and stores nothing. Rule state restarts with a new set; alarms
+ * raised by the replaced set are published as cleared first.
+ */
+bool alarm_set_rules(const char* text) {
+    static alarm_program_t compiled;   // Too large for the loop task's stack
+    alarm_compile_error_t error;
+    if (strlen(text) >= ALARM_RULES_TEXT_MAX) {
+        Debug->println("ERROR: Alarm rule text too long");
+        return false;
+    }
+    if (!alarm_compile(text, &compiled, &error)) {
+        alarm_print_compile_error(error);
+        return false;
+    }
+
+    uint32_t now = millis();
+    for (int i = 0; i < alarm_program.rule_count; i++) {
+        const alarm_rule_t& rule = alarm_program.rules[i];
+        if (!rule.active) continue;
+        alarm_event_t event;
+        event.name = rule.name;
+        event.severity = rule.severity;
+        event.raised = false;
+        event.value = rule.last_value;
+        event.timestamp = now;
+        alarm_publish(event);
+    }
+    alarm_program = compiled;
+    strncpy(alarm_rules_text, text, sizeof(alarm_rules_text) - 1);
+    alarm_rules_text[sizeof(alarm_rules_text) - 1] = '\0';
+
+    Preferences store;
+    if (!store.begin(ALARM_NVS_NAMESPACE, false) ||
+        store.putBytes(ALARM_NVS_RULES_KEY, alarm_rules_text, strlen(alarm_rules_text) + 1) == 0) {
+        Debug->println("ERROR: Failed to store alarm rules (active until reboot)");
+    }
+    store.end();
+
+    Debug->printf("Alarm rules active: %d rules, %d/%d bytes bytecode", alarm_program.rule_count,
+                  alarm_program.code_used, ALARM_CODE_SIZE);
+    return true;
+}
+
+/**
+ * @brief Enter a rule set line by line; "end" finishes, '.' restores defaults
+ * Each line blocks loop() for up to ALARM_LINE_TIMEOUT_MS, so entry is
+ * refused while a pump runs: its stop time is kept by loop().
+ */
+void alarm_interactive_rules(void) {
+    static char text[ALARM_RULES_TEXT_MAX];
+    char line[128];
+    size_t used = 0;
+
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        if (pump_is_running(static_cast<PumpId>(i))) {
+            Debug->println("ERROR: A pump is running - stop it ('x') before entering alarm rules");
+            return;
+        }
+    }
+
+    Debug->println("Enter alarm rules, one per line (10s each; 'end' = done, '.' = defaults):");
+    Debug->println("  e.g. ph_low: ph < 5.2 hyst 0.1 for 10m hold 2m crit");
+    text[0] = '\0';
+
+    while (true) {
+        if (!Debug->read_line(line, sizeof(line), ALARM_LINE_TIMEOUT_MS)) {
+            Debug->println("Alarm rule entry timed out - rules unchanged");
+            return;
+        }
+        if (strcmp(line, "end") == 0) break;
+        if (strcmp(line, ".") == 0) {
+            alarm_set_rules(kDefaultAlarmRules);
+            return;
+        }
+        size_t len = strlen(line);
+        if (used + len + 2 > sizeof(text)) {
+            Debug->println("ERROR: Alarm rule text too long - rules unchanged");
+            return;
+        }
+        memcpy(text + used, line, len);
+        used += len;
+        text[used++] = '\n';
+        text[used] = '\0';
+    }
+
+    if (used == 0) {
+        Debug->println("No rules entered - rules unchanged");
+        return;
+    }
+    alarm_set_rules(text);
+}
+
+/**
+ * @brief Print every rule with its state and last value
+ */
+void alarm_print_status(void) {
+    Debug->printf("Alarm rules: %d (%d/%d bytes bytecode), %d active", alarm_program.rule_count,
+                  alarm_program.code_used, ALARM_CODE_SIZE, alarm_active_count());
+    for (int i = 0; i < alarm_program.rule_count; i++) {
+        const alarm_rule_t& rule = alarm_program.rules[i];
+        Debug->printf("  %-15s %s %-7s raised=%u value=%.3f", rule.name, alarm_severity_to_string(rule.severity),
+                      rule.active ? "ACTIVE" : "ok", rule.raise_count, rule.last_value);
+    }
+}
+
+int alarm_active_count(void) {
+    int count = 0;
+    for (int i = 0; i < alarm_program.rule_count; i++) {
+        if (alarm_program.rules[i].active) count++;
+    }
+    return count;
+}
@@ -0,0 +1,494 @@
+/**
+ * @file binlog.cpp
+ * @brief Deferred-formatting binary logger implementation
+ * @author Arduino Developer
+ * @date 2025
+ *
+ * The ring is a bounded MPSC queue with one sequence word per slot: a slot
+ * whose sequence equals the write index is free, index + 1 means published,
+ * and the consumer hands it back as index + BINLOG_RING_SIZE. Producers claim
+ * an index with compare-and-swap, so an ISR that interrupts a producer
+ * between claim and publish just takes the next slot; the drain stops at an
+ * unpublished slot and picks it up on a later pass.
+ */
+
+#include "binlog.h"
+#include "communication.h"
+
+#include <atomic>
+
+static_assert((BINLOG_RING_SIZE & (BINLOG_RING_SIZE - 1)) == 0, "BINLOG_RING_SIZE must be a power of two");
+static_assert((BINLOG_HISTORY_BYTES & (BINLOG_HISTORY_BYTES - 1)) == 0, "BINLOG_HISTORY_BYTES must be a power of two");
+
+//=============================================================================
+// RING AND SINK STATE
+//=============================================================================
+
+struct binlog_slot_t {
+    std::atomic<uint32_t> seq;
+    binlog_record_t record;
+};
+
+static binlog_slot_t ring[BINLOG_RING_SIZE];
+static std::atomic<uint32_t> write_index{0};
+static std::atomic<uint32_t> dropped_count{0};
+static uint32_t read_index = 0;
+static uint32_t dropped_reported = 0;
+static uint32_t high_water = 0;
+
+static binlog_text_sink_t text_sinks[BINLOG_MAX_SINKS];
+static uint8_t text_sink_count = 0;
+static binlog_raw_sink_t raw_sinks[BINLOG_MAX_SINKS];
+static uint8_t raw_sink_count = 0;
+
+// Raw stream string dictionary (ids are slots, recycled round-robin)
+static const char* raw_dict[BINLOG_DICT_SIZE];
+static uint16_t raw_dict_next = 0;
+
+// Flight recorder: [history_oldest, history_end) holds whole entries
+static uint8_t history[BINLOG_HISTORY_BYTES];
+static uint32_t history_oldest = 0;
+static uint32_t history_end = 0;
+
+//=============================================================================
+// PRODUCER
+//=============================================================================
+
+/**
+ * @brief Queue one record; drops it (and counts the drop) if the ring is full
+ * @param fmt Format string (must outlive the drain)
+ * @param args Argument words from binlog_word()
+ * @param argc Number of argument words
+ * @return false if the record was dropped
+ */
+IRAM_ATTR bool binlog_push(const char* fmt, const binlog_word_t* args, uint8_t argc) {
+    uint32_t index = write_index.load(std::memory_order_relaxed);
+    binlog_slot_t* slot;
+    for (;;) {
+        slot = &ring[index & (BINLOG_RING_SIZE - 1)];
+        int32_t lag = (int32_t)(slot->seq.load(std::memory_order_acquire) - index);
+        if (lag == 0) {
+            if (write_index.compare_exchange_weak(index, index + 1, std::memory_order_relaxed)) break;
+        } else if (lag < 0) {
+            dropped_count.fetch_add(1, std::memory_order_relaxed);   // Consumer a full ring behind
+            return false;
+        } else {
+            index = write_index.load(std::memory_order_relaxed);     // Another producer took it
+        }
+    }
+
+    if (argc > BINLOG_MAX_ARGS) argc = BINLOG_MAX_ARGS;
+    slot->record.fmt = fmt;
+    slot->record.timestamp_us = micros();
+    slot->record.argc = argc;
+    for (uint8_t i = 0; i < argc; i++) {
+        slot->record.args[i] = args[i];
+    }
+    slot->seq.store(index + 1, std::memory_order_release);
+    return true;
+}
+
+//=============================================================================
+// FORMATTING
+//=============================================================================
+
+/**
+ * @brief Copy one conversion spec ("%-8.3f") and return its conversion char
+ * Length modifiers are dropped: every argument is a 32-bit word or a float.
+ * @param p Points at the '%'
+ * @param spec Receives the spec without length modifiers
+ * @param end Receives the position after the spec
+ */
+static char scan_spec(const char* p, char* spec, size_t spec_len, const char** end) {
+    size_t n = 0;
+    spec[n++] = *p++;
+    while (*p && strchr("-+ #0123456789.", *p) && n < spec_len - 2) {
+        spec[n++] = *p++;
+    }
+    while (*p && strchr("hlLzjtq", *p)) p++;
+    char conv = *p;
+    if (conv) {
+        spec[n++] = conv;
+        p++;
+    }
+    spec[n] = '\0';
+    *end = p;
+    return conv;
+}
+
+static bool is_int_conv(char c) { return c && strchr("diuxXoc", c); }
+static bool is_float_conv(char c) { return c && strchr("fFeEgGaA", c); }
+
+static float word_to_float(binlog_word_t word) {
+    uint32_t bits = (uint32_t)word;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static const char* pointer_string(binlog_word_t word, void* ctx) {
+    (void)ctx;
+    return reinterpret_cast<const char*>(word);
+}
+
+/**
+ * @brief Format a record like snprintf would have at the call site
+ * Missing arguments print as "?"; unsupported conversions are copied as text.
+ * @return Length of the formatted text (truncated to out_len - 1)
+ */
+size_t binlog_format(char* out, size_t out_len, const char* fmt, const binlog_word_t* args, uint8_t argc,
+                     binlog_string_fn string_at, void* ctx) {
+    size_t pos = 0;
+    uint8_t arg = 0;
+    if (out_len == 0) return 0;
+
+    const char* p = fmt;
+    while (*p && pos < out_len - 1) {
+        if (*p != '%') {
+            out[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[pos++] = '%';
+            p += 2;
+            continue;
+        }
+
+        char spec[24];
+        const char* next;
+        char conv = scan_spec(p, spec, sizeof(spec), &next);
+        bool known = is_int_conv(conv) || is_float_conv(conv) || conv == 's';
+        int written;
+        if (!known) {
+            written = snprintf(out + pos, out_len - pos, "%.*s", (int)(next - p), p);
+        } else if (arg >= argc) {
+            written = snprintf(out + pos, out_len - pos, "?");
+        } else if (is_float_conv(conv)) {
+            written = snprintf(out + pos, out_len - pos, spec, (double)word_to_float(args[arg++]));
+        } else if (conv == 's') {
+            const char* text = string_at(args[arg++], ctx);
+            written = snprintf(out + pos, out_len - pos, spec, text ? text : "(null)");
+        } else if (conv == 'd' || conv == 'i') {
+            written = snprintf(out + pos, out_len - pos, spec, (int)(int32_t)(uint32_t)args[arg++]);
+        } else {
+            written = snprintf(out + pos, out_len - pos, spec, (unsigned)(uint32_t)args[arg++]);
+        }
+        if (written > 0) {
+            pos += (size_t)written;
+            if (pos > out_len - 1) pos = out_len - 1;
+        }
+        p = next;
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+//=============================================================================
+// RAW STREAM
+//=============================================================================
+
+static void raw_publish(const uint8_t* data, size_t len) {
+    for (int i = 0; i < raw_sink_count; i++) {
+        raw_sinks[i](data, len);
+    }
+}
+
+static size_t put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return 2;
+}
+
+static size_t put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+    return 4;
+}
+
+/**
+ * @brief Dictionary id of a string, defining it in the stream when new
+ * Slots are recycled round-robin, skipping the ids the current record
+ * already uses so a record never evicts its own format or arguments.
+ * @param pinned Ids taken by the current record
+ * @param pinned_count Number of pinned ids
+ */
+static uint16_t raw_string_id(const char* text, const uint16_t* pinned, int pinned_count) {
+    if (!text) text = "(null)";
+    for (uint16_t id = 0; id < BINLOG_DICT_SIZE; id++) {
+        if (raw_dict[id] == text) return id;
+    }
+
+    uint16_t id;
+    bool taken;
+    do {
+        id = raw_dict_next;
+        raw_dict_next = (raw_dict_next + 1) % BINLOG_DICT_SIZE;
+        taken = false;
+        for (int i = 0; i < pinned_count; i++) {
+            if (pinned[i] == id) taken = true;
+        }
+    } while (taken);
+    raw_dict[id] = text;
+
+    uint8_t frame[5 + BINLOG_LINE_MAX];
+    size_t len = strlen(text);
+    if (len > BINLOG_LINE_MAX) len = BINLOG_LINE_MAX;
+    size_t n = 0;
+    frame[n++] = BINLOG_FRAME_STRING;
+    n += put_u16(frame + n, id);
+    n += put_u16(frame + n, (uint16_t)len);
+    memcpy(frame + n, text, len);
+    raw_publish(frame, n + len);
+    return id;
+}
+
+/**
+ * @brief Encode one record as an 'R' frame (after any 'S' frames it needs)
+ */
+static void raw_publish_record(const binlog_record_t& record) {
+    uint16_t pinned[1 + BINLOG_MAX_ARGS] = {};
+    int pinned_count = 0;
+
+    uint8_t frame[8 + 4 * BINLOG_MAX_ARGS];
+    size_t n = 0;
+    frame[n++] = BINLOG_FRAME_RECORD;
+    pinned[pinned_count] = raw_string_id(record.fmt, pinned, pinned_count);
+    n += put_u16(frame + n, pinned[pinned_count++]);
+    n += put_u32(frame + n, record.timestamp_us);
+    frame[n++] = record.argc;
+
+    // Walk the conversions so %s arguments travel as dictionary ids
+    uint8_t arg = 0;
+    const char* p = record.fmt;
+    while (*p && arg < record.argc) {
+        if (*p != '%') { p++; continue; }
+        if (p[1] == '%') { p += 2; continue; }
+        char spec[24];
+        char conv = scan_spec(p, spec, sizeof(spec), &p);
+        if (conv == 's') {
+            const char* text = reinterpret_cast<const char*>(record.args[arg++]);
+            pinned[pinned_count] = raw_string_id(text, pinned, pinned_count);
+            n += put_u32(frame + n, pinned[pinned_count++]);
+        } else if (is_int_conv(conv) || is_float_conv(conv)) {
+            n += put_u32(frame + n, (uint32_t)record.args[arg++]);
+        }
+    }
+    while (arg < record.argc) {
+        n += put_u32(frame + n, (uint32_t)record.args[arg++]);
+    }
+    raw_publish(frame, n);
+}
+
+//=============================================================================
+// CONSUMER
+//=============================================================================
+
+static uint8_t history_at(uint32_t pos) {
+    return history[pos & (BINLOG_HISTORY_BYTES - 1)];
+}
+
+/**
+ * @brief Append a line to the flight recorder, evicting the oldest entries
+ */
+static void history_append(uint32_t timestamp_us, const char* text) {
+    size_t len = strlen(text);
+    if (len > 255) len = 255;
+    uint32_t entry_len = (uint32_t)(BINLOG_HISTORY_ENTRY_HEADER + len);
+    while (history_end - history_oldest + entry_len > BINLOG_HISTORY_BYTES) {
+        history_oldest += BINLOG_HISTORY_ENTRY_HEADER + history_at(history_oldest + 4);
+    }
+
+    uint8_t header[BINLOG_HISTORY_ENTRY_HEADER];
+    put_u32(header, timestamp_us);
+    header[4] = (uint8_t)len;
+    for (size_t i = 0; i < BINLOG_HISTORY_ENTRY_HEADER; i++) {
+        history[(history_end + i) & (BINLOG_HISTORY_BYTES - 1)] = header[i];
+    }
+    for (size_t i = 0; i < len; i++) {
+        history[(history_end + BINLOG_HISTORY_ENTRY_HEADER + i) & (BINLOG_HISTORY_BYTES - 1)] = (uint8_t)text[i];
+    }
+    history_end += entry_len;
+}
+
+static void publish_text(const binlog_record_t& record, const char* text) {
+    history_append(record.timestamp_us, text);
+    if (Debug) {
+        Debug->println(text);
+    } else {
+        Serial.println(text);
+    }
+    for (int i = 0; i < text_sink_count; i++) {
+        text_sinks[i](record, text);
+    }
+}
+
+/**
+ * @brief Empty the ring and reset counters and sinks (not from a producer context)
+ */
+void binlog_init(void) {
+    for (int i = 0; i < BINLOG_RING_SIZE; i++) {
+        ring[i].seq.store((uint32_t)i, std::memory_order_relaxed);
+    }
+    write_index.store(0, std::memory_order_relaxed);
+    dropped_count.store(0, std::memory_order_relaxed);
+    read_index = 0;
+    dropped_reported = 0;
+    high_water = 0;
+    text_sink_count = 0;
+    raw_sink_count = 0;
+    memset(raw_dict, 0, sizeof(raw_dict));
+    raw_dict_next = 0;
+    history_oldest = 0;
+    history_end = 0;
+}
+
+/**
+ * @brief Format and publish pending records (main loop only)
+ * Reports drops since the last drain first, then up to max_records records.
+ * @return Records published
+ */
+int binlog_drain(int max_records) {
+    uint32_t pending = write_index.load(std::memory_order_relaxed) - read_index;
+    if (pending > high_water) high_water = pending;
+
+    uint32_t dropped = dropped_count.load(std::memory_order_relaxed);
+    if (dropped != dropped_reported) {
+        uint32_t lost = dropped - dropped_reported;
+        dropped_reported = dropped;
+
+        binlog_record_t note = {};
+        note.fmt = "[LOG] %u records dropped (ring full)";
+        note.timestamp_us = micros();
+        note.argc = 1;
+        note.args[0] = lost;
+        char text[48];
+        binlog_format(text, sizeof(text), note.fmt, note.args, note.argc, pointer_string, nullptr);
+        publish_text(note, text);
+        if (raw_sink_count > 0) {
+            uint8_t frame[5];
+            frame[0] = BINLOG_FRAME_DROPPED;
+            put_u32(frame + 1, lost);
+            raw_publish(frame, sizeof(frame));
+        }
+    }
+
+    int published = 0;
+    while (published < max_records) {
+        binlog_slot_t* slot = &ring[read_index & (BINLOG_RING_SIZE - 1)];
+        if (slot->seq.load(std::memory_order_acquire) != read_index + 1) {
+            break;                                     // Empty, or the next record is still being written
+        }
+        binlog_record_t record = slot->record;
+        slot->seq.store(read_index + BINLOG_RING_SIZE, std::memory_order_release);
+        read_index++;
+
+        char text[BINLOG_LINE_MAX];
+        binlog_format(text, sizeof(text), record.fmt, record.args, record.argc, pointer_string, nullptr);
+        publish_text(record, text);
+        if (raw_sink_count > 0) {
+            raw_publish_record(record);
+        }
+        published++;
+    }
+    return published;
+}
+
+binlog_stats_t binlog_get_stats(void) {
+    binlog_stats_t stats;
+    stats.written = write_index.load(std::memory_order_relaxed);
+    stats.dropped = dropped_count.load(std::memory_order_relaxed);
+    stats.high_water = high_water;
+    stats.pending = stats.written - read_index;
+    return stats;
+}
+
+void binlog_print_stats(void) {
+    binlog_stats_t stats = binlog_get_stats();
+    Serial.printf("Log: %lu records, %lu dropped | Ring: %lu pending, high water %lu/%d | Raw sinks: %d\n",
+                  (unsigned long)stats.written, (unsigned long)stats.dropped, (unsigned long)stats.pending,
+                  (unsigned long)stats.high_water, BINLOG_RING_SIZE, raw_sink_count);
+}
+
+//=============================================================================
+// SINKS
+//=============================================================================
+
+/**
+ * @brief Register an additional sink for formatted lines
+ * @return false if all sink slots are taken
+ */
+bool binlog_add_sink(binlog_text_sink_t sink) {
+    if (sink == nullptr || text_sink_count >= BINLOG_MAX_SINKS) {
+        return false;
+    }
+    for (int i = 0; i < text_sink_count; i++) {
+        if (text_sinks[i] == sink) return true;
+    }
+    text_sinks[text_sink_count++] = sink;
+    return true;
+}
+
+/**
+ * @brief Register a sink for the raw frame stream
+ * The sink receives the stream magic first; the dictionary restarts so every
+ * string is defined again for it.
+ * @return false if all sink slots are taken
+ */
+bool binlog_add_raw_sink(binlog_raw_sink_t sink) {
+    if (sink == nullptr || raw_sink_count >= BINLOG_MAX_SINKS) {
+        return false;
+    }
+    for (int i = 0; i < raw_sink_count; i++) {
+        if (raw_sinks[i] == sink) return true;
+    }
+    raw_sinks[raw_sink_count++] = sink;
+    memset(raw_dict, 0, sizeof(raw_dict));
+    raw_dict_next = 0;
+    sink(reinterpret_cast<const uint8_t*>(BINLOG_STREAM_MAGIC), 4);
+    return true;
+}
+
+bool binlog_remove_raw_sink(binlog_raw_sink_t sink) {
+    for (int i = 0; i < raw_sink_count; i++) {
+        if (raw_sinks[i] == sink) {
+            raw_sinks[i] = raw_sinks[--raw_sink_count];
+            return true;
+        }
+    }
+    return false;
+}
+
+//=============================================================================
+// FLIGHT RECORDER
+//=============================================================================
+
+uint32_t binlog_history_oldest(void) {
+    return history_oldest;
+}
+
+uint32_t binlog_history_end(void) {
+    return history_end;
+}
+
+/**
+ * @brief Copy whole recorder entries from *cursor up to end into out
+ * A cursor the recorder has already overwritten restarts at the oldest entry
+ * (the caller sees the jump); stops at the first entry that does not fit.
+ * @return Bytes written
+ */
+size_t binlog_history_read(uint32_t* cursor, uint32_t end, uint8_t* out, size_t out_len) {
+    uint32_t pos = *cursor;
+    if ((int32_t)(pos - history_oldest) < 0) pos = history_oldest;
+    if ((int32_t)(end - history_end) > 0) end = history_end;
+    size_t n = 0;
+    while ((int32_t)(end - pos) > 0) {
+        size_t entry_len = BINLOG_HISTORY_ENTRY_HEADER + history_at(pos + 4);
+        if (n + entry_len > out_len) break;
+        for (size_t i = 0; i < entry_len; i++) {
+            out[n + i] = history_at(pos + (uint32_t)i);
+        }
+        n += entry_len;
+        pos += (uint32_t)entry_len;
+    }
+    *cursor = pos;
+    return n;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file block_pool.cpp
+ * @brief Fixed-block pool implementation
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "block_pool.h"
+
+static_assert(POOL_MESSAGE_COUNT <= POOL_MAX_BLOCKS && POOL_CONNECTION_COUNT <= POOL_MAX_BLOCKS &&
+              POOL_FRAME_COUNT <= POOL_MAX_BLOCKS, "pool larger than its in-use bitmap");
+static_assert(POOL_MESSAGE_BLOCK % 8 == 0 && POOL_CONNECTION_BLOCK % 8 == 0 && POOL_FRAME_BLOCK % 8 == 0,
+              "pool block sizes must keep 8-byte alignment");
+
+//=============================================================================
+// POOL STORAGE
+//=============================================================================
+
+constexpr uint8_t POOL_END = 0xFF;
+
+/**
+ * @brief One pool: static storage plus a free list threaded through free blocks
+ */
+struct block_pool_t {
+    uint8_t* storage;
+    size_t block_size;
+    uint16_t block_count;
+    uint8_t free_head;                   // First free block (POOL_END = exhausted)
+    uint32_t in_use_mask;                // Bit i: block i handed out
+    pool_stats_t stats;
+};
+
+alignas(8) static uint8_t message_storage[POOL_MESSAGE_BLOCK * POOL_MESSAGE_COUNT];
+alignas(8) static uint8_t connection_storage[POOL_CONNECTION_BLOCK * POOL_CONNECTION_COUNT];
+alignas(8) static uint8_t frame_storage[POOL_FRAME_BLOCK * POOL_FRAME_COUNT];
+
+static block_pool_t pools[static_cast<int>(PoolId::COUNT)] = {
+    {message_storage, POOL_MESSAGE_BLOCK, POOL_MESSAGE_COUNT, POOL_END, 0, {}},
+    {connection_storage, POOL_CONNECTION_BLOCK, POOL_CONNECTION_COUNT, POOL_END, 0, {}},
+    {frame_storage, POOL_FRAME_BLOCK, POOL_FRAME_COUNT, POOL_END, 0, {}},
+};
+static bool pools_ready = false;
+
+static const char* kPoolNames[static_cast<int>(PoolId::COUNT)] = {"message", "connection", "frame"};
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+static block_pool_t* get_pool(PoolId pool) {
+    int index = static_cast<int>(pool);
+    if (index < 0 || index >= static_cast<int>(PoolId::COUNT)) return nullptr;
+    if (!pools_ready) pool_init();
+    return &pools[index];
+}
+
+// The free-list link lives in the first byte of each free block
+static inline uint8_t* block_at(block_pool_t* p, uint8_t index) {
+    return p->storage + (size_t)index * p->block_size;
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Chain every block of every pool into its free list and clear counters
+ */
+void pool_init(void) {
+    for (block_pool_t& p : pools) {
+        for (uint16_t i = 0; i < p.block_count; i++) {
+            *block_at(&p, (uint8_t)i) = (i + 1 < p.block_count) ? (uint8_t)(i + 1) : POOL_END;
+        }
+        p.free_head = p.block_count > 0 ? 0 : POOL_END;
+        p.in_use_mask = 0;
+        p.stats = {};
+        p.stats.block_size = p.block_size;
+        p.stats.block_count = p.block_count;
+    }
+    pools_ready = true;
+}
+
+/**
+ * @brief Take a block from a pool
+ * @return Block of pool_get_stats(pool).block_size bytes, 8-byte aligned,
+ *         or nullptr if the pool is exhausted
+ */
+void* pool_alloc(PoolId pool) {
+    block_pool_t* p = get_pool(pool);
+    if (p == nullptr) return nullptr;
+    if (p->free_head == POOL_END) {
+        p->stats.exhausted++;
+        return nullptr;
+    }
+
+    uint8_t index = p->free_head;
+    uint8_t* block = block_at(p, index);
+    p->free_head = *block;
+    p->in_use_mask |= 1u << index;
+    p->stats.allocs++;
+    p->stats.in_use++;
+    if (p->stats.in_use > p->stats.high_water) {
+        p->stats.high_water = p->stats.in_use;
+    }
+    return block;
+}
+
+/**
+ * @brief Return a block to its pool
+ * Pointers outside the pool, misaligned or already free are counted and
+ * ignored rather than corrupting the free list.
+ * @return true if the block was returned
+ */
+bool pool_free(PoolId pool, void* block) {
+    block_pool_t* p = get_pool(pool);
+    if (p == nullptr || block == nullptr) return false;
+
+    uint8_t* ptr = static_cast<uint8_t*>(block);
+    uintptr_t base = reinterpret_cast<uintptr_t>(p->storage);
+    uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - base;     // Wraps huge for pointers below the pool
+    if (offset >= p->block_size * p->block_count || offset % p->block_size != 0) {
+        p->stats.bad_frees++;
+        return false;
+    }
+    uint8_t index = (uint8_t)(offset / p->block_size);
+    if ((p->in_use_mask & (1u << index)) == 0) {
+        p->stats.bad_frees++;
+        return false;
+    }
+
+    p->in_use_mask &= ~(1u << index);
+    *ptr = p->free_head;
+    p->free_head = index;
+    p->stats.in_use--;
+    return true;
+}
+
+pool_stats_t pool_get_stats(PoolId pool) {
+    block_pool_t* p = get_pool(pool);
+    return p ? p->stats : pool_stats_t{};
+}
+
+const char* pool_name(PoolId pool) {
+    int index = static_cast<int>(pool);
+    return (index >= 0 && index < static_cast<int>(PoolId::COUNT)) ? kPoolNames[index] : "unknown";
+}
+
+/**
+ * @brief Print one line per pool (shown with 'C')
+ */
+void pool_print_status(void) {
+    for (int i = 0; i < static_cast<int>(PoolId::COUNT); i++) {
+        PoolId pool = static_cast<PoolId>(i);
+        pool_stats_t stats = pool_get_stats(pool);
+        Serial.printf("Pool %-10s %2u/%-2u x %4u B | peak %u | allocs %lu | exhausted %lu%s\n", pool_name(pool),
+                      stats.in_use, stats.block_count, (unsigned)stats.block_size, stats.high_water,
+                      (unsigned long)stats.allocs, (unsigned long)stats.exhausted,
+                      stats.bad_frees ? " | BAD FREES" : "");
+    }
+}
@@ -0,0 +1,495 @@
+/**
+ * @file cal_history.cpp
+ * @brief Calibration record ring, rollback, aging trend and the 'k' console command
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "cal_history.h"
+#include "calibration.h"
+#include "pump.h"
+#include "communication.h"
+#include "trend.h"
+#include "adc_cal.h"
+#include <math.h>
+
+//=============================================================================
+// HISTORY
+//=============================================================================
+
+void cal_history_reset(cal_history_t* hist, float reference_slope) {
+    memset(hist, 0, sizeof(*hist));
+    hist->next_seq = 1;
+    hist->reference_slope = reference_slope;
+}
+
+/**
+ * @brief Append a calibration, overwriting the oldest when full
+ * The new record becomes the active one.
+ */
+const cal_record_t* cal_history_push(cal_history_t* hist, const cal_record_t& record) {
+    cal_record_t& slot = hist->record[hist->head];
+    slot = record;
+    slot.seq = hist->next_seq++;
+    slot.flags = 0;
+    hist->head = (uint8_t)((hist->head + 1) % CAL_HISTORY_RECORDS);
+    if (hist->count < CAL_HISTORY_RECORDS) hist->count++;
+    hist->active_seq = slot.seq;
+    if (hist->reference_slope == 0.0f) hist->reference_slope = slot.slope;
+    return &slot;
+}
+
+const cal_record_t* cal_history_at(const cal_history_t* hist, int back) {
+    if (back < 0 || back >= hist->count) return nullptr;
+    return &hist->record[(hist->head - 1 - back + 2 * CAL_HISTORY_RECORDS) % CAL_HISTORY_RECORDS];
+}
+
+const cal_record_t* cal_history_find(const cal_history_t* hist, uint32_t seq) {
+    for (int back = 0; back < hist->count; back++) {
+        const cal_record_t* record = cal_history_at(hist, back);
+        if (record->seq == seq) return record;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Make record 'seq' the active one
+ * Records newer than it are marked rolled back, older ones are cleared (a
+ * later rollback to a newer record brings those back).
+ */
+bool cal_history_rollback(cal_history_t* hist, uint32_t seq) {
+    if (seq == 0 || !cal_history_find(hist, seq)) return false;
+    for (int i = 0; i < CAL_HISTORY_RECORDS; i++) {
+        cal_record_t& record = hist->record[i];
+        if (record.seq == 0) continue;
+        if (record.seq > seq) {
+            record.flags |= CAL_RECORD_ROLLED_BACK;
+        } else {
+            record.flags &= (uint8_t)~CAL_RECORD_ROLLED_BACK;
+        }
+    }
+    hist->active_seq = seq;
+    return true;
+}
+
+/**
+ * @brief Reference slope over the record's slope, in %
+ * Negative when the slope has the wrong sign (buffers swapped); 0 without a reference.
+ */
+float cal_history_efficiency(const cal_history_t* hist, const cal_record_t& record) {
+    if (hist->reference_slope == 0.0f || record.slope == 0.0f) return 0.0f;
+    return hist->reference_slope / record.slope * 100.0f;
+}
+
+/**
+ * @brief Fit efficiency against operating hours over the counted records
+ * @param limit Minimum efficiency (%)
+ * @return false with fewer than CAL_HISTORY_MIN_POINTS records or less than
+ *         CAL_HISTORY_MIN_SPAN_H between the first and last (out->points still set)
+ */
+bool cal_history_aging(const cal_history_t* hist, float limit, cal_aging_t* out) {
+    trend_fit_t fit;
+    trend_reset(&fit);
+    int points = 0;
+    float first_h = 0.0f, last_h = 0.0f;
+    for (int back = hist->count - 1; back >= 0; back--) {
+        const cal_record_t* record = cal_history_at(hist, back);
+        float efficiency = cal_history_efficiency(hist, *record);
+        if ((record->flags & CAL_RECORD_ROLLED_BACK) || !(efficiency > 0.0f && efficiency <= CAL_HISTORY_MAX_EFFICIENCY)) {
+            continue;
+        }
+        if (points == 0) first_h = last_h = record->hours;
+        // Time only runs forward; a record stamped earlier counts as simultaneous
+        float dt = record->hours > last_h ? record->hours - last_h : 0.0f;
+        trend_add(&fit, dt, efficiency, CAL_HISTORY_TREND_TAU_H);
+        last_h += dt;
+        points++;
+    }
+    memset(out, 0, sizeof(*out));
+    out->points = (uint8_t)points;
+
+    trend_estimate_t estimate;
+    if (points < CAL_HISTORY_MIN_POINTS || last_h - first_h < CAL_HISTORY_MIN_SPAN_H ||
+        !trend_estimate(&fit, &estimate)) {
+        return false;
+    }
+    out->efficiency = estimate.level;
+    out->rate_per_kh = estimate.slope * 1000.0f;
+    out->rate_sigma_per_kh = estimate.slope_sigma * 1000.0f;
+
+    float margin = estimate.level - limit;
+    float early_slope = estimate.slope - estimate.slope_sigma;
+    out->hours_left = margin <= 0.0f ? 0.0f : (estimate.slope < 0.0f ? margin / -estimate.slope : -1.0f);
+    out->hours_left_early = margin <= 0.0f ? 0.0f : (early_slope < 0.0f ? margin / -early_slope : -1.0f);
+    return true;
+}
+
+//=============================================================================
+// FIRMWARE
+//=============================================================================
+
+struct cal_channel_t {
+    const char* name;            // Console and NVS key
+    const char* label;
+    const char* unit;
+    float neutral;               // Value whose mV is the probe's zero point (pH 7, 0 mS/cm)
+    float reference_slope;       // 100 % for a new probe (0 = its first calibration)
+    float limit;                 // Minimum efficiency (%)
+};
+
+static cal_channel_t channels[2] = {
+    {"ph", "pH", "pH", 7.0f, DEFAULT_PH_SLOPE, CAL_HISTORY_DEFAULT_PH_LIMIT},
+    {"ec", "EC", "mS/cm", 0.0f, 0.0f, CAL_HISTORY_DEFAULT_EC_LIMIT},
+};
+
+static float clock_hours;        // Operating hours at clock_ms
+static uint32_t clock_ms;
+
+static cal_channel_t& channel_of(CalProbe probe) {
+    return channels[probe == CalProbe::PH ? 0 : 1];
+}
+
+const char* cal_probe_to_string(CalProbe probe) {
+    return channel_of(probe).label;
+}
+
+/**
+ * @brief Load the hours counter and limits; records stay in NVS until needed
+ */
+void cal_history_init(void) {
+    clock_hours = 0.0f;
+    clock_ms = millis();
+    Preferences store;
+    if (!store.begin(CAL_HISTORY_NVS_NAMESPACE, true)) return;
+    float hours = store.getFloat("hours", 0.0f);
+    if (isfinite(hours) && hours > 0.0f) clock_hours = hours;
+    char key[8];
+    for (cal_channel_t& ch : channels) {
+        snprintf(key, sizeof(key), "%s_lim", ch.name);
+        float limit = store.getFloat(key, ch.limit);
+        if (limit > 0.0f && limit < 100.0f) ch.limit = limit;
+    }
+    store.end();
+}
+
+/**
+ * @brief Move the hours counter to 'hours' at 'now' and store it
+ */
+static void clock_store(float hours, uint32_t now) {
+    clock_hours = hours;
+    clock_ms = now;
+    Preferences store;
+    if (!store.begin(CAL_HISTORY_NVS_NAMESPACE, false)) return;
+    store.putFloat("hours", clock_hours);
+    store.end();
+}
+
+void cal_history_tick(void) {
+    uint32_t now = millis();
+    if (now - clock_ms < CAL_HISTORY_CLOCK_SAVE_MS) return;
+    clock_store(clock_hours + (now - clock_ms) / 3600000.0f, now);
+}
+
+float cal_history_hours(void) {
+    return clock_hours + (millis() - clock_ms) / 3600000.0f;
+}
+
+/**
+ * @brief Check a stored history before anything from it can reach the calibration
+ * Same bounds as calibration_load(), so a rollback never restores what it would reject.
+ */
+static bool cal_history_plausible(const cal_history_t& hist) {
+    if (hist.head >= CAL_HISTORY_RECORDS || hist.count > CAL_HISTORY_RECORDS || !isfinite(hist.reference_slope) ||
+        fabsf(hist.reference_slope) > CALIBRATION_MAX_SLOPE) {
+        return false;
+    }
+    // Every record the ring reaches: numbered newest-first, sane fields. Hours are
+    // not ordered: the counter of a board that reset before storing them may repeat.
+    uint32_t newer = hist.next_seq;
+    for (int back = 0; back < hist.count; back++) {
+        const cal_record_t& r = *cal_history_at(&hist, back);
+        if (r.seq == 0 || r.seq >= newer || !(r.hours >= 0.0f && r.hours <= CAL_HISTORY_MAX_HOURS)) return false;
+        newer = r.seq;
+        if (!isfinite(r.slope) || !isfinite(r.offset) || r.slope == 0.0f ||
+            fabsf(r.slope) > CALIBRATION_MAX_SLOPE || fabsf(r.offset) > CALIBRATION_MAX_OFFSET) {
+            return false;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (!isfinite(r.point_mv[i]) || !isfinite(r.point_value[i])) return false;
+        }
+    }
+    return hist.count == 0 || cal_history_find(&hist, hist.active_seq) != nullptr;
+}
+
+/**
+ * @brief Read a probe's records; an absent or damaged blob reads as an empty history
+ */
+bool cal_history_load(CalProbe probe, cal_history_t* out) {
+    const cal_channel_t& ch = channel_of(probe);
+    Preferences store;
+    bool loaded = false;
+    if (store.begin(CAL_HISTORY_NVS_NAMESPACE, true)) {
+        loaded = store.getBytesLength(ch.name) == sizeof(*out) &&
+                 store.getBytes(ch.name, out, sizeof(*out)) == sizeof(*out) && cal_history_plausible(*out);
+        store.end();
+    }
+    if (!loaded) cal_history_reset(out, ch.reference_slope);
+    return loaded;
+}
+
+static bool cal_history_save(CalProbe probe, const cal_history_t& hist) {
+    Preferences store;
+    if (!store.begin(CAL_HISTORY_NVS_NAMESPACE, false)) return false;
+    bool saved = store.putBytes(channel_of(probe).name, &hist, sizeof(hist)) == sizeof(hist);
+    store.end();
+    return saved;
+}
+
+static void print_aging(CalProbe probe, const cal_history_t& hist) {
+    const cal_channel_t& ch = channel_of(probe);
+    cal_aging_t aging;
+    if (!cal_history_aging(&hist, ch.limit, &aging)) {
+        Debug->printf("%s aging: needs %d records over %.0f h (%u counted)", ch.label, CAL_HISTORY_MIN_POINTS,
+                      CAL_HISTORY_MIN_SPAN_H, aging.points);
+        return;
+    }
+    Debug->printf("%s aging: %.1f %% efficiency, %+.2f %%/1000 h (+-%.2f) over %u records", ch.label,
+                  aging.efficiency, aging.rate_per_kh, aging.rate_sigma_per_kh, aging.points);
+    if (aging.hours_left == 0.0f) {
+        Debug->printf("WARNING: %s probe below the %.0f %% limit - replace it", ch.label, ch.limit);
+        return;
+    }
+    if (aging.hours_left < 0.0f) {
+        Debug->printf("  not declining - no replacement due (limit %.0f %%)", ch.limit);
+        return;
+    }
+    // The fit runs from the newest counted record; report from now
+    float newest_h = 0.0f;
+    for (int back = 0; back < hist.count; back++) {
+        const cal_record_t* record = cal_history_at(&hist, back);
+        if (!(record->flags & CAL_RECORD_ROLLED_BACK)) {
+            newest_h = record->hours;
+            break;
+        }
+    }
+    float now = cal_history_hours();
+    float due = newest_h + aging.hours_left;
+    if (aging.hours_left_early >= 0.0f) {
+        Debug->printf("  %.0f %% limit at ~%.0f h of operation (%.0f h from now, earliest %.0f h)", ch.limit, due,
+                      due - now, newest_h + aging.hours_left_early - now);
+    } else {
+        Debug->printf("  %.0f %% limit at ~%.0f h of operation (%.0f h from now)", ch.limit, due, due - now);
+    }
+}
+
+/**
+ * @brief Store a completed 2-point calibration as the probe's newest record
+ * Called after the calibration itself is saved; a failure here leaves it in use.
+ */
+bool cal_history_record(CalProbe probe, const float* point_mv, const float* point_value, float slope, float offset) {
+    cal_history_t hist;
+    cal_history_load(probe, &hist);
+    cal_record_t record = {};
+    // Store the counter with the record, so a reset within the hour cannot stamp
+    // the next one earlier; never behind the newest record either
+    record.hours = cal_history_hours();
+    const cal_record_t* newest = cal_history_at(&hist, 0);
+    if (newest && newest->hours > record.hours) record.hours = newest->hours;
+    clock_store(record.hours, millis());
+    for (int i = 0; i < 2; i++) {
+        record.point_mv[i] = point_mv[i];
+        record.point_value[i] = point_value[i];
+    }
+    record.slope = slope;
+    record.offset = offset;
+    if (adc_cal_get_source() == AdcCalSource::EFUSE_CURVE) record.flags |= CAL_RECORD_ADC_CURVE;
+    const cal_record_t* stored = cal_history_push(&hist, record);
+    if (!cal_history_save(probe, hist)) {
+        Debug->printf("ERROR: Failed to store %s calibration history", cal_probe_to_string(probe));
+        return false;
+    }
+    float efficiency = cal_history_efficiency(&hist, *stored);
+    Debug->printf("%s calibration #%lu stored in history at %.1f h, efficiency %.1f %%", cal_probe_to_string(probe),
+                  (unsigned long)stored->seq, stored->hours, efficiency);
+
+    // A sudden drop is more often a bad buffer than a worn probe
+    const cal_record_t* previous = cal_history_at(&hist, 1);
+    if (previous && !(previous->flags & CAL_RECORD_ROLLED_BACK)) {
+        float drop = cal_history_efficiency(&hist, *previous) - efficiency;
+        if (efficiency <= 0.0f || drop > CAL_HISTORY_SUSPECT_DROP) {
+            Debug->printf("WARNING: %s efficiency %.1f %% after %.1f %% at #%lu - buffers swapped or contaminated? "
+                          "'k' rollback %s restores #%lu", cal_probe_to_string(probe), efficiency,
+                          efficiency + drop, (unsigned long)previous->seq, channel_of(probe).name,
+                          (unsigned long)previous->seq);
+        }
+    }
+    print_aging(probe, hist);
+    return true;
+}
+
+//=============================================================================
+// CONSOLE
+//=============================================================================
+
+static bool probe_named(const char* name, CalProbe* out) {
+    if (strcmp(name, "ph") == 0) {
+        *out = CalProbe::PH;
+    } else if (strcmp(name, "ec") == 0) {
+        *out = CalProbe::EC;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static void print_list(CalProbe probe) {
+    const cal_channel_t& ch = channel_of(probe);
+    cal_history_t hist;
+    cal_history_load(probe, &hist);
+    Debug->printf("%s calibrations: %u of %d kept, now %.1f h (* in use, x rolled back)", ch.label, hist.count,
+                  CAL_HISTORY_RECORDS, cal_history_hours());
+    for (int back = hist.count - 1; back >= 0; back--) {
+        const cal_record_t* r = cal_history_at(&hist, back);
+        char mark = r->seq == hist.active_seq ? '*' : ((r->flags & CAL_RECORD_ROLLED_BACK) ? 'x' : ' ');
+        Debug->printf(" %c#%-3lu %8.1f h  %.2f@%.1fmV %.2f@%.1fmV  slope %.6f offset %.4f  %5.1f %%", mark,
+                      (unsigned long)r->seq, r->hours, r->point_value[0], r->point_mv[0], r->point_value[1],
+                      r->point_mv[1], r->slope, r->offset, cal_history_efficiency(&hist, *r));
+    }
+    print_aging(probe, hist);
+}
+
+static void print_diff(CalProbe probe, const cal_history_t& hist, const cal_record_t& a, const cal_record_t& b) {
+    const cal_channel_t& ch = channel_of(probe);
+    Debug->printf("%s #%lu (%.1f h) -> #%lu (%.1f h), %.1f h apart", ch.label, (unsigned long)a.seq, a.hours,
+                  (unsigned long)b.seq, b.hours, b.hours - a.hours);
+    Debug->printf("  slope      %.6f -> %.6f (%+.2f %%)", a.slope, b.slope, (b.slope / a.slope - 1.0f) * 100.0f);
+    Debug->printf("  offset     %.4f -> %.4f (%+.4f %s)", a.offset, b.offset, b.offset - a.offset, ch.unit);
+    float zero_a = (ch.neutral - a.offset) / a.slope;
+    float zero_b = (ch.neutral - b.offset) / b.slope;
+    Debug->printf("  zero       %.1f -> %.1f mV (%+.1f mV at %.2f %s)", zero_a, zero_b, zero_b - zero_a, ch.neutral,
+                  ch.unit);
+    float eff_a = cal_history_efficiency(&hist, a);
+    float eff_b = cal_history_efficiency(&hist, b);
+    Debug->printf("  efficiency %.1f -> %.1f %% (%+.1f)", eff_a, eff_b, eff_b - eff_a);
+}
+
+/**
+ * @brief Newest record older than the active one that is not rolled back
+ */
+static const cal_record_t* previous_good(const cal_history_t& hist) {
+    for (int back = 0; back < hist.count; back++) {
+        const cal_record_t* record = cal_history_at(&hist, back);
+        if (record->seq < hist.active_seq && !(record->flags & CAL_RECORD_ROLLED_BACK)) return record;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 'k': one line - "list [ph|ec]", "diff ph|ec [from [to]]", "rollback ph|ec [#]",
+ * "aging", "limit ph|ec <%>" or "new ph|ec"
+ */
+void cal_history_command(void) {
+    char line[48];
+    // The prompt blocks loop(), which is what stops a running dose on time
+    if (pump_any_running()) {
+        Debug->println("ERROR: A pump is running - open the calibration history when it stops");
+        return;
+    }
+    Debug->println("Cal history (10s): list [ph|ec] | diff ph|ec [# [#]] | rollback ph|ec [#] | aging | "
+                   "limit ph|ec <%> | new ph|ec");
+    Debug->read_line(line, sizeof(line), CAL_HISTORY_INPUT_TIMEOUT_MS);
+
+    char verb[10] = "", name[10] = "", arg1[12] = "", arg2[12] = "";
+    int fields = sscanf(line, "%9s %9s %11s %11s", verb, name, arg1, arg2);
+    CalProbe probe;
+    bool named = fields >= 2 && probe_named(name, &probe);
+
+    if (fields <= 0 || strcmp(verb, "list") == 0) {
+        if (named) {
+            print_list(probe);
+        } else {
+            print_list(CalProbe::PH);
+            print_list(CalProbe::EC);
+        }
+    } else if (strcmp(verb, "aging") == 0) {
+        for (CalProbe p : {CalProbe::PH, CalProbe::EC}) {
+            cal_history_t hist;
+            cal_history_load(p, &hist);
+            print_aging(p, hist);
+        }
+    } else if (strcmp(verb, "diff") == 0 && named) {
+        cal_history_t hist;
+        cal_history_load(probe, &hist);
+        // Default: the newest record against the one before it
+        const cal_record_t* from = fields >= 3 ? cal_history_find(&hist, strtoul(arg1, nullptr, 10))
+                                               : cal_history_at(&hist, 1);
+        const cal_record_t* to = fields >= 4 ? cal_history_find(&hist, strtoul(arg2, nullptr, 10))
+                                             : cal_history_at(&hist, 0);
+        if (!from || !to) {
+            Debug->printf("ERROR: No such %s calibration record ('k' list shows them)", cal_probe_to_string(probe));
+            return;
+        }
+        print_diff(probe, hist, *from, *to);
+    } else if (strcmp(verb, "rollback") == 0 && named) {
+        cal_history_t hist;
+        cal_history_load(probe, &hist);
+        const cal_record_t* target = fields >= 3 ? cal_history_find(&hist, strtoul(arg1, nullptr, 10))
+                                                 : previous_good(hist);
+        if (!target) {
+            Debug->printf("ERROR: No %s calibration to roll back to", cal_probe_to_string(probe));
+            return;
+        }
+        // Its slope/offset only hold on the ADC scale it was fitted on
+        bool curve = (target->flags & CAL_RECORD_ADC_CURVE) != 0;
+        if (curve != (adc_cal_get_source() == AdcCalSource::EFUSE_CURVE)) {
+            Debug->printf("ERROR: %s #%lu was fitted on the %s ADC scale, now %s - recalibrate instead",
+                          cal_probe_to_string(probe), (unsigned long)target->seq,
+                          adc_cal_source_to_string(curve ? AdcCalSource::EFUSE_CURVE : AdcCalSource::LINEAR),
+                          adc_cal_source_to_string(adc_cal_get_source()));
+            return;
+        }
+        cal_record_t restored = *target;
+        cal_history_rollback(&hist, restored.seq);
+        if (probe == CalProbe::PH) {
+            calibration.ph_slope = restored.slope;
+            calibration.ph_offset = restored.offset;
+        } else {
+            calibration.ec_slope = restored.slope;
+            calibration.ec_offset = restored.offset;
+        }
+        if (!calibration_save() || !cal_history_save(probe, hist)) {
+            Debug->printf("ERROR: %s rollback not stored - restored values apply until reboot",
+                          cal_probe_to_string(probe));
+            return;
+        }
+        Debug->printf("%s calibration rolled back to #%lu: slope %.6f, offset %.4f", cal_probe_to_string(probe),
+                      (unsigned long)restored.seq, restored.slope, restored.offset);
+    } else if (strcmp(verb, "limit") == 0 && named && fields >= 3) {
+        float limit = (float)atof(arg1);
+        if (!(limit > 0.0f && limit < 100.0f)) {
+            Debug->println("ERROR: Limit must be above 0 and below 100 %");
+            return;
+        }
+        cal_channel_t& ch = channel_of(probe);
+        ch.limit = limit;
+        char key[8];
+        snprintf(key, sizeof(key), "%s_lim", ch.name);
+        Preferences store;
+        if (store.begin(CAL_HISTORY_NVS_NAMESPACE, false)) {
+            store.putFloat(key, limit);
+            store.end();
+        }
+        Debug->printf("%s efficiency limit %.0f %%", ch.label, limit);
+    } else if (strcmp(verb, "new") == 0 && named) {
+        // Replaced probe: its aging starts over, the old records would only skew the fit
+        cal_history_t hist;
+        cal_history_reset(&hist, channel_of(probe).reference_slope);
+        if (!cal_history_save(probe, hist)) {
+            Debug->printf("ERROR: Failed to clear %s calibration history", cal_probe_to_string(probe));
+            return;
+        }
+        Debug->printf("%s calibration history cleared for a new probe - calibrate it now", cal_probe_to_string(probe));
+    } else {
+        Debug->println("ERROR: Not understood");
+    }
+}
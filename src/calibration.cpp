@@ -7,6 +7,10 @@
 
 #include "calibration.h"
 #include "sensors.h"
+#include "cal_history.h"
+#include "adc_cal.h"
+#include "pump.h"
+#include "communication.h"
 
 //=============================================================================
 // GLOBAL VARIABLES
@@ -15,6 +19,76 @@
 // Global calibration data (loaded from NVS or defaults)
 calibration_t calibration;
 
+// pH/EC fitted on another ADC scale than adc_cal_init() chose (calibration_check_adc_scale)
+static bool ph_scale_stale = false;
+static bool ec_scale_stale = false;
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Check that every calibration field is a finite number
+ * NaN/Inf would slip through the range comparisons below (all false)
+ */
+static bool calibration_fields_finite(const calibration_t& cal) {
+  return isfinite(cal.ph_slope) && isfinite(cal.ph_offset) &&
+         isfinite(cal.ec_slope) && isfinite(cal.ec_offset) &&
+         isfinite(cal.empty_distance) && isfinite(cal.half_distance) &&
+         isfinite(cal.full_distance) && isfinite(cal.max_volume);
+}
+
+/**
+ * @brief Check slopes/offsets are within what the 2-point setters can produce
+ * Larger magnitudes overflow the mV conversion to Inf at full-scale ADC.
+ */
+static bool calibration_magnitudes_plausible(const calibration_t& cal) {
+  return fabsf(cal.ph_slope) <= CALIBRATION_MAX_SLOPE && fabsf(cal.ph_offset) <= CALIBRATION_MAX_OFFSET &&
+         fabsf(cal.ec_slope) <= CALIBRATION_MAX_SLOPE && fabsf(cal.ec_offset) <= CALIBRATION_MAX_OFFSET;
+}
+
+/**
+ * @brief Check volume calibration points (all zero means "not calibrated")
+ */
+static bool calibration_volume_consistent(const calibration_t& cal) {
+  if (cal.max_volume == 0.0f && cal.empty_distance == 0.0f) {
+    return true;
+  }
+  return cal.full_distance > 0 && cal.full_distance < cal.half_distance &&
+         cal.half_distance < cal.empty_distance && cal.max_volume > 0;
+}
+
+/**
+ * @brief Record that a probe was just calibrated on the current ADC scale
+ * Automatic dosing resumes once neither probe is left on another scale.
+ */
+static void calibration_mark_adc_scale(const char* key, bool* stale) {
+  preferences.putUChar(key, static_cast<uint8_t>(adc_cal_get_source()));
+  if (!*stale) {
+    return;
+  }
+  *stale = false;
+  if (!ph_scale_stale && !ec_scale_stale) {
+    pump_set_auto_inhibit(PUMP_INHIBIT_ADC_SCALE, false);
+    Debug->println("pH and EC recalibrated on the current ADC scale - automatic dosing allowed again");
+  }
+}
+
+/**
+ * @brief Wait for any key on Serial with timeout
+ * @return true if a key arrived (and was consumed), false on timeout
+ */
+static bool calibration_wait_for_key(uint32_t timeout_ms) {
+  uint32_t start = millis();
+  while (!Serial.available()) {
+    if (millis() - start >= timeout_ms) {
+      return false;
+    }
+  }
+  Serial.read();
+  return true;
+}
+
 //=============================================================================
 // NVS CALIBRATION MANAGEMENT FUNCTIONS
 //=============================================================================
@@ -29,14 +103,22 @@ void calibration_load(void) {
   
   if (calLen == sizeof(calibration_t)) {
     // Load calibration from NVS using safe aligned copy
-    if (preferences.getBytes(NVS_CALIBRATION_KEY, &calibration, sizeof(calibration_t)) == sizeof(calibration_t)) {
-      // Successfully loaded
-    } else {
+    calibration_t stored;
+    if (preferences.getBytes(NVS_CALIBRATION_KEY, &stored, sizeof(calibration_t)) != sizeof(calibration_t)) {
       Serial.println("ERROR: Failed to load calibration data");
       calibration_reset();
       return;
     }
     
+    // Reject corrupted blobs instead of feeding NaN/garbage into sensor math
+    if (!calibration_fields_finite(stored) || !calibration_magnitudes_plausible(stored) ||
+        !calibration_volume_consistent(stored)) {
+      Serial.println("ERROR: Stored calibration corrupted - using defaults");
+      calibration_reset();
+      return;
+    }
+    calibration = stored;
+    
     Serial.println("Calibration loaded from NVS:");
     Serial.printf("  pH: slope=%.6f, offset=%.4f\n", calibration.ph_slope, calibration.ph_offset);
     Serial.printf("  EC: slope=%.6f, offset=%.4f\n", calibration.ec_slope, calibration.ec_offset);
@@ -94,6 +176,45 @@ void calibration_reset(void) {
   Serial.printf("  EC: slope=%.6f, offset=%.4f\n", DEFAULT_EC_SLOPE, DEFAULT_EC_OFFSET);
 }
 
+/**
+ * @brief Compare the ADC scale each probe was calibrated on with the one in use
+ * A slope/offset fitted on the linear scale reads whole pH units off on the
+ * eFuse curve mid-range (and the other way round), so automatic dosing is paused until
+ * the stale probes are recalibrated. A calibration stored before the scale
+ * was recorded was fitted on the linear scale; with none stored, the
+ * defaults apply on either.
+ */
+void calibration_check_adc_scale(void) {
+  const uint8_t unknown = 0xFF;
+  uint8_t current = static_cast<uint8_t>(adc_cal_get_source());
+  bool stored = preferences.getBytesLength(NVS_CALIBRATION_KEY) == sizeof(calibration_t);
+  uint8_t fallback = stored ? static_cast<uint8_t>(AdcCalSource::LINEAR) : current;
+  uint8_t ph_source = preferences.getUChar(NVS_CAL_PH_ADC_KEY, unknown);
+  uint8_t ec_source = preferences.getUChar(NVS_CAL_EC_ADC_KEY, unknown);
+  ph_scale_stale = (ph_source == unknown ? fallback : ph_source) != current;
+  ec_scale_stale = (ec_source == unknown ? fallback : ec_source) != current;
+  pump_set_auto_inhibit(PUMP_INHIBIT_ADC_SCALE, ph_scale_stale || ec_scale_stale);
+  if (!ph_scale_stale && !ec_scale_stale) {
+    return;
+  }
+  
+  const char* now = adc_cal_source_to_string(adc_cal_get_source());
+  Debug->println("!!! CALIBRATION INVALID: ADC SCALE CHANGED !!!");
+  if (ph_scale_stale) {
+    Debug->printf("WARNING: pH calibration was fitted on another ADC scale than the %s now in use - "
+                  "pH readings are wrong. Recalibrate with 'p'", now);
+  }
+  if (ec_scale_stale) {
+    Debug->printf("WARNING: EC calibration was fitted on another ADC scale than the %s now in use - "
+                  "recalibrate with 'e'", now);
+  }
+  Debug->println("WARNING: Automatic pH/EC dosing paused until recalibration");
+}
+
+bool calibration_adc_scale_stale(void) {
+  return ph_scale_stale || ec_scale_stale;
+}
+
 //=============================================================================
 // SENSOR CALIBRATION FUNCTIONS
 //=============================================================================
@@ -108,7 +229,9 @@ void calibration_reset(void) {
  */
 bool calibration_ph_2point(float voltage1, float ph_value1, float voltage2, float ph_value2) {
   // Validate input parameters (voltages should be different and within reasonable range)
-  if (abs(voltage1 - voltage2) < 50.0 ||         // Minimum 50mV difference
+  if (!isfinite(voltage1) || !isfinite(ph_value1) ||  // Reject NaN/Inf (comparisons below are false)
+      !isfinite(voltage2) || !isfinite(ph_value2) ||
+      abs(voltage1 - voltage2) < 50.0 ||         // Minimum 50mV difference
       voltage1 < 0 || voltage1 > 3300 ||         // Valid voltage range
       voltage2 < 0 || voltage2 > 3300 ||
       ph_value1 < 0.0f || ph_value1 > 14.0f ||  // Valid pH range
@@ -130,7 +253,17 @@ bool calibration_ph_2point(float voltage1, float ph_value1, float voltage2, floa
   Serial.printf("  Calculated offset: %.4f pH\n", calibration.ph_offset);
   
   // Save new calibration to NVS
-  return calibration_save();
+  if (!calibration_save()) {
+    return false;
+  }
+  
+  calibration_mark_adc_scale(NVS_CAL_PH_ADC_KEY, &ph_scale_stale);
+  
+  // Keep it in the history as well (rollback, probe aging)
+  const float mv[2] = {voltage1, voltage2};
+  const float ph[2] = {ph_value1, ph_value2};
+  cal_history_record(CalProbe::PH, mv, ph, calibration.ph_slope, calibration.ph_offset);
+  return true;
 }
 
 /**
@@ -143,11 +276,14 @@ bool calibration_ph_2point(float voltage1, float ph_value1, float voltage2, floa
  */
 bool calibration_ec_2point(float low_voltage, float low_ec_value, float high_voltage, float high_ec_value) {
   // Validate input parameters
-  if (abs(low_voltage - high_voltage) < 50.0 ||    // Minimum 50mV difference
+  if (!isfinite(low_voltage) || !isfinite(low_ec_value) ||  // Reject NaN/Inf
+      !isfinite(high_voltage) || !isfinite(high_ec_value) ||
+      abs(low_voltage - high_voltage) < 50.0 ||    // Minimum 50mV difference
       abs(low_ec_value - high_ec_value) < 0.1 ||   // Minimum 0.1 mS/cm difference
       low_voltage < 0 || low_voltage > 3300 ||     // Valid voltage range
       high_voltage < 0 || high_voltage > 3300 ||
-      low_ec_value < 0 || high_ec_value < 0) {     // EC values must be positive
+      low_ec_value < 0 || high_ec_value < 0 ||     // EC values must be positive
+      low_ec_value > 100.0f || high_ec_value > 100.0f) {  // Above seawater (~55 mS/cm) is a typo
     Serial.println("ERROR: Invalid EC calibration parameters");
     return false;
   }
@@ -166,7 +302,17 @@ bool calibration_ec_2point(float low_voltage, float low_ec_value, float high_vol
   Serial.printf("  Calculated offset: %.4f mS/cm\n", calibration.ec_offset);
   
   // Save new calibration to NVS
-  return calibration_save();
+  if (!calibration_save()) {
+    return false;
+  }
+  
+  calibration_mark_adc_scale(NVS_CAL_EC_ADC_KEY, &ec_scale_stale);
+  
+  // Keep it in the history as well (rollback, probe aging)
+  const float mv[2] = {low_voltage, high_voltage};
+  const float ec[2] = {low_ec_value, high_ec_value};
+  cal_history_record(CalProbe::EC, mv, ec, calibration.ec_slope, calibration.ec_offset);
+  return true;
 }
 
 /**
@@ -179,7 +325,9 @@ bool calibration_ec_2point(float low_voltage, float low_ec_value, float high_vol
  */
 bool calibration_volume_3point(float empty_dist, float half_dist, float full_dist, float max_vol) {
   // Validate input parameters - distances should be in logical order
-  if (full_dist >= half_dist || half_dist >= empty_dist || 
+  if (!isfinite(empty_dist) || !isfinite(half_dist) ||   // Reject NaN/Inf
+      !isfinite(full_dist) || !isfinite(max_vol) ||
+      full_dist >= half_dist || half_dist >= empty_dist || 
       empty_dist <= 0 || full_dist <= 0 || max_vol <= 0) {
     Serial.println("ERROR: Invalid volume calibration parameters");
     Serial.println("Expected: full_dist < half_dist < empty_dist (all > 0)");
@@ -251,7 +399,7 @@ bool calibration_is_valid(void) {
   bool ec_valid = (calibration.ec_slope > -1.0 && calibration.ec_slope < 1.0) &&
                   (calibration.ec_offset >= 0.0);
   
-  return ph_valid && ec_valid;
+  return ph_valid && ec_valid && !calibration_adc_scale_stale();
 }
 
 //=============================================================================
@@ -326,20 +474,26 @@ void calibration_interactive_ec(void) {
  */
 void calibration_interactive_volume(void) {
   Serial.println("Volume calibration: Fill reservoir EMPTY, then press any key");
-  while (!Serial.available());
-  Serial.read();
+  if (!calibration_wait_for_key(CALIBRATION_KEY_TIMEOUT_MS)) {
+    Serial.println("Timeout - calibration cancelled");
+    return;
+  }
   float empty_dist = sensor_read_distance_raw();
   Serial.printf("Empty distance: %.1f cm\n", empty_dist);
   
   Serial.println("Fill reservoir HALF FULL, then press any key");
-  while (!Serial.available());
-  Serial.read(); 
+  if (!calibration_wait_for_key(CALIBRATION_KEY_TIMEOUT_MS)) {
+    Serial.println("Timeout - calibration cancelled");
+    return;
+  }
   float half_dist = sensor_read_distance_raw();
   Serial.printf("Half distance: %.1f cm\n", half_dist);
   
   Serial.println("Fill reservoir COMPLETELY FULL, then press any key");
-  while (!Serial.available());
-  Serial.read();
+  if (!calibration_wait_for_key(CALIBRATION_KEY_TIMEOUT_MS)) {
+    Serial.println("Timeout - calibration cancelled");
+    return;
+  }
   float full_dist = sensor_read_distance_raw();
   Serial.printf("Full distance: %.1f cm\n", full_dist);
   
@@ -370,5 +524,9 @@ void calibration_print_status(void) {
   Serial.printf("  Slope: %.6f (mS/cm)/mV\n", calibration.ec_slope);
   Serial.printf("  Offset: %.4f mS/cm\n", calibration.ec_offset);
   Serial.printf("Valid: %s\n", calibration_is_valid() ? "YES" : "NO");
+  if (calibration_adc_scale_stale()) {
+    Serial.printf("  Fitted on another ADC scale than %s:%s%s\n", adc_cal_source_to_string(adc_cal_get_source()),
+                  ph_scale_stale ? " pH ('p')" : "", ec_scale_stale ? " EC ('e')" : "");
+  }
   Serial.println("========================");
 }
@@ -0,0 +1,402 @@
+/**
+ * @file cli.cpp
+ * @brief Single-character command dispatcher for Serial/Telnet CLI
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "cli.h"
+#include "sensors.h"
+#include "calibration.h"
+#include "pump.h"
+#include "state_machine.h"
+#include "communication.h"
+#include "alarms.h"
+#include "volume_balance.h"
+#include "binlog.h"
+#include "multicast.h"
+#include "crash_log.h"
+#include "usb_export.h"
+#include "watch.h"
+#include "macro.h"
+#include "adc_cal.h"
+#include "adc_oversample.h"
+#include "probe_vote.h"
+#include "cal_history.h"
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Raw log sink: one "#BLG <hex>" line per frame on Serial
+ * Capture the console and feed it to the host tool logdump.
+ */
+static void cli_log_hex_sink(const uint8_t* data, size_t len) {
+  Serial.print("#BLG ");
+  for (size_t i = 0; i < len; i++) {
+    Serial.printf("%02x", data[i]);
+  }
+  Serial.println();
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Print the CLI command summary
+ */
+void cli_print_help(void) {
+  Debug->println("CLI Commands:");
+  Debug->println("  Calibration: s=show cal, r=reset cal, p=pH cal, e=EC cal, v=volume cal, c=pump pulse cal, d=pump line cal");
+  Debug->println("  Cal history: k=list, diff, rollback, probe aging trend, efficiency limits, new probe");
+  Debug->println("  pH ADC: o=cycle oversampling (off/14/15/16 bits), s shows the measured noise floor");
+  Debug->println("  Probes: n=redundant pH/EC probes (count, median/weighted vote, tolerance, readmit, match)");
+  Debug->println("  Auto pH: a=auto pH, P=predictive/reactive, u=micro-dosing, f=dose pieces, t=pH target, q=pump status, m=manual dose");
+  Debug->println("  pH Shadow: h=cycle shadow policy (off/PID/predictive), H=live vs shadow summary");
+  Debug->println("  Auto EC: E=auto EC, T=EC target, K=coupled/independent pH+EC");
+  Debug->println("  Manual Pumps: 1=pH_Up, 2=pH_Down, 3=Nut_A, 4=Nut_B");
+  Debug->println("  State Machine: S=show all states, R=recover from error, M=maintenance mode");
+  Debug->println("  Alarms: A=alarm status, L=load alarm rules, V=volume balance");
+  Debug->println("  Batches: b=apply steps as one batch, save/run/del/list stored macros");
+  Debug->println("  Communication: C=comm status + buffer pools, g=log stats + toggle raw log capture, B=multicast telemetry, X=USB bulk export, W=watch channels");
+  Debug->println("  OTA Updates: O=toggle OTA, U=OTA status");
+  Debug->println("  Emergency: x=stop all, z=stop specific pump");
+}
+
+/**
+ * @brief Execute a single CLI command
+ * @param cmd Command character read from Debug (Serial or Telnet)
+ */
+void cli_process_command(char cmd) {
+  switch (cmd) {
+    case 's':
+      calibration_print_status();
+      adc_cal_print_status();
+      sensor_print_ph_resolution();
+      probe_vote_print_status();
+      break;
+    case 'n':
+      // Redundant probes: counts, vote mode, tolerances, readmit, match
+      probe_vote_command();
+      break;
+    case 'k':
+      // Calibration history: list, diff, rollback, aging
+      cal_history_command();
+      break;
+    case 'o': {
+      // Cycle pH oversampling OFF -> 14 -> 15 -> 16 bits; 's' reports the measured resolution
+      uint8_t bits = sensor_get_ph_oversampling();
+      bits = bits == 0 ? 2 : (bits >= ADC_OVERSAMPLE_MAX_BITS ? 0 : bits + 1);
+      sensor_set_ph_oversampling(bits);
+      sensor_print_ph_resolution();
+      break;
+    }
+    case 'S':
+      state_machine_print_status();
+      crash_log_print();
+      break;
+    case 'C':
+      Debug->print_status();
+      watch_print_status();
+      break;
+    case 'W':
+      // Per-connection watch: reads "<channel> <seconds>" from whoever typed W
+      watch_command();
+      break;
+    case 'b':
+      // Batch: "<step>; <step>" applied as one unit, or save/run/del/list macros
+      macro_command();
+      break;
+    case 'g': {
+      // Log counters, then toggle the raw capture on the console
+      binlog_print_stats();
+      bool capture = !binlog_remove_raw_sink(cli_log_hex_sink) && binlog_add_raw_sink(cli_log_hex_sink);
+      Debug->printf("Raw log capture: %s", capture ? "ON (#BLG lines, decode with logdump)" : "OFF");
+      break;
+    }
+    case 'B': {
+      // Multicast telemetry: off -> ask for the group -> on
+      if (multicast_is_enabled()) {
+        multicast_enable(false);
+        multicast_print_status();
+        break;
+      }
+      if (pump_any_running()) {
+        // The prompt blocks loop(), which is what stops a running dose on time
+        Debug->println("ERROR: A pump is running - enable multicast when it stops");
+        break;
+      }
+      uint8_t group[4];
+      uint16_t port;
+      multicast_get_group(group, &port);
+      Debug->printf("Enter group a.b.c.d port (10s, none = %u.%u.%u.%u %u):", group[0], group[1], group[2], group[3], port);
+      char line[32];
+      if (Debug->read_line(line, sizeof(line), CLI_INPUT_TIMEOUT_MS)) {
+        long values[5];
+        bool valid = sscanf(line, "%ld.%ld.%ld.%ld %ld", &values[0], &values[1], &values[2], &values[3],
+                            &values[4]) == 5;
+        valid = valid && values[0] >= 224 && values[0] <= 239 && values[4] > 0 && values[4] <= 65535;
+        for (int i = 1; i < 4; i++) valid = valid && values[i] >= 0 && values[i] <= 255;
+        if (!valid) {
+          Debug->println("Invalid group (224.0.0.0-239.255.255.255, port 1-65535); multicast stays OFF");
+          break;
+        }
+        for (int i = 0; i < 4; i++) group[i] = (uint8_t)values[i];
+        multicast_set_group(group, (uint16_t)values[4]);
+      }
+      multicast_enable(true);
+      multicast_print_status();
+      break;
+    }
+    case 'X':
+      // Bulk export of history, logs and crash records (status if one is running)
+      if (usb_export_is_active()) {
+        usb_export_print_status();
+      } else if (usb_export_start()) {
+        Debug->println("USB export started on the native USB port (capture with the host tool usbdump)");
+      }
+      break;
+    case 'O':
+      if (Debug->is_ota_enabled()) {
+        Debug->disable_ota();
+      } else {
+        Debug->enable_ota();
+      }
+      break;
+    case 'U':
+      if (Debug->is_ota_enabled()) {
+        Debug->printf("OTA Status: %s", Debug->is_ota_in_progress() ? "Update in progress" : "Ready for updates");
+        Debug->printf("OTA Hostname: %s | Port: %d", "ESP32-Hydroponic", 3232);
+      } else {
+        Debug->println("OTA Status: Disabled (WiFi required)");
+      }
+      break;
+    case 'R':
+      Debug->println("Manual recovery attempted");
+      if (state_manager.system_state == SystemState::ERROR) {
+        system_transition_to(SystemState::MONITORING);
+        Debug->println("System recovered from ERROR state");
+      } else {
+        Debug->println("System not in ERROR state - no recovery needed");
+      }
+      break;
+    case 'M':
+      if (state_manager.system_state == SystemState::MAINTENANCE) {
+        system_transition_to(SystemState::MONITORING);
+        Debug->println("Maintenance mode OFF - system operational");
+      } else {
+        system_transition_to(SystemState::MAINTENANCE);
+        Debug->println("Maintenance mode ON - pumps disabled");
+      }
+      break;
+    case 'r':
+      calibration_reset();
+      calibration_save();
+      Debug->println("Calibration reset to defaults and saved");
+      break;
+    case 'p':
+      system_transition_to(SystemState::CALIBRATING);
+      calibration_transition_to(CalibrationState::ACTIVE);
+      calibration_interactive_ph();
+      calibration_transition_to(CalibrationState::IDLE);
+      system_transition_to(SystemState::MONITORING);
+      break;
+    case 'e':
+      system_transition_to(SystemState::CALIBRATING);
+      calibration_transition_to(CalibrationState::ACTIVE);
+      calibration_interactive_ec();
+      calibration_transition_to(CalibrationState::IDLE);
+      system_transition_to(SystemState::MONITORING);
+      break;
+    case 'v':
+      system_transition_to(SystemState::CALIBRATING);
+      calibration_transition_to(CalibrationState::ACTIVE);
+      calibration_interactive_volume();
+      calibration_transition_to(CalibrationState::IDLE);
+      volume_balance_init();   // New volume scale - restart the balance
+      system_transition_to(SystemState::MONITORING);
+      break;
+    case 'c':
+      system_transition_to(SystemState::CALIBRATING);
+      pump_interactive_pulse_calibration();
+      system_transition_to(SystemState::MONITORING);
+      break;
+    case 'd':
+      system_transition_to(SystemState::CALIBRATING);
+      pump_interactive_line_calibration();
+      system_transition_to(SystemState::MONITORING);
+      break;
+    case 'A':
+      alarm_print_status();
+      break;
+    case 'L':
+      alarm_interactive_rules();
+      break;
+    case 'V':
+      volume_balance_print_status();
+      break;
+    case 'a':
+      pump_enable_auto_ph(!pump_is_auto_ph_enabled());
+      Debug->printf("Auto pH control: %s", pump_is_auto_ph_enabled() ? "ON" : "OFF");
+      break;
+    case 'P':
+      pump_enable_ph_predictive(!pump_is_ph_predictive());
+      Debug->printf("pH dosing mode: %s", pump_is_ph_predictive() ? "PREDICTIVE (trend)" : "REACTIVE (PID)");
+      break;
+    case 'h': {
+      // Cycle the shadow pH controller: OFF -> PID -> PREDICTIVE -> OFF
+      PhPolicy policy = pump_get_ph_shadow();
+      PhPolicy next = policy == PhPolicy::OFF ? PhPolicy::PID
+                    : policy == PhPolicy::PID ? PhPolicy::PREDICTIVE : PhPolicy::OFF;
+      if (next == PhPolicy::OFF) {
+        pump_print_ph_shadow();
+        pump_set_ph_shadow(PhPolicy::OFF, 0.0f, 0.0f, 0.0f);
+        Debug->println("pH shadow controller: OFF");
+        break;
+      }
+      if (pump_any_running()) {
+        // The prompt blocks loop(), which is what stops a running dose on time
+        Debug->println("ERROR: A pump is running - start the shadow controller when it stops");
+        break;
+      }
+      float kp, ki, kd;
+      pump_get_ph_pid(&kp, &ki, &kd);
+      Debug->println("Enter shadow Kp Ki Kd (10s, none = live gains):");
+      char line[48];
+      if (Debug->read_line(line, sizeof(line), CLI_INPUT_TIMEOUT_MS)) {
+        float gains[3];
+        if (sscanf(line, "%f %f %f", &gains[0], &gains[1], &gains[2]) != 3 || !(gains[0] > 0.0f) ||
+            !(gains[1] >= 0.0f) || !(gains[2] >= 0.0f)) {
+          Debug->println("Invalid gains (Kp > 0, Ki and Kd >= 0); shadow controller unchanged");
+          break;
+        }
+        kp = gains[0];
+        ki = gains[1];
+        kd = gains[2];
+      }
+      pump_set_ph_shadow(next, kp, ki, kd);
+      Debug->printf("pH shadow controller: %s (Kp=%.1f, Ki=%.2f, Kd=%.1f), logging only",
+                    next == PhPolicy::PID ? "PID" : "PREDICTIVE", kp, ki, kd);
+      break;
+    }
+    case 'H':
+      pump_print_ph_shadow();
+      break;
+    case 'u':
+      pump_enable_micro_dosing(!pump_is_micro_dosing());
+      Debug->printf("Micro-dosing: %s", pump_is_micro_dosing() ? "ON (sub-minimum doses as timed pulses)" : "OFF");
+      break;
+    case 'f': {
+      // Cycle 1 (whole doses) -> 2 -> 3 -> 4 pieces per automatic dose
+      uint8_t count;
+      uint32_t gap_ms;
+      pump_get_dose_fractionation(&count, &gap_ms);
+      count = count >= 4 ? 1 : count + 1;
+      pump_set_dose_fractionation(count, gap_ms);
+      if (count > 1) {
+        Debug->printf("Dose fractionation: %d pieces, %lus mixing gaps", count, (unsigned long)(gap_ms / 1000));
+      } else {
+        Debug->println("Dose fractionation: OFF");
+      }
+      break;
+    }
+    case 't': {
+      Debug->println("Enter target pH (5.0-8.0): - Interactive mode simplified for Demo");
+      // For now, cycle through common pH targets
+      static float targets[] = {5.5, 6.0, 6.5, 7.0};
+      static int target_idx = 2;
+      target_idx = (target_idx + 1) % 4;
+      float target = targets[target_idx];
+      pump_set_ph_target(target);
+      Debug->printf("pH target set to %.1f", target);
+      break;
+    }
+    case 'E':
+      pump_enable_auto_ec(!pump_is_auto_ec_enabled());
+      Debug->printf("Auto EC control: %s", pump_is_auto_ec_enabled() ? "ON" : "OFF");
+      break;
+    case 'T': {
+      // Cycle through common EC targets (mS/cm)
+      static float ec_targets[] = {1.0, 1.5, 2.0, 2.5};
+      static int ec_target_idx = 1;
+      ec_target_idx = (ec_target_idx + 1) % 4;
+      pump_set_ec_target(ec_targets[ec_target_idx]);
+      Debug->printf("EC target set to %.1f mS/cm", ec_targets[ec_target_idx]);
+      break;
+    }
+    case 'K':
+      pump_enable_coupled_control(!pump_is_coupled_control());
+      Debug->printf("pH/EC dosing mode: %s", pump_is_coupled_control() ? "COUPLED (joint doses, learned cross-effects)" : "INDEPENDENT");
+      break;
+    case 'q':
+      pump_print_status();
+      break;
+    case 'm': {
+      Debug->println("Manual dose: Simplified - 10ml pH_Up for demo");
+      // Simplified manual dose for demo - always dose 10ml pH_Up
+      if (pump_manual_dose(PumpId::PH_UP, 10.0)) {
+        Debug->printf("Manual dose started: 10.0ml pH_Up");
+      } else {
+        Debug->println("Manual dose failed (safety limits or pump busy)");
+      }
+      break;
+    }
+    // Manual pump controls (Phase 2)
+    case '1': {
+      Debug->println("pH Up pump: Starting at 30 ml/min (demo)");
+      float rate = 30.0; // Default rate for demo
+      if (pump_start_manual(PumpId::PH_UP, rate)) {
+        Debug->printf("pH Up started at %.1f ml/min", rate);
+      } else {
+        Debug->println("Failed to start pH Up pump (already running or error)");
+      }
+      break;
+    }
+    case '2': {
+      Debug->println("pH Down pump: Starting at 25 ml/min (demo)");
+      float rate = 25.0;
+      if (pump_start_manual(PumpId::PH_DOWN, rate)) {
+        Debug->printf("pH Down started at %.1f ml/min", rate);
+      } else {
+        Debug->println("Failed to start pH Down pump (already running or error)");
+      }
+      break;
+    }
+    case '3': {
+      Debug->println("Nutrient A pump: Starting at 20 ml/min (demo)");
+      float rate = 20.0;
+      if (pump_start_manual(PumpId::NUTRIENT_A, rate)) {
+        Debug->printf("Nutrient A started at %.1f ml/min", rate);
+      } else {
+        Debug->println("Failed to start Nutrient A pump (already running or error)");
+      }
+      break;
+    }
+    case '4': {
+      Debug->println("Nutrient B pump: Starting at 20 ml/min (demo)");
+      float rate = 20.0;
+      if (pump_start_manual(PumpId::NUTRIENT_B, rate)) {
+        Debug->printf("Nutrient B started at %.1f ml/min", rate);
+      } else {
+        Debug->println("Failed to start Nutrient B pump (already running or error)");
+      }
+      break;
+    }
+    case 'x':
+      state_machine_emergency_stop();
+      pump_stop_all();
+      Debug->println("EMERGENCY STOP - All pumps stopped, system in ERROR state");
+      break;
+    case 'z': {
+      Debug->println("Stop pump: Stopping all pumps (demo)");
+      // For demo, stop all pumps
+      pump_stop_all();
+      Debug->println("All pumps stopped");
+      break;
+    }
+    default:
+      break;
+  }
+}
@@ -4,6 +4,7 @@
  */
 
 #include "communication.h"
+#include "block_pool.h"
 #include <stdarg.h>
 
 //=============================================================================
@@ -12,6 +13,11 @@
 
 CommunicationManager* Debug = nullptr;
 
+static_assert(sizeof(WiFiServer) <= POOL_CONNECTION_BLOCK, "telnet server does not fit a connection block");
+
+// Debug lives in static storage so re-initialising never touches the heap
+alignas(CommunicationManager) static uint8_t debug_storage[sizeof(CommunicationManager)];
+
 //=============================================================================
 // CONSTRUCTOR/DESTRUCTOR
 //=============================================================================
@@ -19,12 +25,15 @@ CommunicationManager* Debug = nullptr;
 CommunicationManager::CommunicationManager(const char* ssid, const char* password) 
   : wifi_ssid(ssid), wifi_password(password), current_state(CommState::SERIAL_ONLY),
     last_wifi_attempt(0), state_change_time(0), telnet_server(nullptr),
-    active_clients(0), last_input_source(InputSource::NONE), buffer_pos(0),
+    active_clients(0), last_input_source(InputSource::NONE), input_client(COMM_CLIENT_NONE),
+    reply_client(COMM_CLIENT_NONE), buffer_pos(0),
     ota_enabled(false), ota_in_progress(false), ota_progress_time(0) {
   
   // Clear client array
   for (int i = 0; i < MAX_TELNET_CLIENTS; i++) {
     telnet_clients[i] = WiFiClient();
+    client_session[i] = 0;
+    client_quiet[i] = false;
   }
   
   // Clear input buffer
@@ -32,10 +41,8 @@ CommunicationManager::CommunicationManager(const char* ssid, const char* passwor
 }
 
 CommunicationManager::~CommunicationManager() {
-  if (telnet_server) {
-    delete telnet_server;
-    telnet_server = nullptr;
-  }
+  pool_delete(PoolId::CONNECTION, telnet_server);
+  telnet_server = nullptr;
 }
 
 //=============================================================================
@@ -65,6 +72,9 @@ void CommunicationManager::begin() {
 void CommunicationManager::update() {
   uint32_t now = millis();
   
+  // Replies to the last command are over; quiet clients get broadcasts skipped again
+  reply_client = COMM_CLIENT_NONE;
+  
   // Update WiFi connection status
   update_wifi_connection();
   
@@ -83,10 +93,14 @@ void CommunicationManager::update() {
     case CommState::WIFI_CONNECTING:
       // Check for timeout or success
       if (WiFi.status() == WL_CONNECTED) {
-        // Create telnet server
+        // Create telnet server (connection pool; retried on the next connect if exhausted)
         if (!telnet_server) {
-          telnet_server = new WiFiServer(TELNET_PORT);
-          telnet_server->begin();
+          telnet_server = pool_new<WiFiServer>(PoolId::CONNECTION, TELNET_PORT);
+          if (telnet_server) {
+            telnet_server->begin();
+          } else {
+            Serial.println("Communication: connection pool exhausted - Telnet unavailable");
+          }
         }
         
         // Enable OTA automatically when WiFi connects
@@ -132,24 +146,72 @@ void CommunicationManager::println(const char* message) {
   uint32_t now = millis();
   
   // Always output to Serial (backup/emergency access)
-  if (current_state == CommState::SERIAL_ONLY) {
-    Serial.printf("[%lu] %s [Serial]\n", now, message);
-  } else {
-    Serial.printf("[%lu] %s [WiFi]\n", now, message);
-  }
+  write_serial_line(now, message);
   
-  // Output to telnet clients if WiFi is available
-  if (current_state == CommState::WIFI_PRIMARY) {
-    String telnet_msg = String("[") + String(now) + String("] ") + String(message) + String("\r\n");
-    
-    for (int i = 0; i < MAX_TELNET_CLIENTS; i++) {
-      if (telnet_clients[i] && telnet_clients[i].connected()) {
-        telnet_clients[i].print(telnet_msg);
+  // Output to telnet clients if WiFi is available (line built in a message block;
+  // dropped for Telnet, never for Serial, if the pool is exhausted)
+  if (current_state == CommState::WIFI_PRIMARY && active_clients > 0) {
+    char* telnet_msg = static_cast<char*>(pool_alloc(PoolId::MESSAGE));
+    if (telnet_msg) {
+      snprintf(telnet_msg, POOL_MESSAGE_BLOCK, "[%lu] %s\r\n", (unsigned long)now, message);
+      for (int i = 0; i < MAX_TELNET_CLIENTS; i++) {
+        if (client_quiet[i] && reply_client != i + 1) continue;
+        if (telnet_clients[i] && telnet_clients[i].connected()) {
+          telnet_clients[i].print(telnet_msg);
+        }
       }
+      pool_free(PoolId::MESSAGE, telnet_msg);
     }
   }
 }
 
+void CommunicationManager::write_serial_line(uint32_t now, const char* message) {
+  const char* tag = current_state == CommState::SERIAL_ONLY ? "Serial" : "WiFi";
+  Serial.printf("[%lu] %s [%s]\n", (unsigned long)now, message, tag);
+}
+
+/**
+ * @brief Write one line to a single client instead of everyone
+ * @param client COMM_CLIENT_SERIAL or Telnet slot + 1
+ * @return false if the client is not connected (or the line could not be built)
+ */
+bool CommunicationManager::print_to(uint8_t client, const char* message) {
+  uint32_t now = millis();
+  if (client == COMM_CLIENT_SERIAL) {
+    write_serial_line(now, message);
+    return true;
+  }
+  if (!is_client_connected(client)) return false;
+  char* telnet_msg = static_cast<char*>(pool_alloc(PoolId::MESSAGE));
+  if (!telnet_msg) return false;
+  snprintf(telnet_msg, POOL_MESSAGE_BLOCK, "[%lu] %s\r\n", (unsigned long)now, message);
+  telnet_clients[client - 1].print(telnet_msg);
+  pool_free(PoolId::MESSAGE, telnet_msg);
+  return true;
+}
+
+bool CommunicationManager::is_client_connected(uint8_t client) {
+  if (client == COMM_CLIENT_SERIAL) return true;
+  if (client == COMM_CLIENT_NONE || client > MAX_TELNET_CLIENTS) return false;
+  WiFiClient& telnet = telnet_clients[client - 1];
+  return current_state == CommState::WIFI_PRIMARY && telnet && telnet.connected();
+}
+
+uint8_t CommunicationManager::get_client_session(uint8_t client) {
+  if (client == COMM_CLIENT_NONE || client == COMM_CLIENT_SERIAL || client > MAX_TELNET_CLIENTS) return 0;
+  return client_session[client - 1];
+}
+
+void CommunicationManager::set_client_quiet(uint8_t client, bool quiet) {
+  if (client == COMM_CLIENT_NONE || client == COMM_CLIENT_SERIAL || client > MAX_TELNET_CLIENTS) return;
+  client_quiet[client - 1] = quiet;
+}
+
+bool CommunicationManager::is_client_quiet(uint8_t client) {
+  if (client == COMM_CLIENT_NONE || client == COMM_CLIENT_SERIAL || client > MAX_TELNET_CLIENTS) return false;
+  return client_quiet[client - 1];
+}
+
 void CommunicationManager::println(const String& message) {
   println(message.c_str());
 }
@@ -165,8 +227,13 @@ void CommunicationManager::printf(const char* format, ...) {
 }
 
 void CommunicationManager::print_status() {
-  String status = communication_get_status();
-  println(status.c_str());
+  char* status = static_cast<char*>(pool_alloc(PoolId::MESSAGE));
+  if (status) {
+    communication_get_status(status, POOL_MESSAGE_BLOCK);
+    println(status);
+    pool_free(PoolId::MESSAGE, status);
+  }
+  pool_print_status();
 }
 
 //=============================================================================
@@ -197,12 +264,14 @@ bool CommunicationManager::available() {
 char CommunicationManager::read() {
   // Priority: Serial first, then Telnet
   if (last_input_source == InputSource::SERIAL_USB && Serial.available()) {
+    input_client = reply_client = COMM_CLIENT_SERIAL;
     return Serial.read();
   }
   
   if (last_input_source == InputSource::TELNET_CLIENT) {
     for (int i = 0; i < MAX_TELNET_CLIENTS; i++) {
       if (telnet_clients[i] && telnet_clients[i].connected() && telnet_clients[i].available()) {
+        input_client = reply_client = (uint8_t)(i + 1);
         return telnet_clients[i].read();
       }
     }
@@ -211,6 +280,42 @@ char CommunicationManager::read() {
   return 0;
 }
 
+int CommunicationManager::read_from(uint8_t client) {
+  if (client == COMM_CLIENT_SERIAL) {
+    return Serial.available() ? Serial.read() : -1;
+  }
+  if (!is_client_connected(client)) return -1;
+  WiFiClient& telnet = telnet_clients[client - 1];
+  return telnet.available() ? telnet.read() : -1;
+}
+
+/**
+ * @brief Read one line from the client that sent the last command character
+ * Blocks like the numeric prompts do. Leading line ends (the rest of the
+ * command line) are skipped; Telnet negotiation bytes are dropped.
+ * @return true if a non-empty line arrived before the timeout
+ */
+bool CommunicationManager::read_line(char* out, size_t len, uint32_t timeout_ms) {
+  size_t n = 0;
+  uint32_t start = millis();
+  while (millis() - start < timeout_ms) {
+    int c = read_from(input_client);
+    if (c < 0) {
+      if (!is_client_connected(input_client)) break;
+      delay(10);
+      continue;
+    }
+    if (c == '\r' || c == '\n') {
+      if (n > 0) break;
+      continue;
+    }
+    if (c < 0x20 || c > 0x7E) continue;
+    if (n + 1 < len) out[n++] = (char)c;
+  }
+  out[n] = '\0';
+  return n > 0;
+}
+
 InputSource CommunicationManager::get_input_source() {
   return last_input_source;
 }
@@ -293,6 +398,8 @@ void CommunicationManager::handle_telnet_clients() {
     for (int i = 0; i < MAX_TELNET_CLIENTS; i++) {
       if (!telnet_clients[i] || !telnet_clients[i].connected()) {
         telnet_clients[i] = new_client;
+        client_session[i]++;
+        client_quiet[i] = false;
         telnet_clients[i].println("ESP32-S3 Hydroponic System - Telnet Interface");
         telnet_clients[i].println("Type 'q' for pump status, 'x' for emergency stop");
         client_added = true;
@@ -450,40 +557,39 @@ void CommunicationManager::disable_ota() {
 
 void communication_init(const char* ssid, const char* password) {
   if (Debug) {
-    delete Debug;
+    Debug->~CommunicationManager();
   }
   
-  Debug = new CommunicationManager(ssid, password);
+  Debug = new (debug_storage) CommunicationManager(ssid, password);
   Debug->begin();
 }
 
-String communication_get_status() {
-  if (!Debug) return "Communication not initialized";
-  
-  String status = "Communication Status: ";
+/**
+ * @brief Format the communication status line
+ * @param buffer Output (truncated to len)
+ * @param len Buffer size
+ */
+void communication_get_status(char* buffer, size_t len) {
+  if (!Debug) {
+    snprintf(buffer, len, "Communication not initialized");
+    return;
+  }
   
   switch (Debug->get_state()) {
     case CommState::SERIAL_ONLY:
-      status += "Serial Only";
+      snprintf(buffer, len, "Communication Status: Serial Only");
       break;
     case CommState::WIFI_CONNECTING:
-      status += "WiFi Connecting...";
+      snprintf(buffer, len, "Communication Status: WiFi Connecting...");
       break;
     case CommState::WIFI_PRIMARY:
-      status += "WiFi Primary (";
-      status += Debug->get_ip_address();
-      status += ") | Telnet: ";
-      status += Debug->get_client_count();
-      status += " clients | Serial: Backup";
-      if (Debug->is_ota_enabled()) {
-        status += " | OTA: ";
-        status += Debug->is_ota_in_progress() ? "Updating" : "Ready";
-      }
+      snprintf(buffer, len, "Communication Status: WiFi Primary (%s) | Telnet: %u clients | Serial: Backup%s%s",
+               Debug->get_ip_address(), Debug->get_client_count(),
+               Debug->is_ota_enabled() ? " | OTA: " : "",
+               Debug->is_ota_enabled() ? (Debug->is_ota_in_progress() ? "Updating" : "Ready") : "");
       break;
     case CommState::ERROR:
-      status += "Error";
+      snprintf(buffer, len, "Communication Status: Error");
       break;
   }
-  
-  return status;
-}
\ No newline at end of file
+}
@@ -0,0 +1,158 @@
+/**
+ * @file crash_log.cpp
+ * @brief Abnormal reset records from an RTC checkpoint and an NVS ring
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "crash_log.h"
+#include "state_machine.h"
+#include "communication.h"
+#include <Preferences.h>
+#include <esp_system.h>
+
+#ifndef RTC_NOINIT_ATTR
+#define RTC_NOINIT_ATTR
+#endif
+
+//=============================================================================
+// STATE
+//=============================================================================
+
+constexpr uint32_t CHECKPOINT_MAGIC = 0x43524153;    // "CRAS"
+
+/**
+ * @brief Last known state of the running system (RTC memory, not cleared on reset)
+ */
+struct crash_checkpoint_t {
+    uint32_t magic;
+    uint32_t boot;
+    uint32_t uptime_ms;
+    uint32_t system_state;
+    uint32_t check;                      // Guards against power-on garbage
+};
+
+/**
+ * @brief NVS blob: records oldest first
+ */
+struct crash_store_t {
+    uint8_t count;
+    crash_record_t records[CRASH_LOG_RECORDS];
+};
+
+RTC_NOINIT_ATTR static crash_checkpoint_t checkpoint;
+static crash_store_t store;
+static uint32_t boot_number = 0;
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+static uint32_t checkpoint_check(const crash_checkpoint_t& cp) {
+    return cp.magic ^ cp.boot ^ cp.uptime_ms ^ cp.system_state ^ 0xA5A5A5A5u;
+}
+
+static bool is_abnormal(esp_reset_reason_t reason) {
+    switch (reason) {
+        case ESP_RST_PANIC:
+        case ESP_RST_INT_WDT:
+        case ESP_RST_TASK_WDT:
+        case ESP_RST_WDT:
+        case ESP_RST_BROWNOUT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Count this boot and record the previous run if it ended abnormally
+ */
+void crash_log_init(void) {
+    Preferences prefs;
+    memset(&store, 0, sizeof(store));
+    if (!prefs.begin(CRASH_LOG_NVS_NAMESPACE, false)) {
+        Debug->println("Crash log: NVS unavailable");
+        return;
+    }
+    if (prefs.getBytesLength(CRASH_LOG_NVS_RECORDS_KEY) != sizeof(store) ||
+        prefs.getBytes(CRASH_LOG_NVS_RECORDS_KEY, &store, sizeof(store)) != sizeof(store) ||
+        store.count > CRASH_LOG_RECORDS) {
+        memset(&store, 0, sizeof(store));
+    }
+    boot_number = prefs.getUInt(CRASH_LOG_NVS_BOOTS_KEY, 0) + 1;
+    prefs.putUInt(CRASH_LOG_NVS_BOOTS_KEY, boot_number);
+
+    esp_reset_reason_t reason = esp_reset_reason();
+    if (is_abnormal(reason)) {
+        crash_record_t record = {};
+        record.reason = (uint8_t)reason;
+        if (checkpoint.magic == CHECKPOINT_MAGIC && checkpoint.check == checkpoint_check(checkpoint)) {
+            record.boot = checkpoint.boot;
+            record.uptime_ms = checkpoint.uptime_ms;
+            record.system_state = (uint8_t)checkpoint.system_state;
+        }
+        if (store.count == CRASH_LOG_RECORDS) {
+            memmove(&store.records[0], &store.records[1], sizeof(crash_record_t) * (CRASH_LOG_RECORDS - 1));
+            store.count--;
+        }
+        store.records[store.count++] = record;
+        prefs.putBytes(CRASH_LOG_NVS_RECORDS_KEY, &store, sizeof(store));
+        Debug->printf("Crash log: previous run (boot %lu) ended by %s after %lu s",
+                      (unsigned long)record.boot, crash_log_reason_to_string(record.reason),
+                      (unsigned long)(record.uptime_ms / 1000));
+    }
+    prefs.end();
+    crash_log_checkpoint((uint8_t)SystemState::STARTUP);
+}
+
+void crash_log_checkpoint(uint8_t system_state) {
+    checkpoint.magic = CHECKPOINT_MAGIC;
+    checkpoint.boot = boot_number;
+    checkpoint.uptime_ms = millis();
+    checkpoint.system_state = system_state;
+    checkpoint.check = checkpoint_check(checkpoint);
+}
+
+uint32_t crash_log_get_boot(void) {
+    return boot_number;
+}
+
+int crash_log_count(void) {
+    return store.count;
+}
+
+bool crash_log_get(int index, crash_record_t* out) {
+    if (index < 0 || index >= store.count) return false;
+    *out = store.records[index];
+    return true;
+}
+
+const char* crash_log_reason_to_string(uint8_t reason) {
+    switch ((esp_reset_reason_t)reason) {
+        case ESP_RST_POWERON:    return "POWER_ON";
+        case ESP_RST_EXT:        return "EXTERNAL";
+        case ESP_RST_SW:         return "SOFTWARE";
+        case ESP_RST_PANIC:      return "PANIC";
+        case ESP_RST_INT_WDT:    return "INTERRUPT_WDT";
+        case ESP_RST_TASK_WDT:   return "TASK_WDT";
+        case ESP_RST_WDT:        return "WDT";
+        case ESP_RST_DEEPSLEEP:  return "DEEP_SLEEP";
+        case ESP_RST_BROWNOUT:   return "BROWNOUT";
+        default:                 return "UNKNOWN";
+    }
+}
+
+void crash_log_print(void) {
+    Debug->printf("Crash log: boot %lu, %d record(s)", (unsigned long)boot_number, store.count);
+    for (int i = 0; i < store.count; i++) {
+        const crash_record_t& record = store.records[i];
+        Debug->printf("  boot %lu: %s after %lu s in %s", (unsigned long)record.boot,
+                      crash_log_reason_to_string(record.reason), (unsigned long)(record.uptime_ms / 1000),
+                      system_state_to_string((SystemState)record.system_state));
+    }
+}
@@ -0,0 +1,204 @@
+/**
+ * @file dose_model.cpp
+ * @brief Learned pH/EC dose-response model and joint dose planner implementation
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "dose_model.h"
+
+#include <math.h>
+#include <string.h>
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+static constexpr int kPh = static_cast<int>(DoseChannel::PH);
+static constexpr int kEc = static_cast<int>(DoseChannel::EC);
+static constexpr int kUp = static_cast<int>(DoseGroup::PH_UP);
+static constexpr int kDown = static_cast<int>(DoseGroup::PH_DOWN);
+static constexpr int kNutrient = static_cast<int>(DoseGroup::NUTRIENT);
+
+/**
+ * @brief Solve a x = b for a 3x3 system (Gaussian elimination, partial pivoting)
+ * @return false if the matrix is singular
+ */
+static bool solve3(float a[DOSE_GROUP_COUNT][DOSE_GROUP_COUNT], float b[DOSE_GROUP_COUNT],
+                   float x[DOSE_GROUP_COUNT]) {
+    const int n = DOSE_GROUP_COUNT;
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++) {
+            if (fabsf(a[row][col]) > fabsf(a[pivot][col])) pivot = row;
+        }
+        if (fabsf(a[pivot][col]) < 1e-9f) return false;
+        if (pivot != col) {
+            for (int k = 0; k < n; k++) {
+                float t = a[col][k]; a[col][k] = a[pivot][k]; a[pivot][k] = t;
+            }
+            float t = b[col]; b[col] = b[pivot]; b[pivot] = t;
+        }
+        for (int row = col + 1; row < n; row++) {
+            float f = a[row][col] / a[col][col];
+            for (int k = col; k < n; k++) a[row][k] -= f * a[col][k];
+            b[row] -= f * b[col];
+        }
+    }
+    for (int row = n - 1; row >= 0; row--) {
+        float sum = b[row];
+        for (int k = row + 1; k < n; k++) sum -= a[row][k] * x[k];
+        x[row] = sum / a[row][row];
+    }
+    return true;
+}
+
+/**
+ * @brief Recompute the estimate: (w I + gram) effect = w prior + moment, per channel
+ * Main effects (non-zero priors) keep their sign and stay within
+ * DOSE_MODEL_MAIN_MIN..MAX of the prior, so a noisy response can never make
+ * the planner dose the wrong chemical.
+ */
+static void dose_model_solve(dose_model_t* model) {
+    for (int c = 0; c < DOSE_CHANNEL_COUNT; c++) {
+        float a[DOSE_GROUP_COUNT][DOSE_GROUP_COUNT];
+        float b[DOSE_GROUP_COUNT];
+        float x[DOSE_GROUP_COUNT];
+        for (int i = 0; i < DOSE_GROUP_COUNT; i++) {
+            for (int j = 0; j < DOSE_GROUP_COUNT; j++) {
+                a[i][j] = model->gram[i][j] + (i == j ? DOSE_MODEL_PRIOR_WEIGHT : 0.0f);
+            }
+            b[i] = DOSE_MODEL_PRIOR_WEIGHT * model->prior[c][i] + model->moment[c][i];
+        }
+        if (!solve3(a, b, x)) continue;
+
+        for (int g = 0; g < DOSE_GROUP_COUNT; g++) {
+            float prior = model->prior[c][g];
+            if (prior != 0.0f) {
+                float ratio = constrain(x[g] / prior, DOSE_MODEL_MAIN_MIN, DOSE_MODEL_MAIN_MAX);
+                x[g] = prior * ratio;
+            }
+            model->effect[c][g] = x[g];
+        }
+    }
+}
+
+/**
+ * @brief Modelled residual errors and cost of a candidate dose
+ */
+static float plan_cost(const dose_model_t* model, const float u[DOSE_GROUP_COUNT], float ph_error, float ec_error,
+                       bool ec_active, float ph_band, float ec_band, float* ph_residual, float* ec_residual) {
+    float ph = ph_error;
+    float ec = ec_error;
+    float total = 0.0f;
+    for (int g = 0; g < DOSE_GROUP_COUNT; g++) {
+        ph -= model->effect[kPh][g] * u[g];
+        ec -= model->effect[kEc][g] * u[g];
+        total += u[g];
+    }
+    if (!ec_active) ec = 0.0f;
+    *ph_residual = ph;
+    *ec_residual = ec;
+    return (ph / ph_band) * (ph / ph_band) + (ec / ec_band) * (ec / ec_band) + DOSE_PLAN_ML_COST * total;
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Start from the prior with no observations
+ * @param prior effect[channel][group] per ml/L assumed before any dose is seen
+ */
+void dose_model_reset(dose_model_t* model, const float prior[DOSE_CHANNEL_COUNT][DOSE_GROUP_COUNT]) {
+    memset(model, 0, sizeof(*model));
+    memcpy(model->prior, prior, sizeof(model->prior));
+    memcpy(model->effect, prior, sizeof(model->effect));
+}
+
+/**
+ * @brief Learn from one mixed dose response
+ * @param ml_per_l Dose per group (as planned)
+ * @param d_ph Mixed pH change since the dose started
+ * @param d_ec Mixed EC change since the dose started
+ */
+void dose_model_learn(dose_model_t* model, const float ml_per_l[DOSE_GROUP_COUNT], float d_ph, float d_ec) {
+    float total = 0.0f;
+    for (int g = 0; g < DOSE_GROUP_COUNT; g++) total += ml_per_l[g];
+    if (total < DOSE_MODEL_MIN_STIMULUS) return;
+
+    for (int i = 0; i < DOSE_GROUP_COUNT; i++) {
+        for (int j = 0; j < DOSE_GROUP_COUNT; j++) {
+            model->gram[i][j] = DOSE_MODEL_FORGET * model->gram[i][j] + ml_per_l[i] * ml_per_l[j];
+        }
+        model->moment[kPh][i] = DOSE_MODEL_FORGET * model->moment[kPh][i] + ml_per_l[i] * d_ph;
+        model->moment[kEc][i] = DOSE_MODEL_FORGET * model->moment[kEc][i] + ml_per_l[i] * d_ec;
+    }
+    if (model->observations < 0xFFFF) model->observations++;
+    dose_model_solve(model);
+}
+
+/**
+ * @brief Plan one joint dose towards both targets
+ *
+ * Candidates are: a pH pump alone (hits pH), the nutrient pair alone (hits
+ * EC), or a pH pump plus nutrients solved together so both land on target
+ * with the cross-effects included. pH Up and pH Down are never combined. The
+ * cheapest candidate in band-normalised squared residual wins. EC can only
+ * be raised; an EC above target still penalises acid that would raise it
+ * further.
+ * @param ph_error pH target - pH
+ * @param ec_error EC target - EC
+ * @param ec_active false to leave EC uncontrolled (residual ignored)
+ * @return false when both channels are inside half their band, or the best
+ *         plan is no dose
+ */
+bool dose_model_plan(const dose_model_t* model, float ph_error, float ec_error, bool ec_active,
+                     float ph_band, float ec_band, dose_plan_t* plan) {
+    bool ph_out = fabsf(ph_error) >= ph_band * 0.5f;
+    bool ec_low = ec_active && ec_error >= ec_band * 0.5f;
+    if (!ph_out && !ec_low) return false;
+
+    const float (*e)[DOSE_GROUP_COUNT] = model->effect;
+    float candidates[6][DOSE_GROUP_COUNT];
+    int count = 0;
+    memset(candidates, 0, sizeof(candidates));
+    count++;                                                   // No dose
+
+    for (int p = kUp; p <= kDown; p++) {
+        float u = ph_error / e[kPh][p];
+        if (u > 0.0f) candidates[count++][p] = u;              // pH pump alone
+
+        if (!ec_active) continue;
+        float det = e[kPh][p] * e[kEc][kNutrient] - e[kPh][kNutrient] * e[kEc][p];
+        if (fabsf(det) < 1e-6f) continue;
+        float u_p = (ph_error * e[kEc][kNutrient] - e[kPh][kNutrient] * ec_error) / det;
+        float u_n = (e[kPh][p] * ec_error - ph_error * e[kEc][p]) / det;
+        if (u_p >= 0.0f && u_n >= 0.0f) {                      // Both targets exactly
+            candidates[count][p] = u_p;
+            candidates[count][kNutrient] = u_n;
+            count++;
+        }
+    }
+    if (ec_active && ec_error > 0.0f) {
+        candidates[count++][kNutrient] = ec_error / e[kEc][kNutrient];   // Nutrients alone
+    }
+
+    int best = 0;
+    float best_cost = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float scaled[DOSE_GROUP_COUNT];
+        for (int g = 0; g < DOSE_GROUP_COUNT; g++) scaled[g] = candidates[i][g] * DOSE_PLAN_GAIN;
+        float ph_residual, ec_residual;
+        float cost = plan_cost(model, scaled, ph_error, ec_error, ec_active, ph_band, ec_band,
+                               &ph_residual, &ec_residual);
+        if (i == 0 || cost < best_cost) {
+            best = i;
+            best_cost = cost;
+            memcpy(plan->ml_per_l, scaled, sizeof(plan->ml_per_l));
+            plan->ph_residual = ph_residual;
+            plan->ec_residual = ec_residual;
+        }
+    }
+    return best != 0;
+}
@@ -0,0 +1,464 @@
+/**
+ * @file macro.cpp
+ * @brief Batch compiler, all-or-nothing execution and NVS-stored macros
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "macro.h"
+#include "modbus.h"
+#include "communication.h"
+#include <Preferences.h>
+#include <ctype.h>
+
+static const char* kPumpKeys[static_cast<int>(PumpId::COUNT)] = {"ph_up", "ph_down", "nut_a", "nut_b"};
+
+//=============================================================================
+// COMPILER
+//=============================================================================
+
+static bool equals_nocase(const char* a, size_t len, const char* b) {
+    if (strlen(b) != len) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    }
+    return true;
+}
+
+static bool fail(macro_error_t* error, int step, const char* message) {
+    if (error) {
+        error->step = (uint8_t)step;
+        strncpy(error->message, message, sizeof(error->message) - 1);
+        error->message[sizeof(error->message) - 1] = '\0';
+    }
+    return false;
+}
+
+/**
+ * @brief Parse a plain decimal number (no exponent, no sign but '-')
+ */
+static bool parse_number(const char* text, size_t len, float* value) {
+    if (len == 0 || len > 12) return false;
+    char buffer[16];
+    memcpy(buffer, text, len);
+    buffer[len] = '\0';
+    for (size_t i = 0; i < len; i++) {
+        char c = buffer[i];
+        if (!isdigit((unsigned char)c) && c != '.' && !(c == '-' && i == 0)) return false;
+    }
+    char* end = nullptr;
+    float parsed = strtof(buffer, &end);
+    if (end != buffer + len || parsed != parsed) return false;
+    *value = parsed;
+    return true;
+}
+
+static int parse_pump(const char* text, size_t len) {
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        if (equals_nocase(text, len, kPumpKeys[i])) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Compile one step of up to three words
+ */
+static bool compile_step(const char* const* words, const size_t* lengths, int count,
+                         macro_step_t* step, int number, macro_error_t* error) {
+    const char* op = words[0];
+    size_t op_len = lengths[0];
+
+    if (equals_nocase(op, op_len, "auto_ph") || equals_nocase(op, op_len, "auto_ec")) {
+        if (count != 2) return fail(error, number, "expected on or off");
+        step->op = (tolower((unsigned char)op[5]) == 'p') ? MacroOp::AUTO_PH : MacroOp::AUTO_EC;
+        if (equals_nocase(words[1], lengths[1], "on")) step->value = 1.0f;
+        else if (equals_nocase(words[1], lengths[1], "off")) step->value = 0.0f;
+        else return fail(error, number, "expected on or off");
+        return true;
+    }
+    if (equals_nocase(op, op_len, "ph_target")) {
+        if (count != 2 || !parse_number(words[1], lengths[1], &step->value)) return fail(error, number, "expected a pH value");
+        if (step->value < 5.0f || step->value > 8.0f) return fail(error, number, "pH target outside 5.0-8.0");
+        step->op = MacroOp::PH_TARGET;
+        return true;
+    }
+    if (equals_nocase(op, op_len, "ec_target")) {
+        if (count != 2 || !parse_number(words[1], lengths[1], &step->value)) return fail(error, number, "expected an EC value");
+        if (step->value < 0.2f || step->value > 4.0f) return fail(error, number, "EC target outside 0.2-4.0");
+        step->op = MacroOp::EC_TARGET;
+        return true;
+    }
+    if (equals_nocase(op, op_len, "dose")) {
+        if (count != 3) return fail(error, number, "expected dose <pump> <ml>");
+        int pump = parse_pump(words[1], lengths[1]);
+        if (pump < 0) return fail(error, number, "unknown pump");
+        if (!parse_number(words[2], lengths[2], &step->value)) return fail(error, number, "expected a volume in ml");
+        if (step->value < PUMP_MICRO_MIN_VOLUME || step->value > PUMP_MAX_DOSE_VOLUME) {
+            return fail(error, number, "dose outside 0.2-25 ml");
+        }
+        step->op = MacroOp::DOSE;
+        step->pump = (uint8_t)pump;
+        return true;
+    }
+    if (equals_nocase(op, op_len, "stop")) {
+        if (count != 2) return fail(error, number, "expected stop <pump>|all");
+        if (equals_nocase(words[1], lengths[1], "all")) {
+            step->pump = MACRO_ALL_PUMPS;
+        } else {
+            int pump = parse_pump(words[1], lengths[1]);
+            if (pump < 0) return fail(error, number, "unknown pump");
+            step->pump = (uint8_t)pump;
+        }
+        step->op = MacroOp::STOP;
+        step->value = 0.0f;
+        return true;
+    }
+    return fail(error, number, "unknown command");
+}
+
+/**
+ * @brief Compile batch text (see macro.h); empty steps are skipped
+ * @return false with the first error; the batch is only written on success
+ */
+bool macro_compile(const char* text, size_t len, macro_batch_t* batch, macro_error_t* error) {
+    macro_batch_t result;
+    memset(&result, 0, sizeof(result));
+    uint8_t dosed = 0;
+    int number = 0;
+
+    size_t pos = 0;
+    while (pos < len) {
+        size_t end = pos;
+        while (end < len && text[end] != ';' && text[end] != '\n') end++;
+
+        const char* words[3];
+        size_t lengths[3];
+        int count = 0;
+        size_t i = pos;
+        while (i < end) {
+            while (i < end && isspace((unsigned char)text[i])) i++;
+            if (i >= end) break;
+            size_t start = i;
+            while (i < end && !isspace((unsigned char)text[i])) i++;
+            if (count == 3) return fail(error, number + 1, "too many words");
+            words[count] = text + start;
+            lengths[count] = i - start;
+            count++;
+        }
+        pos = end + 1;
+        if (count == 0) continue;
+
+        number++;
+        if (result.count >= MACRO_MAX_STEPS) return fail(error, number, "more than 12 steps");
+        macro_step_t* step = &result.steps[result.count];
+        if (!compile_step(words, lengths, count, step, number, error)) return false;
+        if (step->op == MacroOp::DOSE) {
+            if (dosed & (1u << step->pump)) return fail(error, number, "pump already dosed by this batch");
+            dosed |= (uint8_t)(1u << step->pump);
+        }
+        result.count++;
+    }
+    if (result.count == 0) return fail(error, 0, "no steps");
+
+    *batch = result;
+    return true;
+}
+
+/**
+ * @brief Macro names: 1-15 characters of a-z, 0-9 and '_'
+ */
+bool macro_valid_name(const char* name, size_t len) {
+    if (len == 0 || len >= MACRO_NAME_MAX) return false;
+    for (size_t i = 0; i < len; i++) {
+        char c = name[i];
+        if (!(c >= 'a' && c <= 'z') && !(c >= '0' && c <= '9') && c != '_') return false;
+    }
+    return true;
+}
+
+//=============================================================================
+// EXECUTION
+//=============================================================================
+
+/**
+ * @brief Check every dose, then apply all steps in order
+ *
+ * Called from the main loop, so the control cycle runs either before or after
+ * the whole batch. A dose refused despite the pre-check (the pump state
+ * changed under us) puts back the targets and auto flags the batch touched
+ * and stops the doses it started; those still count toward the hourly limit.
+ *
+ * @return false with the step that was refused
+ */
+bool macro_execute(const macro_batch_t& batch, macro_error_t* error) {
+    for (int i = 0; i < batch.count; i++) {
+        const macro_step_t& step = batch.steps[i];
+        if (step.op != MacroOp::DOSE) continue;
+        PumpId pump = static_cast<PumpId>(step.pump);
+        if (!pump_is_micro_dosing() && step.value < PUMP_MIN_DOSE_VOLUME) {
+            return fail(error, i + 1, "below 5 ml with micro-dosing off");
+        }
+        if (!pump_can_dose(pump)) {
+            return fail(error, i + 1, "pump busy, too soon or over hourly limit");
+        }
+    }
+
+    const float ph_target = pump_get_ph_target();
+    const float ec_target = pump_get_ec_target();
+    const bool auto_ph = pump_is_auto_ph_enabled();
+    const bool auto_ec = pump_is_auto_ec_enabled();
+    uint8_t touched = 0;                 // Bit per MacroOp changed so far
+    uint8_t started = 0;                 // Pumps dosed so far
+
+    for (int i = 0; i < batch.count; i++) {
+        const macro_step_t& step = batch.steps[i];
+        touched |= (uint8_t)(1u << static_cast<int>(step.op));
+        switch (step.op) {
+            case MacroOp::AUTO_PH:   pump_enable_auto_ph(step.value != 0.0f); break;
+            case MacroOp::AUTO_EC:   pump_enable_auto_ec(step.value != 0.0f); break;
+            case MacroOp::PH_TARGET: pump_set_ph_target(step.value); break;
+            case MacroOp::EC_TARGET: pump_set_ec_target(step.value); break;
+            case MacroOp::STOP:
+                for (int p = 0; p < static_cast<int>(PumpId::COUNT); p++) {
+                    if (step.pump == MACRO_ALL_PUMPS || step.pump == p) pump_stop_manual(static_cast<PumpId>(p));
+                }
+                break;
+            case MacroOp::DOSE:
+                if (pump_manual_dose(static_cast<PumpId>(step.pump), step.value)) {
+                    started |= (uint8_t)(1u << step.pump);
+                    break;
+                }
+                for (int p = 0; p < static_cast<int>(PumpId::COUNT); p++) {
+                    if (started & (1u << p)) pump_stop_manual(static_cast<PumpId>(p));
+                }
+                if (touched & (1u << static_cast<int>(MacroOp::PH_TARGET))) pump_set_ph_target(ph_target);
+                if (touched & (1u << static_cast<int>(MacroOp::EC_TARGET))) pump_set_ec_target(ec_target);
+                if (touched & (1u << static_cast<int>(MacroOp::AUTO_PH))) pump_enable_auto_ph(auto_ph);
+                if (touched & (1u << static_cast<int>(MacroOp::AUTO_EC))) pump_enable_auto_ec(auto_ec);
+                return fail(error, i + 1, "dose refused, batch rolled back");
+        }
+    }
+    return true;
+}
+
+static void print_error(const char* label, const macro_error_t& error) {
+    if (error.step > 0) {
+        Debug->printf("Batch %s: step %d: %s", label, error.step, error.message);
+    } else {
+        Debug->printf("Batch %s: %s", label, error.message);
+    }
+}
+
+/**
+ * @brief Compile and run batch text, reporting the outcome on Debug
+ */
+bool macro_run_text(const char* text, const char* label) {
+    macro_batch_t batch;
+    macro_error_t error;
+    if (!macro_compile(text, strlen(text), &batch, &error) || !macro_execute(batch, &error)) {
+        print_error(label, error);
+        return false;
+    }
+    Debug->printf("Batch %s: %d steps applied", label, batch.count);
+    return true;
+}
+
+//=============================================================================
+// STORED MACROS
+//=============================================================================
+
+static macro_record_t records[MACRO_SLOTS];
+
+static void slot_key(int slot, char* key) {
+    key[0] = 'm';
+    key[1] = (char)('0' + slot);
+    key[2] = '\0';
+}
+
+/**
+ * @brief Load the stored macros; unreadable slots are left free
+ */
+void macro_init(void) {
+    memset(records, 0, sizeof(records));
+    Preferences store;
+    if (!store.begin(MACRO_NVS_NAMESPACE, true)) return;
+    int loaded = 0;
+    for (int slot = 0; slot < MACRO_SLOTS; slot++) {
+        char key[4];
+        slot_key(slot, key);
+        macro_record_t record;
+        if (store.getBytesLength(key) != sizeof(record) ||
+            store.getBytes(key, &record, sizeof(record)) != sizeof(record)) {
+            continue;
+        }
+        record.name[MACRO_NAME_MAX - 1] = '\0';
+        record.text[MACRO_TEXT_MAX - 1] = '\0';
+        if (!macro_valid_name(record.name, strlen(record.name))) continue;
+        records[slot] = record;
+        loaded++;
+    }
+    store.end();
+    if (loaded > 0) {
+        Debug->printf("Macros: %d loaded", loaded);
+    }
+}
+
+int macro_find(const char* name) {
+    for (int slot = 0; slot < MACRO_SLOTS; slot++) {
+        if (records[slot].name[0] && strcmp(records[slot].name, name) == 0) return slot;
+    }
+    return -1;
+}
+
+bool macro_get(int slot, macro_record_t* out) {
+    if (slot < 0 || slot >= MACRO_SLOTS || records[slot].name[0] == '\0') return false;
+    *out = records[slot];
+    return true;
+}
+
+/**
+ * @brief Store a macro after compiling it; replaces a macro of the same name
+ * @return false if the name or steps are invalid, all slots are used or NVS failed
+ */
+bool macro_save(const char* name, const char* text) {
+    if (!macro_valid_name(name, strlen(name))) {
+        Debug->println("ERROR: Macro name must be 1-15 of a-z, 0-9, _");
+        return false;
+    }
+    if (strlen(text) >= MACRO_TEXT_MAX) {
+        Debug->println("ERROR: Macro text too long");
+        return false;
+    }
+    macro_batch_t batch;
+    macro_error_t error;
+    if (!macro_compile(text, strlen(text), &batch, &error)) {
+        print_error(name, error);
+        return false;
+    }
+
+    int slot = macro_find(name);
+    for (int i = 0; slot < 0 && i < MACRO_SLOTS; i++) {
+        if (records[i].name[0] == '\0') slot = i;
+    }
+    if (slot < 0) {
+        Debug->printf("ERROR: All %d macro slots used", MACRO_SLOTS);
+        return false;
+    }
+
+    macro_record_t record;
+    memset(&record, 0, sizeof(record));
+    strncpy(record.name, name, sizeof(record.name) - 1);
+    strncpy(record.text, text, sizeof(record.text) - 1);
+
+    char key[4];
+    slot_key(slot, key);
+    Preferences store;
+    bool stored = store.begin(MACRO_NVS_NAMESPACE, false) &&
+                  store.putBytes(key, &record, sizeof(record)) == sizeof(record);
+    store.end();
+    if (!stored) {
+        Debug->println("ERROR: Failed to store macro");
+        return false;
+    }
+    records[slot] = record;
+    Debug->printf("Macro %s saved in slot %d (%d steps)", name, slot + 1, batch.count);
+    return true;
+}
+
+bool macro_delete(const char* name) {
+    int slot = macro_find(name);
+    if (slot < 0) return false;
+    char key[4];
+    slot_key(slot, key);
+    Preferences store;
+    if (store.begin(MACRO_NVS_NAMESPACE, false)) {
+        store.remove(key);
+        store.end();
+    }
+    memset(&records[slot], 0, sizeof(records[slot]));
+    return true;
+}
+
+/**
+ * @brief Run a stored macro (0-based slot)
+ */
+bool macro_run_slot(int slot) {
+    if (slot < 0 || slot >= MACRO_SLOTS || records[slot].name[0] == '\0') return false;
+    return macro_run_text(records[slot].text, records[slot].name);
+}
+
+//=============================================================================
+// CONSOLE
+//=============================================================================
+
+static const char* skip_word(const char* text, size_t* len) {
+    while (*text == ' ') text++;
+    const char* start = text;
+    while (*text && *text != ' ') text++;
+    *len = (size_t)(text - start);
+    return start;
+}
+
+static bool starts_with_word(const char* text, const char* word) {
+    size_t len = strlen(word);
+    return strncmp(text, word, len) == 0 && (text[len] == ' ' || text[len] == '\0');
+}
+
+/**
+ * @brief 'b': read one line - batch steps, or save/run/del/list
+ */
+void macro_command(void) {
+    char line[MACRO_NAME_MAX + MACRO_TEXT_MAX + 8];
+    // The prompt blocks loop(), which is what stops a running dose on time
+    if (pump_any_running()) {
+        Debug->println("ERROR: A pump is running - enter the batch when it stops");
+        return;
+    }
+    Debug->println("Batch (10s): <steps> | save <name> <steps> | run <name> | del <name> | list");
+    Debug->read_line(line, sizeof(line), MACRO_INPUT_TIMEOUT_MS);
+    const char* text = line;
+    while (*text == ' ') text++;
+
+    if (*text == '\0' || starts_with_word(text, "list")) {
+        macro_print_status();
+        return;
+    }
+    if (starts_with_word(text, "save") || starts_with_word(text, "run") || starts_with_word(text, "del")) {
+        char verb = text[0];
+        size_t len;
+        const char* name_start = skip_word(text + (verb == 's' ? 4 : 3), &len);
+        char name[MACRO_NAME_MAX];
+        if (!macro_valid_name(name_start, len)) {
+            Debug->println("ERROR: Macro name must be 1-15 of a-z, 0-9, _");
+            return;
+        }
+        memcpy(name, name_start, len);
+        name[len] = '\0';
+
+        if (verb == 's') {
+            const char* steps = name_start + len;
+            while (*steps == ' ') steps++;
+            macro_save(name, steps);
+        } else if (macro_find(name) < 0) {
+            Debug->printf("ERROR: No macro named %s", name);
+        } else if (verb == 'r') {
+            macro_run_slot(macro_find(name));
+        } else {
+            macro_delete(name);
+            Debug->printf("Macro %s deleted", name);
+        }
+        return;
+    }
+    macro_run_text(text, "console");
+}
+
+void macro_print_status(void) {
+    int used = 0;
+    for (int slot = 0; slot < MACRO_SLOTS; slot++) {
+        if (records[slot].name[0] == '\0') continue;
+        Debug->printf("  Macro %d %-15s %s", slot + 1, records[slot].name, records[slot].text);
+        used++;
+    }
+    Debug->printf("Macros: %d/%d slots used (Modbus HR %d runs slot 1-%d)", used, MACRO_SLOTS,
+                  MODBUS_HR_MACRO, MACRO_SLOTS);
+}
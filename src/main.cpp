@@ -15,6 +15,20 @@
 #include "pump.h"
 #include "state_machine.h"
 #include "communication.h"
+#include "cli.h"
+#include "alarms.h"
+#include "volume_balance.h"
+#include "binlog.h"
+#include "block_pool.h"
+#include "telemetry.h"
+#include "modbus.h"
+#include "websocket.h"
+#include "multicast.h"
+#include "crash_log.h"
+#include "usb_export.h"
+#include "watch.h"
+#include "macro.h"
+#include "cal_history.h"
 
 //=============================================================================
 // GLOBAL VARIABLES
@@ -36,11 +50,21 @@ const char* WIFI_PASSWORD = "GMQB4R03JK";
  * Configures hardware and initializes sensor system
  */
 void setup() {
+  // Deferred log ring first: any module may log from here on
+  binlog_init();
+  
+  // Fixed-block pools for network, telemetry and command buffers
+  pool_init();
+  
   // Initialize hybrid communication system (WiFi + Serial)
   communication_init(WIFI_SSID, WIFI_PASSWORD);
   
   Debug->println("ESP32-S3 Sensor System Starting...");
   Debug->println("Hybrid Communication: WiFi Primary, Serial Backup");
+  Debug->printf("Board: %s", Board::name);
+  
+  // Count this boot and record how the previous run ended (panic, watchdog, brownout)
+  crash_log_init();
   
   // Initialize state machine (starts in SystemState::STARTUP)
   state_machine_init();
@@ -54,6 +78,9 @@ void setup() {
   // Load calibration from NVS
   calibration_load();
   
+  // Operating-hours clock of the calibration history (records stay in NVS)
+  cal_history_init();
+  
   // Initialize sensor system
   if (sensor_initialize()) {
     Debug->println("Sensor system initialized successfully");
@@ -73,17 +100,40 @@ void setup() {
     return;
   }
   
+  // Calibration fitted on another ADC scale (linear vs eFuse curve) pauses automatic dosing
+  calibration_check_adc_scale();
+  
+  // Load and compile alarm rules (stored set or defaults)
+  alarm_init();
+  
+  // Stored command macros ('b', Modbus HR 8)
+  macro_init();
+  
+  // Binary telemetry stream for collectors (alarms publish through their sink)
+  telemetry_init();
+  
+  // Modbus TCP register map for SCADA (tracks published readings)
+  modbus_init();
+  
+  // WebSocket live stream for dashboards (fan-out of published telemetry)
+  websocket_init();
+  
+  // Optional UDP multicast of telemetry frames (off until enabled with 'B')
+  multicast_init();
+  
+  // Binary bulk export of history, logs and crash records ('X' or the host tool)
+  usb_export_init();
+  
+  // Per-connection watch lines on the console ('W'), served from a snapshot
+  watch_init();
+  
+  // Start volume balance (leak vs evaporation) from the first valid reading
+  volume_balance_init();
+  
   // Optional: initialize task wrappers (stubs when disabled)
  
 
-  Debug->println("CLI Commands:");
-  Debug->println("  Calibration: s=show cal, r=reset cal, p=pH cal, e=EC cal, v=volume cal");
-  Debug->println("  Auto pH: a=auto pH, t=pH target, q=pump status, m=manual dose");
-  Debug->println("  Manual Pumps: 1=pH_Up, 2=pH_Down, 3=Nut_A, 4=Nut_B");
-  Debug->println("  State Machine: S=show all states, R=recover from error, M=maintenance mode");
-  Debug->println("  Communication: C=comm status");
-  Debug->println("  OTA Updates: O=toggle OTA, U=OTA status");
-  Debug->println("  Emergency: x=stop all, z=stop specific pump");
+  cli_print_help();
   
   // Complete initialization - transition to monitoring
   system_transition_to(SystemState::MONITORING);
@@ -94,9 +144,30 @@ void setup() {
  * Non-blocking sensor reading and data output
  */
 void loop() {
+  // Last known uptime and state, kept across a crash reset
+  crash_log_checkpoint((uint8_t)state_manager.system_state);
+  
+  // Operating hours for calibration records (NVS once an hour)
+  cal_history_tick();
+  
   // Update communication manager (handles WiFi state machine and client connections)
   Debug->update();
   
+  // Accept/retire telemetry stream clients
+  telemetry_update();
+  
+  // Answer Modbus requests from the register snapshot
+  modbus_update();
+  
+  // WebSocket handshakes, client frames and rate-limited sends
+  websocket_update();
+  
+  // Next slice of a running bulk export
+  usb_export_update();
+  
+  // Console watch lines that are due, each connection at its own periods
+  watch_update();
+  
   // Update state machine (handles automatic transitions and timeouts)
   state_machine_update();
   
@@ -110,15 +181,28 @@ void loop() {
       // Output data if reading is valid
       if (readings.valid) {
         sensor_print_readings(readings);
+        telemetry_publish_reading(readings);
+        
+        // Volume balance: may pause automatic dosing on a suspected leak
+        volume_balance_update(readings);
         
-        // Automatic pH dosing if enabled (transitions to DOSING state)
-        if (pump_is_auto_ph_enabled()) {
+        // Evaluate alarm rules against this reading (publishes transitions)
+        alarm_update(readings);
+        
+        // Automatic pH/EC dosing if enabled (transitions to DOSING state)
+        if (pump_is_auto_ph_enabled() || pump_is_auto_ec_enabled()) {
           system_transition_to(SystemState::DOSING);
-          pump_ph_dose(readings.ph, readings.volume);
+          if (pump_is_coupled_control() && pump_is_auto_ph_enabled() && pump_is_auto_ec_enabled()) {
+            pump_coupled_dose(readings.ph, readings.ec, readings.volume);
+          } else {
+            pump_ph_dose(readings.ph, readings.volume);
+            pump_ec_dose(readings.ec, readings.volume);
+          }
           system_transition_to(SystemState::MONITORING);
         }
-      } else {
-        // Sensor reading failed - increment error counter
+      } else if (state_manager.sensor_state == SensorState::READY) {
+        // A full read cycle completed with invalid data - increment error counter
+        // (WARMING_UP/READING/FILTERING return no data yet and are not failures)
         static uint8_t sensor_error_count = 0;
         sensor_error_count++;
         
@@ -136,159 +220,9 @@ void loop() {
   
   // CLI handling is always available (except during SHUTDOWN)
   if (state_manager.system_state != SystemState::SHUTDOWN && Debug->available()) {
-    char cmd = Debug->read();
-    switch (cmd) {
-      case 's':
-        calibration_print_status();
-        break;
-      case 'S':
-        state_machine_print_status();
-        break;
-      case 'C':
-        Debug->print_status();
-        break;
-      case 'O':
-        if (Debug->is_ota_enabled()) {
-          Debug->disable_ota();
-        } else {
-          Debug->enable_ota();
-        }
-        break;
-      case 'U':
-        if (Debug->is_ota_enabled()) {
-          Debug->printf("OTA Status: %s", Debug->is_ota_in_progress() ? "Update in progress" : "Ready for updates");
-          Debug->printf("OTA Hostname: %s | Port: %d", "ESP32-Hydroponic", 3232);
-        } else {
-          Debug->println("OTA Status: Disabled (WiFi required)");
-        }
-        break;
-      case 'R':
-        Debug->println("Manual recovery attempted");
-        if (state_manager.system_state == SystemState::ERROR) {
-          system_transition_to(SystemState::MONITORING);
-          Debug->println("System recovered from ERROR state");
-        } else {
-          Debug->println("System not in ERROR state - no recovery needed");
-        }
-        break;
-      case 'M':
-        if (state_manager.system_state == SystemState::MAINTENANCE) {
-          system_transition_to(SystemState::MONITORING);
-          Debug->println("Maintenance mode OFF - system operational");
-        } else {
-          system_transition_to(SystemState::MAINTENANCE);
-          Debug->println("Maintenance mode ON - pumps disabled");
-        }
-        break;
-      case 'r':
-        calibration_reset();
-        calibration_save();
-        Debug->println("Calibration reset to defaults and saved");
-        break;
-      case 'p':
-        system_transition_to(SystemState::CALIBRATING);
-        calibration_transition_to(CalibrationState::ACTIVE);
-        calibration_interactive_ph();
-        calibration_transition_to(CalibrationState::IDLE);
-        system_transition_to(SystemState::MONITORING);
-        break;
-      case 'e':
-        system_transition_to(SystemState::CALIBRATING);
-        calibration_transition_to(CalibrationState::ACTIVE);
-        calibration_interactive_ec();
-        calibration_transition_to(CalibrationState::IDLE);
-        system_transition_to(SystemState::MONITORING);
-        break;
-      case 'v':
-        system_transition_to(SystemState::CALIBRATING);
-        calibration_transition_to(CalibrationState::ACTIVE);
-        calibration_interactive_volume();
-        calibration_transition_to(CalibrationState::IDLE);
-        system_transition_to(SystemState::MONITORING);
-        break;
-      case 'a':
-        pump_enable_auto_ph(!pump_is_auto_ph_enabled());
-        Debug->printf("Auto pH control: %s", pump_is_auto_ph_enabled() ? "ON" : "OFF");
-        break;
-      case 't': {
-        Debug->println("Enter target pH (5.0-8.0): - Interactive mode simplified for Demo");
-        // For now, cycle through common pH targets
-        static float targets[] = {5.5, 6.0, 6.5, 7.0};
-        static int target_idx = 2;
-        target_idx = (target_idx + 1) % 4;
-        float target = targets[target_idx];
-        pump_set_ph_target(target);
-        Debug->printf("pH target set to %.1f", target);
-        break;
-      }
-      case 'q':
-        pump_print_status();
-        break;
-      case 'm': {
-        Debug->println("Manual dose: Simplified - 10ml pH_Up for demo");
-        // Simplified manual dose for demo - always dose 10ml pH_Up
-        if (pump_manual_dose(PumpId::PH_UP, 10.0)) {
-          Debug->printf("Manual dose started: 10.0ml pH_Up");
-        } else {
-          Debug->println("Manual dose failed (safety limits or pump busy)");
-        }
-        break;
-      }
-      // Manual pump controls (Phase 2)
-      case '1': {
-        Debug->println("pH Up pump: Starting at 30 ml/min (demo)");
-        float rate = 30.0; // Default rate for demo
-        if (pump_start_manual(PumpId::PH_UP, rate)) {
-          Debug->printf("pH Up started at %.1f ml/min", rate);
-        } else {
-          Debug->println("Failed to start pH Up pump (already running or error)");
-        }
-        break;
-      }
-      case '2': {
-        Debug->println("pH Down pump: Starting at 25 ml/min (demo)");
-        float rate = 25.0;
-        if (pump_start_manual(PumpId::PH_DOWN, rate)) {
-          Debug->printf("pH Down started at %.1f ml/min", rate);
-        } else {
-          Debug->println("Failed to start pH Down pump (already running or error)");
-        }
-        break;
-      }
-      case '3': {
-        Debug->println("Nutrient A pump: Starting at 20 ml/min (demo)");
-        float rate = 20.0;
-        if (pump_start_manual(PumpId::NUTRIENT_A, rate)) {
-          Debug->printf("Nutrient A started at %.1f ml/min", rate);
-        } else {
-          Debug->println("Failed to start Nutrient A pump (already running or error)");
-        }
-        break;
-      }
-      case '4': {
-        Debug->println("Nutrient B pump: Starting at 20 ml/min (demo)");
-        float rate = 20.0;
-        if (pump_start_manual(PumpId::NUTRIENT_B, rate)) {
-          Debug->printf("Nutrient B started at %.1f ml/min", rate);
-        } else {
-          Debug->println("Failed to start Nutrient B pump (already running or error)");
-        }
-        break;
-      }
-      case 'x':
-        state_machine_emergency_stop();
-        pump_stop_all();
-        Debug->println("EMERGENCY STOP - All pumps stopped, system in ERROR state");
-        break;
-      case 'z': {
-        Debug->println("Stop pump: Stopping all pumps (demo)");
-        // For demo, stop all pumps
-        pump_stop_all();
-        Debug->println("All pumps stopped");
-        break;
-      }
-      default:
-        break;
-    }
+    cli_process_command(Debug->read());
   }
+  
+  // Format deferred log records (bounded per pass to keep the loop period)
+  binlog_drain(BINLOG_DRAIN_PER_LOOP);
 }
\ No newline at end of file
@@ -0,0 +1,440 @@
+/**
+ * @file modbus.cpp
+ * @brief Modbus TCP slave: register snapshot, request handler and server
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "modbus.h"
+#include "telemetry.h"
+#include "pump.h"
+#include "macro.h"
+#include "state_machine.h"
+#include "communication.h"
+#include "block_pool.h"
+#include <WiFi.h>
+
+static_assert(MODBUS_ADU_MAX <= POOL_FRAME_BLOCK, "Modbus receive buffer does not fit a frame block");
+
+// Flow of a coil-started manual run (same as console keys 1-4)
+static const float kManualFlow[static_cast<int>(PumpId::COUNT)] = {30.0f, 25.0f, 20.0f, 20.0f};
+
+//=============================================================================
+// STATE
+//=============================================================================
+
+struct modbus_connection_t {
+    WiFiClient* client;                  // CONNECTION pool
+    uint8_t* rx;                         // FRAME pool, MODBUS_ADU_MAX bytes
+    size_t rx_len;
+};
+
+static modbus_snapshot_t snapshot;
+static modbus_stats_t stats;
+static sensor_readings_t latest_reading;
+static bool have_reading = false;
+static uint16_t reading_count = 0;
+
+static WiFiServer* modbus_server = nullptr;
+static modbus_connection_t clients[MODBUS_MAX_CLIENTS];
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+static inline uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static void put_u32_words(uint16_t* regs, uint32_t v) {
+    regs[0] = (uint16_t)(v >> 16);
+    regs[1] = (uint16_t)v;
+}
+
+static void on_telemetry(const telemetry_event_t& event, const uint8_t* frame, size_t len) {
+    (void)frame;
+    (void)len;
+    if (event.type == TelemetryType::READING) {
+        latest_reading = event.reading;
+        have_reading = true;
+        reading_count++;
+    }
+}
+
+/**
+ * @brief Validate a holding register write without applying it
+ * @return 0 or a Modbus exception code
+ */
+static uint8_t check_holding(uint16_t address, uint16_t value) {
+    switch (address) {
+        case MODBUS_HR_PH_TARGET:
+            return (value >= 5000 && value <= 8000) ? 0 : MODBUS_EX_ILLEGAL_VALUE;
+        case MODBUS_HR_EC_TARGET:
+            return (value >= 200 && value <= 4000) ? 0 : MODBUS_EX_ILLEGAL_VALUE;
+        case MODBUS_HR_AUTO_PH:
+        case MODBUS_HR_AUTO_EC:
+            return value <= 1 ? 0 : MODBUS_EX_ILLEGAL_VALUE;
+        case MODBUS_HR_MACRO: {
+            macro_record_t record;
+            return (value >= 1 && macro_get(value - 1, &record)) ? 0 : MODBUS_EX_ILLEGAL_VALUE;
+        }
+        default:
+            if (address >= MODBUS_HR_DOSE && address < MODBUS_HR_DOSE + static_cast<int>(PumpId::COUNT)) {
+                return (value >= 1 && value <= (uint16_t)(PUMP_MAX_DOSE_VOLUME * 10)) ? 0 : MODBUS_EX_ILLEGAL_VALUE;
+            }
+            return MODBUS_EX_ILLEGAL_ADDRESS;
+    }
+}
+
+static bool apply_holding(uint16_t address, uint16_t value) {
+    switch (address) {
+        case MODBUS_HR_PH_TARGET:
+            pump_set_ph_target(value / 1000.0f);
+            return true;
+        case MODBUS_HR_EC_TARGET:
+            pump_set_ec_target(value / 1000.0f);
+            return true;
+        case MODBUS_HR_AUTO_PH:
+            pump_enable_auto_ph(value != 0);
+            return true;
+        case MODBUS_HR_AUTO_EC:
+            pump_enable_auto_ec(value != 0);
+            return true;
+        case MODBUS_HR_MACRO:
+            return macro_run_slot(value - 1);
+        default:
+            return pump_manual_dose(static_cast<PumpId>(address - MODBUS_HR_DOSE), value / 10.0f);
+    }
+}
+
+static uint8_t check_coil(uint16_t address, bool on) {
+    if (address >= MODBUS_COIL_COUNT) return MODBUS_EX_ILLEGAL_ADDRESS;
+    if (address == MODBUS_COIL_ESTOP && !on && state_manager.system_state == SystemState::ERROR) {
+        return MODBUS_EX_ILLEGAL_VALUE;                  // Latched: released on the console only
+    }
+    return 0;
+}
+
+static bool apply_coil(uint16_t address, bool on) {
+    if (address == MODBUS_COIL_ESTOP) {
+        if (on) {
+            state_machine_emergency_stop();
+            pump_stop_all();
+            Debug->println("EMERGENCY STOP (Modbus) - All pumps stopped, system in ERROR state");
+        }
+        return true;
+    }
+    PumpId pump = static_cast<PumpId>(address - MODBUS_COIL_PUMP);
+    if (!on) return pump_stop_manual(pump);
+    if (pump_is_running(pump)) return true;
+    return pump_start_manual(pump, kManualFlow[address - MODBUS_COIL_PUMP]);
+}
+
+//=============================================================================
+// SNAPSHOT
+//=============================================================================
+
+/**
+ * @brief Rebuild the register image from state the firmware already holds
+ * No sensor or ADC access: the reading is the last one published.
+ */
+void modbus_refresh_snapshot(void) {
+    uint32_t now = millis();
+    modbus_snapshot_t s = {};
+
+    if (have_reading) {
+        s.input[MODBUS_IR_PH] = (uint16_t)telemetry_scale(latest_reading.ph, TELEMETRY_PH_SCALE);
+        s.input[MODBUS_IR_EC] = (uint16_t)telemetry_scale(latest_reading.ec, TELEMETRY_EC_SCALE);
+        s.input[MODBUS_IR_VOLUME] = (uint16_t)telemetry_scale(latest_reading.volume, TELEMETRY_VOLUME_SCALE);
+        s.input[MODBUS_IR_TEMPERATURE] = (uint16_t)telemetry_scale(latest_reading.temperature, TELEMETRY_TEMP_SCALE);
+        uint32_t age_s = (now - latest_reading.timestamp) / 1000;
+        s.input[MODBUS_IR_READING_AGE] = (uint16_t)(age_s < 0xFFFE ? age_s : 0xFFFE);
+    } else {
+        s.input[MODBUS_IR_READING_AGE] = 0xFFFF;
+    }
+    s.input[MODBUS_IR_READING_COUNT] = reading_count;
+    s.input[MODBUS_IR_SYSTEM_STATE] = static_cast<uint16_t>(state_manager.system_state);
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        PumpId pump = static_cast<PumpId>(i);
+        s.input[MODBUS_IR_PUMP_STATE + i] = static_cast<uint16_t>(state_manager.pump_states[i]);
+        put_u32_words(&s.input[MODBUS_IR_TOTAL_DOSED + 2 * i], (uint32_t)lroundf(pump_get_total_dosed(pump) * 10.0f));
+        if (pump_is_running(pump)) s.coils |= 1u << (MODBUS_COIL_PUMP + i);
+    }
+    s.input[MODBUS_IR_INHIBIT] = pump_get_auto_inhibit();
+    put_u32_words(&s.input[MODBUS_IR_UPTIME], now / 1000);
+
+    s.holding[MODBUS_HR_PH_TARGET] = (uint16_t)lroundf(pump_get_ph_target() * 1000.0f);
+    s.holding[MODBUS_HR_EC_TARGET] = (uint16_t)lroundf(pump_get_ec_target() * 1000.0f);
+    s.holding[MODBUS_HR_AUTO_PH] = pump_is_auto_ph_enabled() ? 1 : 0;
+    s.holding[MODBUS_HR_AUTO_EC] = pump_is_auto_ec_enabled() ? 1 : 0;
+    if (state_manager.system_state == SystemState::ERROR) s.coils |= 1u << MODBUS_COIL_ESTOP;
+
+    s.taken_at = now;
+    snapshot = s;
+}
+
+const modbus_snapshot_t& modbus_get_snapshot(void) {
+    return snapshot;
+}
+
+//=============================================================================
+// REQUEST HANDLER
+//=============================================================================
+
+/**
+ * @brief Length of the ADU starting at data, from its MBAP header
+ * @return Total bytes, 0 if the header is incomplete, -1 if it is not Modbus TCP
+ */
+int modbus_adu_length(const uint8_t* data, size_t len) {
+    if (len < MODBUS_MBAP_LEN) return 0;
+    uint16_t protocol = get_u16(data + 2);
+    uint16_t length = get_u16(data + 4);                 // Unit id + PDU
+    if (protocol != 0 || length < 2 || length > MODBUS_ADU_MAX - 6) return -1;
+    return 6 + length;
+}
+
+/**
+ * @brief PDU for one request; returns 0 or an exception code
+ * @param out Response PDU (function code first), *out_len set on success
+ */
+static uint8_t handle_pdu(const uint8_t* pdu, size_t len, uint8_t* out, size_t* out_len, bool* wrote) {
+    uint8_t function = pdu[0];
+    switch (function) {
+        case MODBUS_FC_READ_COILS: {
+            if (len != 5) return MODBUS_EX_ILLEGAL_VALUE;
+            uint16_t address = get_u16(pdu + 1), count = get_u16(pdu + 3);
+            if (count < 1 || count > 2000) return MODBUS_EX_ILLEGAL_VALUE;
+            if ((uint32_t)address + count > MODBUS_COIL_COUNT) return MODBUS_EX_ILLEGAL_ADDRESS;
+            out[0] = function;
+            out[1] = (uint8_t)((count + 7) / 8);
+            memset(out + 2, 0, out[1]);
+            for (uint16_t i = 0; i < count; i++) {
+                if (snapshot.coils & (1u << (address + i))) out[2 + i / 8] |= (uint8_t)(1u << (i % 8));
+            }
+            *out_len = 2 + out[1];
+            return 0;
+        }
+        case MODBUS_FC_READ_HOLDING:
+        case MODBUS_FC_READ_INPUT: {
+            if (len != 5) return MODBUS_EX_ILLEGAL_VALUE;
+            uint16_t address = get_u16(pdu + 1), count = get_u16(pdu + 3);
+            if (count < 1 || count > 125) return MODBUS_EX_ILLEGAL_VALUE;
+            const uint16_t* regs = function == MODBUS_FC_READ_INPUT ? snapshot.input : snapshot.holding;
+            uint16_t reg_count = function == MODBUS_FC_READ_INPUT ? MODBUS_INPUT_COUNT : MODBUS_HOLDING_COUNT;
+            if ((uint32_t)address + count > reg_count) return MODBUS_EX_ILLEGAL_ADDRESS;
+            out[0] = function;
+            out[1] = (uint8_t)(count * 2);
+            for (uint16_t i = 0; i < count; i++) put_u16(out + 2 + 2 * i, regs[address + i]);
+            *out_len = 2 + out[1];
+            return 0;
+        }
+        case MODBUS_FC_WRITE_COIL: {
+            if (len != 5) return MODBUS_EX_ILLEGAL_VALUE;
+            uint16_t address = get_u16(pdu + 1), value = get_u16(pdu + 3);
+            if (value != 0xFF00 && value != 0x0000) return MODBUS_EX_ILLEGAL_VALUE;
+            uint8_t ex = check_coil(address, value == 0xFF00);
+            if (ex) return ex;
+            if (!apply_coil(address, value == 0xFF00)) return MODBUS_EX_DEVICE_FAILURE;
+            *wrote = true;
+            memcpy(out, pdu, 5);                         // Echo
+            *out_len = 5;
+            return 0;
+        }
+        case MODBUS_FC_WRITE_REGISTER: {
+            if (len != 5) return MODBUS_EX_ILLEGAL_VALUE;
+            uint16_t address = get_u16(pdu + 1), value = get_u16(pdu + 3);
+            uint8_t ex = check_holding(address, value);
+            if (ex) return ex;
+            if (!apply_holding(address, value)) return MODBUS_EX_DEVICE_FAILURE;
+            *wrote = true;
+            memcpy(out, pdu, 5);
+            *out_len = 5;
+            return 0;
+        }
+        case MODBUS_FC_WRITE_COILS: {
+            if (len < 6) return MODBUS_EX_ILLEGAL_VALUE;
+            uint16_t address = get_u16(pdu + 1), count = get_u16(pdu + 3);
+            uint8_t bytes = pdu[5];
+            if (count < 1 || count > 1968 || bytes != (count + 7) / 8 || len != 6u + bytes) {
+                return MODBUS_EX_ILLEGAL_VALUE;
+            }
+            if ((uint32_t)address + count > MODBUS_COIL_COUNT) return MODBUS_EX_ILLEGAL_ADDRESS;
+            for (uint16_t i = 0; i < count; i++) {       // All or nothing on validation
+                uint8_t ex = check_coil(address + i, (pdu[6 + i / 8] >> (i % 8)) & 1);
+                if (ex) return ex;
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                if (!apply_coil(address + i, (pdu[6 + i / 8] >> (i % 8)) & 1)) return MODBUS_EX_DEVICE_FAILURE;
+                *wrote = true;
+            }
+            memcpy(out, pdu, 5);
+            *out_len = 5;
+            return 0;
+        }
+        case MODBUS_FC_WRITE_REGISTERS: {
+            if (len < 6) return MODBUS_EX_ILLEGAL_VALUE;
+            uint16_t address = get_u16(pdu + 1), count = get_u16(pdu + 3);
+            uint8_t bytes = pdu[5];
+            if (count < 1 || count > 123 || bytes != count * 2 || len != 6u + bytes) return MODBUS_EX_ILLEGAL_VALUE;
+            if ((uint32_t)address + count > MODBUS_HOLDING_COUNT) return MODBUS_EX_ILLEGAL_ADDRESS;
+            for (uint16_t i = 0; i < count; i++) {
+                uint8_t ex = check_holding(address + i, get_u16(pdu + 6 + 2 * i));
+                if (ex) return ex;
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                if (!apply_holding(address + i, get_u16(pdu + 6 + 2 * i))) return MODBUS_EX_DEVICE_FAILURE;
+                *wrote = true;
+            }
+            memcpy(out, pdu, 5);
+            *out_len = 5;
+            return 0;
+        }
+        default:
+            return MODBUS_EX_ILLEGAL_FUNCTION;
+    }
+}
+
+/**
+ * @brief Answer one complete request ADU
+ * Reads touch only the snapshot; writes apply through the firmware APIs and
+ * refresh it.
+ * @return Response length, 0 if the ADU is malformed (drop the connection)
+ */
+size_t modbus_handle_adu(const uint8_t* request, size_t len, uint8_t* response, size_t response_len) {
+    int adu_len = modbus_adu_length(request, len);
+    if (adu_len <= 0 || (size_t)adu_len != len || response_len < MODBUS_ADU_MAX) {
+        stats.malformed++;
+        return 0;
+    }
+    uint32_t start = micros();
+    stats.requests++;
+
+    memcpy(response, request, MODBUS_MBAP_LEN);          // Transaction, protocol, (length), unit
+    size_t pdu_len = 0;
+    bool wrote = false;
+    uint8_t ex = handle_pdu(request + MODBUS_MBAP_LEN, len - MODBUS_MBAP_LEN, response + MODBUS_MBAP_LEN,
+                            &pdu_len, &wrote);
+    if (ex) {
+        response[MODBUS_MBAP_LEN] = request[MODBUS_MBAP_LEN] | 0x80;
+        response[MODBUS_MBAP_LEN + 1] = ex;
+        pdu_len = 2;
+        stats.exceptions++;
+    }
+    if (wrote) {
+        stats.writes++;
+        modbus_refresh_snapshot();
+    }
+    put_u16(response + 4, (uint16_t)(pdu_len + 1));
+
+    uint32_t elapsed = micros() - start;
+    if (elapsed > stats.max_handle_us) stats.max_handle_us = elapsed;
+    return MODBUS_MBAP_LEN + pdu_len;
+}
+
+//=============================================================================
+// SERVER
+//=============================================================================
+
+/**
+ * @brief Start tracking published readings (register image starts empty)
+ */
+void modbus_init(void) {
+    telemetry_add_sink(on_telemetry);
+    modbus_refresh_snapshot();
+}
+
+static void drop_client(modbus_connection_t& c) {
+    if (c.client) {
+        c.client->stop();
+        pool_delete(PoolId::CONNECTION, c.client);
+    }
+    if (c.rx) pool_free(PoolId::FRAME, c.rx);
+    c = modbus_connection_t();
+}
+
+static void serve_client(modbus_connection_t& c) {
+    if (c.client->available()) {
+        int n = c.client->read(c.rx + c.rx_len, MODBUS_ADU_MAX - c.rx_len);
+        if (n > 0) c.rx_len += (size_t)n;
+    }
+    for (int i = 0; i < MODBUS_REQUESTS_PER_UPDATE; i++) {
+        int adu_len = modbus_adu_length(c.rx, c.rx_len);
+        if (adu_len == 0 || (adu_len > 0 && (size_t)adu_len > c.rx_len)) return;   // Need more
+        uint8_t response[MODBUS_ADU_MAX];
+        size_t out = modbus_handle_adu(c.rx, adu_len > 0 ? (size_t)adu_len : c.rx_len, response, sizeof(response));
+        if (out == 0) {                                  // Malformed (counted): drop the connection
+            drop_client(c);
+            return;
+        }
+        c.client->write(response, out);
+        c.rx_len -= (size_t)adu_len;
+        memmove(c.rx, c.rx + adu_len, c.rx_len);
+    }
+}
+
+/**
+ * @brief Start the server once WiFi is up, accept clients and answer requests
+ * Up to MODBUS_REQUESTS_PER_UPDATE requests per client per loop pass.
+ */
+void modbus_update(void) {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    if (!modbus_server) {
+        modbus_server = pool_new<WiFiServer>(PoolId::CONNECTION, MODBUS_PORT);
+        if (!modbus_server) return;
+        modbus_server->begin();
+    }
+
+    bool any = false;
+    for (modbus_connection_t& c : clients) {
+        if (c.client && !c.client->connected()) drop_client(c);
+        any = any || c.client;
+    }
+
+    WiFiClient incoming = modbus_server->accept();
+    if (incoming) {
+        modbus_connection_t* slot = nullptr;
+        for (modbus_connection_t& c : clients) {
+            if (!c.client) {
+                slot = &c;
+                break;
+            }
+        }
+        if (slot) {
+            slot->rx = static_cast<uint8_t*>(pool_alloc(PoolId::FRAME));
+            slot->client = slot->rx ? pool_new<WiFiClient>(PoolId::CONNECTION, incoming) : nullptr;
+            if (slot->client) {
+                slot->client->setNoDelay(true);
+                any = true;
+            } else {
+                drop_client(*slot);
+                incoming.stop();
+            }
+        } else {
+            incoming.stop();                             // Full
+        }
+    }
+
+    if (!any) return;
+    modbus_refresh_snapshot();
+    for (modbus_connection_t& c : clients) {
+        if (c.client) serve_client(c);
+    }
+}
+
+modbus_stats_t modbus_get_stats(void) {
+    return stats;
+}
+
+uint8_t modbus_get_client_count(void) {
+    uint8_t count = 0;
+    for (const modbus_connection_t& c : clients) {
+        if (c.client) count++;
+    }
+    return count;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file multicast.cpp
+ * @brief UDP multicast publisher of telemetry frames
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "multicast.h"
+#include "telemetry.h"
+#include "communication.h"
+#include <WiFi.h>
+#include <WiFiUdp.h>
+
+//=============================================================================
+// STATE
+//=============================================================================
+
+static WiFiUDP multicast_udp;
+static bool multicast_enabled = false;
+static uint8_t multicast_group[4] = {MULTICAST_DEFAULT_GROUP[0], MULTICAST_DEFAULT_GROUP[1],
+                                     MULTICAST_DEFAULT_GROUP[2], MULTICAST_DEFAULT_GROUP[3]};
+static uint16_t multicast_port = MULTICAST_DEFAULT_PORT;
+static multicast_stats_t stats;
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief One datagram per frame; the frame already carries seq and CRC
+ */
+static void on_telemetry(const telemetry_event_t& event, const uint8_t* frame, size_t len) {
+    (void)event;
+    if (!multicast_enabled) return;
+    if (WiFi.status() != WL_CONNECTED) {
+        stats.skipped++;
+        return;
+    }
+    IPAddress group(multicast_group[0], multicast_group[1], multicast_group[2], multicast_group[3]);
+    if (multicast_udp.beginPacket(group, multicast_port) && multicast_udp.write(frame, len) == len &&
+        multicast_udp.endPacket()) {
+        stats.sent++;
+    } else {
+        stats.failed++;
+    }
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+void multicast_init(void) {
+    telemetry_add_sink(on_telemetry);
+}
+
+void multicast_enable(bool enabled) {
+    multicast_enabled = enabled;
+}
+
+bool multicast_is_enabled(void) {
+    return multicast_enabled;
+}
+
+void multicast_set_group(const uint8_t group[4], uint16_t port) {
+    memcpy(multicast_group, group, sizeof(multicast_group));
+    multicast_port = port;
+}
+
+void multicast_get_group(uint8_t group[4], uint16_t* port) {
+    memcpy(group, multicast_group, sizeof(multicast_group));
+    *port = multicast_port;
+}
+
+multicast_stats_t multicast_get_stats(void) {
+    return stats;
+}
+
+void multicast_print_status(void) {
+    Debug->printf("Multicast telemetry: %s, group %u.%u.%u.%u:%u", multicast_enabled ? "ON" : "OFF",
+                  multicast_group[0], multicast_group[1], multicast_group[2], multicast_group[3], multicast_port);
+    Debug->printf("  %lu datagrams sent, %lu failed, %lu skipped (WiFi down); next seq %lu",
+                  (unsigned long)stats.sent, (unsigned long)stats.failed, (unsigned long)stats.skipped,
+                  (unsigned long)telemetry_get_seq());
+}
@@ -0,0 +1,344 @@
+/**
+ * @file probe_vote.cpp
+ * @brief Redundant-probe voter, firmware pH/EC voters and the 'n' console command
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "probe_vote.h"
+#include "sensors.h"
+#include "pump.h"
+#include "communication.h"
+#include <math.h>
+
+//=============================================================================
+// VOTER
+//=============================================================================
+
+void probe_vote_reset(probe_vote_t* vote) {
+    memset(vote, 0, sizeof(*vote));
+    vote->excluded_now = -1;
+}
+
+/**
+ * @brief Median of n (1-3) values; the mean of two
+ */
+static float median_of(const float* values, int n) {
+    if (n == 1) return values[0];
+    if (n == 2) return (values[0] + values[1]) * 0.5f;
+    float a = values[0], b = values[1], c = values[2];
+    if (a > b) { float t = a; a = b; b = t; }
+    if (b > c) b = c;
+    return a > b ? a : b;
+}
+
+/**
+ * @brief Vote one set of readings
+ * @param readings One per installed probe (config.count)
+ * @param out Voted value, written only on success
+ * @return false on a split (two voters apart by more than the tolerance) or with no voters
+ */
+bool probe_vote_update(probe_vote_t* vote, const probe_vote_config_t& config, const float* readings, float* out) {
+    int count = config.count > PROBE_MAX ? PROBE_MAX : config.count;
+    vote->excluded_now = -1;
+
+    float values[PROBE_MAX];
+    int active[PROBE_MAX];
+    int voters = 0;
+    for (int i = 0; i < count; i++) {
+        vote->probe[i].last = readings[i];
+        if (vote->probe[i].excluded) continue;
+        active[voters] = i;
+        values[voters++] = readings[i];
+    }
+    vote->voters = (uint8_t)voters;
+    if (voters == 0) {
+        vote->splits++;
+        return false;
+    }
+
+    float median = median_of(values, voters);
+    for (int i = 0; i < count; i++) {
+        probe_track_t& probe = vote->probe[i];
+        probe.deviation = fabsf(readings[i] - median);
+        probe.deviation_avg += PROBE_DEVIATION_ALPHA * (probe.deviation - probe.deviation_avg);
+    }
+
+    if (voters == 2 && fabsf(values[0] - values[1]) > config.tolerance) {
+        // No majority: neither can be blamed
+        for (int k = 0; k < 2; k++) vote->probe[active[k]].disagreements++;
+        vote->splits++;
+        return false;
+    }
+
+    if (voters >= 3) {
+        // Strike the voter furthest out if it is beyond tolerance; the others start over
+        int worst = -1;
+        for (int k = 0; k < voters; k++) {
+            probe_track_t& probe = vote->probe[active[k]];
+            if (probe.deviation > config.tolerance &&
+                (worst < 0 || probe.deviation > vote->probe[active[worst]].deviation)) {
+                worst = k;
+            }
+        }
+        for (int k = 0; k < voters; k++) {
+            probe_track_t& probe = vote->probe[active[k]];
+            if (k != worst) {
+                probe.strikes = 0;
+                continue;
+            }
+            probe.disagreements++;
+            if (probe.strikes < 255) probe.strikes++;
+        }
+        if (worst >= 0 && vote->probe[active[worst]].strikes >= config.exclude_after) {
+            vote->probe[active[worst]].excluded = true;
+            vote->excluded_now = (int8_t)active[worst];
+        }
+        if (worst >= 0) {
+            // Outvoted: the value comes from the others this reading
+            for (int k = worst; k < voters - 1; k++) {
+                active[k] = active[k + 1];
+                values[k] = values[k + 1];
+            }
+            voters--;
+            median = median_of(values, voters);
+        }
+    }
+
+    float value = median;
+    if (config.mode == ProbeVoteMode::WEIGHTED && voters > 1) {
+        // Closer track record, larger weight; min_spread keeps a perfect probe from taking all of it
+        float min_spread = config.tolerance * 0.25f;
+        float sum = 0.0f, weights = 0.0f;
+        for (int k = 0; k < voters; k++) {
+            float avg = vote->probe[active[k]].deviation_avg;
+            float weight = 1.0f / (avg * avg + min_spread * min_spread);
+            sum += weight * values[k];
+            weights += weight;
+        }
+        value = sum / weights;
+    }
+
+    vote->voters = (uint8_t)voters;
+    vote->value = value;
+    vote->votes++;
+    *out = value;
+    return true;
+}
+
+void probe_vote_readmit(probe_vote_t* vote, int probe) {
+    if (probe < 0 || probe >= PROBE_MAX) return;
+    vote->probe[probe].excluded = false;
+    vote->probe[probe].strikes = 0;
+    vote->probe[probe].deviation_avg = 0.0f;
+}
+
+const char* probe_vote_mode_to_string(ProbeVoteMode mode) {
+    switch (mode) {
+        case ProbeVoteMode::MEDIAN:   return "median";
+        case ProbeVoteMode::WEIGHTED: return "weighted";
+        default:                      return "unknown";
+    }
+}
+
+//=============================================================================
+// FIRMWARE
+//=============================================================================
+
+struct probe_channel_t {
+    const char* name;            // Console and NVS key prefix
+    const char* unit;
+    const int* pins;
+    uint8_t board_count;
+    probe_vote_config_t config;
+    float trim[PROBE_MAX];       // Added to each probe's reading (probe 1 is the reference)
+    probe_vote_t vote;
+};
+
+static probe_channel_t channels[2] = {
+    {"ph", "pH", Board::ph_probe_pins, Board::ph_probe_count,
+     {1, ProbeVoteMode::MEDIAN, PROBE_DEFAULT_PH_TOLERANCE, PROBE_DEFAULT_EXCLUDE_AFTER}, {}, {}},
+    {"ec", "mS/cm", Board::ec_probe_pins, Board::ec_probe_count,
+     {1, ProbeVoteMode::MEDIAN, PROBE_DEFAULT_EC_TOLERANCE, PROBE_DEFAULT_EXCLUDE_AFTER}, {}, {}},
+};
+
+static probe_channel_t& channel_of(ProbeQuantity quantity) {
+    return channels[quantity == ProbeQuantity::PH ? 0 : 1];
+}
+
+static uint8_t exclusion_mask(const probe_channel_t& ch) {
+    uint8_t mask = 0;
+    for (int i = 0; i < PROBE_MAX; i++) {
+        if (ch.vote.probe[i].excluded) mask |= (uint8_t)(1u << i);
+    }
+    return mask;
+}
+
+static void probe_vote_save(void) {
+    char key[8];
+    Preferences store;
+    store.begin(PROBE_NVS_NAMESPACE, false);
+    store.putUChar("mode", (uint8_t)channels[0].config.mode);
+    for (const probe_channel_t& ch : channels) {
+        snprintf(key, sizeof(key), "%s_n", ch.name);
+        store.putUChar(key, ch.config.count);
+        snprintf(key, sizeof(key), "%s_tol", ch.name);
+        store.putFloat(key, ch.config.tolerance);
+        snprintf(key, sizeof(key), "%s_trim", ch.name);
+        store.putBytes(key, ch.trim, sizeof(ch.trim));
+        snprintf(key, sizeof(key), "%s_x", ch.name);
+        store.putUChar(key, exclusion_mask(ch));
+    }
+    store.end();
+}
+
+/**
+ * @brief Load probe settings; absent keys keep the single-probe defaults
+ */
+void probe_vote_init(void) {
+    char key[8];
+    Preferences store;
+    store.begin(PROBE_NVS_NAMESPACE, true);
+    uint8_t mode = store.getUChar("mode", (uint8_t)ProbeVoteMode::MEDIAN);
+    for (probe_channel_t& ch : channels) {
+        probe_vote_reset(&ch.vote);
+        ch.config.mode = mode == (uint8_t)ProbeVoteMode::WEIGHTED ? ProbeVoteMode::WEIGHTED : ProbeVoteMode::MEDIAN;
+        snprintf(key, sizeof(key), "%s_n", ch.name);
+        ch.config.count = (uint8_t)constrain(store.getUChar(key, 1), 1, ch.board_count);
+        snprintf(key, sizeof(key), "%s_tol", ch.name);
+        float tolerance = store.getFloat(key, ch.config.tolerance);
+        if (tolerance > 0.0f && tolerance < 14.0f) ch.config.tolerance = tolerance;
+        snprintf(key, sizeof(key), "%s_trim", ch.name);
+        if (store.getBytesLength(key) != sizeof(ch.trim) ||
+            store.getBytes(key, ch.trim, sizeof(ch.trim)) != sizeof(ch.trim)) {
+            memset(ch.trim, 0, sizeof(ch.trim));
+        }
+        snprintf(key, sizeof(key), "%s_x", ch.name);
+        uint8_t mask = store.getUChar(key, 0);
+        for (int i = 0; i < PROBE_MAX; i++) ch.vote.probe[i].excluded = (mask >> i) & 1;
+    }
+    store.end();
+}
+
+uint8_t probe_vote_count(ProbeQuantity quantity) {
+    return channel_of(quantity).config.count;
+}
+
+const probe_vote_t* probe_vote_state(ProbeQuantity quantity) {
+    return &channel_of(quantity).vote;
+}
+
+/**
+ * @brief Trim and vote one reading per installed probe
+ * A probe excluded by this vote is logged and its exclusion stored.
+ */
+bool probe_vote_apply(ProbeQuantity quantity, const float* readings, float* out) {
+    probe_channel_t& ch = channel_of(quantity);
+    float trimmed[PROBE_MAX];
+    for (int i = 0; i < ch.config.count; i++) trimmed[i] = readings[i] + ch.trim[i];
+
+    bool voted = probe_vote_update(&ch.vote, ch.config, trimmed, out);
+    if (ch.vote.excluded_now >= 0) {
+        const probe_track_t& probe = ch.vote.probe[ch.vote.excluded_now];
+        Debug->printf("WARNING: %s probe %d excluded - %.2f %s from the others for %u readings (readmit with 'n')",
+                      ch.unit, ch.vote.excluded_now + 1, probe.deviation, ch.unit, probe.strikes);
+        probe_vote_save();
+    }
+    if (!voted) {
+        Debug->printf("WARNING: %s probes disagree (%u voting) - reading discarded", ch.unit, ch.vote.voters);
+    }
+    return voted;
+}
+
+//=============================================================================
+// CONSOLE
+//=============================================================================
+
+static probe_channel_t* channel_named(const char* name) {
+    for (probe_channel_t& ch : channels) {
+        if (strcmp(ch.name, name) == 0) return &ch;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief 'n': one line - "<ph|ec> <count>", "mode median|weighted", "tol <ph|ec> <value>",
+ * "readmit <ph|ec> <probe>", "match <ph|ec>" or "list"
+ */
+void probe_vote_command(void) {
+    char line[48];
+    // The prompt blocks loop(), which is what stops a running dose on time
+    if (pump_any_running()) {
+        Debug->println("ERROR: A pump is running - change the probes when it stops");
+        return;
+    }
+    Debug->println("Probes (10s): ph|ec <count> | mode median|weighted | tol ph|ec <value> | readmit ph|ec <n> | "
+                   "match ph|ec | list");
+    Debug->read_line(line, sizeof(line), PROBE_INPUT_TIMEOUT_MS);
+
+    char verb[10] = "", name[10] = "";
+    float value = 0.0f;
+    int fields = sscanf(line, "%9s %9s %f", verb, name, &value);
+    probe_channel_t* ch = nullptr;
+
+    if (fields <= 0 || strcmp(verb, "list") == 0) {
+        // Status only
+    } else if ((ch = channel_named(verb)) != nullptr && fields >= 2) {
+        int count = atoi(name);
+        if (count < 1 || count > ch->board_count) {
+            Debug->printf("ERROR: %s probe count must be 1-%u on this board", ch->unit, ch->board_count);
+            return;
+        }
+        ch->config.count = (uint8_t)count;
+        probe_vote_reset(&ch->vote);
+    } else if (strcmp(verb, "mode") == 0 && (strcmp(name, "median") == 0 || strcmp(name, "weighted") == 0)) {
+        for (probe_channel_t& c : channels) {
+            c.config.mode = name[0] == 'w' ? ProbeVoteMode::WEIGHTED : ProbeVoteMode::MEDIAN;
+        }
+    } else if (strcmp(verb, "tol") == 0 && (ch = channel_named(name)) != nullptr && fields == 3) {
+        if (!(value > 0.0f && value < 14.0f)) {
+            Debug->println("ERROR: Tolerance must be above 0 and below 14");
+            return;
+        }
+        ch->config.tolerance = value;
+    } else if (strcmp(verb, "readmit") == 0 && (ch = channel_named(name)) != nullptr && fields == 3) {
+        int probe = (int)value - 1;
+        if (probe < 0 || probe >= ch->config.count) {
+            Debug->printf("ERROR: %s probe must be 1-%u", ch->unit, ch->config.count);
+            return;
+        }
+        probe_vote_readmit(&ch->vote, probe);
+    } else if (strcmp(verb, "match") == 0 && (ch = channel_named(name)) != nullptr) {
+        // All probes in the same solution: trim each onto probe 1's last reading
+        if (ch->vote.votes + ch->vote.splits == 0) {
+            Debug->printf("ERROR: No %s reading yet to match", ch->unit);
+            return;
+        }
+        for (int i = 1; i < ch->config.count; i++) {
+            ch->trim[i] += ch->vote.probe[0].last - ch->vote.probe[i].last;
+        }
+    } else {
+        Debug->println("ERROR: Not understood");
+        return;
+    }
+    if (fields > 0 && strcmp(verb, "list") != 0) probe_vote_save();
+    probe_vote_print_status();
+}
+
+void probe_vote_print_status(void) {
+    for (const probe_channel_t& ch : channels) {
+        if (ch.config.count <= 1) {
+            Debug->printf("%s probes: 1 (no voting, %u inputs on this board)", ch.unit, ch.board_count);
+            continue;
+        }
+        Debug->printf("%s probes: %u, %s vote, tolerance %.2f, exclude after %u | %lu votes, %lu discarded",
+                      ch.unit, ch.config.count, probe_vote_mode_to_string(ch.config.mode), ch.config.tolerance,
+                      ch.config.exclude_after, (unsigned long)ch.vote.votes, (unsigned long)ch.vote.splits);
+        for (int i = 0; i < ch.config.count; i++) {
+            const probe_track_t& probe = ch.vote.probe[i];
+            Debug->printf("  %d GPIO%-2d %7.3f  trim %+.3f  off vote %.3f (avg %.3f)  %lu disagreements%s", i + 1,
+                          ch.pins[i], probe.last, ch.trim[i], probe.deviation, probe.deviation_avg,
+                          (unsigned long)probe.disagreements, probe.excluded ? "  EXCLUDED" : "");
+        }
+    }
+}
@@ -6,8 +6,12 @@
  */
 #include <Arduino.h>
 #include <esp32-hal-ledc.h>  // Using LEDC API for Arduino-ESP32 3.x (ledcAttach/ledcWrite)
+#include <esp_timer.h>
+#include <Preferences.h>
 #include "pump.h"
 #include "state_machine.h"
+#include "binlog.h"
+#include "communication.h"
 
 //=============================================================================
 // GLOBAL VARIABLES
@@ -24,9 +28,30 @@ static const char* kPumpNames[static_cast<int>(PumpId::COUNT)] = {"pH_Up", "pH_D
 pump_system_t pump_system = {
     .auto_ph_control = false,
     .auto_ec_control = false,
-    .initialized = false
+    .initialized = false,
+    .auto_inhibit = 0,
+    .ph_predictive = false,
+    .micro_dosing = false,
+    .fraction_count = 1,
+    .fraction_gap_ms = PUMP_FRACTION_DEFAULT_GAP_MS,
+    .ec_target = DEFAULT_EC_TARGET,
+    .coupled_control = false
 };
 
+// Predictive pH dosing state
+static ph_predictor_t ph_predictor;
+
+// Shadow pH controller (decisions logged next to the live ones, never dosed)
+static ph_shadow_t ph_shadow;
+
+// Coupled pH/EC control: learned response (RAM only, relearned after a reboot)
+// and the joint dose waiting for its mixed response
+static dose_model_t dose_model;
+static dose_observation_t dose_observation;
+
+// One-shot timers ending micro-dosing pulses (created once, reused by every pulse)
+static esp_timer_handle_t pulse_timers[static_cast<int>(PumpId::COUNT)];
+
 //=============================================================================
 // PRIVATE HELPER FUNCTIONS
 //=============================================================================
@@ -34,7 +59,7 @@ pump_system_t pump_system = {
 /**
  * @brief Calculate PWM duty cycle from flow rate
  * @param flow_rate_ml_per_min Desired flow rate (5.2-90.0 ml/min)
- * @return PWM duty cycle (0-255)
+ * @return PWM duty cycle (0-PUMP_PWM_MAX_DUTY)
  */
 static uint8_t calculate_pwm_duty(float flow_rate_ml_per_min) {
     // Clamp flow rate to valid range
@@ -43,8 +68,25 @@ static uint8_t calculate_pwm_duty(float flow_rate_ml_per_min) {
     // Linear mapping: 5.2ml/min = 10% PWM, 90ml/min = 100% PWM
     float duty_percent = 10.0f + (flow_rate_ml_per_min - 5.2f) * 90.0f / 84.8f;
     
-    // Convert to 8-bit PWM value
-    return (uint8_t)(duty_percent * 255.0f / 100.0f);
+    // Convert to the board's PWM range
+    return (uint8_t)(duty_percent * PUMP_PWM_MAX_DUTY / 100.0f);
+}
+
+/**
+ * @brief Either pH pump has a fractionated dose that is not yet mixed
+ * That is, pieces still to come, or less than two mixing gaps since its last
+ * piece ended or the series was dropped: one gap leaves much of the last
+ * piece's plume at the probe.
+ */
+static bool ph_series_pending(void) {
+    for (PumpId id : {PumpId::PH_UP, PumpId::PH_DOWN}) {
+        const pump_t& pump = pumps[static_cast<int>(id)];
+        if (pump.series_remaining > 0 ||
+            (pump.series_count > 1 && millis() - pump.series_gap_start < 2 * pump_system.fraction_gap_ms)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
@@ -62,6 +104,14 @@ static bool can_dose_safely(PumpId pump_id, pump_t* pump) {
         return false; // Pump not in correct state for dosing
     }
     
+    // A fractionated dose still has pieces to deliver. A pH series holds both pH
+    // pumps (reactive and predictive alike) until it has mixed: a reading near
+    // the unmixed plume would otherwise call for the opposite correction
+    bool ph_pump = pump_id == PumpId::PH_UP || pump_id == PumpId::PH_DOWN;
+    if (pump->series_remaining > 0 || (ph_pump && ph_series_pending())) {
+        return false;
+    }
+    
     // Check minimum interval between doses (5 minutes)
     if (now - pump->controller.last_dose_time < PUMP_MIN_DOSE_INTERVAL) {
         return false;
@@ -111,8 +161,117 @@ static float calculate_pid_dose(pid_controller_t* pid, float current_value, floa
     // Scale by volume (normalize to 10L baseline)
     float dose_ml = abs(output) * (volume_liters / 10.0f);
     
-    // Apply dose limits  
-    return constrain(dose_ml, (float)PUMP_MIN_DOSE_VOLUME, PUMP_MAX_DOSE_VOLUME);
+    // Apply dose limits (micro-dosing lowers the floor to what a pulse can deliver)
+    float min_ml = pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME;
+    return constrain(dose_ml, min_ml, PUMP_MAX_DOSE_VOLUME);
+}
+
+/**
+ * @brief Restart a pH trend fit
+ * @param settling true when a pH dose has just started mixing
+ */
+static void ph_predictor_restart(ph_predictor_t* predictor, bool settling) {
+    trend_reset(&predictor->trend);
+    predictor->last_reading = 0;
+    predictor->dose_time = millis();
+    predictor->settling = settling;
+}
+
+/**
+ * @brief Restart the pH trends (live and shadow) after a pH pump starts
+ */
+static void ph_predictor_dose_started(void) {
+    ph_predictor_restart(&ph_predictor, true);
+    ph_predictor_restart(&ph_shadow.predictor, true);
+}
+
+/**
+ * @brief Add a pH reading to a trend (skipped while a dose is mixing)
+ * @param predictor Trend to update
+ * @param ph Filtered pH
+ * @param now Reading time (ms)
+ */
+static void ph_predictor_observe(ph_predictor_t* predictor, float ph, uint32_t now) {
+    if (predictor->settling) {
+        if (now - predictor->dose_time < PH_PREDICT_SETTLE_MS) return;
+        predictor->settling = false;
+    }
+    double dt_min = predictor->last_reading ? (now - predictor->last_reading) / 60000.0 : 0.0;
+    trend_add(&predictor->trend, dt_min, ph, PH_PREDICT_TREND_TAU_MIN);
+    predictor->last_reading = now;
+}
+
+//=============================================================================
+// LINE PRIMING
+//=============================================================================
+
+/**
+ * @brief Estimated liquid in a pump's line now
+ * The line held fill_ml when the pump last moved liquid and drains back
+ * exponentially while idle.
+ */
+static float line_fill_ml(const pump_t* pump, uint32_t now) {
+    float idle_h = (now - pump->line.wet_at) / (float)kHourMs;
+    return pump->line.fill_ml * expf(-idle_h / PUMP_LINE_DRAIN_TAU_H);
+}
+
+/**
+ * @brief Record liquid moving into the line (counted as primed)
+ * @param pump Pointer to pump structure
+ * @param fill_ml New fill, clamped to the line volume
+ */
+static void line_fill_to(pump_t* pump, float fill_ml) {
+    fill_ml = constrain(fill_ml, 0.0f, pump->line.dead_ml);
+    if (fill_ml > pump->line.fill_ml) {
+        pump->line.primed_ml += fill_ml - pump->line.fill_ml;
+    }
+    pump->line.fill_ml = fill_ml;
+    pump->line.wet_at = millis();
+}
+
+/**
+ * @brief Size PRIMING for what the line lost while idle
+ * Brings the drained fill estimate up to date and sets prime_ms; a shortfall
+ * below PUMP_LINE_MIN_PRIME_ML is not primed.
+ * @param pump Pointer to pump structure
+ * @return ml needed to fill the line (0 = prime nothing)
+ */
+static float plan_priming(pump_t* pump) {
+    uint32_t now = millis();
+    pump->line.fill_ml = line_fill_ml(pump, now);
+    pump->line.wet_at = now;
+    
+    float shortfall = pump->line.dead_ml - pump->line.fill_ml;
+    if (shortfall < PUMP_LINE_MIN_PRIME_ML) {
+        shortfall = 0.0f;
+    }
+    pump->prime_start_fill = pump->line.fill_ml;
+    pump->prime_ms = (uint32_t)(shortfall / PUMP_PRIME_FLOW_RATE * 60000.0f + 0.5f);
+    return shortfall;
+}
+
+/**
+ * @brief Record a dose (or dose series piece) that has just started
+ * A fractionated series counts once against the rate limiter, at its start;
+ * every piece adds its own ml.
+ * @param pump_id Pump identifier
+ * @param dose_ml Amount this run delivers
+ * @param new_dose false for the second and later pieces of a series
+ */
+static void record_dose_start(PumpId pump_id, float dose_ml, bool new_dose) {
+    pump_t* pump = &pumps[static_cast<int>(pump_id)];
+    
+    // A pH dose invalidates the pH trend until it has mixed
+    if (pump_id == PumpId::PH_UP || pump_id == PumpId::PH_DOWN) {
+        ph_predictor_dose_started();
+    }
+    
+    // Update safety tracking
+    if (new_dose) {
+        pump->controller.last_dose_time = millis();
+        pump->controller.doses_this_hour++;
+    }
+    pump->controller.total_ml_dosed += dose_ml;
 }
 
 /**
@@ -120,9 +279,10 @@ static float calculate_pid_dose(pid_controller_t* pid, float current_value, floa
  * @param pump_id Pump identifier
  * @param dose_ml Amount to dose in ml
  * @param flow_rate Flow rate in ml/min
+ * @param new_dose false for a continuation piece of a fractionated dose
  * @return true if pump started successfully
  */
-static bool start_pump_dose(PumpId pump_id, float dose_ml, float flow_rate) {
+static bool start_pump_dose(PumpId pump_id, float dose_ml, float flow_rate, bool new_dose) {
     int pump_index = static_cast<int>(pump_id);
     if (pump_index >= static_cast<int>(PumpId::COUNT)) return false;
     
@@ -145,6 +305,9 @@ static bool start_pump_dose(PumpId pump_id, float dose_ml, float flow_rate) {
     // Calculate and store PWM duty for dosing phase
     uint8_t pwm_duty = calculate_pwm_duty(flow_rate);
     
+    // Refill only what the line has drained since it last ran
+    plan_priming(pump);
+    
     // Transition to PRIMING state (PWM will be managed by pump_update)
     if (!pump_transition_to(pump_id, PumpState::PRIMING)) {
         return false; // State transition failed
@@ -156,65 +319,412 @@ static bool start_pump_dose(PumpId pump_id, float dose_ml, float flow_rate) {
     // Update pump timing
     pump->start_time = millis();
     
-    // Update safety tracking
-    pump->controller.last_dose_time = millis();
-    pump->controller.doses_this_hour++;
-    pump->controller.total_ml_dosed += dose_ml;
+    record_dose_start(pump_id, dose_ml, new_dose);
+    return true;
+}
+
+/**
+ * @brief Count ml delivered by a manual run since the last call
+ * Manual runs have no planned volume, so delivery is accrued while DOSING
+ * (or running under MAINTENANCE); any other state means the run has ended.
+ * Whatever the line is short of is filled first and counted as primed.
+ * @param pump Pointer to pump structure
+ * @param state Current pump state
+ */
+static void accrue_manual_flow(pump_t* pump, PumpState state) {
+    if (pump->manual_flow_rate <= 0.0f) return;
+    
+    if (state == PumpState::DOSING || (state == PumpState::MAINTENANCE && pump->running)) {
+        uint32_t now = millis();
+        float ml = pump->manual_flow_rate * (now - pump->manual_accounted_at) / 60000.0f;
+        
+        // A manual run is not primed: the line fills before the reservoir sees any
+        float to_line = constrain(pump->line.dead_ml - pump->line.fill_ml, 0.0f, ml);
+        line_fill_to(pump, pump->line.fill_ml + to_line);
+        pump->controller.total_ml_dosed += ml - to_line;
+        pump->manual_accounted_at = now;
+    } else {
+        pump->manual_flow_rate = 0.0f;
+    }
+}
+
+//=============================================================================
+// MICRO-DOSING PULSES
+//=============================================================================
+
+/**
+ * @brief Pulse timer callback: end the pulse at its exact length
+ * Runs in the esp_timer task, so it only stops the PWM and flags pump_update.
+ * @param arg Pump whose pulse ended
+ */
+static void pulse_timer_callback(void* arg) {
+    pump_t* pump = static_cast<pump_t*>(arg);
+    ledcWrite(pump->gpio_pin, 0);
+    pump->pulse_done = true;
+    binlog("[PULSE] Pump %s pulse off", kPumpNames[pump - pumps]);
+}
+
+/**
+ * @brief Pulse length delivering ml with a pump's calibration
+ * @param cal Pulse calibration of the pump
+ * @param ml Volume to deliver
+ * @return Pulse length in ms (0 if shorter than the calibrated minimum pulse)
+ */
+static uint32_t micro_pulse_ms(const pump_pulse_cal_t& cal, float ml) {
+    uint32_t pulse_ms = cal.dead_ms + (uint32_t)(ml / cal.flow_ml_per_min * 60000.0f + 0.5f);
+    return pulse_ms < cal.min_pulse_ms ? 0 : pulse_ms;
+}
+
+/**
+ * @brief Switch a pump on at full duty and arm the timer that switches it off
+ * @param pump_index Pump array index
+ * @param pulse_ms Pulse length
+ * @return true if the pulse is running
+ */
+static bool fire_pulse(int pump_index, uint32_t pulse_ms) {
+    pump_t* pump = &pumps[pump_index];
+    if (pulse_timers[pump_index] == nullptr) return false;
+    
+    pump->pulse_done = false;
+    ledcWrite(pump->gpio_pin, PUMP_MICRO_DUTY);
+    if (esp_timer_start_once(pulse_timers[pump_index], (uint64_t)pulse_ms * 1000) != ESP_OK) {
+        ledcWrite(pump->gpio_pin, 0);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Disarm a pump's pulse timer (no-op when no pulse is running)
+ * @param pump_index Pump array index
+ */
+static void cancel_pulse(int pump_index) {
+    if (pulse_timers[pump_index] != nullptr) {
+        esp_timer_stop(pulse_timers[pump_index]);
+    }
+    pumps[pump_index].micro_pulse = false;
+}
+
+/**
+ * @brief Start a sub-minimum dose as one timed full-duty pulse
+ * There is no priming phase: the calibrated dead time covers spin-up and the
+ * pulse is lengthened by the line's shortfall. The pulse counts as a dose for
+ * the rate limiter exactly like a normal dose.
+ * @param pump_id Pump identifier
+ * @param dose_ml Amount to dose in ml
+ * @param new_dose false for a continuation piece of a fractionated dose
+ * @return true if the pulse started
+ */
+static bool start_micro_dose(PumpId pump_id, float dose_ml, bool new_dose) {
+    int pump_index = static_cast<int>(pump_id);
+    pump_t* pump = &pumps[pump_index];
+    
+    if (state_manager.pump_states[pump_index] != PumpState::IDLE) {
+        return false;
+    }
+    // The pulse refills whatever the line has drained as well
+    uint32_t pulse_ms = micro_pulse_ms(pump->pulse_cal, dose_ml + plan_priming(pump));
+    if (pulse_ms == 0) {
+        return false; // Below the shortest repeatable pulse
+    }
+    
+    // IDLE -> DOSING is not a valid transition: pass through PRIMING
+    if (!pump_transition_to(pump_id, PumpState::PRIMING) ||
+        !pump_transition_to(pump_id, PumpState::DOSING)) {
+        pump_transition_to(pump_id, PumpState::IDLE);
+        return false;
+    }
     
+    pump->micro_pulse = true;
+    pump->run_duration_ms = pulse_ms;
+    pump->target_pwm_duty = PUMP_MICRO_DUTY;
+    pump->start_time = millis();
+    if (!fire_pulse(pump_index, pulse_ms)) {
+        pump->micro_pulse = false;
+        pump_transition_to(pump_id, PumpState::IDLE);
+        return false;
+    }
+    pump->running = true;
+    
+    record_dose_start(pump_id, dose_ml, new_dose);
     return true;
 }
 
+/**
+ * @brief Start a dose, as a micro pulse if it is below PUMP_MIN_DOSE_VOLUME
+ * @param pump_id Pump identifier
+ * @param dose_ml Amount to dose in ml (at most PUMP_MAX_DOSE_VOLUME)
+ * @param new_dose false for a continuation piece of a fractionated dose
+ * @return true if dosing started
+ */
+static bool start_dose(PumpId pump_id, float dose_ml, bool new_dose) {
+    if (dose_ml < PUMP_MIN_DOSE_VOLUME) {
+        return pump_system.micro_dosing && dose_ml >= PUMP_MICRO_MIN_VOLUME &&
+               start_micro_dose(pump_id, dose_ml, new_dose);
+    }
+    return start_pump_dose(pump_id, dose_ml, PUMP_DEFAULT_FLOW_RATE, new_dose);
+}
+
 //=============================================================================
-// PUMP SAFETY FUNCTIONS
+// DOSE FRACTIONATION
 //=============================================================================
 
 /**
- * @brief Check and enforce pump safety timeouts and limits
- * Called from state machine update to monitor all pumps
+ * @brief Drop the rest of a fractionated dose
+ * A piece already running finishes; the pump then cools down as usual.
+ * @param pump_index Pump array index
+ * @param reason Logged reason (nullptr = silent)
  */
-void pump_safety_check(void) {
-    if (!pump_system.initialized) return;
+static void cancel_series(int pump_index, const char* reason) {
+    pump_t* pump = &pumps[pump_index];
+    if (pump->series_remaining == 0) return;
+    
+    if (reason != nullptr) {
+        Serial.printf("Pump %s: dose series stopped with %d of %d pieces left (%s)\n", kPumpNames[pump_index],
+                      pump->series_remaining, pump->series_count, reason);
+    }
+    pump->series_remaining = 0;
+    pump->series_gap_start = millis();                   // What was given still has to mix
+}
+
+/**
+ * @brief Start an automatic dose, split into pieces with mixing gaps
+ * With fractionation off, or a dose too small to split into deliverable
+ * pieces, this is a single dose. Pieces never go below the smallest volume
+ * the pump delivers accurately (a micro pulse when micro-dosing is on).
+ * @param pump_id Pump identifier
+ * @param dose_ml Total dose in ml (at most PUMP_MAX_DOSE_VOLUME)
+ * @param reading Reading the dose was computed from
+ * @param target Reading at which the remaining pieces are dropped
+ * @return true if the first piece started
+ */
+static bool start_fractionated_dose(PumpId pump_id, float dose_ml, float reading, float target) {
+    pump_t* pump = &pumps[static_cast<int>(pump_id)];
+    float min_piece = pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME;
     
+    int count = pump_system.fraction_count;
+    if (dose_ml / count < min_piece) {
+        count = (int)(dose_ml / min_piece);
+    }
+    if (count <= 1) {
+        pump->series_count = 0;
+        return start_dose(pump_id, dose_ml, true);
+    }
     
-    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
-        PumpState current_state = state_manager.pump_states[i];
-        uint32_t  state_duration = pump_get_state_duration_ms(static_cast<PumpId>(i));
-        
-    switch (current_state) {
-            case PumpState::PRIMING:
-                // Force transition if priming takes too long (safety: max 5 seconds)
-                if (state_duration > 5000) {
-                    pump_transition_to(static_cast<PumpId>(i), PumpState::ERROR);
+    float piece_ml = dose_ml / count;
+    if (!start_dose(pump_id, piece_ml, true)) {
+        return false;
+    }
+    pump->series_count = count;
+    pump->series_remaining = count - 1;
+    pump->series_piece_ml = piece_ml;
+    pump->series_target = target;
+    pump->series_reading = reading;
+    return true;
+}
+
+/**
+ * @brief Give pH dose series the newest reading
+ * Only the reading at the end of a mixing gap decides whether the next piece
+ * runs: mid-gap readings still carry the unmixed plume near the probe.
+ * @param current_ph Filtered pH reading
+ */
+static void ph_series_observe(float current_ph) {
+    pumps[static_cast<int>(PumpId::PH_UP)].series_reading = current_ph;
+    pumps[static_cast<int>(PumpId::PH_DOWN)].series_reading = current_ph;
+}
+
+/**
+ * @brief Finish a dose run: rest in IDLE for the next piece, or cool down
+ * @param pump_index Pump array index
+ */
+static void finish_dose_run(int pump_index) {
+    pump_t* pump = &pumps[pump_index];
+    PumpId pump_id = static_cast<PumpId>(pump_index);
+    
+    // The next piece, or the other pH pump after the last one, waits from here
+    pump->series_gap_start = millis();
+    if (pump->series_remaining > 0) {
+        // The lockout applies once, after the last piece
+        pump_transition_to(pump_id, PumpState::IDLE);
+    } else {
+        pump_transition_to(pump_id, PumpState::COOLING_DOWN);
+    }
+}
+
+/**
+ * @brief Start the next piece of a series once its mixing gap has passed
+ * Only from IDLE; the series is dropped if automatic dosing has been paused.
+ * @param pump_index Pump array index
+ */
+static void continue_series(int pump_index) {
+    pump_t* pump = &pumps[pump_index];
+    if (pump->series_remaining == 0 || millis() - pump->series_gap_start < pump_system.fraction_gap_ms) {
+        return;
+    }
+    
+    // Pieces move the reading towards the target; once there, the rest is not needed
+    bool rising = pump_index == static_cast<int>(PumpId::PH_UP);
+    if (rising ? pump->series_reading >= pump->series_target : pump->series_reading <= pump->series_target) {
+        cancel_series(pump_index, "target reached");
+        return;
+    }
+    
+    if (pump_system.auto_inhibit ||
+        (state_manager.system_state != SystemState::MONITORING &&
+         state_manager.system_state != SystemState::DOSING)) {
+        cancel_series(pump_index, "dosing paused");
+        return;
+    }
+    if (!start_dose(static_cast<PumpId>(pump_index), pump->series_piece_ml, false)) {
+        cancel_series(pump_index, "pump unavailable");
+        return;
+    }
+    pump->series_remaining--;
+}
+
+//=============================================================================
+// COUPLED PH/EC MODEL
+//=============================================================================
+
+/**
+ * @brief Start the response model from the prior and forget any pending dose
+ * pH Up/Down act as DEFAULT_PH_KP assumes, nutrients as PUMP_EC_PER_ML_L;
+ * the cross-effects start at zero and are learned.
+ */
+static void reset_dose_model(void) {
+    float prior[DOSE_CHANNEL_COUNT][DOSE_GROUP_COUNT] = {};
+    prior[static_cast<int>(DoseChannel::PH)][static_cast<int>(DoseGroup::PH_UP)] = PUMP_COUPLED_PRIOR_PH;
+    prior[static_cast<int>(DoseChannel::PH)][static_cast<int>(DoseGroup::PH_DOWN)] = -PUMP_COUPLED_PRIOR_PH;
+    prior[static_cast<int>(DoseChannel::EC)][static_cast<int>(DoseGroup::NUTRIENT)] = PUMP_EC_PER_ML_L;
+    dose_model_reset(&dose_model, prior);
+    dose_observation = dose_observation_t();
+}
+
+/**
+ * @brief Dose group a pump belongs to in the response model
+ */
+static DoseGroup pump_dose_group(int pump_index) {
+    switch (static_cast<PumpId>(pump_index)) {
+        case PumpId::PH_UP:   return DoseGroup::PH_UP;
+        case PumpId::PH_DOWN: return DoseGroup::PH_DOWN;
+        default:              return DoseGroup::NUTRIENT;
+    }
+}
+
+/**
+ * @brief Check a pulse calibration (stored or measured) for sane values
+ */
+static bool pulse_cal_plausible(const pump_pulse_cal_t& cal) {
+    return isfinite(cal.flow_ml_per_min) &&
+           cal.flow_ml_per_min >= PUMP_MIN_FLOW_RATE && cal.flow_ml_per_min <= 2.0f * PUMP_MAX_FLOW_RATE &&
+           cal.dead_ms < PUMP_PULSE_CAL_SHORT_MS && cal.min_pulse_ms >= cal.dead_ms;
+}
+
+/**
+ * @brief Load stored pulse calibrations (pumps keep defaults if none stored)
+ */
+static void load_pulse_calibration(void) {
+    pump_pulse_cal_t stored[static_cast<int>(PumpId::COUNT)];
+    Preferences store;
+    if (!store.begin(PUMP_NVS_NAMESPACE, true)) {
+        return;
+    }
+    if (store.getBytesLength(PUMP_NVS_PULSE_KEY) == sizeof(stored) &&
+        store.getBytes(PUMP_NVS_PULSE_KEY, stored, sizeof(stored)) == sizeof(stored)) {
+        for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+            if (pulse_cal_plausible(stored[i])) {
+                pumps[i].pulse_cal = stored[i];
+            }
+        }
+    }
+    store.end();
+}
+
+/**
+ * @brief Load stored line volumes (pumps keep the default if none stored)
+ */
+static void load_line_calibration(void) {
+    float stored[static_cast<int>(PumpId::COUNT)];
+    Preferences store;
+    if (!store.begin(PUMP_NVS_NAMESPACE, true)) {
+        return;
+    }
+    if (store.getBytesLength(PUMP_NVS_LINE_KEY) == sizeof(stored) &&
+        store.getBytes(PUMP_NVS_LINE_KEY, stored, sizeof(stored)) == sizeof(stored)) {
+        for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+            if (isfinite(stored[i]) && stored[i] > 0.0f && stored[i] <= PUMP_LINE_MAX_DEAD_ML) {
+                pumps[i].line.dead_ml = stored[i];
+                pumps[i].line.calibrated = true;
+            }
+        }
+    }
+    store.end();
+}
+
+//=============================================================================
+// PUMP SAFETY FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Timeout a pump state arms on entry
+ * @param pump Pump identifier
+ * @param state State being entered
+ * @return ms until pump_state_expired() fires, 0 for no timeout
+ */
+uint32_t pump_state_timeout_ms(PumpId pump, PumpState state) {
+    int pump_index = static_cast<int>(pump);
+    switch (state) {
+        case PumpState::PRIMING:
+            // Priming overrunning its planned length
+            return pump_index < static_cast<int>(PumpId::COUNT)
+                       ? pumps[pump_index].prime_ms + PUMP_PRIME_TIMEOUT_MARGIN_MS : 0;
+        case PumpState::DOSING:       return PUMP_TIMEOUT_MS;
+        case PumpState::COOLING_DOWN: return PUMP_COOLDOWN_MS;
+        case PumpState::ERROR:        return PUMP_ERROR_RECOVERY_MS;
+        default:                      return 0;
+    }
+}
+
+/**
+ * @brief A pump state's timeout ran out (called by state_machine_update)
+ * @param pump Pump identifier
+ * @param state State that timed out
+ */
+void pump_state_expired(PumpId pump, PumpState state) {
+    int i = static_cast<int>(pump);
+    if (i >= static_cast<int>(PumpId::COUNT)) return;
+    
+    switch (state) {
+        case PumpState::PRIMING:
+            pump_transition_to(pump, PumpState::ERROR);
             Serial.printf("[SAFETY] Pump %s priming timeout - forced to ERROR\n", kPumpNames[i]);
-                }
-                break;
-                
-            case PumpState::DOSING:
-                // Force stop if dosing exceeds maximum timeout (10 minutes)
-                if (state_duration > PUMP_TIMEOUT_MS) {
-                    ledcWrite(pumps[i].pwm_channel, 0);
-                    pumps[i].running = false;
-                    pump_transition_to(static_cast<PumpId>(i), PumpState::ERROR);
+            break;
+            
+        case PumpState::DOSING:
+            // Force stop if dosing exceeds maximum timeout (10 minutes)
+            cancel_pulse(i);
+            ledcWrite(pumps[i].gpio_pin, 0);
+            pumps[i].running = false;
+            pump_transition_to(pump, PumpState::ERROR);
             Serial.printf("[SAFETY] Pump %s dosing timeout (10min) - forced to ERROR\n", kPumpNames[i]);
-                }
-                break;
-                
-            case PumpState::COOLING_DOWN:
-                // Automatic transition to IDLE after cooling period (handled by state machine)
-                // This is just monitoring - state_machine_update handles the transition
-                break;
-                
-            case PumpState::ERROR:
-                // Allow manual recovery after 30 seconds in error state
-                if (state_duration > 30000) {
-                    pump_transition_to(static_cast<PumpId>(i), PumpState::IDLE);
-                    Serial.printf("[SAFETY] Pump %s auto-recovery from ERROR to IDLE\n", kPumpNames[i]);
-                }
-                break;
-                
-            default:
-                break;
-        }
+            break;
+            
+        case PumpState::COOLING_DOWN:
+            pump_transition_to(pump, PumpState::IDLE);
+            if (state_manager.debug_logging_enabled) {
+                binlog("[STATE] Pump %d cooling down complete - transition to IDLE", i);
+            }
+            break;
+            
+        case PumpState::ERROR:
+            // Allow manual recovery after 30 seconds in error state
+            pump_transition_to(pump, PumpState::IDLE);
+            Serial.printf("[SAFETY] Pump %s auto-recovery from ERROR to IDLE\n", kPumpNames[i]);
+            break;
+            
+        default:
+            break;
     }
 }
 
@@ -227,19 +737,30 @@ void pump_safety_check(void) {
  * @return true if initialization successful
  */
 bool pump_init(void) {
-    // GPIO pin mapping for all pumps
-    uint8_t gpio_pins[static_cast<int>(PumpId::COUNT)] = {
-        PUMP_PH_UP_PIN, PUMP_PH_DOWN_PIN, PUMP_NUTRIENT_A_PIN, PUMP_NUTRIENT_B_PIN
-    };
-
     // Initialize pump structures using constructors
     for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        cancel_pulse(i);
         pumps[i] = pump_t(); // Default constructor handles most initialization
-        pumps[i].gpio_pin = gpio_pins[i];
+        pumps[i].gpio_pin = Board::pump_pins[i];
         // Attach LEDC to the pin with configured frequency/resolution and ensure off
         ledcAttach(pumps[i].gpio_pin, PUMP_PWM_FREQ, PUMP_PWM_RESOLUTION);
         ledcWrite(pumps[i].gpio_pin, 0);
+        
+        if (pulse_timers[i] == nullptr) {
+            esp_timer_create_args_t timer_args = {};
+            timer_args.callback = pulse_timer_callback;
+            timer_args.arg = &pumps[i];
+            timer_args.dispatch_method = ESP_TIMER_TASK;
+            timer_args.name = "pump_pulse";
+            if (esp_timer_create(&timer_args, &pulse_timers[i]) != ESP_OK) {
+                pulse_timers[i] = nullptr;
+                Serial.printf("WARNING: No pulse timer for pump %s - micro-dosing unavailable\n", kPumpNames[i]);
+            }
+        }
     }
+    load_pulse_calibration();
+    load_line_calibration();
+    reset_dose_model();
 
     pump_system.initialized = true;
     Serial.println("Pump system initialized successfully");
@@ -261,38 +782,58 @@ void pump_update(void) {
         PumpState current_state = state_manager.pump_states[i];
         uint32_t  state_duration = pump_get_state_duration_ms(static_cast<PumpId>(i));
         
+        accrue_manual_flow(pump, current_state);
+        
         switch (current_state) {
             case PumpState::IDLE:
                 // Ensure PWM is off in idle state
                 ledcWrite(pump->gpio_pin, 0);
                 pump->running = false;
+                continue_series(i);
                 break;
                 
             case PumpState::PRIMING:
-                // Priming phase: 2-3 seconds with lower PWM (20-30%)
-                if (state_duration < 2500) { // 2.5 second priming
-                    uint8_t priming_pwm = (uint8_t)(255 * 0.25f); // 25% PWM for priming
-                    ledcWrite(pump->gpio_pin, priming_pwm);
+                // Priming phase: low PWM until the line's shortfall is refilled (none for a full line)
+                if (state_duration < pump->prime_ms) {
+                    ledcWrite(pump->gpio_pin, calculate_pwm_duty(PUMP_PRIME_FLOW_RATE));
                     pump->running = true;
+                    line_fill_to(pump, pump->prime_start_fill + PUMP_PRIME_FLOW_RATE * state_duration / 60000.0f);
                 } else {
                     // Transition to dosing
+                    line_fill_to(pump, pump->line.dead_ml);
                     pump_transition_to(static_cast<PumpId>(i), PumpState::DOSING);
                 }
                 break;
                 
             case PumpState::DOSING:
+                if (pump->micro_pulse) {
+                    // The pulse timer switches the pump off; retire the pulse here, or
+                    // stop it if the timer is overdue
+                    if (pump->pulse_done || state_duration >= pump->run_duration_ms + PUMP_MICRO_WATCHDOG_MS) {
+                        cancel_pulse(i);
+                        ledcWrite(pump->gpio_pin, 0);
+                        pump->running = false;
+                        line_fill_to(pump, pump->line.dead_ml);
+                        finish_dose_run(i);
+                        Serial.printf("Pump %s completed micro dose pulse of %lums\n",
+                                     kPumpNames[i], (unsigned long)pump->run_duration_ms);
+                    }
+                    break;
+                }
                 // Active dosing with target PWM
                 if (state_duration < pump->run_duration_ms) {
-                    // Set target PWM once at the start of DOSING
-                    if (state_duration == 0) {
-                        ledcWrite(pump->gpio_pin, pump->target_pwm_duty);
-                    }
+                    // Hold target PWM for the whole phase; the first update after
+                    // PRIMING may land past the entry millisecond
+                    ledcWrite(pump->gpio_pin, pump->target_pwm_duty);
                     pump->running = true;
+                    if (pump->manual_flow_rate <= 0.0f) {
+                        line_fill_to(pump, pump->line.dead_ml);   // Keeps the line's wet time current
+                    }
                 } else {
-                    // Dosing complete - stop and begin cooling down
+                    // Dosing complete - stop and begin cooling down (or wait for the next piece)
                     ledcWrite(pump->gpio_pin, 0);
                     pump->running = false;
-                    pump_transition_to(static_cast<PumpId>(i), PumpState::COOLING_DOWN);
+                    finish_dose_run(i);
                     Serial.printf("Pump %s completed dose after %.1fs\n", 
                                  kPumpNames[i], pump->run_duration_ms / 1000.0f);
                 }
@@ -324,8 +865,12 @@ void pump_update(void) {
 void pump_stop_all(void) {
     for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
         // Immediately stop PWM
+        cancel_pulse(i);
+        cancel_series(i, nullptr);
     ledcWrite(pumps[i].gpio_pin, 0);
         pumps[i].running = false;
+        accrue_manual_flow(&pumps[i], state_manager.pump_states[i]);
+        pumps[i].manual_flow_rate = 0.0f;
         
         // Transition to IDLE state (emergency transitions always allowed)
         pump_transition_to(static_cast<PumpId>(i), PumpState::IDLE);
@@ -338,25 +883,105 @@ void pump_stop_all(void) {
 //=============================================================================
 
 /**
- * @brief Perform automatic pH dosing using PID control
+ * @brief Predicted pH error at mix time, shrunk by the prediction uncertainty
+ *
+ * The pH slope since the last dose settled is extrapolated PH_PREDICT_MIX_MS
+ * ahead. The aim point sits half a dose interval of drift below (or above)
+ * the target, so pH spends the lockout that follows centred on the target.
+ * Only the edge of the prediction interval nearest the aim counts: an
+ * uncertain trend gives a smaller dose or none. Until the fit has enough
+ * readings the current pH is used and only an out-of-band pH is corrected.
+ * @param predictor Trend state (its prediction fields are updated)
  * @param current_ph Current pH reading
- * @param volume_liters Reservoir volume in liters
- * @return true if dosing was performed
+ * @return > 0 too high (pH Down), < 0 too low (pH Up), 0 confidently in band
  */
-bool pump_ph_dose(float current_ph, float volume_liters) {
-    if (!pump_system.initialized || !pump_system.auto_ph_control) {
-        return false;
+static float ph_predictive_error(ph_predictor_t* predictor, float current_ph) {
+    trend_estimate_t fit;
+    bool trusted = trend_estimate(&predictor->trend, &fit) && fit.weight >= PH_PREDICT_MIN_WEIGHT;
+    
+    float predicted = current_ph;
+    float sigma = 0.0f;
+    float slope_per_min = 0.0f;
+    if (trusted) {
+        predicted = trend_predict(&predictor->trend, PH_PREDICT_MIX_MS / 60000.0, &sigma);
+        slope_per_min = fit.slope;
     }
+    predictor->predicted_ph = predicted;
+    predictor->predicted_sigma = sigma;
+    predictor->slope_per_h = slope_per_min * 60.0f;
     
-    // Validate inputs
-    if (volume_liters < 5.0f || volume_liters > 200.0f) {
-        return false; // Volume out of safe range
+    float aim = pump_get_ph_target() - slope_per_min * (PUMP_MIN_DOSE_INTERVAL / 60000.0f) * 0.5f;
+    float error = predicted - aim;
+    float spread = PH_PREDICT_CONFIDENCE * sigma;
+    float bound_error = 0.0f;
+    if (error > spread) {
+        bound_error = error - spread;
+    } else if (error < -spread) {
+        bound_error = error + spread;
     }
     
-    if (current_ph < 4.0f || current_ph > 9.0f) {
-        return false; // pH reading invalid
+    if (abs(bound_error) < (trusted ? PH_BAND * 0.5f : PH_BAND)) {
+        return 0.0f;
+    }
+    return bound_error;
+}
+
+/**
+ * @brief Predictive dose size (proportional gain only: the trend takes the
+ * place of the integral term)
+ * @return ml, or 0 when too small to deliver accurately
+ */
+static float ph_predictive_ml(float kp, float bound_error, float volume_liters) {
+    float dose_ml = kp * abs(bound_error) * (volume_liters / 10.0f);
+    if (dose_ml < (pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME)) {
+        return 0.0f;
+    }
+    return dose_ml > PUMP_MAX_DOSE_VOLUME ? PUMP_MAX_DOSE_VOLUME : dose_ml;
+}
+
+/**
+ * @brief Dose on where pH will be once a dose started now has mixed
+ * @param current_ph Current pH reading
+ * @param volume_liters Reservoir volume in liters
+ * @param decision Set to the dose started
+ * @return true if dosing was performed
+ */
+static bool ph_predictive_dose(float current_ph, float volume_liters, ph_decision_t* decision) {
+    float bound_error = ph_predictive_error(&ph_predictor, current_ph);
+    if (bound_error == 0.0f) {
+        return false;                                    // Confidently in band at mix time
+    }
+    
+    PumpId pump_id = bound_error > 0.0f ? PumpId::PH_DOWN : PumpId::PH_UP;
+    pump_t* pump = &pumps[static_cast<int>(pump_id)];
+    if (!can_dose_safely(pump_id, pump)) {
+        return false;
+    }
+    
+    float dose_ml = ph_predictive_ml(pump->controller.kp, bound_error, volume_liters);
+    if (dose_ml <= 0.0f) {
+        return false;
     }
     
+    bool success = start_fractionated_dose(pump_id, dose_ml, current_ph, pump_get_ph_target());
+    if (success) {
+        decision->pump = pump_id;
+        decision->ml = dose_ml;
+        Serial.printf("pH predictive dosing: %.1fml %s (pH %.2f, mixed %.2f+/-%.2f, slope %+.2f/h, Vol: %.1fL)\n",
+                     dose_ml, kPumpNames[static_cast<int>(pump_id)], current_ph, ph_predictor.predicted_ph,
+                     PH_PREDICT_CONFIDENCE * ph_predictor.predicted_sigma, ph_predictor.slope_per_h, volume_liters);
+    }
+    return success;
+}
+
+/**
+ * @brief Dose on the current pH error through the per-pump PID
+ * @param current_ph Current pH reading
+ * @param volume_liters Reservoir volume in liters
+ * @param decision Set to the dose started
+ * @return true if dosing was performed
+ */
+static bool ph_reactive_dose(float current_ph, float volume_liters, ph_decision_t* decision) {
     // Determine which pump to use
     PumpId pump_id = (current_ph > pumps[static_cast<int>(PumpId::PH_UP)].controller.target_value) ? 
                         PumpId::PH_DOWN : PumpId::PH_UP;
@@ -368,18 +993,28 @@ bool pump_ph_dose(float current_ph, float volume_liters) {
         return false;
     }
     
+    // Each pump's integral only ever sees errors of its own sign. Micro doses keep
+    // the PID out of the 5ml floor, so clear the opposite pump's integral when the
+    // direction changes or it winds up into full-size overshoots
+    if (pump_system.micro_dosing) {
+        PumpId opposite = (pump_id == PumpId::PH_UP) ? PumpId::PH_DOWN : PumpId::PH_UP;
+        pumps[static_cast<int>(opposite)].controller.integral = 0.0f;
+    }
+    
     // Calculate dose using PID
     float dose_ml = calculate_pid_dose(&pump->controller, current_ph, volume_liters);
     
     // Skip if dose is too small (within acceptable range)
-    if (dose_ml < (float)PUMP_MIN_DOSE_VOLUME) {
+    if (dose_ml < (pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME)) {
         return false;
     }
     
     // Start dosing
-    bool success = start_pump_dose(pump_id, dose_ml, PUMP_DEFAULT_FLOW_RATE);
+    bool success = start_fractionated_dose(pump_id, dose_ml, current_ph, pump->controller.target_value);
     
     if (success) {
+        decision->pump = pump_id;
+        decision->ml = dose_ml;
         Serial.printf("pH dosing: %.1fml %s (pH %.2f → %.2f, Vol: %.1fL)\n",
                      dose_ml, 
                      (pump_id == PumpId::PH_UP) ? "pH_Up" : "pH_Down",
@@ -389,6 +1024,149 @@ bool pump_ph_dose(float current_ph, float volume_liters) {
     return success;
 }
 
+/**
+ * @brief Decide what the shadow policy would dose on this reading and count it
+ * against the live decision. Same pump choice rules, lockouts and dose limits
+ * as the live loop; nothing is actuated.
+ * @param current_ph Current pH reading
+ * @param volume_liters Reservoir volume in liters
+ * @param available pH Up / pH Down free to dose before the live decision
+ * @param live Dose the live loop started (ml 0 = none)
+ */
+static void ph_shadow_evaluate(float current_ph, float volume_liters, const bool available[2],
+                               const ph_decision_t& live) {
+    uint32_t started = micros();
+    float target = pump_get_ph_target();
+    ph_decision_t shadow = {PumpId::PH_UP, 0.0f};
+    
+    if (ph_shadow.policy == PhPolicy::PREDICTIVE) {
+        float bound_error = ph_predictive_error(&ph_shadow.predictor, current_ph);
+        shadow.pump = bound_error > 0.0f ? PumpId::PH_DOWN : PumpId::PH_UP;
+        int index = static_cast<int>(shadow.pump);
+        if (bound_error != 0.0f && available[index]) {
+            shadow.ml = ph_predictive_ml(ph_shadow.pid[index].kp, bound_error, volume_liters);
+        }
+    } else {
+        shadow.pump = current_ph > target ? PumpId::PH_DOWN : PumpId::PH_UP;
+        int index = static_cast<int>(shadow.pump);
+        if (available[index]) {
+            for (int i = 0; i < 2; i++) {
+                if (ph_shadow.pid[i].target_value != target) {          // Follow live target changes
+                    ph_shadow.pid[i].target_value = target;
+                    ph_shadow.pid[i].integral = 0.0f;
+                    ph_shadow.pid[i].last_error = 0.0f;
+                }
+            }
+            if (pump_system.micro_dosing) {
+                ph_shadow.pid[1 - index].integral = 0.0f;
+            }
+            float dose_ml = calculate_pid_dose(&ph_shadow.pid[index], current_ph, volume_liters);
+            if (dose_ml >= (pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME)) {
+                shadow.ml = dose_ml;
+            }
+        }
+    }
+    
+    ph_shadow_stats_t* stats = &ph_shadow.stats;
+    stats->decisions++;
+    bool live_doses = live.ml > 0.0f;
+    bool shadow_doses = shadow.ml > 0.0f;
+    if (live_doses) {
+        stats->live_doses[static_cast<int>(live.pump)]++;
+        stats->live_ml[static_cast<int>(live.pump)] += live.ml;
+    }
+    if (shadow_doses) {
+        stats->shadow_doses[static_cast<int>(shadow.pump)]++;
+        stats->shadow_ml[static_cast<int>(shadow.pump)] += shadow.ml;
+    }
+    if (live_doses && shadow_doses) {
+        if (live.pump == shadow.pump) {
+            stats->agreements++;
+            stats->same_pump_doses++;
+            stats->same_pump_ml_diff += shadow.ml - live.ml;
+        } else {
+            stats->opposite++;
+        }
+    } else if (live_doses) {
+        stats->live_only++;
+    } else if (shadow_doses) {
+        stats->shadow_only++;
+    } else {
+        stats->agreements++;
+    }
+    
+    if (live_doses || shadow_doses) {
+        Serial.printf("pH shadow (%s): live %.1fml %s, shadow %.1fml %s (pH %.2f)\n",
+                      ph_shadow.policy == PhPolicy::PREDICTIVE ? "predictive" : "PID",
+                      live.ml, live_doses ? kPumpNames[static_cast<int>(live.pump)] : "-",
+                      shadow.ml, shadow_doses ? kPumpNames[static_cast<int>(shadow.pump)] : "-", current_ph);
+    }
+    
+    uint32_t elapsed = micros() - started;
+    if (elapsed > stats->max_eval_us) stats->max_eval_us = elapsed;
+}
+
+/**
+ * @brief Perform automatic pH dosing (PID or predictive)
+ *
+ * A shadow controller, when set, decides on the same reading after the live
+ * dose has started; it only logs and counts.
+ * @param current_ph Current pH reading
+ * @param volume_liters Reservoir volume in liters
+ * @return true if dosing was performed
+ */
+bool pump_ph_dose(float current_ph, float volume_liters) {
+    if (!pump_system.initialized || !pump_system.auto_ph_control) {
+        return false;
+    }
+    
+    // The trends keep learning while dosing is paused
+    uint32_t now = millis();
+    if (pump_system.ph_predictive) {
+        ph_predictor_observe(&ph_predictor, current_ph, now);
+    }
+    if (ph_shadow.policy == PhPolicy::PREDICTIVE) {
+        ph_predictor_observe(&ph_shadow.predictor, current_ph, now);
+    }
+    
+    // A fractionated dose stops early once the reading reaches the target
+    ph_series_observe(current_ph);
+    
+    // Paused by a safety monitor (e.g. suspected leak)
+    if (pump_system.auto_inhibit) {
+        return false;
+    }
+    
+    // Validate inputs
+    if (volume_liters < 5.0f || volume_liters > 200.0f) {
+        return false; // Volume out of safe range
+    }
+    
+    if (current_ph < 4.0f || current_ph > 9.0f) {
+        return false; // pH reading invalid
+    }
+    
+    // The shadow sees the pump lockouts as they were before the live decision.
+    // Checked on copies: the check restarts an expired hourly window, which must
+    // only happen for the pump the live loop itself checks
+    bool available[2] = {false, false};
+    if (ph_shadow.policy != PhPolicy::OFF) {
+        for (int i = 0; i < 2; i++) {
+            pump_t probe = pumps[i];
+            available[i] = can_dose_safely(static_cast<PumpId>(i), &probe);
+        }
+    }
+    
+    ph_decision_t live = {PumpId::PH_UP, 0.0f};
+    bool success = pump_system.ph_predictive ? ph_predictive_dose(current_ph, volume_liters, &live)
+                                             : ph_reactive_dose(current_ph, volume_liters, &live);
+    
+    if (ph_shadow.policy != PhPolicy::OFF) {
+        ph_shadow_evaluate(current_ph, volume_liters, available, live);
+    }
+    return success;
+}
+
 /**
  * @brief Set pH target value
  * @param target_ph Target pH (5.0-8.0)
@@ -425,7 +1203,8 @@ bool pump_manual_dose(PumpId pump, float ml) {
     }
     
     // Clamp dose to safety limits
-    ml = constrain(ml, (float)PUMP_MIN_DOSE_VOLUME, PUMP_MAX_DOSE_VOLUME);
+    ml = constrain(ml, pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME,
+                   PUMP_MAX_DOSE_VOLUME);
     
     // Check safety limits
     if (!can_dose_safely(pump, &pumps[pump_index])) {
@@ -433,7 +1212,7 @@ bool pump_manual_dose(PumpId pump, float ml) {
         return false;
     }
     
-    bool success = start_pump_dose(pump, ml, PUMP_DEFAULT_FLOW_RATE);
+    bool success = start_dose(pump, ml, true);
     
     if (success) {
         Serial.printf("Manual dose: %.1fml %s\n", ml, 
@@ -443,31 +1222,210 @@ bool pump_manual_dose(PumpId pump, float ml) {
     return success;
 }
 
+/**
+ * @brief Check a manual dose against the safety limits without starting it
+ * Same checks as pump_manual_dose(): pump idle, dose interval, hourly count
+ * and system state.
+ */
+bool pump_can_dose(PumpId pump) {
+    int pump_index = static_cast<int>(pump);
+    if (pump_index >= static_cast<int>(PumpId::COUNT) || !pump_system.initialized) {
+        return false;
+    }
+    return can_dose_safely(pump, &pumps[pump_index]);
+}
+
 //=============================================================================
-// EC CONTROL FUNCTIONS (Phase 2 placeholders)
+// EC CONTROL FUNCTIONS
 //=============================================================================
 
 /**
- * @brief EC dosing function (not implemented in Phase 1)
- * @return false (not implemented)
+ * @brief Perform automatic EC dosing (proportional, nutrient A and B in equal parts)
+ * Nutrients can only raise EC; an EC above target is left to the operator
+ * (top-up water).
+ * @param current_ec Current EC reading (mS/cm)
+ * @param volume_liters Reservoir volume in liters
+ * @return true if dosing was performed
  */
 bool pump_ec_dose(float current_ec, float volume_liters) {
-    // Phase 2 implementation
-    return false;
+    if (!pump_system.initialized || !pump_system.auto_ec_control) {
+        return false;
+    }
+    
+    // Paused by a safety monitor (e.g. suspected leak)
+    if (pump_system.auto_inhibit) {
+        return false;
+    }
+    
+    // Validate inputs
+    if (volume_liters < 5.0f || volume_liters > 200.0f) {
+        return false; // Volume out of safe range
+    }
+    
+    if (current_ec < 0.05f || current_ec > 5.0f) {
+        return false; // EC reading invalid
+    }
+    
+    float error = pump_system.ec_target - current_ec;
+    if (error < EC_BAND * 0.5f) {
+        return false;
+    }
+    
+    // Each pump delivers half of the A+B total
+    float dose_ml = PUMP_EC_GAIN * error * volume_liters / PUMP_EC_PER_ML_L * 0.5f;
+    if (dose_ml < (pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME)) {
+        return false;                                    // Too small to deliver accurately
+    }
+    if (dose_ml > PUMP_MAX_DOSE_VOLUME) {
+        dose_ml = PUMP_MAX_DOSE_VOLUME;
+    }
+    
+    // A and B only go in together
+    if (!can_dose_safely(PumpId::NUTRIENT_A, &pumps[static_cast<int>(PumpId::NUTRIENT_A)]) ||
+        !can_dose_safely(PumpId::NUTRIENT_B, &pumps[static_cast<int>(PumpId::NUTRIENT_B)])) {
+        return false;
+    }
+    
+    bool success = start_dose(PumpId::NUTRIENT_A, dose_ml, true);
+    if (success && !start_dose(PumpId::NUTRIENT_B, dose_ml, true)) {
+        Serial.println("WARNING: Nut_B failed to start - EC dose is Nut_A only");
+    }
+    
+    if (success) {
+        Serial.printf("EC dosing: %.1fml Nut_A + %.1fml Nut_B (EC %.2f → %.2f, Vol: %.1fL)\n",
+                     dose_ml, dose_ml, current_ec, pump_system.ec_target, volume_liters);
+    }
+    
+    return success;
 }
 
 /**
- * @brief Set EC target (no-op in Phase 1)
+ * @brief Set EC target value
+ * @param target_ec Target EC (0.2-4.0 mS/cm)
  */
 void pump_set_ec_target(float target_ec) {
-    // Phase 2 implementation
+    pump_system.ec_target = constrain(target_ec, 0.2f, 4.0f);
 }
 
 /**
- * @brief Get EC target (returns 0.0 in Phase 1)
+ * @brief Get current EC target
+ * @return Current EC target value (mS/cm)
  */
 float pump_get_ec_target(void) {
-    return 0.0f; // Phase 2 implementation
+    return pump_system.ec_target;
+}
+
+//=============================================================================
+// COUPLED PH/EC CONTROL FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Perform joint pH/EC dosing from the learned response model
+ *
+ * Each joint dose is read back once it has mixed (PUMP_COUPLED_SETTLE_MS) and
+ * its pH and EC change, cross-effects included, teaches the model; no new
+ * dose is planned before then. A plan is scaled as a whole to the per-pump
+ * limit so its pH/EC balance is kept, parts too small to deliver are dropped,
+ * and it only starts when every pump it needs passes the safety checks.
+ * @param current_ph Current pH reading
+ * @param current_ec Current EC reading (mS/cm)
+ * @param volume_liters Reservoir volume in liters
+ * @return true if dosing was performed
+ */
+bool pump_coupled_dose(float current_ph, float current_ec, float volume_liters) {
+    if (!pump_system.initialized || !pump_system.auto_ph_control || !pump_system.auto_ec_control) {
+        return false;
+    }
+    
+    // A fractionated dose left over from independent mode still stops at its target
+    ph_series_observe(current_ph);
+    
+    // Validate inputs
+    if (volume_liters < 5.0f || volume_liters > 200.0f) {
+        return false; // Volume out of safe range
+    }
+    
+    if (current_ph < 4.0f || current_ph > 9.0f || current_ec < 0.05f || current_ec > 5.0f) {
+        return false; // pH or EC reading invalid
+    }
+    
+    // Learn from the last joint dose once it has mixed (the model keeps learning while paused)
+    uint32_t now = millis();
+    if (dose_observation.pending) {
+        uint32_t age = now - dose_observation.time;
+        if (age < PUMP_COUPLED_SETTLE_MS) {
+            return false;
+        }
+        if (age < 2 * PUMP_COUPLED_SETTLE_MS) {   // Older responses may include other doses
+            dose_model_learn(&dose_model, dose_observation.ml_per_l,
+                             current_ph - dose_observation.ph, current_ec - dose_observation.ec);
+        }
+        dose_observation.pending = false;
+    }
+    
+    // Paused by a safety monitor (e.g. suspected leak)
+    if (pump_system.auto_inhibit) {
+        return false;
+    }
+    
+    dose_plan_t plan;
+    if (!dose_model_plan(&dose_model, pump_get_ph_target() - current_ph, pump_system.ec_target - current_ec,
+                         true, PH_BAND, EC_BAND, &plan)) {
+        return false;
+    }
+    
+    // Plan (ml/L per group) to ml per pump; the A+B total is split equally
+    float ml[static_cast<int>(PumpId::COUNT)];
+    float largest = 0.0f;
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        ml[i] = plan.ml_per_l[static_cast<int>(pump_dose_group(i))] * volume_liters;
+        if (pump_dose_group(i) == DoseGroup::NUTRIENT) ml[i] *= 0.5f;
+        if (ml[i] > largest) largest = ml[i];
+    }
+    float scale = largest > PUMP_MAX_DOSE_VOLUME ? PUMP_MAX_DOSE_VOLUME / largest : 1.0f;
+    float min_ml = pump_system.micro_dosing ? PUMP_MICRO_MIN_VOLUME : PUMP_MIN_DOSE_VOLUME;
+    bool any = false;
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        ml[i] *= scale;
+        if (ml[i] < min_ml) {
+            ml[i] = 0.0f;                                // Too small to deliver accurately
+            continue;
+        }
+        if (!can_dose_safely(static_cast<PumpId>(i), &pumps[i])) {
+            return false;                                // All pumps of the plan or none
+        }
+        any = true;
+    }
+    if (!any) {
+        return false;
+    }
+    
+    dose_observation_t observation = dose_observation_t();
+    bool success = false;
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        if (ml[i] <= 0.0f) continue;
+        if (!start_dose(static_cast<PumpId>(i), ml[i], true)) {
+            Serial.printf("WARNING: %s failed to start - coupled dose incomplete\n", kPumpNames[i]);
+            continue;
+        }
+        observation.ml_per_l[static_cast<int>(pump_dose_group(i))] += ml[i] / volume_liters;
+        success = true;
+    }
+    
+    if (success) {
+        observation.ph = current_ph;
+        observation.ec = current_ec;
+        observation.time = now;
+        observation.pending = true;
+        dose_observation = observation;
+        Serial.printf("Coupled dosing: pH_Up %.1fml, pH_Down %.1fml, Nut_A/B %.1fml each "
+                      "(pH %.2f → %.2f, EC %.2f → %.2f, Vol: %.1fL)\n",
+                      ml[static_cast<int>(PumpId::PH_UP)], ml[static_cast<int>(PumpId::PH_DOWN)],
+                      ml[static_cast<int>(PumpId::NUTRIENT_A)], current_ph, pump_get_ph_target(),
+                      current_ec, pump_system.ec_target, volume_liters);
+    }
+    
+    return success;
 }
 
 //=============================================================================
@@ -501,6 +1459,84 @@ void pump_get_ph_pid(float* kp, float* ki, float* kd) {
     *kd = pumps[static_cast<int>(PumpId::PH_UP)].controller.kd;
 }
 
+//=============================================================================
+// SHADOW PH CONTROLLER FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Start a shadow pH controller (or stop it with PhPolicy::OFF)
+ *
+ * The shadow decides on every reading the live pH loop decides on and logs
+ * what it would have dosed next to the live dose. Statistics restart here.
+ * @param policy Candidate policy
+ * @param kp Proportional gain (the predictive policy uses Kp only)
+ * @param ki Integral gain
+ * @param kd Derivative gain
+ */
+void pump_set_ph_shadow(PhPolicy policy, float kp, float ki, float kd) {
+    ph_shadow.policy = policy;
+    for (int i = 0; i < 2; i++) {
+        ph_shadow.pid[i] = pid_controller_t();
+        ph_shadow.pid[i].kp = constrain(kp, 0.1f, 50.0f);
+        ph_shadow.pid[i].ki = constrain(ki, 0.0f, 5.0f);
+        ph_shadow.pid[i].kd = constrain(kd, 0.0f, 10.0f);
+        ph_shadow.pid[i].target_value = pump_get_ph_target();
+    }
+    ph_predictor_restart(&ph_shadow.predictor, false);
+    memset(&ph_shadow.stats, 0, sizeof(ph_shadow.stats));
+}
+
+/**
+ * @brief Get the shadow pH policy
+ * @return PhPolicy::OFF when no shadow is running
+ */
+PhPolicy pump_get_ph_shadow(void) {
+    return ph_shadow.policy;
+}
+
+/**
+ * @brief Copy the live vs shadow statistics
+ */
+void pump_get_ph_shadow_stats(ph_shadow_stats_t* stats) {
+    *stats = ph_shadow.stats;
+}
+
+/**
+ * @brief Print the live vs shadow summary
+ */
+void pump_print_ph_shadow(void) {
+    if (ph_shadow.policy == PhPolicy::OFF) {
+        Serial.println("pH shadow controller: OFF");
+        return;
+    }
+    const ph_shadow_stats_t& stats = ph_shadow.stats;
+    const pid_controller_t& pid = ph_shadow.pid[0];
+    Serial.println("=== PH SHADOW CONTROLLER ===");
+    if (ph_shadow.policy == PhPolicy::PREDICTIVE) {
+        Serial.printf("Shadow: PREDICTIVE (Kp=%.1f) | Live: %s\n", pid.kp,
+                      pump_system.ph_predictive ? "PREDICTIVE" : "REACTIVE (PID)");
+    } else {
+        Serial.printf("Shadow: PID (Kp=%.1f, Ki=%.2f, Kd=%.1f) | Live: %s\n", pid.kp, pid.ki, pid.kd,
+                      pump_system.ph_predictive ? "PREDICTIVE" : "REACTIVE (PID)");
+    }
+    float agree_pct = stats.decisions ? 100.0f * stats.agreements / stats.decisions : 0.0f;
+    Serial.printf("Decisions: %lu | Agree: %.1f%% | Opposite pump: %lu | Live only: %lu | Shadow only: %lu\n",
+                  (unsigned long)stats.decisions, agree_pct, (unsigned long)stats.opposite,
+                  (unsigned long)stats.live_only, (unsigned long)stats.shadow_only);
+    Serial.printf("Live:   pH_Up %lu doses %.1fml | pH_Down %lu doses %.1fml\n",
+                  (unsigned long)stats.live_doses[0], stats.live_ml[0],
+                  (unsigned long)stats.live_doses[1], stats.live_ml[1]);
+    Serial.printf("Shadow: pH_Up %lu doses %.1fml | pH_Down %lu doses %.1fml\n",
+                  (unsigned long)stats.shadow_doses[0], stats.shadow_ml[0],
+                  (unsigned long)stats.shadow_doses[1], stats.shadow_ml[1]);
+    if (stats.same_pump_doses) {
+        Serial.printf("Same-pump doses: %lu, shadow - live %+.2fml on average\n",
+                      (unsigned long)stats.same_pump_doses, stats.same_pump_ml_diff / stats.same_pump_doses);
+    }
+    Serial.printf("Shadow evaluation: max %luus\n", (unsigned long)stats.max_eval_us);
+    Serial.println("============================");
+}
+
 //=============================================================================
 // STATUS AND UTILITY FUNCTIONS
 //=============================================================================
@@ -515,12 +1551,51 @@ void pump_print_status(void) {
     }
     
     Serial.println("=== PUMP SYSTEM STATUS ===");
-    Serial.printf("Auto pH Control: %s\n", pump_system.auto_ph_control ? "ON" : "OFF");
+    Serial.printf("Auto pH Control: %s%s\n", pump_system.auto_ph_control ? "ON" : "OFF",
+                  (pump_system.auto_inhibit & PUMP_INHIBIT_LEAK)        ? " (paused: leak suspected)"
+                  : (pump_system.auto_inhibit & PUMP_INHIBIT_ADC_SCALE) ? " (paused: recalibrate pH/EC)"
+                                                                        : "");
     Serial.printf("pH Target: %.1f\n", pump_get_ph_target());
+    Serial.printf("Auto EC Control: %s\n", pump_system.auto_ec_control ? "ON" : "OFF");
+    Serial.printf("EC Target: %.2f mS/cm\n", pump_system.ec_target);
     
     float kp, ki, kd;
     pump_get_ph_pid(&kp, &ki, &kd);
     Serial.printf("pH PID: Kp=%.1f, Ki=%.2f, Kd=%.1f\n", kp, ki, kd);
+    if (pump_system.ph_predictive) {
+        Serial.printf("pH Mode: PREDICTIVE (mixed pH %.2f +/- %.2f, slope %+.2f/h%s)\n",
+                      ph_predictor.predicted_ph, PH_PREDICT_CONFIDENCE * ph_predictor.predicted_sigma,
+                      ph_predictor.slope_per_h, ph_predictor.settling ? ", dose mixing" : "");
+    } else {
+        Serial.println("pH Mode: REACTIVE (PID)");
+    }
+    if (ph_shadow.policy != PhPolicy::OFF) {
+        Serial.printf("pH Shadow: %s, %lu decisions, agree %.1f%% (H for summary)\n",
+                      ph_shadow.policy == PhPolicy::PREDICTIVE ? "PREDICTIVE" : "PID",
+                      (unsigned long)ph_shadow.stats.decisions,
+                      ph_shadow.stats.decisions ? 100.0f * ph_shadow.stats.agreements / ph_shadow.stats.decisions : 0.0f);
+    }
+    Serial.printf("Micro-dosing: %s (%.1f-%.1fml as timed pulses)\n", pump_system.micro_dosing ? "ON" : "OFF",
+                  PUMP_MICRO_MIN_VOLUME, PUMP_MIN_DOSE_VOLUME);
+    if (pump_system.fraction_count > 1) {
+        Serial.printf("Dose fractionation: %d pieces, %lus mixing gaps\n", pump_system.fraction_count,
+                      (unsigned long)(pump_system.fraction_gap_ms / 1000));
+    } else {
+        Serial.println("Dose fractionation: OFF");
+    }
+    if (pump_system.coupled_control) {
+        Serial.printf("pH/EC Mode: COUPLED%s (%u doses learned%s)\n",
+                      (pump_system.auto_ph_control && pump_system.auto_ec_control) ? "" : " - needs auto pH and EC",
+                      dose_model.observations, dose_observation.pending ? ", dose mixing" : "");
+        const char* channels[DOSE_CHANNEL_COUNT] = {"pH", "EC"};
+        Serial.println("  per ml/L   pH_Up  pH_Down  Nut_A+B");
+        for (int c = 0; c < DOSE_CHANNEL_COUNT; c++) {
+            Serial.printf("  %-8s %+7.3f %+8.3f %+8.3f\n", channels[c], dose_model.effect[c][0],
+                          dose_model.effect[c][1], dose_model.effect[c][2]);
+        }
+    } else {
+        Serial.println("pH/EC Mode: INDEPENDENT");
+    }
     
     for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
         pump_t* pump = &pumps[i];
@@ -538,7 +1613,7 @@ void pump_print_status(void) {
             uint32_t  remaining = pump->run_duration_ms - state_duration;
             Serial.printf(" (%.1fs remaining)", remaining / 1000.0f);
         } else if (current_state == PumpState::COOLING_DOWN) {
-            uint32_t  remaining = 300000 - state_duration; // 5 minutes cooling
+            uint32_t  remaining = pump_get_state_remaining_ms(static_cast<PumpId>(i));
             Serial.printf(" (%.1fs remaining)", remaining / 1000.0f);
         } else if (current_state == PumpState::PRIMING) {
             Serial.printf(" (%.1fs)", state_duration / 1000.0f);
@@ -546,8 +1621,17 @@ void pump_print_status(void) {
             Serial.printf(" (%.1fs in state)", state_duration / 1000.0f);
         }
         
+        if (pump->series_remaining > 0) {
+            Serial.printf(" | Series: %d of %d pieces left", pump->series_remaining, pump->series_count);
+        }
         Serial.printf(" | Doses: %d/3 this hour", pump->controller.doses_this_hour);
-        Serial.printf(" | Total: %.1fml", pump->controller.total_ml_dosed);
+        Serial.printf(" | Total: %.1fml (+%.1fml priming)", pump->controller.total_ml_dosed, pump->line.primed_ml);
+        Serial.printf(" | Line: %.2f/%.2fml%s", line_fill_ml(pump, millis()), pump->line.dead_ml,
+                      pump->line.calibrated ? "" : " (default)");
+        if (pump_system.micro_dosing) {
+            Serial.printf(" | Pulse: %.1fml/min, dead %lums%s", pump->pulse_cal.flow_ml_per_min,
+                          (unsigned long)pump->pulse_cal.dead_ms, pump->pulse_cal.calibrated ? "" : " (default)");
+        }
         
         // Next dose availability
         uint32_t  time_since_last = millis() - pump->controller.last_dose_time;
@@ -572,6 +1656,18 @@ bool pump_is_running(PumpId pump) {
     return pumps[pump_index].running;
 }
 
+/**
+ * @brief Check if any pump is running
+ * A running pump is stopped by pump_update() from loop(), so console prompts
+ * that block loop() refuse to start while this is true.
+ */
+bool pump_any_running(void) {
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        if (pumps[i].running) return true;
+    }
+    return false;
+}
+
 /**
  * @brief Reset dose counters (for testing/maintenance)
  */
@@ -596,6 +1692,29 @@ float pump_get_total_dosed(PumpId pump) {
     return pumps[pump_index].controller.total_ml_dosed;
 }
 
+/**
+ * @brief Get ml pumped into a pump's line by priming (drawn from the bottle, not dosed)
+ * @param pump Pump identifier
+ * @return Lifetime primed ml
+ */
+float pump_get_total_primed(PumpId pump) {
+    int pump_index = static_cast<int>(pump);
+    if (pump_index >= static_cast<int>(PumpId::COUNT)) return 0.0f;
+    return pumps[pump_index].line.primed_ml;
+}
+
+/**
+ * @brief Get ml delivered into the reservoir by all pumps
+ * @return Lifetime ml of doses plus manual runs (accrued up to the last update)
+ */
+float pump_get_total_inflow_ml(void) {
+    float total = 0.0f;
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        total += pumps[i].controller.total_ml_dosed;
+    }
+    return total;
+}
+
 //=============================================================================
 // AUTO CONTROL FUNCTIONS
 //=============================================================================
@@ -613,6 +1732,9 @@ void pump_enable_auto_ph(bool enabled) {
             pumps[i].controller.integral = 0.0f;
             pumps[i].controller.last_error = 0.0f;
         }
+    } else {
+        cancel_series(static_cast<int>(PumpId::PH_UP), "auto pH off");
+        cancel_series(static_cast<int>(PumpId::PH_DOWN), "auto pH off");
     }
 }
 
@@ -624,6 +1746,116 @@ bool pump_is_auto_ph_enabled(void) {
     return pump_system.auto_ph_control;
 }
 
+/**
+ * @brief Enable or disable automatic EC control
+ * @param enabled true to enable, false to disable
+ */
+void pump_enable_auto_ec(bool enabled) {
+    pump_system.auto_ec_control = enabled;
+}
+
+/**
+ * @brief Check if automatic EC control is enabled
+ * @return true if auto EC control is enabled
+ */
+bool pump_is_auto_ec_enabled(void) {
+    return pump_system.auto_ec_control;
+}
+
+/**
+ * @brief Select coupled (joint, learned model) or independent pH and EC dosing
+ * Coupled dosing runs only while auto pH and auto EC are both enabled. The
+ * learned model is kept; a dose still mixing is not learned from.
+ * @param enabled true for coupled
+ */
+void pump_enable_coupled_control(bool enabled) {
+    pump_system.coupled_control = enabled;
+    dose_observation.pending = false;
+}
+
+/**
+ * @brief Check if coupled pH/EC dosing is selected
+ * @return true if coupled
+ */
+bool pump_is_coupled_control(void) {
+    return pump_system.coupled_control;
+}
+
+/**
+ * @brief Select predictive (trend) or reactive (PID) automatic pH dosing
+ * @param enabled true for predictive
+ */
+void pump_enable_ph_predictive(bool enabled) {
+    pump_system.ph_predictive = enabled;
+    ph_predictor_restart(&ph_predictor, false);
+}
+
+/**
+ * @brief Check if predictive pH dosing is selected
+ * @return true if predictive
+ */
+bool pump_is_ph_predictive(void) {
+    return pump_system.ph_predictive;
+}
+
+/**
+ * @brief Enable or disable micro-dosing of sub-minimum volumes
+ * @param enabled true to deliver 0.2-5ml doses as timed pulses
+ */
+void pump_enable_micro_dosing(bool enabled) {
+    pump_system.micro_dosing = enabled;
+}
+
+/**
+ * @brief Check if micro-dosing is enabled
+ * @return true if sub-minimum doses are delivered as pulses
+ */
+bool pump_is_micro_dosing(void) {
+    return pump_system.micro_dosing;
+}
+
+/**
+ * @brief Configure splitting of automatic doses into pieces
+ * @param count Pieces per dose (1 = no splitting, max PUMP_FRACTION_MAX_COUNT)
+ * @param gap_ms Mixing time between the end of one piece and the next
+ */
+void pump_set_dose_fractionation(uint8_t count, uint32_t gap_ms) {
+    pump_system.fraction_count = constrain(count, (uint8_t)1, (uint8_t)PUMP_FRACTION_MAX_COUNT);
+    pump_system.fraction_gap_ms = constrain(gap_ms, PUMP_FRACTION_MIN_GAP_MS, PUMP_FRACTION_MAX_GAP_MS);
+}
+
+/**
+ * @brief Get the dose splitting configuration
+ * @param count Pieces per dose (1 = no splitting)
+ * @param gap_ms Mixing time between pieces
+ */
+void pump_get_dose_fractionation(uint8_t* count, uint32_t* gap_ms) {
+    *count = pump_system.fraction_count;
+    *gap_ms = pump_system.fraction_gap_ms;
+}
+
+/**
+ * @brief Pause or resume automatic dosing for one reason
+ * Dosing resumes only when every reason has been cleared.
+ * @param reason PUMP_INHIBIT_* bit
+ * @param active true to pause, false to clear this reason
+ */
+void pump_set_auto_inhibit(uint8_t reason, bool active) {
+    if (active) {
+        pump_system.auto_inhibit |= reason;
+    } else {
+        pump_system.auto_inhibit &= ~reason;
+    }
+}
+
+/**
+ * @brief Get active reasons pausing automatic dosing
+ * @return PUMP_INHIBIT_* bits (0 = dosing allowed)
+ */
+uint8_t pump_get_auto_inhibit(void) {
+    return pump_system.auto_inhibit;
+}
+
 //=============================================================================
 // MANUAL CONTROL FUNCTIONS (Phase 2)
 //=============================================================================
@@ -654,8 +1886,11 @@ bool pump_start_manual(PumpId pump, float ml_per_min) {
     uint8_t pwm_duty = calculate_pwm_duty(ml_per_min);
     pumps[pump_index].target_pwm_duty = pwm_duty;
     
-    // For manual operation, skip PRIMING and go directly to DOSING
-    if (!pump_transition_to(pump, PumpState::DOSING)) {
+    // Manual operation needs no priming: pass through PRIMING straight into DOSING
+    // (IDLE -> DOSING is not a valid transition)
+    if (!pump_transition_to(pump, PumpState::PRIMING) ||
+        !pump_transition_to(pump, PumpState::DOSING)) {
+        pump_transition_to(pump, PumpState::IDLE);
         return false;
     }
     
@@ -666,6 +1901,12 @@ bool pump_start_manual(PumpId pump, float ml_per_min) {
     pumps[pump_index].running = true;
     pumps[pump_index].start_time = millis();
     pumps[pump_index].run_duration_ms = PUMP_TIMEOUT_MS; // 10 minute safety timeout
+    pumps[pump_index].manual_flow_rate = ml_per_min;
+    if (pump == PumpId::PH_UP || pump == PumpId::PH_DOWN) {
+        ph_predictor_dose_started();
+    }
+    pumps[pump_index].manual_accounted_at = pumps[pump_index].start_time;
+    plan_priming(&pumps[pump_index]);   // Drained fill as of now; the run itself fills the line
     
     return true;
 }
@@ -683,20 +1924,261 @@ bool pump_stop_manual(PumpId pump) {
     }
     
     // Stop PWM output immediately
+    cancel_pulse(pump_index);
+    cancel_series(pump_index, nullptr);
     ledcWrite(pumps[pump_index].gpio_pin, 0);
     
+    // Count what the run delivered before its timing is cleared
+    accrue_manual_flow(&pumps[pump_index], state_manager.pump_states[pump_index]);
+    pumps[pump_index].manual_flow_rate = 0.0f;
+    
     // Update pump state
     pumps[pump_index].running = false;
     pumps[pump_index].start_time = 0;
     pumps[pump_index].run_duration_ms = 0;
     
-    // Transition pump to COOLING_DOWN if it was running, otherwise IDLE
+    // Transition pump to COOLING_DOWN if it was dosing, otherwise IDLE
+    // (PRIMING -> COOLING_DOWN is not a valid transition and left the pump PRIMING)
     PumpState current_state = state_manager.pump_states[pump_index];
-    if (current_state == PumpState::DOSING || current_state == PumpState::PRIMING) {
+    if (current_state == PumpState::DOSING) {
         pump_transition_to(pump, PumpState::COOLING_DOWN);
     } else {
         pump_transition_to(pump, PumpState::IDLE);
     }
     
     return true;
-}
\ No newline at end of file
+}
+//=============================================================================
+// PULSE CALIBRATION
+//=============================================================================
+
+/**
+ * @brief Apply a pulse calibration to one pump and store all calibrations
+ * @param pump Pump identifier
+ * @param flow_ml_per_min Flow at full duty once liquid moves
+ * @param dead_ms Run time before liquid leaves the tube
+ * @return true if plausible and applied (stored unless NVS fails)
+ */
+bool pump_set_pulse_calibration(PumpId pump, float flow_ml_per_min, uint32_t dead_ms) {
+    int pump_index = static_cast<int>(pump);
+    if (pump_index >= static_cast<int>(PumpId::COUNT)) {
+        return false;
+    }
+    
+    pump_pulse_cal_t cal;
+    cal.flow_ml_per_min = flow_ml_per_min;
+    cal.dead_ms = dead_ms;
+    cal.min_pulse_ms = dead_ms + PUMP_MICRO_MARGIN_MS;
+    cal.calibrated = true;
+    if (!pulse_cal_plausible(cal)) {
+        return false;
+    }
+    pumps[pump_index].pulse_cal = cal;
+    
+    pump_pulse_cal_t stored[static_cast<int>(PumpId::COUNT)];
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        stored[i] = pumps[i].pulse_cal;
+    }
+    Preferences store;
+    if (!store.begin(PUMP_NVS_NAMESPACE, false) ||
+        store.putBytes(PUMP_NVS_PULSE_KEY, stored, sizeof(stored)) != sizeof(stored)) {
+        Serial.println("ERROR: Failed to store pulse calibration (active until reboot)");
+    }
+    store.end();
+    return true;
+}
+
+/**
+ * @brief Read one number from the connection that issued the command
+ * @return The number, or NAN if no number arrived within timeout_ms
+ */
+static float prompt_number(uint32_t timeout_ms) {
+    char line[24];
+    if (!Debug->read_line(line, sizeof(line), timeout_ms)) return NAN;
+    char* end;
+    float value = strtof(line, &end);
+    return end != line && isfinite(value) ? value : NAN;
+}
+
+/**
+ * @brief Run one calibration point and ask for the collected volume
+ * @param pump_index Pump array index
+ * @param pulse_ms Pulse length
+ * @return ml collected from PUMP_PULSE_CAL_COUNT pulses (< 0 on failure)
+ */
+static float pulse_cal_point(int pump_index, uint32_t pulse_ms) {
+    Debug->printf("Running %d pulses of %lums...", PUMP_PULSE_CAL_COUNT, (unsigned long)pulse_ms);
+    for (int n = 0; n < PUMP_PULSE_CAL_COUNT; n++) {
+        if (!fire_pulse(pump_index, pulse_ms)) {
+            return -1.0f;
+        }
+        uint32_t start = millis();
+        while (!pumps[pump_index].pulse_done && millis() - start < pulse_ms + PUMP_MICRO_WATCHDOG_MS) {
+            delay(1);
+        }
+        cancel_pulse(pump_index);
+        ledcWrite(pumps[pump_index].gpio_pin, 0);
+        delay(PUMP_PULSE_CAL_GAP_MS);
+    }
+    Debug->println("Enter total ml collected, then empty the cylinder:");
+    float ml = prompt_number(PUMP_PULSE_CAL_INPUT_TIMEOUT_MS);
+    return ml >= 0.0f ? ml : -1.0f;
+}
+
+/**
+ * @brief Two-point pulse calibration of one pump via Serial/Telnet
+ *
+ * Runs PUMP_PULSE_CAL_COUNT short and long pulses into a measuring cylinder.
+ * The per-pulse volume difference over the pulse length difference gives the
+ * flow; the short pulse's shortfall against that flow gives the dead time.
+ */
+void pump_interactive_pulse_calibration(void) {
+    Debug->println("Pulse calibration: enter pump (1=pH_Up, 2=pH_Down, 3=Nut_A, 4=Nut_B):");
+    float pump_number = prompt_number(PUMP_CAL_INPUT_TIMEOUT_MS);
+    if (!(pump_number >= 1.0f && pump_number <= static_cast<int>(PumpId::COUNT))) {
+        Debug->println("Invalid pump - calibration cancelled");
+        return;
+    }
+    int pump_index = (int)pump_number - 1;
+    PumpId pump_id = static_cast<PumpId>(pump_index);
+    if (!pump_system.initialized || state_manager.pump_states[pump_index] != PumpState::IDLE) {
+        Debug->println("Pump busy - calibration cancelled");
+        return;
+    }
+    
+    // MAINTENANCE keeps pump_update and automatic dosing away from the pump
+    pump_transition_to(pump_id, PumpState::MAINTENANCE);
+    Debug->printf("Prime the %s tubing and hold its outlet over an empty measuring cylinder",
+                  kPumpNames[pump_index]);
+    delay(5000);
+    float short_ml = pulse_cal_point(pump_index, PUMP_PULSE_CAL_SHORT_MS);
+    float long_ml = short_ml >= 0.0f ? pulse_cal_point(pump_index, PUMP_PULSE_CAL_LONG_MS) : -1.0f;
+    pump_transition_to(pump_id, PumpState::IDLE);
+    pumps[pump_index].line.fill_ml = pumps[pump_index].line.dead_ml;   // Primed by hand and just run
+    pumps[pump_index].line.wet_at = millis();
+    
+    float short_pulse_ml = short_ml / PUMP_PULSE_CAL_COUNT;
+    float long_pulse_ml = long_ml / PUMP_PULSE_CAL_COUNT;
+    if (short_ml < 0.0f || long_pulse_ml <= short_pulse_ml) {
+        Debug->println("Invalid volumes - calibration cancelled");
+        return;
+    }
+    
+    float flow = (long_pulse_ml - short_pulse_ml) * 60000.0f / (PUMP_PULSE_CAL_LONG_MS - PUMP_PULSE_CAL_SHORT_MS);
+    float dead = PUMP_PULSE_CAL_SHORT_MS - short_pulse_ml * 60000.0f / flow;
+    if (dead < 0.0f) dead = 0.0f;
+    
+    if (pump_set_pulse_calibration(pump_id, flow, (uint32_t)(dead + 0.5f))) {
+        const pump_pulse_cal_t& cal = pumps[pump_index].pulse_cal;
+        Debug->printf("Pulse calibration %s: %.1f ml/min, dead time %lums, min pulse %lums (%.2fml)",
+                      kPumpNames[pump_index], cal.flow_ml_per_min, (unsigned long)cal.dead_ms,
+                      (unsigned long)cal.min_pulse_ms,
+                      (cal.min_pulse_ms - cal.dead_ms) * cal.flow_ml_per_min / 60000.0f);
+    } else {
+        Debug->printf("Pulse calibration rejected (%.1f ml/min, dead time %.0fms implausible)", flow, dead);
+    }
+}
+
+//=============================================================================
+// LINE CALIBRATION
+//=============================================================================
+
+/**
+ * @brief Apply a line volume to one pump and store all line volumes
+ * @param pump Pump identifier
+ * @param dead_ml Line volume from bottle to outlet (ml)
+ * @return true if plausible and applied (stored unless NVS fails)
+ */
+bool pump_set_line_dead_volume(PumpId pump, float dead_ml) {
+    int pump_index = static_cast<int>(pump);
+    if (pump_index >= static_cast<int>(PumpId::COUNT) || !isfinite(dead_ml) ||
+        dead_ml <= 0.0f || dead_ml > PUMP_LINE_MAX_DEAD_ML) {
+        return false;
+    }
+    pump_line_t* line = &pumps[pump_index].line;
+    line->dead_ml = dead_ml;
+    line->calibrated = true;
+    if (line->fill_ml > dead_ml) line->fill_ml = dead_ml;
+    
+    float stored[static_cast<int>(PumpId::COUNT)];
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        stored[i] = pumps[i].line.calibrated ? pumps[i].line.dead_ml : 0.0f;
+    }
+    Preferences store;
+    if (!store.begin(PUMP_NVS_NAMESPACE, false) ||
+        store.putBytes(PUMP_NVS_LINE_KEY, stored, sizeof(stored)) != sizeof(stored)) {
+        Serial.println("ERROR: Failed to store line volume (active until reboot)");
+    }
+    store.end();
+    return true;
+}
+
+/**
+ * @brief Get the estimated liquid in a pump's line now
+ * @param pump Pump identifier
+ * @return ml in the line (dead volume = fully primed)
+ */
+float pump_get_line_fill(PumpId pump) {
+    int pump_index = static_cast<int>(pump);
+    if (pump_index >= static_cast<int>(PumpId::COUNT)) return 0.0f;
+    return line_fill_ml(&pumps[pump_index], millis());
+}
+
+/**
+ * @brief Wait for any line from the connection that issued the command
+ * @return false if nothing arrived within timeout_ms
+ */
+static bool wait_for_line(uint32_t timeout_ms) {
+    char line[16];
+    return Debug->read_line(line, sizeof(line), timeout_ms);
+}
+
+/**
+ * @brief Measure one pump's line volume via Serial/Telnet
+ *
+ * Runs the emptied line at the priming flow until the operator sees liquid
+ * at the outlet. The line is measured in priming time, so an error in the
+ * nominal priming flow cancels out when the line is primed later.
+ */
+void pump_interactive_line_calibration(void) {
+    Debug->println("Line calibration: enter pump (1=pH_Up, 2=pH_Down, 3=Nut_A, 4=Nut_B):");
+    float pump_number = prompt_number(PUMP_CAL_INPUT_TIMEOUT_MS);
+    if (!(pump_number >= 1.0f && pump_number <= static_cast<int>(PumpId::COUNT))) {
+        Debug->println("Invalid pump - calibration cancelled");
+        return;
+    }
+    int pump_index = (int)pump_number - 1;
+    PumpId pump_id = static_cast<PumpId>(pump_index);
+    pump_t* pump = &pumps[pump_index];
+    if (!pump_system.initialized || state_manager.pump_states[pump_index] != PumpState::IDLE) {
+        Debug->println("Pump busy - calibration cancelled");
+        return;
+    }
+    
+    Debug->printf("Empty the %s line, put its inlet back in the bottle and send any line to start",
+                  kPumpNames[pump_index]);
+    if (!wait_for_line(PUMP_LINE_CAL_TIMEOUT_MS)) {
+        Debug->println("No response - calibration cancelled");
+        return;
+    }
+    
+    // MAINTENANCE keeps pump_update and automatic dosing away from the pump
+    pump_transition_to(pump_id, PumpState::MAINTENANCE);
+    Debug->println("Priming - send any line when liquid reaches the outlet");
+    uint32_t start = millis();
+    ledcWrite(pump->gpio_pin, calculate_pwm_duty(PUMP_PRIME_FLOW_RATE));
+    bool seen = wait_for_line(PUMP_LINE_CAL_TIMEOUT_MS);
+    uint32_t run_ms = millis() - start;
+    ledcWrite(pump->gpio_pin, 0);
+    pump_transition_to(pump_id, PumpState::IDLE);
+    
+    float dead_ml = PUMP_PRIME_FLOW_RATE * run_ms / 60000.0f;
+    if (!seen || !pump_set_line_dead_volume(pump_id, dead_ml)) {
+        Debug->printf("Line calibration rejected (%.2fml after %.1fs)", dead_ml, run_ms / 1000.0f);
+        return;
+    }
+    pump->line.fill_ml = dead_ml;   // Just primed
+    pump->line.wet_at = millis();
+    Debug->printf("Line calibration %s: %.2fml (%.1fs priming from empty)",
+                  kPumpNames[pump_index], dead_ml, run_ms / 1000.0f);
+}
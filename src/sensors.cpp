@@ -7,6 +7,12 @@
 
 #include "sensors.h"
 #include "state_machine.h"
+#include "binlog.h"
+#include "adc_cal.h"
+#include "adc_oversample.h"
+#include "probe_vote.h"
+#include "communication.h"
+#include <esp32-hal-ledc.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
 // Temperature compensation coefficient for EC (per °C)
@@ -55,6 +61,9 @@ static sensor_config_t sensor_config = {
  */
 static sensor_state_t sensor_state; // Default constructor handles initialization
 
+// pH oversamplers, one per probe input (extra_bits 0 = the FILTER_SAMPLES average below)
+static adc_oversample_t ph_oversample[Board::ph_probe_count] = {};
+
 //=============================================================================
 // SENSOR SYSTEM FUNCTIONS
 //=============================================================================
@@ -72,6 +81,21 @@ bool sensor_initialize(void) {
   digitalWrite(PH_POWER_PIN, LOW);
   digitalWrite(EC_POWER_PIN, LOW);
   
+  // ADC resolution and input range from the board descriptor
+  analogReadResolution(Board::adc_bits);
+  for (int i = 0; i < Board::ph_probe_count; i++) {
+    analogSetPinAttenuation(Board::ph_probe_pins[i], Board::adc_attenuation);
+  }
+  for (int i = 0; i < Board::ec_probe_count; i++) {
+    analogSetPinAttenuation(Board::ec_probe_pins[i], Board::adc_attenuation);
+  }
+  adc_cal_init();
+  probe_vote_init();
+  if (Board::ph_dither_pin >= 0) {
+    ledcAttach(Board::ph_dither_pin, PH_DITHER_PWM_FREQ, PH_DITHER_PWM_RESOLUTION);
+    ledcWrite(Board::ph_dither_pin, 0);
+  }
+  
   // Configure ultrasonic sensor pins
   pinMode(TRIG_PIN, OUTPUT);
   pinMode(ECHO_PIN, INPUT);
@@ -218,35 +242,106 @@ sensor_readings_t sensor_read_raw(void) {
   return readings;
 }
 
+/**
+ * @brief Get the most recent filtered readings without touching hardware
+ * @return Filtered readings from the last completed FILTERING phase
+ */
+sensor_readings_t sensor_get_filtered(void) {
+  return sensor_state.filtered;
+}
+
 //=============================================================================
 // INDIVIDUAL SENSOR READING FUNCTIONS
 //=============================================================================
 
+//=============================================================================
+// PH OVERSAMPLING
+//=============================================================================
+
+// ctx: the probe's ADC pin
+static int sensor_ph_sample(void* ctx) {
+  return analogRead((uint8_t)(intptr_t)ctx);
+}
+
 /**
- * @brief Read pH sensor with power management and multi-sampling
- * @return Average pH value (0-14 scale)
+ * @brief Dither ramp: duty rises from 0 to full scale across the burst
+ * Every burst sees the same ramp, so it adds a constant offset (taken up by
+ * the pH calibration) while moving the input across code boundaries.
  */
+static void sensor_ph_dither(void* ctx, int step, int steps) {
+  (void)ctx;
+  const uint32_t full = (1u << PH_DITHER_PWM_RESOLUTION) - 1;
+  ledcWrite(Board::ph_dither_pin, (uint32_t)((uint64_t)full * step / (steps - 1)));
+}
+
+void sensor_set_ph_oversampling(uint8_t extra_bits) {
+  for (adc_oversample_t& os : ph_oversample) adc_oversample_init(&os, extra_bits);
+}
+
+uint8_t sensor_get_ph_oversampling(void) {
+  return ph_oversample[0].extra_bits;
+}
+
 /**
- * @brief Read pH sensor with power management, multi-sampling, and temperature compensation
+ * @brief Report the pH channel's measured resolution
+ * Statistics cover the readings since the setting last changed.
+ */
+void sensor_print_ph_resolution(void) {
+  const adc_oversample_t& os = ph_oversample[0];   // Probe 1
+  const float mv_per_lsb = SENSOR_ADC_VOLTS_PER_COUNT * 1000.0f;
+  if (os.extra_bits == 0) {
+    Debug->printf("pH ADC: %d-sample average of %d-bit codes (1 LSB = %.2f mV = %.4f pH), oversampling OFF",
+                  sensor_config.filter_samples, Board::adc_bits, mv_per_lsb, fabsf(calibration.ph_slope) * mv_per_lsb);
+    return;
+  }
+  Debug->printf("pH ADC: oversampling %u bits (%d conversions -> %d-bit code%s)", os.extra_bits,
+                1 << (2 * os.extra_bits), Board::adc_bits + os.extra_bits,
+                Board::ph_dither_pin >= 0 ? ", ramp dither" : "");
+  float noise = adc_oversample_noise_lsb(&os);
+  if (noise < 0.0f) {
+    Debug->printf("  %lu reading(s) so far - noise needs 3", (unsigned long)os.readings);
+    return;
+  }
+  float spread = adc_oversample_mean_spread_lsb(&os);
+  Debug->printf("  Burst spread %.2f LSB%s", spread,
+                spread < ADC_OVERSAMPLE_MIN_SPREAD_LSB ? " - too little dither, no bits gained" : "");
+  Debug->printf("  Noise floor %.3f LSB = %.3f mV = %.5f pH over %lu readings, effective %.1f bits", noise,
+                noise * mv_per_lsb, fabsf(calibration.ph_slope) * noise * mv_per_lsb,
+                (unsigned long)os.readings, adc_oversample_effective_bits(&os));
+}
+
+/**
+ * @brief Read one pH probe with multi-sampling and temperature compensation
+ * @param probe Probe index (0 = PH_PIN)
  * @param temperature Water temperature in degrees Celsius
  * @param calib Calibration parameters for pH sensor
  * @return Compensated average pH value (0-14 scale)
  */
-float sensor_read_ph_raw(float temperature, const calibration_t& calib) {
+static float sensor_read_ph_probe(int probe, float temperature, const calibration_t& calib) {
   // Note: Power management is now handled by state machine in sensor_read_all()
   // This function assumes sensors are already powered and warmed up
-  
+  const int pin = Board::ph_probe_pins[probe];
+  
+  // Oversampled: one decimated 14-16 bit reading instead of the average
+  adc_oversample_t* os = &ph_oversample[probe];
+  if (os->extra_bits > 0) {
+    adc_oversample_read(os, sensor_ph_sample, Board::ph_dither_pin >= 0 ? sensor_ph_dither : nullptr,
+                        (void*)(intptr_t)pin);
+    if (Board::ph_dither_pin >= 0) ledcWrite(Board::ph_dither_pin, 0);
+    float millivolts = adc_cal_millivolts_fine(adc_oversample_code(os));
+    float rawPh = constrain(calib.ph_slope * millivolts + calib.ph_offset, 0.0, 14.0);
+    float compensatedPh = rawPh + ((temperature - 25.0f) * 0.03f);
+    return constrain(compensatedPh, 0.0, 14.0);
+  }
+
   // Take multiple samples for stability
   float sum = 0;
   for (int i = 0; i < sensor_config.filter_samples; i++) {
-    // Read raw ADC value (0-4095 for ESP32-S3 12-bit ADC)
-    int rawValue = analogRead(PH_PIN);
-    
-    // Convert to voltage (0-3.3V for ESP32-S3)
-    float voltage = rawValue * (3.3f / 4095.0f);
+    // Read raw ADC value (0-4095 at the board's 12-bit resolution)
+    int rawValue = analogRead(pin);
     
-    // Convert voltage to millivolts for pH calculation
-    float millivolts = voltage * 1000.0;
+    // Convert to millivolts for pH calculation (eFuse curve table, or 0-3.3V linear)
+    float millivolts = adc_cal_millivolts(rawValue);
     
     // Apply calibration formula to get pH value using NVS calibration parameters
     float phValue = calib.ph_slope * millivolts + calib.ph_offset;
@@ -266,30 +361,40 @@ float sensor_read_ph_raw(float temperature, const calibration_t& calib) {
 }
 
 /**
- * @brief Read EC sensor with power management and multi-sampling
- * @return Average EC value in mS/cm
+ * @brief Read pH with temperature compensation, voted across the installed probes
+ * @param temperature Water temperature in degrees Celsius
+ * @param calib Calibration parameters for pH sensor
+ * @return Compensated pH (0-14), or -1 when the probes have no majority
  */
+float sensor_read_ph_raw(float temperature, const calibration_t& calib) {
+  uint8_t probes = probe_vote_count(ProbeQuantity::PH);
+  if (probes <= 1) return sensor_read_ph_probe(0, temperature, calib);
+  float readings[PROBE_MAX];
+  for (int i = 0; i < probes; i++) readings[i] = sensor_read_ph_probe(i, temperature, calib);
+  float voted;
+  return probe_vote_apply(ProbeQuantity::PH, readings, &voted) ? constrain(voted, 0.0f, 14.0f) : -1.0f;
+}
+
 /**
- * @brief Read EC sensor with power management, multi-sampling, and temperature compensation
+ * @brief Read one EC probe with multi-sampling and temperature compensation
+ * @param probe Probe index (0 = EC_PIN)
  * @param temperature Water temperature in degrees Celsius
  * @param calib Calibration parameters for EC sensor
  * @return Compensated average EC value (mS/cm)
  */
-float sensor_read_ec_raw(float temperature, const calibration_t& calib) {
+static float sensor_read_ec_probe(int probe, float temperature, const calibration_t& calib) {
   // Note: Power management is now handled by state machine in sensor_read_all()
   // This function assumes sensors are already powered and warmed up
+  const int pin = Board::ec_probe_pins[probe];
   
   // Take multiple samples for stability
   float sum = 0;
   for (int i = 0; i < sensor_config.filter_samples; i++) {
-    // Read raw ADC value (0-4095 for ESP32-S3 12-bit ADC)
-    int rawValue = analogRead(EC_PIN);
-    
-    // Convert to voltage (0-3.3V for ESP32-S3)
-    float voltage = rawValue * (3.3f / 4095.0f);
+    // Read raw ADC value (0-4095 at the board's 12-bit resolution)
+    int rawValue = analogRead(pin);
     
-    // Convert voltage to millivolts for EC calculation
-    float millivolts = voltage * 1000.0;
+    // Convert to millivolts for EC calculation (eFuse curve table, or 0-3.3V linear)
+    float millivolts = adc_cal_millivolts(rawValue);
     
     // Apply calibration formula to get EC value using NVS calibration parameters
     float ecValue = calib.ec_slope * millivolts + calib.ec_offset;
@@ -308,6 +413,19 @@ float sensor_read_ec_raw(float temperature, const calibration_t& calib) {
   return compensatedEc;
 }
 
+/**
+ * @brief Read EC with temperature compensation, voted across the installed probes
+ * @return Compensated EC (mS/cm), or -1 when the probes have no majority
+ */
+float sensor_read_ec_raw(float temperature, const calibration_t& calib) {
+  uint8_t probes = probe_vote_count(ProbeQuantity::EC);
+  if (probes <= 1) return sensor_read_ec_probe(0, temperature, calib);
+  float readings[PROBE_MAX];
+  for (int i = 0; i < probes; i++) readings[i] = sensor_read_ec_probe(i, temperature, calib);
+  float voted;
+  return probe_vote_apply(ProbeQuantity::EC, readings, &voted) ? max(voted, 0.0f) : -1.0f;
+}
+
 /**
  * @brief Read ultrasonic distance sensor (HC-SR04)
  * @return Distance in centimeters, or previous value if error
@@ -325,7 +443,7 @@ float sensor_read_distance_raw(void) {
   
   // Handle timeout error - return error indicator
   if (duration == 0) {
-    Serial.println("Distance sensor timeout");
+    binlog("Distance sensor timeout");
     return -1.0f; // Clear error indicator
   }
   
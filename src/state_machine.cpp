@@ -7,6 +7,9 @@
 
 #include "state_machine.h"
 #include "pump.h"
+#include "timer_wheel.h"
+#include "binlog.h"
+#include "telemetry.h"
 
 //=============================================================================
 // GLOBAL STATE MANAGER INSTANCE
@@ -14,16 +17,74 @@
 
 state_manager_t state_manager; // Default constructor handles proper initialization
 
+// State timeouts: one timer per state machine, re-armed on every transition
+enum StateTimer : uint8_t {
+    TIMER_SYSTEM = 0,
+    TIMER_PUMP_0,               // TIMER_PUMP_0 + pump index
+    TIMER_SENSOR = TIMER_PUMP_0 + 4,
+};
+static timer_wheel_t state_timers;
+
 //=============================================================================
 // PRIVATE HELPER FUNCTIONS
 //=============================================================================
 
 /**
  * @brief Log state transition for debugging
+ * Deferred through binlog: transitions happen inside pump updates and timer
+ * expiry, and all names are literals.
  */
 static void log_transition(const char* subsystem, const char* from_state, const char* to_state) {
     if (state_manager.debug_logging_enabled) {
-        Serial.printf("[STATE] %s: %s -> %s\n", subsystem, from_state, to_state);
+        binlog("[STATE] %s: %s -> %s", subsystem, from_state, to_state);
+    }
+}
+
+/**
+ * @brief Arm a state's timeout from its entry time, or cancel it (timeout 0)
+ */
+static void arm_state_timer(uint8_t timer, uint32_t entry_time, uint32_t timeout_ms) {
+    if (timeout_ms > 0) {
+        timer_wheel_arm(&state_timers, timer, entry_time + timeout_ms);
+    } else {
+        timer_wheel_cancel(&state_timers, timer);
+    }
+}
+
+static uint32_t system_state_timeout_ms(SystemState state) {
+    return state == SystemState::ERROR ? SYSTEM_ERROR_RECOVERY_MS : 0;
+}
+
+static uint32_t sensor_state_timeout_ms(SensorState state) {
+    switch (state) {
+        case SensorState::ERROR:      return SENSOR_ERROR_RECOVERY_MS;
+        case SensorState::WARMING_UP: return SENSOR_WARMUP_TIMEOUT_MS;
+        default:                      return 0;
+    }
+}
+
+/**
+ * @brief System state timed out
+ */
+static void system_state_expired(void) {
+    if (state_manager.system_state == SystemState::ERROR) {
+        if (state_manager.debug_logging_enabled) {
+            Serial.println("[STATE] ERROR state timeout - attempting recovery to MONITORING");
+        }
+        system_transition_to(SystemState::MONITORING);
+    }
+}
+
+/**
+ * @brief Sensor state timed out
+ */
+static void sensor_state_expired(void) {
+    if (state_manager.sensor_state == SensorState::ERROR) {
+        sensor_transition_to(SensorState::READY);
+    } else if (state_manager.sensor_state == SensorState::WARMING_UP) {
+        // Force transition if warming up takes too long
+        sensor_transition_to(SensorState::ERROR);
+        Serial.println("[SENSOR SAFETY] Warmup timeout - forced to ERROR");
     }
 }
 
@@ -43,6 +104,15 @@ bool state_machine_init(void) {
         state_manager.pump_state_entry_times[i] = now;
     }
     
+    // Timeouts of the states the machines are in now
+    timer_wheel_init(&state_timers, now);
+    arm_state_timer(TIMER_SYSTEM, now, system_state_timeout_ms(state_manager.system_state));
+    arm_state_timer(TIMER_SENSOR, now, sensor_state_timeout_ms(state_manager.sensor_state));
+    for (int i = 0; i < 4; i++) {
+        arm_state_timer(TIMER_PUMP_0 + i, now,
+                        pump_state_timeout_ms(static_cast<PumpId>(i), state_manager.pump_states[i]));
+    }
+    
     // Enable debug logging by default during initialization
     state_manager.debug_logging_enabled = true;
     
@@ -69,6 +139,7 @@ bool system_transition_to(SystemState new_state) {
     // Perform transition
     state_manager.system_state = new_state;
     state_manager.system_state_entry_time = millis();
+    arm_state_timer(TIMER_SYSTEM, state_manager.system_state_entry_time, system_state_timeout_ms(new_state));
     
     log_transition("SYSTEM", system_state_to_string(old_state), system_state_to_string(new_state));
     return true;
@@ -114,10 +185,14 @@ bool pump_transition_to(PumpId pump_id, PumpState new_state) {
     // Perform transition
     state_manager.pump_states[pump_index] = new_state;
     state_manager.pump_state_entry_times[pump_index] = millis();
+    arm_state_timer(TIMER_PUMP_0 + pump_index, state_manager.pump_state_entry_times[pump_index],
+                    pump_state_timeout_ms(pump_id, new_state));
     
-    char subsystem[16];
-    snprintf(subsystem, sizeof(subsystem), "PUMP_%d", pump_index);
-    log_transition(subsystem, pump_state_to_string(old_state), pump_state_to_string(new_state));
+    if (state_manager.debug_logging_enabled) {
+        binlog("[STATE] PUMP_%d: %s -> %s", pump_index, pump_state_to_string(old_state),
+               pump_state_to_string(new_state));
+    }
+    telemetry_publish_pump((uint8_t)pump_index, static_cast<uint8_t>(old_state), static_cast<uint8_t>(new_state));
     
     return true;
 }
@@ -140,6 +215,12 @@ uint32_t pump_get_state_duration_ms(PumpId pump_id) {
     return millis() - state_manager.pump_state_entry_times[pump_index];
 }
 
+uint32_t pump_get_state_remaining_ms(PumpId pump_id) {
+    int pump_index = static_cast<int>(pump_id);
+    if (pump_index >= 4) return 0;
+    return timer_wheel_remaining_ms(&state_timers, TIMER_PUMP_0 + pump_index, millis());
+}
+
 //=============================================================================
 // SENSOR STATE FUNCTIONS
 //=============================================================================
@@ -159,6 +240,7 @@ bool sensor_transition_to(SensorState new_state) {
     // Perform transition
     state_manager.sensor_state = new_state;
     state_manager.sensor_state_entry_time = millis();
+    arm_state_timer(TIMER_SENSOR, state_manager.sensor_state_entry_time, sensor_state_timeout_ms(new_state));
     
     log_transition("SENSOR", sensor_state_to_string(old_state), sensor_state_to_string(new_state));
     return true;
@@ -311,16 +393,19 @@ void state_machine_emergency_stop(void) {
     // Emergency stop: transition all systems to safe states immediately
     state_manager.system_state = SystemState::ERROR;
     state_manager.system_state_entry_time = millis();
+    arm_state_timer(TIMER_SYSTEM, state_manager.system_state_entry_time, SYSTEM_ERROR_RECOVERY_MS);
     
     // Stop all pumps immediately
     for (int i = 0; i < 4; i++) {
         state_manager.pump_states[i] = PumpState::IDLE;
         state_manager.pump_state_entry_times[i] = millis();
+        timer_wheel_cancel(&state_timers, TIMER_PUMP_0 + i);
     }
     
     // Reset sensor to safe state
     state_manager.sensor_state = SensorState::READY;
     state_manager.sensor_state_entry_time = millis();
+    timer_wheel_cancel(&state_timers, TIMER_SENSOR);
     
     Serial.println("[STATE EMERGENCY] All systems stopped - EMERGENCY MODE");
 }
@@ -362,15 +447,10 @@ void state_machine_enable_debug(bool enabled) {
 void state_machine_update(void) {
     uint32_t now = millis();
     
-    // Handle ERROR state recovery attempts
-    if (state_manager.system_state == SystemState::ERROR) {
-        // Allow manual recovery after 5 seconds in ERROR state
-        if (system_get_state_duration_ms() > 5000) {
-            if (state_manager.debug_logging_enabled) {
-                Serial.println("[STATE] ERROR state timeout - attempting recovery to MONITORING");
-            }
-            system_transition_to(SystemState::MONITORING);
-        }
+    // State timeouts: one wheel advance, handlers only for the states that expired
+    uint32_t due = timer_wheel_advance(&state_timers, now);
+    if (due & (1u << TIMER_SYSTEM)) {
+        system_state_expired();
     }
     
     // Handle MAINTENANCE state (pumps disabled)
@@ -384,49 +464,15 @@ void state_machine_update(void) {
         }
     }
     
-    // Automatic pump cooling down timeout handling
     for (int i = 0; i < 4; i++) {
-        if (state_manager.pump_states[i] == PumpState::COOLING_DOWN) {
-            // 5-minute cooling down period (300000ms)
-            if (pump_get_state_duration_ms(static_cast<PumpId>(i)) > 300000) {
-                pump_transition_to(static_cast<PumpId>(i), PumpState::IDLE);
-                if (state_manager.debug_logging_enabled) {
-                    Serial.printf("[STATE] Pump %d cooling down complete - transition to IDLE\n", i);
-                }
-            }
-        }
-        
-        // Pump dosing timeout safety (10 minutes maximum)
-        if (state_manager.pump_states[i] == PumpState::DOSING) {
-            if (pump_get_state_duration_ms(static_cast<PumpId>(i)) > 600000) { // 10 minutes
-                pump_transition_to(static_cast<PumpId>(i), PumpState::ERROR);
-                Serial.printf("[STATE ERROR] Pump %d dosing timeout - forced to ERROR state\n", i);
-            }
+        if (due & (1u << (TIMER_PUMP_0 + i))) {
+            pump_state_expired(static_cast<PumpId>(i), state_manager.pump_states[i]);
         }
     }
-    
-    // Automatic sensor state machine management
-    SensorState sensor_current_state = state_manager.sensor_state;
-    uint32_t sensor_state_duration = sensor_get_state_duration_ms();
-    
-    // Handle sensor error recovery
-    if (sensor_current_state == SensorState::ERROR) {
-        // Auto-recover from sensor error after 10 seconds
-        if (sensor_state_duration > 10000) {
-            sensor_transition_to(SensorState::READY);
-        }
+    if (due & (1u << TIMER_SENSOR)) {
+        sensor_state_expired();
     }
     
-    // Handle sensor timeout in WARMING_UP state
-    if (sensor_current_state == SensorState::WARMING_UP && sensor_state_duration > 5000) {
-        // Force transition if warming up takes too long (safety: max 5 seconds)
-        sensor_transition_to(SensorState::ERROR);
-        Serial.println("[SENSOR SAFETY] Warmup timeout - forced to ERROR");
-    }
-    
-    // Call pump safety check to monitor timeouts and enforce limits
-    pump_safety_check();
-    
     // Debug status printing
     if (state_manager.debug_logging_enabled) {
         static uint32_t last_status_print = 0;
@@ -437,4 +483,4 @@ void state_machine_update(void) {
             last_status_print = now;
         }
     }
-}
\ No newline at end of file
+}
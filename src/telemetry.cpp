@@ -0,0 +1,465 @@
+/**
+ * @file telemetry.cpp
+ * @brief Binary telemetry frame codec and publisher
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "telemetry.h"
+#include "block_pool.h"
+#include <WiFi.h>
+#include <lwip/sockets.h>
+
+static_assert(sizeof(WiFiClient) <= POOL_CONNECTION_BLOCK, "telemetry client does not fit a connection block");
+
+//=============================================================================
+// CODEC
+//=============================================================================
+
+static size_t put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+    return 4;
+}
+
+static size_t put_i16(uint8_t* p, int16_t v) {
+    p[0] = (uint8_t)((uint16_t)v);
+    p[1] = (uint8_t)((uint16_t)v >> 8);
+    return 2;
+}
+
+static uint32_t get_u32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static int16_t get_i16(const uint8_t* p) {
+    return (int16_t)(uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief CRC-16/CCITT-FALSE (poly 0x1021), chainable through crc
+ */
+uint16_t telemetry_crc16(const uint8_t* data, size_t len, uint16_t crc) {
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief Fixed-point value of a reading, rounded and saturated to int16
+ */
+int16_t telemetry_scale(float value, float scale) {
+    float scaled = value * scale;
+    if (!(scaled > -32768.0f)) return scaled != scaled ? 0 : -32768;   // NaN -> 0
+    if (scaled > 32767.0f) return 32767;
+    return (int16_t)lroundf(scaled);
+}
+
+/**
+ * @brief Encode one event as a frame
+ * @return Frame length, 0 if out_len is too small
+ */
+size_t telemetry_encode(const telemetry_event_t& event, uint8_t* out, size_t out_len) {
+    uint8_t payload[8 + ALARM_NAME_LEN];
+    size_t plen = 0;
+
+    switch (event.type) {
+        case TelemetryType::READING:
+            plen += put_i16(payload + plen, telemetry_scale(event.reading.ph, TELEMETRY_PH_SCALE));
+            plen += put_i16(payload + plen, telemetry_scale(event.reading.ec, TELEMETRY_EC_SCALE));
+            plen += put_i16(payload + plen, telemetry_scale(event.reading.volume, TELEMETRY_VOLUME_SCALE));
+            plen += put_i16(payload + plen, telemetry_scale(event.reading.temperature, TELEMETRY_TEMP_SCALE));
+            break;
+        case TelemetryType::PUMP:
+            payload[plen++] = event.pump;
+            payload[plen++] = event.from_state;
+            payload[plen++] = event.to_state;
+            break;
+        case TelemetryType::ALARM: {
+            payload[plen++] = event.severity;
+            payload[plen++] = event.raised ? 1 : 0;
+            memcpy(payload + plen, &event.value, 4);
+            plen += 4;
+            size_t name_len = strnlen(event.alarm_name, ALARM_NAME_LEN - 1);
+            payload[plen++] = (uint8_t)name_len;
+            memcpy(payload + plen, event.alarm_name, name_len);
+            plen += name_len;
+            break;
+        }
+        default:
+            return 0;
+    }
+
+    size_t total = TELEMETRY_HEADER_LEN + plen + 2;
+    if (out_len < total) return 0;
+    size_t n = 0;
+    out[n++] = TELEMETRY_SYNC;
+    out[n++] = static_cast<uint8_t>(event.type);
+    out[n++] = (uint8_t)plen;
+    n += put_u32(out + n, event.seq);
+    n += put_u32(out + n, event.timestamp);
+    memcpy(out + n, payload, plen);
+    n += plen;
+    uint16_t crc = telemetry_crc16(out + 1, n - 1);
+    out[n++] = (uint8_t)crc;
+    out[n++] = (uint8_t)(crc >> 8);
+    return n;
+}
+
+/**
+ * @brief Decode the frame at the start of data
+ * @param consumed Bytes to drop: the frame, or 1 to resync after garbage
+ * @return 1 frame decoded, 0 incomplete (read more), -1 not a valid frame here
+ */
+int telemetry_decode(const uint8_t* data, size_t len, telemetry_event_t* event, size_t* consumed) {
+    *consumed = 0;
+    if (len == 0) return 0;
+    if (data[0] != TELEMETRY_SYNC) {
+        *consumed = 1;
+        return -1;
+    }
+    if (len < 3) return 0;
+
+    TelemetryType type = static_cast<TelemetryType>(data[1]);
+    size_t plen = data[2];
+    bool plausible = (type == TelemetryType::READING && plen == 8) ||
+                     (type == TelemetryType::PUMP && plen == 3) ||
+                     (type == TelemetryType::ALARM && plen >= 7 && plen <= 7 + ALARM_NAME_LEN - 1);
+    if (!plausible) {
+        *consumed = 1;
+        return -1;
+    }
+    size_t total = TELEMETRY_HEADER_LEN + plen + 2;
+    if (len < total) return 0;
+    uint16_t crc = telemetry_crc16(data + 1, total - 3);
+    if ((uint16_t)(data[total - 2] | (data[total - 1] << 8)) != crc) {
+        *consumed = 1;
+        return -1;
+    }
+
+    const uint8_t* p = data + TELEMETRY_HEADER_LEN;
+    *event = telemetry_event_t();
+    event->type = type;
+    event->seq = get_u32(data + 3);
+    event->timestamp = get_u32(data + 7);
+    switch (type) {
+        case TelemetryType::READING:
+            event->reading.ph = get_i16(p) / TELEMETRY_PH_SCALE;
+            event->reading.ec = get_i16(p + 2) / TELEMETRY_EC_SCALE;
+            event->reading.volume = get_i16(p + 4) / TELEMETRY_VOLUME_SCALE;
+            event->reading.temperature = get_i16(p + 6) / TELEMETRY_TEMP_SCALE;
+            event->reading.timestamp = event->timestamp;
+            event->reading.valid = true;
+            break;
+        case TelemetryType::PUMP:
+            event->pump = p[0];
+            event->from_state = p[1];
+            event->to_state = p[2];
+            break;
+        case TelemetryType::ALARM: {
+            event->severity = p[0];
+            event->raised = p[1] != 0;
+            memcpy(&event->value, p + 2, 4);
+            size_t name_len = p[6];
+            if (name_len != plen - 7) {
+                *consumed = 1;
+                return -1;
+            }
+            memcpy(event->alarm_name, p + 7, name_len);
+            event->alarm_name[name_len] = '\0';
+            break;
+        }
+    }
+    *consumed = total;
+    return 1;
+}
+
+//=============================================================================
+// PUBLISHER
+//=============================================================================
+
+static uint32_t telemetry_seq = 0;
+static telemetry_sink_t telemetry_sinks[TELEMETRY_MAX_SINKS];
+static uint8_t telemetry_sink_count = 0;
+static WiFiServer* telemetry_server = nullptr;
+static WiFiClient* telemetry_clients[TELEMETRY_MAX_CLIENTS];
+static char telemetry_requests[TELEMETRY_MAX_CLIENTS][TELEMETRY_REQUEST_MAX];
+static uint8_t telemetry_request_len[TELEMETRY_MAX_CLIENTS];
+
+// Rest of a frame the socket took only part of (goes out before anything else)
+static uint8_t telemetry_tail[TELEMETRY_MAX_CLIENTS][TELEMETRY_FRAME_MAX];
+static uint8_t telemetry_tail_len[TELEMETRY_MAX_CLIENTS];
+
+// Backfill range still to send per client (from == end: none)
+static uint32_t telemetry_backfill_from[TELEMETRY_MAX_CLIENTS];
+static uint32_t telemetry_backfill_end[TELEMETRY_MAX_CLIENTS];
+
+// Recent frames by seq % TELEMETRY_HISTORY_FRAMES (len 0 = never written)
+static uint8_t telemetry_history[TELEMETRY_HISTORY_FRAMES][TELEMETRY_FRAME_MAX];
+static uint8_t telemetry_history_len[TELEMETRY_HISTORY_FRAMES];
+
+/**
+ * @brief Write without blocking: WiFiClient::write() retries a full socket
+ * for up to a second, stalling the main loop
+ * @return Bytes the socket took (0 = full, try later), -1 = closed
+ */
+int telemetry_client_send(WiFiClient* client, const uint8_t* data, size_t len) {
+    if (!client->connected() || client->fd() < 0) return -1;
+    int n = send(client->fd(), data, len, MSG_DONTWAIT);
+    if (n >= 0) return n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+}
+
+// Finish a partly written frame; true once nothing is left of it
+static bool flush_tail(int index) {
+    uint8_t& tail_len = telemetry_tail_len[index];
+    if (tail_len == 0) return true;
+    int n = telemetry_client_send(telemetry_clients[index], telemetry_tail[index], tail_len);
+    if (n <= 0) return false;
+    tail_len = (uint8_t)(tail_len - n);
+    memmove(telemetry_tail[index], telemetry_tail[index] + n, tail_len);
+    return tail_len == 0;
+}
+
+/**
+ * @brief Offer one whole frame to a stream client
+ * @return true if the socket took it (any rest waits in the tail); a frame
+ *         refused here is skipped, and the receiver sees the seq gap
+ */
+static bool stream_frame(int index, const uint8_t* frame, size_t len) {
+    if (!flush_tail(index)) return false;
+    int n = telemetry_client_send(telemetry_clients[index], frame, len);
+    if (n <= 0) return false;
+    telemetry_tail_len[index] = (uint8_t)(len - (size_t)n);
+    memcpy(telemetry_tail[index], frame + n, telemetry_tail_len[index]);
+    return true;
+}
+
+/**
+ * @brief Encode an event once, into its history slot, and hand the frame to
+ * stream clients and sinks
+ */
+static void publish(telemetry_event_t& event) {
+    event.seq = telemetry_seq;
+    uint8_t* frame = telemetry_history[event.seq % TELEMETRY_HISTORY_FRAMES];
+    size_t len = telemetry_encode(event, frame, TELEMETRY_FRAME_MAX);
+    if (len == 0) return;
+    telemetry_history_len[event.seq % TELEMETRY_HISTORY_FRAMES] = (uint8_t)len;
+    telemetry_seq++;
+
+    for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+        if (telemetry_clients[i] && telemetry_clients[i]->connected()) {
+            stream_frame(i, frame, len);
+        }
+    }
+    for (int i = 0; i < telemetry_sink_count; i++) {
+        telemetry_sinks[i](event, frame, len);
+    }
+}
+
+static void alarm_to_telemetry(const alarm_event_t& alarm) {
+    telemetry_event_t event = telemetry_event_t();
+    event.type = TelemetryType::ALARM;
+    event.timestamp = alarm.timestamp;
+    strncpy(event.alarm_name, alarm.name ? alarm.name : "", ALARM_NAME_LEN - 1);
+    event.alarm_name[ALARM_NAME_LEN - 1] = '\0';
+    event.severity = static_cast<uint8_t>(alarm.severity);
+    event.raised = alarm.raised;
+    event.value = alarm.value;
+    publish(event);
+}
+
+/**
+ * @brief Read backfill request lines from a stream client
+ */
+static void serve_requests(int index) {
+    WiFiClient* client = telemetry_clients[index];
+    char* line = telemetry_requests[index];
+    uint8_t& len = telemetry_request_len[index];
+    while (client->available()) {
+        int c = client->read();
+        if (c < 0) break;
+        if (c != '\n') {
+            if (len < TELEMETRY_REQUEST_MAX) line[len++] = (char)c;
+            continue;
+        }
+        uint32_t from, count;
+        bool valid = len < TELEMETRY_REQUEST_MAX && telemetry_parse_backfill(line, len, &from, &count);
+        len = 0;
+        if (!valid) continue;
+        telemetry_backfill_from[index] = from;
+        telemetry_backfill_end[index] = from + count;
+    }
+}
+
+/**
+ * @brief Send the requested backfill frame by frame, as far as the socket takes it
+ */
+static void serve_backfill(int index) {
+    uint32_t& from = telemetry_backfill_from[index];
+    uint32_t end = telemetry_backfill_end[index];
+    while (from != end) {
+        uint8_t frame[TELEMETRY_FRAME_MAX];
+        uint32_t next;
+        size_t n = telemetry_backfill(from, end - from, frame, sizeof(frame), &next);
+        if (n == 0) {
+            from = end;                                  // Nothing left that is still held
+            break;
+        }
+        if (!stream_frame(index, frame, n)) break;
+        from = next;
+    }
+}
+
+/**
+ * @brief Start publishing alarms (readings and pump transitions are pushed by their owners)
+ */
+void telemetry_init(void) {
+    alarm_add_sink(alarm_to_telemetry);
+}
+
+/**
+ * @brief Start the stream server once WiFi is up; accept and retire clients
+ */
+void telemetry_update(void) {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    if (!telemetry_server) {
+        telemetry_server = pool_new<WiFiServer>(PoolId::CONNECTION, TELEMETRY_PORT);
+        if (!telemetry_server) return;                   // Pool exhausted; retried next pass
+        telemetry_server->begin();
+    }
+
+    for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+        if (telemetry_clients[i] && !telemetry_clients[i]->connected()) {
+            telemetry_clients[i]->stop();
+            pool_delete(PoolId::CONNECTION, telemetry_clients[i]);
+            telemetry_clients[i] = nullptr;
+        }
+        if (telemetry_clients[i]) {
+            serve_requests(i);
+            serve_backfill(i);
+        }
+    }
+
+    WiFiClient incoming = telemetry_server->accept();
+    if (!incoming) return;
+    for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+        if (!telemetry_clients[i]) {
+            telemetry_clients[i] = pool_new<WiFiClient>(PoolId::CONNECTION, incoming);
+            telemetry_request_len[i] = 0;
+            telemetry_tail_len[i] = 0;
+            telemetry_backfill_from[i] = telemetry_backfill_end[i] = 0;
+            if (telemetry_clients[i]) {
+                telemetry_clients[i]->setNoDelay(true);
+                return;
+            }
+            break;
+        }
+    }
+    incoming.stop();                                     // Full (or pool exhausted)
+}
+
+void telemetry_publish_reading(const sensor_readings_t& readings) {
+    telemetry_event_t event = telemetry_event_t();
+    event.type = TelemetryType::READING;
+    event.timestamp = readings.timestamp;
+    event.reading = readings;
+    publish(event);
+}
+
+void telemetry_publish_pump(uint8_t pump, uint8_t from_state, uint8_t to_state) {
+    telemetry_event_t event = telemetry_event_t();
+    event.type = TelemetryType::PUMP;
+    event.timestamp = millis();
+    event.pump = pump;
+    event.from_state = from_state;
+    event.to_state = to_state;
+    publish(event);
+}
+
+/**
+ * @brief Register an additional sink for encoded frames
+ * @return false if all sink slots are taken
+ */
+bool telemetry_add_sink(telemetry_sink_t sink) {
+    if (sink == nullptr || telemetry_sink_count >= TELEMETRY_MAX_SINKS) {
+        return false;
+    }
+    for (int i = 0; i < telemetry_sink_count; i++) {
+        if (telemetry_sinks[i] == sink) return true;
+    }
+    telemetry_sinks[telemetry_sink_count++] = sink;
+    return true;
+}
+
+uint32_t telemetry_get_seq(void) {
+    return telemetry_seq;
+}
+
+uint8_t telemetry_get_client_count(void) {
+    uint8_t count = 0;
+    for (int i = 0; i < TELEMETRY_MAX_CLIENTS; i++) {
+        if (telemetry_clients[i] && telemetry_clients[i]->connected()) count++;
+    }
+    return count;
+}
+
+//=============================================================================
+// BACKFILL
+//=============================================================================
+
+/**
+ * @brief Parse a backfill request line "B <from> <count>" (decimal)
+ */
+bool telemetry_parse_backfill(const char* line, size_t len, uint32_t* from, uint32_t* count) {
+    while (len > 0 && (line[len - 1] == '\r' || line[len - 1] == ' ')) len--;
+    if (len < 5 || line[0] != 'B' || line[1] != ' ') return false;
+    uint64_t values[2] = {0, 0};
+    size_t pos = 2;
+    for (int v = 0; v < 2; v++) {
+        size_t start = pos;
+        while (pos < len && line[pos] >= '0' && line[pos] <= '9' && pos - start < 10) {
+            values[v] = values[v] * 10 + (uint64_t)(line[pos] - '0');
+            pos++;
+        }
+        if (pos == start || values[v] > 0xFFFFFFFFull) return false;
+        if (v == 0) {
+            if (pos >= len || line[pos] != ' ') return false;
+            pos++;
+        }
+    }
+    if (pos != len || values[1] == 0) return false;
+    *from = (uint32_t)values[0];
+    *count = values[1] > (uint64_t)TELEMETRY_HISTORY_FRAMES ? (uint32_t)TELEMETRY_HISTORY_FRAMES : (uint32_t)values[1];
+    return true;
+}
+
+uint32_t telemetry_get_oldest_seq(void) {
+    return telemetry_seq > (uint32_t)TELEMETRY_HISTORY_FRAMES ? telemetry_seq - TELEMETRY_HISTORY_FRAMES : 0;
+}
+
+/**
+ * @brief Copy held frames of [from, from + count) into out, oldest first
+ * Frames already overwritten are skipped; stops at the first frame that
+ * does not fit.
+ * @param next First sequence number not copied (continue from here)
+ * @return Bytes written (whole frames)
+ */
+size_t telemetry_backfill(uint32_t from, uint32_t count, uint8_t* out, size_t out_len, uint32_t* next) {
+    uint32_t oldest = telemetry_get_oldest_seq();
+    uint32_t end = (uint64_t)from + count > telemetry_seq ? telemetry_seq : from + count;
+    uint32_t seq = from < oldest ? oldest : from;
+    size_t n = 0;
+    for (; seq < end; seq++) {
+        size_t len = telemetry_history_len[seq % TELEMETRY_HISTORY_FRAMES];
+        if (n + len > out_len) break;
+        memcpy(out + n, telemetry_history[seq % TELEMETRY_HISTORY_FRAMES], len);
+        n += len;
+    }
+    *next = seq < end ? seq : from + count;
+    return n;
+}
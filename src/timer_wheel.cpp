@@ -0,0 +1,166 @@
+/**
+ * @file timer_wheel.cpp
+ * @brief Hashed timer wheel implementation
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "timer_wheel.h"
+
+#include <string.h>
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Tick in which a deadline becomes due (first millisecond past it)
+ */
+static inline uint32_t due_tick(uint32_t deadline) {
+    return (deadline + 1) >> TIMER_WHEEL_TICK_SHIFT;
+}
+
+/**
+ * @brief Signed distance from tick a to tick b
+ *
+ * Ticks are millis() >> TIMER_WHEEL_TICK_SHIFT and so wrap at 2^28, not
+ * 2^32; shifting the difference back up sign-extends it across the wrap.
+ */
+static inline int32_t tick_diff(uint32_t b, uint32_t a) {
+    return (int32_t)((b - a) << TIMER_WHEEL_TICK_SHIFT) >> TIMER_WHEEL_TICK_SHIFT;
+}
+
+/**
+ * @brief Unlink an armed timer from its slot list
+ */
+static void unlink_timer(timer_wheel_t* wheel, uint8_t id) {
+    uint8_t slot = wheel->slot[id];
+    if (wheel->prev[id] != TIMER_WHEEL_NONE) {
+        wheel->next[wheel->prev[id]] = wheel->next[id];
+    } else {
+        wheel->head[slot] = wheel->next[id];
+    }
+    if (wheel->next[id] != TIMER_WHEEL_NONE) {
+        wheel->prev[wheel->next[id]] = wheel->prev[id];
+    }
+    wheel->slot[id] = TIMER_WHEEL_NONE;
+}
+
+/**
+ * @brief Check one slot and disarm its due timers
+ * @return Bitmask of timers that came due
+ */
+static uint32_t expire_slot(timer_wheel_t* wheel, uint32_t slot, uint32_t now) {
+    uint32_t due = 0;
+    uint8_t id = wheel->head[slot];
+    while (id != TIMER_WHEEL_NONE) {
+        uint8_t next = wheel->next[id];
+        if ((int32_t)(now - wheel->deadline[id]) > 0) {
+            unlink_timer(wheel, id);
+            due |= 1u << id;
+        }
+        id = next;
+    }
+    return due;
+}
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+/**
+ * @brief Empty the wheel
+ * @param now Current time (ms)
+ */
+void timer_wheel_init(timer_wheel_t* wheel, uint32_t now) {
+    memset(wheel->head, TIMER_WHEEL_NONE, sizeof(wheel->head));
+    memset(wheel->next, TIMER_WHEEL_NONE, sizeof(wheel->next));
+    memset(wheel->prev, TIMER_WHEEL_NONE, sizeof(wheel->prev));
+    memset(wheel->slot, TIMER_WHEEL_NONE, sizeof(wheel->slot));
+    memset(wheel->deadline, 0, sizeof(wheel->deadline));
+    wheel->tick = now >> TIMER_WHEEL_TICK_SHIFT;
+}
+
+/**
+ * @brief Arm (or re-arm) a timer
+ * @param id Timer id (< TIMER_WHEEL_MAX_TIMERS)
+ * @param deadline Time (ms) the timer must be strictly past to come due
+ */
+void timer_wheel_arm(timer_wheel_t* wheel, uint8_t id, uint32_t deadline) {
+    if (id >= TIMER_WHEEL_MAX_TIMERS) return;
+    if (wheel->slot[id] != TIMER_WHEEL_NONE) {
+        unlink_timer(wheel, id);
+    }
+
+    // Already due: queue it in the slot the next advance checks first
+    uint32_t tick = due_tick(deadline);
+    if (tick_diff(tick, wheel->tick) < 0) {
+        tick = wheel->tick;
+    }
+    uint8_t slot = tick & (TIMER_WHEEL_SLOTS - 1);
+
+    wheel->deadline[id] = deadline;
+    wheel->slot[id] = slot;
+    wheel->prev[id] = TIMER_WHEEL_NONE;
+    wheel->next[id] = wheel->head[slot];
+    if (wheel->head[slot] != TIMER_WHEEL_NONE) {
+        wheel->prev[wheel->head[slot]] = id;
+    }
+    wheel->head[slot] = id;
+}
+
+/**
+ * @brief Disarm a timer (no effect if not armed)
+ */
+void timer_wheel_cancel(timer_wheel_t* wheel, uint8_t id) {
+    if (id >= TIMER_WHEEL_MAX_TIMERS || wheel->slot[id] == TIMER_WHEEL_NONE) return;
+    unlink_timer(wheel, id);
+}
+
+/**
+ * @brief Check whether a timer is armed
+ */
+bool timer_wheel_is_armed(const timer_wheel_t* wheel, uint8_t id) {
+    return id < TIMER_WHEEL_MAX_TIMERS && wheel->slot[id] != TIMER_WHEEL_NONE;
+}
+
+/**
+ * @brief Time until an armed timer comes due
+ * @return ms, 0 if not armed or already due
+ */
+uint32_t timer_wheel_remaining_ms(const timer_wheel_t* wheel, uint8_t id, uint32_t now) {
+    if (!timer_wheel_is_armed(wheel, id)) return 0;
+    int32_t remaining = (int32_t)(wheel->deadline[id] - now);
+    return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+/**
+ * @brief Collect the timers due at `now`
+ *
+ * Visits the slots of every tick since the last advance, up to and
+ * including the current one, which stays pending so timers due later in
+ * the same tick are found next time.
+ * @param now Current time (ms)
+ * @return Bitmask of timers that came due (they are disarmed)
+ */
+uint32_t timer_wheel_advance(timer_wheel_t* wheel, uint32_t now) {
+    uint32_t target = now >> TIMER_WHEEL_TICK_SHIFT;
+    int32_t ticks = tick_diff(target, wheel->tick);
+    uint32_t due = 0;
+
+    if (ticks < 0) {
+        return 0;                                        // Clock behind the wheel
+    }
+    if (ticks >= TIMER_WHEEL_SLOTS) {
+        // Stalled for a revolution or more: every slot is behind
+        for (int slot = 0; slot < TIMER_WHEEL_SLOTS; slot++) {
+            due |= expire_slot(wheel, slot, now);
+        }
+    } else {
+        for (int32_t t = 0; t <= ticks; t++) {
+            due |= expire_slot(wheel, (wheel->tick + t) & (TIMER_WHEEL_SLOTS - 1), now);
+        }
+    }
+    wheel->tick = target;
+    return due;
+}
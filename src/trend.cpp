@@ -0,0 +1,95 @@
+/**
+ * @file trend.cpp
+ * @brief Exponentially weighted linear trend fit implementation
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "trend.h"
+
+#include <math.h>
+#include <string.h>
+
+//=============================================================================
+// PUBLIC FUNCTIONS
+//=============================================================================
+
+void trend_reset(trend_fit_t* fit) {
+    memset(fit, 0, sizeof(*fit));
+}
+
+/**
+ * @brief Add one point
+ * Shifts the origin to the new point (t -> t - dt), decays every sum, then
+ * adds the point at t = 0.
+ * @param dt Time since the previous point
+ * @param value New value
+ * @param tau Weighting time constant (same unit as dt)
+ */
+void trend_add(trend_fit_t* fit, double dt, float value, double tau) {
+    if (!fit->has_reference) {
+        fit->reference = value;
+        fit->has_reference = true;
+    }
+    double v = (double)value - fit->reference;
+    double decay = exp(-dt / tau);
+
+    fit->stt = (fit->stt - 2.0 * dt * fit->st + dt * dt * fit->sw) * decay;
+    fit->stv = (fit->stv - dt * fit->sv) * decay;
+    fit->st = (fit->st - dt * fit->sw) * decay;
+    fit->sw *= decay;
+    fit->sv *= decay;
+    fit->svv *= decay;
+
+    fit->sw += 1.0;
+    fit->sv += v;
+    fit->svv += v * v;
+}
+
+/**
+ * @brief Solve the weighted fit
+ * @return false while all points share one time (no slope yet)
+ */
+bool trend_estimate(const trend_fit_t* fit, trend_estimate_t* out) {
+    if (fit->sw <= 0.0) return false;
+
+    double mean_t = fit->st / fit->sw;
+    double mean_v = fit->sv / fit->sw;
+    double sxx = fit->stt - fit->st * mean_t;      // Weighted sum of (t - mean_t)^2
+    double sxy = fit->stv - fit->st * mean_v;
+    double syy = fit->svv - fit->sv * mean_v;
+    if (sxx <= 1e-12) return false;
+
+    double slope = sxy / sxx;
+    double residual = syy - slope * sxy;
+    // Weighted residual variance; -2 for the fitted level and slope
+    double variance = fit->sw > 2.0 ? (residual > 0.0 ? residual : 0.0) / (fit->sw - 2.0) : 0.0;
+
+    out->slope = (float)slope;
+    out->level = (float)(mean_v + slope * (0.0 - mean_t) + fit->reference);
+    out->slope_sigma = (float)sqrt(variance / sxx);
+    out->residual_sigma = (float)sqrt(variance);
+    out->weight = (float)fit->sw;
+    return true;
+}
+
+/**
+ * @brief Predict the value 'ahead' after the newest point
+ * @param sigma Standard deviation of the predicted mean (level and slope error)
+ * @return Predicted value (the newest value's level when no slope is available)
+ */
+float trend_predict(const trend_fit_t* fit, double ahead, float* sigma) {
+    trend_estimate_t e;
+    if (!trend_estimate(fit, &e)) {
+        if (sigma) *sigma = 0.0f;
+        return fit->has_reference ? fit->reference + (float)(fit->sw > 0.0 ? fit->sv / fit->sw : 0.0) : 0.0f;
+    }
+    double mean_t = fit->st / fit->sw;
+    double lever = ahead - mean_t;                 // Distance from the fit's centre of mass
+    if (sigma) {
+        double variance = (double)e.residual_sigma * e.residual_sigma / fit->sw +
+                          (double)e.slope_sigma * e.slope_sigma * lever * lever;
+        *sigma = (float)sqrt(variance);
+    }
+    return e.level + e.slope * (float)ahead;
+}
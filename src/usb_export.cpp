@@ -0,0 +1,338 @@
+/**
+ * @file usb_export.cpp
+ * @brief Bulk export session, frame codec and USB port glue
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "usb_export.h"
+#include "telemetry.h"
+#include "binlog.h"
+#include "crash_log.h"
+#include "communication.h"
+
+// The native USB Serial/JTAG port when the console stays on the UART bridge
+// (the board default). With USB CDC on boot the only port is the console's,
+// where direct Serial prints would land inside frames: exports are refused
+#if defined(ARDUINO_USB_MODE) && ARDUINO_USB_MODE && !ARDUINO_USB_CDC_ON_BOOT
+#define USB_EXPORT_NATIVE 1
+#define USB_EXPORT_PORT USBSerial
+#else
+#define USB_EXPORT_NATIVE 0
+#define USB_EXPORT_PORT Serial
+#endif
+
+static_assert(TELEMETRY_FRAME_MAX <= USB_EXPORT_PAYLOAD_MAX, "telemetry frame does not fit an export frame");
+static_assert(BINLOG_HISTORY_ENTRY_HEADER + 255 <= USB_EXPORT_PAYLOAD_MAX, "log entry does not fit an export frame");
+
+//=============================================================================
+// STATE
+//=============================================================================
+
+static usb_export_t session;
+static bool active = false;
+static uint32_t last_progress = 0;               // millis() of the last byte taken
+static usb_export_stats_t stats;
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+static size_t put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return 2;
+}
+
+static size_t put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+    return 4;
+}
+
+static uint16_t get_u16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Header and CRC around a payload already in session->frame
+ */
+static void seal_frame(usb_export_t* session, UsbExportFrame type, size_t payload_len) {
+    uint8_t* f = session->frame;
+    f[0] = USB_EXPORT_SYNC;
+    f[1] = (uint8_t)type;
+    put_u16(f + 2, session->seq++);
+    put_u16(f + 4, (uint16_t)payload_len);
+    uint16_t crc = telemetry_crc16(f + 1, 5);
+    crc = telemetry_crc16(f + USB_EXPORT_HEADER_LEN, payload_len, crc);
+    put_u16(f + USB_EXPORT_HEADER_LEN + payload_len, crc);
+    session->frame_len = (uint16_t)(USB_EXPORT_HEADER_LEN + payload_len + 2);
+    session->frame_sent = 0;
+    session->frames++;
+    session->bytes += session->frame_len;
+}
+
+/**
+ * @brief Encode the next frame of the current section into session->frame
+ * An empty section moves on to the next one.
+ * @return false when the export is complete (END already sent)
+ */
+static bool next_frame(usb_export_t* session, uint32_t now_us) {
+    uint8_t* payload = session->frame + USB_EXPORT_HEADER_LEN;
+    for (;;) {
+        switch ((UsbExportFrame)session->section) {
+            case UsbExportFrame::BEGIN: {
+                size_t n = 0;
+                payload[n++] = USB_EXPORT_VERSION;
+                n += put_u32(payload + n, crash_log_get_boot());
+                n += put_u32(payload + n, millis());
+                n += put_u32(payload + n, session->telemetry_next);
+                n += put_u32(payload + n, session->telemetry_end);
+                n += put_u32(payload + n, session->log_end - session->log_cursor);
+                payload[n++] = (uint8_t)crash_log_count();
+                seal_frame(session, UsbExportFrame::BEGIN, n);
+                session->section = (uint8_t)UsbExportFrame::TELEMETRY;
+                return true;
+            }
+            case UsbExportFrame::TELEMETRY: {
+                uint32_t oldest = telemetry_get_oldest_seq();
+                if ((int32_t)(oldest - session->telemetry_next) > 0) {
+                    uint32_t end = (int32_t)(oldest - session->telemetry_end) > 0 ? session->telemetry_end : oldest;
+                    session->telemetry_lost += end - session->telemetry_next;
+                    session->telemetry_next = end;
+                }
+                size_t n = 0;
+                if (session->telemetry_next != session->telemetry_end) {
+                    n = telemetry_backfill(session->telemetry_next, session->telemetry_end - session->telemetry_next,
+                                           payload, USB_EXPORT_PAYLOAD_MAX, &session->telemetry_next);
+                }
+                if (n > 0) {
+                    seal_frame(session, UsbExportFrame::TELEMETRY, n);
+                    return true;
+                }
+                session->section = (uint8_t)UsbExportFrame::LOG;
+                break;
+            }
+            case UsbExportFrame::LOG: {
+                uint32_t oldest = binlog_history_oldest();
+                if ((int32_t)(oldest - session->log_cursor) > 0) {
+                    uint32_t end = (int32_t)(oldest - session->log_end) > 0 ? session->log_end : oldest;
+                    session->log_lost += end - session->log_cursor;
+                    session->log_cursor = end;
+                }
+                size_t n = binlog_history_read(&session->log_cursor, session->log_end, payload, USB_EXPORT_PAYLOAD_MAX);
+                if (n > 0) {
+                    seal_frame(session, UsbExportFrame::LOG, n);
+                    return true;
+                }
+                session->section = (uint8_t)UsbExportFrame::CRASH;
+                break;
+            }
+            case UsbExportFrame::CRASH: {
+                size_t n = 0;
+                crash_record_t record;
+                while (n + USB_EXPORT_CRASH_RECORD_LEN <= USB_EXPORT_PAYLOAD_MAX &&
+                       crash_log_get(session->crash_next, &record)) {
+                    n += put_u32(payload + n, record.boot);
+                    n += put_u32(payload + n, record.uptime_ms);
+                    payload[n++] = record.reason;
+                    payload[n++] = record.system_state;
+                    session->crash_next++;
+                }
+                if (n > 0) {
+                    seal_frame(session, UsbExportFrame::CRASH, n);
+                    return true;
+                }
+                session->section = (uint8_t)UsbExportFrame::END;
+                break;
+            }
+            case UsbExportFrame::END: {
+                size_t n = 0;
+                n += put_u32(payload + n, session->frames);
+                n += put_u32(payload + n, session->bytes);
+                n += put_u32(payload + n, now_us - session->started_us);
+                n += put_u32(payload + n, session->telemetry_lost);
+                n += put_u32(payload + n, session->log_lost);
+                seal_frame(session, UsbExportFrame::END, n);
+                session->section = 0;
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+}
+
+/**
+ * @brief Port writer: only what the transmit buffer takes now
+ */
+static int port_write(void* ctx, const uint8_t* data, size_t len) {
+    (void)ctx;
+    int space = USB_EXPORT_PORT.availableForWrite();
+    if (space <= 0) return 0;
+    size_t n = len < (size_t)space ? len : (size_t)space;
+    return (int)USB_EXPORT_PORT.write(data, n);
+}
+
+static void finish(bool completed) {
+    active = false;
+    if (completed) {
+        stats.exports++;
+        stats.last_bytes = session.bytes;
+        stats.last_elapsed_us = micros() - session.started_us;
+    } else {
+        stats.aborted++;
+    }
+    if (completed) {
+        Debug->printf("USB export: %lu frames, %lu bytes in %lu ms", (unsigned long)session.frames,
+                      (unsigned long)session.bytes, (unsigned long)(stats.last_elapsed_us / 1000));
+    } else {
+        Debug->printf("USB export aborted after %lu bytes (host stopped reading)", (unsigned long)session.bytes);
+    }
+}
+
+//=============================================================================
+// CODEC
+//=============================================================================
+
+/**
+ * @brief Encode one frame
+ * @return Frame length, 0 if the payload is too long or out_len too small
+ */
+size_t usb_export_encode_frame(uint8_t type, uint16_t seq, const uint8_t* payload, size_t len, uint8_t* out,
+                               size_t out_len) {
+    if (len > USB_EXPORT_PAYLOAD_MAX || out_len < USB_EXPORT_HEADER_LEN + len + 2) return 0;
+    out[0] = USB_EXPORT_SYNC;
+    out[1] = type;
+    put_u16(out + 2, seq);
+    put_u16(out + 4, (uint16_t)len);
+    memcpy(out + USB_EXPORT_HEADER_LEN, payload, len);
+    put_u16(out + USB_EXPORT_HEADER_LEN + len, telemetry_crc16(out + 1, USB_EXPORT_HEADER_LEN - 1 + len));
+    return USB_EXPORT_HEADER_LEN + len + 2;
+}
+
+/**
+ * @brief Decode the frame at the start of data
+ * @return Bytes used, 0 if more data is needed, -1 if data does not start
+ *         with a valid frame (skip a byte and try again)
+ */
+int usb_export_decode_frame(const uint8_t* data, size_t len, usb_export_frame_t* frame) {
+    if (len == 0) return 0;
+    if (data[0] != USB_EXPORT_SYNC) return -1;
+    if (len < USB_EXPORT_HEADER_LEN) return 0;
+    size_t payload_len = get_u16(data + 4);
+    if (payload_len > USB_EXPORT_PAYLOAD_MAX) return -1;
+    size_t total = USB_EXPORT_HEADER_LEN + payload_len + 2;
+    if (len < total) return 0;
+    if (telemetry_crc16(data + 1, USB_EXPORT_HEADER_LEN - 1 + payload_len) !=
+        get_u16(data + USB_EXPORT_HEADER_LEN + payload_len)) {
+        return -1;
+    }
+    frame->type = data[1];
+    frame->seq = get_u16(data + 2);
+    frame->len = (uint16_t)payload_len;
+    frame->payload = data + USB_EXPORT_HEADER_LEN;
+    return (int)total;
+}
+
+//=============================================================================
+// SESSION
+//=============================================================================
+
+void usb_export_begin(usb_export_t* session, uint32_t now_us) {
+    memset(session, 0, sizeof(*session));
+    session->section = (uint8_t)UsbExportFrame::BEGIN;
+    session->started_us = now_us;
+    session->telemetry_next = telemetry_get_oldest_seq();
+    session->telemetry_end = telemetry_get_seq();
+    session->log_cursor = binlog_history_oldest();
+    session->log_end = binlog_history_end();
+}
+
+/**
+ * @brief Write frames until the port is busy, budget bytes went out or the export is complete
+ * @return Bytes written, -1 if the port reported closed
+ */
+int usb_export_pump(usb_export_t* session, usb_export_write_t write, void* ctx, size_t budget, uint32_t now_us) {
+    size_t written = 0;
+    while (written < budget) {
+        if (session->frame_sent == session->frame_len && !next_frame(session, now_us)) break;
+        size_t chunk = session->frame_len - session->frame_sent;
+        if (chunk > budget - written) chunk = budget - written;
+        int n = write(ctx, session->frame + session->frame_sent, chunk);
+        if (n < 0) {
+            session->section = 0;
+            session->frame_sent = session->frame_len;
+            return -1;
+        }
+        if (n == 0) break;
+        session->frame_sent += (uint16_t)n;
+        written += (size_t)n;
+    }
+    return (int)written;
+}
+
+bool usb_export_finished(const usb_export_t* session) {
+    return session->section == 0 && session->frame_sent == session->frame_len;
+}
+
+//=============================================================================
+// FIRMWARE PORT
+//=============================================================================
+
+void usb_export_init(void) {
+#if USB_EXPORT_NATIVE
+    USB_EXPORT_PORT.setTxBufferSize(USB_EXPORT_TX_BUFFER);
+    USB_EXPORT_PORT.begin();
+#endif
+}
+
+bool usb_export_start(void) {
+    if (active) return false;
+    if (!USB_EXPORT_NATIVE) {
+        Debug->println("USB export needs the native USB port (this build has USB CDC on boot)");
+        return false;
+    }
+    usb_export_begin(&session, micros());
+    active = true;
+    last_progress = millis();
+    return true;
+}
+
+void usb_export_update(void) {
+#if USB_EXPORT_NATIVE
+    while (USB_EXPORT_PORT.available()) {
+        if (USB_EXPORT_PORT.read() == USB_EXPORT_TRIGGER && !active) {
+            usb_export_start();
+        }
+    }
+#endif
+    if (!active) return;
+
+    int n = usb_export_pump(&session, port_write, nullptr, USB_EXPORT_BYTES_PER_LOOP, micros());
+    if (n > 0) {
+        last_progress = millis();
+    }
+    if (usb_export_finished(&session)) {
+        finish(n >= 0);
+    } else if (millis() - last_progress > USB_EXPORT_STALL_MS) {
+        finish(false);
+    }
+}
+
+bool usb_export_is_active(void) {
+    return active;
+}
+
+usb_export_stats_t usb_export_get_stats(void) {
+    return stats;
+}
+
+void usb_export_print_status(void) {
+    Debug->printf("USB export: %s on %s | %lu done, %lu aborted | last %lu bytes in %lu ms",
+                  active ? "RUNNING" : "idle", USB_EXPORT_NATIVE ? "native USB" : "no port (USB CDC on boot)",
+                  (unsigned long)stats.exports, (unsigned long)stats.aborted, (unsigned long)stats.last_bytes,
+                  (unsigned long)(stats.last_elapsed_us / 1000));
+    Debug->printf("  Holds: %lu telemetry frames, %lu log bytes, %d crash record(s)",
+                  (unsigned long)(telemetry_get_seq() - telemetry_get_oldest_seq()),
+                  (unsigned long)(binlog_history_end() - binlog_history_oldest()), crash_log_count());
+}
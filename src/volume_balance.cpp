@@ -0,0 +1,261 @@
+/**
+ * @file volume_balance.cpp
+ * @brief Volume balance estimator and leak alarm implementation
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "volume_balance.h"
+#include "pump.h"
+#include "alarms.h"
+#include "communication.h"
+
+#include <string.h>
+
+//=============================================================================
+// PRIVATE HELPER FUNCTIONS
+//=============================================================================
+
+static constexpr uint32_t kHourMs = 60u * 60u * 1000u;
+
+static uint8_t hour_of_day(uint32_t now) {
+    return (uint8_t)((now / kHourMs) % VB_DIURNAL_BINS);
+}
+
+/**
+ * @brief Expected evaporation for the current hour
+ * Learned bin if available, else the mean of learned bins, else the default.
+ */
+static float diurnal_baseline(const volume_balance_t* vb, uint8_t hour) {
+    if (vb->diurnal_days[hour] > 0) {
+        return vb->diurnal[hour];
+    }
+    float sum = 0.0f;
+    int learned = 0;
+    for (int i = 0; i < VB_DIURNAL_BINS; i++) {
+        if (vb->diurnal_days[i] > 0) {
+            sum += vb->diurnal[i];
+            learned++;
+        }
+    }
+    return learned > 0 ? sum / learned : VB_DEFAULT_EVAP_L_PER_H;
+}
+
+/**
+ * @brief Fold the finished hour's mean loss rate into its diurnal bin
+ */
+static void diurnal_close_hour(volume_balance_t* vb) {
+    if (vb->hour_samples > 0) {
+        float mean = constrain(vb->hour_sum / vb->hour_samples, 0.0f, VB_BASELINE_MAX_L_PER_H);
+        uint8_t h = vb->current_hour;
+        vb->diurnal[h] = vb->diurnal_days[h] == 0 ? mean : vb->diurnal[h] + VB_BASELINE_ALPHA * (mean - vb->diurnal[h]);
+        if (vb->diurnal_days[h] < 255) vb->diurnal_days[h]++;
+    }
+    vb->hour_sum = 0.0f;
+    vb->hour_samples = 0;
+}
+
+//=============================================================================
+// ESTIMATOR CORE
+//=============================================================================
+
+/**
+ * @brief Clear all state including the learned diurnal profile
+ */
+void volume_balance_reset(volume_balance_t* vb) {
+    memset(vb, 0, sizeof(*vb));
+    vb->baseline = VB_DEFAULT_EVAP_L_PER_H;
+}
+
+/**
+ * @brief Process one filtered volume reading
+ * @param volume_l Filtered reservoir volume (L)
+ * @param inflow_ml Cumulative ml delivered by all pumps (any origin)
+ * @param now Reading timestamp (ms)
+ * @return VB_EVENT_* flags for this reading
+ */
+uint8_t volume_balance_step(volume_balance_t* vb, float volume_l, float inflow_ml, uint32_t now) {
+    uint8_t events = 0;
+
+    if (!vb->started) {
+        vb->started = true;
+        vb->start_time = now;
+        vb->last_time = now;
+        vb->last_volume = volume_l;
+        vb->last_inflow_ml = inflow_ml;
+        vb->current_hour = hour_of_day(now);
+        return 0;
+    }
+
+    float d_volume = volume_l - vb->last_volume;
+    float d_inflow_l = (inflow_ml - vb->last_inflow_ml) / 1000.0f;
+    double dt_h = (double)(now - vb->last_time) / kHourMs;
+    vb->last_time = now;
+    vb->last_volume = volume_l;
+    vb->last_inflow_ml = inflow_ml;
+
+    // The volume EMA starts from 0 at boot; skip until it has converged
+    if (now - vb->start_time < VB_WARMUP_MS) {
+        return 0;
+    }
+    vb->inflow_l += d_inflow_l;
+
+    // Rises no pump explains are operator top-ups: absorb them so net volume stays continuous
+    float residual = d_volume - d_inflow_l;
+    if (vb->in_topup) {
+        if (residual < VB_TOPUP_EXIT_L) {
+            vb->in_topup = false;
+            events |= VB_EVENT_TOPUP_END;
+        } else {
+            vb->current_topup_l += residual;
+            vb->topup_l += residual;
+        }
+    } else if (residual > VB_TOPUP_ENTER_L) {
+        vb->in_topup = true;
+        vb->current_topup_l = residual;
+        vb->topup_l += residual;
+        vb->topup_count++;
+        events |= VB_EVENT_TOPUP_START;
+    }
+
+    float net = volume_l - vb->inflow_l - vb->topup_l;
+    trend_add(&vb->trend, dt_h, net, VB_TREND_TAU_H);
+    trend_estimate_t fit;
+    if (trend_estimate(&vb->trend, &fit)) {
+        vb->loss_rate = -fit.slope;
+    }
+    vb->settled = (now - vb->start_time) >= (uint32_t)(VB_WARMUP_MS + 2.0f * VB_TREND_TAU_H * kHourMs);
+
+    // Diurnal baseline and excess loss
+    uint8_t hour = hour_of_day(now);
+    if (hour != vb->current_hour) {
+        diurnal_close_hour(vb);
+        vb->current_hour = hour;
+    }
+    vb->baseline = diurnal_baseline(vb, hour);
+    vb->excess = vb->loss_rate - vb->baseline;
+    if (!vb->settled) {
+        return events;
+    }
+
+    // Leak alarm with hysteresis and confirmation time
+    bool condition = vb->leak ? vb->excess > VB_LEAK_CLEAR_L_PER_H : vb->excess > VB_LEAK_RAISE_L_PER_H;
+    if (condition != vb->leak_condition) {
+        vb->leak_condition = condition;
+        vb->leak_condition_since = now;
+    }
+
+    // Learn evaporation only while nothing suspicious is going on
+    if (!vb->in_topup && !vb->leak && !condition) {
+        vb->hour_sum += vb->loss_rate;
+        vb->hour_samples++;
+    }
+    if (now - vb->leak_condition_since >= VB_LEAK_CONFIRM_MS) {
+        if (!vb->leak && condition) {
+            vb->leak = true;
+            events |= VB_EVENT_LEAK_RAISED;
+        } else if (vb->leak && !condition) {
+            vb->leak = false;
+            events |= VB_EVENT_LEAK_CLEARED;
+        }
+    }
+    return events;
+}
+
+//=============================================================================
+// FIRMWARE INTEGRATION
+//=============================================================================
+
+static volume_balance_t volume_balance;
+
+/**
+ * @brief Restart estimation, keeping the learned diurnal profile
+ */
+void volume_balance_init(void) {
+    float diurnal[VB_DIURNAL_BINS];
+    uint8_t days[VB_DIURNAL_BINS];
+    memcpy(diurnal, volume_balance.diurnal, sizeof(diurnal));
+    memcpy(days, volume_balance.diurnal_days, sizeof(days));
+    bool was_leak = volume_balance.leak;
+    float was_excess = volume_balance.excess;
+
+    volume_balance_reset(&volume_balance);
+    memcpy(volume_balance.diurnal, diurnal, sizeof(diurnal));
+    memcpy(volume_balance.diurnal_days, days, sizeof(days));
+
+    if (was_leak) {
+        // The restarted balance cannot clear it, so close the raised event here
+        pump_set_auto_inhibit(PUMP_INHIBIT_LEAK, false);
+
+        alarm_event_t event;
+        event.name = "leak";
+        event.severity = AlarmSeverity::CRITICAL;
+        event.raised = false;
+        event.value = was_excess;
+        event.timestamp = millis();
+        alarm_publish(event);
+    }
+}
+
+/**
+ * @brief Feed one reading; pauses automatic dosing while a leak is suspected
+ * @param readings Filtered sensor readings for this cycle
+ */
+void volume_balance_update(const sensor_readings_t& readings) {
+    if (readings.volume < VB_MIN_VOLUME_L) {
+        return;   // Volume not calibrated or tank empty - nothing to balance
+    }
+
+    uint8_t events = volume_balance_step(&volume_balance, readings.volume,
+                                         pump_get_total_inflow_ml(), readings.timestamp);
+
+    if (events & VB_EVENT_TOPUP_END) {
+        Debug->printf("Volume balance: top-up detected (+%.1f L)", volume_balance.current_topup_l);
+    }
+    if (events & (VB_EVENT_LEAK_RAISED | VB_EVENT_LEAK_CLEARED)) {
+        bool raised = (events & VB_EVENT_LEAK_RAISED) != 0;
+        pump_set_auto_inhibit(PUMP_INHIBIT_LEAK, raised);
+
+        alarm_event_t event;
+        event.name = "leak";
+        event.severity = AlarmSeverity::CRITICAL;
+        event.raised = raised;
+        event.value = volume_balance.excess;
+        event.timestamp = readings.timestamp;
+        alarm_publish(event);
+
+        if (raised) {
+            Debug->printf("Volume balance: losing %.2f L/h (%.2f L/h above evaporation) - automatic dosing paused",
+                          volume_balance.loss_rate, volume_balance.excess);
+        } else {
+            Debug->println("Volume balance: loss back within evaporation - automatic dosing resumed");
+        }
+    }
+}
+
+const volume_balance_t* volume_balance_get(void) {
+    return &volume_balance;
+}
+
+/**
+ * @brief Print loss rate, baseline, top-ups and leak state
+ */
+void volume_balance_print_status(void) {
+    const volume_balance_t& vb = volume_balance;
+    int learned = 0;
+    for (int i = 0; i < VB_DIURNAL_BINS; i++) {
+        if (vb.diurnal_days[i] > 0) learned++;
+    }
+
+    Debug->println("=== VOLUME BALANCE ===");
+    if (!vb.started) {
+        Debug->println("No volume readings yet (volume calibrated?)");
+        return;
+    }
+    Debug->printf("Loss rate: %.2f L/h%s | Evaporation baseline: %.2f L/h | Excess: %.2f L/h",
+                  vb.loss_rate, vb.settled ? "" : " (settling)", vb.baseline, vb.excess);
+    Debug->printf("Pump inflow: %.2f L | Top-ups: %u (%.1f L) | Diurnal bins learned: %d/%d",
+                  vb.inflow_l, vb.topup_count, vb.topup_l, learned, VB_DIURNAL_BINS);
+    Debug->printf("Leak: %s | Automatic dosing: %s", vb.leak ? "SUSPECTED" : "no",
+                  pump_get_auto_inhibit() ? "paused" : "allowed");
+}
@@ -0,0 +1,406 @@
+/**
+ * @file watch.cpp
+ * @brief Watch command parser, per-client scheduler and console glue
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "watch.h"
+#include "telemetry.h"
+#include "state_machine.h"
+#include "pump.h"
+#include "communication.h"
+#include <ctype.h>
+#include <stdarg.h>
+
+static_assert(WATCH_CHANNEL_COUNT <= 8, "channel sets are one byte");
+static_assert(WATCH_MAX_CLIENTS == COMM_MAX_CLIENTS, "one watch client per console connection");
+
+static const char* kChannelNames[WATCH_CHANNEL_COUNT] = {"ph", "ec", "temp", "volume", "pumps", "state"};
+static const char* kPumpNames[static_cast<int>(PumpId::COUNT)] = {"pH_Up", "pH_Down", "Nut_A", "Nut_B"};
+
+//=============================================================================
+// PARSER
+//=============================================================================
+
+static bool equals_nocase(const char* a, size_t len, const char* b) {
+    if (strlen(b) != len) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    }
+    return true;
+}
+
+const char* watch_channel_to_string(WatchChannel channel) {
+    int index = static_cast<int>(channel);
+    return index < WATCH_CHANNEL_COUNT ? kChannelNames[index] : "unknown";
+}
+
+/**
+ * @brief Parse one watch command (see watch.h); a leading "watch" is allowed
+ * @return false (request untouched) if the text is not a valid command
+ */
+bool watch_parse(const char* text, size_t len, watch_request_t* request) {
+    const char* words[3];
+    size_t lengths[3];
+    int count = 0;
+    size_t pos = 0;
+    while (pos < len) {
+        while (pos < len && (text[pos] == ' ' || text[pos] == '\t')) pos++;
+        if (pos >= len) break;
+        size_t start = pos;
+        while (pos < len && text[pos] != ' ' && text[pos] != '\t') pos++;
+        if (count == 0 && equals_nocase(text + start, pos - start, "watch")) continue;
+        if (count == 3) return false;
+        words[count] = text + start;
+        lengths[count] = pos - start;
+        count++;
+    }
+
+    watch_request_t result = {WatchAction::LIST, 0, 0, false};
+    if (count == 0 || (count == 1 && equals_nocase(words[0], lengths[0], "list"))) {
+        *request = result;
+        return true;
+    }
+    if (count == 1) {
+        if (!equals_nocase(words[0], lengths[0], "off")) return false;
+        result.action = WatchAction::STOP_ALL;
+        *request = result;
+        return true;
+    }
+    if (count != 2) return false;
+
+    if (equals_nocase(words[0], lengths[0], "log")) {
+        if (equals_nocase(words[1], lengths[1], "on")) result.log = true;
+        else if (!equals_nocase(words[1], lengths[1], "off")) return false;
+        result.action = WatchAction::LOG;
+        *request = result;
+        return true;
+    }
+
+    int channel = 0;
+    while (channel < WATCH_CHANNEL_COUNT && !equals_nocase(words[0], lengths[0], kChannelNames[channel])) channel++;
+    if (channel == WATCH_CHANNEL_COUNT) return false;
+    result.channel = (uint8_t)channel;
+
+    if (equals_nocase(words[1], lengths[1], "off")) {
+        result.action = WatchAction::STOP;
+        *request = result;
+        return true;
+    }
+    // Whole seconds, optionally suffixed "s"
+    size_t digits = lengths[1];
+    if (digits > 1 && (words[1][digits - 1] == 's' || words[1][digits - 1] == 'S')) digits--;
+    if (digits == 0 || digits > 7) return false;
+    uint32_t seconds = 0;
+    for (size_t i = 0; i < digits; i++) {
+        if (words[1][i] < '0' || words[1][i] > '9') return false;
+        seconds = seconds * 10 + (uint32_t)(words[1][i] - '0');
+    }
+    uint32_t period_ms = seconds * 1000;
+    if (period_ms < WATCH_MIN_PERIOD_MS || period_ms > WATCH_MAX_PERIOD_MS) return false;
+    result.action = WatchAction::SET;
+    result.period_ms = period_ms;
+    *request = result;
+    return true;
+}
+
+//=============================================================================
+// SCHEDULER
+//=============================================================================
+
+static inline bool due_by(uint32_t due, uint32_t now) {
+    return (int32_t)(now - due) >= 0;
+}
+
+// Earliest due time across all clients; called whenever a watch changes
+static void recompute(watch_table_t* table) {
+    table->watching = 0;
+    bool first = true;
+    for (int c = 0; c < table->capacity; c++) {
+        const watch_client_t& client = table->clients[c];
+        if (!client.channels) continue;
+        table->watching++;
+        for (int i = 0; i < WATCH_CHANNEL_COUNT; i++) {
+            if (!(client.channels & (1u << i))) continue;
+            if (first || (int32_t)(client.next_due[i] - table->next_due) < 0) table->next_due = client.next_due[i];
+            first = false;
+        }
+    }
+}
+
+void watch_table_init(watch_table_t* table, watch_client_t* clients, int capacity) {
+    memset(table, 0, sizeof(*table));
+    memset(clients, 0, sizeof(watch_client_t) * (size_t)capacity);
+    table->clients = clients;
+    table->capacity = capacity;
+}
+
+/**
+ * @brief Apply SET, STOP or STOP_ALL to one client (LIST and LOG are the caller's)
+ * A new or changed watch is first due now, so the client sees it at once.
+ */
+void watch_apply(watch_table_t* table, int client, const watch_request_t& request, uint32_t now) {
+    if (client < 0 || client >= table->capacity) return;
+    watch_client_t& c = table->clients[client];
+    switch (request.action) {
+        case WatchAction::SET:
+            if (request.channel >= WATCH_CHANNEL_COUNT) return;
+            c.channels |= (uint8_t)(1u << request.channel);
+            c.period_ms[request.channel] = request.period_ms;
+            c.next_due[request.channel] = now;
+            break;
+        case WatchAction::STOP:
+            if (request.channel >= WATCH_CHANNEL_COUNT) return;
+            c.channels &= (uint8_t)~(1u << request.channel);
+            c.period_ms[request.channel] = 0;
+            break;
+        case WatchAction::STOP_ALL:
+            c.channels = 0;
+            memset(c.period_ms, 0, sizeof(c.period_ms));
+            break;
+        default:
+            return;
+    }
+    recompute(table);
+}
+
+void watch_reset_client(watch_table_t* table, int client) {
+    if (client < 0 || client >= table->capacity) return;
+    memset(&table->clients[client], 0, sizeof(watch_client_t));
+    recompute(table);
+}
+
+/**
+ * @brief Channels of one client that are due, scheduling each one's next time
+ * A client that fell behind (blocked loop) gets one line, not a burst.
+ */
+uint8_t watch_client_due(watch_client_t* client, uint32_t now) {
+    uint8_t due = 0;
+    for (int i = 0; i < WATCH_CHANNEL_COUNT; i++) {
+        if (!(client->channels & (1u << i)) || !due_by(client->next_due[i], now)) continue;
+        due |= (uint8_t)(1u << i);
+        client->next_due[i] += client->period_ms[i];
+        if (due_by(client->next_due[i], now)) client->next_due[i] = now + client->period_ms[i];
+    }
+    return due;
+}
+
+static size_t append(char* out, size_t len, size_t pos, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+static size_t append(char* out, size_t len, size_t pos, const char* format, ...) {
+    if (pos >= len) return pos;
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out + pos, len - pos, format, args);
+    va_end(args);
+    if (n < 0) return pos;
+    return pos + (size_t)n < len ? pos + (size_t)n : len - 1;
+}
+
+/**
+ * @brief One watch line with the given channels, in channel order
+ * @return Line length (truncated to len - 1)
+ */
+size_t watch_format(uint8_t channels, const watch_snapshot_t& snapshot, uint32_t now, char* out, size_t len) {
+    if (len == 0) return 0;
+    out[0] = '\0';
+    size_t pos = append(out, len, 0, "watch");
+    const uint8_t reading_channels = (1u << static_cast<int>(WatchChannel::PH)) | (1u << static_cast<int>(WatchChannel::EC)) |
+                                     (1u << static_cast<int>(WatchChannel::TEMPERATURE)) |
+                                     (1u << static_cast<int>(WatchChannel::VOLUME));
+    if ((channels & reading_channels) && !snapshot.have_reading) {
+        pos = append(out, len, pos, " | no reading yet");
+    } else if (channels & reading_channels) {
+        const sensor_readings_t& r = snapshot.reading;
+        if (channels & (1u << static_cast<int>(WatchChannel::PH))) pos = append(out, len, pos, " | pH %.2f", r.ph);
+        if (channels & (1u << static_cast<int>(WatchChannel::EC))) pos = append(out, len, pos, " | EC %.2f mS/cm", r.ec);
+        if (channels & (1u << static_cast<int>(WatchChannel::TEMPERATURE))) {
+            pos = append(out, len, pos, " | Temp %.1f C", r.temperature);
+        }
+        if (channels & (1u << static_cast<int>(WatchChannel::VOLUME))) pos = append(out, len, pos, " | Vol %.1f L", r.volume);
+        uint32_t age = now - r.timestamp;
+        if (age >= WATCH_STALE_MS) pos = append(out, len, pos, " (%lus old)", (unsigned long)(age / 1000));
+    }
+    if (channels & (1u << static_cast<int>(WatchChannel::PUMPS))) {
+        pos = append(out, len, pos, " |");
+        for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+            pos = append(out, len, pos, " %s=%s", kPumpNames[i], pump_state_to_string((PumpState)snapshot.pump_state[i]));
+        }
+    }
+    if (channels & (1u << static_cast<int>(WatchChannel::STATE))) {
+        pos = append(out, len, pos, " | %s", system_state_to_string((SystemState)snapshot.system_state));
+    }
+    return pos;
+}
+
+size_t watch_describe(const watch_client_t& client, char* out, size_t len) {
+    if (len == 0) return 0;
+    out[0] = '\0';
+    size_t pos = 0;
+    for (int i = 0; i < WATCH_CHANNEL_COUNT; i++) {
+        if (!(client.channels & (1u << i))) continue;
+        pos = append(out, len, pos, "%s%s %lus", pos ? ", " : "", kChannelNames[i],
+                     (unsigned long)(client.period_ms[i] / 1000));
+    }
+    if (pos == 0) pos = append(out, len, 0, "nothing");
+    return pos;
+}
+
+/**
+ * @brief Write every due line
+ * Returns at once until the earliest due time. Otherwise takes one
+ * snapshot, and formats each distinct channel set once: clients due on
+ * the same channels in this pass get the same line.
+ * @return Lines written
+ */
+int watch_run(watch_table_t* table, watch_refresh_t refresh, watch_write_t write, void* ctx, uint32_t now) {
+    if (table->watching == 0 || !due_by(table->next_due, now)) return 0;
+
+    bool any = false;
+    for (int c = 0; c < table->capacity; c++) {
+        watch_client_t& client = table->clients[c];
+        client.due = client.channels ? watch_client_due(&client, now) : 0;
+        any = any || client.due;
+    }
+    recompute(table);
+    if (!any) return 0;
+
+    watch_snapshot_t snapshot;
+    refresh(&snapshot);
+    table->snapshots++;
+
+    char line[WATCH_LINE_MAX];
+    int written = 0;
+    for (int c = 0; c < table->capacity; c++) {
+        uint8_t channels = table->clients[c].due;
+        if (!channels) continue;
+        watch_format(channels, snapshot, now, line, sizeof(line));
+        table->formatted++;
+        for (int other = c; other < table->capacity; other++) {
+            watch_client_t& client = table->clients[other];
+            if (client.due != channels) continue;
+            client.due = 0;
+            if (other != c) table->shared++;
+            if (write(ctx, other, line)) {
+                client.lines++;
+                written++;
+            } else {
+                client.failed++;
+            }
+        }
+    }
+    return written;
+}
+
+//=============================================================================
+// CONSOLE
+//=============================================================================
+
+static watch_client_t clients[WATCH_MAX_CLIENTS];
+static watch_table_t table;
+static uint8_t sessions[WATCH_MAX_CLIENTS];          // Telnet session the watches belong to
+static sensor_readings_t latest_reading;
+static bool have_reading = false;
+
+static void on_telemetry(const telemetry_event_t& event, const uint8_t* frame, size_t len) {
+    (void)frame;
+    (void)len;
+    if (event.type == TelemetryType::READING) {
+        latest_reading = event.reading;
+        have_reading = true;
+    }
+}
+
+// No sensor access: the reading is the last one published
+static void refresh_snapshot(watch_snapshot_t* snapshot) {
+    snapshot->have_reading = have_reading;
+    snapshot->reading = latest_reading;
+    for (int i = 0; i < static_cast<int>(PumpId::COUNT); i++) {
+        snapshot->pump_state[i] = static_cast<uint8_t>(state_manager.pump_states[i]);
+    }
+    snapshot->system_state = static_cast<uint8_t>(state_manager.system_state);
+    snapshot->taken_at = millis();
+}
+
+static bool console_write(void* ctx, int client, const char* line) {
+    (void)ctx;
+    return Debug->print_to((uint8_t)client, line);
+}
+
+/**
+ * @brief Track published readings
+ */
+void watch_init(void) {
+    watch_table_init(&table, clients, WATCH_MAX_CLIENTS);
+    memset(sessions, 0, sizeof(sessions));
+    telemetry_add_sink(on_telemetry);
+}
+
+/**
+ * @brief Drop watches of Telnet connections that went away, then serve due lines
+ */
+void watch_update(void) {
+    if (!Debug || table.watching == 0) return;
+    for (int c = COMM_CLIENT_SERIAL + 1; c < WATCH_MAX_CLIENTS; c++) {
+        if (clients[c].channels &&
+            (!Debug->is_client_connected((uint8_t)c) || Debug->get_client_session((uint8_t)c) != sessions[c])) {
+            watch_reset_client(&table, c);
+        }
+    }
+    watch_run(&table, refresh_snapshot, console_write, nullptr, millis());
+}
+
+/**
+ * @brief 'W': read one watch command from the connection that typed it
+ * The prompt and the reply go to that connection only.
+ */
+void watch_command(void) {
+    uint8_t client = Debug->get_input_client();
+    if (client >= WATCH_MAX_CLIENTS) return;
+    // The prompt blocks loop(), which is what stops a running dose on time
+    if (pump_any_running()) {
+        Debug->print_to(client, "Watch: a pump is running - try again when it stops");
+        return;
+    }
+    char line[WATCH_LINE_MAX];
+    Debug->print_to(client, "Watch (10s): <ph|ec|temp|volume|pumps|state> <seconds> | <channel> off | off | log on|off | list");
+    Debug->read_line(line, sizeof(line), WATCH_INPUT_TIMEOUT_MS);
+
+    watch_request_t request;
+    if (!watch_parse(line, strlen(line), &request)) {
+        Debug->print_to(client, "Watch: not understood (period 1-3600 s)");
+        return;
+    }
+    if (request.action == WatchAction::LOG) {
+        if (client == COMM_CLIENT_SERIAL) {
+            Debug->print_to(client, "Watch: Serial always receives the full log");
+        } else {
+            Debug->set_client_quiet(client, !request.log);
+            Debug->print_to(client, request.log ? "Watch: full log ON" : "Watch: full log OFF (watch lines and replies only)");
+        }
+        return;
+    }
+    if (request.action != WatchAction::LIST) {
+        sessions[client] = Debug->get_client_session(client);
+        watch_apply(&table, client, request, millis());
+    }
+    char description[WATCH_LINE_MAX];
+    watch_describe(clients[client], description, sizeof(description));
+    snprintf(line, sizeof(line), "Watching: %s%s", description,
+             Debug->is_client_quiet(client) ? " (full log OFF)" : "");
+    Debug->print_to(client, line);
+}
+
+void watch_print_status(void) {
+    Debug->printf("Watch: %u client(s) watching | %lu snapshots, %lu lines formatted, %lu shared",
+                  table.watching, (unsigned long)table.snapshots, (unsigned long)table.formatted,
+                  (unsigned long)table.shared);
+    for (int c = 0; c < WATCH_MAX_CLIENTS; c++) {
+        if (!clients[c].channels) continue;
+        char description[WATCH_LINE_MAX];
+        watch_describe(clients[c], description, sizeof(description));
+        Debug->printf("  %s %d: %s | %lu lines, %lu not taken", c == COMM_CLIENT_SERIAL ? "Serial" : "Telnet", c,
+                      description, (unsigned long)clients[c].lines, (unsigned long)clients[c].failed);
+    }
+}
@@ -0,0 +1,658 @@
+/**
+ * @file websocket.cpp
+ * @brief WebSocket handshake, client frame decoder, fan-out hub and server
+ * @author Arduino Developer
+ * @date 2025
+ */
+
+#include "websocket.h"
+#include "block_pool.h"
+#include <WiFi.h>
+
+static_assert(TELEMETRY_FRAME_MAX < 126, "telemetry frames must fit a 2-byte WebSocket header");
+static_assert(WEBSOCKET_REQUEST_MAX <= POOL_FRAME_BLOCK, "handshake buffer does not fit a frame block");
+static_assert(WEBSOCKET_SLOT_COUNT <= 8, "pending flags are one byte");
+
+static const char kGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static const char kBadRequest[] = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+
+//=============================================================================
+// HANDSHAKE
+//=============================================================================
+
+static inline uint32_t rol(uint32_t v, int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+/**
+ * @brief SHA-1 of a short message (key + GUID); only the handshake uses it
+ */
+static void sha1(const uint8_t* data, size_t len, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint64_t bits = (uint64_t)len * 8;
+    size_t total = ((len + 8) / 64 + 1) * 64;
+
+    for (size_t block = 0; block < total; block += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            uint32_t word = 0;
+            for (int j = 0; j < 4; j++) {
+                size_t pos = block + 4 * i + j;
+                uint8_t byte;
+                if (pos < len) byte = data[pos];
+                else if (pos == len) byte = 0x80;
+                else if (pos >= total - 8) byte = (uint8_t)(bits >> (8 * (total - 1 - pos)));
+                else byte = 0;
+                word = (word << 8) | byte;
+            }
+            w[i] = word;
+        }
+        for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    for (int i = 0; i < 5; i++) {
+        for (int j = 0; j < 4; j++) digest[4 * i + j] = (uint8_t)(h[i] >> (24 - 8 * j));
+    }
+}
+
+static size_t base64(const uint8_t* data, size_t len, char* out) {
+    static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        out[n++] = kAlphabet[(v >> 18) & 0x3F];
+        out[n++] = kAlphabet[(v >> 12) & 0x3F];
+        out[n++] = i + 1 < len ? kAlphabet[(v >> 6) & 0x3F] : '=';
+        out[n++] = i + 2 < len ? kAlphabet[v & 0x3F] : '=';
+    }
+    return n;
+}
+
+static bool equals_nocase(const char* a, size_t len, const char* b) {
+    if (strlen(b) != len) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i])) return false;
+    }
+    return true;
+}
+
+// Comma-separated header value contains token (case-insensitive)
+static bool has_token(const char* value, size_t len, const char* token) {
+    size_t start = 0;
+    while (start < len) {
+        size_t end = start;
+        while (end < len && value[end] != ',') end++;
+        size_t a = start, b = end;
+        while (a < b && (value[a] == ' ' || value[a] == '\t')) a++;
+        while (b > a && (value[b - 1] == ' ' || value[b - 1] == '\t')) b--;
+        if (equals_nocase(value + a, b - a, token)) return true;
+        start = end + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief Apply "events=reading,pump,alarm&hz=N"; keys not given keep their value
+ * @return false (subscription unchanged) on an unknown event or a bad number
+ */
+bool websocket_parse_subscription(const char* text, size_t len, websocket_subscription_t* subscription) {
+    websocket_subscription_t result = *subscription;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t end = pos;
+        while (end < len && text[end] != '&') end++;
+        const char* item = text + pos;
+        size_t item_len = end - pos;
+        pos = end + 1;
+        if (item_len == 0) continue;
+
+        if (item_len > 7 && strncmp(item, "events=", 7) == 0) {
+            uint8_t events = 0;
+            size_t i = 7;
+            while (i <= item_len) {
+                size_t j = i;
+                while (j < item_len && item[j] != ',') j++;
+                if (equals_nocase(item + i, j - i, "reading")) events |= WEBSOCKET_EVENT_READING;
+                else if (equals_nocase(item + i, j - i, "pump")) events |= WEBSOCKET_EVENT_PUMP;
+                else if (equals_nocase(item + i, j - i, "alarm")) events |= WEBSOCKET_EVENT_ALARM;
+                else return false;
+                i = j + 1;
+            }
+            result.events = events;
+        } else if (item_len > 3 && strncmp(item, "hz=", 3) == 0) {
+            if (item_len > 8) return false;
+            uint32_t hz = 0;
+            for (size_t i = 3; i < item_len; i++) {
+                if (item[i] < '0' || item[i] > '9') return false;
+                hz = hz * 10 + (uint32_t)(item[i] - '0');
+            }
+            result.max_hz = (uint16_t)(hz > WEBSOCKET_MAX_HZ ? WEBSOCKET_MAX_HZ : hz);
+        }
+        // Other keys (cache busters etc.) are ignored
+    }
+    *subscription = result;
+    return true;
+}
+
+/**
+ * @brief Validate an opening handshake and build the 101 response
+ * Accepts GET /stream[?subscription] with Upgrade: websocket,
+ * Connection: Upgrade, Sec-WebSocket-Version: 13 and a 16-byte key.
+ */
+int websocket_handshake(const char* request, size_t len, char* response, size_t response_len,
+                        websocket_subscription_t* subscription) {
+    size_t header_end = 0;
+    for (size_t i = 3; i < len; i++) {
+        if (request[i - 3] == '\r' && request[i - 2] == '\n' && request[i - 1] == '\r' && request[i] == '\n') {
+            header_end = i + 1;
+            break;
+        }
+    }
+    if (header_end == 0) return len >= WEBSOCKET_REQUEST_MAX ? -1 : 0;
+
+    // Request line: GET <path> HTTP/1.1
+    size_t line_end = 0;
+    while (request[line_end] != '\r') line_end++;
+    if (line_end < 14 || strncmp(request, "GET ", 4) != 0 ||
+        strncmp(request + line_end - 9, " HTTP/1.1", 9) != 0) {
+        return -1;
+    }
+    const char* target = request + 4;
+    size_t target_len = line_end - 13;
+    size_t path_len = 0;
+    while (path_len < target_len && target[path_len] != '?') path_len++;
+    if (path_len != 7 || strncmp(target, "/stream", 7) != 0) return -1;
+
+    websocket_subscription_t requested = {WEBSOCKET_EVENT_ALL, 0};
+    if (path_len < target_len &&
+        !websocket_parse_subscription(target + path_len + 1, target_len - path_len - 1, &requested)) {
+        return -1;
+    }
+
+    bool upgrade = false, connection = false, version = false;
+    const char* key = nullptr;
+    size_t key_len = 0;
+    size_t pos = line_end + 2;
+    while (pos + 2 < header_end) {
+        size_t end = pos;
+        while (request[end] != '\r') end++;
+        size_t colon = pos;
+        while (colon < end && request[colon] != ':') colon++;
+        if (colon < end) {
+            const char* name = request + pos;
+            size_t name_len = colon - pos;
+            size_t v = colon + 1, v_end = end;
+            while (v < v_end && (request[v] == ' ' || request[v] == '\t')) v++;
+            while (v_end > v && (request[v_end - 1] == ' ' || request[v_end - 1] == '\t')) v_end--;
+            const char* value = request + v;
+            size_t value_len = v_end - v;
+
+            if (equals_nocase(name, name_len, "upgrade")) upgrade = has_token(value, value_len, "websocket");
+            else if (equals_nocase(name, name_len, "connection")) connection = has_token(value, value_len, "upgrade");
+            else if (equals_nocase(name, name_len, "sec-websocket-version")) version = value_len == 2 && strncmp(value, "13", 2) == 0;
+            else if (equals_nocase(name, name_len, "sec-websocket-key")) {
+                key = value;
+                key_len = value_len;
+            }
+        }
+        pos = end + 2;
+    }
+    if (!upgrade || !connection || !version || key_len != 24 || key[22] != '=' || key[23] != '=') return -1;
+
+    uint8_t input[24 + sizeof(kGuid) - 1];
+    memcpy(input, key, 24);
+    memcpy(input + 24, kGuid, sizeof(kGuid) - 1);
+    uint8_t digest[20];
+    sha1(input, sizeof(input), digest);
+    char accept[29];
+    accept[base64(digest, sizeof(digest), accept)] = '\0';
+
+    int n = snprintf(response, response_len,
+                     "HTTP/1.1 101 Switching Protocols\r\n"
+                     "Upgrade: websocket\r\n"
+                     "Connection: Upgrade\r\n"
+                     "Sec-WebSocket-Accept: %s\r\n\r\n",
+                     accept);
+    if (n <= 0 || (size_t)n >= response_len) return -1;
+    *subscription = requested;
+    return n;
+}
+
+//=============================================================================
+// FRAMES
+//=============================================================================
+
+/**
+ * @brief Decode one client frame (must be masked, unfragmented, <= 125 bytes)
+ */
+int websocket_decode_frame(const uint8_t* data, size_t len, websocket_frame_t* frame) {
+    if (len < 2) return 0;
+    uint8_t opcode = data[0] & 0x0F;
+    bool fin = (data[0] & 0x80) != 0;
+    if ((data[0] & 0x70) != 0 || !fin) return -1;        // No extensions, no fragmentation
+    if (opcode != WEBSOCKET_OP_TEXT && opcode != WEBSOCKET_OP_BINARY && opcode != WEBSOCKET_OP_CLOSE &&
+        opcode != WEBSOCKET_OP_PING && opcode != WEBSOCKET_OP_PONG) {
+        return -1;
+    }
+    if ((data[1] & 0x80) == 0) return -1;                // Client frames are masked
+    size_t payload_len = data[1] & 0x7F;
+    if (payload_len > WEBSOCKET_CONTROL_MAX) return -1;
+    size_t total = 6 + payload_len;
+    if (len < total) return 0;
+
+    const uint8_t* mask = data + 2;
+    frame->opcode = opcode;
+    frame->fin = fin;
+    frame->length = (uint8_t)payload_len;
+    for (size_t i = 0; i < payload_len; i++) frame->payload[i] = data[6 + i] ^ mask[i & 3];
+    return (int)total;
+}
+
+size_t websocket_encode_header(uint8_t opcode, size_t payload_len, uint8_t* out) {
+    out[0] = (uint8_t)(0x80 | opcode);
+    if (payload_len < 126) {
+        out[1] = (uint8_t)payload_len;
+        return 2;
+    }
+    out[1] = 126;
+    out[2] = (uint8_t)(payload_len >> 8);
+    out[3] = (uint8_t)payload_len;
+    return 4;
+}
+
+//=============================================================================
+// FAN-OUT HUB
+//=============================================================================
+
+static int event_slot(const telemetry_event_t& event) {
+    switch (event.type) {
+        case TelemetryType::READING:
+            return WEBSOCKET_SLOT_READING;
+        case TelemetryType::PUMP:
+            return event.pump < WEBSOCKET_SLOT_COUNT - WEBSOCKET_SLOT_PUMP ? WEBSOCKET_SLOT_PUMP + event.pump : -1;
+        case TelemetryType::ALARM:
+            break;                                       // Queued, see websocket_hub_publish()
+    }
+    return -1;
+}
+
+static uint8_t event_bit(TelemetryType type) {
+    switch (type) {
+        case TelemetryType::READING: return WEBSOCKET_EVENT_READING;
+        case TelemetryType::PUMP: return WEBSOCKET_EVENT_PUMP;
+        case TelemetryType::ALARM: return WEBSOCKET_EVENT_ALARM;
+    }
+    return 0;
+}
+
+// Write what the subscriber takes; the rest of a message goes to its tail
+static bool write_some(websocket_subscriber_t& s, const uint8_t* data, size_t len, size_t* taken) {
+    int n = s.write(s.ctx, data, len);
+    if (n < 0) {
+        s.closed = true;
+        return false;
+    }
+    *taken = (size_t)n > len ? len : (size_t)n;
+    return true;
+}
+
+/**
+ * @brief Offer one whole message
+ * @return true if the subscriber took it (any rest went to its tail); *more
+ *         is false when nothing else may be written in this flush
+ */
+static bool offer_message(websocket_subscriber_t& s, const uint8_t* data, size_t len, bool* more) {
+    size_t taken = 0;
+    *more = false;
+    if (!write_some(s, data, len, &taken) || taken == 0) return false;   // Busy: stays pending
+    s.sent++;
+    if (taken < len) {
+        s.tail_len = (uint8_t)(len - taken);
+        memcpy(s.tail, data + taken, s.tail_len);
+        return true;
+    }
+    *more = true;
+    return true;
+}
+
+static bool alarms_pending(const websocket_hub_t* hub, const websocket_subscriber_t& s) {
+    return (s.events & WEBSOCKET_EVENT_ALARM) && s.alarm_next != hub->alarms;
+}
+
+static void flush_subscriber(websocket_hub_t* hub, websocket_subscriber_t& s, uint32_t now) {
+    if (s.tail_len > 0) {
+        size_t taken = 0;
+        if (!write_some(s, s.tail, s.tail_len, &taken)) return;
+        s.tail_len = (uint8_t)(s.tail_len - taken);
+        memmove(s.tail, s.tail + taken, s.tail_len);
+        if (s.tail_len > 0) return;
+    }
+    if (s.pending == 0 && !alarms_pending(hub, s)) return;
+    if (s.min_interval_ms > 0 && (uint32_t)(now - s.last_flush) < s.min_interval_ms) return;
+
+    // Alarms first, oldest to newest; those the queue no longer holds are counted
+    bool any = false, more = true;
+    if (alarms_pending(hub, s) && hub->alarms - s.alarm_next > WEBSOCKET_ALARM_QUEUE) {
+        s.alarms_dropped += hub->alarms - s.alarm_next - WEBSOCKET_ALARM_QUEUE;
+        s.alarm_next = hub->alarms - WEBSOCKET_ALARM_QUEUE;
+    }
+    while (more && alarms_pending(hub, s)) {
+        uint32_t entry = s.alarm_next % WEBSOCKET_ALARM_QUEUE;
+        if (!offer_message(s, hub->alarm[entry], hub->alarm_len[entry], &more)) break;
+        s.alarm_next++;
+        any = true;
+    }
+    for (int slot = 0; more && slot < WEBSOCKET_SLOT_COUNT; slot++) {
+        uint8_t bit = (uint8_t)(1u << slot);
+        if ((s.pending & bit) == 0) continue;
+        if (!offer_message(s, hub->message[slot], hub->message_len[slot], &more)) break;
+        s.pending &= (uint8_t)~bit;
+        any = true;
+    }
+    if (s.closed) return;
+    if (any) s.last_flush = now;
+}
+
+void websocket_hub_init(websocket_hub_t* hub, websocket_subscriber_t* subscribers, int capacity) {
+    memset(hub->message_len, 0, sizeof(hub->message_len));
+    memset(hub->alarm_len, 0, sizeof(hub->alarm_len));
+    hub->alarms = 0;
+    hub->subscribers = subscribers;
+    hub->capacity = capacity;
+    hub->published = 0;
+    for (int i = 0; i < capacity; i++) subscribers[i] = websocket_subscriber_t();
+}
+
+int websocket_hub_subscribe(websocket_hub_t* hub, websocket_write_t write, void* ctx,
+                            const websocket_subscription_t& subscription) {
+    for (int i = 0; i < hub->capacity; i++) {
+        websocket_subscriber_t& s = hub->subscribers[i];
+        if (s.write) continue;
+        s = websocket_subscriber_t();
+        s.write = write;
+        s.ctx = ctx;
+        s.alarm_next = hub->alarms;                      // No replay of alarms raised before it came
+        websocket_hub_set_subscription(hub, i, subscription);
+        return i;
+    }
+    return -1;
+}
+
+void websocket_hub_set_subscription(websocket_hub_t* hub, int index, const websocket_subscription_t& subscription) {
+    websocket_subscriber_t& s = hub->subscribers[index];
+    s.events = subscription.events & WEBSOCKET_EVENT_ALL;
+    uint16_t hz = subscription.max_hz > WEBSOCKET_MAX_HZ ? WEBSOCKET_MAX_HZ : subscription.max_hz;
+    s.min_interval_ms = hz ? (uint16_t)(1000 / hz) : 0;
+
+    // Drop pending messages of kinds no longer wanted
+    if (!(s.events & WEBSOCKET_EVENT_READING)) s.pending &= (uint8_t)~(1u << WEBSOCKET_SLOT_READING);
+    if (!(s.events & WEBSOCKET_EVENT_PUMP)) {
+        for (int slot = WEBSOCKET_SLOT_PUMP; slot < WEBSOCKET_SLOT_COUNT; slot++) s.pending &= (uint8_t)~(1u << slot);
+    }
+    if (!(s.events & WEBSOCKET_EVENT_ALARM)) s.alarm_next = hub->alarms;
+}
+
+void websocket_hub_unsubscribe(websocket_hub_t* hub, int index) {
+    if (index >= 0 && index < hub->capacity) hub->subscribers[index] = websocket_subscriber_t();
+}
+
+/**
+ * @brief Wrap a telemetry frame once into its slot and offer it to subscribers
+ * Subscribers that are rate-limited or busy keep only the pending flag, so a
+ * later event of the same slot replaces this one (counted as coalesced).
+ * Alarms go to the next queue entry instead and are never replaced.
+ */
+void websocket_hub_publish(websocket_hub_t* hub, const telemetry_event_t& event, const uint8_t* frame, size_t len,
+                           uint32_t now) {
+    bool alarm = event.type == TelemetryType::ALARM;
+    int slot = event_slot(event);
+    if ((!alarm && slot < 0) || len > TELEMETRY_FRAME_MAX) return;
+    uint8_t* message = alarm ? hub->alarm[hub->alarms % WEBSOCKET_ALARM_QUEUE] : hub->message[slot];
+    size_t header = websocket_encode_header(WEBSOCKET_OP_BINARY, len, message);
+    memcpy(message + header, frame, len);
+    if (alarm) {
+        hub->alarm_len[hub->alarms % WEBSOCKET_ALARM_QUEUE] = (uint8_t)(header + len);
+        hub->alarms++;
+    } else {
+        hub->message_len[slot] = (uint8_t)(header + len);
+    }
+    hub->published++;
+
+    uint8_t event_mask = event_bit(event.type);
+    uint8_t slot_bit = alarm ? 0 : (uint8_t)(1u << slot);
+    for (int i = 0; i < hub->capacity; i++) {
+        websocket_subscriber_t& s = hub->subscribers[i];
+        if (!s.write || s.closed || !(s.events & event_mask)) continue;
+        if (s.pending & slot_bit) s.coalesced++;
+        s.pending |= slot_bit;
+        flush_subscriber(hub, s, now);
+    }
+}
+
+void websocket_hub_flush(websocket_hub_t* hub, uint32_t now) {
+    for (int i = 0; i < hub->capacity; i++) {
+        websocket_subscriber_t& s = hub->subscribers[i];
+        if (s.write && !s.closed && (s.pending || s.tail_len || alarms_pending(hub, s))) {
+            flush_subscriber(hub, s, now);
+        }
+    }
+}
+
+//=============================================================================
+// SERVER
+//=============================================================================
+
+struct websocket_connection_t {
+    WiFiClient* client;                  // CONNECTION pool
+    char* request;                       // FRAME pool until the handshake completes
+    size_t request_len;
+    uint32_t accepted_at;
+    int subscriber;                      // Hub index once upgraded, -1 before
+    uint8_t rx[WEBSOCKET_RX_MAX];
+    size_t rx_len;
+};
+
+static websocket_subscriber_t subscribers[WEBSOCKET_MAX_CLIENTS];
+static websocket_hub_t hub;
+static WiFiServer* websocket_server = nullptr;
+static websocket_connection_t connections[WEBSOCKET_MAX_CLIENTS];
+
+// Non-blocking, so a full socket reaches the hub's tail/pending logic as 0
+// bytes taken instead of stalling the main loop in WiFiClient::write()
+static int client_write(void* ctx, const uint8_t* data, size_t len) {
+    return telemetry_client_send(static_cast<WiFiClient*>(ctx), data, len);
+}
+
+static void on_telemetry(const telemetry_event_t& event, const uint8_t* frame, size_t len) {
+    websocket_hub_publish(&hub, event, frame, len, millis());
+}
+
+static void drop_connection(websocket_connection_t& c) {
+    if (c.subscriber >= 0) websocket_hub_unsubscribe(&hub, c.subscriber);
+    if (c.client) {
+        c.client->stop();
+        pool_delete(PoolId::CONNECTION, c.client);
+    }
+    if (c.request) pool_free(PoolId::FRAME, c.request);
+    c = websocket_connection_t();
+    c.subscriber = -1;
+}
+
+// Control replies go straight out, but never into the middle of a message;
+// a rest the socket did not take goes to the tail like a message's would
+static void send_control(websocket_connection_t& c, uint8_t opcode, const uint8_t* payload, size_t len) {
+    websocket_subscriber_t& s = hub.subscribers[c.subscriber];
+    if (s.tail_len > 0) return;
+    uint8_t frame[2 + WEBSOCKET_CONTROL_MAX];
+    size_t n = websocket_encode_header(opcode, len, frame);
+    memcpy(frame + n, payload, len);
+    int taken = client_write(c.client, frame, n + len);
+    if (taken < 0) {
+        s.closed = true;
+        return;
+    }
+    size_t rest = n + len - (size_t)taken;
+    if (rest > sizeof(s.tail)) {
+        s.closed = true;                                 // Cannot finish the frame; owner drops it
+        return;
+    }
+    memcpy(s.tail, frame + taken, rest);
+    s.tail_len = (uint8_t)rest;
+}
+
+static void serve_handshake(websocket_connection_t& c) {
+    if (c.client->available()) {
+        int n = c.client->read(reinterpret_cast<uint8_t*>(c.request) + c.request_len,
+                               WEBSOCKET_REQUEST_MAX - c.request_len);
+        if (n > 0) c.request_len += (size_t)n;
+    }
+    char response[WEBSOCKET_RESPONSE_MAX];
+    websocket_subscription_t subscription;
+    int result = websocket_handshake(c.request, c.request_len, response, sizeof(response), &subscription);
+    if (result == 0) {
+        if (millis() - c.accepted_at > WEBSOCKET_HANDSHAKE_TIMEOUT_MS) drop_connection(c);
+        return;
+    }
+    if (result < 0) {
+        client_write(c.client, reinterpret_cast<const uint8_t*>(kBadRequest), sizeof(kBadRequest) - 1);
+        drop_connection(c);
+        return;
+    }
+    c.subscriber = websocket_hub_subscribe(&hub, client_write, c.client, subscription);
+    if (c.subscriber < 0) {
+        drop_connection(c);
+        return;
+    }
+    // Nothing has been sent on the socket yet, so the response fits unless the peer is gone
+    if (client_write(c.client, reinterpret_cast<const uint8_t*>(response), (size_t)result) != result) {
+        drop_connection(c);
+        return;
+    }
+    pool_free(PoolId::FRAME, c.request);
+    c.request = nullptr;
+}
+
+static void serve_frames(websocket_connection_t& c) {
+    if (c.client->available()) {
+        int n = c.client->read(c.rx + c.rx_len, WEBSOCKET_RX_MAX - c.rx_len);
+        if (n > 0) c.rx_len += (size_t)n;
+    }
+    while (c.rx_len > 0) {
+        websocket_frame_t frame;
+        int used = websocket_decode_frame(c.rx, c.rx_len, &frame);
+        if (used == 0) return;
+        if (used < 0) {
+            static const uint8_t kProtocolError[2] = {0x03, 0xEA};   // 1002
+            send_control(c, WEBSOCKET_OP_CLOSE, kProtocolError, sizeof(kProtocolError));
+            drop_connection(c);
+            return;
+        }
+        switch (frame.opcode) {
+            case WEBSOCKET_OP_PING:
+                send_control(c, WEBSOCKET_OP_PONG, frame.payload, frame.length);
+                break;
+            case WEBSOCKET_OP_CLOSE:
+                send_control(c, WEBSOCKET_OP_CLOSE, frame.payload, frame.length < 2 ? frame.length : 2);
+                drop_connection(c);
+                return;
+            case WEBSOCKET_OP_TEXT: {
+                websocket_subscriber_t& s = hub.subscribers[c.subscriber];
+                websocket_subscription_t subscription = {s.events, (uint16_t)(s.min_interval_ms ? 1000 / s.min_interval_ms : 0)};
+                if (websocket_parse_subscription(reinterpret_cast<const char*>(frame.payload), frame.length,
+                                                 &subscription)) {
+                    websocket_hub_set_subscription(&hub, c.subscriber, subscription);
+                }
+                break;
+            }
+            default:
+                break;                                   // Binary and pong: ignored
+        }
+        c.rx_len -= (size_t)used;
+        memmove(c.rx, c.rx + used, c.rx_len);
+    }
+}
+
+/**
+ * @brief Attach the stream to published telemetry
+ */
+void websocket_init(void) {
+    websocket_hub_init(&hub, subscribers, WEBSOCKET_MAX_CLIENTS);
+    for (websocket_connection_t& c : connections) c.subscriber = -1;
+    telemetry_add_sink(on_telemetry);
+}
+
+/**
+ * @brief Start the server once WiFi is up, run handshakes, answer client
+ * frames and send what rate limits held back
+ */
+void websocket_update(void) {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    if (!websocket_server) {
+        websocket_server = pool_new<WiFiServer>(PoolId::CONNECTION, WEBSOCKET_PORT);
+        if (!websocket_server) return;
+        websocket_server->begin();
+    }
+
+    for (websocket_connection_t& c : connections) {
+        if (!c.client) continue;
+        if (!c.client->connected() || (c.subscriber >= 0 && hub.subscribers[c.subscriber].closed)) {
+            drop_connection(c);
+        } else if (c.request) {
+            serve_handshake(c);
+        } else {
+            serve_frames(c);
+        }
+    }
+
+    WiFiClient incoming = websocket_server->accept();
+    if (incoming) {
+        websocket_connection_t* slot = nullptr;
+        for (websocket_connection_t& c : connections) {
+            if (!c.client) {
+                slot = &c;
+                break;
+            }
+        }
+        if (slot) {
+            slot->request = static_cast<char*>(pool_alloc(PoolId::FRAME));
+            slot->client = slot->request ? pool_new<WiFiClient>(PoolId::CONNECTION, incoming) : nullptr;
+            if (slot->client) {
+                slot->client->setNoDelay(true);
+                slot->accepted_at = millis();
+            } else {
+                drop_connection(*slot);
+                incoming.stop();
+            }
+        } else {
+            incoming.stop();                             // Full
+        }
+    }
+
+    websocket_hub_flush(&hub, millis());
+}
+
+uint8_t websocket_get_client_count(void) {
+    uint8_t count = 0;
+    for (const websocket_connection_t& c : connections) {
+        if (c.subscriber >= 0) count++;
+    }
+    return count;
+}